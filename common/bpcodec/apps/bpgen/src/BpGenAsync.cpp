@@ -1,6 +1,7 @@
 #include <string.h>
 #include <iostream>
 #include "BpGenAsync.h"
+#include "MetricsRegistry.h"
 
 struct bpgen_hdr {
     uint64_t seq;
@@ -25,6 +26,7 @@ uint64_t BpGenAsync::GetNextPayloadLength_Step1() {
 bool BpGenAsync::CopyPayload_Step2(uint8_t * destinationBuffer) {
     bpgen_hdr bpGenHeader;
     bpGenHeader.seq = m_bpGenSequenceNumber++;
+    bpGenHeader.tsc = LatencyHistogram::NowNanoseconds(); //monotonic, so a sink on this host can compute one way latency
     memcpy(destinationBuffer, &bpGenHeader, sizeof(bpgen_hdr));
     return true;
 }
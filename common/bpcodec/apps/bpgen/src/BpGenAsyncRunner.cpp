@@ -166,7 +166,7 @@ bool BpGenAsyncRunner::Run(int argc, const char* const argv[], volatile bool & r
                     deadlineTimer.expires_from_now(boost::posix_time::seconds(durationSeconds));
                     deadlineTimer.async_wait(boost::bind(&DurationEndedThreadFunction, boost::asio::placeholders::error, &running));
                 }
-                else {
+                else if (startedTimer) { //polling an io_service with no work stops it, so don't poll before the timer is started
                     ioService.poll_one();
                 }
             }
@@ -9,7 +9,10 @@ struct bpgen_hdr {
 };
 
 BpSinkAsync::BpSinkAsync() : 
-    BpSinkPattern()
+    BpSinkPattern(),
+    m_bundlesReceivedCounterRef(MetricsRegistry::GetInstance().GetOrCreateCounter("bpsink.bundlesReceived")),
+    m_bytesReceivedCounterRef(MetricsRegistry::GetInstance().GetOrCreateCounter("bpsink.bytesReceived")),
+    m_bundleLatencyHistogramRef(MetricsRegistry::GetInstance().GetOrCreateHistogram("bpsink.bundleLatency"))
 {}
 
 BpSinkAsync::~BpSinkAsync() {}
@@ -20,8 +23,12 @@ bool BpSinkAsync::ProcessPayload(const uint8_t * data, const uint64_t size) {
         return false;
     }
     memcpy(&bpGenHdr, data, sizeof(bpgen_hdr));
-
-    
+    const uint64_t nowNanoseconds = LatencyHistogram::NowNanoseconds();
+    if (nowNanoseconds >= bpGenHdr.tsc) { //else bpgen is on a different host
+        m_bundleLatencyHistogramRef.RecordNanoseconds(nowNanoseconds - bpGenHdr.tsc);
+    }
+    m_bundlesReceivedCounterRef.Increment();
+    m_bytesReceivedCounterRef.Increment(size);
 
     // offset by the first sequence number we see, so that we don't need to restart for each run ...
     if (m_FinalStatsBpSink.m_seqBase == 0) {
@@ -2,6 +2,7 @@
 #define _BP_SINK_ASYNC_H
 
 #include "app_patterns/BpSinkPattern.h"
+#include "MetricsRegistry.h"
 
 struct FinalStatsBpSink {
     FinalStatsBpSink() : m_totalBytesRx(0), m_totalBundlesRx(0), m_receivedCount(0), m_duplicateCount(0),
@@ -24,6 +25,10 @@ protected:
 public:
 
     FinalStatsBpSink m_FinalStatsBpSink;
+private:
+    MetricCounter & m_bundlesReceivedCounterRef;
+    MetricCounter & m_bytesReceivedCounterRef;
+    LatencyHistogram & m_bundleLatencyHistogramRef; //from bpgen's timestamp, only meaningful when bpgen runs on the same host
 };
 
 
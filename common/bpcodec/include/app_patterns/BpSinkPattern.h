@@ -13,6 +13,7 @@
 #include "OutductManager.h"
 #include "codec/bpv6.h"
 #include "codec/CustodyTransferManager.h"
+#include "codec/Bpv7Fragmentation.h"
 #include <boost/asio.hpp>
 #include "TcpclInduct.h"
 
@@ -30,7 +31,7 @@ private:
     BP_APP_PATTERNS_LIB_NO_EXPORT bool Process(padded_vector_uint8_t & rxBuf, const std::size_t messageSize);
     BP_APP_PATTERNS_LIB_NO_EXPORT void AcsNeedToSend_TimerExpired(const boost::system::error_code& e);
     BP_APP_PATTERNS_LIB_NO_EXPORT void TransferRate_TimerExpired(const boost::system::error_code& e);
-    BP_APP_PATTERNS_LIB_NO_EXPORT void SendAcsFromTimerThread();
+    BP_APP_PATTERNS_LIB_NO_EXPORT void SendAcsFromTimerThread(const bool sendAllAcs);
     BP_APP_PATTERNS_LIB_NO_EXPORT void OnNewOpportunisticLinkCallback(const uint64_t remoteNodeId, Induct * thisInductPtr);
     BP_APP_PATTERNS_LIB_NO_EXPORT void OnDeletedOpportunisticLinkCallback(const uint64_t remoteNodeId);
     BP_APP_PATTERNS_LIB_NO_EXPORT bool Forward_ThreadSafe(const cbhe_eid_t & destEid, std::vector<uint8_t> & bundleToMoveAndSend);
@@ -67,6 +68,8 @@ private:
     std::unique_ptr<boost::thread> m_ioServiceThreadPtr;
     boost::mutex m_mutexCtm;
     boost::mutex m_mutexForward;
+    Bpv7FragmentReassembler m_bpv7FragmentReassembler;
+    boost::mutex m_mutexFragmentReassembler;
     uint64_t m_tcpclOpportunisticRemoteNodeId;
     Induct * m_tcpclInductPtr;
 };
@@ -0,0 +1,172 @@
+#ifndef BPSEC_MANAGER_H
+#define BPSEC_MANAGER_H 1
+
+#include "codec/bpv7.h"
+#include "codec/BundleViewV7.h"
+#include <cstdint>
+#include <vector>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <openssl/opensslv.h>
+
+/*
+BPSecManager computes and verifies the security results of the default BPSec security contexts
+(RFC 9173 BIB-HMAC-SHA2 and BCB-AES-GCM) directly on the serialized blocks of a loaded or rendered BundleViewV7.
+
+Encryption and decryption of security targets are performed in place on the block-type-specific data
+inside the bundle's rendered buffer (AES-GCM ciphertext is the same length as the plaintext), so no
+payload copies are made by this class.  Only the newly added or removed security blocks dirty the bundle,
+so a subsequent BundleViewV7::RenderInPlace() keeps a large payload block where it already is.
+
+The OpenSSL EVP interface is used throughout so that AES-NI, PCLMULQDQ and SHA extensions are used automatically
+when the cpu supports them.  All OpenSSL context objects are held by the caller in a ReusableElementsInternal
+(one per thread) so that the hot path does not allocate per bundle.
+
+The Additional Authenticated Data (BCB) and Integrity Protected Plain Text (BIB) are never concatenated;
+they are fed to OpenSSL as a sequence of buffers:
+    scope flags (cbor uint) | [primary block] | [target header] | [security block header] | [target data (BIB only)]
+where each header is the cbor uint encoding of the block type code, block number, and block processing control flags.
+*/
+
+class BPSecManager {
+public:
+    struct CLASS_VISIBILITY_BPCODEC EvpCipherCtxWrapper : private boost::noncopyable {
+        BPCODEC_EXPORT EvpCipherCtxWrapper();
+        BPCODEC_EXPORT ~EvpCipherCtxWrapper();
+        void * m_ctx; //EVP_CIPHER_CTX
+    };
+    struct CLASS_VISIBILITY_BPCODEC HmacCtxWrapper : private boost::noncopyable {
+        BPCODEC_EXPORT HmacCtxWrapper();
+        BPCODEC_EXPORT ~HmacCtxWrapper();
+        void * m_ctx; //EVP_MAC_CTX (OpenSSL >= 3.0) or HMAC_CTX
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+        void * m_mac; //EVP_MAC
+#endif
+    };
+    //one per thread, reused between bundles to avoid allocations
+    struct ReusableElementsInternal {
+        EvpCipherCtxWrapper cipherCtxWrapper;
+        EvpCipherCtxWrapper keyWrapCtxWrapper;
+        HmacCtxWrapper hmacCtxWrapper;
+        std::vector<boost::asio::const_buffer> constBufferVec;
+        std::vector<uint8_t> unwrappedKeyBytes;
+    };
+
+    BPCODEC_EXPORT static bool HmacSha(HmacCtxWrapper & ctxWrapper, const COSE_ALGORITHMS variant,
+        const std::vector<boost::asio::const_buffer> & ipptParts,
+        const uint8_t * key, const uint64_t keyLength,
+        uint8_t * messageDigestOut, unsigned int & messageDigestOutSize);
+
+    BPCODEC_EXPORT static bool AesGcmEncrypt(EvpCipherCtxWrapper & ctxWrapper,
+        uint8_t * inPlaceData, const uint64_t dataLength,
+        const uint8_t * key, const uint64_t keyLength,
+        const uint8_t * iv, const uint64_t ivLength,
+        const std::vector<boost::asio::const_buffer> & aadParts,
+        uint8_t * tagOut); //tagOut must be at least 16 bytes
+
+    BPCODEC_EXPORT static bool AesGcmDecrypt(EvpCipherCtxWrapper & ctxWrapper,
+        uint8_t * inPlaceData, const uint64_t dataLength,
+        const uint8_t * key, const uint64_t keyLength,
+        const uint8_t * iv, const uint64_t ivLength,
+        const std::vector<boost::asio::const_buffer> & aadParts,
+        const uint8_t * tag, const uint64_t tagLength);
+
+    //RFC 3394 AES key wrap, wrappedKeyOut must be at least keyToWrapLength + 8 bytes
+    BPCODEC_EXPORT static bool AesWrapKey(EvpCipherCtxWrapper & ctxWrapper,
+        const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+        const uint8_t * keyToWrap, const unsigned int keyToWrapLength,
+        uint8_t * wrappedKeyOut, unsigned int & wrappedKeyOutSize);
+
+    //unwrappedKeyOut must be at least wrappedKeyLength bytes
+    BPCODEC_EXPORT static bool AesUnwrapKey(EvpCipherCtxWrapper & ctxWrapper,
+        const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+        const uint8_t * wrappedKey, const unsigned int wrappedKeyLength,
+        uint8_t * unwrappedKeyOut, unsigned int & unwrappedKeyOutSize);
+
+    //Computes one expected HMAC per target over the current serialized targets and inserts a new BIB (with the given block number)
+    //before the payload block.  If keyEncryptionKey is not NULL, hmacKey is transmitted wrapped in the BIB.
+    //The bundle must be loaded or rendered (not dirty) prior to calling; call Render or RenderInPlace afterwards.
+    BPCODEC_EXPORT static bool TryAddBundleIntegrity(ReusableElementsInternal & reusableElements,
+        BundleViewV7 & bv,
+        const BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS integrityScopeMask,
+        const COSE_ALGORITHMS variant,
+        const cbhe_eid_t & securitySource,
+        const uint64_t * targetBlockNumbers, const unsigned int numTargets,
+        const uint8_t * hmacKey, const unsigned int hmacKeyLength,
+        const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+        const uint64_t bibBlockNumber,
+        const BPV7_BLOCKFLAG bibBlockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET,
+        const BPV7_CRC_TYPE bibCrcType = BPV7_CRC_TYPE::NONE);
+
+    //Verifies every unencrypted BIB in the bundle.  If the BIB carries a wrapped key, the given key is used as the key encryption key.
+    //On success, BIBs are marked for deletion if markBibForDeletion is true (call Render or RenderInPlace afterwards).
+    BPCODEC_EXPORT static bool TryVerifyBundleIntegrity(ReusableElementsInternal & reusableElements,
+        BundleViewV7 & bv,
+        const uint8_t * hmacKeyOrKeyEncryptionKey, const unsigned int keyLength,
+        const bool markBibForDeletion);
+
+    //Encrypts each target in place inside the bundle's rendered buffer and inserts a new BCB (with the given block number)
+    //before the payload block.  The initialization vector must never be reused with the same content encryption key.
+    //If keyEncryptionKey is not NULL, contentEncryptionKey is transmitted wrapped in the BCB.
+    //The bundle must be loaded or rendered (not dirty) prior to calling; call Render or RenderInPlace afterwards.
+    BPCODEC_EXPORT static bool TryEncryptBundle(ReusableElementsInternal & reusableElements,
+        BundleViewV7 & bv,
+        const BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS aadScopeMask,
+        const COSE_ALGORITHMS aesVariant,
+        const cbhe_eid_t & securitySource,
+        const uint64_t * targetBlockNumbers, const unsigned int numTargets,
+        const uint8_t * iv, const unsigned int ivLength,
+        const uint8_t * contentEncryptionKey, const unsigned int contentEncryptionKeyLength,
+        const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+        const uint64_t bcbBlockNumber,
+        const BPV7_BLOCKFLAG bcbBlockProcessingControlFlags = BPV7_BLOCKFLAG::MUST_BE_REPLICATED,
+        const BPV7_CRC_TYPE bcbCrcType = BPV7_CRC_TYPE::NONE);
+
+    //Decrypts every BCB target in place inside the bundle's rendered buffer.  If the BCB carries a wrapped key,
+    //the given key is used as the key encryption key.  On success, the BCBs are marked for deletion and the decrypted
+    //targets are deserialized; call Render or RenderInPlace afterwards.
+    BPCODEC_EXPORT static bool TryDecryptBundle(ReusableElementsInternal & reusableElements,
+        BundleViewV7 & bv,
+        const uint8_t * contentEncryptionKeyOrKeyEncryptionKey, const unsigned int keyLength);
+
+private:
+    BPCODEC_NO_EXPORT static uint8_t * GetSerializedBlockTypeSpecificDataPtr(BundleViewV7::Bpv7CanonicalBlockView & cbv);
+    BPCODEC_NO_EXPORT static BundleViewV7::Bpv7CanonicalBlockView * GetCanonicalBlockViewByNumber(BundleViewV7 & bv, const uint64_t blockNumber);
+    BPCODEC_NO_EXPORT static unsigned int SerializeBlockHeaderForScope(uint8_t * serialization, const Bpv7CanonicalBlock & block);
+    BPCODEC_NO_EXPORT static unsigned int SerializeBlockHeaderForScope(uint8_t * serialization,
+        const BPV7_BLOCK_TYPE_CODE blockTypeCode, const uint64_t blockNumber, const BPV7_BLOCKFLAG blockFlags);
+};
+
+/*
+Distributes a batch of bundles over a fixed set of worker threads.  Each worker owns its own
+BPSecManager::ReusableElementsInternal so that the OpenSSL contexts are never shared between threads.
+*/
+class BpSecWorkerPool : private boost::noncopyable {
+public:
+    typedef boost::function<bool(BundleViewV7 & bv, BPSecManager::ReusableElementsInternal & reusableElements)> bundle_operation_function_t;
+
+    BPCODEC_EXPORT BpSecWorkerPool(const unsigned int numThreads);
+    BPCODEC_EXPORT ~BpSecWorkerPool();
+    //blocks until every bundle in the batch has been processed; returns the number of successful operations
+    //and sets successes[i] to 1 if bundles[i] succeeded
+    BPCODEC_EXPORT std::size_t ProcessBatch(std::vector<BundleViewV7*> & bundles, const bundle_operation_function_t & operation, std::vector<uint8_t> & successes);
+    BPCODEC_EXPORT unsigned int GetNumThreads() const;
+private:
+    BPCODEC_NO_EXPORT void ProcessStridedSubset(const unsigned int workerIndex, std::vector<BundleViewV7*> * bundlesPtr,
+        const bundle_operation_function_t * operationPtr, std::vector<uint8_t> * successesPtr);
+
+    const unsigned int m_numThreads;
+    boost::asio::io_service m_ioService;
+    std::unique_ptr<boost::asio::io_service::work> m_workPtr;
+    boost::thread_group m_threadGroup;
+    std::vector<std::unique_ptr<BPSecManager::ReusableElementsInternal> > m_reusableElementsPerWorker;
+    boost::mutex m_batchMutex;
+    boost::condition_variable m_batchCv;
+    unsigned int m_numWorkersRemaining;
+    std::size_t m_numSuccessful;
+};
+
+#endif // BPSEC_MANAGER_H
@@ -0,0 +1,79 @@
+#ifndef BPV7_FRAGMENTATION_H
+#define BPV7_FRAGMENTATION_H 1
+
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include "codec/BundleViewV7.h"
+#include "FragmentSet.h"
+/*
+Bpv7Fragmenter splits a loaded (or rendered) BPv7 bundle into fragments per RFC 9171 section 5.8:
+each fragment carries a copy of the primary block (with the ISFRAGMENT flag, fragment offset,
+and total application data unit length set), a contiguous range of the payload,
+every block flagged MUST_BE_REPLICATED, and (only in the fragment whose offset is zero)
+every other extension block.  Fragmenting a fragment is supported (offsets stay relative to the original ADU).
+FragmentPayloadRange creates a single fragment for an arbitrary payload range
+(i.e. the unsent remainder of a bundle after a link was lost mid transfer).
+For reactive fragmentation, FragmentUnsentRemainder (sender side) and FragmentReceivedPrefix (receiver side)
+split a bundle whose transfer was interrupted at a byte boundary into the two complementary fragments.
+
+Bpv7FragmentReassembler collects the fragments of bundles destined for this node.
+The received byte ranges of each ADU are tracked with a FragmentSet (so duplicates and overlaps are harmless)
+and the payload bytes are copied straight into a buffer the size of the ADU.
+ADU buffers are recycled through a small pool, and the total bytes held by incomplete bundles is capped.
+Once every byte has arrived, the whole bundle is rendered from the offset zero fragment's blocks and the ADU.
+*/
+class Bpv7Fragmenter {
+public:
+    //returns false if the bundle must not be fragmented or cannot fit maxFragmentBundleSizeBytes,
+    //otherwise fragments (serialized bundles) are appended in increasing offset order
+    BPCODEC_EXPORT static bool Fragment(const BundleViewV7 & bv, const uint64_t maxFragmentBundleSizeBytes, std::list<std::vector<uint8_t> > & fragments);
+    BPCODEC_EXPORT static bool FragmentPayloadRange(const BundleViewV7 & bv, const uint64_t payloadBeginIndex, const uint64_t payloadLength, std::vector<uint8_t> & fragment);
+    BPCODEC_EXPORT static bool IsFragmentable(const BundleViewV7 & bv);
+    //returns false if the whole bundle must be sent again (not bpv7, not fragmentable, or the whole payload was delivered),
+    //otherwise fragment holds the payload that follows the first numBytesDelivered bytes of the serialized bundle (all of it if no payload was delivered)
+    BPCODEC_EXPORT static bool FragmentUnsentRemainder(uint8_t * bundleData, const uint64_t bundleSizeBytes, const uint64_t numBytesDelivered, std::vector<uint8_t> & fragment);
+    //bundleBuffer holds the first numBytesReceived bytes of a bundle of bundleSizeBytes and must be bundleSizeBytes in size (the rest gets overwritten).
+    //returns false if no payload byte was received, otherwise fragment holds the received part of the payload
+    BPCODEC_EXPORT static bool FragmentReceivedPrefix(uint8_t * bundleBuffer, const uint64_t numBytesReceived, const uint64_t bundleSizeBytes, std::vector<uint8_t> & fragment);
+private:
+    BPCODEC_NO_EXPORT static uint64_t GetFragmentSerializationSizeExcludingPayloadData(const BundleViewV7 & bv, const uint64_t payloadBeginIndex, const uint64_t payloadLength);
+};
+
+class Bpv7FragmentReassembler {
+public:
+    BPCODEC_EXPORT Bpv7FragmentReassembler(const uint64_t maxBytesInUse = 100000000, const std::size_t maxPooledBuffers = 10);
+    BPCODEC_EXPORT ~Bpv7FragmentReassembler();
+
+    //fragmentBv must be a loaded bundle with the ISFRAGMENT flag set.
+    //returns false if the fragment is inconsistent or its bundle would exceed the memory cap.
+    //if this fragment completed its bundle, isComplete is set and the whole bundle is swapped into reassembledBundle
+    BPCODEC_EXPORT bool AddFragment(const BundleViewV7 & fragmentBv, bool & isComplete, std::vector<uint8_t> & reassembledBundle);
+    //discard incomplete bundles whose lifetime has ended, returns the number discarded
+    BPCODEC_EXPORT std::size_t RemoveExpiredBundles(const uint64_t nowMillisecondsSinceEpochRfc5050);
+    BPCODEC_EXPORT std::size_t GetNumPendingBundles() const;
+    BPCODEC_EXPORT uint64_t GetNumBytesInUse() const;
+    BPCODEC_EXPORT void Reset();
+private:
+    struct pending_bundle_t {
+        std::vector<uint8_t> applicationDataUnit;
+        std::set<FragmentSet::data_fragment_t> receivedFragmentSet;
+        std::vector<uint8_t> firstFragmentBundle; //offset zero fragment, supplies the non-replicated extension blocks
+        uint64_t expirationMilliseconds;
+        uint64_t numBytesInUse;
+    };
+    typedef std::map<cbhe_bundle_uuid_nofragment_t, pending_bundle_t> pending_bundle_map_t;
+
+    BPCODEC_NO_EXPORT bool RenderWholeBundle(pending_bundle_t & pendingBundle, std::vector<uint8_t> & reassembledBundle);
+    BPCODEC_NO_EXPORT void ErasePendingBundle(pending_bundle_map_t::iterator it);
+
+    const uint64_t M_MAX_BYTES_IN_USE;
+    const std::size_t M_MAX_POOLED_BUFFERS;
+    uint64_t m_numBytesInUse;
+    pending_bundle_map_t m_mapBundleUuidToPendingBundle;
+    std::list<std::vector<uint8_t> > m_bufferPool;
+};
+
+#endif // BPV7_FRAGMENTATION_H
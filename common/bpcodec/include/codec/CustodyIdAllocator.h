@@ -4,9 +4,9 @@
 
 #include <string>
 #include <cstdint>
-#include "FragmentSet.h"
+#include <vector>
+#include <unordered_map>
 #include "codec/bpv6.h"
-#include <map>
 /*
 This is a class to help intelligently allocate custody ids with CTEB/ACS.
 Custody Ids should be allocated with the smallest number possible, and also
@@ -16,6 +16,13 @@ This will minimize CTEB/ACS total bytes transferred when encoded to sdnvs and AC
 In case of interleaving from multiple bundle sources,
 allocate integer range from [N*256+0, N*256+1, ... ,  N*256+255]
 
+Used custody ids and used multipliers (N) are kept in bitmaps so that allocating and freeing
+a custody id is O(1), and freeing a range (i.e. an ACS fill) touches one 64-bit word per 64 custody ids:
+level 0: one bit per custody id plus the number of custody ids used per multiplier,
+level 1: one bit per used multiplier,
+level 2: one bit per level 1 word that is full, so the lowest free multiplier is found
+         with a find-first-zero over 4096 multipliers at a time.
+The bitmaps grow on demand, so custody ids are expected to be dense (as allocated by this class).
 */
 class CustodyIdAllocator {
 public:
@@ -30,14 +37,28 @@ public:
     BPCODEC_EXPORT void ReserveNextCustodyIdBlock();
     BPCODEC_EXPORT void Reset();
     BPCODEC_EXPORT uint64_t GetNextCustodyIdForNextHopCtebToSend(const cbhe_eid_t & bundleSrcEid);
+    BPCODEC_EXPORT bool IsCustodyIdUsed(const uint64_t custodyId) const;
     BPCODEC_EXPORT void PrintUsedCustodyIds();
     BPCODEC_EXPORT void PrintUsedCustodyIdMultipliers();
 private:
+    struct hash_cbhe_eid_t {
+        std::size_t operator()(const cbhe_eid_t & eid) const {
+            return static_cast<std::size_t>((eid.nodeId * 0x9e3779b97f4a7c15ULL) ^ eid.serviceId);
+        }
+    };
+    BPCODEC_NO_EXPORT void EnsureMultiplierCapacity(const uint64_t multiplier);
+    BPCODEC_NO_EXPORT void SetMultiplierUsed(const uint64_t multiplier);
+    BPCODEC_NO_EXPORT bool FreeMultiplierIfUnused(const uint64_t multiplier);
+    BPCODEC_NO_EXPORT void SetCustodyIdRangeUsed(const uint64_t custodyIdBegin, const uint64_t custodyIdEnd);
+    BPCODEC_NO_EXPORT uint64_t GetLowestFreeMultiplier() const;
+    BPCODEC_NO_EXPORT static void PrintBitmapAsFragments(const std::vector<uint64_t> & bitmap);
 
     uint64_t m_myNextCustodyIdAllocationBeginForNextHopCtebToSend;
-    std::map<cbhe_eid_t, uint64_t> m_mapBundleSrcEidToNextCtebCustodyId;
-    std::set<FragmentSet::data_fragment_t> m_usedCustodyIds;
-    std::set<FragmentSet::data_fragment_t> m_usedCustodyIdMultipliers;
+    std::unordered_map<cbhe_eid_t, uint64_t, hash_cbhe_eid_t> m_mapBundleSrcEidToNextCtebCustodyId;
+    std::vector<uint64_t> m_usedCustodyIdsBitmap; //level 0
+    std::vector<uint16_t> m_numUsedCustodyIdsPerMultiplier; //level 0
+    std::vector<uint64_t> m_usedMultipliersBitmap; //level 1
+    std::vector<uint64_t> m_fullUsedMultipliersWordsBitmap; //level 2
 };
 
 #endif // CUSTODY_ID_ALLOCATOR_H
@@ -7,6 +7,9 @@
 #include <string>
 #include <cstdint>
 #include <vector>
+#include <list>
+#include <map>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 enum class BPV6_ACS_STATUS_REASON_INDICES : uint8_t {
     SUCCESS__NO_ADDITIONAL_INFORMATION = 0,
@@ -21,8 +24,56 @@ enum class BPV6_ACS_STATUS_REASON_INDICES : uint8_t {
 };
 static constexpr unsigned int NUM_ACS_STATUS_INDICES = static_cast<unsigned int>(BPV6_ACS_STATUS_REASON_INDICES::NUM_INDICES);
 
-struct acs_array_t : public std::array<Bpv6AdministrativeRecordContentAggregateCustodySignal, NUM_ACS_STATUS_INDICES> {
-    acs_array_t();
+/*
+Builds the fills of the ACS of one custodian and one status incrementally as custody ids arrive.
+The custody ids of a custodian's CTEBs normally arrive in increasing order, so every fill except the last
+(still growing) one is sdnv encoded exactly once, when it is closed, into a preallocated buffer.
+A custody id that arrives out of order is kept aside and merged (requiring a re-encode of all fills)
+only when the ACS is finished.
+*/
+class AcsFillsBuilder {
+public:
+    BPCODEC_EXPORT AcsFillsBuilder();
+    BPCODEC_EXPORT void Reserve(const uint64_t numBytesEncodedFills);
+    BPCODEC_EXPORT void SetCustodyTransferStatusAndReason(bool custodyTransferSucceeded, BPV6_CUSTODY_SIGNAL_REASON_CODES_7BIT reasonCode7bit);
+    //return number of fills
+    BPCODEC_EXPORT uint64_t AddCustodyIdToFill(const uint64_t custodyId);
+    BPCODEC_EXPORT uint64_t GetNumFills() const;
+    BPCODEC_EXPORT bool IsEmpty() const;
+    //merge any out of order custody ids into the encoded fills (only needed before GetContentSerializationSize must be exact)
+    BPCODEC_EXPORT void MergeOutOfOrderFills();
+    //acs admin record content (status byte plus fills), an upper bound if there are any out of order custody ids
+    BPCODEC_EXPORT uint64_t GetContentSerializationSize() const;
+    //serialize the acs admin record content (status byte plus fills)
+    BPCODEC_EXPORT uint64_t SerializeContent(uint8_t * serialization, uint64_t bufferSize);
+    //copy of the fills as a Bpv6AdministrativeRecordContentAggregateCustodySignal (not for the hot path)
+    BPCODEC_EXPORT const Bpv6AdministrativeRecordContentAggregateCustodySignal & GetAcs();
+    BPCODEC_EXPORT void Reset();
+
+    boost::posix_time::ptime m_firstFillTime;
+    bool m_isFull;
+private:
+    BPCODEC_NO_EXPORT void AppendEncodedFill(const uint64_t beginIndex, const uint64_t endIndex);
+    BPCODEC_NO_EXPORT void DecodeAllFills();
+
+    Bpv6AdministrativeRecordContentAggregateCustodySignal m_acs;
+    std::vector<uint8_t> m_encodedClosedFills;
+    uint64_t m_rightEdgeOfLastClosedFill;
+    uint64_t m_pendingFillBeginIndex;
+    uint64_t m_pendingFillEndIndex;
+    uint64_t m_numFills;
+    uint8_t m_statusFlagsPlus7bitReasonCode;
+    std::set<FragmentSet::data_fragment_t> m_outOfOrderFills;
+};
+
+struct acs_builder_array_t : public std::array<AcsFillsBuilder, NUM_ACS_STATUS_INDICES> {
+    acs_builder_array_t();
+};
+
+//an ACS bundle serialized without a BundleViewV6
+struct serialized_acs_bundle_t {
+    Bpv6CbhePrimaryBlock m_primary;
+    std::vector<uint8_t> m_bundleSerialized;
 };
 
 class CustodyTransferManager {
@@ -42,15 +93,33 @@ public:
     BPCODEC_EXPORT bool GenerateAcsBundle(BundleViewV6 & newAcsRenderedBundleView, const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex, const bool copyAcsOnly = false);
     BPCODEC_EXPORT const Bpv6AdministrativeRecordContentAggregateCustodySignal & GetAcsConstRef(const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex);
     BPCODEC_EXPORT uint64_t GetLargestNumberOfFills() const;
+
+    //An ACS is finished when it reaches maxFillsPerAcs fills or maxAcsContentBytes serialized bytes of admin record content,
+    //or when its first fill is maxAcsAge old.
+    BPCODEC_EXPORT void SetAcsFlushThresholds(const uint64_t maxFillsPerAcs, const uint64_t maxAcsContentBytes, const boost::posix_time::time_duration & maxAcsAge);
+    BPCODEC_EXPORT bool HasFullAcs() const; //reached max fills or max bytes
+    BPCODEC_EXPORT bool IsAcsReadyToSend(const boost::posix_time::ptime & nowPtime) const;
+    //serialize (without BundleViewV6) then clear every finished ACS (every non-empty ACS if sendAll)
+    BPCODEC_EXPORT bool GenerateReadyAcsBundles(std::list<serialized_acs_bundle_t> & newAcsBundleList, const boost::posix_time::ptime & nowPtime, const bool sendAll = false);
 private:
+    BPCODEC_NO_EXPORT acs_builder_array_t & GetAcsBuilders(const cbhe_eid_t & custodianEid);
+    BPCODEC_NO_EXPORT void AddCustodyIdToAcs(const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex, const uint64_t custodyId);
+    BPCODEC_NO_EXPORT void ResetAcs(AcsFillsBuilder & acsFillsBuilder);
+    BPCODEC_NO_EXPORT bool SerializeAcsBundle(serialized_acs_bundle_t & acsBundle, const cbhe_eid_t & custodianEid, AcsFillsBuilder & acsFillsBuilder);
+
     const bool m_isAcsAware;
     const uint64_t m_myCustodianNodeId;
     const uint64_t m_myCustodianServiceId;
     const std::string m_myCtebCreatorCustodianEidString;
-    std::map<cbhe_eid_t, acs_array_t> m_mapCustodianToAcsArray;
+    std::map<cbhe_eid_t, acs_builder_array_t> m_mapCustodianToAcsBuilders;
     uint64_t m_lastCreation;
     uint64_t m_sequence;
     uint64_t m_largestNumberOfFills;
+    uint64_t m_maxFillsPerAcs;
+    uint64_t m_maxAcsContentBytes;
+    boost::posix_time::time_duration m_maxAcsAge;
+    uint64_t m_numFullAcs;
+    boost::posix_time::ptime m_oldestAcsFirstFillTime;
 };
 
 #endif // CUSTODY_TRANSFER_MANAGER_H
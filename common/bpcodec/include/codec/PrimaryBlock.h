@@ -9,6 +9,8 @@
 struct PrimaryBlock {
     virtual bool HasCustodyFlagSet() const = 0;
     virtual bool HasFragmentationFlagSet() const = 0;
+    virtual bool HasDeletionStatusReportsRequested() const = 0;
+    virtual bool HasUnknownCreationTime() const = 0; //creation time of 0 (no accurate clock), so the lifetime can't be aged from it
     virtual cbhe_bundle_uuid_t GetCbheBundleUuidFromPrimary() const = 0;
     virtual cbhe_bundle_uuid_nofragment_t GetCbheBundleUuidNoFragmentFromPrimary() const = 0;
     virtual cbhe_eid_t GetFinalDestinationEid() const = 0;
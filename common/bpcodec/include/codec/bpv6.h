@@ -113,6 +113,8 @@ struct CLASS_VISIBILITY_BPCODEC Bpv6CbhePrimaryBlock : public PrimaryBlock {
 
     BPCODEC_EXPORT virtual bool HasCustodyFlagSet() const;
     BPCODEC_EXPORT virtual bool HasFragmentationFlagSet() const;
+    BPCODEC_EXPORT virtual bool HasDeletionStatusReportsRequested() const;
+    BPCODEC_EXPORT virtual bool HasUnknownCreationTime() const;
     BPCODEC_EXPORT virtual cbhe_bundle_uuid_t GetCbheBundleUuidFromPrimary() const;
     BPCODEC_EXPORT virtual cbhe_bundle_uuid_nofragment_t GetCbheBundleUuidNoFragmentFromPrimary() const;
     BPCODEC_EXPORT virtual cbhe_eid_t GetFinalDestinationEid() const;
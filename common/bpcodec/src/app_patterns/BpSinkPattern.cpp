@@ -18,6 +18,7 @@
 #include "TcpclInduct.h"
 #include "TcpclV4Induct.h"
 #include "codec/BundleViewV7.h"
+#include "TimestampUtil.h"
 
 BpSinkPattern::BpSinkPattern() : m_timerAcs(m_ioService), m_timerTransferRateStats(m_ioService) {}
 
@@ -177,8 +178,8 @@ bool BpSinkPattern::Process(padded_vector_uint8_t & rxBuf, const std::size_t mes
                         const cbhe_eid_t & custodySignalDestEid = m_custodySignalRfc5050RenderedBundleView.m_primaryBlockView.header.m_destinationEid;
                         Forward_ThreadSafe(custodySignalDestEid, m_custodySignalRfc5050RenderedBundleView.m_frontBuffer);
                     }
-                    else if (m_custodyTransferManagerPtr->GetLargestNumberOfFills() > 100) {
-                        boost::asio::post(m_ioService, boost::bind(&BpSinkPattern::SendAcsFromTimerThread, this));
+                    else if (m_custodyTransferManagerPtr->HasFullAcs()) {
+                        boost::asio::post(m_ioService, boost::bind(&BpSinkPattern::SendAcsFromTimerThread, this, false));
                     }
                 }
             }
@@ -225,6 +226,24 @@ bool BpSinkPattern::Process(padded_vector_uint8_t & rxBuf, const std::size_t mes
             return false;
         }
 
+        //collect fragments until the whole bundle arrives, then process the reassembled bundle
+        if (primary.HasFragmentationFlagSet()) {
+            bool isComplete;
+            std::vector<uint8_t> reassembledBundle;
+            {
+                boost::mutex::scoped_lock lock(m_mutexFragmentReassembler);
+                m_bpv7FragmentReassembler.RemoveExpiredBundles(TimestampUtil::GetMillisecondsSinceEpochRfc5050());
+                if (!m_bpv7FragmentReassembler.AddFragment(bv, isComplete, reassembledBundle)) {
+                    std::cerr << "error in BpSinkPattern::Process: unable to reassemble version 7 bundle fragment\n";
+                    return false;
+                }
+            }
+            if (!isComplete) {
+                return true;
+            }
+            rxBuf.assign(reassembledBundle.begin(), reassembledBundle.end());
+            return Process(rxBuf, rxBuf.size());
+        }
         
         //get previous node
         std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
@@ -332,7 +351,7 @@ void BpSinkPattern::WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundle
 void BpSinkPattern::AcsNeedToSend_TimerExpired(const boost::system::error_code& e) {
     if (e != boost::asio::error::operation_aborted) {
         // Timer was not cancelled, take necessary action.
-        SendAcsFromTimerThread();
+        SendAcsFromTimerThread(true);
         
         m_timerAcs.expires_from_now(boost::posix_time::seconds(1));
         m_timerAcs.async_wait(boost::bind(&BpSinkPattern::AcsNeedToSend_TimerExpired, this, boost::asio::placeholders::error));
@@ -373,18 +392,15 @@ void BpSinkPattern::TransferRate_TimerExpired(const boost::system::error_code& e
     }
 }
 
-void BpSinkPattern::SendAcsFromTimerThread() {
-    //std::cout << "send acs, fills = " << ctm.GetLargestNumberOfFills() << "\n";
-    std::list<BundleViewV6> newAcsRenderedBundleViewList;
+//sendAllAcs => send every pending acs (acs send timer), otherwise only the full ones
+void BpSinkPattern::SendAcsFromTimerThread(const bool sendAllAcs) {
+    std::list<serialized_acs_bundle_t> newAcsBundleList;
     m_mutexCtm.lock();
-    const bool generatedSuccessfully = m_custodyTransferManagerPtr->GenerateAllAcsBundlesAndClear(newAcsRenderedBundleViewList);
+    m_custodyTransferManagerPtr->GenerateReadyAcsBundles(newAcsBundleList, boost::posix_time::microsec_clock::universal_time(), sendAllAcs);
     m_mutexCtm.unlock();
-    if (generatedSuccessfully) {
-        for (std::list<BundleViewV6>::iterator it = newAcsRenderedBundleViewList.begin(); it != newAcsRenderedBundleViewList.end(); ++it) {
-            //send an acs custody signal due to acs send timer
-            const cbhe_eid_t & custodySignalDestEid = it->m_primaryBlockView.header.m_destinationEid;
-            Forward_ThreadSafe(custodySignalDestEid, it->m_frontBuffer);
-        }
+    for (std::list<serialized_acs_bundle_t>::iterator it = newAcsBundleList.begin(); it != newAcsBundleList.end(); ++it) {
+        //send an acs custody signal due to acs send timer or a full acs
+        Forward_ThreadSafe(it->m_primary.m_destinationEid, it->m_bundleSerialized);
     }
 }
 
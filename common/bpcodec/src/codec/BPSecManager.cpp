@@ -0,0 +1,781 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+#include "codec/BPSecManager.h"
+#include "CborUint.h"
+#include <iostream>
+#include <climits>
+#include <boost/make_unique.hpp>
+#include <boost/bind/bind.hpp>
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+#include <openssl/params.h>
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+
+static constexpr unsigned int AES_GCM_TAG_LENGTH = 16;
+static constexpr uint64_t MAX_EVP_UPDATE_CHUNK_SIZE = 1U << 30; //EVP update lengths are of type int
+
+static const Bpv7AbstractSecurityBlockValueBase * GetSecurityParameterValuePtr(const Bpv7AbstractSecurityBlock & asb, const uint64_t parameterId) {
+    if (!asb.IsSecurityContextParametersPresent()) {
+        return NULL;
+    }
+    const Bpv7AbstractSecurityBlock::security_context_parameters_t & params = asb.m_securityContextParametersOptional;
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        if (params[i].first == parameterId) {
+            return params[i].second.get();
+        }
+    }
+    return NULL;
+}
+static bool GetSecurityParameterUintOrDefault(const Bpv7AbstractSecurityBlock & asb, const uint64_t parameterId, const uint64_t defaultValue, uint64_t & value) {
+    const Bpv7AbstractSecurityBlockValueBase * valuePtr = GetSecurityParameterValuePtr(asb, parameterId);
+    if (valuePtr == NULL) {
+        value = defaultValue;
+        return true;
+    }
+    if (const Bpv7AbstractSecurityBlockValueUint * valueUintPtr = dynamic_cast<const Bpv7AbstractSecurityBlockValueUint*>(valuePtr)) {
+        value = valueUintPtr->m_uintValue;
+        return true;
+    }
+    return false;
+}
+static const std::vector<uint8_t> * GetSecurityParameterByteStringPtr(const Bpv7AbstractSecurityBlock & asb, const uint64_t parameterId) {
+    if (const Bpv7AbstractSecurityBlockValueByteString * valueBsPtr = dynamic_cast<const Bpv7AbstractSecurityBlockValueByteString*>(GetSecurityParameterValuePtr(asb, parameterId))) {
+        return &valueBsPtr->m_byteString;
+    }
+    return NULL;
+}
+static const EVP_CIPHER * GetAesGcmCipher(const COSE_ALGORITHMS aesVariant, const uint64_t keyLength) {
+    if ((aesVariant == COSE_ALGORITHMS::A128GCM) && (keyLength == 16)) {
+        return EVP_aes_128_gcm();
+    }
+    else if ((aesVariant == COSE_ALGORITHMS::A256GCM) && (keyLength == 32)) {
+        return EVP_aes_256_gcm();
+    }
+    return NULL;
+}
+static const EVP_CIPHER * GetAesKeyWrapCipher(const unsigned int keyEncryptionKeyLength) {
+    if (keyEncryptionKeyLength == 16) {
+        return EVP_aes_128_wrap();
+    }
+    else if (keyEncryptionKeyLength == 24) {
+        return EVP_aes_192_wrap();
+    }
+    else if (keyEncryptionKeyLength == 32) {
+        return EVP_aes_256_wrap();
+    }
+    return NULL;
+}
+
+BPSecManager::EvpCipherCtxWrapper::EvpCipherCtxWrapper() : m_ctx(EVP_CIPHER_CTX_new()) {}
+BPSecManager::EvpCipherCtxWrapper::~EvpCipherCtxWrapper() {
+    if (m_ctx) {
+        EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX*>(m_ctx));
+        m_ctx = NULL;
+    }
+}
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+BPSecManager::HmacCtxWrapper::HmacCtxWrapper() :
+    m_ctx(NULL),
+    m_mac(EVP_MAC_fetch(NULL, OSSL_MAC_NAME_HMAC, NULL))
+{
+    if (m_mac) {
+        m_ctx = EVP_MAC_CTX_new(static_cast<EVP_MAC*>(m_mac));
+    }
+}
+BPSecManager::HmacCtxWrapper::~HmacCtxWrapper() {
+    if (m_ctx) {
+        EVP_MAC_CTX_free(static_cast<EVP_MAC_CTX*>(m_ctx));
+        m_ctx = NULL;
+    }
+    if (m_mac) {
+        EVP_MAC_free(static_cast<EVP_MAC*>(m_mac));
+        m_mac = NULL;
+    }
+}
+#else
+BPSecManager::HmacCtxWrapper::HmacCtxWrapper() : m_ctx(HMAC_CTX_new()) {}
+BPSecManager::HmacCtxWrapper::~HmacCtxWrapper() {
+    if (m_ctx) {
+        HMAC_CTX_free(static_cast<HMAC_CTX*>(m_ctx));
+        m_ctx = NULL;
+    }
+}
+#endif
+
+bool BPSecManager::HmacSha(HmacCtxWrapper & ctxWrapper, const COSE_ALGORITHMS variant,
+    const std::vector<boost::asio::const_buffer> & ipptParts,
+    const uint8_t * key, const uint64_t keyLength,
+    uint8_t * messageDigestOut, unsigned int & messageDigestOutSize)
+{
+    if (ctxWrapper.m_ctx == NULL) {
+        return false;
+    }
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    const char * digestName;
+    if (variant == COSE_ALGORITHMS::HMAC_256_256) {
+        digestName = OSSL_DIGEST_NAME_SHA2_256;
+    }
+    else if (variant == COSE_ALGORITHMS::HMAC_384_384) {
+        digestName = OSSL_DIGEST_NAME_SHA2_384;
+    }
+    else if (variant == COSE_ALGORITHMS::HMAC_512_512) {
+        digestName = OSSL_DIGEST_NAME_SHA2_512;
+    }
+    else {
+        return false;
+    }
+    EVP_MAC_CTX * ctx = static_cast<EVP_MAC_CTX*>(ctxWrapper.m_ctx);
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>(digestName), 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if (!EVP_MAC_init(ctx, key, keyLength, params)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < ipptParts.size(); ++i) {
+        if (!EVP_MAC_update(ctx, static_cast<const unsigned char*>(ipptParts[i].data()), ipptParts[i].size())) {
+            return false;
+        }
+    }
+    std::size_t outSize;
+    if (!EVP_MAC_final(ctx, messageDigestOut, &outSize, EVP_MAX_MD_SIZE)) {
+        return false;
+    }
+    messageDigestOutSize = static_cast<unsigned int>(outSize);
+    return true;
+#else
+    const EVP_MD * md;
+    if (variant == COSE_ALGORITHMS::HMAC_256_256) {
+        md = EVP_sha256();
+    }
+    else if (variant == COSE_ALGORITHMS::HMAC_384_384) {
+        md = EVP_sha384();
+    }
+    else if (variant == COSE_ALGORITHMS::HMAC_512_512) {
+        md = EVP_sha512();
+    }
+    else {
+        return false;
+    }
+    HMAC_CTX * ctx = static_cast<HMAC_CTX*>(ctxWrapper.m_ctx);
+    if (!HMAC_Init_ex(ctx, key, static_cast<int>(keyLength), md, NULL)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < ipptParts.size(); ++i) {
+        if (!HMAC_Update(ctx, static_cast<const unsigned char*>(ipptParts[i].data()), ipptParts[i].size())) {
+            return false;
+        }
+    }
+    return (HMAC_Final(ctx, messageDigestOut, &messageDigestOutSize) != 0);
+#endif
+}
+
+bool BPSecManager::AesGcmEncrypt(EvpCipherCtxWrapper & ctxWrapper,
+    uint8_t * inPlaceData, const uint64_t dataLength,
+    const uint8_t * key, const uint64_t keyLength,
+    const uint8_t * iv, const uint64_t ivLength,
+    const std::vector<boost::asio::const_buffer> & aadParts,
+    uint8_t * tagOut)
+{
+    EVP_CIPHER_CTX * ctx = static_cast<EVP_CIPHER_CTX*>(ctxWrapper.m_ctx);
+    const EVP_CIPHER * cipher = (keyLength == 16) ? EVP_aes_128_gcm() : (keyLength == 32) ? EVP_aes_256_gcm() : NULL;
+    if ((ctx == NULL) || (cipher == NULL) || (ivLength == 0) || (ivLength > INT_MAX)) {
+        return false;
+    }
+    if (!EVP_EncryptInit_ex(ctx, cipher, NULL, NULL, NULL)) {
+        return false;
+    }
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(ivLength), NULL)) {
+        return false;
+    }
+    if (!EVP_EncryptInit_ex(ctx, NULL, NULL, key, iv)) {
+        return false;
+    }
+    int len;
+    for (std::size_t i = 0; i < aadParts.size(); ++i) {
+        if (!EVP_EncryptUpdate(ctx, NULL, &len, static_cast<const unsigned char*>(aadParts[i].data()), static_cast<int>(aadParts[i].size()))) {
+            return false;
+        }
+    }
+    uint64_t remaining = dataLength;
+    uint8_t * dataPtr = inPlaceData;
+    while (remaining) {
+        const int chunkSize = static_cast<int>(std::min(remaining, MAX_EVP_UPDATE_CHUNK_SIZE));
+        if (!EVP_EncryptUpdate(ctx, dataPtr, &len, dataPtr, chunkSize)) {
+            return false;
+        }
+        dataPtr += len;
+        remaining -= len;
+    }
+    if (!EVP_EncryptFinal_ex(ctx, dataPtr, &len)) { //gcm mode writes nothing here
+        return false;
+    }
+    return (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, AES_GCM_TAG_LENGTH, tagOut) != 0);
+}
+
+bool BPSecManager::AesGcmDecrypt(EvpCipherCtxWrapper & ctxWrapper,
+    uint8_t * inPlaceData, const uint64_t dataLength,
+    const uint8_t * key, const uint64_t keyLength,
+    const uint8_t * iv, const uint64_t ivLength,
+    const std::vector<boost::asio::const_buffer> & aadParts,
+    const uint8_t * tag, const uint64_t tagLength)
+{
+    EVP_CIPHER_CTX * ctx = static_cast<EVP_CIPHER_CTX*>(ctxWrapper.m_ctx);
+    const EVP_CIPHER * cipher = (keyLength == 16) ? EVP_aes_128_gcm() : (keyLength == 32) ? EVP_aes_256_gcm() : NULL;
+    if ((ctx == NULL) || (cipher == NULL) || (ivLength == 0) || (ivLength > INT_MAX) || (tagLength != AES_GCM_TAG_LENGTH)) {
+        return false;
+    }
+    if (!EVP_DecryptInit_ex(ctx, cipher, NULL, NULL, NULL)) {
+        return false;
+    }
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(ivLength), NULL)) {
+        return false;
+    }
+    if (!EVP_DecryptInit_ex(ctx, NULL, NULL, key, iv)) {
+        return false;
+    }
+    int len;
+    for (std::size_t i = 0; i < aadParts.size(); ++i) {
+        if (!EVP_DecryptUpdate(ctx, NULL, &len, static_cast<const unsigned char*>(aadParts[i].data()), static_cast<int>(aadParts[i].size()))) {
+            return false;
+        }
+    }
+    uint64_t remaining = dataLength;
+    uint8_t * dataPtr = inPlaceData;
+    while (remaining) {
+        const int chunkSize = static_cast<int>(std::min(remaining, MAX_EVP_UPDATE_CHUNK_SIZE));
+        if (!EVP_DecryptUpdate(ctx, dataPtr, &len, dataPtr, chunkSize)) {
+            return false;
+        }
+        dataPtr += len;
+        remaining -= len;
+    }
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, AES_GCM_TAG_LENGTH, const_cast<uint8_t*>(tag))) {
+        return false;
+    }
+    return (EVP_DecryptFinal_ex(ctx, dataPtr, &len) > 0); //authentication
+}
+
+bool BPSecManager::AesWrapKey(EvpCipherCtxWrapper & ctxWrapper,
+    const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+    const uint8_t * keyToWrap, const unsigned int keyToWrapLength,
+    uint8_t * wrappedKeyOut, unsigned int & wrappedKeyOutSize)
+{
+    EVP_CIPHER_CTX * ctx = static_cast<EVP_CIPHER_CTX*>(ctxWrapper.m_ctx);
+    const EVP_CIPHER * cipher = GetAesKeyWrapCipher(keyEncryptionKeyLength);
+    if ((ctx == NULL) || (cipher == NULL) || (keyToWrapLength < 16) || ((keyToWrapLength % 8) != 0)) {
+        return false;
+    }
+    EVP_CIPHER_CTX_set_flags(ctx, EVP_CIPHER_CTX_FLAG_WRAP_ALLOW);
+    if (!EVP_EncryptInit_ex(ctx, cipher, NULL, keyEncryptionKey, NULL)) { //NULL iv => RFC 3394 default iv
+        return false;
+    }
+    int len;
+    if (!EVP_EncryptUpdate(ctx, wrappedKeyOut, &len, keyToWrap, static_cast<int>(keyToWrapLength))) {
+        return false;
+    }
+    wrappedKeyOutSize = static_cast<unsigned int>(len);
+    if (!EVP_EncryptFinal_ex(ctx, wrappedKeyOut + len, &len)) {
+        return false;
+    }
+    wrappedKeyOutSize += static_cast<unsigned int>(len);
+    return true;
+}
+
+bool BPSecManager::AesUnwrapKey(EvpCipherCtxWrapper & ctxWrapper,
+    const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+    const uint8_t * wrappedKey, const unsigned int wrappedKeyLength,
+    uint8_t * unwrappedKeyOut, unsigned int & unwrappedKeyOutSize)
+{
+    EVP_CIPHER_CTX * ctx = static_cast<EVP_CIPHER_CTX*>(ctxWrapper.m_ctx);
+    const EVP_CIPHER * cipher = GetAesKeyWrapCipher(keyEncryptionKeyLength);
+    if ((ctx == NULL) || (cipher == NULL) || (wrappedKeyLength < 24) || ((wrappedKeyLength % 8) != 0)) {
+        return false;
+    }
+    EVP_CIPHER_CTX_set_flags(ctx, EVP_CIPHER_CTX_FLAG_WRAP_ALLOW);
+    if (!EVP_DecryptInit_ex(ctx, cipher, NULL, keyEncryptionKey, NULL)) {
+        return false;
+    }
+    int len;
+    if (!EVP_DecryptUpdate(ctx, unwrappedKeyOut, &len, wrappedKey, static_cast<int>(wrappedKeyLength))) { //fails on integrity check
+        return false;
+    }
+    unwrappedKeyOutSize = static_cast<unsigned int>(len);
+    if (!EVP_DecryptFinal_ex(ctx, unwrappedKeyOut + len, &len)) {
+        return false;
+    }
+    unwrappedKeyOutSize += static_cast<unsigned int>(len);
+    return true;
+}
+
+uint8_t * BPSecManager::GetSerializedBlockTypeSpecificDataPtr(BundleViewV7::Bpv7CanonicalBlockView & cbv) {
+    if (cbv.dirty || cbv.markedForDeletion) { //not yet rendered
+        return NULL;
+    }
+    const Bpv7CanonicalBlock & block = *cbv.headerPtr;
+    const uint64_t crcSize = (block.m_crcType == BPV7_CRC_TYPE::CRC32C) ? 5 : (block.m_crcType == BPV7_CRC_TYPE::CRC16_X25) ? 3 : 0;
+    const uint64_t serializedSize = cbv.actualSerializedBlockPtr.size();
+    if ((cbv.actualSerializedBlockPtr.data() == NULL) || (serializedSize < (crcSize + block.m_dataLength + Bpv7CanonicalBlock::smallestSerializedCanonicalSize - 1))) {
+        return NULL;
+    }
+    //the block-type-specific data is always located immediately before the (optional) crc
+    return ((uint8_t*)cbv.actualSerializedBlockPtr.data()) + (serializedSize - (crcSize + block.m_dataLength));
+}
+
+BundleViewV7::Bpv7CanonicalBlockView * BPSecManager::GetCanonicalBlockViewByNumber(BundleViewV7 & bv, const uint64_t blockNumber) {
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::iterator it = bv.m_listCanonicalBlockView.begin(); it != bv.m_listCanonicalBlockView.end(); ++it) {
+        if ((it->headerPtr->m_blockNumber == blockNumber) && (!it->markedForDeletion)) {
+            return &(*it);
+        }
+    }
+    return NULL;
+}
+
+unsigned int BPSecManager::SerializeBlockHeaderForScope(uint8_t * serialization, const Bpv7CanonicalBlock & block) {
+    return SerializeBlockHeaderForScope(serialization, block.m_blockTypeCode, block.m_blockNumber, block.m_blockProcessingControlFlags);
+}
+unsigned int BPSecManager::SerializeBlockHeaderForScope(uint8_t * serialization,
+    const BPV7_BLOCK_TYPE_CODE blockTypeCode, const uint64_t blockNumber, const BPV7_BLOCKFLAG blockFlags)
+{
+    //canonical form of the block type code, block number, and block processing control flags (in that order)
+    uint8_t * const serializationBase = serialization;
+    serialization += CborEncodeU64BufSize9(serialization, static_cast<uint64_t>(blockTypeCode));
+    serialization += CborEncodeU64BufSize9(serialization, blockNumber);
+    serialization += CborEncodeU64BufSize9(serialization, static_cast<uint64_t>(blockFlags));
+    return static_cast<unsigned int>(serialization - serializationBase);
+}
+
+bool BPSecManager::TryAddBundleIntegrity(ReusableElementsInternal & reusableElements,
+    BundleViewV7 & bv,
+    const BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS integrityScopeMask,
+    const COSE_ALGORITHMS variant,
+    const cbhe_eid_t & securitySource,
+    const uint64_t * targetBlockNumbers, const unsigned int numTargets,
+    const uint8_t * hmacKey, const unsigned int hmacKeyLength,
+    const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+    const uint64_t bibBlockNumber,
+    const BPV7_BLOCKFLAG bibBlockProcessingControlFlags,
+    const BPV7_CRC_TYPE bibCrcType)
+{
+    if ((numTargets == 0) || bv.m_primaryBlockView.dirty || GetCanonicalBlockViewByNumber(bv, bibBlockNumber)) {
+        return false;
+    }
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7BlockIntegrityBlock>();
+    Bpv7BlockIntegrityBlock & bib = *(static_cast<Bpv7BlockIntegrityBlock*>(blockPtr.get()));
+    bib.m_blockProcessingControlFlags = bibBlockProcessingControlFlags;
+    bib.m_blockNumber = bibBlockNumber;
+    bib.m_crcType = bibCrcType;
+    bib.m_securityTargets.assign(targetBlockNumbers, targetBlockNumbers + numTargets);
+    bib.m_securityContextFlags = 0;
+    bib.SetSecurityContextParametersPresent();
+    bib.m_securitySource = securitySource;
+    if (!bib.AddOrUpdateSecurityParameterShaVariant(variant)) {
+        return false;
+    }
+    if (keyEncryptionKey) {
+        std::vector<uint8_t> & wrappedKey = *bib.AddAndGetWrappedKeyPtr();
+        wrappedKey.resize(hmacKeyLength + 8);
+        unsigned int wrappedKeyOutSize;
+        if (!AesWrapKey(reusableElements.keyWrapCtxWrapper, keyEncryptionKey, keyEncryptionKeyLength, hmacKey, hmacKeyLength, wrappedKey.data(), wrappedKeyOutSize)) {
+            return false;
+        }
+        wrappedKey.resize(wrappedKeyOutSize);
+    }
+    if (!bib.AddSecurityParameterIntegrityScope(integrityScopeMask)) {
+        return false;
+    }
+
+    uint8_t scopeFlagsSerialized[9];
+    uint8_t targetHeaderSerialized[27];
+    uint8_t securityHeaderSerialized[27];
+    const uint64_t scopeFlags = static_cast<uint64_t>(integrityScopeMask);
+    const unsigned int scopeFlagsSize = CborEncodeU64BufSize9(scopeFlagsSerialized, scopeFlags);
+    const unsigned int securityHeaderSize = SerializeBlockHeaderForScope(securityHeaderSerialized,
+        BPV7_BLOCK_TYPE_CODE::INTEGRITY, bibBlockNumber, bibBlockProcessingControlFlags);
+    std::vector<boost::asio::const_buffer> & ipptParts = reusableElements.constBufferVec;
+    for (unsigned int i = 0; i < numTargets; ++i) {
+        BundleViewV7::Bpv7CanonicalBlockView * targetPtr = GetCanonicalBlockViewByNumber(bv, targetBlockNumbers[i]);
+        if ((targetPtr == NULL) || targetPtr->isEncrypted) {
+            return false;
+        }
+        const uint8_t * const targetDataPtr = GetSerializedBlockTypeSpecificDataPtr(*targetPtr);
+        if (targetDataPtr == NULL) {
+            return false;
+        }
+        ipptParts.clear();
+        ipptParts.emplace_back(scopeFlagsSerialized, scopeFlagsSize);
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK)) {
+            ipptParts.emplace_back(bv.m_primaryBlockView.actualSerializedPrimaryBlockPtr);
+        }
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_TARGET_HEADER)) {
+            ipptParts.emplace_back(targetHeaderSerialized, SerializeBlockHeaderForScope(targetHeaderSerialized, *(targetPtr->headerPtr)));
+        }
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_SECURITY_HEADER)) {
+            ipptParts.emplace_back(securityHeaderSerialized, securityHeaderSize);
+        }
+        ipptParts.emplace_back(targetDataPtr, targetPtr->headerPtr->m_dataLength);
+
+        std::vector<uint8_t> & expectedHmac = *bib.AppendAndGetExpectedHmacPtr();
+        expectedHmac.resize(EVP_MAX_MD_SIZE);
+        unsigned int messageDigestOutSize;
+        if (!HmacSha(reusableElements.hmacCtxWrapper, variant, ipptParts, hmacKey, hmacKeyLength, expectedHmac.data(), messageDigestOutSize)) {
+            return false;
+        }
+        expectedHmac.resize(messageDigestOutSize);
+    }
+    return bv.InsertMoveCanonicalBlockBeforeBlockNumber(blockPtr, 1); //before the payload block
+}
+
+bool BPSecManager::TryVerifyBundleIntegrity(ReusableElementsInternal & reusableElements,
+    BundleViewV7 & bv,
+    const uint8_t * hmacKeyOrKeyEncryptionKey, const unsigned int keyLength,
+    const bool markBibForDeletion)
+{
+    if (bv.m_primaryBlockView.dirty) {
+        return false;
+    }
+    uint8_t scopeFlagsSerialized[9];
+    uint8_t targetHeaderSerialized[27];
+    uint8_t securityHeaderSerialized[27];
+    uint8_t computedHmac[EVP_MAX_MD_SIZE];
+    std::vector<boost::asio::const_buffer> & ipptParts = reusableElements.constBufferVec;
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::iterator it = bv.m_listCanonicalBlockView.begin(); it != bv.m_listCanonicalBlockView.end(); ++it) {
+        if ((it->headerPtr->m_blockTypeCode != BPV7_BLOCK_TYPE_CODE::INTEGRITY) || it->isEncrypted || it->markedForDeletion) {
+            continue;
+        }
+        Bpv7BlockIntegrityBlock * bibPtr = dynamic_cast<Bpv7BlockIntegrityBlock*>(it->headerPtr.get());
+        if (bibPtr == NULL) {
+            return false;
+        }
+        uint64_t variant;
+        uint64_t scopeFlags;
+        if ((!GetSecurityParameterUintOrDefault(*bibPtr, static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_SECURITY_PARAMETERS::SHA_VARIANT),
+                static_cast<uint64_t>(COSE_ALGORITHMS::HMAC_384_384), variant))
+            || (!GetSecurityParameterUintOrDefault(*bibPtr, static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_SECURITY_PARAMETERS::INTEGRITY_SCOPE_FLAGS), 7, scopeFlags)))
+        {
+            return false;
+        }
+        const uint8_t * hmacKey = hmacKeyOrKeyEncryptionKey;
+        unsigned int hmacKeyLength = keyLength;
+        if (const std::vector<uint8_t> * wrappedKeyPtr = GetSecurityParameterByteStringPtr(*bibPtr, static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_SECURITY_PARAMETERS::WRAPPED_KEY))) {
+            reusableElements.unwrappedKeyBytes.resize(wrappedKeyPtr->size());
+            if (!AesUnwrapKey(reusableElements.keyWrapCtxWrapper, hmacKeyOrKeyEncryptionKey, keyLength,
+                wrappedKeyPtr->data(), static_cast<unsigned int>(wrappedKeyPtr->size()), reusableElements.unwrappedKeyBytes.data(), hmacKeyLength))
+            {
+                return false;
+            }
+            hmacKey = reusableElements.unwrappedKeyBytes.data();
+        }
+        std::vector<std::vector<uint8_t>*> expectedHmacPtrs = bibPtr->GetAllExpectedHmacPtrs();
+        if (expectedHmacPtrs.size() != bibPtr->m_securityTargets.size()) {
+            return false;
+        }
+        const unsigned int scopeFlagsSize = CborEncodeU64BufSize9(scopeFlagsSerialized, scopeFlags);
+        const unsigned int securityHeaderSize = SerializeBlockHeaderForScope(securityHeaderSerialized, *bibPtr);
+        for (std::size_t i = 0; i < bibPtr->m_securityTargets.size(); ++i) {
+            BundleViewV7::Bpv7CanonicalBlockView * targetPtr = GetCanonicalBlockViewByNumber(bv, bibPtr->m_securityTargets[i]);
+            if ((targetPtr == NULL) || targetPtr->isEncrypted) {
+                return false;
+            }
+            const uint8_t * const targetDataPtr = GetSerializedBlockTypeSpecificDataPtr(*targetPtr);
+            if (targetDataPtr == NULL) {
+                return false;
+            }
+            ipptParts.clear();
+            ipptParts.emplace_back(scopeFlagsSerialized, scopeFlagsSize);
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK)) {
+                ipptParts.emplace_back(bv.m_primaryBlockView.actualSerializedPrimaryBlockPtr);
+            }
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_TARGET_HEADER)) {
+                ipptParts.emplace_back(targetHeaderSerialized, SerializeBlockHeaderForScope(targetHeaderSerialized, *(targetPtr->headerPtr)));
+            }
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_SECURITY_HEADER)) {
+                ipptParts.emplace_back(securityHeaderSerialized, securityHeaderSize);
+            }
+            ipptParts.emplace_back(targetDataPtr, targetPtr->headerPtr->m_dataLength);
+            unsigned int computedHmacSize;
+            if (!HmacSha(reusableElements.hmacCtxWrapper, static_cast<COSE_ALGORITHMS>(variant), ipptParts, hmacKey, hmacKeyLength, computedHmac, computedHmacSize)) {
+                return false;
+            }
+            const std::vector<uint8_t> & expectedHmac = *expectedHmacPtrs[i];
+            if ((expectedHmac.size() != computedHmacSize) || (CRYPTO_memcmp(expectedHmac.data(), computedHmac, computedHmacSize) != 0)) {
+                return false;
+            }
+        }
+        if (markBibForDeletion) {
+            it->markedForDeletion = true;
+        }
+    }
+    return true;
+}
+
+bool BPSecManager::TryEncryptBundle(ReusableElementsInternal & reusableElements,
+    BundleViewV7 & bv,
+    const BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS aadScopeMask,
+    const COSE_ALGORITHMS aesVariant,
+    const cbhe_eid_t & securitySource,
+    const uint64_t * targetBlockNumbers, const unsigned int numTargets,
+    const uint8_t * iv, const unsigned int ivLength,
+    const uint8_t * contentEncryptionKey, const unsigned int contentEncryptionKeyLength,
+    const uint8_t * keyEncryptionKey, const unsigned int keyEncryptionKeyLength,
+    const uint64_t bcbBlockNumber,
+    const BPV7_BLOCKFLAG bcbBlockProcessingControlFlags,
+    const BPV7_CRC_TYPE bcbCrcType)
+{
+    if ((numTargets == 0) || bv.m_primaryBlockView.dirty || GetCanonicalBlockViewByNumber(bv, bcbBlockNumber)
+        || (GetAesGcmCipher(aesVariant, contentEncryptionKeyLength) == NULL))
+    {
+        return false;
+    }
+    //validate all targets prior to modifying any data in place
+    for (unsigned int i = 0; i < numTargets; ++i) {
+        BundleViewV7::Bpv7CanonicalBlockView * targetPtr = GetCanonicalBlockViewByNumber(bv, targetBlockNumbers[i]);
+        if ((targetPtr == NULL) || targetPtr->isEncrypted || (targetPtr->headerPtr->m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::CONFIDENTIALITY)
+            || (GetSerializedBlockTypeSpecificDataPtr(*targetPtr) == NULL))
+        {
+            return false;
+        }
+    }
+
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7BlockConfidentialityBlock>();
+    Bpv7BlockConfidentialityBlock & bcb = *(static_cast<Bpv7BlockConfidentialityBlock*>(blockPtr.get()));
+    bcb.m_blockProcessingControlFlags = bcbBlockProcessingControlFlags;
+    bcb.m_blockNumber = bcbBlockNumber;
+    bcb.m_crcType = bcbCrcType;
+    bcb.m_securityTargets.assign(targetBlockNumbers, targetBlockNumbers + numTargets);
+    bcb.m_securityContextFlags = 0;
+    bcb.SetSecurityContextParametersPresent();
+    bcb.m_securitySource = securitySource;
+    bcb.AddAndGetInitializationVectorPtr()->assign(iv, iv + ivLength);
+    if (!bcb.AddOrUpdateSecurityParameterAesVariant(aesVariant)) {
+        return false;
+    }
+    if (keyEncryptionKey) {
+        std::vector<uint8_t> & wrappedKey = *bcb.AddAndGetAesWrappedKeyPtr();
+        wrappedKey.resize(contentEncryptionKeyLength + 8);
+        unsigned int wrappedKeyOutSize;
+        if (!AesWrapKey(reusableElements.keyWrapCtxWrapper, keyEncryptionKey, keyEncryptionKeyLength,
+            contentEncryptionKey, contentEncryptionKeyLength, wrappedKey.data(), wrappedKeyOutSize))
+        {
+            return false;
+        }
+        wrappedKey.resize(wrappedKeyOutSize);
+    }
+    if (!bcb.AddSecurityParameterScope(aadScopeMask)) {
+        return false;
+    }
+
+    uint8_t scopeFlagsSerialized[9];
+    uint8_t targetHeaderSerialized[27];
+    uint8_t securityHeaderSerialized[27];
+    const uint64_t scopeFlags = static_cast<uint64_t>(aadScopeMask);
+    const unsigned int scopeFlagsSize = CborEncodeU64BufSize9(scopeFlagsSerialized, scopeFlags);
+    const unsigned int securityHeaderSize = SerializeBlockHeaderForScope(securityHeaderSerialized,
+        BPV7_BLOCK_TYPE_CODE::CONFIDENTIALITY, bcbBlockNumber, bcbBlockProcessingControlFlags);
+    std::vector<boost::asio::const_buffer> & aadParts = reusableElements.constBufferVec;
+    for (unsigned int i = 0; i < numTargets; ++i) {
+        BundleViewV7::Bpv7CanonicalBlockView & target = *GetCanonicalBlockViewByNumber(bv, targetBlockNumbers[i]);
+        uint8_t * const targetDataPtr = GetSerializedBlockTypeSpecificDataPtr(target);
+        aadParts.clear();
+        aadParts.emplace_back(scopeFlagsSerialized, scopeFlagsSize);
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK)) {
+            aadParts.emplace_back(bv.m_primaryBlockView.actualSerializedPrimaryBlockPtr);
+        }
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_TARGET_HEADER)) {
+            aadParts.emplace_back(targetHeaderSerialized, SerializeBlockHeaderForScope(targetHeaderSerialized, *(target.headerPtr)));
+        }
+        if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_SECURITY_HEADER)) {
+            aadParts.emplace_back(securityHeaderSerialized, securityHeaderSize);
+        }
+        std::vector<uint8_t> & tag = *bcb.AppendAndGetPayloadAuthenticationTagPtr();
+        tag.resize(AES_GCM_TAG_LENGTH);
+        if (!AesGcmEncrypt(reusableElements.cipherCtxWrapper, targetDataPtr, target.headerPtr->m_dataLength,
+            contentEncryptionKey, contentEncryptionKeyLength, iv, ivLength, aadParts, tag.data()))
+        {
+            return false;
+        }
+        target.headerPtr->m_dataPtr = targetDataPtr;
+        target.headerPtr->RecomputeCrcAfterDataModification((uint8_t*)target.actualSerializedBlockPtr.data(), target.actualSerializedBlockPtr.size());
+        target.isEncrypted = true;
+        bv.m_mapEncryptedBlockNumberToBcbPtr[targetBlockNumbers[i]] = &bcb;
+    }
+    return bv.InsertMoveCanonicalBlockBeforeBlockNumber(blockPtr, 1); //before the payload block
+}
+
+bool BPSecManager::TryDecryptBundle(ReusableElementsInternal & reusableElements,
+    BundleViewV7 & bv,
+    const uint8_t * contentEncryptionKeyOrKeyEncryptionKey, const unsigned int keyLength)
+{
+    if (bv.m_primaryBlockView.dirty) {
+        return false;
+    }
+    uint8_t scopeFlagsSerialized[9];
+    uint8_t targetHeaderSerialized[27];
+    uint8_t securityHeaderSerialized[27];
+    uint8_t restoreTag[AES_GCM_TAG_LENGTH];
+    std::vector<boost::asio::const_buffer> & aadParts = reusableElements.constBufferVec;
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::iterator it = bv.m_listCanonicalBlockView.begin(); it != bv.m_listCanonicalBlockView.end(); ++it) {
+        if ((it->headerPtr->m_blockTypeCode != BPV7_BLOCK_TYPE_CODE::CONFIDENTIALITY) || it->markedForDeletion) {
+            continue;
+        }
+        Bpv7BlockConfidentialityBlock * bcbPtr = dynamic_cast<Bpv7BlockConfidentialityBlock*>(it->headerPtr.get());
+        if (bcbPtr == NULL) {
+            return false;
+        }
+        uint64_t aesVariant;
+        uint64_t scopeFlags;
+        if ((!GetSecurityParameterUintOrDefault(*bcbPtr, static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SECURITY_PARAMETERS::AES_VARIANT),
+                static_cast<uint64_t>(COSE_ALGORITHMS::A256GCM), aesVariant))
+            || (!GetSecurityParameterUintOrDefault(*bcbPtr, static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SECURITY_PARAMETERS::AAD_SCOPE_FLAGS), 7, scopeFlags)))
+        {
+            return false;
+        }
+        const std::vector<uint8_t> * ivPtr = GetSecurityParameterByteStringPtr(*bcbPtr, static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SECURITY_PARAMETERS::INITIALIZATION_VECTOR));
+        if (ivPtr == NULL) {
+            return false;
+        }
+        const uint8_t * cek = contentEncryptionKeyOrKeyEncryptionKey;
+        unsigned int cekLength = keyLength;
+        if (const std::vector<uint8_t> * wrappedKeyPtr = GetSecurityParameterByteStringPtr(*bcbPtr, static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SECURITY_PARAMETERS::WRAPPED_KEY))) {
+            reusableElements.unwrappedKeyBytes.resize(wrappedKeyPtr->size());
+            if (!AesUnwrapKey(reusableElements.keyWrapCtxWrapper, contentEncryptionKeyOrKeyEncryptionKey, keyLength,
+                wrappedKeyPtr->data(), static_cast<unsigned int>(wrappedKeyPtr->size()), reusableElements.unwrappedKeyBytes.data(), cekLength))
+            {
+                return false;
+            }
+            cek = reusableElements.unwrappedKeyBytes.data();
+        }
+        if (GetAesGcmCipher(static_cast<COSE_ALGORITHMS>(aesVariant), cekLength) == NULL) {
+            return false;
+        }
+        std::vector<std::vector<uint8_t>*> tagPtrs = bcbPtr->GetAllPayloadAuthenticationTagPtrs();
+        const std::vector<uint64_t> & targets = bcbPtr->m_securityTargets;
+        if (tagPtrs.size() != targets.size()) {
+            return false;
+        }
+        const unsigned int scopeFlagsSize = CborEncodeU64BufSize9(scopeFlagsSerialized, scopeFlags);
+        const unsigned int securityHeaderSize = SerializeBlockHeaderForScope(securityHeaderSerialized, *bcbPtr);
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            BundleViewV7::Bpv7CanonicalBlockView * targetPtr = GetCanonicalBlockViewByNumber(bv, targets[i]);
+            if ((targetPtr == NULL) || (!targetPtr->isEncrypted) || (GetSerializedBlockTypeSpecificDataPtr(*targetPtr) == NULL)) {
+                return false;
+            }
+        }
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            BundleViewV7::Bpv7CanonicalBlockView & target = *GetCanonicalBlockViewByNumber(bv, targets[i]);
+            uint8_t * const targetDataPtr = GetSerializedBlockTypeSpecificDataPtr(target);
+            aadParts.clear();
+            aadParts.emplace_back(scopeFlagsSerialized, scopeFlagsSize);
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK)) {
+                aadParts.emplace_back(bv.m_primaryBlockView.actualSerializedPrimaryBlockPtr);
+            }
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_TARGET_HEADER)) {
+                aadParts.emplace_back(targetHeaderSerialized, SerializeBlockHeaderForScope(targetHeaderSerialized, *(target.headerPtr)));
+            }
+            if (scopeFlags & static_cast<uint64_t>(BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_SECURITY_HEADER)) {
+                aadParts.emplace_back(securityHeaderSerialized, securityHeaderSize);
+            }
+            if (!AesGcmDecrypt(reusableElements.cipherCtxWrapper, targetDataPtr, target.headerPtr->m_dataLength,
+                cek, cekLength, ivPtr->data(), ivPtr->size(), aadParts, tagPtrs[i]->data(), tagPtrs[i]->size()))
+            {
+                //gcm is a counter mode, so re-encrypting restores the ciphertext of this and all previously decrypted targets of this bcb
+                for (std::size_t j = 0; j <= i; ++j) {
+                    BundleViewV7::Bpv7CanonicalBlockView & restoreTarget = *GetCanonicalBlockViewByNumber(bv, targets[j]);
+                    aadParts.clear();
+                    AesGcmEncrypt(reusableElements.cipherCtxWrapper, GetSerializedBlockTypeSpecificDataPtr(restoreTarget), restoreTarget.headerPtr->m_dataLength,
+                        cek, cekLength, ivPtr->data(), ivPtr->size(), aadParts, restoreTag);
+                }
+                return false;
+            }
+        }
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            BundleViewV7::Bpv7CanonicalBlockView & target = *GetCanonicalBlockViewByNumber(bv, targets[i]);
+            target.headerPtr->m_dataPtr = GetSerializedBlockTypeSpecificDataPtr(target);
+            target.headerPtr->RecomputeCrcAfterDataModification((uint8_t*)target.actualSerializedBlockPtr.data(), target.actualSerializedBlockPtr.size());
+            target.isEncrypted = false;
+            bv.m_mapEncryptedBlockNumberToBcbPtr.erase(targets[i]);
+            if (!target.headerPtr->Virtual_DeserializeExtensionBlockDataBpv7()) {
+                return false;
+            }
+        }
+        it->markedForDeletion = true;
+    }
+    return true;
+}
+
+
+BpSecWorkerPool::BpSecWorkerPool(const unsigned int numThreads) :
+    m_numThreads((numThreads) ? numThreads : 1),
+    m_workPtr(boost::make_unique<boost::asio::io_service::work>(m_ioService)),
+    m_numWorkersRemaining(0),
+    m_numSuccessful(0)
+{
+    for (unsigned int i = 0; i < m_numThreads; ++i) {
+        m_reusableElementsPerWorker.emplace_back(boost::make_unique<BPSecManager::ReusableElementsInternal>());
+    }
+    for (unsigned int i = 0; i < m_numThreads; ++i) {
+        m_threadGroup.create_thread(boost::bind(&boost::asio::io_service::run, &m_ioService));
+    }
+}
+
+BpSecWorkerPool::~BpSecWorkerPool() {
+    m_workPtr.reset(); //allow run() to return once idle
+    m_threadGroup.join_all();
+}
+
+unsigned int BpSecWorkerPool::GetNumThreads() const {
+    return m_numThreads;
+}
+
+std::size_t BpSecWorkerPool::ProcessBatch(std::vector<BundleViewV7*> & bundles, const bundle_operation_function_t & operation, std::vector<uint8_t> & successes) {
+    successes.assign(bundles.size(), 0);
+    if (bundles.empty()) {
+        return 0;
+    }
+    const unsigned int numWorkers = static_cast<unsigned int>(std::min<std::size_t>(m_numThreads, bundles.size()));
+    {
+        boost::mutex::scoped_lock lock(m_batchMutex);
+        m_numWorkersRemaining = numWorkers;
+        m_numSuccessful = 0;
+    }
+    for (unsigned int i = 0; i < numWorkers; ++i) {
+        m_ioService.post(boost::bind(&BpSecWorkerPool::ProcessStridedSubset, this, i, &bundles, &operation, &successes));
+    }
+    boost::mutex::scoped_lock lock(m_batchMutex);
+    while (m_numWorkersRemaining) {
+        m_batchCv.wait(lock);
+    }
+    return m_numSuccessful;
+}
+
+void BpSecWorkerPool::ProcessStridedSubset(const unsigned int workerIndex, std::vector<BundleViewV7*> * bundlesPtr,
+    const bundle_operation_function_t * operationPtr, std::vector<uint8_t> * successesPtr)
+{
+    //contiguous ranges per worker avoid false sharing on the successes vector
+    const std::size_t numBundles = bundlesPtr->size();
+    const std::size_t numWorkers = std::min<std::size_t>(m_numThreads, numBundles);
+    const std::size_t begin = (numBundles * workerIndex) / numWorkers;
+    const std::size_t end = (numBundles * (workerIndex + 1)) / numWorkers;
+    BPSecManager::ReusableElementsInternal & reusableElements = *m_reusableElementsPerWorker[workerIndex];
+    std::size_t numSuccessful = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        if ((*operationPtr)(*((*bundlesPtr)[i]), reusableElements)) {
+            (*successesPtr)[i] = 1;
+            ++numSuccessful;
+        }
+    }
+    boost::mutex::scoped_lock lock(m_batchMutex);
+    m_numSuccessful += numSuccessful;
+    if (--m_numWorkersRemaining == 0) {
+        m_batchCv.notify_one();
+    }
+}
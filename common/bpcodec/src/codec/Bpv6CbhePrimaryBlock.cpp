@@ -300,6 +300,12 @@ bool Bpv6CbhePrimaryBlock::HasCustodyFlagSet() const {
 bool Bpv6CbhePrimaryBlock::HasFragmentationFlagSet() const {
     return ((m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::ISFRAGMENT) != BPV6_BUNDLEFLAG::NO_FLAGS_SET);
 }
+bool Bpv6CbhePrimaryBlock::HasDeletionStatusReportsRequested() const {
+    return ((m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED) != BPV6_BUNDLEFLAG::NO_FLAGS_SET);
+}
+bool Bpv6CbhePrimaryBlock::HasUnknownCreationTime() const {
+    return (m_creationTimestamp.secondsSinceStartOfYear2000 == 0);
+}
 
 cbhe_bundle_uuid_t Bpv6CbhePrimaryBlock::GetCbheBundleUuidFromPrimary() const {
     cbhe_bundle_uuid_t uuid;
@@ -491,6 +491,12 @@ bool Bpv7CbhePrimaryBlock::HasFragmentationFlagSet() const {
     const bool isFragment = ((m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ISFRAGMENT) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
     return isFragment;
 }
+bool Bpv7CbhePrimaryBlock::HasDeletionStatusReportsRequested() const {
+    return ((m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+}
+bool Bpv7CbhePrimaryBlock::HasUnknownCreationTime() const {
+    return (m_creationTimestamp.millisecondsSinceStartOfYear2000 == 0); //RFC 9171 4.2.7 (the node has no accurate clock)
+}
 
 cbhe_bundle_uuid_t Bpv7CbhePrimaryBlock::GetCbheBundleUuidFromPrimary() const {
     cbhe_bundle_uuid_t uuid;
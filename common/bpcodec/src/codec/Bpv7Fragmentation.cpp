@@ -0,0 +1,358 @@
+#include "codec/Bpv7Fragmentation.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <boost/next_prior.hpp>
+
+static const Bpv7CanonicalBlock * GetPayloadBlock(const BundleViewV7 & bv) {
+    if (bv.m_listCanonicalBlockView.empty()) {
+        return NULL;
+    }
+    const Bpv7CanonicalBlock * const payloadBlockPtr = bv.m_listCanonicalBlockView.back().headerPtr.get();
+    if ((payloadBlockPtr == NULL) || (payloadBlockPtr->m_blockTypeCode != BPV7_BLOCK_TYPE_CODE::PAYLOAD)) {
+        return NULL;
+    }
+    return payloadBlockPtr;
+}
+
+static bool IsFragment(const Bpv7CbhePrimaryBlock & primary) {
+    return ((primary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ISFRAGMENT) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+}
+
+//the fragment offset of payloadBeginIndex relative to the original (unfragmented) application data unit
+static uint64_t GetAbsoluteFragmentOffset(const Bpv7CbhePrimaryBlock & primary, const uint64_t payloadBeginIndex) {
+    return (IsFragment(primary) ? primary.m_fragmentOffset : 0) + payloadBeginIndex;
+}
+
+static void MakeFragmentPrimary(const Bpv7CbhePrimaryBlock & primary, const uint64_t payloadLength, const uint64_t payloadBeginIndex, Bpv7CbhePrimaryBlock & fragmentPrimary) {
+    fragmentPrimary = primary;
+    if (!IsFragment(primary)) {
+        fragmentPrimary.m_bundleProcessingControlFlags |= BPV7_BUNDLEFLAG::ISFRAGMENT;
+        fragmentPrimary.m_totalApplicationDataUnitLength = payloadLength;
+    }
+    fragmentPrimary.m_fragmentOffset = GetAbsoluteFragmentOffset(primary, payloadBeginIndex);
+}
+
+static bool IsReplicatedInFragment(const BundleViewV7::Bpv7CanonicalBlockView & cbv, const uint64_t absoluteFragmentOffset) {
+    return (absoluteFragmentOffset == 0)
+        || ((cbv.headerPtr->m_blockProcessingControlFlags & BPV7_BLOCKFLAG::MUST_BE_REPLICATED) != BPV7_BLOCKFLAG::NO_FLAGS_SET);
+}
+
+bool Bpv7Fragmenter::IsFragmentable(const BundleViewV7 & bv) {
+    const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    if ((primary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::NOFRAGMENT) != BPV7_BUNDLEFLAG::NO_FLAGS_SET) {
+        return false;
+    }
+    //BCB targets cannot be tracked across fragments
+    if (!bv.m_mapEncryptedBlockNumberToBcbPtr.empty()) {
+        return false;
+    }
+    //a BIB over the payload or the primary block could no longer be verified, since every fragment changes both
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::const_iterator it = bv.m_listCanonicalBlockView.cbegin(); it != bv.m_listCanonicalBlockView.cend(); ++it) {
+        if (it->headerPtr->m_blockTypeCode != BPV7_BLOCK_TYPE_CODE::INTEGRITY) {
+            continue;
+        }
+        const Bpv7BlockIntegrityBlock * const bibPtr = dynamic_cast<const Bpv7BlockIntegrityBlock*>(it->headerPtr.get());
+        if (bibPtr == NULL) {
+            return false;
+        }
+        for (std::size_t i = 0; i < bibPtr->m_securityTargets.size(); ++i) {
+            if (bibPtr->m_securityTargets[i] <= 1) { //0 is the primary block, 1 is the payload block
+                return false;
+            }
+        }
+    }
+    const Bpv7CanonicalBlock * const payloadBlockPtr = GetPayloadBlock(bv);
+    return (payloadBlockPtr != NULL) && (payloadBlockPtr->m_dataPtr != NULL) && (payloadBlockPtr->m_dataLength != 0);
+}
+
+uint64_t Bpv7Fragmenter::GetFragmentSerializationSizeExcludingPayloadData(const BundleViewV7 & bv, const uint64_t payloadBeginIndex, const uint64_t payloadLength) {
+    const Bpv7CanonicalBlock & payloadBlock = *GetPayloadBlock(bv);
+    Bpv7CbhePrimaryBlock fragmentPrimary;
+    MakeFragmentPrimary(bv.m_primaryBlockView.header, payloadBlock.m_dataLength, payloadBeginIndex, fragmentPrimary);
+    uint64_t size = 2; //cbor indefinite array start and break stop code
+    size += fragmentPrimary.GetSerializationSize();
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::const_iterator it = bv.m_listCanonicalBlockView.cbegin(); it != boost::prior(bv.m_listCanonicalBlockView.cend()); ++it) {
+        if (IsReplicatedInFragment(*it, fragmentPrimary.m_fragmentOffset)) {
+            size += it->actualSerializedBlockPtr.size();
+        }
+    }
+    Bpv7CanonicalBlock fragmentPayloadBlock(payloadBlock);
+    fragmentPayloadBlock.m_dataLength = payloadLength;
+    size += fragmentPayloadBlock.GetSerializationSize() - payloadLength;
+    return size;
+}
+
+bool Bpv7Fragmenter::FragmentPayloadRange(const BundleViewV7 & bv, const uint64_t payloadBeginIndex, const uint64_t payloadLength, std::vector<uint8_t> & fragment) {
+    if (!IsFragmentable(bv)) {
+        return false;
+    }
+    const Bpv7CanonicalBlock & payloadBlock = *GetPayloadBlock(bv);
+    if ((payloadLength == 0) || (payloadBeginIndex >= payloadBlock.m_dataLength) || (payloadLength > (payloadBlock.m_dataLength - payloadBeginIndex))) {
+        return false;
+    }
+    //blocks are copied as they were last loaded or rendered
+    if (bv.m_primaryBlockView.dirty) {
+        return false;
+    }
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::const_iterator it = bv.m_listCanonicalBlockView.cbegin(); it != bv.m_listCanonicalBlockView.cend(); ++it) {
+        if (it->dirty || it->markedForDeletion) {
+            return false;
+        }
+    }
+
+    fragment.resize(GetFragmentSerializationSizeExcludingPayloadData(bv, payloadBeginIndex, payloadLength) + payloadLength);
+    uint8_t * serialization = fragment.data();
+    *serialization++ = (4U << 5) | 31U; //major type 4, additional information 31 (Indefinite-Length Array)
+
+    Bpv7CbhePrimaryBlock fragmentPrimary;
+    MakeFragmentPrimary(bv.m_primaryBlockView.header, payloadBlock.m_dataLength, payloadBeginIndex, fragmentPrimary);
+    const uint64_t primarySizeSerialized = fragmentPrimary.SerializeBpv7(serialization);
+    if (primarySizeSerialized == 0) {
+        return false;
+    }
+    serialization += primarySizeSerialized;
+
+    for (std::list<BundleViewV7::Bpv7CanonicalBlockView>::const_iterator it = bv.m_listCanonicalBlockView.cbegin(); it != boost::prior(bv.m_listCanonicalBlockView.cend()); ++it) {
+        if (IsReplicatedInFragment(*it, fragmentPrimary.m_fragmentOffset)) {
+            const std::size_t size = it->actualSerializedBlockPtr.size();
+            memcpy(serialization, it->actualSerializedBlockPtr.data(), size);
+            serialization += size;
+        }
+    }
+
+    Bpv7CanonicalBlock fragmentPayloadBlock(payloadBlock);
+    fragmentPayloadBlock.m_dataPtr = payloadBlock.m_dataPtr + payloadBeginIndex;
+    fragmentPayloadBlock.m_dataLength = payloadLength;
+    serialization += fragmentPayloadBlock.SerializeBpv7(serialization);
+    *serialization++ = 0xff; //break stop code
+
+    const uint64_t fragmentSizeSerialized = serialization - fragment.data();
+    if (fragmentSizeSerialized != fragment.size()) {
+        std::cerr << "error in Bpv7Fragmenter::FragmentPayloadRange: serialized size " << fragmentSizeSerialized
+            << " does not match the computed size " << fragment.size() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Bpv7Fragmenter::Fragment(const BundleViewV7 & bv, const uint64_t maxFragmentBundleSizeBytes, std::list<std::vector<uint8_t> > & fragments) {
+    if (!IsFragmentable(bv)) {
+        return false;
+    }
+    const std::size_t originalNumFragments = fragments.size();
+    const uint64_t payloadLength = GetPayloadBlock(bv)->m_dataLength;
+    for (uint64_t payloadBeginIndex = 0; payloadBeginIndex < payloadLength; ) {
+        const uint64_t remainingLength = payloadLength - payloadBeginIndex;
+        //cbor headers are sized for the remaining length, so the chunk can only be smaller
+        const uint64_t overhead = GetFragmentSerializationSizeExcludingPayloadData(bv, payloadBeginIndex, remainingLength);
+        if (overhead >= maxFragmentBundleSizeBytes) {
+            std::cerr << "error in Bpv7Fragmenter::Fragment: fragment overhead of " << overhead
+                << " bytes does not fit in the max fragment size of " << maxFragmentBundleSizeBytes << " bytes\n";
+            fragments.resize(originalNumFragments);
+            return false;
+        }
+        const uint64_t chunkLength = std::min(remainingLength, maxFragmentBundleSizeBytes - overhead);
+        fragments.emplace_back();
+        if (!FragmentPayloadRange(bv, payloadBeginIndex, chunkLength, fragments.back())) {
+            fragments.resize(originalNumFragments);
+            return false;
+        }
+        payloadBeginIndex += chunkLength;
+    }
+    return true;
+}
+
+//the index of the first payload data byte within the serialized bundle
+static uint64_t GetPayloadDataIndex(const BundleViewV7 & bv) {
+    return static_cast<uint64_t>(GetPayloadBlock(bv)->m_dataPtr - static_cast<const uint8_t*>(bv.m_renderedBundle.data()));
+}
+
+bool Bpv7Fragmenter::FragmentUnsentRemainder(uint8_t * bundleData, const uint64_t bundleSizeBytes, const uint64_t numBytesDelivered, std::vector<uint8_t> & fragment) {
+    if ((bundleSizeBytes == 0) || (bundleData[0] != ((4U << 5) | 31U))) { //not bpv7
+        return false;
+    }
+    BundleViewV7 bv;
+    if ((!bv.LoadBundle(bundleData, bundleSizeBytes, true)) || (!IsFragmentable(bv))) { //crcs were verified before the bundle was first sent
+        return false;
+    }
+    const uint64_t payloadDataIndex = GetPayloadDataIndex(bv);
+    const uint64_t payloadLength = GetPayloadBlock(bv)->m_dataLength;
+    //even with no payload acked, the receiver may hold (and deliver as a fragment) payload whose acks were lost, so resend the whole payload as a fragment
+    const uint64_t payloadBytesDelivered = (numBytesDelivered <= payloadDataIndex) ? 0 : std::min(numBytesDelivered - payloadDataIndex, payloadLength);
+    if (payloadBytesDelivered == payloadLength) { //only the trailing crc and break stop code are missing
+        return false;
+    }
+    return FragmentPayloadRange(bv, payloadBytesDelivered, payloadLength - payloadBytesDelivered, fragment);
+}
+
+bool Bpv7Fragmenter::FragmentReceivedPrefix(uint8_t * bundleBuffer, const uint64_t numBytesReceived, const uint64_t bundleSizeBytes, std::vector<uint8_t> & fragment) {
+    if ((numBytesReceived == 0) || (numBytesReceived >= bundleSizeBytes) || (bundleBuffer[0] != ((4U << 5) | 31U))) {
+        return false;
+    }
+    //The payload block is the last block, so its data is followed only by its crc (if any) and the break stop code.
+    //The payload block's crc type is unknown until it is decoded, so try a zeroed crc trailer for each type until the bundle loads.
+    //Only the payload block header has to be among the received bytes; the missing payload data is zero filled.
+    static const uint8_t TRAILER_CRC_NONE[1] = { 0xff };
+    static const uint8_t TRAILER_CRC16[4] = { (2U << 5) | 2U, 0, 0, 0xff };
+    static const uint8_t TRAILER_CRC32C[6] = { (2U << 5) | 4U, 0, 0, 0, 0, 0xff };
+    static const uint8_t * const TRAILERS[3] = { TRAILER_CRC_NONE, TRAILER_CRC16, TRAILER_CRC32C };
+    static const uint64_t TRAILER_SIZES[3] = { sizeof(TRAILER_CRC_NONE), sizeof(TRAILER_CRC16), sizeof(TRAILER_CRC32C) };
+    for (unsigned int i = 0; i < 3; ++i) {
+        const uint64_t trailerSize = TRAILER_SIZES[i];
+        if (bundleSizeBytes <= trailerSize) {
+            continue;
+        }
+        const uint64_t trailerIndex = bundleSizeBytes - trailerSize;
+        if (numBytesReceived < trailerIndex) {
+            memset(bundleBuffer + numBytesReceived, 0, trailerIndex - numBytesReceived);
+        }
+        memcpy(bundleBuffer + trailerIndex, TRAILERS[i], trailerSize);
+        BundleViewV7 bv;
+        if ((!bv.LoadBundle(bundleBuffer, bundleSizeBytes, true)) || (!IsFragmentable(bv))) {
+            continue;
+        }
+        const uint64_t payloadDataIndex = GetPayloadDataIndex(bv);
+        if (numBytesReceived <= payloadDataIndex) {
+            return false;
+        }
+        const uint64_t payloadBytesReceived = std::min(numBytesReceived - payloadDataIndex, GetPayloadBlock(bv)->m_dataLength);
+        return FragmentPayloadRange(bv, 0, payloadBytesReceived, fragment);
+    }
+    return false;
+}
+
+
+
+Bpv7FragmentReassembler::Bpv7FragmentReassembler(const uint64_t maxBytesInUse, const std::size_t maxPooledBuffers) :
+    M_MAX_BYTES_IN_USE(maxBytesInUse),
+    M_MAX_POOLED_BUFFERS(maxPooledBuffers),
+    m_numBytesInUse(0) {}
+
+Bpv7FragmentReassembler::~Bpv7FragmentReassembler() {}
+
+bool Bpv7FragmentReassembler::AddFragment(const BundleViewV7 & fragmentBv, bool & isComplete, std::vector<uint8_t> & reassembledBundle) {
+    isComplete = false;
+    const Bpv7CbhePrimaryBlock & primary = fragmentBv.m_primaryBlockView.header;
+    const Bpv7CanonicalBlock * const payloadBlockPtr = GetPayloadBlock(fragmentBv);
+    if ((!IsFragment(primary)) || (payloadBlockPtr == NULL)) {
+        return false;
+    }
+    const uint64_t totalLength = primary.m_totalApplicationDataUnitLength;
+    const uint64_t fragmentOffset = primary.m_fragmentOffset;
+    const uint64_t fragmentLength = payloadBlockPtr->m_dataLength;
+    if ((totalLength == 0) || (fragmentOffset >= totalLength) || (fragmentLength > (totalLength - fragmentOffset))) {
+        return false;
+    }
+
+    const cbhe_bundle_uuid_nofragment_t uuid = primary.GetCbheBundleUuidNoFragmentFromPrimary();
+    pending_bundle_map_t::iterator it = m_mapBundleUuidToPendingBundle.find(uuid);
+    if (it == m_mapBundleUuidToPendingBundle.end()) {
+        if ((m_numBytesInUse + totalLength) > M_MAX_BYTES_IN_USE) {
+            return false;
+        }
+        it = m_mapBundleUuidToPendingBundle.emplace(uuid, pending_bundle_t()).first;
+        pending_bundle_t & pendingBundle = it->second;
+        if (!m_bufferPool.empty()) {
+            pendingBundle.applicationDataUnit.swap(m_bufferPool.front());
+            m_bufferPool.pop_front();
+        }
+        pendingBundle.applicationDataUnit.resize(totalLength);
+        pendingBundle.numBytesInUse = totalLength;
+        m_numBytesInUse += totalLength;
+        //without a clock at the source the lifetime cannot be evaluated, so only the memory cap applies
+        pendingBundle.expirationMilliseconds = (primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 == 0) ?
+            UINT64_MAX : primary.GetExpirationMilliseconds();
+    }
+    else if (it->second.applicationDataUnit.size() != totalLength) {
+        return false;
+    }
+    pending_bundle_t & pendingBundle = it->second;
+
+    if (fragmentLength) {
+        memcpy(&pendingBundle.applicationDataUnit[fragmentOffset], payloadBlockPtr->m_dataPtr, fragmentLength);
+        FragmentSet::InsertFragment(pendingBundle.receivedFragmentSet, FragmentSet::data_fragment_t(fragmentOffset, fragmentOffset + fragmentLength - 1));
+    }
+    if ((fragmentOffset == 0) && pendingBundle.firstFragmentBundle.empty()) {
+        const uint8_t * const bundleData = static_cast<const uint8_t*>(fragmentBv.m_renderedBundle.data());
+        pendingBundle.firstFragmentBundle.assign(bundleData, bundleData + fragmentBv.m_renderedBundle.size());
+        pendingBundle.numBytesInUse += pendingBundle.firstFragmentBundle.size();
+        m_numBytesInUse += pendingBundle.firstFragmentBundle.size();
+    }
+
+    if ((pendingBundle.receivedFragmentSet.size() == 1)
+        && (pendingBundle.receivedFragmentSet.begin()->beginIndex == 0)
+        && (pendingBundle.receivedFragmentSet.begin()->endIndex == (totalLength - 1))
+        && (!pendingBundle.firstFragmentBundle.empty()))
+    {
+        const bool success = RenderWholeBundle(pendingBundle, reassembledBundle);
+        ErasePendingBundle(it);
+        if (!success) {
+            std::cerr << "error in Bpv7FragmentReassembler::AddFragment: unable to render the reassembled bundle\n";
+            return false;
+        }
+        isComplete = true;
+    }
+    return true;
+}
+
+bool Bpv7FragmentReassembler::RenderWholeBundle(pending_bundle_t & pendingBundle, std::vector<uint8_t> & reassembledBundle) {
+    const uint64_t maxBundleSizeBytes = pendingBundle.firstFragmentBundle.size() + pendingBundle.applicationDataUnit.size();
+    BundleViewV7 bv;
+    if (!bv.SwapInAndLoadBundle(pendingBundle.firstFragmentBundle)) {
+        return false;
+    }
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.m_bundleProcessingControlFlags &= ~BPV7_BUNDLEFLAG::ISFRAGMENT;
+    primary.m_fragmentOffset = 0;
+    primary.m_totalApplicationDataUnitLength = 0;
+    bv.m_primaryBlockView.SetManuallyModified();
+
+    BundleViewV7::Bpv7CanonicalBlockView & payloadBlockView = bv.m_listCanonicalBlockView.back();
+    payloadBlockView.headerPtr->m_dataPtr = pendingBundle.applicationDataUnit.data();
+    payloadBlockView.headerPtr->m_dataLength = pendingBundle.applicationDataUnit.size();
+    payloadBlockView.SetManuallyModified();
+    if (!bv.Render(maxBundleSizeBytes)) {
+        return false;
+    }
+    reassembledBundle.swap(bv.m_frontBuffer);
+    return true;
+}
+
+void Bpv7FragmentReassembler::ErasePendingBundle(pending_bundle_map_t::iterator it) {
+    pending_bundle_t & pendingBundle = it->second;
+    m_numBytesInUse -= pendingBundle.numBytesInUse;
+    if (m_bufferPool.size() < M_MAX_POOLED_BUFFERS) {
+        m_bufferPool.emplace_back();
+        m_bufferPool.back().swap(pendingBundle.applicationDataUnit);
+    }
+    m_mapBundleUuidToPendingBundle.erase(it);
+}
+
+std::size_t Bpv7FragmentReassembler::RemoveExpiredBundles(const uint64_t nowMillisecondsSinceEpochRfc5050) {
+    std::size_t numRemoved = 0;
+    for (pending_bundle_map_t::iterator it = m_mapBundleUuidToPendingBundle.begin(); it != m_mapBundleUuidToPendingBundle.end(); ) {
+        if (it->second.expirationMilliseconds <= nowMillisecondsSinceEpochRfc5050) {
+            ErasePendingBundle(it++);
+            ++numRemoved;
+        }
+        else {
+            ++it;
+        }
+    }
+    return numRemoved;
+}
+
+std::size_t Bpv7FragmentReassembler::GetNumPendingBundles() const {
+    return m_mapBundleUuidToPendingBundle.size();
+}
+
+uint64_t Bpv7FragmentReassembler::GetNumBytesInUse() const {
+    return m_numBytesInUse;
+}
+
+void Bpv7FragmentReassembler::Reset() {
+    while (!m_mapBundleUuidToPendingBundle.empty()) {
+        ErasePendingBundle(m_mapBundleUuidToPendingBundle.begin());
+    }
+}
@@ -1,82 +1,167 @@
 #include "codec/CustodyIdAllocator.h"
+#include "FragmentSet.h"
 #include <iostream>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/multiprecision/detail/bitscan.hpp>
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
 
 
 
+static unsigned int PopCount64(const uint64_t value) {
+#ifdef _MSC_VER
+    return static_cast<unsigned int>(__popcnt64(value));
+#else
+    return static_cast<unsigned int>(__builtin_popcountll(value));
+#endif
+}
+
+//mask of bits [lowBit, highBit] within a 64-bit word
+static uint64_t GetBitRangeMask(const unsigned int lowBit, const unsigned int highBit) {
+    const uint64_t highMask = (highBit == 63) ? UINT64_MAX : ((static_cast<uint64_t>(1) << (highBit + 1)) - 1);
+    return highMask & (~((static_cast<uint64_t>(1) << lowBit) - 1));
+}
+
 CustodyIdAllocator::CustodyIdAllocator() : m_myNextCustodyIdAllocationBeginForNextHopCtebToSend(UINT64_MAX) {}
 CustodyIdAllocator::~CustodyIdAllocator() {}
 
+//grow all levels in units of 4096 multipliers (one level 2 word)
+void CustodyIdAllocator::EnsureMultiplierCapacity(const uint64_t multiplier) {
+    if (multiplier < m_numUsedCustodyIdsPerMultiplier.size()) {
+        return;
+    }
+    const uint64_t numMultipliers = ((multiplier >> 12) + 1) << 12;
+    m_usedCustodyIdsBitmap.resize(numMultipliers << 2, 0); //4 words per multiplier
+    m_numUsedCustodyIdsPerMultiplier.resize(numMultipliers, 0);
+    m_usedMultipliersBitmap.resize(numMultipliers >> 6, 0);
+    m_fullUsedMultipliersWordsBitmap.resize(numMultipliers >> 12, 0);
+}
+
+void CustodyIdAllocator::SetMultiplierUsed(const uint64_t multiplier) {
+    EnsureMultiplierCapacity(multiplier);
+    uint64_t & level1Word = m_usedMultipliersBitmap[multiplier >> 6];
+    level1Word |= (static_cast<uint64_t>(1) << (multiplier & 63));
+    if (level1Word == UINT64_MAX) {
+        m_fullUsedMultipliersWordsBitmap[multiplier >> 12] |= (static_cast<uint64_t>(1) << ((multiplier >> 6) & 63));
+    }
+}
+
+//return true if the multiplier was in use and none of its custody ids are used
+bool CustodyIdAllocator::FreeMultiplierIfUnused(const uint64_t multiplier) {
+    const uint64_t level1Bit = static_cast<uint64_t>(1) << (multiplier & 63);
+    uint64_t & level1Word = m_usedMultipliersBitmap[multiplier >> 6];
+    if ((m_numUsedCustodyIdsPerMultiplier[multiplier] != 0) || ((level1Word & level1Bit) == 0)) {
+        return false;
+    }
+    level1Word &= ~level1Bit;
+    m_fullUsedMultipliersWordsBitmap[multiplier >> 12] &= ~(static_cast<uint64_t>(1) << ((multiplier >> 6) & 63));
+    return true;
+}
+
+void CustodyIdAllocator::SetCustodyIdRangeUsed(const uint64_t custodyIdBegin, const uint64_t custodyIdEnd) {
+    EnsureMultiplierCapacity(custodyIdEnd >> 8);
+    const uint64_t wordIndexEnd = custodyIdEnd >> 6;
+    for (uint64_t wordIndex = custodyIdBegin >> 6; wordIndex <= wordIndexEnd; ++wordIndex) {
+        const unsigned int lowBit = (wordIndex == (custodyIdBegin >> 6)) ? static_cast<unsigned int>(custodyIdBegin & 63) : 0;
+        const unsigned int highBit = (wordIndex == wordIndexEnd) ? static_cast<unsigned int>(custodyIdEnd & 63) : 63;
+        const uint64_t mask = GetBitRangeMask(lowBit, highBit);
+        uint64_t & word = m_usedCustodyIdsBitmap[wordIndex];
+        m_numUsedCustodyIdsPerMultiplier[wordIndex >> 2] += static_cast<uint16_t>(PopCount64(mask & (~word)));
+        word |= mask;
+    }
+}
+
+uint64_t CustodyIdAllocator::GetLowestFreeMultiplier() const {
+    for (std::size_t level2Index = 0; level2Index < m_fullUsedMultipliersWordsBitmap.size(); ++level2Index) {
+        const uint64_t notFullLevel1Words = ~m_fullUsedMultipliersWordsBitmap[level2Index];
+        if (notFullLevel1Words) {
+            const uint64_t level1Index = (level2Index << 6) + boost::multiprecision::detail::find_lsb<uint64_t>(notFullLevel1Words);
+            return (level1Index << 6) + boost::multiprecision::detail::find_lsb<uint64_t>(~m_usedMultipliersBitmap[level1Index]);
+        }
+    }
+    return m_numUsedCustodyIdsPerMultiplier.size(); //all full (or empty), next multiplier is just past the capacity
+}
+
 void CustodyIdAllocator::InitializeAddUsedCustodyId(const uint64_t custodyId) {
-    const uint64_t multiplier = custodyId >> 8; //custodyId / 256
-    FragmentSet::InsertFragment(m_usedCustodyIdMultipliers, FragmentSet::data_fragment_t(multiplier, multiplier));
-    FragmentSet::InsertFragment(m_usedCustodyIds, FragmentSet::data_fragment_t (custodyId, custodyId));
+    SetMultiplierUsed(custodyId >> 8); //custodyId / 256
+    SetCustodyIdRangeUsed(custodyId, custodyId);
 }
 void CustodyIdAllocator::InitializeAddUsedCustodyIdRange(const uint64_t custodyIdBegin, const uint64_t custodyIdEnd) {
     const uint64_t multiplierBegin = custodyIdBegin >> 8; //custodyIdBegin / 256
     const uint64_t multiplierEnd = custodyIdEnd >> 8; //custodyIdEnd / 256
-    FragmentSet::InsertFragment(m_usedCustodyIdMultipliers, FragmentSet::data_fragment_t(multiplierBegin, multiplierEnd));
-    FragmentSet::InsertFragment(m_usedCustodyIds, FragmentSet::data_fragment_t(custodyIdBegin, custodyIdEnd));
+    for (uint64_t multiplier = multiplierBegin; multiplier <= multiplierEnd; ++multiplier) {
+        SetMultiplierUsed(multiplier);
+    }
+    SetCustodyIdRangeUsed(custodyIdBegin, custodyIdEnd);
 }
 //return number of multipliers freed
 uint64_t CustodyIdAllocator::FreeCustodyId(const uint64_t custodyId) {
-    FragmentSet::RemoveFragment(m_usedCustodyIds, FragmentSet::data_fragment_t(custodyId, custodyId));
     const uint64_t multiplier = custodyId >> 8; //custodyId / 256
-    const uint64_t blockBase = multiplier << 8; //multiplier * 256
-    const FragmentSet::data_fragment_t blockOfCustodyIds(blockBase, blockBase + 255);
-    if (FragmentSet::DoesNotContainFragmentEntirely(m_usedCustodyIds, blockOfCustodyIds)) {
-        //blockOfCustodyIds not contained/set inside of m_usedCustodyIdMultipliers (may still abut)
-        const FragmentSet::data_fragment_t multiplierToRemove(multiplier, multiplier);
-        if (FragmentSet::ContainsFragmentEntirely(m_usedCustodyIdMultipliers, multiplierToRemove)) {
-            FragmentSet::RemoveFragment(m_usedCustodyIdMultipliers, multiplierToRemove);
-            return 1;
-        }
+    if (multiplier >= m_numUsedCustodyIdsPerMultiplier.size()) {
+        return 0;
+    }
+    const uint64_t bit = static_cast<uint64_t>(1) << (custodyId & 63);
+    uint64_t & word = m_usedCustodyIdsBitmap[custodyId >> 6];
+    if (word & bit) {
+        word &= ~bit;
+        --m_numUsedCustodyIdsPerMultiplier[multiplier];
     }
-    return 0;
+    return (FreeMultiplierIfUnused(multiplier)) ? 1 : 0;
 }
 //return number of multipliers freed
 uint64_t CustodyIdAllocator::FreeCustodyIdRange(const uint64_t custodyIdBegin, const uint64_t custodyIdEnd) {
-    FragmentSet::RemoveFragment(m_usedCustodyIds, FragmentSet::data_fragment_t(custodyIdBegin, custodyIdEnd));
+    const uint64_t capacity = static_cast<uint64_t>(m_numUsedCustodyIdsPerMultiplier.size()) << 8;
+    if ((custodyIdBegin >= capacity) || (custodyIdBegin > custodyIdEnd)) {
+        return 0;
+    }
+    const uint64_t lastCustodyId = (custodyIdEnd >= capacity) ? (capacity - 1) : custodyIdEnd;
+    const uint64_t wordIndexEnd = lastCustodyId >> 6;
+    for (uint64_t wordIndex = custodyIdBegin >> 6; wordIndex <= wordIndexEnd; ++wordIndex) {
+        const unsigned int lowBit = (wordIndex == (custodyIdBegin >> 6)) ? static_cast<unsigned int>(custodyIdBegin & 63) : 0;
+        const unsigned int highBit = (wordIndex == wordIndexEnd) ? static_cast<unsigned int>(lastCustodyId & 63) : 63;
+        uint64_t & word = m_usedCustodyIdsBitmap[wordIndex];
+        const uint64_t bitsToClear = word & GetBitRangeMask(lowBit, highBit);
+        m_numUsedCustodyIdsPerMultiplier[wordIndex >> 2] -= static_cast<uint16_t>(PopCount64(bitsToClear));
+        word &= ~bitsToClear;
+    }
     const uint64_t multiplierBegin = custodyIdBegin >> 8; //custodyIdBegin / 256
-    const uint64_t multiplierEnd = custodyIdEnd >> 8; //custodyIdEnd / 256
+    const uint64_t multiplierEnd = lastCustodyId >> 8; //lastCustodyId / 256
     uint64_t numMultipliersRemoved = 0;
     for (uint64_t multiplier = multiplierBegin; multiplier <= multiplierEnd; ++multiplier) {
-        const uint64_t blockBase = multiplier << 8; //multiplier * 256
-        const FragmentSet::data_fragment_t blockOfCustodyIds(blockBase, blockBase + 255);
-        if (FragmentSet::DoesNotContainFragmentEntirely(m_usedCustodyIds, blockOfCustodyIds)) {
-            //blockOfCustodyIds not contained/set inside of m_usedCustodyIdMultipliers (may still abut)
-            const FragmentSet::data_fragment_t multiplierToRemove(multiplier, multiplier);
-            if (FragmentSet::ContainsFragmentEntirely(m_usedCustodyIdMultipliers, multiplierToRemove)) {
-                FragmentSet::RemoveFragment(m_usedCustodyIdMultipliers, multiplierToRemove);
-                ++numMultipliersRemoved;
-            }
-        }
+        numMultipliersRemoved += FreeMultiplierIfUnused(multiplier);
     }
     return numMultipliersRemoved;
+}
 
+bool CustodyIdAllocator::IsCustodyIdUsed(const uint64_t custodyId) const {
+    const uint64_t wordIndex = custodyId >> 6;
+    return (wordIndex < m_usedCustodyIdsBitmap.size()) && ((m_usedCustodyIdsBitmap[wordIndex] >> (custodyId & 63)) & 1);
 }
 
 
 //sets m_myNextCustodyIdAllocationBeginForNextHopCtebToSend
 void CustodyIdAllocator::ReserveNextCustodyIdBlock() {
-    uint64_t multiplier;
-    if (m_usedCustodyIdMultipliers.empty()) { //if empty start at 0
-        multiplier = 0;
-    }
-    else { //pick the lowest value from begin() iterator
-        const FragmentSet::data_fragment_t & multFrag = *(m_usedCustodyIdMultipliers.cbegin());
-        multiplier = (multFrag.beginIndex != 0) ? 0 : (multFrag.endIndex + 1);
-    }
-    
+    const uint64_t multiplier = GetLowestFreeMultiplier();
 
-    //use selected multiplier to update the sets
-    FragmentSet::InsertFragment(m_usedCustodyIdMultipliers, FragmentSet::data_fragment_t(multiplier, multiplier));
+    //use selected multiplier to update the bitmaps (a free multiplier has no used custody ids)
+    SetMultiplierUsed(multiplier);
     const uint64_t blockBase = multiplier << 8; //multiplier * 256
-    const FragmentSet::data_fragment_t blockOfCustodyIds(blockBase, blockBase + 255);
-    FragmentSet::InsertFragment(m_usedCustodyIds, blockOfCustodyIds);
+    uint64_t * const blockWords = &m_usedCustodyIdsBitmap[multiplier << 2];
+    blockWords[0] = UINT64_MAX;
+    blockWords[1] = UINT64_MAX;
+    blockWords[2] = UINT64_MAX;
+    blockWords[3] = UINT64_MAX;
+    m_numUsedCustodyIdsPerMultiplier[multiplier] = 256;
     m_myNextCustodyIdAllocationBeginForNextHopCtebToSend = blockBase;
 }
 void CustodyIdAllocator::Reset() {
-
+    m_myNextCustodyIdAllocationBeginForNextHopCtebToSend = UINT64_MAX;
+    m_mapBundleSrcEidToNextCtebCustodyId.clear();
+    m_usedCustodyIdsBitmap.clear();
+    m_numUsedCustodyIdsPerMultiplier.clear();
+    m_usedMultipliersBitmap.clear();
+    m_fullUsedMultipliersWordsBitmap.clear();
 }
 
 //bundle sources should have as much contiguous custody ids as possible
@@ -86,7 +171,7 @@ uint64_t CustodyIdAllocator::GetNextCustodyIdForNextHopCtebToSend(const cbhe_eid
     if (m_myNextCustodyIdAllocationBeginForNextHopCtebToSend == UINT64_MAX) {
         ReserveNextCustodyIdBlock(); //set m_myNextCustodyIdAllocationBeginForNextHopCtebToSend
     }
-    std::pair<std::map<cbhe_eid_t, uint64_t>::iterator, bool> res = m_mapBundleSrcEidToNextCtebCustodyId.insert(
+    std::pair<std::unordered_map<cbhe_eid_t, uint64_t, hash_cbhe_eid_t>::iterator, bool> res = m_mapBundleSrcEidToNextCtebCustodyId.insert(
         std::pair<cbhe_eid_t, uint64_t>(bundleSrcEid, m_myNextCustodyIdAllocationBeginForNextHopCtebToSend + 1)); //+1 because it's the next
     if (res.second == true) { //insertion due to first bundleSrcEid
         const uint64_t retVal = m_myNextCustodyIdAllocationBeginForNextHopCtebToSend;
@@ -105,9 +190,18 @@ uint64_t CustodyIdAllocator::GetNextCustodyIdForNextHopCtebToSend(const cbhe_eid
     }
 }
 
+void CustodyIdAllocator::PrintBitmapAsFragments(const std::vector<uint64_t> & bitmap) {
+    std::set<FragmentSet::data_fragment_t> fragmentSet;
+    for (uint64_t i = 0; i < (static_cast<uint64_t>(bitmap.size()) << 6); ++i) {
+        if ((bitmap[i >> 6] >> (i & 63)) & 1) {
+            FragmentSet::InsertFragment(fragmentSet, FragmentSet::data_fragment_t(i, i));
+        }
+    }
+    FragmentSet::PrintFragmentSet(fragmentSet);
+}
 void CustodyIdAllocator::PrintUsedCustodyIds() {
-    FragmentSet::PrintFragmentSet(m_usedCustodyIds);
+    PrintBitmapAsFragments(m_usedCustodyIdsBitmap);
 }
 void CustodyIdAllocator::PrintUsedCustodyIdMultipliers() {
-    FragmentSet::PrintFragmentSet(m_usedCustodyIdMultipliers);
+    PrintBitmapAsFragments(m_usedMultipliersBitmap);
 }
@@ -1,8 +1,11 @@
 #include "codec/CustodyTransferManager.h"
 #include <iostream>
+#include <cstring>
+#include <iterator>
 #include "TimestampUtil.h"
 #include "Uri.h"
 #include <boost/make_unique.hpp>
+#include "Sdnv.h"
 
 static const bool INDEX_TO_IS_SUCCESS[NUM_ACS_STATUS_INDICES] = {
     true,
@@ -75,16 +78,17 @@ bool CustodyTransferManager::GenerateCustodySignalBundle(BundleViewV6 & newRende
 bool CustodyTransferManager::GenerateAllAcsBundlesAndClear(std::list<BundleViewV6> & newAcsRenderedBundleViewList) {
     newAcsRenderedBundleViewList.clear();
     m_largestNumberOfFills = 0;
-    for (std::map<cbhe_eid_t, acs_array_t>::iterator it = m_mapCustodianToAcsArray.begin(); it != m_mapCustodianToAcsArray.end(); ++it) {
+    for (std::map<cbhe_eid_t, acs_builder_array_t>::iterator it = m_mapCustodianToAcsBuilders.begin(); it != m_mapCustodianToAcsBuilders.end(); ++it) {
         const cbhe_eid_t & custodianEid = it->first;
-        acs_array_t & acsArray = it->second;
+        acs_builder_array_t & acsBuilders = it->second;
         for (unsigned int statusReasonIndex = 0; statusReasonIndex < NUM_ACS_STATUS_INDICES; ++statusReasonIndex) {
-            Bpv6AdministrativeRecordContentAggregateCustodySignal & currentAcsToMove = acsArray[statusReasonIndex];
-            if (!currentAcsToMove.m_custodyIdFills.empty()) {
+            AcsFillsBuilder & currentAcsBuilder = acsBuilders[statusReasonIndex];
+            if (!currentAcsBuilder.IsEmpty()) {
                 newAcsRenderedBundleViewList.emplace_back();
                 BundleViewV6 & bv = newAcsRenderedBundleViewList.back();
-                if (GenerateAcsBundle(bv, custodianEid, currentAcsToMove)) {
-                    currentAcsToMove.Reset();
+                Bpv6AdministrativeRecordContentAggregateCustodySignal acsToMove(currentAcsBuilder.GetAcs());
+                if (GenerateAcsBundle(bv, custodianEid, acsToMove)) {
+                    ResetAcs(currentAcsBuilder);
                 }
                 else { //failure
                     return false;
@@ -92,6 +96,7 @@ bool CustodyTransferManager::GenerateAllAcsBundlesAndClear(std::list<BundleViewV
             }
         }
     }
+    m_oldestAcsFirstFillTime = boost::posix_time::pos_infin;
     return true;
 }
 uint64_t CustodyTransferManager::GetLargestNumberOfFills() const {
@@ -102,6 +107,7 @@ bool CustodyTransferManager::GenerateAcsBundle(BundleViewV6 & newAcsRenderedBund
     if (acsToMove.m_custodyIdFills.empty()) {
         return false;
     }
+    const uint64_t adminRecordSerializationSize = 1 + acsToMove.GetSerializationSize(); //1 => admin record type
     Bpv6CbhePrimaryBlock & newPrimary = newAcsRenderedBundleView.m_primaryBlockView.header;
     newPrimary.SetZero();
 
@@ -130,23 +136,168 @@ bool CustodyTransferManager::GenerateAcsBundle(BundleViewV6 & newAcsRenderedBund
         }
         newAcsRenderedBundleView.AppendMoveCanonicalBlock(blockPtr);
     }
-    if (!newAcsRenderedBundleView.Render(CBHE_BPV6_MINIMUM_SAFE_PRIMARY_HEADER_ENCODE_SIZE + 2000)) { //todo size
+    if (!newAcsRenderedBundleView.Render(CBHE_BPV6_MINIMUM_SAFE_PRIMARY_PLUS_CANONICAL_HEADER_ENCODE_SIZE + adminRecordSerializationSize)) {
         return false;
     }
     return true;
 }
 bool CustodyTransferManager::GenerateAcsBundle(BundleViewV6 & newAcsRenderedBundleView, const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex, const bool copyAcsOnly) {
     //const cbhe_eid_t custodianEidFromPrimary(primaryFromSender.custodian_node, primaryFromSender.custodian_svc);
-    std::map<cbhe_eid_t, acs_array_t>::iterator it = m_mapCustodianToAcsArray.find(custodianEid);
-    if (it == m_mapCustodianToAcsArray.end()) {
+    std::map<cbhe_eid_t, acs_builder_array_t>::iterator it = m_mapCustodianToAcsBuilders.find(custodianEid);
+    if (it == m_mapCustodianToAcsBuilders.end()) {
         return false;
     }
-    acs_array_t & acsArray = it->second;
-    Bpv6AdministrativeRecordContentAggregateCustodySignal & currentAcs = acsArray[static_cast<uint8_t>(statusReasonIndex)];
-    return GenerateAcsBundle(newAcsRenderedBundleView, custodianEid, currentAcs, copyAcsOnly);
+    AcsFillsBuilder & currentAcsBuilder = it->second[static_cast<uint8_t>(statusReasonIndex)];
+    Bpv6AdministrativeRecordContentAggregateCustodySignal acsToMove(currentAcsBuilder.GetAcs());
+    if (!GenerateAcsBundle(newAcsRenderedBundleView, custodianEid, acsToMove)) {
+        return false;
+    }
+    if (!copyAcsOnly) {
+        ResetAcs(currentAcsBuilder);
+    }
+    return true;
+}
+
+AcsFillsBuilder::AcsFillsBuilder() :
+    m_firstFillTime(boost::posix_time::pos_infin),
+    m_isFull(false),
+    m_rightEdgeOfLastClosedFill(0),
+    m_pendingFillBeginIndex(0),
+    m_pendingFillEndIndex(0),
+    m_numFills(0),
+    m_statusFlagsPlus7bitReasonCode(0) {}
+
+void AcsFillsBuilder::Reserve(const uint64_t numBytesEncodedFills) {
+    m_encodedClosedFills.reserve(numBytesEncodedFills + 20); //+20 => room for the two sdnvs of one more fill
+}
+
+void AcsFillsBuilder::SetCustodyTransferStatusAndReason(bool custodyTransferSucceeded, BPV6_CUSTODY_SIGNAL_REASON_CODES_7BIT reasonCode7bit) {
+    m_acs.SetCustodyTransferStatusAndReason(custodyTransferSucceeded, reasonCode7bit);
+    m_statusFlagsPlus7bitReasonCode = (static_cast<uint8_t>(reasonCode7bit)) | ((static_cast<uint8_t>(custodyTransferSucceeded)) << 7);
+}
+
+void AcsFillsBuilder::AppendEncodedFill(const uint64_t beginIndex, const uint64_t endIndex) {
+    const std::size_t oldSize = m_encodedClosedFills.size();
+    m_encodedClosedFills.resize(oldSize + 20);
+    uint8_t * const serializationBase = &m_encodedClosedFills[oldSize];
+    uint8_t * serialization = serializationBase;
+    serialization += SdnvEncodeU64BufSize10(serialization, beginIndex - m_rightEdgeOfLastClosedFill);
+    serialization += SdnvEncodeU64BufSize10(serialization, (endIndex + 1) - beginIndex);
+    m_encodedClosedFills.resize(oldSize + (serialization - serializationBase));
+    m_rightEdgeOfLastClosedFill = endIndex;
+}
+
+//return number of fills
+uint64_t AcsFillsBuilder::AddCustodyIdToFill(const uint64_t custodyId) {
+    if (m_numFills == 0) { //first custody id
+        m_pendingFillBeginIndex = custodyId;
+        m_pendingFillEndIndex = custodyId;
+        m_numFills = 1;
+    }
+    else if (custodyId == (m_pendingFillEndIndex + 1)) { //the common case
+        m_pendingFillEndIndex = custodyId;
+    }
+    else if (custodyId > m_pendingFillEndIndex) { //gap => close the pending fill and start a new one
+        AppendEncodedFill(m_pendingFillBeginIndex, m_pendingFillEndIndex);
+        m_pendingFillBeginIndex = custodyId;
+        m_pendingFillEndIndex = custodyId;
+        ++m_numFills;
+    }
+    else if (custodyId < m_pendingFillBeginIndex) { //out of order, merged when the acs is finished
+        FragmentSet::InsertFragment(m_outOfOrderFills, FragmentSet::data_fragment_t(custodyId, custodyId));
+    }
+    //else duplicate of a custody id within the pending fill
+    return GetNumFills();
+}
+
+uint64_t AcsFillsBuilder::GetNumFills() const {
+    return m_numFills + m_outOfOrderFills.size(); //an upper bound if there are any out of order custody ids
+}
+
+bool AcsFillsBuilder::IsEmpty() const {
+    return (m_numFills == 0);
+}
+
+uint64_t AcsFillsBuilder::GetContentSerializationSize() const {
+    if (m_numFills == 0) {
+        return 1;
+    }
+    return 1 + m_encodedClosedFills.size() //1 => m_statusFlagsPlus7bitReasonCode
+        + SdnvGetNumBytesRequiredToEncode(m_pendingFillBeginIndex - m_rightEdgeOfLastClosedFill)
+        + SdnvGetNumBytesRequiredToEncode((m_pendingFillEndIndex + 1) - m_pendingFillBeginIndex)
+        + (m_outOfOrderFills.size() * 20);
+}
+
+void AcsFillsBuilder::DecodeAllFills() {
+    uint64_t numBytesTakenToDecode;
+    if (m_encodedClosedFills.empty() || (!m_acs.DeserializeFills(m_encodedClosedFills.data(), numBytesTakenToDecode, m_encodedClosedFills.size()))) {
+        m_acs.m_custodyIdFills.clear();
+    }
+    if (m_numFills) {
+        m_acs.AddContiguousCustodyIdsToFill(m_pendingFillBeginIndex, m_pendingFillEndIndex);
+    }
+    for (std::set<FragmentSet::data_fragment_t>::const_iterator it = m_outOfOrderFills.cbegin(); it != m_outOfOrderFills.cend(); ++it) {
+        m_acs.AddContiguousCustodyIdsToFill(it->beginIndex, it->endIndex);
+    }
+}
+
+const Bpv6AdministrativeRecordContentAggregateCustodySignal & AcsFillsBuilder::GetAcs() {
+    DecodeAllFills();
+    return m_acs;
+}
+
+void AcsFillsBuilder::MergeOutOfOrderFills() {
+    if (m_outOfOrderFills.empty()) {
+        return;
+    }
+    DecodeAllFills();
+    m_outOfOrderFills.clear();
+    m_encodedClosedFills.resize(0);
+    m_rightEdgeOfLastClosedFill = 0;
+    m_numFills = m_acs.m_custodyIdFills.size();
+    std::set<FragmentSet::data_fragment_t>::const_iterator itLast = std::prev(m_acs.m_custodyIdFills.cend());
+    for (std::set<FragmentSet::data_fragment_t>::const_iterator it = m_acs.m_custodyIdFills.cbegin(); it != itLast; ++it) {
+        AppendEncodedFill(it->beginIndex, it->endIndex);
+    }
+    m_pendingFillBeginIndex = itLast->beginIndex;
+    m_pendingFillEndIndex = itLast->endIndex;
+}
+
+uint64_t AcsFillsBuilder::SerializeContent(uint8_t * serialization, uint64_t bufferSize) {
+    MergeOutOfOrderFills();
+    const uint8_t * const serializationBase = serialization;
+    if ((m_numFills == 0) || (bufferSize < (1 + m_encodedClosedFills.size()))) {
+        return 0;
+    }
+    *serialization++ = m_statusFlagsPlus7bitReasonCode;
+    memcpy(serialization, m_encodedClosedFills.data(), m_encodedClosedFills.size());
+    serialization += m_encodedClosedFills.size();
+    bufferSize -= (1 + m_encodedClosedFills.size());
+
+    uint64_t thisSerializationSize = SdnvEncodeU64(serialization, m_pendingFillBeginIndex - m_rightEdgeOfLastClosedFill, bufferSize);
+    if (thisSerializationSize == 0) {
+        return 0;
+    }
+    serialization += thisSerializationSize;
+    bufferSize -= thisSerializationSize;
+    thisSerializationSize = SdnvEncodeU64(serialization, (m_pendingFillEndIndex + 1) - m_pendingFillBeginIndex, bufferSize);
+    if (thisSerializationSize == 0) {
+        return 0;
+    }
+    serialization += thisSerializationSize;
+    return serialization - serializationBase;
 }
 
-acs_array_t::acs_array_t() {
+void AcsFillsBuilder::Reset() {
+    m_firstFillTime = boost::posix_time::pos_infin;
+    m_isFull = false;
+    m_encodedClosedFills.resize(0); //keep capacity
+    m_rightEdgeOfLastClosedFill = 0;
+    m_numFills = 0;
+    m_outOfOrderFills.clear();
+}
+
+acs_builder_array_t::acs_builder_array_t() {
     at(static_cast<uint8_t>(BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION)).SetCustodyTransferStatusAndReason(
         true, BPV6_CUSTODY_SIGNAL_REASON_CODES_7BIT::NO_ADDITIONAL_INFORMATION);
     at(static_cast<uint8_t>(BPV6_ACS_STATUS_REASON_INDICES::FAIL__REDUNDANT_RECEPTION)).SetCustodyTransferStatusAndReason(
@@ -170,7 +321,12 @@ CustodyTransferManager::CustodyTransferManager(const bool isAcsAware, const uint
     m_myCtebCreatorCustodianEidString(Uri::GetIpnUriString(m_myCustodianNodeId, m_myCustodianServiceId)),
     m_lastCreation(0),
     m_sequence(0),
-    m_largestNumberOfFills(0)
+    m_largestNumberOfFills(0),
+    m_maxFillsPerAcs(100),
+    m_maxAcsContentBytes(1000),
+    m_maxAcsAge(boost::posix_time::seconds(1)),
+    m_numFullAcs(0),
+    m_oldestAcsFirstFillTime(boost::posix_time::pos_infin)
 {
  
 }
@@ -246,8 +402,7 @@ bool CustodyTransferManager::ProcessCustodyOfBundle(BundleViewV6 & bv, bool acce
                 //      signal, the associated timer and pending ACS Succeeded.
 
                 //aggregate succeeded status
-                acs_array_t & acsArray = m_mapCustodianToAcsArray[custodianEidFromPrimary];
-                m_largestNumberOfFills = std::max(acsArray[static_cast<uint8_t>(BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION)].AddCustodyIdToFill(receivedCtebCustodyId), m_largestNumberOfFills);
+                AddCustodyIdToAcs(custodianEidFromPrimary, BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION, receivedCtebCustodyId);
             }
             else { //invalid cteb
                 //acs capable ba, ba accepts custody, invalid cteb => generate succeeded and follow 5.10
@@ -307,8 +462,7 @@ bool CustodyTransferManager::ProcessCustodyOfBundle(BundleViewV6 & bv, bool acce
                 //  signal, the associated timer and pending ACS Failed.
 
                 //aggregate failed status
-                acs_array_t & acsArray = m_mapCustodianToAcsArray[custodianEidFromPrimary];
-                m_largestNumberOfFills = std::max(acsArray[static_cast<uint8_t>(statusReasonIndex)].AddCustodyIdToFill(receivedCtebCustodyId), m_largestNumberOfFills);
+                AddCustodyIdToAcs(custodianEidFromPrimary, statusReasonIndex, receivedCtebCustodyId);
             }
             else { //invalid cteb
                 //acs capable ba, ba refuses custody, invalid cteb => generate failed and follow 5.10
@@ -357,5 +511,121 @@ bool CustodyTransferManager::ProcessCustodyOfBundle(BundleViewV6 & bv, bool acce
 }
 
 const Bpv6AdministrativeRecordContentAggregateCustodySignal & CustodyTransferManager::GetAcsConstRef(const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex) {
-    return m_mapCustodianToAcsArray[custodianEid][static_cast<uint8_t>(statusReasonIndex)];
+    return GetAcsBuilders(custodianEid)[static_cast<uint8_t>(statusReasonIndex)].GetAcs();
+}
+
+acs_builder_array_t & CustodyTransferManager::GetAcsBuilders(const cbhe_eid_t & custodianEid) {
+    std::map<cbhe_eid_t, acs_builder_array_t>::iterator it = m_mapCustodianToAcsBuilders.find(custodianEid);
+    if (it == m_mapCustodianToAcsBuilders.end()) {
+        it = m_mapCustodianToAcsBuilders.emplace(custodianEid, acs_builder_array_t()).first;
+        for (unsigned int statusReasonIndex = 0; statusReasonIndex < NUM_ACS_STATUS_INDICES; ++statusReasonIndex) {
+            it->second[statusReasonIndex].Reserve(m_maxAcsContentBytes);
+        }
+    }
+    return it->second;
+}
+
+void CustodyTransferManager::AddCustodyIdToAcs(const cbhe_eid_t & custodianEid, const BPV6_ACS_STATUS_REASON_INDICES statusReasonIndex, const uint64_t custodyId) {
+    AcsFillsBuilder & acsBuilder = GetAcsBuilders(custodianEid)[static_cast<uint8_t>(statusReasonIndex)];
+    if (acsBuilder.IsEmpty()) {
+        acsBuilder.m_firstFillTime = boost::posix_time::microsec_clock::universal_time();
+        if (acsBuilder.m_firstFillTime < m_oldestAcsFirstFillTime) {
+            m_oldestAcsFirstFillTime = acsBuilder.m_firstFillTime;
+        }
+    }
+    const uint64_t numFills = acsBuilder.AddCustodyIdToFill(custodyId);
+    m_largestNumberOfFills = std::max(numFills, m_largestNumberOfFills);
+    if ((!acsBuilder.m_isFull) && ((numFills >= m_maxFillsPerAcs) || (acsBuilder.GetContentSerializationSize() >= m_maxAcsContentBytes))) {
+        acsBuilder.m_isFull = true;
+        ++m_numFullAcs;
+    }
+}
+
+void CustodyTransferManager::ResetAcs(AcsFillsBuilder & acsFillsBuilder) {
+    if (acsFillsBuilder.m_isFull) {
+        --m_numFullAcs;
+    }
+    acsFillsBuilder.Reset();
+}
+
+void CustodyTransferManager::SetAcsFlushThresholds(const uint64_t maxFillsPerAcs, const uint64_t maxAcsContentBytes, const boost::posix_time::time_duration & maxAcsAge) {
+    m_maxFillsPerAcs = maxFillsPerAcs;
+    m_maxAcsContentBytes = maxAcsContentBytes;
+    m_maxAcsAge = maxAcsAge;
+}
+
+bool CustodyTransferManager::HasFullAcs() const {
+    return (m_numFullAcs != 0);
+}
+
+bool CustodyTransferManager::IsAcsReadyToSend(const boost::posix_time::ptime & nowPtime) const {
+    return (m_numFullAcs != 0) || ((!m_oldestAcsFirstFillTime.is_pos_infinity()) && ((m_oldestAcsFirstFillTime + m_maxAcsAge) <= nowPtime));
+}
+
+bool CustodyTransferManager::GenerateReadyAcsBundles(std::list<serialized_acs_bundle_t> & newAcsBundleList, const boost::posix_time::ptime & nowPtime, const bool sendAll) {
+    newAcsBundleList.clear();
+    bool success = true;
+    m_largestNumberOfFills = 0;
+    m_numFullAcs = 0;
+    m_oldestAcsFirstFillTime = boost::posix_time::pos_infin;
+    for (std::map<cbhe_eid_t, acs_builder_array_t>::iterator it = m_mapCustodianToAcsBuilders.begin(); it != m_mapCustodianToAcsBuilders.end(); ++it) {
+        const cbhe_eid_t & custodianEid = it->first;
+        acs_builder_array_t & acsBuilders = it->second;
+        for (unsigned int statusReasonIndex = 0; statusReasonIndex < NUM_ACS_STATUS_INDICES; ++statusReasonIndex) {
+            AcsFillsBuilder & acsBuilder = acsBuilders[statusReasonIndex];
+            if (acsBuilder.IsEmpty()) {
+                continue;
+            }
+            if (sendAll || acsBuilder.m_isFull || ((acsBuilder.m_firstFillTime + m_maxAcsAge) <= nowPtime)) {
+                newAcsBundleList.emplace_back();
+                if (SerializeAcsBundle(newAcsBundleList.back(), custodianEid, acsBuilder)) {
+                    acsBuilder.Reset();
+                    continue;
+                }
+                newAcsBundleList.pop_back();
+                success = false; //keep the acs (try again next time)
+            }
+            //not ready, recompute the bookkeeping of the acs that remain
+            m_largestNumberOfFills = std::max(acsBuilder.GetNumFills(), m_largestNumberOfFills);
+            if (acsBuilder.m_isFull) {
+                ++m_numFullAcs;
+            }
+            if (acsBuilder.m_firstFillTime < m_oldestAcsFirstFillTime) {
+                m_oldestAcsFirstFillTime = acsBuilder.m_firstFillTime;
+            }
+        }
+    }
+    return success;
+}
+
+bool CustodyTransferManager::SerializeAcsBundle(serialized_acs_bundle_t & acsBundle, const cbhe_eid_t & custodianEid, AcsFillsBuilder & acsFillsBuilder) {
+    Bpv6CbhePrimaryBlock & primary = acsBundle.m_primary;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT | BPV6_BUNDLEFLAG::ADMINRECORD);
+    primary.m_sourceNodeId.Set(m_myCustodianNodeId, m_myCustodianServiceId);
+    primary.m_destinationEid = custodianEid;
+    SetCreationAndSequence(primary.m_creationTimestamp.secondsSinceStartOfYear2000, primary.m_creationTimestamp.sequenceNumber);
+    primary.m_lifetimeSeconds = 1000; //todo
+
+    acsFillsBuilder.MergeOutOfOrderFills(); //content size now exact
+    const uint64_t contentSize = acsFillsBuilder.GetContentSerializationSize();
+
+    Bpv6CanonicalBlock payloadBlock;
+    payloadBlock.SetZero();
+    payloadBlock.m_blockTypeCode = BPV6_BLOCK_TYPE_CODE::PAYLOAD;
+    payloadBlock.m_blockProcessingControlFlags = BPV6_BLOCKFLAG::IS_LAST_BLOCK;
+    payloadBlock.m_blockTypeSpecificDataLength = 1 + contentSize; //1 => admin record type
+    payloadBlock.m_blockTypeSpecificDataPtr = NULL; //NULL => SerializeBpv6 will point it to the (uncopied) payload within the bundle
+
+    std::vector<uint8_t> & bundleSerialized = acsBundle.m_bundleSerialized;
+    bundleSerialized.resize(CBHE_BPV6_MINIMUM_SAFE_PRIMARY_PLUS_CANONICAL_HEADER_ENCODE_SIZE + payloadBlock.m_blockTypeSpecificDataLength);
+    uint64_t bundleSize = primary.SerializeBpv6(bundleSerialized.data());
+    bundleSize += payloadBlock.SerializeBpv6(&bundleSerialized[bundleSize]);
+    uint8_t * adminRecordSerialization = payloadBlock.m_blockTypeSpecificDataPtr;
+    *adminRecordSerialization++ = (static_cast<uint8_t>(BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::AGGREGATE_CUSTODY_SIGNAL)) << 4; //not a fragment
+    if (acsFillsBuilder.SerializeContent(adminRecordSerialization, contentSize) != contentSize) {
+        return false;
+    }
+    bundleSerialized.resize(bundleSize);
+    return true;
 }
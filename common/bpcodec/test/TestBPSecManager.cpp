@@ -0,0 +1,309 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/timer/timer.hpp>
+#include "codec/BPSecManager.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/make_unique.hpp>
+#include "BinaryConversions.h"
+#include "PaddedVectorUint8.h"
+#include <boost/algorithm/string.hpp>
+
+static const BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS BIB_FULL_SCOPE =
+    BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK
+    | BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_TARGET_HEADER
+    | BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::INCLUDE_SECURITY_HEADER;
+static const BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS BCB_FULL_SCOPE =
+    BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_PRIMARY_BLOCK
+    | BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_TARGET_HEADER
+    | BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::INCLUDE_SECURITY_HEADER;
+
+//RFC 9173 Appendix A sample bundle: primary block and the payload "Ready Generate a 32 byte payload"
+static void GenerateRfc9173SampleBundle(BundleViewV7 & bv, const std::string & payloadString) {
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.SetZero();
+    primary.m_destinationEid.Set(1, 2);
+    primary.m_sourceNodeId.Set(2, 1);
+    primary.m_reportToEid.Set(2, 1);
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = 0;
+    primary.m_creationTimestamp.sequenceNumber = 40;
+    primary.m_lifetimeMilliseconds = 1000000;
+    bv.m_primaryBlockView.SetManuallyModified();
+
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+    Bpv7CanonicalBlock & block = *blockPtr;
+    block.m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+    block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+    block.m_blockNumber = 1;
+    block.m_crcType = BPV7_CRC_TYPE::NONE;
+    block.m_dataLength = payloadString.size();
+    block.m_dataPtr = (uint8_t*)payloadString.data(); //payloadString must remain in scope until after render
+    bv.AppendMoveCanonicalBlock(blockPtr);
+    BOOST_REQUIRE(bv.Render(payloadString.size() + 500));
+}
+
+static std::string GetPayloadString(BundleViewV7 & bv) {
+    std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+    bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+    BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+    const char * strPtr = (const char *)blocks[0]->headerPtr->m_dataPtr;
+    return std::string(strPtr, strPtr + blocks[0]->headerPtr->m_dataLength);
+}
+
+BOOST_AUTO_TEST_CASE(TestBPSecManagerSimpleIntegrityTestCase)
+{
+    //RFC 9173 A.1 Example 1
+    static const std::string payloadString("Ready Generate a 32 byte payload");
+    std::vector<uint8_t> hmacKey;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("1a2b1a2b1a2b1a2b1a2b1a2b1a2b1a2b", hmacKey));
+    static const std::string expectedSerializedBundleString(
+        "9f88070000820282010282028202018202820201820018281a000f4240850b020000585581010"
+        "10182028202018282010782030081820158400654d65992803252210e377d66d0a8dc"
+        "18a1e8a392269125ae9ac198a9a598be4b83d5daa8be2f2d16769ec1c30cfc348e220"
+        "5fba4b3be2b219074fdd5ea8ef08501010000582052656164792047656e6572617465"
+        "20612033322062797465207061796c6f6164ff"
+    );
+    std::vector<uint8_t> expectedSerializedBundle;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes(expectedSerializedBundleString, expectedSerializedBundle));
+
+    BPSecManager::ReusableElementsInternal re;
+    BundleViewV7 bv;
+    GenerateRfc9173SampleBundle(bv, payloadString);
+    const uint64_t targets[1] = { 1 };
+    BOOST_REQUIRE(BPSecManager::TryAddBundleIntegrity(re, bv,
+        BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::NO_ADDITIONAL_SCOPE, COSE_ALGORITHMS::HMAC_512_512, cbhe_eid_t(2, 1),
+        targets, 1, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), NULL, 0, 2));
+    //cannot add a second block with the same block number
+    BOOST_REQUIRE(!BPSecManager::TryAddBundleIntegrity(re, bv,
+        BPSEC_BIB_HMAX_SHA2_INTEGRITY_SCOPE_MASKS::NO_ADDITIONAL_SCOPE, COSE_ALGORITHMS::HMAC_512_512, cbhe_eid_t(2, 1),
+        targets, 1, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), NULL, 0, 2));
+    BOOST_REQUIRE(bv.Render(5000));
+    BOOST_REQUIRE(expectedSerializedBundle == bv.m_frontBuffer);
+
+    //verify received bundle
+    {
+        BundleViewV7 bv2;
+        std::vector<uint8_t> toSwapIn(expectedSerializedBundle);
+        BOOST_REQUIRE(bv2.SwapInAndLoadBundle(toSwapIn));
+        BOOST_REQUIRE(BPSecManager::TryVerifyBundleIntegrity(re, bv2, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), false));
+        std::vector<uint8_t> badKey(hmacKey);
+        badKey[0] ^= 1;
+        BOOST_REQUIRE(!BPSecManager::TryVerifyBundleIntegrity(re, bv2, badKey.data(), static_cast<unsigned int>(badKey.size()), false));
+        //remove the bib after verification
+        BOOST_REQUIRE(BPSecManager::TryVerifyBundleIntegrity(re, bv2, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), true));
+        BOOST_REQUIRE(bv2.RenderInPlace(0)); //bundle shrinks
+        std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+        bv2.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::INTEGRITY, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 0);
+        BOOST_REQUIRE_EQUAL(GetPayloadString(bv2), payloadString);
+    }
+    //tampered payload fails verification
+    {
+        BundleViewV7 bv2;
+        std::vector<uint8_t> toSwapIn(expectedSerializedBundle);
+        toSwapIn[toSwapIn.size() - 2] ^= 1; //last byte of payload (before the cbor break)
+        BOOST_REQUIRE(bv2.SwapInAndLoadBundle(toSwapIn));
+        BOOST_REQUIRE(!BPSecManager::TryVerifyBundleIntegrity(re, bv2, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), false));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestBPSecManagerSimpleConfidentialityWithKeyWrapTestCase)
+{
+    //RFC 9173 A.2 Example 2
+    static const std::string payloadString("Ready Generate a 32 byte payload");
+    std::vector<uint8_t> cek;
+    std::vector<uint8_t> kek;
+    std::vector<uint8_t> iv;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("71776572747975696f70617364666768", cek));
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("6162636465666768696a6b6c6d6e6f70", kek));
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("5477656c7665313231323132", iv));
+    static const std::string expectedSerializedBundleString(
+        "9f88070000820282010282028202018202820201820018281a000f4240850c020100584f81010"
+        "20182028202018482014c5477656c76653132313231328202018203581869c411276f"
+        "ecddc4780df42c8a2af89296fabf34d7fae70082040081820150da08f4d8936024ad7"
+        "c6b3b800e73dd97850101000058203a09c1e63fe2097528a78b7c12943354a563e326"
+        "48b700c2784e26a990d91f9dff"
+    );
+    std::vector<uint8_t> expectedSerializedBundle;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes(expectedSerializedBundleString, expectedSerializedBundle));
+
+    BPSecManager::ReusableElementsInternal re;
+    BundleViewV7 bv;
+    GenerateRfc9173SampleBundle(bv, payloadString);
+    const uint64_t targets[1] = { 1 };
+    BOOST_REQUIRE(BPSecManager::TryEncryptBundle(re, bv,
+        BPSEC_BCB_AES_GCM_AAD_SCOPE_MASKS::NO_ADDITIONAL_SCOPE, COSE_ALGORITHMS::A128GCM, cbhe_eid_t(2, 1),
+        targets, 1, iv.data(), static_cast<unsigned int>(iv.size()),
+        cek.data(), static_cast<unsigned int>(cek.size()), kek.data(), static_cast<unsigned int>(kek.size()), 2));
+    BOOST_REQUIRE(bv.Render(5000));
+    BOOST_REQUIRE(expectedSerializedBundle == bv.m_frontBuffer);
+
+    //decrypt received bundle in place
+    {
+        BundleViewV7 bv2;
+        std::vector<uint8_t> toSwapIn(expectedSerializedBundle);
+        BOOST_REQUIRE(bv2.SwapInAndLoadBundle(toSwapIn));
+        std::vector<uint8_t> badKek(kek);
+        badKek[0] ^= 1;
+        BOOST_REQUIRE(!BPSecManager::TryDecryptBundle(re, bv2, badKek.data(), static_cast<unsigned int>(badKek.size())));
+        BOOST_REQUIRE(BPSecManager::TryDecryptBundle(re, bv2, kek.data(), static_cast<unsigned int>(kek.size())));
+        BOOST_REQUIRE(bv2.RenderInPlace(0)); //bundle shrinks
+        std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+        bv2.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::CONFIDENTIALITY, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 0);
+        BOOST_REQUIRE(bv2.m_mapEncryptedBlockNumberToBcbPtr.empty());
+        BOOST_REQUIRE_EQUAL(GetPayloadString(bv2), payloadString);
+    }
+    //tampered ciphertext fails authentication and leaves the ciphertext untouched
+    {
+        BundleViewV7 bv2;
+        std::vector<uint8_t> toSwapIn(expectedSerializedBundle);
+        toSwapIn[toSwapIn.size() - 2] ^= 1;
+        const std::vector<uint8_t> tamperedBundle(toSwapIn);
+        BOOST_REQUIRE(bv2.SwapInAndLoadBundle(toSwapIn));
+        BOOST_REQUIRE(!BPSecManager::TryDecryptBundle(re, bv2, kek.data(), static_cast<unsigned int>(kek.size())));
+        BOOST_REQUIRE(tamperedBundle == bv2.m_frontBuffer);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestBPSecManagerSecurityBlocksWithFullScopeTestCase)
+{
+    //RFC 9173 A.4 Example 4: BIB over the payload, then a BCB over the payload and the BIB
+    static const std::string payloadString("Ready Generate a 32 byte payload");
+    std::vector<uint8_t> hmacKey;
+    std::vector<uint8_t> cek;
+    std::vector<uint8_t> iv;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("1a2b1a2b1a2b1a2b1a2b1a2b1a2b1a2b", hmacKey));
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("71776572747975696f7061736466676871776572747975696f70617364666768", cek));
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes("5477656c7665313231323132", iv));
+    static const std::string expectedSerializedBundleString(
+        "9f88070000820282010282"
+        "02820201820282020182001828"
+        "1a000f4240850b0300005845438ed6208eb1c1ffb9"
+        "4d952175167df0902a815f221ebc837a134efc13bfa82a2d5d317747da3eb54acef4c"
+        "a839bd961487284404259b60be12b8aed2f3e8a362836529f66850c0201005847820"
+        "301020182028202018382014c5477656c766531323132313282020382040782820150"
+        "c95ed4534769b046d716e1cdfd00830e8201500e365c700e4bb19c0d991faff5345af"
+        "f8501010000582090eab64575930498d6aa654107f15e96319bb227706000abc8fcac"
+        "3b9bb9c87eff"
+    );
+    std::vector<uint8_t> expectedSerializedBundle;
+    BOOST_REQUIRE(BinaryConversions::HexStringToBytes(expectedSerializedBundleString, expectedSerializedBundle));
+
+    BPSecManager::ReusableElementsInternal re;
+    BundleViewV7 bv;
+    GenerateRfc9173SampleBundle(bv, payloadString);
+    const uint64_t bibTargets[1] = { 1 };
+    BOOST_REQUIRE(BPSecManager::TryAddBundleIntegrity(re, bv,
+        BIB_FULL_SCOPE, COSE_ALGORITHMS::HMAC_384_384, cbhe_eid_t(2, 1),
+        bibTargets, 1, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), NULL, 0, 3));
+    BOOST_REQUIRE(bv.Render(5000));
+    const uint64_t bcbTargets[2] = { 3, 1 };
+    BOOST_REQUIRE(BPSecManager::TryEncryptBundle(re, bv,
+        BCB_FULL_SCOPE, COSE_ALGORITHMS::A256GCM, cbhe_eid_t(2, 1),
+        bcbTargets, 2, iv.data(), static_cast<unsigned int>(iv.size()),
+        cek.data(), static_cast<unsigned int>(cek.size()), NULL, 0, 2));
+    BOOST_REQUIRE(bv.Render(5000));
+    BOOST_REQUIRE(expectedSerializedBundle == bv.m_frontBuffer);
+
+    //receiver decrypts then verifies, removing both security blocks
+    {
+        BundleViewV7 bv2;
+        std::vector<uint8_t> toSwapIn(expectedSerializedBundle);
+        BOOST_REQUIRE(bv2.SwapInAndLoadBundle(toSwapIn));
+        BOOST_REQUIRE(BPSecManager::TryDecryptBundle(re, bv2, cek.data(), static_cast<unsigned int>(cek.size())));
+        BOOST_REQUIRE(BPSecManager::TryVerifyBundleIntegrity(re, bv2, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), true));
+        BOOST_REQUIRE(bv2.RenderInPlace(0)); //bundle shrinks
+        BOOST_REQUIRE_EQUAL(bv2.m_listCanonicalBlockView.size(), 1);
+        BOOST_REQUIRE_EQUAL(GetPayloadString(bv2), payloadString);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestBPSecManagerWorkerPoolTestCase)
+{
+    static const std::string payloadString("Ready Generate a 32 byte payload");
+    std::vector<uint8_t> cek(32, 0x5a);
+    std::vector<uint8_t> iv(12, 0x01);
+    static const unsigned int NUM_BUNDLES = 100;
+    std::vector<std::unique_ptr<BundleViewV7> > bundleViews;
+    std::vector<BundleViewV7*> bundlePtrs;
+    for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+        bundleViews.emplace_back(boost::make_unique<BundleViewV7>());
+        GenerateRfc9173SampleBundle(*bundleViews.back(), payloadString);
+        bundlePtrs.push_back(bundleViews.back().get());
+    }
+    const uint64_t targets[1] = { 1 };
+    const BpSecWorkerPool::bundle_operation_function_t encryptFunc = [&](BundleViewV7 & bv, BPSecManager::ReusableElementsInternal & re) {
+        return BPSecManager::TryEncryptBundle(re, bv,
+            BCB_FULL_SCOPE, COSE_ALGORITHMS::A256GCM, cbhe_eid_t(2, 1),
+            targets, 1, iv.data(), static_cast<unsigned int>(iv.size()),
+            cek.data(), static_cast<unsigned int>(cek.size()), NULL, 0, 2) && bv.Render(5000);
+    };
+    const BpSecWorkerPool::bundle_operation_function_t decryptFunc = [&](BundleViewV7 & bv, BPSecManager::ReusableElementsInternal & re) {
+        return BPSecManager::TryDecryptBundle(re, bv, cek.data(), static_cast<unsigned int>(cek.size())) && bv.RenderInPlace(0); //bundle shrinks
+    };
+    BpSecWorkerPool pool(4);
+    BOOST_REQUIRE_EQUAL(pool.GetNumThreads(), 4);
+    std::vector<uint8_t> successes;
+    BOOST_REQUIRE_EQUAL(pool.ProcessBatch(bundlePtrs, encryptFunc, successes), NUM_BUNDLES);
+    for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+        BOOST_REQUIRE_EQUAL(successes[i], 1);
+        BOOST_REQUIRE_NE(GetPayloadString(*bundlePtrs[i]), payloadString);
+    }
+    //already encrypted, so a second encryption with the same bcb block number fails
+    BOOST_REQUIRE_EQUAL(pool.ProcessBatch(bundlePtrs, encryptFunc, successes), 0);
+    BOOST_REQUIRE_EQUAL(pool.ProcessBatch(bundlePtrs, decryptFunc, successes), NUM_BUNDLES);
+    for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+        BOOST_REQUIRE_EQUAL(GetPayloadString(*bundlePtrs[i]), payloadString);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestBPSecManagerSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t PAYLOAD_SIZE = 1000000;
+    static const unsigned int NUM_ITERATIONS = 2000;
+    const std::string payloadString(PAYLOAD_SIZE, 'a');
+    std::vector<uint8_t> hmacKey(32, 0x1a);
+    std::vector<uint8_t> cek(32, 0x5a);
+    std::vector<uint8_t> iv(12, 0x01);
+    BPSecManager::ReusableElementsInternal re;
+    padded_vector_uint8_t bundleSerializedPadded;
+    {
+        BundleViewV7 bvOriginal;
+        GenerateRfc9173SampleBundle(bvOriginal, payloadString);
+        bundleSerializedPadded.assign(bvOriginal.m_frontBuffer.begin(), bvOriginal.m_frontBuffer.end());
+    }
+    BundleViewV7 bv;
+    BOOST_REQUIRE(bv.LoadBundle(&bundleSerializedPadded[0], bundleSerializedPadded.size()));
+    const std::size_t paddingLeft = bundleSerializedPadded.get_allocator().PADDING_ELEMENTS_BEFORE;
+    const uint64_t targets[1] = { 1 };
+    {
+        std::cout << "single core AES-256-GCM in place encrypt+decrypt of " << NUM_ITERATIONS << " x " << PAYLOAD_SIZE << " byte payloads\n";
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_ITERATIONS; ++i) {
+            BOOST_REQUIRE(BPSecManager::TryEncryptBundle(re, bv,
+                BCB_FULL_SCOPE, COSE_ALGORITHMS::A256GCM, cbhe_eid_t(2, 1),
+                targets, 1, iv.data(), static_cast<unsigned int>(iv.size()),
+                cek.data(), static_cast<unsigned int>(cek.size()), NULL, 0, 2));
+            BOOST_REQUIRE(bv.RenderInPlace(paddingLeft));
+            BOOST_REQUIRE(BPSecManager::TryDecryptBundle(re, bv, cek.data(), static_cast<unsigned int>(cek.size())));
+            BOOST_REQUIRE(bv.RenderInPlace(paddingLeft));
+        }
+        const double seconds = static_cast<double>(timer.elapsed().wall) * 1e-9;
+        std::cout << "    " << ((2.0 * NUM_ITERATIONS * PAYLOAD_SIZE * 8) / seconds) * 1e-9 << " Gbps per core\n";
+    }
+    {
+        std::cout << "single core HMAC-SHA-384 add+verify of " << NUM_ITERATIONS << " x " << PAYLOAD_SIZE << " byte payloads\n";
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_ITERATIONS; ++i) {
+            BOOST_REQUIRE(BPSecManager::TryAddBundleIntegrity(re, bv,
+                BIB_FULL_SCOPE, COSE_ALGORITHMS::HMAC_384_384, cbhe_eid_t(2, 1),
+                targets, 1, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), NULL, 0, 2));
+            BOOST_REQUIRE(bv.RenderInPlace(paddingLeft));
+            BOOST_REQUIRE(BPSecManager::TryVerifyBundleIntegrity(re, bv, hmacKey.data(), static_cast<unsigned int>(hmacKey.size()), true));
+            BOOST_REQUIRE(bv.RenderInPlace(paddingLeft));
+        }
+        const double seconds = static_cast<double>(timer.elapsed().wall) * 1e-9;
+        std::cout << "    " << ((2.0 * NUM_ITERATIONS * PAYLOAD_SIZE * 8) / seconds) * 1e-9 << " Gbps per core\n";
+    }
+}
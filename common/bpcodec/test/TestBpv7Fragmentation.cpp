@@ -0,0 +1,284 @@
+#include <boost/test/unit_test.hpp>
+#include "codec/Bpv7Fragmentation.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <boost/make_unique.hpp>
+#include <boost/next_prior.hpp>
+
+static const uint64_t PRIMARY_SRC_NODE = 100;
+static const uint64_t PRIMARY_SRC_SVC = 1;
+static const uint64_t PRIMARY_DEST_NODE = 200;
+static const uint64_t PRIMARY_DEST_SVC = 2;
+static const uint64_t PRIMARY_TIME = 10000;
+static const uint64_t PRIMARY_LIFETIME = 2000;
+static const uint64_t PRIMARY_SEQ = 1;
+
+static void AppendBlock(BundleViewV7 & bv, BPV7_BLOCK_TYPE_CODE type, uint64_t blockNumber, BPV7_BLOCKFLAG flags, const std::string & body) {
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+    Bpv7CanonicalBlock & block = *blockPtr;
+    block.m_blockTypeCode = type;
+    block.m_blockProcessingControlFlags = flags;
+    block.m_blockNumber = blockNumber;
+    block.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    block.m_dataLength = body.size();
+    block.m_dataPtr = (uint8_t*)body.data(); //body must remain in scope until after render
+    bv.AppendMoveCanonicalBlock(blockPtr);
+}
+
+static void GenerateBundle(BundleViewV7 & bv, const BPV7_BUNDLEFLAG flags, const std::string & payload) {
+    static const std::string replicatedBody("replicated");
+    static const std::string firstFragmentOnlyBody("first fragment only");
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = flags;
+    primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+    primary.m_destinationEid.Set(PRIMARY_DEST_NODE, PRIMARY_DEST_SVC);
+    primary.m_reportToEid.Set(0, 0);
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = PRIMARY_TIME;
+    primary.m_lifetimeMilliseconds = PRIMARY_LIFETIME;
+    primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+    primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    bv.m_primaryBlockView.SetManuallyModified();
+
+    AppendBlock(bv, BPV7_BLOCK_TYPE_CODE::UNUSED_5, 2, BPV7_BLOCKFLAG::MUST_BE_REPLICATED, replicatedBody);
+    AppendBlock(bv, BPV7_BLOCK_TYPE_CODE::UNUSED_4, 3, BPV7_BLOCKFLAG::NO_FLAGS_SET, firstFragmentOnlyBody);
+    AppendBlock(bv, BPV7_BLOCK_TYPE_CODE::PAYLOAD, 1, BPV7_BLOCKFLAG::NO_FLAGS_SET, payload);
+    BOOST_REQUIRE(bv.Render(payload.size() + 500));
+}
+
+static std::string MakePayload(const std::size_t size) {
+    std::string payload(size, 0);
+    for (std::size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>('a' + (i % 26));
+    }
+    return payload;
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7FragmentAndReassembleTestCase)
+{
+    const std::string payload = MakePayload(1000);
+    BundleViewV7 bv;
+    GenerateBundle(bv, BPV7_BUNDLEFLAG::NO_FLAGS_SET, payload);
+    const std::vector<uint8_t> originalBundle(bv.m_frontBuffer);
+
+    static const uint64_t MAX_FRAGMENT_SIZE = 300;
+    std::list<std::vector<uint8_t> > fragments;
+    BOOST_REQUIRE(Bpv7Fragmenter::Fragment(bv, MAX_FRAGMENT_SIZE, fragments));
+    BOOST_REQUIRE_GT(fragments.size(), 3);
+
+    //every fragment is a valid bundle carrying the right blocks and a contiguous piece of the payload
+    uint64_t expectedOffset = 0;
+    for (std::list<std::vector<uint8_t> >::iterator it = fragments.begin(); it != fragments.end(); ++it) {
+        BOOST_REQUIRE_LE(it->size(), MAX_FRAGMENT_SIZE);
+        BundleViewV7 fragmentBv;
+        BOOST_REQUIRE(fragmentBv.CopyAndLoadBundle(it->data(), it->size()));
+        const Bpv7CbhePrimaryBlock & primary = fragmentBv.m_primaryBlockView.header;
+        BOOST_REQUIRE(primary.HasFragmentationFlagSet());
+        BOOST_REQUIRE_EQUAL(primary.m_fragmentOffset, expectedOffset);
+        BOOST_REQUIRE_EQUAL(primary.m_totalApplicationDataUnitLength, payload.size());
+        BOOST_REQUIRE_EQUAL(fragmentBv.GetCanonicalBlockCountByType(BPV7_BLOCK_TYPE_CODE::UNUSED_5), 1);
+        BOOST_REQUIRE_EQUAL(fragmentBv.GetCanonicalBlockCountByType(BPV7_BLOCK_TYPE_CODE::UNUSED_4), (expectedOffset == 0) ? 1 : 0);
+        const Bpv7CanonicalBlock & payloadBlock = *fragmentBv.m_listCanonicalBlockView.back().headerPtr;
+        BOOST_REQUIRE(std::string((const char*)payloadBlock.m_dataPtr, payloadBlock.m_dataLength) == payload.substr(expectedOffset, payloadBlock.m_dataLength));
+        expectedOffset += payloadBlock.m_dataLength;
+    }
+    BOOST_REQUIRE_EQUAL(expectedOffset, payload.size());
+
+    //fragment the second fragment again; its pieces keep offsets relative to the original payload
+    std::list<std::vector<uint8_t> > subFragments;
+    {
+        BundleViewV7 secondFragmentBv;
+        BOOST_REQUIRE(secondFragmentBv.CopyAndLoadBundle(boost::next(fragments.begin())->data(), boost::next(fragments.begin())->size()));
+        BOOST_REQUIRE(Bpv7Fragmenter::Fragment(secondFragmentBv, 150, subFragments));
+        BOOST_REQUIRE_GT(subFragments.size(), 1);
+        BundleViewV7 firstSubFragmentBv;
+        BOOST_REQUIRE(firstSubFragmentBv.CopyAndLoadBundle(subFragments.front().data(), subFragments.front().size()));
+        BOOST_REQUIRE_EQUAL(firstSubFragmentBv.m_primaryBlockView.header.m_fragmentOffset, secondFragmentBv.m_primaryBlockView.header.m_fragmentOffset);
+        BOOST_REQUIRE_EQUAL(firstSubFragmentBv.m_primaryBlockView.header.m_totalApplicationDataUnitLength, payload.size());
+    }
+
+    //reassemble out of order (last fragment first), with the second fragment arriving as both pieces and a duplicate
+    std::list<std::vector<uint8_t> > arrivalOrder(fragments.rbegin(), fragments.rend());
+    arrivalOrder.insert(boost::next(arrivalOrder.begin()), subFragments.begin(), subFragments.end());
+    Bpv7FragmentReassembler reassembler;
+    std::vector<uint8_t> reassembledBundle;
+    std::size_t numAdded = 0;
+    for (std::list<std::vector<uint8_t> >::iterator it = arrivalOrder.begin(); it != arrivalOrder.end(); ++it) {
+        BundleViewV7 fragmentBv;
+        BOOST_REQUIRE(fragmentBv.CopyAndLoadBundle(it->data(), it->size()));
+        bool isComplete;
+        BOOST_REQUIRE(reassembler.AddFragment(fragmentBv, isComplete, reassembledBundle));
+        ++numAdded;
+        BOOST_REQUIRE_EQUAL(isComplete, (numAdded == arrivalOrder.size()));
+        BOOST_REQUIRE_EQUAL(reassembler.GetNumPendingBundles(), (isComplete) ? 0 : 1);
+    }
+    BOOST_REQUIRE_EQUAL(reassembler.GetNumBytesInUse(), 0);
+    BOOST_REQUIRE(reassembledBundle == originalBundle);
+
+    //a single payload range (i.e. the unsent remainder of a bundle)
+    std::vector<uint8_t> remainderFragment;
+    BOOST_REQUIRE(Bpv7Fragmenter::FragmentPayloadRange(bv, 600, 400, remainderFragment));
+    BundleViewV7 remainderBv;
+    BOOST_REQUIRE(remainderBv.SwapInAndLoadBundle(remainderFragment));
+    BOOST_REQUIRE_EQUAL(remainderBv.m_primaryBlockView.header.m_fragmentOffset, 600);
+    BOOST_REQUIRE_EQUAL(remainderBv.m_listCanonicalBlockView.back().headerPtr->m_dataLength, 400);
+    BOOST_REQUIRE(!Bpv7Fragmenter::FragmentPayloadRange(bv, 600, 401, remainderFragment));
+    BOOST_REQUIRE(!Bpv7Fragmenter::FragmentPayloadRange(bv, 1000, 1, remainderFragment));
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7FragmentationRefusedTestCase)
+{
+    const std::string payload = MakePayload(1000);
+    std::list<std::vector<uint8_t> > fragments;
+    {
+        BundleViewV7 bv;
+        GenerateBundle(bv, BPV7_BUNDLEFLAG::NOFRAGMENT, payload);
+        BOOST_REQUIRE(!Bpv7Fragmenter::IsFragmentable(bv));
+        BOOST_REQUIRE(!Bpv7Fragmenter::Fragment(bv, 300, fragments));
+        BOOST_REQUIRE(fragments.empty());
+    }
+    {
+        BundleViewV7 bv;
+        GenerateBundle(bv, BPV7_BUNDLEFLAG::NO_FLAGS_SET, payload);
+        BOOST_REQUIRE(!Bpv7Fragmenter::Fragment(bv, 50, fragments)); //blocks alone exceed the max
+        BOOST_REQUIRE(fragments.empty());
+    }
+}
+
+//a bundle whose BIB targets the given block, loaded back from its serialization
+static void GenerateBundleWithBib(BundleViewV7 & bv, const uint64_t bibTargetBlockNumber, const std::string & payload) {
+    BundleViewV7 bvToRender;
+    GenerateBundle(bvToRender, BPV7_BUNDLEFLAG::NO_FLAGS_SET, payload);
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7BlockIntegrityBlock>();
+    Bpv7BlockIntegrityBlock & bib = *(reinterpret_cast<Bpv7BlockIntegrityBlock*>(blockPtr.get()));
+    bib.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+    bib.m_blockNumber = 4;
+    bib.m_crcType = BPV7_CRC_TYPE::NONE;
+    bib.m_securityTargets = Bpv7AbstractSecurityBlock::security_targets_t({ bibTargetBlockNumber });
+    bib.m_securityContextFlags = 0;
+    bib.m_securitySource.Set(PRIMARY_SRC_NODE, 0);
+    std::vector<uint8_t> * resultPtr = bib.AppendAndGetExpectedHmacPtr();
+    BOOST_REQUIRE(resultPtr);
+    resultPtr->assign(32, 0x55);
+    bvToRender.PrependMoveCanonicalBlock(blockPtr);
+    BOOST_REQUIRE(bvToRender.Render(payload.size() + 500));
+    BOOST_REQUIRE(bv.CopyAndLoadBundle(bvToRender.m_frontBuffer.data(), bvToRender.m_frontBuffer.size()));
+    BOOST_REQUIRE_EQUAL(bv.GetCanonicalBlockCountByType(BPV7_BLOCK_TYPE_CODE::INTEGRITY), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7FragmentationBibTargetsTestCase)
+{
+    const std::string payload = MakePayload(1000);
+    std::list<std::vector<uint8_t> > fragments;
+    //an integrity check over the payload or the primary block could not be verified on any fragment
+    for (uint64_t target = 0; target <= 1; ++target) {
+        BundleViewV7 bv;
+        GenerateBundleWithBib(bv, target, payload);
+        BOOST_REQUIRE(!Bpv7Fragmenter::IsFragmentable(bv));
+        BOOST_REQUIRE(!Bpv7Fragmenter::Fragment(bv, 300, fragments));
+        BOOST_REQUIRE(fragments.empty());
+    }
+    //an integrity check over an extension block is unaffected
+    {
+        BundleViewV7 bv;
+        GenerateBundleWithBib(bv, 3, payload);
+        BOOST_REQUIRE(Bpv7Fragmenter::IsFragmentable(bv));
+        BOOST_REQUIRE(Bpv7Fragmenter::Fragment(bv, 400, fragments));
+        BOOST_REQUIRE_GT(fragments.size(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7FragmentReassemblerLimitsTestCase)
+{
+    const std::string payload = MakePayload(1000);
+    BundleViewV7 bv;
+    GenerateBundle(bv, BPV7_BUNDLEFLAG::NO_FLAGS_SET, payload);
+    std::list<std::vector<uint8_t> > fragments;
+    BOOST_REQUIRE(Bpv7Fragmenter::Fragment(bv, 300, fragments));
+    BundleViewV7 fragmentBv;
+    BOOST_REQUIRE(fragmentBv.CopyAndLoadBundle(fragments.front().data(), fragments.front().size()));
+    std::vector<uint8_t> reassembledBundle;
+    bool isComplete;
+
+    //the whole application data unit must fit under the memory cap
+    Bpv7FragmentReassembler smallReassembler(500);
+    BOOST_REQUIRE(!smallReassembler.AddFragment(fragmentBv, isComplete, reassembledBundle));
+    BOOST_REQUIRE_EQUAL(smallReassembler.GetNumPendingBundles(), 0);
+
+    //incomplete bundles are discarded once their lifetime ends
+    Bpv7FragmentReassembler reassembler;
+    BOOST_REQUIRE(reassembler.AddFragment(fragmentBv, isComplete, reassembledBundle));
+    BOOST_REQUIRE(!isComplete);
+    BOOST_REQUIRE_GT(reassembler.GetNumBytesInUse(), payload.size());
+    BOOST_REQUIRE_EQUAL(reassembler.RemoveExpiredBundles(PRIMARY_TIME + PRIMARY_LIFETIME - 1), 0);
+    BOOST_REQUIRE_EQUAL(reassembler.RemoveExpiredBundles(PRIMARY_TIME + PRIMARY_LIFETIME), 1);
+    BOOST_REQUIRE_EQUAL(reassembler.GetNumPendingBundles(), 0);
+    BOOST_REQUIRE_EQUAL(reassembler.GetNumBytesInUse(), 0);
+
+    //a whole bundle is not a fragment
+    BOOST_REQUIRE(!reassembler.AddFragment(bv, isComplete, reassembledBundle));
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7ReactiveFragmentationTestCase)
+{
+    const std::string payload = MakePayload(1000);
+    BundleViewV7 bv;
+    GenerateBundle(bv, BPV7_BUNDLEFLAG::NO_FLAGS_SET, payload);
+    const std::vector<uint8_t> originalBundle(bv.m_frontBuffer);
+    const uint64_t payloadDataIndex = originalBundle.size() - payload.size() - 6; //payload is followed by a crc32c and the break stop code
+
+    //interrupted within the payload: the received prefix and the unsent remainder reassemble into the original bundle
+    static const uint64_t CUTS[3] = { 1, 500, 999 };
+    for (unsigned int i = 0; i < 3; ++i) {
+        const uint64_t numBytesDelivered = payloadDataIndex + CUTS[i];
+        std::vector<uint8_t> senderBundle(originalBundle);
+        std::vector<uint8_t> remainderFragment;
+        BOOST_REQUIRE(Bpv7Fragmenter::FragmentUnsentRemainder(senderBundle.data(), senderBundle.size(), numBytesDelivered, remainderFragment));
+        BOOST_REQUIRE(senderBundle == originalBundle);
+
+        std::vector<uint8_t> receiverBuffer(originalBundle.begin(), originalBundle.begin() + numBytesDelivered);
+        receiverBuffer.resize(originalBundle.size());
+        std::vector<uint8_t> prefixFragment;
+        BOOST_REQUIRE(Bpv7Fragmenter::FragmentReceivedPrefix(receiverBuffer.data(), numBytesDelivered, receiverBuffer.size(), prefixFragment));
+
+        Bpv7FragmentReassembler reassembler;
+        std::vector<uint8_t> reassembledBundle;
+        bool isComplete;
+        BundleViewV7 prefixBv;
+        BOOST_REQUIRE(prefixBv.SwapInAndLoadBundle(prefixFragment));
+        BOOST_REQUIRE_EQUAL(prefixBv.m_listCanonicalBlockView.back().headerPtr->m_dataLength, CUTS[i]);
+        BOOST_REQUIRE(reassembler.AddFragment(prefixBv, isComplete, reassembledBundle));
+        BOOST_REQUIRE(!isComplete);
+        BundleViewV7 remainderBv;
+        BOOST_REQUIRE(remainderBv.SwapInAndLoadBundle(remainderFragment));
+        BOOST_REQUIRE_EQUAL(remainderBv.m_primaryBlockView.header.m_fragmentOffset, CUTS[i]);
+        BOOST_REQUIRE(reassembler.AddFragment(remainderBv, isComplete, reassembledBundle));
+        BOOST_REQUIRE(isComplete);
+        BOOST_REQUIRE(reassembledBundle == originalBundle);
+    }
+
+    //interrupted before any payload data was acked: the whole payload is resent as a fragment that completes the bundle on its own
+    std::vector<uint8_t> senderBundle(originalBundle);
+    std::vector<uint8_t> fragment;
+    const uint64_t noPayloadCuts[2] = { 0, payloadDataIndex };
+    for (unsigned int i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(Bpv7Fragmenter::FragmentUnsentRemainder(senderBundle.data(), senderBundle.size(), noPayloadCuts[i], fragment));
+        BundleViewV7 wholePayloadBv;
+        BOOST_REQUIRE(wholePayloadBv.SwapInAndLoadBundle(fragment));
+        BOOST_REQUIRE_EQUAL(wholePayloadBv.m_primaryBlockView.header.m_fragmentOffset, 0);
+        BOOST_REQUIRE_EQUAL(wholePayloadBv.m_listCanonicalBlockView.back().headerPtr->m_dataLength, payload.size());
+        Bpv7FragmentReassembler reassembler;
+        std::vector<uint8_t> reassembledBundle;
+        bool isComplete;
+        BOOST_REQUIRE(reassembler.AddFragment(wholePayloadBv, isComplete, reassembledBundle));
+        BOOST_REQUIRE(isComplete);
+        BOOST_REQUIRE(reassembledBundle == originalBundle);
+    }
+    //the whole payload was delivered (only the trailing crc and break stop code are missing): the whole bundle must be sent again
+    BOOST_REQUIRE(!Bpv7Fragmenter::FragmentUnsentRemainder(senderBundle.data(), senderBundle.size(), payloadDataIndex + payload.size() + 1, fragment));
+    std::vector<uint8_t> receiverBuffer(originalBundle.begin(), originalBundle.begin() + payloadDataIndex - 2);
+    receiverBuffer.resize(originalBundle.size());
+    BOOST_REQUIRE(!Bpv7Fragmenter::FragmentReceivedPrefix(receiverBuffer.data(), payloadDataIndex - 2, receiverBuffer.size(), fragment));
+}
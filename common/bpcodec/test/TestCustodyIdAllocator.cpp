@@ -103,3 +103,54 @@ BOOST_AUTO_TEST_CASE(CustodyIdAllocatorTestCase)
     }
 }
 
+
+BOOST_AUTO_TEST_CASE(CustodyIdAllocatorBitmapTestCase)
+{
+    //fill more than one level 2 word (4096 multipliers) from a single source, then free in ranges like ACS fills
+    {
+        CustodyIdAllocator cia;
+        static const uint64_t NUM_IDS = 5000 * 256;
+        for (uint64_t i = 0; i < NUM_IDS; ++i) {
+            BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(1, 1)), i);
+        }
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(NUM_IDS - 1));
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(NUM_IDS)); //next block of source 1
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(NUM_IDS + 256)); //reserved for the next allocation
+        BOOST_REQUIRE(!cia.IsCustodyIdUsed(NUM_IDS + 512));
+        //free the middle of two blocks (no multipliers freed), then the rest of them
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(4100 * 256 + 10, 4102 * 256 - 11), 0);
+        BOOST_REQUIRE(!cia.IsCustodyIdUsed(4100 * 256 + 10));
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(4100 * 256 + 9));
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(4100 * 256, 4102 * 256 - 1), 2);
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(4100 * 256, 4102 * 256 - 1), 0); //already freed
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(3 * 256, 4 * 256 - 1), 1);
+        //new sources take the reserved block, after which the lowest free multipliers are reserved in order
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(2, 2)), NUM_IDS + 256);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(1, 1)), NUM_IDS);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(3, 3)), 3 * 256);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(4, 4)), 4100 * 256);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(5, 5)), 4101 * 256);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(6, 6)), NUM_IDS + 512);
+        //freeing beyond what was ever allocated is harmless
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyId(UINT64_MAX), 0);
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(NUM_IDS * 2, UINT64_MAX), 0);
+        cia.Reset();
+        BOOST_REQUIRE(!cia.IsCustodyIdUsed(0));
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(5, 5)), 0);
+    }
+
+    //InitializeAddUsedCustodyIdRange spanning blocks
+    {
+        CustodyIdAllocator cia;
+        cia.InitializeAddUsedCustodyIdRange(100, 700);
+        BOOST_REQUIRE(!cia.IsCustodyIdUsed(99));
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(100));
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(700));
+        BOOST_REQUIRE(!cia.IsCustodyIdUsed(701));
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(1, 1)), 768);
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(256, 511), 1);
+        BOOST_REQUIRE_EQUAL(cia.GetNextCustodyIdForNextHopCtebToSend(cbhe_eid_t(2, 2)), 1024);
+        BOOST_REQUIRE(cia.IsCustodyIdUsed(256)); //freed multiplier 1 reserved for the next allocation
+        BOOST_REQUIRE_EQUAL(cia.FreeCustodyIdRange(0, 767), 3);
+    }
+}
@@ -712,3 +712,146 @@ BOOST_AUTO_TEST_CASE(CustodyTransferTestCase)
 
 }
 
+
+BOOST_AUTO_TEST_CASE(AcsFillsBuilderTestCase)
+{
+    //mostly in order custody ids with gaps, duplicates, and out of order ids
+    std::vector<uint64_t> custodyIds;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        if ((i % 7) != 3) { //gaps
+            custodyIds.push_back(i * 3 + ((i % 5) == 0)); //non-contiguous fills
+        }
+        if ((i % 11) == 0) {
+            custodyIds.push_back(i); //duplicates and out of order
+        }
+        if ((i % 50) == 49) {
+            custodyIds.push_back(i * 3 + 100000); //out of order (ahead) followed by smaller ids
+        }
+    }
+    custodyIds.push_back(1ULL << 40); //large custody id
+
+    Bpv6AdministrativeRecordContentAggregateCustodySignal expectedAcs;
+    expectedAcs.SetCustodyTransferStatusAndReason(false, BPV6_CUSTODY_SIGNAL_REASON_CODES_7BIT::DEPLETED_STORAGE);
+    AcsFillsBuilder acsBuilder;
+    acsBuilder.Reserve(100);
+    acsBuilder.SetCustodyTransferStatusAndReason(false, BPV6_CUSTODY_SIGNAL_REASON_CODES_7BIT::DEPLETED_STORAGE);
+    BOOST_REQUIRE(acsBuilder.IsEmpty());
+    for (std::size_t i = 0; i < custodyIds.size(); ++i) {
+        const uint64_t expectedNumFills = expectedAcs.AddCustodyIdToFill(custodyIds[i]);
+        BOOST_REQUIRE_GE(acsBuilder.AddCustodyIdToFill(custodyIds[i]), expectedNumFills); //upper bound with out of order ids
+        BOOST_REQUIRE_GE(acsBuilder.GetContentSerializationSize(), expectedAcs.GetSerializationSize());
+    }
+    BOOST_REQUIRE(!acsBuilder.IsEmpty());
+    BOOST_REQUIRE(acsBuilder.GetAcs() == expectedAcs);
+
+    std::vector<uint8_t> expectedSerialization(expectedAcs.GetSerializationSize() + 10);
+    expectedSerialization.resize(expectedAcs.SerializeBpv6(expectedSerialization.data(), expectedSerialization.size()));
+    acsBuilder.MergeOutOfOrderFills();
+    BOOST_REQUIRE_EQUAL(acsBuilder.GetNumFills(), expectedAcs.m_custodyIdFills.size());
+    BOOST_REQUIRE_EQUAL(acsBuilder.GetContentSerializationSize(), expectedSerialization.size());
+    std::vector<uint8_t> serialization(expectedSerialization.size());
+    BOOST_REQUIRE_EQUAL(acsBuilder.SerializeContent(serialization.data(), serialization.size() - 1), 0); //buffer too small
+    BOOST_REQUIRE_EQUAL(acsBuilder.SerializeContent(serialization.data(), serialization.size()), expectedSerialization.size());
+    BOOST_REQUIRE(serialization == expectedSerialization);
+
+    //keep building after the merge
+    BOOST_REQUIRE_EQUAL(acsBuilder.AddCustodyIdToFill((1ULL << 40) + 1), expectedAcs.AddCustodyIdToFill((1ULL << 40) + 1));
+    BOOST_REQUIRE(acsBuilder.GetAcs() == expectedAcs);
+
+    acsBuilder.Reset();
+    BOOST_REQUIRE(acsBuilder.IsEmpty());
+    BOOST_REQUIRE_EQUAL(acsBuilder.GetNumFills(), 0);
+    BOOST_REQUIRE_EQUAL(acsBuilder.AddCustodyIdToFill(5), 1);
+    BOOST_REQUIRE_EQUAL(acsBuilder.GetAcs().m_custodyIdFills.size(), 1);
+    BOOST_REQUIRE(!acsBuilder.GetAcs().DidCustodyTransferSucceed());
+}
+
+BOOST_AUTO_TEST_CASE(CustodyTransferManagerIncrementalAcsTestCase)
+{
+    const std::string bundleDataStr = "bundle data!!!";
+    const cbhe_eid_t custodianOriginator(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+    static const uint64_t MAX_FILLS_PER_ACS = 3;
+    CustodyTransferManager ctmHdtn(true, PRIMARY_HDTN_NODE, PRIMARY_HDTN_SVC);
+    ctmHdtn.SetAcsFlushThresholds(MAX_FILLS_PER_ACS, 1000, boost::posix_time::seconds(10));
+    const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    BOOST_REQUIRE(!ctmHdtn.IsAcsReadyToSend(startTime + boost::posix_time::hours(1))); //nothing pending
+
+    //custody ids 1,2,3 then 5 then 7 => 3 fills
+    static const uint64_t srcCtebCustodyIds[5] = { 1, 2, 3, 5, 7 };
+    for (unsigned int i = 0; i < 5; ++i) {
+        BundleViewV6 bundleViewWithCteb;
+        GenerateBundleWithCteb(
+            PRIMARY_SRC_NODE, PRIMARY_SRC_SVC, //primary custodian
+            PRIMARY_SRC_NODE, PRIMARY_SRC_SVC, srcCtebCustodyIds[i], //cteb custodian
+            bundleDataStr, bundleViewWithCteb);
+        std::vector<uint8_t> bundleData(bundleViewWithCteb.m_frontBuffer);
+        BundleViewV6 bv;
+        BOOST_REQUIRE(bv.SwapInAndLoadBundle(bundleData));
+        BundleViewV6 custodySignalRfc5050RenderedBundleView;
+        BOOST_REQUIRE(!ctmHdtn.HasFullAcs());
+        BOOST_REQUIRE(ctmHdtn.ProcessCustodyOfBundle(bv, true, 100 + i, BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION,
+            custodySignalRfc5050RenderedBundleView));
+        BOOST_REQUIRE_EQUAL(custodySignalRfc5050RenderedBundleView.m_renderedBundle.size(), 0);
+    }
+    BOOST_REQUIRE(ctmHdtn.HasFullAcs());
+    BOOST_REQUIRE(ctmHdtn.IsAcsReadyToSend(startTime));
+    BOOST_REQUIRE_EQUAL(ctmHdtn.GetLargestNumberOfFills(), 3);
+
+    std::list<serialized_acs_bundle_t> acsBundleList;
+    BOOST_REQUIRE(ctmHdtn.GenerateReadyAcsBundles(acsBundleList, startTime));
+    BOOST_REQUIRE_EQUAL(acsBundleList.size(), 1);
+    BOOST_REQUIRE(!ctmHdtn.HasFullAcs());
+    BOOST_REQUIRE(!ctmHdtn.IsAcsReadyToSend(startTime + boost::posix_time::hours(1)));
+    BOOST_REQUIRE_EQUAL(ctmHdtn.GetLargestNumberOfFills(), 0);
+    {
+        serialized_acs_bundle_t & acsBundle = acsBundleList.front();
+        BOOST_REQUIRE_EQUAL(acsBundle.m_primary.m_destinationEid, custodianOriginator);
+        BundleViewV6 bvSrc;
+        BOOST_REQUIRE(bvSrc.LoadBundle(acsBundle.m_bundleSerialized.data(), acsBundle.m_bundleSerialized.size()));
+        Bpv6CbhePrimaryBlock & primary = bvSrc.m_primaryBlockView.header;
+        const BPV6_BUNDLEFLAG requiredPrimaryFlags = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT | BPV6_BUNDLEFLAG::ADMINRECORD;
+        BOOST_REQUIRE_EQUAL(primary.m_bundleProcessingControlFlags & requiredPrimaryFlags, requiredPrimaryFlags);
+        BOOST_REQUIRE_EQUAL(primary.m_sourceNodeId, cbhe_eid_t(PRIMARY_HDTN_NODE, PRIMARY_HDTN_SVC));
+        BOOST_REQUIRE_EQUAL(primary.m_destinationEid, custodianOriginator);
+        std::vector<BundleViewV6::Bpv6CanonicalBlockView*> blocks;
+        bvSrc.GetCanonicalBlocksByType(BPV6_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+        Bpv6AdministrativeRecord* adminRecordBlockPtr = dynamic_cast<Bpv6AdministrativeRecord*>(blocks[0]->headerPtr.get());
+        BOOST_REQUIRE(adminRecordBlockPtr);
+        BOOST_REQUIRE_EQUAL(adminRecordBlockPtr->m_adminRecordTypeCode, BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::AGGREGATE_CUSTODY_SIGNAL);
+        Bpv6AdministrativeRecordContentAggregateCustodySignal * acsPtr = dynamic_cast<Bpv6AdministrativeRecordContentAggregateCustodySignal*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
+        BOOST_REQUIRE(acsPtr);
+        BOOST_REQUIRE(acsPtr->DidCustodyTransferSucceed());
+        Bpv6AdministrativeRecordContentAggregateCustodySignal expectedAcs;
+        for (unsigned int i = 0; i < 5; ++i) {
+            expectedAcs.AddCustodyIdToFill(srcCtebCustodyIds[i]);
+        }
+        BOOST_REQUIRE(acsPtr->m_custodyIdFills == expectedAcs.m_custodyIdFills);
+    }
+
+    //a single fill is only sent once its first fill is 10 seconds old (or when sending all)
+    {
+        BundleViewV6 bundleViewWithCteb;
+        GenerateBundleWithCteb(
+            PRIMARY_SRC_NODE, PRIMARY_SRC_SVC, //primary custodian
+            PRIMARY_SRC_NODE, PRIMARY_SRC_SVC, 20, //cteb custodian
+            bundleDataStr, bundleViewWithCteb);
+        std::vector<uint8_t> bundleData(bundleViewWithCteb.m_frontBuffer);
+        BundleViewV6 bv;
+        BOOST_REQUIRE(bv.SwapInAndLoadBundle(bundleData));
+        BundleViewV6 custodySignalRfc5050RenderedBundleView;
+        BOOST_REQUIRE(ctmHdtn.ProcessCustodyOfBundle(bv, true, 200, BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION,
+            custodySignalRfc5050RenderedBundleView));
+    }
+    const boost::posix_time::ptime afterFillTime = boost::posix_time::microsec_clock::universal_time();
+    BOOST_REQUIRE(!ctmHdtn.HasFullAcs());
+    BOOST_REQUIRE(!ctmHdtn.IsAcsReadyToSend(startTime));
+    BOOST_REQUIRE(ctmHdtn.GenerateReadyAcsBundles(acsBundleList, startTime));
+    BOOST_REQUIRE_EQUAL(acsBundleList.size(), 0);
+    BOOST_REQUIRE_EQUAL(ctmHdtn.GetLargestNumberOfFills(), 1);
+    BOOST_REQUIRE(ctmHdtn.IsAcsReadyToSend(afterFillTime + boost::posix_time::seconds(10)));
+    BOOST_REQUIRE(ctmHdtn.GenerateReadyAcsBundles(acsBundleList, afterFillTime + boost::posix_time::seconds(10)));
+    BOOST_REQUIRE_EQUAL(acsBundleList.size(), 1);
+    BOOST_REQUIRE(ctmHdtn.GenerateReadyAcsBundles(acsBundleList, afterFillTime, true));
+    BOOST_REQUIRE_EQUAL(acsBundleList.size(), 0); //nothing left to send
+}
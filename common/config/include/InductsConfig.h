@@ -34,6 +34,11 @@ struct induct_element_config_t {
     uint16_t ltpRemoteUdpPort;
     uint64_t ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     uint64_t ltpMaxExpectedSimultaneousSessions;
+    uint64_t ltpRxSpillToDiskThresholdBytesOrZeroToDisable; //red parts larger than this are received into memory mapped files
+    std::string ltpRxSpillDirectory; //where the memory mapped files are created (empty => the system temp directory)
+    uint32_t ltpNumUdpRxSockets; //receive sockets (threads) sharing the bound udp port via SO_REUSEPORT (linux only, default 1)
+    bool ltpForwardGreenOnlyBundles; //deliver fully green blocks as bundles as soon as their EOB arrives (default false)
+    uint64_t ltpMemoryBudgetBytesOrZeroToDisable; //caps the bytes held by the ltp engine (sessions and queued segments), see LtpEngine::SetMemoryBudget
 
     //specific to stcp and tcpcl
     uint32_t keepAliveIntervalSeconds;
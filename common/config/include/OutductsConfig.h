@@ -19,6 +19,7 @@ struct outduct_element_config_t {
     std::string remoteHostname;
     uint16_t remotePort;
     uint32_t bundlePipelineLimit;
+    uint64_t bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable; //bpv7 bundles larger than this are proactively fragmented by egress
     std::set<std::string> finalDestinationEidUris;
     
 
@@ -35,6 +36,13 @@ struct outduct_element_config_t {
     uint32_t ltpRandomNumberSizeBits;
     uint16_t ltpSenderBoundPort;
     uint64_t ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    uint64_t ltpAggregationSizeThresholdBytesOrZeroToDisable; //bundles smaller than this are packed into one ltp block up to this size
+    uint64_t ltpAggregationTimeThresholdMilliseconds; //max time a bundle waits for its ltp block to fill
+    uint64_t ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable; //nonzero adapts the send rate (up to ltpMaxSendRateBitsPerSecOrZeroToDisable), checkpoint interval and timeout to observed rtt and loss
+    uint64_t ltpAdaptiveMinCheckpointEveryNthDataSegment;
+    uint64_t ltpAdaptiveMaxCheckpointEveryNthDataSegment;
+    uint64_t ltpAdaptiveMinCheckpointTimeoutMs;
+    uint64_t ltpMemoryBudgetBytesOrZeroToDisable; //caps the bytes held by the ltp engine (sessions and queued segments), see LtpEngine::SetMemoryBudget
 
     //specific to udp
     uint64_t udpRateBps;
@@ -50,6 +58,7 @@ struct outduct_element_config_t {
 
     //specific to tcpcl version 4 (clients)
     uint64_t tcpclV4MyMaxRxSegmentSizeBytes;
+    bool tcpclV4ReactiveFragmentation; //retain bundles until acked and resend only the unacked remainder after a session loss
     bool tryUseTls;
     bool tlsIsRequired;
     bool useTlsVersion1_3;
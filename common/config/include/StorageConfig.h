@@ -77,6 +77,9 @@ public:
     bool m_tryToRestoreFromDisk;
     bool m_autoDeleteFilesOnExit;
     uint64_t m_totalStorageCapacityBytes;
+    //when nonzero, every run of this many consecutive segment ids is stored contiguously on one disk
+    //(instead of striping each segment id round robin across the disks)
+    uint64_t m_diskExtentSizeSegmentsOrZeroToDisable;
     storage_disk_config_vector_t m_storageDiskConfigVector;
 };
 
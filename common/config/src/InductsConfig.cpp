@@ -32,6 +32,11 @@ induct_element_config_t::induct_element_config_t() :
     ltpRemoteUdpPort(0),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(0),
     ltpMaxExpectedSimultaneousSessions(0),
+    ltpRxSpillToDiskThresholdBytesOrZeroToDisable(0),
+    ltpRxSpillDirectory(""),
+    ltpNumUdpRxSockets(1),
+    ltpForwardGreenOnlyBundles(false),
+    ltpMemoryBudgetBytesOrZeroToDisable(0),
 
     keepAliveIntervalSeconds(0),
 
@@ -67,6 +72,11 @@ induct_element_config_t::induct_element_config_t(const induct_element_config_t&
     ltpRemoteUdpPort(o.ltpRemoteUdpPort),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
     ltpMaxExpectedSimultaneousSessions(o.ltpMaxExpectedSimultaneousSessions),
+    ltpRxSpillToDiskThresholdBytesOrZeroToDisable(o.ltpRxSpillToDiskThresholdBytesOrZeroToDisable),
+    ltpRxSpillDirectory(o.ltpRxSpillDirectory),
+    ltpNumUdpRxSockets(o.ltpNumUdpRxSockets),
+    ltpForwardGreenOnlyBundles(o.ltpForwardGreenOnlyBundles),
+    ltpMemoryBudgetBytesOrZeroToDisable(o.ltpMemoryBudgetBytesOrZeroToDisable),
 
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
@@ -99,6 +109,11 @@ induct_element_config_t::induct_element_config_t(induct_element_config_t&& o) :
     ltpRemoteUdpPort(o.ltpRemoteUdpPort),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
     ltpMaxExpectedSimultaneousSessions(o.ltpMaxExpectedSimultaneousSessions),
+    ltpRxSpillToDiskThresholdBytesOrZeroToDisable(o.ltpRxSpillToDiskThresholdBytesOrZeroToDisable),
+    ltpRxSpillDirectory(std::move(o.ltpRxSpillDirectory)),
+    ltpNumUdpRxSockets(o.ltpNumUdpRxSockets),
+    ltpForwardGreenOnlyBundles(o.ltpForwardGreenOnlyBundles),
+    ltpMemoryBudgetBytesOrZeroToDisable(o.ltpMemoryBudgetBytesOrZeroToDisable),
 
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
@@ -131,6 +146,11 @@ induct_element_config_t& induct_element_config_t::operator=(const induct_element
     ltpRemoteUdpPort = o.ltpRemoteUdpPort;
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     ltpMaxExpectedSimultaneousSessions = o.ltpMaxExpectedSimultaneousSessions;
+    ltpRxSpillToDiskThresholdBytesOrZeroToDisable = o.ltpRxSpillToDiskThresholdBytesOrZeroToDisable;
+    ltpRxSpillDirectory = o.ltpRxSpillDirectory;
+    ltpNumUdpRxSockets = o.ltpNumUdpRxSockets;
+    ltpForwardGreenOnlyBundles = o.ltpForwardGreenOnlyBundles;
+    ltpMemoryBudgetBytesOrZeroToDisable = o.ltpMemoryBudgetBytesOrZeroToDisable;
 
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
@@ -165,6 +185,11 @@ induct_element_config_t& induct_element_config_t::operator=(induct_element_confi
     ltpRemoteUdpPort = o.ltpRemoteUdpPort;
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     ltpMaxExpectedSimultaneousSessions = o.ltpMaxExpectedSimultaneousSessions;
+    ltpRxSpillToDiskThresholdBytesOrZeroToDisable = o.ltpRxSpillToDiskThresholdBytesOrZeroToDisable;
+    ltpRxSpillDirectory = std::move(o.ltpRxSpillDirectory);
+    ltpNumUdpRxSockets = o.ltpNumUdpRxSockets;
+    ltpForwardGreenOnlyBundles = o.ltpForwardGreenOnlyBundles;
+    ltpMemoryBudgetBytesOrZeroToDisable = o.ltpMemoryBudgetBytesOrZeroToDisable;
 
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
@@ -198,6 +223,11 @@ bool induct_element_config_t::operator==(const induct_element_config_t & o) cons
         (ltpRemoteUdpPort == o.ltpRemoteUdpPort) &&
         (ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize == o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize) &&
         (ltpMaxExpectedSimultaneousSessions == o.ltpMaxExpectedSimultaneousSessions) &&
+        (ltpRxSpillToDiskThresholdBytesOrZeroToDisable == o.ltpRxSpillToDiskThresholdBytesOrZeroToDisable) &&
+        (ltpRxSpillDirectory == o.ltpRxSpillDirectory) &&
+        (ltpNumUdpRxSockets == o.ltpNumUdpRxSockets) &&
+        (ltpForwardGreenOnlyBundles == o.ltpForwardGreenOnlyBundles) &&
+        (ltpMemoryBudgetBytesOrZeroToDisable == o.ltpMemoryBudgetBytesOrZeroToDisable) &&
 
         (keepAliveIntervalSeconds == o.keepAliveIntervalSeconds) &&
         
@@ -304,11 +334,21 @@ bool InductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 inductElementConfig.ltpRemoteUdpPort = inductElementConfigPt.second.get<uint16_t>("ltpRemoteUdpPort");
                 inductElementConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = inductElementConfigPt.second.get<uint64_t>("ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize");
                 inductElementConfig.ltpMaxExpectedSimultaneousSessions = inductElementConfigPt.second.get<uint64_t>("ltpMaxExpectedSimultaneousSessions");
+                inductElementConfig.ltpRxSpillToDiskThresholdBytesOrZeroToDisable = inductElementConfigPt.second.get<uint64_t>("ltpRxSpillToDiskThresholdBytesOrZeroToDisable", 0);
+                inductElementConfig.ltpRxSpillDirectory = inductElementConfigPt.second.get<std::string>("ltpRxSpillDirectory", "");
+                inductElementConfig.ltpNumUdpRxSockets = inductElementConfigPt.second.get<uint32_t>("ltpNumUdpRxSockets", 1);
+                if (inductElementConfig.ltpNumUdpRxSockets == 0) {
+                    std::cerr << "error parsing JSON inductVector[" << (vectorIndex - 1) << "]: ltpNumUdpRxSockets must be at least 1" << std::endl;
+                    return false;
+                }
+                inductElementConfig.ltpForwardGreenOnlyBundles = inductElementConfigPt.second.get<bool>("ltpForwardGreenOnlyBundles", false);
+                inductElementConfig.ltpMemoryBudgetBytesOrZeroToDisable = inductElementConfigPt.second.get<uint64_t>("ltpMemoryBudgetBytesOrZeroToDisable", 0);
             }
             else {
                 static const std::vector<std::string> LTP_ONLY_VALUES = { "thisLtpEngineId" , "remoteLtpEngineId", "ltpReportSegmentMtu", "oneWayLightTimeMs", "oneWayMarginTimeMs",
                     "clientServiceId", "preallocatedRedDataBytes", "ltpMaxRetriesPerSerialNumber", "ltpRandomNumberSizeBits", "ltpRemoteUdpHostname", "ltpRemoteUdpPort",
-                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize"
+                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", "ltpRxSpillToDiskThresholdBytesOrZeroToDisable", "ltpRxSpillDirectory",
+                    "ltpNumUdpRxSockets", "ltpForwardGreenOnlyBundles", "ltpMemoryBudgetBytesOrZeroToDisable"
                 };
                 for (std::size_t i = 0; i < LTP_ONLY_VALUES.size(); ++i) {
                     if (inductElementConfigPt.second.count(LTP_ONLY_VALUES[i]) != 0) {
@@ -429,6 +469,11 @@ boost::property_tree::ptree InductsConfig::GetNewPropertyTree() const {
             inductElementConfigPt.put("ltpRemoteUdpPort", inductElementConfig.ltpRemoteUdpPort);
             inductElementConfigPt.put("ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", inductElementConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize);
             inductElementConfigPt.put("ltpMaxExpectedSimultaneousSessions", inductElementConfig.ltpMaxExpectedSimultaneousSessions);
+            inductElementConfigPt.put("ltpRxSpillToDiskThresholdBytesOrZeroToDisable", inductElementConfig.ltpRxSpillToDiskThresholdBytesOrZeroToDisable);
+            inductElementConfigPt.put("ltpRxSpillDirectory", inductElementConfig.ltpRxSpillDirectory);
+            inductElementConfigPt.put("ltpNumUdpRxSockets", inductElementConfig.ltpNumUdpRxSockets);
+            inductElementConfigPt.put("ltpForwardGreenOnlyBundles", inductElementConfig.ltpForwardGreenOnlyBundles);
+            inductElementConfigPt.put("ltpMemoryBudgetBytesOrZeroToDisable", inductElementConfig.ltpMemoryBudgetBytesOrZeroToDisable);
         }
         if ((inductElementConfig.convergenceLayer == "stcp") || (inductElementConfig.convergenceLayer == "tcpcl_v3") || (inductElementConfig.convergenceLayer == "tcpcl_v4")) {
             inductElementConfigPt.put("keepAliveIntervalSeconds", inductElementConfig.keepAliveIntervalSeconds);
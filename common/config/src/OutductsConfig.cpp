@@ -21,6 +21,7 @@ outduct_element_config_t::outduct_element_config_t() :
     remoteHostname(""),
     remotePort(0),
     bundlePipelineLimit(0),
+    bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable(0),
     finalDestinationEidUris(),
     
     thisLtpEngineId(0),
@@ -35,6 +36,13 @@ outduct_element_config_t::outduct_element_config_t() :
     ltpRandomNumberSizeBits(0),
     ltpSenderBoundPort(0),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(0),
+    ltpAggregationSizeThresholdBytesOrZeroToDisable(0),
+    ltpAggregationTimeThresholdMilliseconds(0),
+    ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable(0),
+    ltpAdaptiveMinCheckpointEveryNthDataSegment(0),
+    ltpAdaptiveMaxCheckpointEveryNthDataSegment(0),
+    ltpAdaptiveMinCheckpointTimeoutMs(0),
+    ltpMemoryBudgetBytesOrZeroToDisable(0),
 
     udpRateBps(0),
 
@@ -43,6 +51,7 @@ outduct_element_config_t::outduct_element_config_t() :
     tcpclAllowOpportunisticReceiveBundles(true),
 
     tcpclV4MyMaxRxSegmentSizeBytes(0),
+    tcpclV4ReactiveFragmentation(false),
     tryUseTls(false),
     tlsIsRequired(false),
     useTlsVersion1_3(false),
@@ -61,6 +70,7 @@ outduct_element_config_t::outduct_element_config_t(const outduct_element_config_
     remoteHostname(o.remoteHostname),
     remotePort(o.remotePort),
     bundlePipelineLimit(o.bundlePipelineLimit),
+    bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable(o.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable),
     finalDestinationEidUris(o.finalDestinationEidUris),
     
     thisLtpEngineId(o.thisLtpEngineId),
@@ -75,6 +85,13 @@ outduct_element_config_t::outduct_element_config_t(const outduct_element_config_
     ltpRandomNumberSizeBits(o.ltpRandomNumberSizeBits),
     ltpSenderBoundPort(o.ltpSenderBoundPort),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(o.ltpMaxSendRateBitsPerSecOrZeroToDisable),
+    ltpAggregationSizeThresholdBytesOrZeroToDisable(o.ltpAggregationSizeThresholdBytesOrZeroToDisable),
+    ltpAggregationTimeThresholdMilliseconds(o.ltpAggregationTimeThresholdMilliseconds),
+    ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable(o.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable),
+    ltpAdaptiveMinCheckpointEveryNthDataSegment(o.ltpAdaptiveMinCheckpointEveryNthDataSegment),
+    ltpAdaptiveMaxCheckpointEveryNthDataSegment(o.ltpAdaptiveMaxCheckpointEveryNthDataSegment),
+    ltpAdaptiveMinCheckpointTimeoutMs(o.ltpAdaptiveMinCheckpointTimeoutMs),
+    ltpMemoryBudgetBytesOrZeroToDisable(o.ltpMemoryBudgetBytesOrZeroToDisable),
 
     udpRateBps(o.udpRateBps),
 
@@ -83,6 +100,7 @@ outduct_element_config_t::outduct_element_config_t(const outduct_element_config_
     tcpclAllowOpportunisticReceiveBundles(o.tcpclAllowOpportunisticReceiveBundles),
 
     tcpclV4MyMaxRxSegmentSizeBytes(o.tcpclV4MyMaxRxSegmentSizeBytes),
+    tcpclV4ReactiveFragmentation(o.tcpclV4ReactiveFragmentation),
     tryUseTls(o.tryUseTls),
     tlsIsRequired(o.tlsIsRequired),
     useTlsVersion1_3(o.useTlsVersion1_3),
@@ -98,6 +116,7 @@ outduct_element_config_t::outduct_element_config_t(outduct_element_config_t&& o)
     remoteHostname(std::move(o.remoteHostname)),
     remotePort(o.remotePort),
     bundlePipelineLimit(o.bundlePipelineLimit),
+    bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable(o.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable),
     finalDestinationEidUris(std::move(o.finalDestinationEidUris)),
     
     thisLtpEngineId(o.thisLtpEngineId),
@@ -112,6 +131,13 @@ outduct_element_config_t::outduct_element_config_t(outduct_element_config_t&& o)
     ltpRandomNumberSizeBits(o.ltpRandomNumberSizeBits),
     ltpSenderBoundPort(o.ltpSenderBoundPort),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(o.ltpMaxSendRateBitsPerSecOrZeroToDisable),
+    ltpAggregationSizeThresholdBytesOrZeroToDisable(o.ltpAggregationSizeThresholdBytesOrZeroToDisable),
+    ltpAggregationTimeThresholdMilliseconds(o.ltpAggregationTimeThresholdMilliseconds),
+    ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable(o.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable),
+    ltpAdaptiveMinCheckpointEveryNthDataSegment(o.ltpAdaptiveMinCheckpointEveryNthDataSegment),
+    ltpAdaptiveMaxCheckpointEveryNthDataSegment(o.ltpAdaptiveMaxCheckpointEveryNthDataSegment),
+    ltpAdaptiveMinCheckpointTimeoutMs(o.ltpAdaptiveMinCheckpointTimeoutMs),
+    ltpMemoryBudgetBytesOrZeroToDisable(o.ltpMemoryBudgetBytesOrZeroToDisable),
 
     udpRateBps(o.udpRateBps),
 
@@ -120,6 +146,7 @@ outduct_element_config_t::outduct_element_config_t(outduct_element_config_t&& o)
     tcpclAllowOpportunisticReceiveBundles(o.tcpclAllowOpportunisticReceiveBundles),
 
     tcpclV4MyMaxRxSegmentSizeBytes(o.tcpclV4MyMaxRxSegmentSizeBytes),
+    tcpclV4ReactiveFragmentation(o.tcpclV4ReactiveFragmentation),
     tryUseTls(o.tryUseTls),
     tlsIsRequired(o.tlsIsRequired),
     useTlsVersion1_3(o.useTlsVersion1_3),
@@ -135,6 +162,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(const outduct_elem
     remoteHostname = o.remoteHostname;
     remotePort = o.remotePort;
     bundlePipelineLimit = o.bundlePipelineLimit;
+    bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable = o.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable;
     finalDestinationEidUris = o.finalDestinationEidUris;
     
     thisLtpEngineId = o.thisLtpEngineId;
@@ -149,6 +177,13 @@ outduct_element_config_t& outduct_element_config_t::operator=(const outduct_elem
     ltpRandomNumberSizeBits = o.ltpRandomNumberSizeBits;
     ltpSenderBoundPort = o.ltpSenderBoundPort;
     ltpMaxSendRateBitsPerSecOrZeroToDisable = o.ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    ltpAggregationSizeThresholdBytesOrZeroToDisable = o.ltpAggregationSizeThresholdBytesOrZeroToDisable;
+    ltpAggregationTimeThresholdMilliseconds = o.ltpAggregationTimeThresholdMilliseconds;
+    ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable = o.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable;
+    ltpAdaptiveMinCheckpointEveryNthDataSegment = o.ltpAdaptiveMinCheckpointEveryNthDataSegment;
+    ltpAdaptiveMaxCheckpointEveryNthDataSegment = o.ltpAdaptiveMaxCheckpointEveryNthDataSegment;
+    ltpAdaptiveMinCheckpointTimeoutMs = o.ltpAdaptiveMinCheckpointTimeoutMs;
+    ltpMemoryBudgetBytesOrZeroToDisable = o.ltpMemoryBudgetBytesOrZeroToDisable;
 
     udpRateBps = o.udpRateBps;
 
@@ -158,6 +193,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(const outduct_elem
     tcpclAllowOpportunisticReceiveBundles = o.tcpclAllowOpportunisticReceiveBundles;
 
     tcpclV4MyMaxRxSegmentSizeBytes = o.tcpclV4MyMaxRxSegmentSizeBytes;
+    tcpclV4ReactiveFragmentation = o.tcpclV4ReactiveFragmentation;
     tryUseTls = o.tryUseTls;
     tlsIsRequired = o.tlsIsRequired;
     useTlsVersion1_3 = o.useTlsVersion1_3;
@@ -175,6 +211,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(outduct_element_co
     remoteHostname = std::move(o.remoteHostname);
     remotePort = o.remotePort;
     bundlePipelineLimit = o.bundlePipelineLimit;
+    bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable = o.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable;
     finalDestinationEidUris = std::move(o.finalDestinationEidUris);
 
     thisLtpEngineId = o.thisLtpEngineId;
@@ -189,6 +226,13 @@ outduct_element_config_t& outduct_element_config_t::operator=(outduct_element_co
     ltpRandomNumberSizeBits = o.ltpRandomNumberSizeBits;
     ltpSenderBoundPort = o.ltpSenderBoundPort;
     ltpMaxSendRateBitsPerSecOrZeroToDisable = o.ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    ltpAggregationSizeThresholdBytesOrZeroToDisable = o.ltpAggregationSizeThresholdBytesOrZeroToDisable;
+    ltpAggregationTimeThresholdMilliseconds = o.ltpAggregationTimeThresholdMilliseconds;
+    ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable = o.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable;
+    ltpAdaptiveMinCheckpointEveryNthDataSegment = o.ltpAdaptiveMinCheckpointEveryNthDataSegment;
+    ltpAdaptiveMaxCheckpointEveryNthDataSegment = o.ltpAdaptiveMaxCheckpointEveryNthDataSegment;
+    ltpAdaptiveMinCheckpointTimeoutMs = o.ltpAdaptiveMinCheckpointTimeoutMs;
+    ltpMemoryBudgetBytesOrZeroToDisable = o.ltpMemoryBudgetBytesOrZeroToDisable;
 
     udpRateBps = o.udpRateBps;
 
@@ -198,6 +242,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(outduct_element_co
     tcpclAllowOpportunisticReceiveBundles = o.tcpclAllowOpportunisticReceiveBundles;
 
     tcpclV4MyMaxRxSegmentSizeBytes = o.tcpclV4MyMaxRxSegmentSizeBytes;
+    tcpclV4ReactiveFragmentation = o.tcpclV4ReactiveFragmentation;
     tryUseTls = o.tryUseTls;
     tlsIsRequired = o.tlsIsRequired;
     useTlsVersion1_3 = o.useTlsVersion1_3;
@@ -214,6 +259,7 @@ bool outduct_element_config_t::operator==(const outduct_element_config_t & o) co
         (remoteHostname == o.remoteHostname) &&
         (remotePort == o.remotePort) &&
         (bundlePipelineLimit == o.bundlePipelineLimit) &&
+        (bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable == o.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable) &&
         (finalDestinationEidUris == o.finalDestinationEidUris) &&
         
         (thisLtpEngineId == o.thisLtpEngineId) &&
@@ -228,6 +274,13 @@ bool outduct_element_config_t::operator==(const outduct_element_config_t & o) co
         (ltpRandomNumberSizeBits == o.ltpRandomNumberSizeBits) &&
         (ltpSenderBoundPort == o.ltpSenderBoundPort) &&
         (ltpMaxSendRateBitsPerSecOrZeroToDisable == o.ltpMaxSendRateBitsPerSecOrZeroToDisable) &&
+        (ltpAggregationSizeThresholdBytesOrZeroToDisable == o.ltpAggregationSizeThresholdBytesOrZeroToDisable) &&
+        (ltpAggregationTimeThresholdMilliseconds == o.ltpAggregationTimeThresholdMilliseconds) &&
+        (ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable == o.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable) &&
+        (ltpAdaptiveMinCheckpointEveryNthDataSegment == o.ltpAdaptiveMinCheckpointEveryNthDataSegment) &&
+        (ltpAdaptiveMaxCheckpointEveryNthDataSegment == o.ltpAdaptiveMaxCheckpointEveryNthDataSegment) &&
+        (ltpAdaptiveMinCheckpointTimeoutMs == o.ltpAdaptiveMinCheckpointTimeoutMs) &&
+        (ltpMemoryBudgetBytesOrZeroToDisable == o.ltpMemoryBudgetBytesOrZeroToDisable) &&
 
         (udpRateBps == o.udpRateBps) &&
 
@@ -237,6 +290,7 @@ bool outduct_element_config_t::operator==(const outduct_element_config_t & o) co
         (tcpclAllowOpportunisticReceiveBundles == o.tcpclAllowOpportunisticReceiveBundles) &&
         
         (tcpclV4MyMaxRxSegmentSizeBytes == o.tcpclV4MyMaxRxSegmentSizeBytes) &&
+        (tcpclV4ReactiveFragmentation == o.tcpclV4ReactiveFragmentation) &&
         (tryUseTls == o.tryUseTls) &&
         (tlsIsRequired == o.tlsIsRequired) &&
         (useTlsVersion1_3 == o.useTlsVersion1_3) &&
@@ -316,6 +370,8 @@ bool OutductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 return false;
             }
             outductElementConfig.bundlePipelineLimit = outductElementConfigPt.second.get<uint32_t>("bundlePipelineLimit");
+            //optional (fragmentation disabled if not present)
+            outductElementConfig.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable", 0);
             const boost::property_tree::ptree & finalDestinationEidUrisPt = outductElementConfigPt.second.get_child("finalDestinationEidUris", boost::property_tree::ptree()); //non-throw version
             outductElementConfig.finalDestinationEidUris.clear();
             BOOST_FOREACH(const boost::property_tree::ptree::value_type & finalDestinationEidUriValuePt, finalDestinationEidUrisPt) {
@@ -349,10 +405,38 @@ bool OutductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 }
                 outductElementConfig.ltpSenderBoundPort = outductElementConfigPt.second.get<uint16_t>("ltpSenderBoundPort");
                 outductElementConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("ltpMaxSendRateBitsPerSecOrZeroToDisable");
+                //optional (aggregation disabled if not present) so that existing config files remain valid
+                outductElementConfig.ltpAggregationSizeThresholdBytesOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("ltpAggregationSizeThresholdBytesOrZeroToDisable", 0);
+                outductElementConfig.ltpAggregationTimeThresholdMilliseconds = outductElementConfigPt.second.get<uint64_t>("ltpAggregationTimeThresholdMilliseconds", 0);
+                if (outductElementConfig.ltpAggregationSizeThresholdBytesOrZeroToDisable && (outductElementConfig.ltpAggregationTimeThresholdMilliseconds == 0)) {
+                    std::cerr << "error parsing JSON outductVector[" << (vectorIndex - 1) << "]: " << "ltpAggregationTimeThresholdMilliseconds must be non-zero when ltp aggregation is enabled" << std::endl;
+                    return false;
+                }
+                //optional (adaptive rate and checkpointing disabled if not present)
+                outductElementConfig.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable", 0);
+                outductElementConfig.ltpAdaptiveMinCheckpointEveryNthDataSegment = outductElementConfigPt.second.get<uint64_t>("ltpAdaptiveMinCheckpointEveryNthDataSegment", 0);
+                outductElementConfig.ltpAdaptiveMaxCheckpointEveryNthDataSegment = outductElementConfigPt.second.get<uint64_t>("ltpAdaptiveMaxCheckpointEveryNthDataSegment", 0);
+                outductElementConfig.ltpAdaptiveMinCheckpointTimeoutMs = outductElementConfigPt.second.get<uint64_t>("ltpAdaptiveMinCheckpointTimeoutMs", 0);
+                outductElementConfig.ltpMemoryBudgetBytesOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("ltpMemoryBudgetBytesOrZeroToDisable", 0);
+                if (outductElementConfig.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable) {
+                    if (outductElementConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable < outductElementConfig.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable) {
+                        std::cerr << "error parsing JSON outductVector[" << (vectorIndex - 1) << "]: " << "ltpMaxSendRateBitsPerSecOrZeroToDisable must be non-zero and at least ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable when ltp adaptive mode is enabled" << std::endl;
+                        return false;
+                    }
+                    if ((outductElementConfig.ltpAdaptiveMinCheckpointEveryNthDataSegment == 0)
+                        || (outductElementConfig.ltpAdaptiveMinCheckpointEveryNthDataSegment > outductElementConfig.ltpAdaptiveMaxCheckpointEveryNthDataSegment))
+                    {
+                        std::cerr << "error parsing JSON outductVector[" << (vectorIndex - 1) << "]: " << "ltpAdaptiveMinCheckpointEveryNthDataSegment and ltpAdaptiveMaxCheckpointEveryNthDataSegment must satisfy 1 <= min <= max when ltp adaptive mode is enabled" << std::endl;
+                        return false;
+                    }
+                }
             }
             else {
                 static const std::vector<std::string> LTP_ONLY_VALUES = { "thisLtpEngineId" , "remoteLtpEngineId", "ltpDataSegmentMtu", "oneWayLightTimeMs", "oneWayMarginTimeMs",
-                    "clientServiceId", "numRxCircularBufferElements", "ltpMaxRetriesPerSerialNumber", "ltpCheckpointEveryNthDataSegment", "ltpRandomNumberSizeBits", "ltpSenderBoundPort"
+                    "clientServiceId", "numRxCircularBufferElements", "ltpMaxRetriesPerSerialNumber", "ltpCheckpointEveryNthDataSegment", "ltpRandomNumberSizeBits", "ltpSenderBoundPort",
+                    "ltpAggregationSizeThresholdBytesOrZeroToDisable", "ltpAggregationTimeThresholdMilliseconds",
+                    "ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable", "ltpAdaptiveMinCheckpointEveryNthDataSegment", "ltpAdaptiveMaxCheckpointEveryNthDataSegment", "ltpAdaptiveMinCheckpointTimeoutMs",
+                    "ltpMemoryBudgetBytesOrZeroToDisable"
                 };
                 for (std::size_t i = 0; i < LTP_ONLY_VALUES.size(); ++i) {
                     if (outductElementConfigPt.second.count(LTP_ONLY_VALUES[i]) != 0) {
@@ -401,6 +485,7 @@ bool OutductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
 
             if (outductElementConfig.convergenceLayer == "tcpcl_v4") {
                 outductElementConfig.tcpclV4MyMaxRxSegmentSizeBytes = outductElementConfigPt.second.get<uint64_t>("tcpclV4MyMaxRxSegmentSizeBytes");
+                outductElementConfig.tcpclV4ReactiveFragmentation = outductElementConfigPt.second.get<bool>("tcpclV4ReactiveFragmentation", false); //optional (disabled if not present)
                 outductElementConfig.tryUseTls = outductElementConfigPt.second.get<bool>("tryUseTls");
                 outductElementConfig.tlsIsRequired = outductElementConfigPt.second.get<bool>("tlsIsRequired");
                 outductElementConfig.useTlsVersion1_3 = outductElementConfigPt.second.get<bool>("useTlsVersion1_3");
@@ -410,7 +495,7 @@ bool OutductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
             }
             else {
                 static const std::vector<std::string> VALID_TCPCL_V4_OUTDUCT_PARAMETERS = { 
-                    "tcpclV4MyMaxRxSegmentSizeBytes", "tryUseTls", "tlsIsRequired", "useTlsVersion1_3",
+                    "tcpclV4MyMaxRxSegmentSizeBytes", "tcpclV4ReactiveFragmentation", "tryUseTls", "tlsIsRequired", "useTlsVersion1_3",
                     "doX509CertificateVerification", "verifySubjectAltNameInX509Certificate", "certificationAuthorityPemFileForVerification" };
                 
                 for (std::vector<std::string>::const_iterator it = VALID_TCPCL_V4_OUTDUCT_PARAMETERS.cbegin(); it != VALID_TCPCL_V4_OUTDUCT_PARAMETERS.cend(); ++it) {
@@ -477,6 +562,7 @@ boost::property_tree::ptree OutductsConfig::GetNewPropertyTree() const {
         outductElementConfigPt.put("remoteHostname", outductElementConfig.remoteHostname);
         outductElementConfigPt.put("remotePort", outductElementConfig.remotePort);
         outductElementConfigPt.put("bundlePipelineLimit", outductElementConfig.bundlePipelineLimit);
+        outductElementConfigPt.put("bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable", outductElementConfig.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable);
         boost::property_tree::ptree & finalDestinationEidUrisPt = outductElementConfigPt.put_child("finalDestinationEidUris", outductElementConfig.finalDestinationEidUris.empty() ? boost::property_tree::ptree("[]") : boost::property_tree::ptree());
         for (std::set<std::string>::const_iterator finalDestinationEidUriIt = outductElementConfig.finalDestinationEidUris.cbegin(); finalDestinationEidUriIt != outductElementConfig.finalDestinationEidUris.cend(); ++finalDestinationEidUriIt) {
             finalDestinationEidUrisPt.push_back(std::make_pair("", boost::property_tree::ptree(*finalDestinationEidUriIt))); //using "" as key creates json array
@@ -495,6 +581,13 @@ boost::property_tree::ptree OutductsConfig::GetNewPropertyTree() const {
             outductElementConfigPt.put("ltpRandomNumberSizeBits", outductElementConfig.ltpRandomNumberSizeBits);
             outductElementConfigPt.put("ltpSenderBoundPort", outductElementConfig.ltpSenderBoundPort);
             outductElementConfigPt.put("ltpMaxSendRateBitsPerSecOrZeroToDisable", outductElementConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable);
+            outductElementConfigPt.put("ltpAggregationSizeThresholdBytesOrZeroToDisable", outductElementConfig.ltpAggregationSizeThresholdBytesOrZeroToDisable);
+            outductElementConfigPt.put("ltpAggregationTimeThresholdMilliseconds", outductElementConfig.ltpAggregationTimeThresholdMilliseconds);
+            outductElementConfigPt.put("ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable", outductElementConfig.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable);
+            outductElementConfigPt.put("ltpAdaptiveMinCheckpointEveryNthDataSegment", outductElementConfig.ltpAdaptiveMinCheckpointEveryNthDataSegment);
+            outductElementConfigPt.put("ltpAdaptiveMaxCheckpointEveryNthDataSegment", outductElementConfig.ltpAdaptiveMaxCheckpointEveryNthDataSegment);
+            outductElementConfigPt.put("ltpAdaptiveMinCheckpointTimeoutMs", outductElementConfig.ltpAdaptiveMinCheckpointTimeoutMs);
+            outductElementConfigPt.put("ltpMemoryBudgetBytesOrZeroToDisable", outductElementConfig.ltpMemoryBudgetBytesOrZeroToDisable);
         }
         if (outductElementConfig.convergenceLayer == "udp") {
             outductElementConfigPt.put("udpRateBps", outductElementConfig.udpRateBps);
@@ -510,6 +603,7 @@ boost::property_tree::ptree OutductsConfig::GetNewPropertyTree() const {
         }
         if (outductElementConfig.convergenceLayer == "tcpcl_v4") {
             outductElementConfigPt.put("tcpclV4MyMaxRxSegmentSizeBytes", outductElementConfig.tcpclV4MyMaxRxSegmentSizeBytes);
+            outductElementConfigPt.put("tcpclV4ReactiveFragmentation", outductElementConfig.tcpclV4ReactiveFragmentation);
             outductElementConfigPt.put("tryUseTls", outductElementConfig.tryUseTls);
             outductElementConfigPt.put("tlsIsRequired", outductElementConfig.tlsIsRequired);
             outductElementConfigPt.put("useTlsVersion1_3", outductElementConfig.useTlsVersion1_3);
@@ -49,6 +49,7 @@ StorageConfig::StorageConfig() :
     m_tryToRestoreFromDisk(false),
     m_autoDeleteFilesOnExit(true),
     m_totalStorageCapacityBytes(1),
+    m_diskExtentSizeSegmentsOrZeroToDisable(0),
     m_storageDiskConfigVector() { }
 
 StorageConfig::~StorageConfig() {
@@ -60,6 +61,7 @@ StorageConfig::StorageConfig(const StorageConfig& o) :
     m_tryToRestoreFromDisk(o.m_tryToRestoreFromDisk),
     m_autoDeleteFilesOnExit(o.m_autoDeleteFilesOnExit),
     m_totalStorageCapacityBytes(o.m_totalStorageCapacityBytes),
+    m_diskExtentSizeSegmentsOrZeroToDisable(o.m_diskExtentSizeSegmentsOrZeroToDisable),
     m_storageDiskConfigVector(o.m_storageDiskConfigVector) { }
 
 //a move constructor: X(X&&)
@@ -68,6 +70,7 @@ StorageConfig::StorageConfig(StorageConfig&& o) :
     m_tryToRestoreFromDisk(o.m_tryToRestoreFromDisk),
     m_autoDeleteFilesOnExit(o.m_autoDeleteFilesOnExit),
     m_totalStorageCapacityBytes(o.m_totalStorageCapacityBytes),
+    m_diskExtentSizeSegmentsOrZeroToDisable(o.m_diskExtentSizeSegmentsOrZeroToDisable),
     m_storageDiskConfigVector(std::move(o.m_storageDiskConfigVector)) { }
 
 //a copy assignment: operator=(const X&)
@@ -76,6 +79,7 @@ StorageConfig& StorageConfig::operator=(const StorageConfig& o) {
     m_tryToRestoreFromDisk = o.m_tryToRestoreFromDisk;
     m_autoDeleteFilesOnExit = o.m_autoDeleteFilesOnExit;
     m_totalStorageCapacityBytes = o.m_totalStorageCapacityBytes;
+    m_diskExtentSizeSegmentsOrZeroToDisable = o.m_diskExtentSizeSegmentsOrZeroToDisable;
     m_storageDiskConfigVector = o.m_storageDiskConfigVector;
     return *this;
 }
@@ -86,6 +90,7 @@ StorageConfig& StorageConfig::operator=(StorageConfig&& o) {
     m_tryToRestoreFromDisk = o.m_tryToRestoreFromDisk;
     m_autoDeleteFilesOnExit = o.m_autoDeleteFilesOnExit;
     m_totalStorageCapacityBytes = o.m_totalStorageCapacityBytes;
+    m_diskExtentSizeSegmentsOrZeroToDisable = o.m_diskExtentSizeSegmentsOrZeroToDisable;
     m_storageDiskConfigVector = std::move(o.m_storageDiskConfigVector);
     return *this;
 }
@@ -96,6 +101,7 @@ bool StorageConfig::operator==(const StorageConfig & other) const {
         (m_tryToRestoreFromDisk == other.m_tryToRestoreFromDisk) &&
         (m_autoDeleteFilesOnExit == other.m_autoDeleteFilesOnExit) &&
         (m_totalStorageCapacityBytes == other.m_totalStorageCapacityBytes) &&
+        (m_diskExtentSizeSegmentsOrZeroToDisable == other.m_diskExtentSizeSegmentsOrZeroToDisable) &&
         (m_storageDiskConfigVector == other.m_storageDiskConfigVector);
 }
 
@@ -118,6 +124,7 @@ bool StorageConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
         m_tryToRestoreFromDisk = pt.get<bool>("tryToRestoreFromDisk");
         m_autoDeleteFilesOnExit = pt.get<bool>("autoDeleteFilesOnExit");
         m_totalStorageCapacityBytes = pt.get<uint64_t>("totalStorageCapacityBytes");
+        m_diskExtentSizeSegmentsOrZeroToDisable = pt.get<uint64_t>("diskExtentSizeSegmentsOrZeroToDisable", 0); //non-throw version
     }
     catch (const boost::property_tree::ptree_error & e) {
         std::cerr << "error parsing JSON Storage config: " << e.what() << std::endl;
@@ -191,6 +198,7 @@ boost::property_tree::ptree StorageConfig::GetNewPropertyTree() const {
     pt.put("tryToRestoreFromDisk", m_tryToRestoreFromDisk);
     pt.put("autoDeleteFilesOnExit", m_autoDeleteFilesOnExit);
     pt.put("totalStorageCapacityBytes", m_totalStorageCapacityBytes);
+    pt.put("diskExtentSizeSegmentsOrZeroToDisable", m_diskExtentSizeSegmentsOrZeroToDisable);
     boost::property_tree::ptree & storageDiskConfigVectorPt = pt.put_child("storageDiskConfigVector", m_storageDiskConfigVector.empty() ? boost::property_tree::ptree("[]") : boost::property_tree::ptree());
     for (storage_disk_config_vector_t::const_iterator storageDiskConfigVectorIt = m_storageDiskConfigVector.cbegin(); storageDiskConfigVectorIt != m_storageDiskConfigVector.cend(); ++storageDiskConfigVectorIt) {
         const storage_disk_config_t & storageDiskConfig = *storageDiskConfigVectorIt;
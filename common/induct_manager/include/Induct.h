@@ -23,6 +23,8 @@
 
 class Induct;
 typedef boost::function<void(padded_vector_uint8_t & movableBundle)> InductProcessBundleCallback_t;
+//a bundle within a zmq message padded like a padded_vector_uint8_t (currently only LTP inducts spilling red parts to disk deliver these)
+typedef boost::function<void(std::unique_ptr<zmq::message_t> & movablePaddedBundleZmq)> InductProcessPaddedZmqBundleCallback_t;
 typedef boost::function<void(const uint64_t remoteNodeId, Induct* thisInductPtr)> OnNewOpportunisticLinkCallback_t;
 typedef boost::function<void(const uint64_t remoteNodeId)> OnDeletedOpportunisticLinkCallback_t;
 
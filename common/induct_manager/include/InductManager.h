@@ -10,7 +10,8 @@ public:
     INDUCT_MANAGER_LIB_EXPORT ~InductManager();
     INDUCT_MANAGER_LIB_EXPORT void LoadInductsFromConfig(const InductProcessBundleCallback_t & inductProcessBundleCallback, const InductsConfig & inductsConfig,
         const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
-        const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback);
+        const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback,
+        const InductProcessPaddedZmqBundleCallback_t & inductProcessPaddedZmqBundleCallback = InductProcessPaddedZmqBundleCallback_t());
     INDUCT_MANAGER_LIB_EXPORT void Clear();
 public:
 
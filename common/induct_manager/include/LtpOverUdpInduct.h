@@ -7,7 +7,8 @@
 
 class CLASS_VISIBILITY_INDUCT_MANAGER_LIB LtpOverUdpInduct : public Induct {
 public:
-    INDUCT_MANAGER_LIB_EXPORT LtpOverUdpInduct(const InductProcessBundleCallback_t & inductProcessBundleCallback, const induct_element_config_t & inductConfig, const uint64_t maxBundleSizeBytes);
+    INDUCT_MANAGER_LIB_EXPORT LtpOverUdpInduct(const InductProcessBundleCallback_t & inductProcessBundleCallback, const induct_element_config_t & inductConfig, const uint64_t maxBundleSizeBytes,
+        const InductProcessPaddedZmqBundleCallback_t & inductProcessPaddedZmqBundleCallback = InductProcessPaddedZmqBundleCallback_t());
     INDUCT_MANAGER_LIB_EXPORT virtual ~LtpOverUdpInduct();
     
 private:
@@ -4,7 +4,8 @@
 #include <boost/make_shared.hpp>
 
 
-LtpOverUdpInduct::LtpOverUdpInduct(const InductProcessBundleCallback_t & inductProcessBundleCallback, const induct_element_config_t & inductConfig, const uint64_t maxBundleSizeBytes) :
+LtpOverUdpInduct::LtpOverUdpInduct(const InductProcessBundleCallback_t & inductProcessBundleCallback, const induct_element_config_t & inductConfig, const uint64_t maxBundleSizeBytes,
+    const InductProcessPaddedZmqBundleCallback_t & inductProcessPaddedZmqBundleCallback) :
     Induct(inductProcessBundleCallback, inductConfig)
 {
     m_ltpBundleSinkPtr = boost::make_unique<LtpBundleSink>(
@@ -14,7 +15,9 @@ LtpOverUdpInduct::LtpOverUdpInduct(const InductProcessBundleCallback_t & inductP
         inductConfig.boundPort, inductConfig.numRxCircularBufferElements,
         inductConfig.preallocatedRedDataBytes, inductConfig.ltpMaxRetriesPerSerialNumber,
         (inductConfig.ltpRandomNumberSizeBits == 32), inductConfig.ltpRemoteUdpHostname, inductConfig.ltpRemoteUdpPort, maxBundleSizeBytes,
-        inductConfig.ltpMaxExpectedSimultaneousSessions, inductConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize);
+        inductConfig.ltpMaxExpectedSimultaneousSessions, inductConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize,
+        inductConfig.ltpRxSpillToDiskThresholdBytesOrZeroToDisable, inductConfig.ltpRxSpillDirectory, inductConfig.ltpNumUdpRxSockets,
+        inductConfig.ltpForwardGreenOnlyBundles, inductConfig.ltpMemoryBudgetBytesOrZeroToDisable, inductProcessPaddedZmqBundleCallback);
 
 }
 LtpOverUdpInduct::~LtpOverUdpInduct() {
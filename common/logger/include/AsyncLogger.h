@@ -0,0 +1,199 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ***************************************************************************
+ */
+
+#ifndef _HDTN_ASYNC_LOGGER_H
+#define _HDTN_ASYNC_LOGGER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <type_traits>
+#include <boost/function.hpp>
+#include "Logger.h"
+#include "log_lib_export.h"
+
+/*
+AsyncLogger is the hot path companion to hdtn::Logger.
+
+A call to one of the HDTN_LOG_* macros below:
+1.) costs one relaxed atomic load and a branch when the severity is filtered out (the arguments are not evaluated),
+2.) otherwise copies the format string pointer and the typed arguments (integers, floating point, bools, chars,
+    and strings which are truncated to fit) into a fixed size record in a lock-free per-thread ring buffer.
+    Nothing is formatted and nothing is allocated on the calling thread (except the thread's ring buffer on its first log).
+3.) A single background flusher thread drains every thread's ring buffer, substitutes each "{}" in the format
+    string with the next argument, and writes the message to std::cout (info and notification), std::cerr (warning and above),
+    and/or the hdtn::Logger (Boost.Log) files.
+If a thread's ring buffer is full, the message is dropped (the caller never blocks) and the drop count is reported by the flusher.
+
+The format string and the module name must be string literals (or otherwise outlive the flush).
+
+The HDTN_LOG_*_RATE_LIMITED macros add a per call site limit of maxPerSecond messages; the number of messages suppressed
+at that call site is appended to the next message allowed through.
+
+Example:
+    HDTN_LOG_ERROR("ingress", "error in Ingress::Process: received bundle size ({}) exceeds max bundle size ({})", size, maxSize);
+    HDTN_LOG_WARNING_RATE_LIMITED(10, "egress", "egress can't send telemetry to gui");
+*/
+
+namespace hdtn{
+
+class LogRateLimiter {
+public:
+    LOG_LIB_EXPORT LogRateLimiter(const uint32_t maxPerSecond);
+    //returns true if the message may be logged, in which case numSuppressedSinceLastAllowed is set
+    LOG_LIB_EXPORT bool Allow(uint32_t & numSuppressedSinceLastAllowed);
+private:
+    const uint32_t M_MAX_PER_SECOND;
+    std::atomic<uint64_t> m_windowStartMilliseconds;
+    std::atomic<uint32_t> m_numAllowedInWindow;
+    std::atomic<uint32_t> m_numSuppressed;
+};
+
+class AsyncLogger {
+public:
+    static constexpr unsigned int MAX_ARGS = 8;
+    static constexpr unsigned int STRING_STORAGE_SIZE = 152;
+    static constexpr unsigned int RECORDS_PER_THREAD = 512;
+
+    enum class ArgType : uint8_t {
+        INT64 = 0,
+        UINT64,
+        DOUBLE,
+        BOOL,
+        CHAR,
+        STRING //value is (offset << 32) | length into stringStorage
+    };
+
+    //fixed size so that a record never allocates
+    struct Record {
+        const char * format;
+        const char * module;
+        uint32_t numSuppressed; //by the call site's LogRateLimiter before this record
+        uint8_t severity;
+        uint8_t numArgs;
+        uint8_t stringStorageUsed;
+        ArgType argTypes[MAX_ARGS];
+        union Value {
+            int64_t i;
+            uint64_t u;
+            double d;
+        } argValues[MAX_ARGS];
+        char stringStorage[STRING_STORAGE_SIZE];
+    };
+
+    typedef boost::function<void(hdtn::severity_level level, const char * module, const std::string & message)> output_function_t;
+
+    static bool IsEnabled(const hdtn::severity_level level) {
+        return static_cast<int>(level) >= s_minimumSeverity.load(std::memory_order_relaxed);
+    }
+    LOG_LIB_EXPORT static void SetMinimumSeverity(const hdtn::severity_level level);
+    LOG_LIB_EXPORT static void SetOutputToConsole(const bool enabled);
+    LOG_LIB_EXPORT static void SetOutputToLogFiles(const bool enabled);
+    //replaces the console and log file outputs (i.e. for unit tests); pass an empty function to restore them
+    LOG_LIB_EXPORT static void SetOutputFunction(const output_function_t & outputFunction);
+    //blocks until every record logged (by any thread) before this call has been output
+    LOG_LIB_EXPORT static void Flush();
+    LOG_LIB_EXPORT static uint64_t GetNumDropped();
+
+    template <typename... Args>
+    static void Log(const hdtn::severity_level level, const char * module, const uint32_t numSuppressed, const char * format, const Args & ... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "too many arguments to HDTN_LOG");
+        Record * const r = GetRecordForWrite();
+        if (r == NULL) {
+            return;
+        }
+        r->format = format;
+        r->module = module;
+        r->numSuppressed = numSuppressed;
+        r->severity = static_cast<uint8_t>(level);
+        r->numArgs = 0;
+        r->stringStorageUsed = 0;
+        EncodeArgs(*r, args...);
+        CommitRecord();
+    }
+
+private:
+    LOG_LIB_EXPORT static Record * GetRecordForWrite();
+    LOG_LIB_EXPORT static void CommitRecord();
+    LOG_LIB_EXPORT static void EncodeString(Record & r, const char * str, std::size_t length);
+
+    static void EncodeArgs(Record &) {}
+    template <typename T, typename... Rest>
+    static void EncodeArgs(Record & r, const T & first, const Rest & ... rest) {
+        EncodeArg(r, first);
+        EncodeArgs(r, rest...);
+    }
+    static void EncodeArg(Record & r, const bool value) {
+        r.argTypes[r.numArgs] = ArgType::BOOL;
+        r.argValues[r.numArgs++].u = value;
+    }
+    static void EncodeArg(Record & r, const char value) {
+        r.argTypes[r.numArgs] = ArgType::CHAR;
+        r.argValues[r.numArgs++].i = value;
+    }
+    static void EncodeArg(Record & r, const char * value) {
+        EncodeString(r, value, (value) ? std::strlen(value) : 0);
+    }
+    static void EncodeArg(Record & r, char * value) {
+        EncodeArg(r, static_cast<const char *>(value));
+    }
+    static void EncodeArg(Record & r, const std::string & value) {
+        EncodeString(r, value.data(), value.size());
+    }
+    template <typename T>
+    static void EncodeArg(Record & r, const T & value) {
+        EncodeNumber(r, value, std::is_floating_point<T>(), std::is_signed<T>());
+    }
+    template <typename T, bool isSigned>
+    static void EncodeNumber(Record & r, const T & value, std::true_type, std::integral_constant<bool, isSigned>) {
+        r.argTypes[r.numArgs] = ArgType::DOUBLE;
+        r.argValues[r.numArgs++].d = static_cast<double>(value);
+    }
+    template <typename T>
+    static void EncodeNumber(Record & r, const T & value, std::false_type, std::true_type) {
+        r.argTypes[r.numArgs] = ArgType::INT64;
+        r.argValues[r.numArgs++].i = static_cast<int64_t>(value);
+    }
+    template <typename T>
+    static void EncodeNumber(Record & r, const T & value, std::false_type, std::false_type) { //unsigned integers and unsigned enums
+        r.argTypes[r.numArgs] = ArgType::UINT64;
+        r.argValues[r.numArgs++].u = static_cast<uint64_t>(value);
+    }
+
+    LOG_LIB_EXPORT static std::atomic<int> s_minimumSeverity;
+};
+
+} //namespace hdtn
+
+#define HDTN_LOG(level, module, ...) \
+    do { if (hdtn::AsyncLogger::IsEnabled(level)) { hdtn::AsyncLogger::Log(level, module, 0, __VA_ARGS__); } } while (0)
+
+#define HDTN_LOG_RATE_LIMITED(maxPerSecond, level, module, ...) \
+    do { \
+        if (hdtn::AsyncLogger::IsEnabled(level)) { \
+            static hdtn::LogRateLimiter hdtnLogRateLimiterForCallSite(maxPerSecond); \
+            uint32_t hdtnLogNumSuppressed; \
+            if (hdtnLogRateLimiterForCallSite.Allow(hdtnLogNumSuppressed)) { \
+                hdtn::AsyncLogger::Log(level, module, hdtnLogNumSuppressed, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define HDTN_LOG_INFO(module, ...) HDTN_LOG(hdtn::severity_level::info, module, __VA_ARGS__)
+#define HDTN_LOG_NOTIFICATION(module, ...) HDTN_LOG(hdtn::severity_level::notification, module, __VA_ARGS__)
+#define HDTN_LOG_WARNING(module, ...) HDTN_LOG(hdtn::severity_level::warning, module, __VA_ARGS__)
+#define HDTN_LOG_ERROR(module, ...) HDTN_LOG(hdtn::severity_level::error, module, __VA_ARGS__)
+#define HDTN_LOG_CRITICAL(module, ...) HDTN_LOG(hdtn::severity_level::critical, module, __VA_ARGS__)
+
+#define HDTN_LOG_INFO_RATE_LIMITED(maxPerSecond, module, ...) HDTN_LOG_RATE_LIMITED(maxPerSecond, hdtn::severity_level::info, module, __VA_ARGS__)
+#define HDTN_LOG_NOTIFICATION_RATE_LIMITED(maxPerSecond, module, ...) HDTN_LOG_RATE_LIMITED(maxPerSecond, hdtn::severity_level::notification, module, __VA_ARGS__)
+#define HDTN_LOG_WARNING_RATE_LIMITED(maxPerSecond, module, ...) HDTN_LOG_RATE_LIMITED(maxPerSecond, hdtn::severity_level::warning, module, __VA_ARGS__)
+#define HDTN_LOG_ERROR_RATE_LIMITED(maxPerSecond, module, ...) HDTN_LOG_RATE_LIMITED(maxPerSecond, hdtn::severity_level::error, module, __VA_ARGS__)
+
+#endif //_HDTN_ASYNC_LOGGER_H
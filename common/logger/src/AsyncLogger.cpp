@@ -0,0 +1,341 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "AsyncLogger.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/make_unique.hpp>
+
+namespace hdtn{
+
+std::atomic<int> AsyncLogger::s_minimumSeverity(static_cast<int>(hdtn::severity_level::info));
+
+/*
+One per logging thread, written only by that thread and read only by the flusher thread.
+The read and write counters are free running (they wrap around) and are reduced modulo RECORDS_PER_THREAD,
+so the buffer is full when (write - read) == RECORDS_PER_THREAD.
+*/
+struct ThreadRecordBuffer {
+    ThreadRecordBuffer() : m_writeCounter(0), m_readCounter(0), m_numDropped(0), m_ownerThreadExited(false) {}
+
+    AsyncLogger::Record m_records[AsyncLogger::RECORDS_PER_THREAD];
+    char m_paddingBeforeProducer[64];
+    std::atomic<uint32_t> m_writeCounter;
+    char m_paddingBeforeConsumer[64];
+    std::atomic<uint32_t> m_readCounter;
+    std::atomic<uint64_t> m_numDropped;
+    std::atomic<bool> m_ownerThreadExited;
+};
+
+//the flusher keeps its own reference so that records logged just before a thread exits are still output
+struct ThreadRecordBufferHolder {
+    ~ThreadRecordBufferHolder() {
+        if (m_bufferSharedPtr) {
+            m_bufferSharedPtr->m_ownerThreadExited.store(true, std::memory_order_release);
+        }
+    }
+    std::shared_ptr<ThreadRecordBuffer> m_bufferSharedPtr;
+};
+static thread_local ThreadRecordBufferHolder t_threadRecordBufferHolder;
+
+class AsyncLoggerFlusher {
+public:
+    static AsyncLoggerFlusher & Instance();
+    AsyncLoggerFlusher();
+    ~AsyncLoggerFlusher();
+    ThreadRecordBuffer * RegisterThisThread();
+    void Flush();
+    void FlushThreadFunc();
+    void DrainBuffer(ThreadRecordBuffer & buffer);
+    void FormatRecord(const AsyncLogger::Record & r);
+    void Output(const hdtn::severity_level level, const char * module, const std::string & message);
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_flusherCv;
+    boost::condition_variable m_flushCompletedCv;
+    std::vector<std::shared_ptr<ThreadRecordBuffer> > m_buffers;
+    std::vector<std::shared_ptr<ThreadRecordBuffer> > m_buffersFlusherCopy;
+    uint64_t m_flushRequestedCount;
+    uint64_t m_flushCompletedCount;
+    bool m_running;
+    bool m_outputToConsole;
+    bool m_outputToLogFiles;
+    AsyncLogger::output_function_t m_outputFunction;
+    //copies of the above settings only used by the flusher thread
+    bool m_flusherOutputToConsole;
+    bool m_flusherOutputToLogFiles;
+    AsyncLogger::output_function_t m_flusherOutputFunction;
+    std::atomic<uint64_t> m_totalDropped;
+    std::ostringstream m_oss;
+    std::unique_ptr<boost::thread> m_flusherThreadPtr;
+};
+
+AsyncLoggerFlusher & AsyncLoggerFlusher::Instance() {
+    static AsyncLoggerFlusher flusher; //thread safe initialization in C++11
+    return flusher;
+}
+
+AsyncLoggerFlusher::AsyncLoggerFlusher() :
+    m_flushRequestedCount(0),
+    m_flushCompletedCount(0),
+    m_running(true),
+    m_outputToConsole(true),
+    m_outputToLogFiles(true),
+    m_flusherOutputToConsole(true),
+    m_flusherOutputToLogFiles(true),
+    m_totalDropped(0)
+{
+    //construct the Boost.Log core now so that it is destroyed after this object (which flushes into it on destruction)
+    boost::log::core::get();
+    m_flusherThreadPtr = boost::make_unique<boost::thread>(boost::bind(&AsyncLoggerFlusher::FlushThreadFunc, this));
+}
+
+AsyncLoggerFlusher::~AsyncLoggerFlusher() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_running = false;
+    }
+    m_flusherCv.notify_one();
+    if (m_flusherThreadPtr) {
+        m_flusherThreadPtr->join(); //the flusher drains every buffer before exiting
+        m_flusherThreadPtr.reset();
+    }
+}
+
+ThreadRecordBuffer * AsyncLoggerFlusher::RegisterThisThread() {
+    std::shared_ptr<ThreadRecordBuffer> bufferSharedPtr = std::make_shared<ThreadRecordBuffer>();
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_buffers.push_back(bufferSharedPtr);
+    }
+    t_threadRecordBufferHolder.m_bufferSharedPtr = std::move(bufferSharedPtr);
+    return t_threadRecordBufferHolder.m_bufferSharedPtr.get();
+}
+
+void AsyncLoggerFlusher::Flush() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    const uint64_t myRequest = ++m_flushRequestedCount;
+    m_flusherCv.notify_one();
+    while (m_running && (m_flushCompletedCount < myRequest)) {
+        m_flushCompletedCv.wait(lock);
+    }
+}
+
+void AsyncLoggerFlusher::FlushThreadFunc() {
+    while (true) {
+        bool running;
+        uint64_t flushRequestedCount;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            if (m_running && (m_flushCompletedCount == m_flushRequestedCount)) {
+                m_flusherCv.timed_wait(lock, boost::posix_time::milliseconds(20));
+            }
+            running = m_running;
+            flushRequestedCount = m_flushRequestedCount;
+            //remove buffers whose thread has exited, once they are drained
+            for (std::size_t i = 0; i < m_buffers.size(); ) {
+                ThreadRecordBuffer & b = *m_buffers[i];
+                if (b.m_ownerThreadExited.load(std::memory_order_acquire)
+                    && (b.m_readCounter.load(std::memory_order_relaxed) == b.m_writeCounter.load(std::memory_order_acquire))
+                    && (b.m_numDropped.load(std::memory_order_relaxed) == 0))
+                {
+                    m_buffers[i] = std::move(m_buffers.back());
+                    m_buffers.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+            m_buffersFlusherCopy = m_buffers;
+            m_flusherOutputToConsole = m_outputToConsole;
+            m_flusherOutputToLogFiles = m_outputToLogFiles;
+            m_flusherOutputFunction = m_outputFunction;
+        }
+
+        for (std::size_t i = 0; i < m_buffersFlusherCopy.size(); ++i) {
+            DrainBuffer(*m_buffersFlusherCopy[i]);
+        }
+        if (m_flusherOutputToConsole && (!m_flusherOutputFunction)) {
+            std::cout.flush();
+            std::cerr.flush();
+        }
+        m_buffersFlusherCopy.clear();
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_flushCompletedCount = flushRequestedCount;
+        }
+        m_flushCompletedCv.notify_all();
+        if (!running) {
+            break;
+        }
+    }
+}
+
+void AsyncLoggerFlusher::DrainBuffer(ThreadRecordBuffer & buffer) {
+    const uint64_t numDropped = buffer.m_numDropped.exchange(0, std::memory_order_relaxed);
+    const uint32_t writeCounter = buffer.m_writeCounter.load(std::memory_order_acquire);
+    uint32_t readCounter = buffer.m_readCounter.load(std::memory_order_relaxed);
+    while (readCounter != writeCounter) {
+        FormatRecord(buffer.m_records[readCounter % AsyncLogger::RECORDS_PER_THREAD]);
+        ++readCounter;
+        buffer.m_readCounter.store(readCounter, std::memory_order_release);
+    }
+    if (numDropped) {
+        m_oss.str(std::string());
+        m_oss << "AsyncLogger: " << numDropped << " log message(s) dropped because a thread's log buffer was full";
+        Output(hdtn::severity_level::warning, "logger", m_oss.str());
+    }
+}
+
+void AsyncLoggerFlusher::FormatRecord(const AsyncLogger::Record & r) {
+    m_oss.str(std::string());
+    unsigned int argIndex = 0;
+    for (const char * f = r.format; *f != '\0'; ++f) {
+        if ((f[0] == '{') && (f[1] == '}') && (argIndex < r.numArgs)) {
+            const AsyncLogger::Record::Value & v = r.argValues[argIndex];
+            switch (r.argTypes[argIndex]) {
+                case AsyncLogger::ArgType::INT64: m_oss << v.i; break;
+                case AsyncLogger::ArgType::UINT64: m_oss << v.u; break;
+                case AsyncLogger::ArgType::DOUBLE: m_oss << v.d; break;
+                case AsyncLogger::ArgType::BOOL: m_oss << ((v.u) ? "true" : "false"); break;
+                case AsyncLogger::ArgType::CHAR: m_oss << static_cast<char>(v.i); break;
+                case AsyncLogger::ArgType::STRING:
+                    m_oss.write(&r.stringStorage[v.u >> 32], static_cast<std::streamsize>(v.u & 0xffffffffu));
+                    break;
+            }
+            ++argIndex;
+            ++f;
+        }
+        else {
+            m_oss << *f;
+        }
+    }
+    if (r.numSuppressed) {
+        m_oss << " [" << r.numSuppressed << " similar message(s) suppressed by rate limit]";
+    }
+    Output(static_cast<hdtn::severity_level>(r.severity), r.module, m_oss.str());
+}
+
+void AsyncLoggerFlusher::Output(const hdtn::severity_level level, const char * module, const std::string & message) {
+    if (m_flusherOutputFunction) {
+        m_flusherOutputFunction(level, module, message);
+        return;
+    }
+    if (m_flusherOutputToConsole) {
+        std::ostream & os = (level >= hdtn::severity_level::warning) ? std::cerr : std::cout;
+        os << message << '\n';
+    }
+    if (m_flusherOutputToLogFiles) {
+        hdtn::Logger * const logger = hdtn::Logger::getInstance();
+        const std::string moduleString(module);
+        switch (level) {
+            case hdtn::severity_level::info: logger->logInfo(moduleString, message); break;
+            case hdtn::severity_level::notification: logger->logNotification(moduleString, message); break;
+            case hdtn::severity_level::warning: logger->logWarning(moduleString, message); break;
+            case hdtn::severity_level::error: logger->logError(moduleString, message); break;
+            default: logger->logCritical(moduleString, message); break;
+        }
+    }
+}
+
+AsyncLogger::Record * AsyncLogger::GetRecordForWrite() {
+    ThreadRecordBuffer * buffer = t_threadRecordBufferHolder.m_bufferSharedPtr.get();
+    if (buffer == NULL) {
+        buffer = AsyncLoggerFlusher::Instance().RegisterThisThread();
+    }
+    const uint32_t writeCounter = buffer->m_writeCounter.load(std::memory_order_relaxed);
+    if ((writeCounter - buffer->m_readCounter.load(std::memory_order_acquire)) >= RECORDS_PER_THREAD) {
+        buffer->m_numDropped.fetch_add(1, std::memory_order_relaxed);
+        AsyncLoggerFlusher::Instance().m_totalDropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+    return &buffer->m_records[writeCounter % RECORDS_PER_THREAD];
+}
+
+void AsyncLogger::CommitRecord() {
+    ThreadRecordBuffer * const buffer = t_threadRecordBufferHolder.m_bufferSharedPtr.get();
+    buffer->m_writeCounter.store(buffer->m_writeCounter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AsyncLogger::EncodeString(Record & r, const char * str, std::size_t length) {
+    const std::size_t remaining = STRING_STORAGE_SIZE - r.stringStorageUsed;
+    if (length > remaining) {
+        length = remaining; //truncate
+    }
+    if (length) {
+        memcpy(&r.stringStorage[r.stringStorageUsed], str, length);
+    }
+    r.argTypes[r.numArgs] = ArgType::STRING;
+    r.argValues[r.numArgs++].u = (static_cast<uint64_t>(r.stringStorageUsed) << 32) | length;
+    r.stringStorageUsed = static_cast<uint8_t>(r.stringStorageUsed + length);
+}
+
+void AsyncLogger::SetMinimumSeverity(const hdtn::severity_level level) {
+    s_minimumSeverity.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void AsyncLogger::SetOutputToConsole(const bool enabled) {
+    AsyncLoggerFlusher & flusher = AsyncLoggerFlusher::Instance();
+    flusher.Flush();
+    boost::mutex::scoped_lock lock(flusher.m_mutex);
+    flusher.m_outputToConsole = enabled;
+}
+
+void AsyncLogger::SetOutputToLogFiles(const bool enabled) {
+    AsyncLoggerFlusher & flusher = AsyncLoggerFlusher::Instance();
+    flusher.Flush();
+    boost::mutex::scoped_lock lock(flusher.m_mutex);
+    flusher.m_outputToLogFiles = enabled;
+}
+
+void AsyncLogger::SetOutputFunction(const output_function_t & outputFunction) {
+    AsyncLoggerFlusher & flusher = AsyncLoggerFlusher::Instance();
+    flusher.Flush();
+    boost::mutex::scoped_lock lock(flusher.m_mutex);
+    flusher.m_outputFunction = outputFunction;
+}
+
+void AsyncLogger::Flush() {
+    AsyncLoggerFlusher::Instance().Flush();
+}
+
+uint64_t AsyncLogger::GetNumDropped() {
+    return AsyncLoggerFlusher::Instance().m_totalDropped.load(std::memory_order_relaxed);
+}
+
+LogRateLimiter::LogRateLimiter(const uint32_t maxPerSecond) :
+    M_MAX_PER_SECOND(maxPerSecond),
+    m_windowStartMilliseconds(0),
+    m_numAllowedInWindow(0),
+    m_numSuppressed(0) {}
+
+bool LogRateLimiter::Allow(uint32_t & numSuppressedSinceLastAllowed) {
+    const uint64_t nowMilliseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    uint64_t windowStartMilliseconds = m_windowStartMilliseconds.load(std::memory_order_relaxed);
+    if ((nowMilliseconds - windowStartMilliseconds) >= 1000) {
+        //only one thread starts the new window
+        if (m_windowStartMilliseconds.compare_exchange_strong(windowStartMilliseconds, nowMilliseconds, std::memory_order_relaxed)) {
+            m_numAllowedInWindow.store(0, std::memory_order_relaxed);
+        }
+    }
+    if (m_numAllowedInWindow.fetch_add(1, std::memory_order_relaxed) < M_MAX_PER_SECOND) {
+        numSuppressedSinceLastAllowed = m_numSuppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    m_numSuppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+} //namespace hdtn
@@ -0,0 +1,171 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ***************************************************************************
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/timer/timer.hpp>
+#include "AsyncLogger.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+struct CapturedLogMessage {
+    hdtn::severity_level level;
+    std::string module;
+    std::string message;
+};
+
+struct AsyncLoggerCapture {
+    AsyncLoggerCapture() {
+        hdtn::AsyncLogger::SetOutputFunction(boost::bind(&AsyncLoggerCapture::OnMessage, this,
+            boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3));
+    }
+    ~AsyncLoggerCapture() {
+        hdtn::AsyncLogger::SetOutputFunction(hdtn::AsyncLogger::output_function_t());
+        hdtn::AsyncLogger::SetMinimumSeverity(hdtn::severity_level::info);
+    }
+    void OnMessage(hdtn::severity_level level, const char * module, const std::string & message) { //called by flusher thread only
+        CapturedLogMessage m;
+        m.level = level;
+        m.module = module;
+        m.message = message;
+        m_messages.push_back(std::move(m));
+    }
+    std::vector<CapturedLogMessage> m_messages; //only read after AsyncLogger::Flush()
+};
+
+static int g_numTimesEvaluated = 0;
+static int CountEvaluation() {
+    ++g_numTimesEvaluated;
+    return 5;
+}
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerFormatTestCase)
+{
+    AsyncLoggerCapture capture;
+    enum class TestEnum : uint8_t { VALUE_SEVEN = 7 };
+    const std::string s("a std::string");
+    const char * cStr = "a c string";
+    HDTN_LOG_ERROR("ingress", "no args");
+    HDTN_LOG_WARNING("egress", "int {} uint64 {} double {} bool {} char {}", -3, UINT64_MAX, 2.5, true, 'x');
+    HDTN_LOG_INFO("storage", "{} and {} and {}", s, cStr, "a literal");
+    HDTN_LOG_NOTIFICATION("storage", "enum {} uint8 {}", TestEnum::VALUE_SEVEN, static_cast<uint8_t>(200));
+    HDTN_LOG_CRITICAL("egress", "missing {} {}", 1);
+    HDTN_LOG_ERROR("egress", "long string {}", std::string(1000, 'z'));
+    hdtn::AsyncLogger::Flush();
+
+    BOOST_REQUIRE_EQUAL(capture.m_messages.size(), 6);
+    BOOST_REQUIRE(capture.m_messages[0].level == hdtn::severity_level::error);
+    BOOST_REQUIRE_EQUAL(capture.m_messages[0].module, "ingress");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[0].message, "no args");
+    BOOST_REQUIRE(capture.m_messages[1].level == hdtn::severity_level::warning);
+    BOOST_REQUIRE_EQUAL(capture.m_messages[1].message, "int -3 uint64 18446744073709551615 double 2.5 bool true char x");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[2].message, "a std::string and a c string and a literal");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[3].message, "enum 7 uint8 200");
+    BOOST_REQUIRE(capture.m_messages[4].level == hdtn::severity_level::critical);
+    BOOST_REQUIRE_EQUAL(capture.m_messages[4].message, "missing 1 {}");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[5].message, "long string " + std::string(hdtn::AsyncLogger::STRING_STORAGE_SIZE, 'z')); //truncated
+
+    //filtered out messages don't evaluate their arguments
+    hdtn::AsyncLogger::SetMinimumSeverity(hdtn::severity_level::error);
+    g_numTimesEvaluated = 0;
+    HDTN_LOG_INFO("ingress", "filtered {}", CountEvaluation());
+    HDTN_LOG_WARNING("ingress", "filtered {}", CountEvaluation());
+    HDTN_LOG_ERROR("ingress", "not filtered {}", CountEvaluation());
+    hdtn::AsyncLogger::Flush();
+    BOOST_REQUIRE_EQUAL(g_numTimesEvaluated, 1);
+    BOOST_REQUIRE_EQUAL(capture.m_messages.size(), 7);
+    BOOST_REQUIRE_EQUAL(capture.m_messages[6].message, "not filtered 5");
+}
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerRateLimitTestCase)
+{
+    AsyncLoggerCapture capture;
+    for (unsigned int round = 0; round < 2; ++round) {
+        if (round == 1) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1100)); //start a new one second window
+        }
+        for (unsigned int i = 0; i < 100; ++i) {
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "link flap {}", i);
+        }
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "other call site"); //has its own limit
+        hdtn::AsyncLogger::Flush();
+    }
+    BOOST_REQUIRE_EQUAL(capture.m_messages.size(), 22);
+    BOOST_REQUIRE_EQUAL(capture.m_messages[9].message, "link flap 9");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[10].message, "other call site");
+    //the first message of the new window reports what was suppressed at that call site
+    BOOST_REQUIRE_EQUAL(capture.m_messages[11].message, "link flap 0 [90 similar message(s) suppressed by rate limit]");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[20].message, "link flap 9");
+    BOOST_REQUIRE_EQUAL(capture.m_messages[21].message, "other call site");
+}
+
+static void AsyncLoggerTestThreadFunc(const unsigned int threadId, const unsigned int numMessages) {
+    for (unsigned int i = 0; i < numMessages; ++i) {
+        HDTN_LOG_INFO("storage", "thread {} message {}", threadId, i);
+        if ((i % 64) == 63) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1)); //stay within the per-thread buffer
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerMultiThreadTestCase)
+{
+    AsyncLoggerCapture capture;
+    static const unsigned int NUM_THREADS = 4;
+    static const unsigned int NUM_MESSAGES_PER_THREAD = 1000;
+    const uint64_t numDroppedBefore = hdtn::AsyncLogger::GetNumDropped();
+    {
+        boost::thread_group threads;
+        for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+            threads.create_thread(boost::bind(&AsyncLoggerTestThreadFunc, t, NUM_MESSAGES_PER_THREAD));
+        }
+        threads.join_all(); //records of exited threads must still be output
+    }
+    hdtn::AsyncLogger::Flush();
+    const uint64_t numDropped = hdtn::AsyncLogger::GetNumDropped() - numDroppedBefore;
+    std::vector<unsigned int> nextExpectedPerThread(NUM_THREADS, 0);
+    uint64_t numDataMessages = 0;
+    for (std::size_t i = 0; i < capture.m_messages.size(); ++i) {
+        if (capture.m_messages[i].module != "storage") {
+            continue; //drop report
+        }
+        unsigned int threadId, messageNumber;
+        BOOST_REQUIRE_EQUAL(sscanf(capture.m_messages[i].message.c_str(), "thread %u message %u", &threadId, &messageNumber), 2);
+        BOOST_REQUIRE_LT(threadId, NUM_THREADS);
+        BOOST_REQUIRE_GE(messageNumber, nextExpectedPerThread[threadId]); //per-thread order is preserved
+        nextExpectedPerThread[threadId] = messageNumber + 1;
+        ++numDataMessages;
+    }
+    BOOST_REQUIRE_EQUAL(numDataMessages + numDropped, NUM_THREADS * NUM_MESSAGES_PER_THREAD);
+}
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerSpeedTestCase, *boost::unit_test::disabled())
+{
+    AsyncLoggerCapture capture;
+    static const unsigned int NUM_CALLS = 10000000;
+    hdtn::AsyncLogger::SetMinimumSeverity(hdtn::severity_level::error);
+    {
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_CALLS; ++i) {
+            HDTN_LOG_INFO("ingress", "filtered {} {}", i, 1.5);
+        }
+        std::cout << "filtered out: " << (static_cast<double>(timer.elapsed().wall) / NUM_CALLS) << " ns per call\n";
+    }
+    {
+        static const unsigned int NUM_LOGGED = 256;
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_LOGGED; ++i) {
+            HDTN_LOG_ERROR("ingress", "logged {} {} {}", i, 1.5, "str");
+        }
+        std::cout << "logged: " << (static_cast<double>(timer.elapsed().wall) / NUM_LOGGED) << " ns per call\n";
+        hdtn::AsyncLogger::Flush();
+    }
+}
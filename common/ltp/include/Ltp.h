@@ -248,6 +248,10 @@ public:
 	typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
         std::vector<uint8_t> & clientServiceDataVec, const data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> DataSegmentContentsReadCallback_t;
+    //clientServiceData (of length dataSegmentMetadata.length) is only valid for the duration of the callback
+    typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
+        const uint8_t * clientServiceData, const data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> DataSegmentContentsReadInPlaceCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, const report_segment_t & reportSegment,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> ReportSegmentContentsReadCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, uint64_t reportSerialNumberBeingAcknowledged,
@@ -263,6 +267,9 @@ public:
     LTP_LIB_EXPORT ~Ltp();
     
     LTP_LIB_EXPORT void SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback);
+    //if set, takes precedence over the DataSegmentContentsReadCallback_t, and when a data segment's client service data
+    //is entirely within one HandleReceivedChars call (i.e. a whole udp packet) it is passed in place without being copied
+    LTP_LIB_EXPORT void SetDataSegmentContentsReadInPlaceCallback(const DataSegmentContentsReadInPlaceCallback_t & callback);
     LTP_LIB_EXPORT void SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetReportAcknowledgementSegmentContentsReadCallback(const ReportAcknowledgementSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetCancelSegmentContentsReadCallback(const CancelSegmentContentsReadCallback_t & callback);
@@ -279,6 +286,10 @@ public:
     LTP_LIB_EXPORT static void GenerateLtpHeaderPlusDataSegmentMetadata(std::vector<uint8_t> & ltpHeaderPlusDataSegmentMetadata, LTP_DATA_SEGMENT_TYPE_FLAGS dataSegmentTypeFlags,
         const session_id_t & sessionId, const data_segment_metadata_t & dataSegmentMetadata,
         ltp_extensions_t * headerExtensions = NULL, uint8_t numTrailerExtensions = 0);
+    //serializes into a caller provided buffer (which must be large enough) and returns the number of bytes written
+    LTP_LIB_EXPORT static uint64_t GenerateLtpHeaderPlusDataSegmentMetadata(uint8_t * ltpHeaderPlusDataSegmentMetadata, LTP_DATA_SEGMENT_TYPE_FLAGS dataSegmentTypeFlags,
+        const session_id_t & sessionId, const data_segment_metadata_t & dataSegmentMetadata,
+        ltp_extensions_t * headerExtensions = NULL, uint8_t numTrailerExtensions = 0);
     LTP_LIB_EXPORT static void GenerateReportSegmentLtpPacket(std::vector<uint8_t> & ltpReportSegmentPacket, const session_id_t & sessionId, const report_segment_t & reportSegmentStruct,
         ltp_extensions_t * headerExtensions = NULL, ltp_extensions_t * trailerExtensions = NULL);
     LTP_LIB_EXPORT static void GenerateReportAcknowledgementSegmentLtpPacket(std::vector<uint8_t> & ltpReportAcknowledgementSegmentPacket, const session_id_t & sessionId,
@@ -294,6 +305,7 @@ private:
     LTP_LIB_NO_EXPORT void SetBeginningState();
     LTP_LIB_NO_EXPORT const uint8_t * NextStateAfterHeaderExtensions(const uint8_t * rxVals, std::size_t & numChars, std::string & errorMessage);
     LTP_LIB_NO_EXPORT bool NextStateAfterTrailerExtensions(std::string & errorMessage);
+    LTP_LIB_NO_EXPORT void DataSegmentContentsReadCallbackFromVec();
     LTP_LIB_NO_EXPORT const uint8_t * TryShortcutReadDataSegmentSdnvs(const uint8_t * rxVals, std::size_t & numChars, std::string & errorMessage);
     LTP_LIB_NO_EXPORT const uint8_t * TryShortcutReadReportSegmentSdnvs(const uint8_t * rxVals, std::size_t & numChars, std::string & errorMessage);
 public:
@@ -325,6 +337,7 @@ public:
         
 	//callback functions
 	DataSegmentContentsReadCallback_t m_dataSegmentContentsReadCallback;
+    DataSegmentContentsReadInPlaceCallback_t m_dataSegmentContentsReadInPlaceCallback;
     ReportSegmentContentsReadCallback_t m_reportSegmentContentsReadCallback;
     ReportAcknowledgementSegmentContentsReadCallback_t m_reportAcknowledgementSegmentContentsReadCallback;
     CancelSegmentContentsReadCallback_t m_cancelSegmentContentsReadCallback;
@@ -0,0 +1,131 @@
+/**
+ * @file LtpAdaptiveController.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpAdaptiveController class tunes an LtpEngine's sending sessions, within configured bounds,
+ * from what the engine observes of the link instead of from fixed configuration:
+ * 1.) Round trip time is measured from the sending of a checkpoint to the arrival of the report segment answering it
+ *     (only for checkpoints sent once, per Karn's algorithm) and smoothed per RFC 6298.  The checkpoint retransmission
+ *     timeout is SRTT + 4*RTTVAR (doubled on each expiration until the next sample), bounded above by the configured
+ *     2*(one way light time + one way margin time).
+ * 2.) Loss is measured from the reception claims of report segments answering first pass checkpoints
+ *     (the fraction of each report's scope not claimed), and the checkpoint interval is set to about
+ *     one expected lost data segment per interval, so that gaps are reported (and retransmitted) early on lossy links
+ *     and checkpoints are few on clean links.
+ * 3.) The send rate follows a BBR like pacing model: the bottleneck bandwidth is the windowed max of the delivery rate
+ *     (red bytes newly acknowledged per round trip), and the send rate is that bandwidth times a pacing gain which
+ *     starts at 2/ln(2) (startup) until the bandwidth stops growing, then cycles through 5/4, 3/4, 1, 1, 1, 1, 1, 1 (probe bandwidth).
+ *     Delivery rate samples taken while the engine was never held back by its rate limiter are application limited
+ *     and only count if they raise the estimate.
+ * Until there are samples, the send rate is the maximum, the checkpoint interval is the maximum, and the timeout is the configured one.
+ * Times are in nanoseconds of a monotonic clock (i.e. LatencyHistogram::NowNanoseconds()).
+ * This class is not thread safe and is driven from the LtpEngine's thread.
+ */
+
+#ifndef LTP_ADAPTIVE_CONTROLLER_H
+#define LTP_ADAPTIVE_CONTROLLER_H 1
+
+#include <cstdint>
+#include "ltp_lib_export.h"
+
+class LtpAdaptiveController {
+private:
+    LtpAdaptiveController();
+public:
+    static constexpr unsigned int BANDWIDTH_FILTER_LENGTH = 10; //delivery rate samples (one per round trip)
+    static constexpr unsigned int NUM_PACING_GAIN_CYCLE_PHASES = 8;
+    static constexpr uint64_t MIN_DELIVERY_RATE_SAMPLE_INTERVAL_NANOSECONDS = 10000000; //10ms (when the round trip time is less)
+    static constexpr unsigned int MAX_TIMEOUT_BACKOFF_SHIFT = 6;
+
+    LTP_LIB_EXPORT LtpAdaptiveController(const uint64_t minSendRateBitsPerSec, const uint64_t maxSendRateBitsPerSec,
+        const uint64_t minCheckpointEveryNthDataPacket, const uint64_t maxCheckpointEveryNthDataPacket,
+        const uint64_t minCheckpointTimeoutNanoseconds, const uint64_t maxCheckpointTimeoutNanoseconds);
+    LTP_LIB_EXPORT void Reset();
+    LTP_LIB_EXPORT void SetMaxSendRate(const uint64_t maxSendRateBitsPerSec);
+
+    //a report segment arrived for a checkpoint that was only sent once
+    LTP_LIB_EXPORT void OnRoundTripTimeSample(const uint64_t roundTripTimeNanoseconds);
+    LTP_LIB_EXPORT void OnCheckpointTimerExpired();
+    //the scope and claimed bytes of a report segment answering a first pass checkpoint
+    LTP_LIB_EXPORT void OnFirstPassReportClaims(const uint64_t reportScopeBytes, const uint64_t claimedBytes);
+    //red bytes newly acknowledged by a report segment; returns true if the send rate changed
+    LTP_LIB_EXPORT bool OnBytesDelivered(const uint64_t nowNanoseconds, const uint64_t newlyAckedBytes);
+    //the engine had data to send but was held back by its rate limiter
+    void OnSendLimitedByRate() {
+        m_sendWasLimitedByRateThisInterval = true;
+    }
+
+    uint64_t GetSendRateBitsPerSec() const {
+        return m_sendRateBitsPerSec;
+    }
+    uint64_t GetCheckpointEveryNthDataPacket() const {
+        return m_checkpointEveryNthDataPacket;
+    }
+    uint64_t GetCheckpointTimeoutNanoseconds() const {
+        return m_checkpointTimeoutNanoseconds;
+    }
+    uint64_t GetSmoothedRoundTripTimeNanoseconds() const {
+        return m_smoothedRoundTripTimeNanoseconds;
+    }
+    double GetLossRate() const {
+        return (m_decayedScopeBytes > 0) ? (m_decayedLostBytes / m_decayedScopeBytes) : 0;
+    }
+    uint64_t GetBottleneckBandwidthBitsPerSec() const {
+        return m_bottleneckBandwidthBytesPerSec << 3;
+    }
+    bool IsInStartup() const {
+        return m_isInStartup;
+    }
+
+private:
+    LTP_LIB_NO_EXPORT void UpdateCheckpointTimeout();
+    LTP_LIB_NO_EXPORT void UpdateCheckpointInterval();
+    LTP_LIB_NO_EXPORT bool UpdateSendRate();
+
+    const uint64_t M_MIN_SEND_RATE_BITS_PER_SEC;
+    uint64_t m_maxSendRateBitsPerSec;
+    const uint64_t M_MIN_CHECKPOINT_EVERY_NTH_DATA_PACKET;
+    const uint64_t M_MAX_CHECKPOINT_EVERY_NTH_DATA_PACKET;
+    const uint64_t M_MIN_CHECKPOINT_TIMEOUT_NANOSECONDS;
+    const uint64_t M_MAX_CHECKPOINT_TIMEOUT_NANOSECONDS;
+
+    //outputs
+    uint64_t m_sendRateBitsPerSec;
+    uint64_t m_checkpointEveryNthDataPacket;
+    uint64_t m_checkpointTimeoutNanoseconds;
+
+    //round trip time
+    uint64_t m_smoothedRoundTripTimeNanoseconds; //0 => no samples yet
+    uint64_t m_roundTripTimeVariationNanoseconds;
+    unsigned int m_timeoutBackoffShift;
+
+    //loss (byte weighted, decayed by 7/8 per report)
+    double m_decayedLostBytes;
+    double m_decayedScopeBytes;
+    uint64_t m_intervalLostBytes;
+    uint64_t m_intervalScopeBytes;
+
+    //delivery rate
+    uint64_t m_intervalStartNanoseconds; //0 => no interval started
+    uint64_t m_intervalDeliveredBytes;
+    bool m_sendWasLimitedByRateThisInterval;
+    uint64_t m_bandwidthFilterBytesPerSec[BANDWIDTH_FILTER_LENGTH];
+    unsigned int m_bandwidthFilterIndex;
+    uint64_t m_bottleneckBandwidthBytesPerSec; //max of the filter, 0 => no samples yet
+    bool m_isInStartup;
+    uint64_t m_fullBandwidthBytesPerSec;
+    unsigned int m_fullBandwidthCount;
+    unsigned int m_pacingGainCycleIndex;
+};
+
+#endif // LTP_ADAPTIVE_CONTROLLER_H
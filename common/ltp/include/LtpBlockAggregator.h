@@ -0,0 +1,58 @@
+/**
+ * @file LtpBlockAggregator.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpBlockAggregator class packs multiple (small) bundles into one LTP block so that
+ * the session setup, checkpoint, report segment, and report acknowledgement costs
+ * are paid once per block instead of once per bundle.
+ * An aggregated block is the concatenation of each bundle preceded by its SDNV encoded length,
+ * and is sent to the AGGREGATED_BLOCK_CLIENT_SERVICE_ID so that the receiving LtpBundleSink
+ * knows to split it back into bundles (a block sent to any other client service id is a single bundle).
+ * This class is not thread safe.
+ */
+
+#ifndef LTP_BLOCK_AGGREGATOR_H
+#define LTP_BLOCK_AGGREGATOR_H 1
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "ltp_lib_export.h"
+
+class LtpBlockAggregator {
+private:
+    LtpBlockAggregator();
+public:
+    //outside of the ids assigned to the bundle protocol (1), ltp service data aggregation (2), and cfdp (3)
+    static constexpr uint64_t AGGREGATED_BLOCK_CLIENT_SERVICE_ID = 64;
+
+    LTP_LIB_EXPORT LtpBlockAggregator(const uint64_t sizeThresholdBytes);
+
+    //returns true if the block has reached the size threshold and should be sent
+    LTP_LIB_EXPORT bool AddBundle(const uint8_t * bundleData, const std::size_t size);
+    LTP_LIB_EXPORT bool IsEmpty() const;
+    LTP_LIB_EXPORT uint64_t GetNumBundles() const;
+    LTP_LIB_EXPORT uint64_t GetBlockSize() const;
+    //moves the block out (leaving this aggregator empty) and returns the number of bundles in it
+    LTP_LIB_EXPORT uint64_t TakeBlock(std::vector<uint8_t> & block);
+
+    //appends the (pointer, length) of each bundle within the block; returns false if the block is malformed
+    LTP_LIB_EXPORT static bool SplitBlock(const uint8_t * block, const std::size_t blockSize, std::vector<std::pair<const uint8_t *, std::size_t> > & bundles);
+
+private:
+    const uint64_t M_SIZE_THRESHOLD_BYTES;
+    std::vector<uint8_t> m_block;
+    uint64_t m_numBundles;
+};
+
+#endif // LTP_BLOCK_AGGREGATOR_H
@@ -16,7 +16,15 @@
  * This LtpBundleSink class encapsulates the appropriate LTP functionality
  * to receive bundles (or any other user defined data) over an LTP over UDP link
  * and calls the user defined function LtpWholeBundleReadyCallback_t when a new bundle
- * is received.
+ * is received.  Blocks sent to the LtpBlockAggregator's client service id are split
+ * back into their bundles, with the callback called once per bundle.
+ * If a spill to disk threshold is given, bundles larger than it are received into memory mapped files
+ * (see LtpRedPartFile) and, if an LtpWholePaddedZmqBundleReadyCallback_t is given, are handed over as zmq messages
+ * backed by those files (never read back into memory); the file is deleted when the zmq message is freed.
+ * If forwardGreenOnlyBundles is set, blocks sent fully green are reassembled from their green segments and
+ * the bundle is delivered as soon as the green EOB arrives (if every byte of the block was received),
+ * without any red part reception, checkpoint, or report machinery.  Incomplete green blocks are discarded.
+ * The green part of a block that also has a red part (whose green data never starts at offset 0) is ignored.
  */
 
 #ifndef _LTP_BUNDLE_SINK_H
@@ -28,12 +36,20 @@
 #include <boost/function.hpp>
 #include "LtpUdpEngineManager.h"
 #include "PaddedVectorUint8.h"
+#include "LtpBlockAggregator.h"
+#include "LtpFragmentIntervalSet.h"
+#include <unordered_map>
+#include <list>
+#include <zmq.hpp>
 
 class LtpBundleSink {
 private:
     LtpBundleSink();
 public:
     typedef boost::function<void(padded_vector_uint8_t & wholeBundleVec)> LtpWholeBundleReadyCallback_t;
+    //the message data is padded like a padded_vector_uint8_t (PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE bytes before the bundle
+    //and PADDING_ELEMENTS_AFTER bytes after it)
+    typedef boost::function<void(std::unique_ptr<zmq::message_t> & movablePaddedBundleZmq)> LtpWholePaddedZmqBundleReadyCallback_t;
 
     LTP_LIB_EXPORT LtpBundleSink(const LtpWholeBundleReadyCallback_t & ltpWholeBundleReadyCallback,
         const uint64_t thisEngineId, const uint64_t expectedSessionOriginatorEngineId, uint64_t mtuReportSegment,
@@ -42,7 +58,10 @@ public:
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION,
         uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
         const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxBundleSizeBytes, const uint64_t maxSimultaneousSessions,
-        const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable);
+        const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable,
+        const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable = 0, const std::string & rxSpillDirectory = "", const unsigned int numUdpRxSockets = 1,
+        const bool forwardGreenOnlyBundles = false, const uint64_t memoryBudgetBytesOrZeroToDisable = 0,
+        const LtpWholePaddedZmqBundleReadyCallback_t & ltpWholePaddedZmqBundleReadyCallback = LtpWholePaddedZmqBundleReadyCallback_t());
     LTP_LIB_EXPORT ~LtpBundleSink();
     LTP_LIB_EXPORT bool ReadyToBeDeleted();
 private:
@@ -51,15 +70,36 @@ private:
     //tcpcl received data callback functions
     LTP_LIB_NO_EXPORT void RedPartReceptionCallback(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec,
         uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock);
+    LTP_LIB_NO_EXPORT void RedPartFileReceptionCallback(const Ltp::session_id_t & sessionId, std::unique_ptr<LtpRedPartFile> & movableRedPartFilePtr,
+        uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock);
+    LTP_LIB_NO_EXPORT void GreenPartSegmentArrivalCallback(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+        uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock);
+    LTP_LIB_NO_EXPORT void EraseGreenBlockReassembly(const Ltp::session_id_t & sessionId);
+    LTP_LIB_NO_EXPORT void DeliverBlock(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & block, const uint64_t clientServiceId);
+    LTP_LIB_NO_EXPORT void DeliverAggregatedBlock(const Ltp::session_id_t & sessionId, const uint8_t * block, const std::size_t blockSize);
     LTP_LIB_NO_EXPORT void ReceptionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode);
 
     const LtpWholeBundleReadyCallback_t m_ltpWholeBundleReadyCallback;
+    const LtpWholePaddedZmqBundleReadyCallback_t m_ltpWholePaddedZmqBundleReadyCallback;
 
     //ltp vars
     const uint64_t M_THIS_ENGINE_ID;
     const uint64_t M_EXPECTED_SESSION_ORIGINATOR_ENGINE_ID;
     std::shared_ptr<LtpUdpEngineManager> m_ltpUdpEngineManagerPtr;
     LtpUdpEngine * m_ltpUdpEnginePtr;
+    std::vector<std::pair<const uint8_t *, std::size_t> > m_aggregatedBundlesTemp;
+
+    //green only bundles being reassembled (at most M_MAX_GREEN_BLOCKS_IN_REASSEMBLY, oldest dropped first)
+    struct green_block_reassembly_t {
+        padded_vector_uint8_t data;
+        LtpFragmentIntervalSet receivedFragments;
+        std::list<Ltp::session_id_t>::iterator ageQueueIt;
+    };
+    typedef std::unordered_map<Ltp::session_id_t, std::unique_ptr<green_block_reassembly_t>, Ltp::hash_session_id_t> map_session_id_to_green_block_reassembly_t;
+    const uint64_t M_MAX_BUNDLE_SIZE_BYTES;
+    const uint64_t M_MAX_GREEN_BLOCKS_IN_REASSEMBLY;
+    map_session_id_to_green_block_reassembly_t m_mapSessionIdToGreenBlockReassembly;
+    std::list<Ltp::session_id_t> m_greenBlockReassemblyAgeQueue; //only blocks still in m_mapSessionIdToGreenBlockReassembly, oldest first
 
     volatile bool m_removeCallbackCalled;
 };
@@ -17,6 +17,11 @@
  * to send a pipeline of bundles (or any other user defined data) over an LTP over UDP link
  * and calls the user defined function OnSuccessfulAckCallback_t when the session closes, meaning
  * a bundle is fully sent (i.e. the ltp fully red session gets acknowledged by the remote receiver).
+ * If an aggregation size threshold is given, bundles smaller than it are packed (see LtpBlockAggregator)
+ * into one fully red session.  A block is sent immediately if no other block is still being transmitted
+ * (so an idle link adds no latency), otherwise it keeps filling until the threshold is reached,
+ * until the previous block's initial transmission completes, or until the oldest bundle in it
+ * has waited the aggregation time threshold.
  */
 
 #ifndef _LTP_BUNDLE_SOURCE_H
@@ -29,6 +34,7 @@
 #include <set>
 #include <vector>
 #include "LtpUdpEngineManager.h"
+#include "LtpBlockAggregator.h"
 #include <zmq.hpp>
 
 class LtpBundleSource {
@@ -48,7 +54,11 @@ public:
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
         const uint16_t myBoundUdpPort, const unsigned int numUdpRxCircularBufferVectors,
         uint32_t checkpointEveryNthDataPacketSender, uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
-        const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable, const uint32_t bundlePipelineLimit);
+        const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable, const uint32_t bundlePipelineLimit,
+        const uint64_t aggregationSizeThresholdBytesOrZeroToDisable = 0, const uint64_t aggregationTimeThresholdMilliseconds = 0,
+        const uint64_t adaptiveMinSendRateBitsPerSecOrZeroToDisable = 0, const uint64_t adaptiveMinCheckpointEveryNthDataPacket = 0,
+        const uint64_t adaptiveMaxCheckpointEveryNthDataPacket = 0, const uint64_t adaptiveMinCheckpointTimeoutMilliseconds = 0,
+        const uint64_t memoryBudgetBytesOrZeroToDisable = 0);
 
     LTP_LIB_EXPORT ~LtpBundleSource();
     LTP_LIB_EXPORT void Stop();
@@ -63,13 +73,26 @@ public:
     //std::size_t GetTotalBundleBytesUnacked();
     LTP_LIB_EXPORT void SetOnSuccessfulAckCallback(const OnSuccessfulAckCallback_t & callback);
 private:
+    struct AggregatedBlockUserData : public LtpTransmissionRequestUserData {
+        AggregatedBlockUserData(const uint64_t paramNumBundles) : numBundles(paramNumBundles), initialTransmissionEnded(false) {}
+        const uint64_t numBundles;
+        bool initialTransmissionEnded; //only accessed by the ltp engine thread
+    };
+
     LTP_LIB_NO_EXPORT void RemoveCallback();
+    LTP_LIB_NO_EXPORT bool ForwardAggregated(const uint8_t* bundleData, const std::size_t size);
+    LTP_LIB_NO_EXPORT void SendAggregatedBlock_NotThreadSafe();
+    LTP_LIB_NO_EXPORT void StartAggregationTimer(const uint64_t blockGeneration);
+    LTP_LIB_NO_EXPORT void CancelAggregationTimer();
+    LTP_LIB_NO_EXPORT void OnAggregation_TimerExpired(const boost::system::error_code& e, const uint64_t blockGeneration);
+    LTP_LIB_NO_EXPORT void OnAggregatedBlockInitialTransmissionEnded(std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
+    LTP_LIB_NO_EXPORT static uint64_t GetNumBundlesInSession(const std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
 
     //ltp callback functions for a sender
     LTP_LIB_NO_EXPORT void SessionStartCallback(const Ltp::session_id_t & sessionId);
-    LTP_LIB_NO_EXPORT void TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId);
-    LTP_LIB_NO_EXPORT void InitialTransmissionCompletedCallback(const Ltp::session_id_t & sessionId);
-    LTP_LIB_NO_EXPORT void TransmissionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode);
+    LTP_LIB_NO_EXPORT void TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
+    LTP_LIB_NO_EXPORT void InitialTransmissionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
+    LTP_LIB_NO_EXPORT void TransmissionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
 
     volatile bool m_useLocalConditionVariableAckReceived;
     boost::condition_variable m_localConditionVariableAckReceived;
@@ -83,6 +106,18 @@ private:
     const uint32_t M_BUNDLE_PIPELINE_LIMIT;
     std::set<Ltp::session_id_t> m_activeSessionsSet;
 
+    //aggregation (Forward appends under the mutex, the aggregation thread only runs the time threshold timer)
+    const uint64_t M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE;
+    const boost::posix_time::time_duration M_AGGREGATION_TIME_THRESHOLD;
+    boost::mutex m_aggregationMutex;
+    LtpBlockAggregator m_blockAggregator;
+    uint64_t m_aggregationBlockGeneration; //incremented each time a block is sent so that a stale timer doesn't send the next block early
+    uint64_t m_numAggregatedBlocksBeingTransmitted; //sent to the engine but initial transmission not yet completed (or cancelled)
+    boost::asio::io_service m_ioServiceAggregation;
+    std::unique_ptr<boost::asio::io_service::work> m_workAggregationPtr;
+    boost::asio::deadline_timer m_aggregationTimer;
+    std::unique_ptr<boost::thread> m_ioServiceAggregationThreadPtr;
+
     OnSuccessfulAckCallback_t m_onSuccessfulAckCallback;
 
     volatile bool m_removeCallbackCalled;
@@ -92,6 +127,7 @@ public:
     std::size_t m_totalDataSegmentsFailedToSend;
     std::size_t m_totalDataSegmentsSent;
     std::size_t m_totalBundleBytesSent;
+    std::size_t m_totalAggregatedBlocksSent;
 };
 
 
@@ -32,6 +32,7 @@
 #include "TokenRateLimiter.h"
 #include <unordered_map>
 #include <queue>
+#include <atomic>
 
 class CLASS_VISIBILITY_LTP_LIB LtpEngine {
 private:
@@ -62,6 +63,35 @@ public:
     LTP_LIB_EXPORT virtual void Reset();
     LTP_LIB_EXPORT void SetCheckpointEveryNthDataPacketForSenders(uint64_t checkpointEveryNthDataPacketSender);
     LTP_LIB_EXPORT void SetMtuReportSegment(uint64_t mtuReportSegment);
+    //receiving sessions whose red part grows beyond the threshold continue in a memory mapped file in the spill directory
+    //(an empty directory means the system temp directory) and are delivered to the RedPartFileReceptionCallback,
+    //which must be set for spilling to occur.  Call before any data is received.
+    LTP_LIB_EXPORT void SetRxSpillToDisk(const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable, const boost::filesystem::path & rxSpillDirectory);
+    //sending sessions adapt their checkpoint interval (within [min, max]), checkpoint timeout (within [min, 2*(owlt+margin)]),
+    //and the engine adapts its send rate (within [min, maxSendRateBitsPerSec]) to the round trip time and loss observed from report segments.
+    //Requires a nonzero maxSendRateBitsPerSec.  Call before any data is sent.
+    LTP_LIB_EXPORT bool SetAdaptiveRateAndCheckpointing(const uint64_t minSendRateBitsPerSec, const uint64_t minCheckpointEveryNthDataPacket,
+        const uint64_t maxCheckpointEveryNthDataPacket, const uint64_t minCheckpointTimeoutMilliseconds);
+    LTP_LIB_EXPORT void SetAdaptiveRateAndCheckpointing_ThreadSafe(const uint64_t minSendRateBitsPerSec, const uint64_t minCheckpointEveryNthDataPacket,
+        const uint64_t maxCheckpointEveryNthDataPacket, const uint64_t minCheckpointTimeoutMilliseconds);
+    //NULL if not adaptive, engine thread only
+    LTP_LIB_EXPORT const LtpAdaptiveController * GetAdaptiveController() const;
+    //Caps the bytes held by this engine: sender client service data (kept for retransmission), receiver red part buffers,
+    //and queued segments of closed sessions.  Receivers take priority because their data cannot be regenerated locally:
+    //- a new transmission request is admitted only if it fits within the budget less a quarter reserved for receivers,
+    //  otherwise it is cancelled immediately (SYSTEM_CANCELLED, nothing is sent) so the client service can retry it later;
+    //- a new receive session is admitted only if its estimated size fits within the budget, otherwise its data segment is
+    //  dropped (the sender retries it on its checkpoint timer);
+    //- if growing receivers exceed the budget, the largest sending sessions are cancelled first, then the largest receiving sessions.
+    //The memory in use by all engines is reported in the "ltp.memoryInUseBytes" gauge.
+    LTP_LIB_EXPORT void SetMemoryBudget(const uint64_t memoryBudgetBytesOrZeroToDisable);
+    LTP_LIB_EXPORT void SetMemoryBudget_ThreadSafe(const uint64_t memoryBudgetBytesOrZeroToDisable);
+    //thread safe
+    LTP_LIB_EXPORT uint64_t GetMemoryInUseBytes() const;
+    //thread safe, false if a transmission request of this size would currently be refused by the memory budget
+    LTP_LIB_EXPORT bool TransmissionRequestFitsWithinMemoryBudget(const uint64_t clientServiceDataBytes) const;
+    //copies the stats of an active sending session, engine thread only
+    LTP_LIB_EXPORT bool GetSessionSenderStats(const uint64_t sessionNumber, LtpSessionSender::session_stats_t & sessionStats) const;
 
     LTP_LIB_EXPORT void TransmissionRequest(boost::shared_ptr<transmission_request_t> & transmissionRequest);
     LTP_LIB_EXPORT void TransmissionRequest_ThreadSafe(boost::shared_ptr<transmission_request_t> && transmissionRequest);
@@ -77,7 +107,10 @@ public:
     
     LTP_LIB_EXPORT void SetSessionStartCallback(const SessionStartCallback_t & callback);
     LTP_LIB_EXPORT void SetRedPartReceptionCallback(const RedPartReceptionCallback_t & callback);
+    LTP_LIB_EXPORT void SetRedPartFileReceptionCallback(const RedPartFileReceptionCallback_t & callback);
     LTP_LIB_EXPORT void SetGreenPartSegmentArrivalCallback(const GreenPartSegmentArrivalCallback_t & callback);
+    //for streaming green data (see LtpGreenSegmentRing), called before the GreenPartSegmentArrivalCallback_t if both are set
+    LTP_LIB_EXPORT void SetGreenPartSegmentArrivalZeroCopyCallback(const GreenPartSegmentArrivalZeroCopyCallback_t & callback);
     LTP_LIB_EXPORT void SetReceptionSessionCancelledCallback(const ReceptionSessionCancelledCallback_t & callback);
     LTP_LIB_EXPORT void SetTransmissionSessionCompletedCallback(const TransmissionSessionCompletedCallback_t & callback);
     LTP_LIB_EXPORT void SetInitialTransmissionCompletedCallback(const InitialTransmissionCompletedCallback_t & callback);
@@ -100,6 +133,11 @@ protected:
     LTP_LIB_EXPORT virtual void PacketInFullyProcessedCallback(bool success);
     LTP_LIB_EXPORT virtual void SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId);
     LTP_LIB_EXPORT void SignalReadyForSend_ThreadSafe();
+
+    //data segment headers from GetNextPacketToSend may point into this pool;
+    //SendPacket implementations must call m_headerBufferPool.Release(constBufferVec[0].data()) once the send completes
+    static constexpr unsigned int NUM_HEADER_BUFFER_POOL_SLOTS = 128;
+    LtpHeaderBufferPool m_headerBufferPool;
 private:
     LTP_LIB_NO_EXPORT void TrySendPacketIfAvailable();
 
@@ -112,7 +150,7 @@ private:
     LTP_LIB_NO_EXPORT void ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionId, const Ltp::report_segment_t & reportSegment,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
     LTP_LIB_NO_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
-        std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
 
     LTP_LIB_NO_EXPORT void CancelSegmentTimerExpiredCallback(Ltp::session_id_t cancelSegmentTimerSerialNumber, std::vector<uint8_t> & userData);
@@ -122,6 +160,7 @@ private:
     LTP_LIB_NO_EXPORT void NotifyEngineThatThisReceiversTimersHasProducibleData(const Ltp::session_id_t & sessionId);
     LTP_LIB_NO_EXPORT void InitialTransmissionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
 
+    LTP_LIB_NO_EXPORT void ApplyAdaptiveSendRate();
     LTP_LIB_NO_EXPORT void TryRestartTokenRefreshTimer();
     LTP_LIB_NO_EXPORT void TryRestartTokenRefreshTimer(const boost::posix_time::ptime & nowPtime);
     LTP_LIB_NO_EXPORT void OnTokenRefresh_TimerExpired(const boost::system::error_code& e);
@@ -143,8 +182,21 @@ private:
     typedef std::unordered_map<uint64_t, std::unique_ptr<LtpSessionSender> > map_session_number_to_session_sender_t;
     typedef std::unordered_map<Ltp::session_id_t, std::unique_ptr<LtpSessionReceiver>, Ltp::hash_session_id_t > map_session_id_to_session_receiver_t;
     map_session_number_to_session_sender_t m_mapSessionNumberToSessionSender;
+    std::vector<padded_vector_uint8_t> m_redPartBufferRecyclePool; //must outlive the receivers which return their buffers to it
+    uint64_t m_rxSpillToDiskThresholdBytesOrZeroToDisable;
+    boost::filesystem::path m_rxSpillDirectory; //must outlive the receivers which reference it
     map_session_id_to_session_receiver_t m_mapSessionIdToSessionReceiver;
 
+    //session erasure (stats and memory accounting)
+    LTP_LIB_NO_EXPORT void EraseTxSession(map_session_number_to_session_sender_t::iterator & txSessionIt);
+    LTP_LIB_NO_EXPORT void EraseRxSession(map_session_id_to_session_receiver_t::iterator & rxSessionIt);
+    //memory budget
+    LTP_LIB_NO_EXPORT void ChargeMemory(const uint64_t bytes);
+    LTP_LIB_NO_EXPORT void ReleaseMemory(const uint64_t bytes);
+    LTP_LIB_NO_EXPORT void EvictSessionsUntilWithinMemoryBudget();
+    std::atomic<uint64_t> m_memoryBudgetBytesOrZeroToDisable;
+    std::atomic<uint64_t> m_memoryInUseBytes; //only modified by the engine thread
+
     std::queue<std::pair<uint64_t, std::vector<uint8_t> > > m_queueClosedSessionDataToSend; //sessionOriginatorEngineId, data
     std::queue<cancel_segment_timer_info_t> m_queueCancelSegmentTimerInfo;
     std::queue<uint64_t> m_queueSendersNeedingDeleted;
@@ -154,7 +206,9 @@ private:
 
     SessionStartCallback_t m_sessionStartCallback;
     RedPartReceptionCallback_t m_redPartReceptionCallback;
+    RedPartFileReceptionCallback_t m_redPartFileReceptionCallback;
     GreenPartSegmentArrivalCallback_t m_greenPartSegmentArrivalCallback;
+    GreenPartSegmentArrivalZeroCopyCallback_t m_greenPartSegmentArrivalZeroCopyCallback;
     ReceptionSessionCancelledCallback_t m_receptionSessionCancelledCallback;
     TransmissionSessionCompletedCallback_t m_transmissionSessionCompletedCallback;
     InitialTransmissionCompletedCallback_t m_initialTransmissionCompletedCallback;
@@ -163,16 +217,19 @@ private:
     uint64_t m_checkpointEveryNthDataPacketSender;
     uint64_t m_maxReceptionClaims;
     uint32_t m_maxRetriesPerSerialNumber;
-
+protected:
     boost::asio::io_service m_ioServiceLtpEngine; //for timers and post calls only
+private:
     std::unique_ptr<boost::asio::io_service::work> m_workLtpEnginePtr;
     LtpTimerManager<Ltp::session_id_t> m_timeManagerOfCancelSegments;
     TokenRateLimiter m_tokenRateLimiter;
     boost::asio::deadline_timer m_tokenRefreshTimer;
-    uint64_t m_maxSendRateBitsPerSecOrZeroToDisable;
+    uint64_t m_maxSendRateBitsPerSecOrZeroToDisable; //the current rate (set by the adaptive controller if adaptive)
+    std::unique_ptr<LtpAdaptiveController> m_adaptiveControllerPtr;
     bool m_tokenRefreshTimerIsRunning;
     boost::posix_time::ptime m_lastTimeTokensWereRefreshed;
     std::unique_ptr<boost::thread> m_ioServiceLtpEngineThreadPtr;
+    std::vector<boost::asio::const_buffer> m_constBufferVecForSend; //reused by TrySendPacketIfAvailable so the send path doesn't allocate
 
     //session re-creation prevention
     std::map<uint64_t, std::unique_ptr<LtpSessionRecreationPreventer> > m_mapSessionOriginatorEngineIdToLtpSessionRecreationPreventer;
@@ -191,6 +248,11 @@ public:
     uint64_t m_numReportSegmentsUnableToBeIssued;
     uint64_t m_numReportSegmentsTooLargeAndNeedingSplit;
     uint64_t m_numReportSegmentsCreatedViaSplit;
+
+    //memory budget stats
+    uint64_t m_numTransmissionRequestsRefusedByMemoryBudget;
+    uint64_t m_numReceiveSessionsRefusedByMemoryBudget;
+    uint64_t m_numSessionsEvictedByMemoryBudget;
 };
 
 #endif // LTP_ENGINE_H
@@ -0,0 +1,73 @@
+/**
+ * @file LtpFragmentIntervalSet.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpFragmentIntervalSet class tracks which byte ranges of an LTP block have been received (or acknowledged).
+ * It replaces the std::set<data_fragment_t> used with FragmentSet/LtpFragmentSet on the session hot path.
+ * The sorted, non-overlapping, non-abutting fragments are stored as a two level "B-tree of ranges":
+ * a vector of chunks, each chunk a contiguous sorted vector of at most MAX_FRAGMENTS_PER_CHUNK fragments.
+ * 1.) The common case of in-order segments is an O(1) extension of (or append after) the last fragment.
+ * 2.) Out-of-order segments (i.e. retransmissions) are two binary searches plus a memmove within one small chunk,
+ *     with no per-segment node allocation.
+ * 3.) Report segment claims and retransmission lists are produced by a linear scan of contiguous memory.
+ */
+
+#ifndef LTP_FRAGMENT_INTERVAL_SET_H
+#define LTP_FRAGMENT_INTERVAL_SET_H 1
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include "Ltp.h"
+#include "FragmentSet.h"
+
+class LtpFragmentIntervalSet {
+public:
+    typedef FragmentSet::data_fragment_t data_fragment_t;
+    static constexpr std::size_t MAX_FRAGMENTS_PER_CHUNK = 64;
+
+    LTP_LIB_EXPORT LtpFragmentIntervalSet();
+    LTP_LIB_EXPORT ~LtpFragmentIntervalSet();
+
+    //merges the fragment with any fragments it overlaps or abuts
+    LTP_LIB_EXPORT void InsertFragment(const data_fragment_t & key);
+    LTP_LIB_EXPORT bool ContainsFragmentEntirely(const data_fragment_t & key) const;
+    //true if the set is the single fragment [0, endIndex] where endIndex >= (length - 1)
+    LTP_LIB_EXPORT bool ContainsPrefix(const uint64_t length) const;
+
+    LTP_LIB_EXPORT bool PopulateReportSegment(Ltp::report_segment_t & reportSegment, uint64_t lowerBound = UINT64_MAX, uint64_t upperBound = UINT64_MAX) const;
+    LTP_LIB_EXPORT void AddReportSegment(const Ltp::report_segment_t & reportSegment);
+    //the gaps between a report segment's reception claims (within its bounds), in ascending order
+    LTP_LIB_EXPORT static void GetFragmentsNeedingResent(const Ltp::report_segment_t & reportSegment, std::vector<data_fragment_t> & fragmentsNeedingResent);
+
+    std::size_t size() const { return m_size; }
+    //the total number of bytes covered by the fragments
+    uint64_t GetNumBytes() const { return m_numBytes; }
+    bool empty() const { return (m_size == 0); }
+    const data_fragment_t & front() const { return m_chunks.front().front(); }
+    const data_fragment_t & back() const { return m_chunks.back().back(); }
+    LTP_LIB_EXPORT void clear();
+    LTP_LIB_EXPORT bool operator==(const std::set<data_fragment_t> & fragmentSet) const;
+    LTP_LIB_EXPORT void Print() const;
+
+private:
+    typedef std::vector<data_fragment_t> chunk_t;
+    std::vector<chunk_t>::const_iterator FindChunk(const data_fragment_t & key) const;
+    void SplitChunkIfFull(const std::size_t chunkIndex);
+
+    std::vector<chunk_t> m_chunks; //never contains an empty chunk
+    std::size_t m_size;
+    uint64_t m_numBytes;
+};
+
+#endif // LTP_FRAGMENT_INTERVAL_SET_H
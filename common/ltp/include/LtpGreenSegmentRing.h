@@ -0,0 +1,75 @@
+/**
+ * @file LtpGreenSegmentRing.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpGreenSegmentRing class streams green data segments from an LtpEngine thread to one consumer thread
+ * as they arrive, for flows (i.e. video and telemetry) that want low latency more than reliability.
+ * The producer is the engine's GreenPartSegmentArrivalZeroCopyCallback_t (see GetProducerCallback()),
+ * which copies the segment straight from the UDP receive buffer into a preallocated ring slot
+ * (no allocation), along with its session id, block offset, client service id, and end of block flag.
+ * The consumer reads each segment in place from the ring and then releases it.
+ * When the ring is full (or a segment is larger than a slot), the segment is dropped and counted, and the engine never blocks.
+ */
+
+#ifndef LTP_GREEN_SEGMENT_RING_H
+#define LTP_GREEN_SEGMENT_RING_H 1
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "LtpNoticesToClientService.h"
+#include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
+#include "ltp_lib_export.h"
+
+class LtpGreenSegmentRing {
+private:
+    LtpGreenSegmentRing();
+public:
+    struct green_segment_t {
+        Ltp::session_id_t sessionId;
+        uint64_t offsetStartOfBlock;
+        uint64_t clientServiceId;
+        bool isEndOfBlock;
+        std::vector<uint8_t> data; //size() is the segment length (capacity is preallocated to the slot size)
+    };
+
+    LTP_LIB_EXPORT LtpGreenSegmentRing(const unsigned int numSegments, const uint64_t maxSegmentSizeBytes);
+    LTP_LIB_EXPORT ~LtpGreenSegmentRing();
+
+    //producer (LtpEngine thread): returns false if the segment was dropped
+    LTP_LIB_EXPORT bool PushSegment(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+        uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock);
+    //pass to LtpEngine::SetGreenPartSegmentArrivalZeroCopyCallback
+    LTP_LIB_EXPORT GreenPartSegmentArrivalZeroCopyCallback_t GetProducerCallback();
+
+    //consumer: the returned segment remains valid until ReleaseSegment() is called
+    LTP_LIB_EXPORT const green_segment_t * TryGetNextSegment();
+    //blocks until a segment is available, or returns NULL once StopWaiting() has been called and the ring is empty
+    LTP_LIB_EXPORT const green_segment_t * WaitForNextSegment();
+    LTP_LIB_EXPORT void ReleaseSegment();
+    LTP_LIB_EXPORT void StopWaiting();
+
+    LTP_LIB_EXPORT uint64_t GetNumSegmentsDropped() const;
+private:
+    LTP_LIB_NO_EXPORT void PushSegmentFromCallback(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+        uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock);
+
+    const uint64_t M_MAX_SEGMENT_SIZE_BYTES;
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
+    std::vector<green_segment_t> m_segments;
+    unsigned int m_readIndex;
+    std::atomic<uint64_t> m_numSegmentsDropped;
+};
+
+#endif // LTP_GREEN_SEGMENT_RING_H
+
@@ -0,0 +1,62 @@
+/**
+ * @file LtpHeaderBufferPool.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpHeaderBufferPool class is a fixed set of fixed size slots that an LtpEngine's
+ * session senders serialize data segment headers (LTP header plus data segment metadata) into,
+ * so that the send path does not allocate a new header per data segment.
+ * A slot is acquired by the LtpEngine thread when the segment is generated
+ * and released (from any thread) when the send of that segment completes.
+ * If every slot is awaiting its send completion, Acquire returns NULL and the caller falls back to a heap allocated header.
+ */
+
+#ifndef LTP_HEADER_BUFFER_POOL_H
+#define LTP_HEADER_BUFFER_POOL_H 1
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include "ltp_lib_export.h"
+
+class LtpHeaderBufferPool : private boost::noncopyable {
+private:
+    LtpHeaderBufferPool();
+public:
+    //flags + extension counts + 2 10-byte session sdnvs + 5 10-byte metadata sdnvs (no header extensions) rounded up
+    static constexpr unsigned int SLOT_SIZE_BYTES = 128;
+
+    LTP_LIB_EXPORT LtpHeaderBufferPool(const unsigned int numSlots);
+    LTP_LIB_EXPORT ~LtpHeaderBufferPool();
+
+    //called by the LtpEngine thread only; returns NULL if every slot is awaiting its send completion
+    LTP_LIB_EXPORT uint8_t * Acquire();
+    //thread safe; does nothing (returns false) if the pointer did not come from Acquire
+    LTP_LIB_EXPORT bool Release(const void * slotPtr);
+    LTP_LIB_EXPORT bool IsFromPool(const void * ptr) const;
+    LTP_LIB_EXPORT unsigned int NumSlotsInUse() const;
+
+private:
+    const unsigned int M_NUM_SLOTS;
+    std::vector<uint8_t> m_slotsBuffer;
+    std::unique_ptr<std::atomic<bool>[]> m_slotInUseFlags;
+    unsigned int m_nextSlotIndexToTry;
+
+public:
+    //stats
+    uint64_t m_numAcquires;
+    uint64_t m_numAcquireFailures;
+};
+
+#endif // LTP_HEADER_BUFFER_POOL_H
@@ -24,6 +24,7 @@
 #include <vector>
 #include <boost/function.hpp>
 #include "PaddedVectorUint8.h"
+#include "LtpRedPartFile.h"
 
 //add a way to associate data with the specific outgoing LTP session
 struct LtpTransmissionRequestUserData {
@@ -64,6 +65,12 @@ typedef boost::function<void(const Ltp::session_id_t & sessionId,
     std::vector<uint8_t> & movableClientServiceDataVec, uint64_t offsetStartOfBlock,
     uint64_t clientServiceId, bool isEndOfBlock)> GreenPartSegmentArrivalCallback_t;
 
+//Green-Part Segment Arrival (as above) without a copy: clientServiceData points into the received UDP packet
+//and is only valid until the callback returns.  offsetStartOfBlock is the offset of the first byte of the segment's content.
+typedef boost::function<void(const Ltp::session_id_t & sessionId,
+    const uint8_t * clientServiceData, uint64_t length, uint64_t offsetStartOfBlock,
+    uint64_t clientServiceId, bool isEndOfBlock)> GreenPartSegmentArrivalZeroCopyCallback_t;
+
 //7.3.  Red-Part Reception
 //The following parameters are provided by the LTP engine when a red -
 //part reception notice is delivered :
@@ -81,6 +88,11 @@ typedef boost::function<void(const Ltp::session_id_t & sessionId,
 typedef boost::function<void(const Ltp::session_id_t & sessionId,
     padded_vector_uint8_t & movableClientServiceDataVec, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)> RedPartReceptionCallback_t;
 
+//Red-Part Reception (as above) for a red part that the receiving engine spilled to disk (see LtpEngine::SetRxSpillToDisk).
+//The client service may take ownership of the file by moving the unique_ptr; otherwise the file is deleted with the session.
+typedef boost::function<void(const Ltp::session_id_t & sessionId,
+    std::unique_ptr<LtpRedPartFile> & movableRedPartFilePtr, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)> RedPartFileReceptionCallback_t;
+
 //7.4.Transmission - Session Completion
 //The sole parameter provided by the LTP engine when a transmission -
 //session completion notice is delivered is the session ID of the
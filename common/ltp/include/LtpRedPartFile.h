@@ -0,0 +1,72 @@
+/**
+ * @file LtpRedPartFile.h
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This LtpRedPartFile class is the disk backed alternative to the padded_vector_uint8_t
+ * that an LtpSessionReceiver normally holds its red part in.  Once a session's red part grows beyond
+ * the engine's spill threshold, the received data segments are written into a memory mapped file
+ * (in the engine's spill directory) so that the session's memory use no longer grows with the block size.
+ * The file is laid out like a padded_vector_uint8_t (PaddedMallocator's padding before and after the red part)
+ * so that the mapped data can be handed to the client service (i.e. as a zmq message) and processed in place.
+ * The file is unmapped and deleted when this object is destroyed.
+ * This class is not thread safe.
+ */
+
+#ifndef LTP_RED_PART_FILE_H
+#define LTP_RED_PART_FILE_H 1
+
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/core/noncopyable.hpp>
+#include "PaddedVectorUint8.h"
+#include "ltp_lib_export.h"
+
+class LtpRedPartFile : private boost::noncopyable {
+public:
+    static constexpr uint64_t PADDING_BYTES_BEFORE = PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE;
+    static constexpr uint64_t TOTAL_PADDING_BYTES = PaddedMallocator<uint8_t>::TOTAL_PADDING_ELEMENTS;
+
+    LTP_LIB_EXPORT LtpRedPartFile();
+    LTP_LIB_EXPORT ~LtpRedPartFile();
+
+    //creates a uniquely named file in the directory (an empty directory means the system temp directory)
+    //with room for redPartCapacityBytes, and maps it
+    LTP_LIB_EXPORT bool Create(const boost::filesystem::path & directory, const uint64_t redPartCapacityBytes);
+    //grows the file and remaps it (invalidating any pointer previously returned by RedPartData())
+    LTP_LIB_EXPORT bool Grow(const uint64_t newRedPartCapacityBytes);
+
+    uint8_t * RedPartData() {
+        return m_paddedData + PADDING_BYTES_BEFORE;
+    }
+    //the start of the mapping (PADDING_BYTES_BEFORE ahead of the red part)
+    uint8_t * PaddedData() {
+        return m_paddedData;
+    }
+    uint64_t GetRedPartCapacity() const {
+        return m_redPartCapacityBytes;
+    }
+    const boost::filesystem::path & GetFilePath() const {
+        return m_filePath;
+    }
+
+private:
+    LTP_LIB_NO_EXPORT bool Map();
+
+    boost::filesystem::path m_filePath;
+    boost::iostreams::mapped_file m_mappedFile;
+    uint8_t * m_paddedData;
+    uint64_t m_redPartCapacityBytes;
+};
+
+#endif // LTP_RED_PART_FILE_H
@@ -21,6 +21,7 @@
 #define LTP_SESSION_RECEIVER_H 1
 
 #include "LtpFragmentSet.h"
+#include "LtpFragmentIntervalSet.h"
 #include "Ltp.h"
 #include "LtpRandomNumberGenerator.h"
 #include "LtpTimerManager.h"
@@ -34,6 +35,9 @@ typedef boost::function<void(const Ltp::session_id_t & sessionId, bool wasCancel
 typedef boost::function<void(const Ltp::session_id_t & sessionId)> NotifyEngineThatThisReceiversTimersHasProducibleDataFunction_t;
 
 class LtpSessionReceiver {
+public:
+    //buffers not moved to the client service (i.e. cancelled sessions) are returned to the engine's pool for reuse by later sessions
+    static constexpr std::size_t MAX_RED_PART_BUFFERS_IN_RECYCLE_POOL = 8;
 private:
     LtpSessionReceiver();
 
@@ -42,6 +46,8 @@ public:
     
     
     LTP_LIB_EXPORT LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS, const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
+        std::vector<padded_vector_uint8_t> & redPartBufferRecyclePoolRef,
+        const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable, const boost::filesystem::path & rxSpillDirectoryRef,
         const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
         const NotifyEngineThatThisReceiverNeedsDeletedCallback_t & notifyEngineThatThisReceiverNeedsDeletedCallback,
@@ -54,20 +60,33 @@ public:
     
     LTP_LIB_EXPORT void ReportAcknowledgementSegmentReceivedCallback(uint64_t reportSerialNumberBeingAcknowledged,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    //clientServiceData is of length dataSegmentMetadata.length and is copied (red) or passed on (green) before returning.
+    //The red part is only spilled to disk (and given to redPartFileReceptionCallback) if redPartFileReceptionCallback is set.
     LTP_LIB_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
-        std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
-        const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
+        const RedPartFileReceptionCallback_t & redPartFileReceptionCallback,
+        const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback,
+        const GreenPartSegmentArrivalZeroCopyCallback_t & greenPartSegmentArrivalZeroCopyCallback);
+    //the red part buffer held in memory (zero once spilled to disk or moved to the client service), charged against the engine's memory budget.
+    //Only changes during construction and DataSegmentReceivedCallback.
+    LTP_LIB_EXPORT uint64_t GetMemoryFootprintBytes() const;
 private:
-    std::set<LtpFragmentSet::data_fragment_t> m_receivedDataFragmentsSet;
+    LTP_LIB_NO_EXPORT void ReturnRedPartBufferToRecyclePool();
+    LTP_LIB_NO_EXPORT bool SpillRedPartToDisk(const uint64_t redPartCapacityBytes);
+    LtpFragmentIntervalSet m_receivedDataFragmentsSet;
     std::map<uint64_t, Ltp::report_segment_t> m_mapAllReportSegmentsSent;
     std::map<uint64_t, Ltp::report_segment_t> m_mapPrimaryReportSegmentsSent;
-    std::set<LtpFragmentSet::data_fragment_t> m_receivedDataFragmentsThatSenderKnowsAboutSet;
+    LtpFragmentIntervalSet m_receivedDataFragmentsThatSenderKnowsAboutSet;
     std::set<uint64_t> m_checkpointSerialNumbersReceivedSet;
     std::queue<std::pair<uint64_t, uint8_t> > m_reportSerialNumbersToSendQueue; //pair<reportSerialNumber, retryCount>
     LtpTimerManager<uint64_t> m_timeManagerOfReportSerialNumbers;
     uint64_t m_nextReportSegmentReportSerialNumber;
     padded_vector_uint8_t m_dataReceivedRed;
+    std::vector<padded_vector_uint8_t> & m_redPartBufferRecyclePoolRef;
+    std::unique_ptr<LtpRedPartFile> m_redPartFilePtr; //non-null once the red part has been spilled to disk (m_dataReceivedRed is then unused)
+    const uint64_t M_RX_SPILL_TO_DISK_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE;
+    const boost::filesystem::path & M_RX_SPILL_DIRECTORY_REF;
     const uint64_t M_MAX_RECEPTION_CLAIMS;
     const uint64_t M_ESTIMATED_BYTES_TO_RECEIVE;
     const uint64_t M_MAX_RED_RX_BYTES;
@@ -90,6 +109,7 @@ public:
     uint64_t m_numReportSegmentsUnableToBeIssued;
     uint64_t m_numReportSegmentsTooLargeAndNeedingSplit;
     uint64_t m_numReportSegmentsCreatedViaSplit;
+    const uint64_t m_creationTimestampNanoseconds; //session duration is recorded to the "ltp.receiveSessionDuration" metric on destruction
 };
 
 #endif // LTP_SESSION_RECEIVER_H
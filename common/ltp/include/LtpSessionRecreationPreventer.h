@@ -18,6 +18,15 @@
  * It was created during testing of sending large UDP packets with IP fragmentation to
  * help mitigate an anomaly that was seen where old closed session numbers would
  * reappear much later during a multi-session transmission.
+ *
+ * The history is a fixed memory cuckoo filter (buckets of 4 fingerprints, two candidate buckets
+ * per session number) paired with a FIFO ring of the inserted fingerprints so that the oldest
+ * session number is forgotten when the history is full.  Membership tests look at 8 slots without
+ * branching on their contents, and insertion is O(1) amortized, so millions of session numbers can be
+ * remembered for about 8 bytes (ring) plus 5 to 10 bytes (filter) each.
+ * Being a filter, ContainsSession may return a false positive (an unseen session number
+ * reported as previously received, which AddSession then rejects) with probability of at most
+ * 8 / 2^fingerprintBits per lookup (about 1.9e-9 for the default 32 bits, 1.2e-4 for 16 bits).
  */
 
 #ifndef LTP_SESSION_RECREATION_PREVENTER_H
@@ -25,7 +34,6 @@
 
 #include <cstdint>
 #include <vector>
-#include <unordered_set>
 #include "ltp_lib_export.h"
 
 class LtpSessionRecreationPreventer {
@@ -33,18 +41,35 @@ private:
     LtpSessionRecreationPreventer();
 public:
     
-    LTP_LIB_EXPORT LtpSessionRecreationPreventer(const uint64_t numReceivedSessionsToRemember);
+    //fingerprintBits (8 to 32) sets the false positive rate (see above), memory use does not depend on it
+    LTP_LIB_EXPORT LtpSessionRecreationPreventer(const uint64_t numReceivedSessionsToRemember, const unsigned int fingerprintBits = 32);
     LTP_LIB_EXPORT ~LtpSessionRecreationPreventer();
     
     LTP_LIB_EXPORT bool AddSession(const uint64_t newSessionNumber);
     LTP_LIB_EXPORT bool ContainsSession(const uint64_t newSessionNumber) const;
+    //number of remembered sessions forgotten early because the filter could not place them (should stay 0)
+    LTP_LIB_EXPORT uint64_t GetNumInsertionFailures() const;
 
 private:
+    static constexpr unsigned int SLOTS_PER_BUCKET = 4;
+    static constexpr unsigned int MAX_KICKS = 500;
+
+    LTP_LIB_NO_EXPORT void Hash(const uint64_t sessionNumber, uint32_t & bucketIndex, uint32_t & fingerprint) const;
+    LTP_LIB_NO_EXPORT uint32_t AltBucketIndex(const uint32_t bucketIndex, const uint32_t fingerprint) const;
+    LTP_LIB_NO_EXPORT bool BucketContains(const uint32_t bucketIndex, const uint32_t fingerprint) const;
+    LTP_LIB_NO_EXPORT bool TryInsertIntoBucket(const uint32_t bucketIndex, const uint32_t fingerprint);
+    LTP_LIB_NO_EXPORT bool RemoveFromBucket(const uint32_t bucketIndex, const uint32_t fingerprint);
+    LTP_LIB_NO_EXPORT void Insert(uint32_t bucketIndex, uint32_t fingerprint);
+
     const uint64_t M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER;
-    std::unordered_set<uint64_t> m_previouslyReceivedSessionNumbersUnorderedSet;
-    std::vector<uint64_t> m_previouslyReceivedSessionNumbersQueueVector;
-    bool m_queueIsFull;
-    uint64_t m_nextQueueIndex;
+    const uint32_t M_FINGERPRINT_MASK;
+    uint32_t m_bucketIndexMask;
+    std::vector<uint32_t> m_fingerprintSlots; //0 => empty slot
+    std::vector<uint64_t> m_fifoRingBucketIndexAndFingerprint; //(bucketIndex << 32) | fingerprint of each remembered session, oldest at m_nextRingIndex when full
+    bool m_ringIsFull;
+    uint64_t m_nextRingIndex;
+    uint32_t m_kickCounter;
+    uint64_t m_numInsertionFailures;
 };
 
 #endif // LTP_SESSION_RECREATION_PREVENTER_H
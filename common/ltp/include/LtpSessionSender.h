@@ -21,6 +21,7 @@
 #define LTP_SESSION_SENDER_H 1
 
 #include "LtpFragmentSet.h"
+#include "LtpFragmentIntervalSet.h"
 #include "Ltp.h"
 #include "LtpRandomNumberGenerator.h"
 #include <queue>
@@ -29,6 +30,8 @@
 #include "LtpTimerManager.h"
 #include "LtpNoticesToClientService.h"
 #include "LtpClientServiceDataToSend.h"
+#include "LtpHeaderBufferPool.h"
+#include "LtpAdaptiveController.h"
 
 
 
@@ -42,36 +45,62 @@ class LtpSessionSender {
 private:
     LtpSessionSender();
     void LtpCheckpointTimerExpiredCallback(uint64_t checkpointSerialNumber, std::vector<uint8_t> & userData);
+    void GenerateDataSegmentHeader(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback,
+        LTP_DATA_SEGMENT_TYPE_FLAGS flags, const Ltp::data_segment_metadata_t & meta);
 public:
     struct LTP_LIB_EXPORT resend_fragment_t {
         resend_fragment_t() {}
         resend_fragment_t(uint64_t paramOffset, uint64_t paramLength, uint64_t paramCheckpointSerialNumber, uint64_t paramReportSerialNumber, LTP_DATA_SEGMENT_TYPE_FLAGS paramFlags) :
-            offset(paramOffset), length(paramLength), checkpointSerialNumber(paramCheckpointSerialNumber), reportSerialNumber(paramReportSerialNumber), flags(paramFlags), retryCount(1) {}
+            offset(paramOffset), length(paramLength), checkpointSerialNumber(paramCheckpointSerialNumber), reportSerialNumber(paramReportSerialNumber), flags(paramFlags), retryCount(1),
+            checkpointSentTimestampNanoseconds(0) {}
         uint64_t offset;
         uint64_t length;
         uint64_t checkpointSerialNumber;
         uint64_t reportSerialNumber;
         LTP_DATA_SEGMENT_TYPE_FLAGS flags;
         uint8_t retryCount;
+        uint64_t checkpointSentTimestampNanoseconds; //for round trip time samples
+    };
+    struct LTP_LIB_EXPORT session_stats_t {
+        session_stats_t() : numDataSegmentsSent(0), numDataSegmentsResent(0), numRedBytesResent(0), numCheckpointsSent(0), numReportSegmentsReceived(0),
+            numRedBytesAcked(0), numRoundTripTimeSamples(0), lastRoundTripTimeNanoseconds(0), minRoundTripTimeNanoseconds(0), maxRoundTripTimeNanoseconds(0) {}
+        uint64_t numDataSegmentsSent; //including resends
+        uint64_t numDataSegmentsResent;
+        uint64_t numRedBytesResent;
+        uint64_t numCheckpointsSent; //including resends
+        uint64_t numReportSegmentsReceived; //excluding duplicates
+        uint64_t numRedBytesAcked;
+        uint64_t numRoundTripTimeSamples; //checkpoint sent to report segment received (checkpoints sent only once)
+        uint64_t lastRoundTripTimeNanoseconds;
+        uint64_t minRoundTripTimeNanoseconds;
+        uint64_t maxRoundTripTimeNanoseconds;
     };
     LTP_LIB_EXPORT ~LtpSessionSender();
     LTP_LIB_EXPORT LtpSessionSender(uint64_t randomInitialSenderCheckpointSerialNumber, LtpClientServiceDataToSend && dataToSend,
         std::shared_ptr<LtpTransmissionRequestUserData> && userDataPtrToTake, uint64_t lengthOfRedPart, const uint64_t MTU,
         const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
+        LtpHeaderBufferPool & headerBufferPoolRef,
         const NotifyEngineThatThisSenderNeedsDeletedCallback_t & notifyEngineThatThisSenderNeedsDeletedCallback,
         const NotifyEngineThatThisSenderHasProducibleDataFunction_t & notifyEngineThatThisSenderHasProducibleDataFunction,
         const InitialTransmissionCompletedCallback_t & initialTransmissionCompletedCallback,
-        const uint64_t checkpointEveryNthDataPacket = 0, const uint32_t maxRetriesPerSerialNumber = 5);
+        const uint64_t checkpointEveryNthDataPacket = 0, const uint32_t maxRetriesPerSerialNumber = 5,
+        LtpAdaptiveController * adaptiveControllerPtr = NULL);
     LTP_LIB_EXPORT bool NextDataToSend(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback);
     
 
     
     LTP_LIB_EXPORT void ReportSegmentReceivedCallback(const Ltp::report_segment_t & reportSegment,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    //the client service data held for (re)transmission, charged against the engine's memory budget
+    LTP_LIB_EXPORT uint64_t GetMemoryFootprintBytes() const;
     
 private:
-    std::set<LtpFragmentSet::data_fragment_t> m_dataFragmentsAckedByReceiver;
+    void StartCheckpointTimer(resend_fragment_t & resendFragment);
+
+    LtpFragmentIntervalSet m_dataFragmentsAckedByReceiver;
+    std::vector<LtpFragmentSet::data_fragment_t> m_fragmentsNeedingResent; //reused by ReportSegmentReceivedCallback
+    std::vector<uint8_t> m_checkpointUserDataTemp; //reused by ReportSegmentReceivedCallback
     std::queue<std::vector<uint8_t> > m_nonDataToSend;
     std::queue<resend_fragment_t> m_resendFragmentsQueue;
     std::set<uint64_t> m_reportSegmentSerialNumbersReceivedSet;
@@ -90,8 +119,10 @@ private:
     const uint64_t M_CLIENT_SERVICE_ID;
     const uint64_t M_CHECKPOINT_EVERY_NTH_DATA_PACKET;
     uint64_t m_checkpointEveryNthDataPacketCounter;
+    LtpAdaptiveController * const m_adaptiveControllerPtr; //owned by the engine, NULL if adaptive mode is disabled
     const uint32_t M_MAX_RETRIES_PER_SERIAL_NUMBER;
     boost::asio::io_service & m_ioServiceRef;
+    LtpHeaderBufferPool & m_headerBufferPoolRef; //data segment headers are serialized into the engine's pool (released by the engine on send completion)
     const NotifyEngineThatThisSenderNeedsDeletedCallback_t m_notifyEngineThatThisSenderNeedsDeletedCallback;
     const NotifyEngineThatThisSenderHasProducibleDataFunction_t m_notifyEngineThatThisSenderHasProducibleDataFunction;
     const InitialTransmissionCompletedCallback_t m_initialTransmissionCompletedCallback;
@@ -100,6 +131,8 @@ public:
     //stats
     uint64_t m_numCheckpointTimerExpiredCallbacks;
     uint64_t m_numDiscretionaryCheckpointsNotResent;
+    session_stats_t m_sessionStats;
+    const uint64_t m_creationTimestampNanoseconds; //session duration is recorded to the "ltp.sendSessionDuration" metric on destruction
 };
 
 #endif // LTP_SESSION_SENDER_H
@@ -16,7 +16,8 @@
  * This LtpTimerManager templated class encapsulates one boost::asio::deadline_timer for use with one LTP session.
  * The boost::asio::deadline_timer uses/shares the user's provided boost::asio::io_service.
  * This is a single threaded class designed to run and be called from one ioService thread only.
- * Time expiration is based on 2*(one_way_light_time + one_way_margin_time)
+ * Time expiration is based on 2*(one_way_light_time + one_way_margin_time) unless changed by SetTransmissionToAckReceivedTime
+ * (i.e. by an LtpAdaptiveController), which only affects timers started afterwards.
  * Explicit template instantiation is defined in its .cpp file for idType of Ltp::session_id_t and uint64_t.
  * The idType is a "serial number" used to associate an expiry time with. 
  */
@@ -40,6 +41,7 @@ public:
     LTP_LIB_EXPORT LtpTimerManager(boost::asio::io_service & ioService, const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, const LtpTimerExpiredCallback_t & callback);
     LTP_LIB_EXPORT ~LtpTimerManager();
     LTP_LIB_EXPORT void Reset();
+    LTP_LIB_EXPORT void SetTransmissionToAckReceivedTime(const boost::posix_time::time_duration & transmissionToAckReceivedTime);
        
     LTP_LIB_EXPORT bool StartTimer(const idType serialNumber, std::vector<uint8_t> userData = std::vector<uint8_t>());
     LTP_LIB_EXPORT bool DeleteTimer(const idType serialNumber);
@@ -52,7 +54,7 @@ private:
     boost::asio::deadline_timer m_deadlineTimer;
     const boost::posix_time::time_duration M_ONE_WAY_LIGHT_TIME;
     const boost::posix_time::time_duration M_ONE_WAY_MARGIN_TIME;
-    const boost::posix_time::time_duration M_TRANSMISSION_TO_ACK_RECEIVED_TIME;
+    boost::posix_time::time_duration m_transmissionToAckReceivedTime;
     const LtpTimerExpiredCallback_t m_ltpTimerExpiredCallbackFunction;
     //boost::bimap<idType, boost::posix_time::ptime> m_bimapCheckpointSerialNumberToExpiry;
     //std::map<idType, std::vector<uint8_t> > m_mapSerialNumberToUserData;
@@ -16,6 +16,9 @@
  * This LtpUdpEngine class is a child class of LtpEngine.
  * It manages a reference to a bidirectional udp socket
  * and a circular buffer of incoming UDP packets to feed into the LtpEngine.
+ * When the LtpUdpEngineManager receives on more than one socket, each receive socket
+ * gets its own single producer single consumer circular buffer (allocated on its first packet),
+ * so that the handoff from any receive thread to the LtpEngine thread stays lock-free.
  */
 
 
@@ -28,6 +31,8 @@
 #include <vector>
 #include <map>
 #include <queue>
+#include <array>
+#include <atomic>
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "LtpEngine.h"
 
@@ -43,18 +48,27 @@ public:
         const boost::asio::ip::udp::endpoint & remoteEndpoint, const unsigned int numUdpRxCircularBufferVectors,
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
         uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
-        const uint64_t maxSimultaneousSessions, const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable);
+        const uint64_t maxSimultaneousSessions, const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable,
+        const unsigned int numUdpRxSockets = 1);
 
     LTP_LIB_EXPORT virtual ~LtpUdpEngine();
 
     LTP_LIB_EXPORT virtual void Reset();
     
-    LTP_LIB_EXPORT void PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size);
+    //only one thread may post for a given rxSocketIndex
+    LTP_LIB_EXPORT void PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size, const unsigned int rxSocketIndex = 0);
 
 private:
+    struct udp_rx_queue_t {
+        udp_rx_queue_t(const unsigned int numCircularBufferVectors, const uint64_t maxUdpRxPacketSizeBytes);
+        CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
+        std::vector<std::vector<boost::uint8_t> > m_udpReceiveBuffersCbVec;
+        bool m_printedCbTooSmallNotice;
+    };
+    LTP_LIB_NO_EXPORT void PacketInFromRxQueue(const unsigned int rxSocketIndex, const uint8_t * data, const std::size_t size);
     LTP_LIB_NO_EXPORT virtual void PacketInFullyProcessedCallback(bool success);
     LTP_LIB_NO_EXPORT virtual void SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId);
-    LTP_LIB_NO_EXPORT void HandleUdpSend(boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const boost::system::error_code& error, std::size_t bytes_transferred);
+    LTP_LIB_NO_EXPORT void HandleUdpSend(boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const void * headerPtr, const boost::system::error_code& error, std::size_t bytes_transferred);
 
     
 
@@ -67,15 +81,13 @@ private:
 
     const unsigned int M_NUM_CIRCULAR_BUFFER_VECTORS;
     const uint64_t M_MAX_UDP_RX_PACKET_SIZE_BYTES;
-    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
-    std::vector<std::vector<boost::uint8_t> > m_udpReceiveBuffersCbVec;
-
-    bool m_printedCbTooSmallNotice;
+    std::vector<std::unique_ptr<udp_rx_queue_t> > m_udpRxQueues; //one per receive socket
+    unsigned int m_rxSocketIndexOfPacketBeingProcessed; //LtpEngine thread only
 
 public:
     volatile uint64_t m_countAsyncSendCalls;
     volatile uint64_t m_countAsyncSendCallbackCalls;
-    uint64_t m_countCircularBufferOverruns;
+    std::atomic<uint64_t> m_countCircularBufferOverruns;
 
     //unit testing drop packet simulation stuff
     UdpDropSimulatorFunction_t m_udpDropSimulatorFunction;
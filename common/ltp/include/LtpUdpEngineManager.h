@@ -18,6 +18,12 @@
  * It manages a bidirectional udp socket paired with its own boost::asio::io_service and thread.
  * It quickly examines the first few bytes of incoming UDP packets so that it can
  * route them to their proper LtpUdpEngine.
+ * Routing is O(1) and lock-free: inducts are found by the session originator engine id in a flat
+ * open addressing hash table, and outducts by the engine index encoded into the session number in a flat array.
+ * With more than one receive socket (Linux SO_REUSEPORT), additional receive-only sockets are bound to the same port,
+ * each with its own io_service thread and receive buffer, and the kernel spreads incoming packets across them
+ * by source address so that the receive rate of many remote engines on one port scales with cores.
+ * All sends and engine management stay on the first socket's io_service thread.
  */
 
 #ifndef _LTP_UDP_ENGINE_MANAGER_H
@@ -28,6 +34,8 @@
 #include <boost/asio.hpp>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <memory>
 #include "LtpUdpEngine.h"
 
 //Every "link" should have a unique engine ID, managed by using the remote eid that the link will be connecting to as the engine id for LTP
@@ -35,7 +43,7 @@
 class LtpUdpEngineManager {
 private:
     LtpUdpEngineManager();
-    LTP_LIB_EXPORT LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bool autoStart); //LtpUdpEngineManager can only be created by the GetOrCreateInstance() function
+    LTP_LIB_EXPORT LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bool autoStart, const unsigned int numUdpRxSockets); //LtpUdpEngineManager can only be created by the GetOrCreateInstance() function
 public:
     LTP_LIB_EXPORT ~LtpUdpEngineManager();
 
@@ -65,11 +73,18 @@ public:
     LTP_LIB_EXPORT void DoUdpShutdown();
     
     LTP_LIB_EXPORT bool ReadyToForward();
+    LTP_LIB_EXPORT unsigned int GetNumUdpRxSockets() const;
 private:
-    LTP_LIB_NO_EXPORT void StartUdpReceive();
-    LTP_LIB_NO_EXPORT void HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT void StartUdpReceive(const unsigned int rxSocketIndex);
+    LTP_LIB_NO_EXPORT void HandleUdpReceive(const unsigned int rxSocketIndex, const boost::system::error_code & error, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT void DoUdpShutdownFromRxThread(const unsigned int rxSocketIndex);
+    LTP_LIB_NO_EXPORT void CloseAdditionalUdpRxSocket(const unsigned int rxSocketIndex);
+    LTP_LIB_NO_EXPORT void WaitForAdditionalUdpRxThreadsToBeIdle();
+    LTP_LIB_NO_EXPORT bool InsertReceiverEngine(const uint64_t remoteEngineId, LtpUdpEngine * ltpUdpEnginePtr);
+    LTP_LIB_NO_EXPORT LtpUdpEngine * FindReceiverEngine(const uint64_t remoteEngineId) const;
 public:
-    LTP_LIB_EXPORT static std::shared_ptr<LtpUdpEngineManager> GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart);
+    //numUdpRxSockets only applies when the instance for the port is created
+    LTP_LIB_EXPORT static std::shared_ptr<LtpUdpEngineManager> GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart, const unsigned int numUdpRxSockets = 1);
     LTP_LIB_EXPORT static void SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t maxUdpRxPacketSizeBytesForAllLtp);
 private:
     //LtpUdpEngineManager(); 
@@ -80,6 +95,7 @@ private:
 
 
     const uint16_t M_MY_BOUND_UDP_PORT;
+    const unsigned int M_NUM_UDP_RX_SOCKETS;
     boost::asio::io_service m_ioServiceUdp;
     boost::asio::ip::udp::resolver m_resolver;
     boost::asio::ip::udp::socket m_udpSocket;
@@ -89,10 +105,33 @@ private:
     
     std::vector<boost::uint8_t> m_udpReceiveBuffer;
     boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
+
+    //receive only sockets (index 1 and up) sharing the bound port
+    struct additional_udp_rx_socket_t {
+        additional_udp_rx_socket_t(const uint64_t maxUdpRxPacketSizeBytes);
+        boost::asio::io_service m_ioService;
+        boost::asio::ip::udp::socket m_udpSocket;
+        std::vector<boost::uint8_t> m_udpReceiveBuffer;
+        boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
+        std::unique_ptr<boost::thread> m_ioServiceThreadPtr;
+    };
+    std::vector<std::unique_ptr<additional_udp_rx_socket_t> > m_additionalUdpRxSockets;
+
     //std::map<std::pair<uint64_t, bool>, std::unique_ptr<LtpUdpEngine> > m_mapSessionOriginatorEngineIdPlusIsInductToLtpUdpEnginePtr;
-    std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr; //inducts (differentiate by remote engine id using this map)
+    std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr; //inducts (owns them; receive threads use m_receiverHashTable)
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr; //outducts (differentiate by engine index encoded into the session number, cannot use this map)
-    std::vector<LtpUdpEngine*> m_vecEngineIndexToLtpUdpEngineTransmitterPtr;
+
+    //inducts by remote engine id (open addressing with linear probing), read lock-free by the receive threads.
+    //A slot's remote engine id never changes once the slot is in use, so removal only clears the engine pointer.
+    static constexpr unsigned int RECEIVER_HASH_TABLE_SIZE_BITS = 10;
+    static constexpr unsigned int RECEIVER_HASH_TABLE_SIZE = 1u << RECEIVER_HASH_TABLE_SIZE_BITS;
+    struct receiver_hash_table_slot_t {
+        uint64_t remoteEngineId;
+        std::atomic<LtpUdpEngine*> ltpUdpEnginePtr;
+        std::atomic<bool> inUse;
+    };
+    std::unique_ptr<receiver_hash_table_slot_t[]> m_receiverHashTable;
+    std::unique_ptr<std::atomic<LtpUdpEngine*>[]> m_engineIndexToLtpUdpEngineTransmitterPtr; //256 entries
     unsigned int m_nextEngineIndex;
 
     volatile bool m_readyToForward;
@@ -329,6 +329,9 @@ Ltp::~Ltp() {
 void Ltp::SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback) {
     m_dataSegmentContentsReadCallback = callback;
 }
+void Ltp::SetDataSegmentContentsReadInPlaceCallback(const DataSegmentContentsReadInPlaceCallback_t & callback) {
+    m_dataSegmentContentsReadInPlaceCallback = callback;
+}
 void Ltp::SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback) {
     m_reportSegmentContentsReadCallback = callback;
 }
@@ -677,6 +680,16 @@ bool Ltp::HandleReceivedChars(const uint8_t * rxVals, std::size_t numChars, std:
                     }
                 }
             }
+            else if ((dataSegmentRxState == LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_DATA) && m_dataSegmentContentsReadInPlaceCallback
+                && m_dataSegment_clientServiceData.empty() && (m_numTrailerExtensionTlvs == 0) && (numChars >= (m_dataSegmentMetadata.length - 1)))
+            {
+                //all of the client service data is in rxVals (rxVal being its first byte), so skip over it and pass it in place
+                const uint8_t * const clientServiceData = rxVals - 1;
+                rxVals += (m_dataSegmentMetadata.length - 1);
+                numChars -= (m_dataSegmentMetadata.length - 1);
+                m_dataSegmentContentsReadInPlaceCallback(m_segmentTypeFlags, m_sessionId, clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+                SetBeginningState();
+            }
             else if (dataSegmentRxState == LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_DATA) {
                 m_dataSegment_clientServiceData.push_back(rxVal);
                 if (m_dataSegment_clientServiceData.size() == m_dataSegmentMetadata.length) {
@@ -688,9 +701,7 @@ bool Ltp::HandleReceivedChars(const uint8_t * rxVals, std::size_t numChars, std:
                     }
                     else {
                         //callback data segment
-                        if (m_dataSegmentContentsReadCallback) {
-                            m_dataSegmentContentsReadCallback(m_segmentTypeFlags, m_sessionId, m_dataSegment_clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
-                        }
+                        DataSegmentContentsReadCallbackFromVec();
                         SetBeginningState();
                     }
                 }
@@ -1023,9 +1034,7 @@ bool Ltp::NextStateAfterTrailerExtensions(std::string & errorMessage) {
     }
     else if (m_segmentTypeFlags <= 7) {
         //callback data segment
-        if (m_dataSegmentContentsReadCallback) {
-            m_dataSegmentContentsReadCallback(m_segmentTypeFlags, m_sessionId, m_dataSegment_clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
-        }
+        DataSegmentContentsReadCallbackFromVec();
     }
     else if (m_segmentTypeFlags == 8) {
         //callback report segment
@@ -1049,6 +1058,15 @@ bool Ltp::NextStateAfterTrailerExtensions(std::string & errorMessage) {
     return true;
 }
 
+void Ltp::DataSegmentContentsReadCallbackFromVec() {
+    if (m_dataSegmentContentsReadInPlaceCallback) {
+        m_dataSegmentContentsReadInPlaceCallback(m_segmentTypeFlags, m_sessionId, m_dataSegment_clientServiceData.data(), m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+    }
+    else if (m_dataSegmentContentsReadCallback) {
+        m_dataSegmentContentsReadCallback(m_segmentTypeFlags, m_sessionId, m_dataSegment_clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+    }
+}
+
 //Preconditions before call:
 //m_sdnvTempVec.clear();
 //m_dataSegmentRxState = LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_ID_SDNV;
@@ -1474,14 +1492,18 @@ void Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(std::vector<uint8_t> & ltpHea
     const session_id_t & sessionId, const data_segment_metadata_t & dataSegmentMetadata,
     ltp_extensions_t * headerExtensions, uint8_t numTrailerExtensions)
 {
-    uint8_t numHeaderExtensions = 0;
-    uint64_t maxBytesRequiredForHeaderExtensions = 0;
-    if (headerExtensions) {
-        numHeaderExtensions = static_cast<uint8_t>(headerExtensions->extensionsVec.size());
-        maxBytesRequiredForHeaderExtensions = headerExtensions->GetMaximumDataRequiredForSerialization();
-    }
+    const uint64_t maxBytesRequiredForHeaderExtensions = (headerExtensions) ? headerExtensions->GetMaximumDataRequiredForSerialization() : 0;
     ltpHeaderPlusDataSegmentMetadata.resize(1 + 1 + (2 * 10) + dataSegmentMetadata.GetMaximumDataRequiredForSerialization() + maxBytesRequiredForHeaderExtensions); //flags + extensionCounts + 2 10-byte session sdnvs + metadata sdnvs + header extensions
-    uint8_t * encodedPtr = ltpHeaderPlusDataSegmentMetadata.data();
+    ltpHeaderPlusDataSegmentMetadata.resize(GenerateLtpHeaderPlusDataSegmentMetadata(ltpHeaderPlusDataSegmentMetadata.data(), dataSegmentTypeFlags,
+        sessionId, dataSegmentMetadata, headerExtensions, numTrailerExtensions));
+}
+
+uint64_t Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(uint8_t * ltpHeaderPlusDataSegmentMetadata, LTP_DATA_SEGMENT_TYPE_FLAGS dataSegmentTypeFlags,
+    const session_id_t & sessionId, const data_segment_metadata_t & dataSegmentMetadata,
+    ltp_extensions_t * headerExtensions, uint8_t numTrailerExtensions)
+{
+    const uint8_t numHeaderExtensions = (headerExtensions) ? static_cast<uint8_t>(headerExtensions->extensionsVec.size()) : 0;
+    uint8_t * encodedPtr = ltpHeaderPlusDataSegmentMetadata;
     *encodedPtr++ = static_cast<uint8_t>(dataSegmentTypeFlags); //assumes version 0 in most significant 4 bits
     encodedPtr += SdnvEncodeU64BufSize10(encodedPtr, sessionId.sessionOriginatorEngineId);
     encodedPtr += SdnvEncodeU64BufSize10(encodedPtr, sessionId.sessionNumber);
@@ -1490,7 +1512,7 @@ void Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(std::vector<uint8_t> & ltpHea
         encodedPtr += headerExtensions->Serialize(encodedPtr);
     }
     encodedPtr += dataSegmentMetadata.Serialize(encodedPtr);
-    ltpHeaderPlusDataSegmentMetadata.resize(encodedPtr - ltpHeaderPlusDataSegmentMetadata.data());
+    return static_cast<uint64_t>(encodedPtr - ltpHeaderPlusDataSegmentMetadata);
 }
 
 void Ltp::GenerateReportSegmentLtpPacket(std::vector<uint8_t> & ltpReportSegmentPacket, const session_id_t & sessionId, const report_segment_t & reportSegmentStruct,
@@ -0,0 +1,188 @@
+/**
+ * @file LtpAdaptiveController.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpAdaptiveController.h"
+#include <algorithm>
+
+//pacing gains as in BBR (scaled by 1/4)
+static constexpr uint64_t STARTUP_PACING_GAIN_QUARTERS = 12; //~2/ln(2)
+static const uint64_t PROBE_BANDWIDTH_PACING_GAIN_QUARTERS[LtpAdaptiveController::NUM_PACING_GAIN_CYCLE_PHASES] = { 5, 3, 4, 4, 4, 4, 4, 4 };
+static constexpr unsigned int FULL_BANDWIDTH_COUNT = 3; //startup ends after this many samples without 25% growth
+static constexpr double STARTUP_LOSS_RATE_THRESHOLD = 0.02; //or when the loss within one sample exceeds 2%
+
+LtpAdaptiveController::LtpAdaptiveController(const uint64_t minSendRateBitsPerSec, const uint64_t maxSendRateBitsPerSec,
+    const uint64_t minCheckpointEveryNthDataPacket, const uint64_t maxCheckpointEveryNthDataPacket,
+    const uint64_t minCheckpointTimeoutNanoseconds, const uint64_t maxCheckpointTimeoutNanoseconds) :
+    M_MIN_SEND_RATE_BITS_PER_SEC(minSendRateBitsPerSec),
+    m_maxSendRateBitsPerSec(std::max(minSendRateBitsPerSec, maxSendRateBitsPerSec)),
+    M_MIN_CHECKPOINT_EVERY_NTH_DATA_PACKET(std::max<uint64_t>(minCheckpointEveryNthDataPacket, 1)),
+    M_MAX_CHECKPOINT_EVERY_NTH_DATA_PACKET(std::max<uint64_t>(maxCheckpointEveryNthDataPacket, M_MIN_CHECKPOINT_EVERY_NTH_DATA_PACKET)),
+    M_MIN_CHECKPOINT_TIMEOUT_NANOSECONDS(std::min(minCheckpointTimeoutNanoseconds, maxCheckpointTimeoutNanoseconds)),
+    M_MAX_CHECKPOINT_TIMEOUT_NANOSECONDS(maxCheckpointTimeoutNanoseconds),
+    m_sendRateBitsPerSec(0)
+{
+    Reset();
+}
+
+void LtpAdaptiveController::Reset() {
+    m_smoothedRoundTripTimeNanoseconds = 0;
+    m_roundTripTimeVariationNanoseconds = 0;
+    m_timeoutBackoffShift = 0;
+
+    m_decayedLostBytes = 0;
+    m_decayedScopeBytes = 0;
+    m_intervalLostBytes = 0;
+    m_intervalScopeBytes = 0;
+
+    m_intervalStartNanoseconds = 0;
+    m_intervalDeliveredBytes = 0;
+    m_sendWasLimitedByRateThisInterval = false;
+    for (unsigned int i = 0; i < BANDWIDTH_FILTER_LENGTH; ++i) {
+        m_bandwidthFilterBytesPerSec[i] = 0;
+    }
+    m_bandwidthFilterIndex = 0;
+    m_bottleneckBandwidthBytesPerSec = 0;
+    m_isInStartup = true;
+    m_fullBandwidthBytesPerSec = 0;
+    m_fullBandwidthCount = 0;
+    m_pacingGainCycleIndex = 0;
+
+    UpdateCheckpointTimeout();
+    UpdateCheckpointInterval();
+    UpdateSendRate();
+}
+
+void LtpAdaptiveController::SetMaxSendRate(const uint64_t maxSendRateBitsPerSec) {
+    m_maxSendRateBitsPerSec = std::max(M_MIN_SEND_RATE_BITS_PER_SEC, maxSendRateBitsPerSec);
+    UpdateSendRate();
+}
+
+void LtpAdaptiveController::OnRoundTripTimeSample(const uint64_t roundTripTimeNanoseconds) {
+    //RFC 6298 section 2
+    if (m_smoothedRoundTripTimeNanoseconds == 0) {
+        m_smoothedRoundTripTimeNanoseconds = std::max<uint64_t>(roundTripTimeNanoseconds, 1);
+        m_roundTripTimeVariationNanoseconds = roundTripTimeNanoseconds >> 1;
+    }
+    else {
+        const uint64_t absDiff = (m_smoothedRoundTripTimeNanoseconds > roundTripTimeNanoseconds) ?
+            (m_smoothedRoundTripTimeNanoseconds - roundTripTimeNanoseconds) : (roundTripTimeNanoseconds - m_smoothedRoundTripTimeNanoseconds);
+        m_roundTripTimeVariationNanoseconds = ((m_roundTripTimeVariationNanoseconds * 3) + absDiff) >> 2;
+        m_smoothedRoundTripTimeNanoseconds = std::max<uint64_t>(((m_smoothedRoundTripTimeNanoseconds * 7) + roundTripTimeNanoseconds) >> 3, 1);
+    }
+    m_timeoutBackoffShift = 0;
+    UpdateCheckpointTimeout();
+}
+
+void LtpAdaptiveController::OnCheckpointTimerExpired() {
+    //RFC 6298 section 5.5
+    if (m_timeoutBackoffShift < MAX_TIMEOUT_BACKOFF_SHIFT) {
+        ++m_timeoutBackoffShift;
+        UpdateCheckpointTimeout();
+    }
+}
+
+void LtpAdaptiveController::UpdateCheckpointTimeout() {
+    if (m_smoothedRoundTripTimeNanoseconds == 0) {
+        m_checkpointTimeoutNanoseconds = M_MAX_CHECKPOINT_TIMEOUT_NANOSECONDS;
+        return;
+    }
+    const uint64_t timeout = (m_smoothedRoundTripTimeNanoseconds + (m_roundTripTimeVariationNanoseconds << 2)) << m_timeoutBackoffShift;
+    m_checkpointTimeoutNanoseconds = std::min(std::max(timeout, M_MIN_CHECKPOINT_TIMEOUT_NANOSECONDS), M_MAX_CHECKPOINT_TIMEOUT_NANOSECONDS);
+}
+
+void LtpAdaptiveController::OnFirstPassReportClaims(const uint64_t reportScopeBytes, const uint64_t claimedBytes) {
+    if ((reportScopeBytes == 0) || (claimedBytes > reportScopeBytes)) {
+        return;
+    }
+    const uint64_t lostBytes = reportScopeBytes - claimedBytes;
+    m_decayedLostBytes = (m_decayedLostBytes * 0.875) + lostBytes;
+    m_decayedScopeBytes = (m_decayedScopeBytes * 0.875) + reportScopeBytes;
+    m_intervalLostBytes += lostBytes;
+    m_intervalScopeBytes += reportScopeBytes;
+    UpdateCheckpointInterval();
+}
+
+void LtpAdaptiveController::UpdateCheckpointInterval() {
+    //one expected lost data segment per checkpoint interval
+    const double lossRate = GetLossRate();
+    const double expectedPacketsPerLoss = (lossRate > 0) ? (1.0 / lossRate) : static_cast<double>(M_MAX_CHECKPOINT_EVERY_NTH_DATA_PACKET);
+    const uint64_t interval = (expectedPacketsPerLoss >= static_cast<double>(M_MAX_CHECKPOINT_EVERY_NTH_DATA_PACKET)) ?
+        M_MAX_CHECKPOINT_EVERY_NTH_DATA_PACKET : static_cast<uint64_t>(expectedPacketsPerLoss + 0.5);
+    m_checkpointEveryNthDataPacket = std::max(interval, M_MIN_CHECKPOINT_EVERY_NTH_DATA_PACKET);
+}
+
+bool LtpAdaptiveController::OnBytesDelivered(const uint64_t nowNanoseconds, const uint64_t newlyAckedBytes) {
+    if (m_intervalStartNanoseconds == 0) { //the first report only starts the first interval
+        m_intervalStartNanoseconds = std::max<uint64_t>(nowNanoseconds, 1);
+        m_intervalDeliveredBytes = 0;
+        m_intervalLostBytes = 0;
+        m_intervalScopeBytes = 0;
+        m_sendWasLimitedByRateThisInterval = false;
+        return false;
+    }
+    m_intervalDeliveredBytes += newlyAckedBytes;
+    const uint64_t elapsedNanoseconds = nowNanoseconds - m_intervalStartNanoseconds;
+    if ((nowNanoseconds <= m_intervalStartNanoseconds) || (elapsedNanoseconds < std::max(m_smoothedRoundTripTimeNanoseconds, MIN_DELIVERY_RATE_SAMPLE_INTERVAL_NANOSECONDS))) {
+        return false;
+    }
+
+    //one delivery rate sample per round trip
+    const uint64_t deliveryRateBytesPerSec = static_cast<uint64_t>((static_cast<double>(m_intervalDeliveredBytes) * 1e9) / elapsedNanoseconds);
+    const bool isApplicationLimited = !m_sendWasLimitedByRateThisInterval;
+    const double intervalLossRate = (m_intervalScopeBytes) ? (static_cast<double>(m_intervalLostBytes) / m_intervalScopeBytes) : 0;
+    m_intervalStartNanoseconds = nowNanoseconds;
+    m_intervalDeliveredBytes = 0;
+    m_intervalLostBytes = 0;
+    m_intervalScopeBytes = 0;
+    m_sendWasLimitedByRateThisInterval = false;
+
+    if ((!isApplicationLimited) || (deliveryRateBytesPerSec > m_bottleneckBandwidthBytesPerSec)) {
+        m_bandwidthFilterBytesPerSec[m_bandwidthFilterIndex] = deliveryRateBytesPerSec;
+        m_bandwidthFilterIndex = (m_bandwidthFilterIndex + 1) % BANDWIDTH_FILTER_LENGTH;
+        m_bottleneckBandwidthBytesPerSec = *std::max_element(m_bandwidthFilterBytesPerSec, m_bandwidthFilterBytesPerSec + BANDWIDTH_FILTER_LENGTH);
+    }
+
+    if (m_isInStartup) {
+        if (!isApplicationLimited) {
+            if (m_bottleneckBandwidthBytesPerSec >= (m_fullBandwidthBytesPerSec + (m_fullBandwidthBytesPerSec >> 2))) { //still growing by 25%
+                m_fullBandwidthBytesPerSec = m_bottleneckBandwidthBytesPerSec;
+                m_fullBandwidthCount = 0;
+            }
+            else {
+                ++m_fullBandwidthCount;
+            }
+        }
+        if ((m_fullBandwidthCount >= FULL_BANDWIDTH_COUNT) || (intervalLossRate > STARTUP_LOSS_RATE_THRESHOLD)) {
+            m_isInStartup = false;
+            m_pacingGainCycleIndex = 1; //drain any queue built during startup
+        }
+    }
+    else {
+        m_pacingGainCycleIndex = (m_pacingGainCycleIndex + 1) % NUM_PACING_GAIN_CYCLE_PHASES;
+    }
+    return UpdateSendRate();
+}
+
+bool LtpAdaptiveController::UpdateSendRate() {
+    const uint64_t previousSendRateBitsPerSec = m_sendRateBitsPerSec;
+    if (m_bottleneckBandwidthBytesPerSec == 0) {
+        m_sendRateBitsPerSec = m_maxSendRateBitsPerSec;
+    }
+    else {
+        const uint64_t gainQuarters = (m_isInStartup) ? STARTUP_PACING_GAIN_QUARTERS : PROBE_BANDWIDTH_PACING_GAIN_QUARTERS[m_pacingGainCycleIndex];
+        const double rateBitsPerSec = (static_cast<double>(m_bottleneckBandwidthBytesPerSec) * 8 * gainQuarters) / 4;
+        m_sendRateBitsPerSec = (rateBitsPerSec >= static_cast<double>(m_maxSendRateBitsPerSec)) ?
+            m_maxSendRateBitsPerSec : std::max(static_cast<uint64_t>(rateBitsPerSec), M_MIN_SEND_RATE_BITS_PER_SEC);
+    }
+    return (m_sendRateBitsPerSec != previousSendRateBitsPerSec);
+}
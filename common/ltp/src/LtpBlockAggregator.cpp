@@ -0,0 +1,69 @@
+/**
+ * @file LtpBlockAggregator.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpBlockAggregator.h"
+#include "Sdnv.h"
+#include <cstring>
+
+LtpBlockAggregator::LtpBlockAggregator(const uint64_t sizeThresholdBytes) :
+    M_SIZE_THRESHOLD_BYTES(sizeThresholdBytes),
+    m_numBundles(0)
+{
+    m_block.reserve(M_SIZE_THRESHOLD_BYTES + 10);
+}
+
+bool LtpBlockAggregator::AddBundle(const uint8_t * bundleData, const std::size_t size) {
+    const std::size_t previousBlockSize = m_block.size();
+    m_block.resize(previousBlockSize + 10 + size);
+    const unsigned int sdnvSize = SdnvEncodeU64BufSize10(&m_block[previousBlockSize], size);
+    memcpy(&m_block[previousBlockSize + sdnvSize], bundleData, size);
+    m_block.resize(previousBlockSize + sdnvSize + size);
+    ++m_numBundles;
+    return (m_block.size() >= M_SIZE_THRESHOLD_BYTES);
+}
+
+bool LtpBlockAggregator::IsEmpty() const {
+    return (m_numBundles == 0);
+}
+
+uint64_t LtpBlockAggregator::GetNumBundles() const {
+    return m_numBundles;
+}
+
+uint64_t LtpBlockAggregator::GetBlockSize() const {
+    return m_block.size();
+}
+
+uint64_t LtpBlockAggregator::TakeBlock(std::vector<uint8_t> & block) {
+    block = std::move(m_block);
+    m_block = std::vector<uint8_t>();
+    m_block.reserve(M_SIZE_THRESHOLD_BYTES + 10);
+    const uint64_t numBundles = m_numBundles;
+    m_numBundles = 0;
+    return numBundles;
+}
+
+bool LtpBlockAggregator::SplitBlock(const uint8_t * block, const std::size_t blockSize, std::vector<std::pair<const uint8_t *, std::size_t> > & bundles) {
+    std::size_t offset = 0;
+    while (offset < blockSize) {
+        uint8_t sdnvSize;
+        const uint64_t bundleSize = SdnvDecodeU64(block + offset, &sdnvSize, blockSize - offset);
+        if ((sdnvSize == 0) || (bundleSize == 0) || (bundleSize > (blockSize - offset - sdnvSize))) {
+            return false;
+        }
+        offset += sdnvSize;
+        bundles.emplace_back(block + offset, static_cast<std::size_t>(bundleSize));
+        offset += static_cast<std::size_t>(bundleSize);
+    }
+    return true;
+}
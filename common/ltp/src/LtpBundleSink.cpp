@@ -15,6 +15,7 @@
 #include <boost/bind/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <iostream>
+#include <cstring>
 #include "LtpBundleSink.h"
 #include <boost/make_unique.hpp>
 #include <boost/lexical_cast.hpp>
@@ -26,12 +27,18 @@ LtpBundleSink::LtpBundleSink(const LtpWholeBundleReadyCallback_t & ltpWholeBundl
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION,
     uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
     const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxBundleSizeBytes, const uint64_t maxSimultaneousSessions,
-    const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable) :
+    const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable,
+    const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable, const std::string & rxSpillDirectory, const unsigned int numUdpRxSockets,
+    const bool forwardGreenOnlyBundles, const uint64_t memoryBudgetBytesOrZeroToDisable,
+    const LtpWholePaddedZmqBundleReadyCallback_t & ltpWholePaddedZmqBundleReadyCallback) :
 
     m_ltpWholeBundleReadyCallback(ltpWholeBundleReadyCallback),
+    m_ltpWholePaddedZmqBundleReadyCallback(ltpWholePaddedZmqBundleReadyCallback),
     M_THIS_ENGINE_ID(thisEngineId),
     M_EXPECTED_SESSION_ORIGINATOR_ENGINE_ID(expectedSessionOriginatorEngineId),
-    m_ltpUdpEngineManagerPtr(LtpUdpEngineManager::GetOrCreateInstance(myBoundUdpPort, true))
+    m_ltpUdpEngineManagerPtr(LtpUdpEngineManager::GetOrCreateInstance(myBoundUdpPort, true, numUdpRxSockets)),
+    M_MAX_BUNDLE_SIZE_BYTES(maxBundleSizeBytes),
+    M_MAX_GREEN_BLOCKS_IN_REASSEMBLY((maxSimultaneousSessions) ? maxSimultaneousSessions : 1)
    
 {
     m_ltpUdpEnginePtr = m_ltpUdpEngineManagerPtr->GetLtpUdpEnginePtrByRemoteEngineId(expectedSessionOriginatorEngineId, true); //sessionOriginatorEngineId is the remote engine id in the case of an induct
@@ -46,6 +53,18 @@ LtpBundleSink::LtpBundleSink(const LtpWholeBundleReadyCallback_t & ltpWholeBundl
     m_ltpUdpEnginePtr->SetRedPartReceptionCallback(boost::bind(&LtpBundleSink::RedPartReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
         boost::placeholders::_4, boost::placeholders::_5));
     m_ltpUdpEnginePtr->SetReceptionSessionCancelledCallback(boost::bind(&LtpBundleSink::ReceptionSessionCancelledCallback, this, boost::placeholders::_1, boost::placeholders::_2));
+    if (rxSpillToDiskThresholdBytesOrZeroToDisable) {
+        m_ltpUdpEnginePtr->SetRxSpillToDisk(rxSpillToDiskThresholdBytesOrZeroToDisable, rxSpillDirectory);
+        m_ltpUdpEnginePtr->SetRedPartFileReceptionCallback(boost::bind(&LtpBundleSink::RedPartFileReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+            boost::placeholders::_4, boost::placeholders::_5));
+    }
+    if (forwardGreenOnlyBundles) {
+        m_ltpUdpEnginePtr->SetGreenPartSegmentArrivalZeroCopyCallback(boost::bind(&LtpBundleSink::GreenPartSegmentArrivalCallback, this, boost::placeholders::_1, boost::placeholders::_2,
+            boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+    }
+    if (memoryBudgetBytesOrZeroToDisable) {
+        m_ltpUdpEnginePtr->SetMemoryBudget_ThreadSafe(memoryBudgetBytesOrZeroToDisable);
+    }
 
     
     std::cout << "this ltp bundle sink for engine ID " << thisEngineId << " will receive on port "
@@ -74,16 +93,115 @@ LtpBundleSink::~LtpBundleSink() {
 void LtpBundleSink::RedPartReceptionCallback(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec,
     uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)
 {
-    m_ltpWholeBundleReadyCallback(movableClientServiceDataVec);
+    DeliverBlock(sessionId, movableClientServiceDataVec, clientServiceId);
 
     //This function is holding up the LtpEngine thread.  Once this red part reception callback exits, the last LTP checkpoint report segment (ack)
     //can be sent to the sending ltp engine to close the session
 }
 
+void LtpBundleSink::DeliverBlock(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & block, const uint64_t clientServiceId) {
+    if (clientServiceId == LtpBlockAggregator::AGGREGATED_BLOCK_CLIENT_SERVICE_ID) {
+        DeliverAggregatedBlock(sessionId, block.data(), block.size());
+        return;
+    }
+    m_ltpWholeBundleReadyCallback(block);
+}
+
+//clientServiceData points into the UDP receive buffer, so the only copy is into the block being reassembled
+void LtpBundleSink::GreenPartSegmentArrivalCallback(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+    uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock)
+{
+    const uint64_t offsetPlusLength = offsetStartOfBlock + length;
+    if ((length == 0) || (offsetPlusLength > M_MAX_BUNDLE_SIZE_BYTES)) {
+        return;
+    }
+    map_session_id_to_green_block_reassembly_t::iterator it = m_mapSessionIdToGreenBlockReassembly.find(sessionId);
+    if (it == m_mapSessionIdToGreenBlockReassembly.end()) {
+        if (offsetStartOfBlock != 0) {
+            //either the block has a red part (only a fully green block has green data at offset 0),
+            //or the first segment of a fully green block was lost or reordered, so the block can't be completed
+            return;
+        }
+        if (isEndOfBlock) { //single segment block, no reassembly needed
+            padded_vector_uint8_t block(clientServiceData, clientServiceData + length);
+            DeliverBlock(sessionId, block, clientServiceId);
+            return;
+        }
+        if (m_mapSessionIdToGreenBlockReassembly.size() >= M_MAX_GREEN_BLOCKS_IN_REASSEMBLY) { //the oldest live block is presumed lost
+            EraseGreenBlockReassembly(m_greenBlockReassemblyAgeQueue.front());
+        }
+        it = m_mapSessionIdToGreenBlockReassembly.emplace(sessionId, boost::make_unique<green_block_reassembly_t>()).first;
+        it->second->ageQueueIt = m_greenBlockReassemblyAgeQueue.insert(m_greenBlockReassemblyAgeQueue.end(), sessionId);
+    }
+    green_block_reassembly_t & reassembly = *(it->second);
+    if (reassembly.data.size() < offsetPlusLength) {
+        reassembly.data.resize(offsetPlusLength);
+    }
+    memcpy(&reassembly.data[offsetStartOfBlock], clientServiceData, length);
+    reassembly.receivedFragments.InsertFragment(LtpFragmentIntervalSet::data_fragment_t(offsetStartOfBlock, offsetPlusLength - 1));
+    if (isEndOfBlock) {
+        //green segments are not retransmitted, so the block is either complete now or lost
+        if (reassembly.receivedFragments.ContainsPrefix(offsetPlusLength)) {
+            reassembly.data.resize(offsetPlusLength);
+            DeliverBlock(sessionId, reassembly.data, clientServiceId);
+        }
+        else {
+            std::cout << "notice in LtpBundleSink: discarding incomplete green block from session " << sessionId << std::endl;
+        }
+        EraseGreenBlockReassembly(sessionId);
+    }
+}
+
+void LtpBundleSink::EraseGreenBlockReassembly(const Ltp::session_id_t & sessionId) {
+    map_session_id_to_green_block_reassembly_t::iterator it = m_mapSessionIdToGreenBlockReassembly.find(sessionId);
+    if (it != m_mapSessionIdToGreenBlockReassembly.end()) {
+        m_greenBlockReassemblyAgeQueue.erase(it->second->ageQueueIt);
+        m_mapSessionIdToGreenBlockReassembly.erase(it);
+    }
+}
+
+static void CustomCleanupLtpRedPartFile(void *data, void *hint) {
+    delete static_cast<LtpRedPartFile*>(hint);
+}
+
+void LtpBundleSink::RedPartFileReceptionCallback(const Ltp::session_id_t & sessionId, std::unique_ptr<LtpRedPartFile> & movableRedPartFilePtr,
+    uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)
+{
+    if (clientServiceId == LtpBlockAggregator::AGGREGATED_BLOCK_CLIENT_SERVICE_ID) {
+        DeliverAggregatedBlock(sessionId, movableRedPartFilePtr->RedPartData(), lengthOfRedPart);
+        return;
+    }
+    if (m_ltpWholePaddedZmqBundleReadyCallback) {
+        //the zmq message takes ownership of the file, which is deleted once the bundle has been consumed (i.e. written to storage)
+        LtpRedPartFile * const redPartFileRawPtr = movableRedPartFilePtr.release();
+        std::unique_ptr<zmq::message_t> zmqMessagePtr = boost::make_unique<zmq::message_t>(redPartFileRawPtr->PaddedData(),
+            lengthOfRedPart + LtpRedPartFile::TOTAL_PADDING_BYTES, CustomCleanupLtpRedPartFile, redPartFileRawPtr);
+        m_ltpWholePaddedZmqBundleReadyCallback(zmqMessagePtr);
+    }
+    else { //the user only accepts in memory bundles
+        padded_vector_uint8_t bundle(movableRedPartFilePtr->RedPartData(), movableRedPartFilePtr->RedPartData() + lengthOfRedPart);
+        movableRedPartFilePtr.reset();
+        m_ltpWholeBundleReadyCallback(bundle);
+    }
+}
+
+void LtpBundleSink::DeliverAggregatedBlock(const Ltp::session_id_t & sessionId, const uint8_t * block, const std::size_t blockSize) {
+    m_aggregatedBundlesTemp.clear();
+    if (!LtpBlockAggregator::SplitBlock(block, blockSize, m_aggregatedBundlesTemp)) {
+        std::cerr << "error in LtpBundleSink::DeliverAggregatedBlock: malformed aggregated block from session " << sessionId
+            << ", only the first " << m_aggregatedBundlesTemp.size() << " bundles are delivered" << std::endl;
+    }
+    for (std::size_t i = 0; i < m_aggregatedBundlesTemp.size(); ++i) {
+        padded_vector_uint8_t bundle(m_aggregatedBundlesTemp[i].first, m_aggregatedBundlesTemp[i].first + m_aggregatedBundlesTemp[i].second);
+        m_ltpWholeBundleReadyCallback(bundle);
+    }
+}
+
 
 void LtpBundleSink::ReceptionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode)
 {
     std::cout << "remote has cancelled session " << sessionId << " with reason code " << (int)reasonCode << std::endl;
+    EraseGreenBlockReassembly(sessionId);
 }
 
 
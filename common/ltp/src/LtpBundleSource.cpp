@@ -23,7 +23,11 @@ LtpBundleSource::LtpBundleSource(const uint64_t clientServiceId, const uint64_t
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
     const uint16_t myBoundUdpPort, const unsigned int numUdpRxCircularBufferVectors,
     uint32_t checkpointEveryNthDataPacketSender, uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
-    const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable, const uint32_t bundlePipelineLimit) :
+    const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable, const uint32_t bundlePipelineLimit,
+    const uint64_t aggregationSizeThresholdBytesOrZeroToDisable, const uint64_t aggregationTimeThresholdMilliseconds,
+    const uint64_t adaptiveMinSendRateBitsPerSecOrZeroToDisable, const uint64_t adaptiveMinCheckpointEveryNthDataPacket,
+    const uint64_t adaptiveMaxCheckpointEveryNthDataPacket, const uint64_t adaptiveMinCheckpointTimeoutMilliseconds,
+    const uint64_t memoryBudgetBytesOrZeroToDisable) :
 
 m_useLocalConditionVariableAckReceived(false), //for destructor only
 
@@ -32,11 +36,18 @@ M_CLIENT_SERVICE_ID(clientServiceId),
 M_THIS_ENGINE_ID(thisEngineId),
 M_REMOTE_LTP_ENGINE_ID(remoteLtpEngineId),
 M_BUNDLE_PIPELINE_LIMIT(bundlePipelineLimit),
+M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE(aggregationSizeThresholdBytesOrZeroToDisable),
+M_AGGREGATION_TIME_THRESHOLD(boost::posix_time::milliseconds(aggregationTimeThresholdMilliseconds)),
+m_blockAggregator(aggregationSizeThresholdBytesOrZeroToDisable),
+m_aggregationBlockGeneration(0),
+m_numAggregatedBlocksBeingTransmitted(0),
+m_aggregationTimer(m_ioServiceAggregation),
 
 m_totalDataSegmentsSentSuccessfullyWithAck(0),
 m_totalDataSegmentsFailedToSend(0),
 m_totalDataSegmentsSent(0),
-m_totalBundleBytesSent(0)
+m_totalBundleBytesSent(0),
+m_totalAggregatedBlocksSent(0)
 {
     m_ltpUdpEnginePtr = m_ltpUdpEngineManagerPtr->GetLtpUdpEnginePtrByRemoteEngineId(remoteLtpEngineId, false);
     if (m_ltpUdpEnginePtr == NULL) {
@@ -46,9 +57,24 @@ m_totalBundleBytesSent(0)
     }
 
     m_ltpUdpEnginePtr->SetSessionStartCallback(boost::bind(&LtpBundleSource::SessionStartCallback, this, boost::placeholders::_1));
-    m_ltpUdpEnginePtr->SetTransmissionSessionCompletedCallback(boost::bind(&LtpBundleSource::TransmissionSessionCompletedCallback, this, boost::placeholders::_1));
-    m_ltpUdpEnginePtr->SetInitialTransmissionCompletedCallback(boost::bind(&LtpBundleSource::InitialTransmissionCompletedCallback, this, boost::placeholders::_1));
-    m_ltpUdpEnginePtr->SetTransmissionSessionCancelledCallback(boost::bind(&LtpBundleSource::TransmissionSessionCancelledCallback, this, boost::placeholders::_1, boost::placeholders::_2));
+    m_ltpUdpEnginePtr->SetTransmissionSessionCompletedCallback(boost::bind(&LtpBundleSource::TransmissionSessionCompletedCallback, this, boost::placeholders::_1, boost::placeholders::_2));
+    m_ltpUdpEnginePtr->SetInitialTransmissionCompletedCallback(boost::bind(&LtpBundleSource::InitialTransmissionCompletedCallback, this, boost::placeholders::_1, boost::placeholders::_2));
+    m_ltpUdpEnginePtr->SetTransmissionSessionCancelledCallback(boost::bind(&LtpBundleSource::TransmissionSessionCancelledCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3));
+    if (adaptiveMinSendRateBitsPerSecOrZeroToDisable) {
+        m_ltpUdpEnginePtr->SetAdaptiveRateAndCheckpointing_ThreadSafe(adaptiveMinSendRateBitsPerSecOrZeroToDisable,
+            adaptiveMinCheckpointEveryNthDataPacket, adaptiveMaxCheckpointEveryNthDataPacket, adaptiveMinCheckpointTimeoutMilliseconds);
+    }
+    if (memoryBudgetBytesOrZeroToDisable) {
+        m_ltpUdpEnginePtr->SetMemoryBudget_ThreadSafe(memoryBudgetBytesOrZeroToDisable);
+    }
+
+    if (M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) {
+        std::cout << "ltp bundle source for remote engine ID " << remoteLtpEngineId << " will aggregate bundles smaller than "
+            << M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE << " bytes into blocks of up to that size (or up to "
+            << aggregationTimeThresholdMilliseconds << " ms of bundles)" << std::endl;
+        m_workAggregationPtr = boost::make_unique<boost::asio::io_service::work>(m_ioServiceAggregation);
+        m_ioServiceAggregationThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioServiceAggregation));
+    }
 }
 
 LtpBundleSource::~LtpBundleSource() {
@@ -60,6 +86,18 @@ void LtpBundleSource::RemoveCallback() {
 }
 
 void LtpBundleSource::Stop() {
+    if (m_ioServiceAggregationThreadPtr) {
+        {
+            boost::mutex::scoped_lock lock(m_aggregationMutex);
+            if (!m_blockAggregator.IsEmpty()) {
+                SendAggregatedBlock_NotThreadSafe();
+            }
+        }
+        boost::asio::post(m_ioServiceAggregation, boost::bind(&LtpBundleSource::CancelAggregationTimer, this));
+        m_workAggregationPtr.reset();
+        m_ioServiceAggregationThreadPtr->join();
+        m_ioServiceAggregationThreadPtr.reset();
+    }
     if (m_ltpUdpEnginePtr) {
         //prevent TcpclBundleSource from exiting before all bundles sent and acked
         boost::mutex localMutex;
@@ -99,6 +137,9 @@ void LtpBundleSource::Stop() {
         std::cout << "m_totalDataSegmentsFailedToSend " << m_totalDataSegmentsFailedToSend << std::endl;
         std::cout << "m_totalDataSegmentsSent " << m_totalDataSegmentsSent << std::endl;
         std::cout << "m_totalBundleBytesSent " << m_totalBundleBytesSent << std::endl;
+        if (M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) {
+            std::cout << "m_totalAggregatedBlocksSent " << m_totalAggregatedBlocksSent << std::endl;
+        }
     }
 }
 
@@ -132,6 +173,15 @@ bool LtpBundleSource::Forward(std::vector<uint8_t> & dataVec) {
         std::cerr << "Error in LtpBundleSource::Forward(std::vector<uint8_t>.. too many unacked sessions (exceeds bundle pipeline limit of " << M_BUNDLE_PIPELINE_LIMIT << ")." << std::endl;
         return false;
     }
+    if (dataVec.size() < M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) {
+        const bool success = ForwardAggregated(dataVec.data(), dataVec.size());
+        std::vector<uint8_t>().swap(dataVec); //consumed (copied into the block) just as a non-aggregated bundle is moved
+        return success;
+    }
+    if (!m_ltpUdpEnginePtr->TransmissionRequestFitsWithinMemoryBudget(dataVec.size())) {
+        std::cerr << "Error in LtpBundleSource::Forward(std::vector<uint8_t>.. ltp engine memory budget exhausted." << std::endl;
+        return false;
+    }
 
     boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
     tReq->destinationClientServiceId = M_CLIENT_SERVICE_ID;
@@ -155,6 +205,15 @@ bool LtpBundleSource::Forward(zmq::message_t & dataZmq) {
         std::cerr << "Error in LtpBundleSource::Forward(zmq::message_t.. too many unacked sessions (exceeds bundle pipeline limit of " << M_BUNDLE_PIPELINE_LIMIT << ")." << std::endl;
         return false;
     }
+    if (dataZmq.size() < M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) {
+        const bool success = ForwardAggregated(static_cast<const uint8_t *>(dataZmq.data()), dataZmq.size());
+        dataZmq.rebuild(); //consumed (copied into the block) just as a non-aggregated bundle is moved
+        return success;
+    }
+    if (!m_ltpUdpEnginePtr->TransmissionRequestFitsWithinMemoryBudget(dataZmq.size())) {
+        std::cerr << "Error in LtpBundleSource::Forward(zmq::message_t.. ltp engine memory budget exhausted." << std::endl;
+        return false;
+    }
 
     boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
     tReq->destinationClientServiceId = M_CLIENT_SERVICE_ID;
@@ -172,10 +231,89 @@ bool LtpBundleSource::Forward(zmq::message_t & dataZmq) {
 }
 
 bool LtpBundleSource::Forward(const uint8_t* bundleData, const std::size_t size) {
+    if (size < M_AGGREGATION_SIZE_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) {
+        if (m_activeSessionsSet.size() > M_BUNDLE_PIPELINE_LIMIT) {
+            std::cerr << "Error in LtpBundleSource::Forward(const uint8_t*.. too many unacked sessions (exceeds bundle pipeline limit of " << M_BUNDLE_PIPELINE_LIMIT << ")." << std::endl;
+            return false;
+        }
+        return ForwardAggregated(bundleData, size);
+    }
     std::vector<uint8_t> vec(bundleData, bundleData + size);
     return Forward(vec);
 }
 
+bool LtpBundleSource::ForwardAggregated(const uint8_t* bundleData, const std::size_t size) {
+    boost::mutex::scoped_lock lock(m_aggregationMutex);
+    const bool isFirstBundleOfBlock = m_blockAggregator.IsEmpty();
+    const bool sizeThresholdReached = m_blockAggregator.AddBundle(bundleData, size);
+    ++m_totalDataSegmentsSent; //counted per bundle so that the outduct's unacked (pipeline) count remains in bundles
+    m_totalBundleBytesSent += size;
+    if (sizeThresholdReached || (m_numAggregatedBlocksBeingTransmitted == 0)) {
+        SendAggregatedBlock_NotThreadSafe();
+    }
+    else if (isFirstBundleOfBlock) {
+        boost::asio::post(m_ioServiceAggregation, boost::bind(&LtpBundleSource::StartAggregationTimer, this, m_aggregationBlockGeneration));
+    }
+    return true;
+}
+
+void LtpBundleSource::SendAggregatedBlock_NotThreadSafe() {
+    boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+    tReq->destinationClientServiceId = LtpBlockAggregator::AGGREGATED_BLOCK_CLIENT_SERVICE_ID;
+    tReq->destinationLtpEngineId = M_REMOTE_LTP_ENGINE_ID;
+    std::vector<uint8_t> block;
+    const uint64_t numBundles = m_blockAggregator.TakeBlock(block);
+    tReq->lengthOfRedPart = block.size();
+    tReq->clientServiceDataToSend = std::move(block);
+    tReq->userDataPtr = std::make_shared<AggregatedBlockUserData>(numBundles);
+
+    m_ltpUdpEnginePtr->TransmissionRequest_ThreadSafe(std::move(tReq));
+    ++m_aggregationBlockGeneration;
+    ++m_numAggregatedBlocksBeingTransmitted;
+    ++m_totalAggregatedBlocksSent;
+}
+
+//runs on the ltp engine thread; once the previous block is out, the bundles that accumulated meanwhile are sent without waiting for the timer
+void LtpBundleSource::OnAggregatedBlockInitialTransmissionEnded(std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
+    if (AggregatedBlockUserData * aggregatedBlockUserData = dynamic_cast<AggregatedBlockUserData *>(userDataPtr.get())) {
+        if (!aggregatedBlockUserData->initialTransmissionEnded) {
+            aggregatedBlockUserData->initialTransmissionEnded = true;
+            boost::mutex::scoped_lock lock(m_aggregationMutex);
+            --m_numAggregatedBlocksBeingTransmitted;
+            if ((m_numAggregatedBlocksBeingTransmitted == 0) && (!m_blockAggregator.IsEmpty())) {
+                SendAggregatedBlock_NotThreadSafe();
+            }
+        }
+    }
+}
+
+//runs on the aggregation thread
+void LtpBundleSource::StartAggregationTimer(const uint64_t blockGeneration) {
+    m_aggregationTimer.expires_from_now(M_AGGREGATION_TIME_THRESHOLD);
+    m_aggregationTimer.async_wait(boost::bind(&LtpBundleSource::OnAggregation_TimerExpired, this, boost::asio::placeholders::error, blockGeneration));
+}
+
+void LtpBundleSource::CancelAggregationTimer() {
+    m_aggregationTimer.cancel();
+}
+
+void LtpBundleSource::OnAggregation_TimerExpired(const boost::system::error_code& e, const uint64_t blockGeneration) {
+    if (e != boost::asio::error::operation_aborted) {
+        boost::mutex::scoped_lock lock(m_aggregationMutex);
+        //the block this timer was started for may have already been sent by reaching the size threshold
+        if ((blockGeneration == m_aggregationBlockGeneration) && (!m_blockAggregator.IsEmpty())) {
+            SendAggregatedBlock_NotThreadSafe();
+        }
+    }
+}
+
+uint64_t LtpBundleSource::GetNumBundlesInSession(const std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
+    if (const AggregatedBlockUserData * aggregatedBlockUserData = dynamic_cast<const AggregatedBlockUserData *>(userDataPtr.get())) {
+        return aggregatedBlockUserData->numBundles;
+    }
+    return 1;
+}
+
 
 
 void LtpBundleSource::SessionStartCallback(const Ltp::session_id_t & sessionId) {
@@ -183,12 +321,12 @@ void LtpBundleSource::SessionStartCallback(const Ltp::session_id_t & sessionId)
         std::cerr << "error in LtpBundleSource::SessionStartCallback, sessionId " << sessionId << " (already exists)\n";
     }
 }
-void LtpBundleSource::TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId) {
+void LtpBundleSource::TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
     std::set<Ltp::session_id_t>::iterator it = m_activeSessionsSet.find(sessionId);
     if (it != m_activeSessionsSet.end()) { //found
         m_activeSessionsSet.erase(it);
         
-        ++m_totalDataSegmentsSentSuccessfullyWithAck;
+        m_totalDataSegmentsSentSuccessfullyWithAck += GetNumBundlesInSession(userDataPtr);
         //m_totalBytesAcked += m_bytesToAckCbVec[readIndex];
         //m_bytesToAckCb.CommitRead();
         if (m_onSuccessfulAckCallback) {
@@ -202,15 +340,16 @@ void LtpBundleSource::TransmissionSessionCompletedCallback(const Ltp::session_id
         std::cerr << "critical error in LtpBundleSource::TransmissionSessionCompletedCallback: cannot find sessionId " << sessionId << std::endl;
     }
 }
-void LtpBundleSource::InitialTransmissionCompletedCallback(const Ltp::session_id_t & sessionId) {
-
+void LtpBundleSource::InitialTransmissionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
+    OnAggregatedBlockInitialTransmissionEnded(userDataPtr);
 }
-void LtpBundleSource::TransmissionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode) {
+void LtpBundleSource::TransmissionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
     std::set<Ltp::session_id_t>::iterator it = m_activeSessionsSet.find(sessionId);
     if (it != m_activeSessionsSet.end()) { //found
         m_activeSessionsSet.erase(it);
 
-        ++m_totalDataSegmentsFailedToSend;
+        m_totalDataSegmentsFailedToSend += GetNumBundlesInSession(userDataPtr);
+        OnAggregatedBlockInitialTransmissionEnded(userDataPtr); //in case cancelled before the initial transmission completed
         //m_totalBytesAcked += m_bytesToAckCbVec[readIndex];
         //m_bytesToAckCb.CommitRead();
         if (m_onSuccessfulAckCallback) {
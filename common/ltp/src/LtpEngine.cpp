@@ -17,8 +17,13 @@
 #include <inttypes.h>
 #include <boost/bind/bind.hpp>
 #include <boost/make_unique.hpp>
+#include "MetricsRegistry.h"
 
 static const boost::posix_time::time_duration static_tokenMaxLimitDurationWindow(boost::posix_time::milliseconds(100));
+static MetricGauge & g_metricMemoryInUseBytes = MetricsRegistry::GetInstance().GetOrCreateGauge("ltp.memoryInUseBytes"); //sum of all engines
+static MetricCounter & g_metricTransmissionRequestsRefusedByMemoryBudget = MetricsRegistry::GetInstance().GetOrCreateCounter("ltp.memoryBudget.transmissionRequestsRefused");
+static MetricCounter & g_metricReceiveSessionsRefusedByMemoryBudget = MetricsRegistry::GetInstance().GetOrCreateCounter("ltp.memoryBudget.receiveSessionsRefused");
+static MetricCounter & g_metricSessionsEvictedByMemoryBudget = MetricsRegistry::GetInstance().GetOrCreateCounter("ltp.memoryBudget.sessionsEvicted");
 static const boost::posix_time::time_duration static_tokenRefreshTimeDurationWindow(boost::posix_time::milliseconds(20));
 
 LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEncodingIntoRandomSessionNumber, 
@@ -27,6 +32,7 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, bool startIoServiceThread,
     uint32_t checkpointEveryNthDataPacketSender, uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
     const uint64_t maxSimultaneousSessions, const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable) :
+    m_headerBufferPool(NUM_HEADER_BUFFER_POOL_SLOTS),
     M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION(ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION),
     M_MAX_RED_RX_BYTES_PER_SESSION(maxRedRxBytesPerSession),
     M_THIS_ENGINE_ID(thisEngineId),
@@ -37,6 +43,9 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     M_FORCE_32_BIT_RANDOM_NUMBERS(force32BitRandomNumbers),
     M_MAX_SIMULTANEOUS_SESSIONS(maxSimultaneousSessions),
     M_MAX_RX_DATA_SEGMENT_HISTORY_OR_ZERO_DISABLE(rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable),
+    m_rxSpillToDiskThresholdBytesOrZeroToDisable(0),
+    m_memoryBudgetBytesOrZeroToDisable(0),
+    m_memoryInUseBytes(0),
     m_checkpointEveryNthDataPacketSender(checkpointEveryNthDataPacketSender),
     m_maxRetriesPerSerialNumber(maxRetriesPerSerialNumber),
     m_workLtpEnginePtr(boost::make_unique< boost::asio::io_service::work>(m_ioServiceLtpEngine)),
@@ -58,7 +67,7 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     m_ltpRxStateMachine.SetReportSegmentContentsReadCallback(boost::bind(&LtpEngine::ReportSegmentReceivedCallback, this,
         boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
         boost::placeholders::_4));
-    m_ltpRxStateMachine.SetDataSegmentContentsReadCallback(boost::bind(&LtpEngine::DataSegmentReceivedCallback, this,
+    m_ltpRxStateMachine.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&LtpEngine::DataSegmentReceivedCallback, this,
         boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
         boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
 
@@ -86,7 +95,12 @@ LtpEngine::~LtpEngine() {
     std::cout << "m_numReportSegmentsUnableToBeIssued: " << m_numReportSegmentsUnableToBeIssued << std::endl;
     std::cout << "m_numReportSegmentsTooLargeAndNeedingSplit: " << m_numReportSegmentsTooLargeAndNeedingSplit << std::endl;
     std::cout << "m_numReportSegmentsCreatedViaSplit: " << m_numReportSegmentsCreatedViaSplit << std::endl;
-    std::cout << "m_countAsyncSendsLimitedByRate " << m_countAsyncSendsLimitedByRate << std::endl << std::endl;
+    std::cout << "m_countAsyncSendsLimitedByRate " << m_countAsyncSendsLimitedByRate << std::endl;
+    if (m_memoryBudgetBytesOrZeroToDisable) {
+        std::cout << "memory budget: " << m_memoryBudgetBytesOrZeroToDisable << " bytes, transmission requests refused: " << m_numTransmissionRequestsRefusedByMemoryBudget
+            << ", receive sessions refused: " << m_numReceiveSessionsRefusedByMemoryBudget << ", sessions evicted: " << m_numSessionsEvictedByMemoryBudget << std::endl;
+    }
+    std::cout << "header buffer pool acquires: " << m_headerBufferPool.m_numAcquires << " (pool exhausted " << m_headerBufferPool.m_numAcquireFailures << " times)" << std::endl << std::endl;
 
     if (m_ioServiceLtpEngineThreadPtr) {
         boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::Reset, this));
@@ -94,6 +108,7 @@ LtpEngine::~LtpEngine() {
         m_ioServiceLtpEngineThreadPtr->join();
         m_ioServiceLtpEngineThreadPtr.reset(); //delete it
     }
+    ReleaseMemory(m_memoryInUseBytes.load(std::memory_order_relaxed)); //keep the process wide gauge correct if Reset wasn't posted
 }
 
 void LtpEngine::Reset() {
@@ -112,6 +127,7 @@ void LtpEngine::Reset() {
     m_queueSendersNeedingDataSent = std::queue<uint64_t>();
     m_queueReceiversNeedingDeleted = std::queue<Ltp::session_id_t>();
     m_queueReceiversNeedingDataSent = std::queue<Ltp::session_id_t>();
+    ReleaseMemory(m_memoryInUseBytes.load(std::memory_order_relaxed)); //everything accounted for was just cleared
 
     m_countAsyncSendsLimitedByRate = 0;
     m_numCheckpointTimerExpiredCallbacks = 0;
@@ -120,6 +136,16 @@ void LtpEngine::Reset() {
     m_numReportSegmentsUnableToBeIssued = 0;
     m_numReportSegmentsTooLargeAndNeedingSplit = 0;
     m_numReportSegmentsCreatedViaSplit = 0;
+    m_numTransmissionRequestsRefusedByMemoryBudget = 0;
+    m_numReceiveSessionsRefusedByMemoryBudget = 0;
+    m_numSessionsEvictedByMemoryBudget = 0;
+
+    if (m_adaptiveControllerPtr) {
+        m_adaptiveControllerPtr->Reset();
+        if (m_maxSendRateBitsPerSecOrZeroToDisable) {
+            ApplyAdaptiveSendRate();
+        }
+    }
 }
 
 void LtpEngine::SetCheckpointEveryNthDataPacketForSenders(uint64_t checkpointEveryNthDataPacketSender) {
@@ -137,6 +163,57 @@ void LtpEngine::SetMtuReportSegment(uint64_t mtuReportSegment) {
     std::cout << "max reception claims = " << m_maxReceptionClaims << std::endl;
 }
 
+void LtpEngine::SetRxSpillToDisk(const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable, const boost::filesystem::path & rxSpillDirectory) {
+    m_rxSpillToDiskThresholdBytesOrZeroToDisable = rxSpillToDiskThresholdBytesOrZeroToDisable;
+    m_rxSpillDirectory = rxSpillDirectory;
+    if (rxSpillToDiskThresholdBytesOrZeroToDisable) {
+        std::cout << "ltp engine " << M_THIS_ENGINE_ID << " will spill received red parts larger than " << rxSpillToDiskThresholdBytesOrZeroToDisable
+            << " bytes to " << ((rxSpillDirectory.empty()) ? std::string("the temp directory") : rxSpillDirectory.string()) << std::endl;
+    }
+}
+
+bool LtpEngine::SetAdaptiveRateAndCheckpointing(const uint64_t minSendRateBitsPerSec, const uint64_t minCheckpointEveryNthDataPacket,
+    const uint64_t maxCheckpointEveryNthDataPacket, const uint64_t minCheckpointTimeoutMilliseconds)
+{
+    if (m_maxSendRateBitsPerSecOrZeroToDisable == 0) {
+        std::cerr << "error in LtpEngine::SetAdaptiveRateAndCheckpointing: a max send rate is required, adaptive rate and checkpointing disabled" << std::endl;
+        return false;
+    }
+    if ((minCheckpointEveryNthDataPacket == 0) || (minCheckpointEveryNthDataPacket > maxCheckpointEveryNthDataPacket)) {
+        std::cerr << "error in LtpEngine::SetAdaptiveRateAndCheckpointing: checkpoint interval must satisfy 1 <= min <= max, adaptive rate and checkpointing disabled" << std::endl;
+        return false;
+    }
+    const uint64_t maxSendRateBitsPerSec = m_maxSendRateBitsPerSecOrZeroToDisable;
+    m_adaptiveControllerPtr = boost::make_unique<LtpAdaptiveController>(minSendRateBitsPerSec, maxSendRateBitsPerSec,
+        minCheckpointEveryNthDataPacket, maxCheckpointEveryNthDataPacket,
+        minCheckpointTimeoutMilliseconds * 1000000, static_cast<uint64_t>(M_TRANSMISSION_TO_ACK_RECEIVED_TIME.total_microseconds()) * 1000);
+    ApplyAdaptiveSendRate();
+    std::cout << "ltp engine " << M_THIS_ENGINE_ID << " adaptive: send rate bitsPerSec [" << minSendRateBitsPerSec << ", " << maxSendRateBitsPerSec
+        << "], checkpoint every nth data segment [" << minCheckpointEveryNthDataPacket << ", " << maxCheckpointEveryNthDataPacket
+        << "], checkpoint timeout ms [" << minCheckpointTimeoutMilliseconds << ", " << M_TRANSMISSION_TO_ACK_RECEIVED_TIME.total_milliseconds() << "]" << std::endl;
+    return true;
+}
+
+void LtpEngine::SetAdaptiveRateAndCheckpointing_ThreadSafe(const uint64_t minSendRateBitsPerSec, const uint64_t minCheckpointEveryNthDataPacket,
+    const uint64_t maxCheckpointEveryNthDataPacket, const uint64_t minCheckpointTimeoutMilliseconds)
+{
+    boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::SetAdaptiveRateAndCheckpointing, this,
+        minSendRateBitsPerSec, minCheckpointEveryNthDataPacket, maxCheckpointEveryNthDataPacket, minCheckpointTimeoutMilliseconds));
+}
+
+const LtpAdaptiveController * LtpEngine::GetAdaptiveController() const {
+    return m_adaptiveControllerPtr.get();
+}
+
+bool LtpEngine::GetSessionSenderStats(const uint64_t sessionNumber, LtpSessionSender::session_stats_t & sessionStats) const {
+    map_session_number_to_session_sender_t::const_iterator txSessionIt = m_mapSessionNumberToSessionSender.find(sessionNumber);
+    if (txSessionIt == m_mapSessionNumberToSessionSender.cend()) {
+        return false;
+    }
+    sessionStats = txSessionIt->second->m_sessionStats;
+    return true;
+}
+
 bool LtpEngine::PacketIn(const uint8_t * data, const std::size_t size, Ltp::SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr) {
     std::string errorMessage;
     const bool success = m_ltpRxStateMachine.HandleReceivedChars(data, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
@@ -174,11 +251,15 @@ void LtpEngine::TrySendPacketIfAvailable() {
         //RATE STUFF (the TrySendPacketIfAvailable and OnTokenRefresh_TimerExpired run in the same thread)
         if (m_maxSendRateBitsPerSecOrZeroToDisable) { //if rate limiting enabled
             if (!m_tokenRateLimiter.CanTakeTokens()) { //no tokens available for next send, TrySendPacketIfAvailable() will be called at the next m_tokenRefreshTimer expiration
+                ++m_countAsyncSendsLimitedByRate;
+                if (m_adaptiveControllerPtr) {
+                    m_adaptiveControllerPtr->OnSendLimitedByRate();
+                }
                 TryRestartTokenRefreshTimer(); //make sure this is running so that tokens can be replenished
                 return;
             }
         }
-        std::vector<boost::asio::const_buffer> constBufferVec;
+        std::vector<boost::asio::const_buffer> & constBufferVec = m_constBufferVecForSend;
         boost::shared_ptr<std::vector<std::vector<uint8_t> > >  underlyingDataToDeleteOnSentCallback;
         uint64_t sessionOriginatorEngineId;
         if (GetNextPacketToSend(constBufferVec, underlyingDataToDeleteOnSentCallback, sessionOriginatorEngineId)) {
@@ -197,7 +278,11 @@ void LtpEngine::TrySendPacketIfAvailable() {
 
 void LtpEngine::PacketInFullyProcessedCallback(bool success) {}
 
-void LtpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId) {}
+void LtpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId) {
+    if (!constBufferVec.empty()) {
+        m_headerBufferPool.Release(constBufferVec[0].data()); //nothing sent, so done with the header
+    }
+}
 
 bool LtpEngine::GetNextPacketToSend(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, uint64_t & sessionOriginatorEngineId) {
     while (!m_queueSendersNeedingDeleted.empty()) {
@@ -208,9 +293,7 @@ bool LtpEngine::GetNextPacketToSend(std::vector<boost::asio::const_buffer> & con
                 return true;
             }
             else {
-                m_numCheckpointTimerExpiredCallbacks += txSessionIt->second->m_numCheckpointTimerExpiredCallbacks;
-                m_numDiscretionaryCheckpointsNotResent += txSessionIt->second->m_numDiscretionaryCheckpointsNotResent;
-                m_mapSessionNumberToSessionSender.erase(txSessionIt);
+                EraseTxSession(txSessionIt);
                 ////std::cout << "deleted session sender " << m_listSendersNeedingDeleted.front() << std::endl;
             }
         }
@@ -229,11 +312,7 @@ bool LtpEngine::GetNextPacketToSend(std::vector<boost::asio::const_buffer> & con
             }
             else {
                 //erase session
-                m_numReportSegmentTimerExpiredCallbacks += rxSessionIt->second->m_numReportSegmentTimerExpiredCallbacks;
-                m_numReportSegmentsUnableToBeIssued += rxSessionIt->second->m_numReportSegmentsUnableToBeIssued;
-                m_numReportSegmentsTooLargeAndNeedingSplit += rxSessionIt->second->m_numReportSegmentsTooLargeAndNeedingSplit;
-                m_numReportSegmentsCreatedViaSplit += rxSessionIt->second->m_numReportSegmentsCreatedViaSplit;
-                m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
+                EraseRxSession(rxSessionIt);
                 ////std::cout << "deleted session receiver sessionNumber " << m_listReceiversNeedingDeleted.front().sessionNumber << std::endl;
             }
         }
@@ -271,6 +350,7 @@ bool LtpEngine::GetNextPacketToSend(std::vector<boost::asio::const_buffer> & con
     if (!m_queueClosedSessionDataToSend.empty()) { //includes report ack segments and cancel ack segments from closed sessions (which do not require timers)
         //highest priority
         underlyingDataToDeleteOnSentCallback = boost::make_shared<std::vector<std::vector<uint8_t> > >(1);
+        ReleaseMemory(m_queueClosedSessionDataToSend.front().second.size());
         (*underlyingDataToDeleteOnSentCallback)[0] = std::move(m_queueClosedSessionDataToSend.front().second);
         sessionOriginatorEngineId = m_queueClosedSessionDataToSend.front().first;
         m_queueClosedSessionDataToSend.pop();
@@ -353,13 +433,29 @@ void LtpEngine::TransmissionRequest(uint64_t destinationClientServiceId, uint64_
         randomInitialSenderCheckpointSerialNumber = m_rng.GetRandomSerialNumber64(m_randomDevice);
     }
     Ltp::session_id_t senderSessionId(M_THIS_ENGINE_ID, randomSessionNumberGeneratedBySender);
-    m_mapSessionNumberToSessionSender[randomSessionNumberGeneratedBySender] = boost::make_unique<LtpSessionSender>(
+    if (!TransmissionRequestFitsWithinMemoryBudget(clientServiceDataToSend.size())) {
+        //backpressure: the session is started and immediately cancelled (nothing is sent) so the client service gets its user data back
+        ++m_numTransmissionRequestsRefusedByMemoryBudget;
+        g_metricTransmissionRequestsRefusedByMemoryBudget.Increment();
+        if (m_sessionStartCallback) {
+            m_sessionStartCallback(senderSessionId);
+        }
+        if (m_transmissionSessionCancelledCallback) {
+            m_transmissionSessionCancelledCallback(senderSessionId, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED, userDataPtrToTake);
+        }
+        return;
+    }
+    std::unique_ptr<LtpSessionSender> & txSessionPtr = m_mapSessionNumberToSessionSender[randomSessionNumberGeneratedBySender];
+    txSessionPtr = boost::make_unique<LtpSessionSender>(
         randomInitialSenderCheckpointSerialNumber, std::move(clientServiceDataToSend), std::move(userDataPtrToTake),
         lengthOfRedPart, M_MTU_CLIENT_SERVICE_DATA, senderSessionId, destinationClientServiceId,
-        M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_ioServiceLtpEngine,
+        M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_ioServiceLtpEngine, m_headerBufferPool,
         boost::bind(&LtpEngine::NotifyEngineThatThisSenderNeedsDeletedCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4),
         boost::bind(&LtpEngine::NotifyEngineThatThisSenderHasProducibleData, this, boost::placeholders::_1),
-        boost::bind(&LtpEngine::InitialTransmissionCompletedCallback, this, boost::placeholders::_1, boost::placeholders::_2), m_checkpointEveryNthDataPacketSender, m_maxRetriesPerSerialNumber);
+        boost::bind(&LtpEngine::InitialTransmissionCompletedCallback, this, boost::placeholders::_1, boost::placeholders::_2),
+        (m_adaptiveControllerPtr) ? m_adaptiveControllerPtr->GetCheckpointEveryNthDataPacket() : m_checkpointEveryNthDataPacketSender,
+        m_maxRetriesPerSerialNumber, m_adaptiveControllerPtr.get());
+    ChargeMemory(txSessionPtr->GetMemoryFootprintBytes());
 
     if (m_sessionStartCallback) {
         //At the sender, the session start notice informs the client service of the initiation of the transmission session.
@@ -441,9 +537,7 @@ bool LtpEngine::CancellationRequest(const Ltp::session_id_t & sessionId) { //onl
             //destination LTP engine specified in the transmission request
             //that started this session.
             //erase session
-            m_numCheckpointTimerExpiredCallbacks += txSessionIt->second->m_numCheckpointTimerExpiredCallbacks;
-            m_numDiscretionaryCheckpointsNotResent += txSessionIt->second->m_numDiscretionaryCheckpointsNotResent;
-            m_mapSessionNumberToSessionSender.erase(txSessionIt);
+            EraseTxSession(txSessionIt);
             std::cout << "LtpEngine::CancellationRequest deleted session sender session number " << sessionId.sessionNumber << std::endl;
 
             //send Cancel Segment to receiver (GetNextPacketToSend() will create the packet and start the timer)
@@ -473,11 +567,7 @@ bool LtpEngine::CancellationRequest(const Ltp::session_id_t & sessionId) { //onl
             //sender.
 
             //erase session
-            m_numReportSegmentTimerExpiredCallbacks += rxSessionIt->second->m_numReportSegmentTimerExpiredCallbacks;
-            m_numReportSegmentsUnableToBeIssued += rxSessionIt->second->m_numReportSegmentsUnableToBeIssued;
-            m_numReportSegmentsTooLargeAndNeedingSplit += rxSessionIt->second->m_numReportSegmentsTooLargeAndNeedingSplit;
-            m_numReportSegmentsCreatedViaSplit += rxSessionIt->second->m_numReportSegmentsCreatedViaSplit;
-            m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
+            EraseRxSession(rxSessionIt);
             std::cout << "LtpEngine::CancellationRequest deleted session receiver session number " << sessionId.sessionNumber << std::endl;
 
             //send Cancel Segment to sender (GetNextPacketToSend() will create the packet and start the timer)
@@ -508,11 +598,7 @@ void LtpEngine::CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionI
                 m_receptionSessionCancelledCallback(sessionId, reasonCode); //No subsequent delivery notices will be issued for this session.
             }
             //erase session
-            m_numReportSegmentTimerExpiredCallbacks += rxSessionIt->second->m_numReportSegmentTimerExpiredCallbacks;
-            m_numReportSegmentsUnableToBeIssued += rxSessionIt->second->m_numReportSegmentsUnableToBeIssued;
-            m_numReportSegmentsTooLargeAndNeedingSplit += rxSessionIt->second->m_numReportSegmentsTooLargeAndNeedingSplit;
-            m_numReportSegmentsCreatedViaSplit += rxSessionIt->second->m_numReportSegmentsCreatedViaSplit;
-            m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
+            EraseRxSession(rxSessionIt);
             std::cout << "LtpEngine::CancelSegmentReceivedCallback deleted session receiver session number " << sessionId.sessionNumber << std::endl;
             //Send CAx after outer if-else statement
             
@@ -533,9 +619,7 @@ void LtpEngine::CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionI
                 m_transmissionSessionCancelledCallback(sessionId, reasonCode, txSessionIt->second->m_userDataPtr);
             }
             //erase session
-            m_numCheckpointTimerExpiredCallbacks += txSessionIt->second->m_numCheckpointTimerExpiredCallbacks;
-            m_numDiscretionaryCheckpointsNotResent += txSessionIt->second->m_numDiscretionaryCheckpointsNotResent;
-            m_mapSessionNumberToSessionSender.erase(txSessionIt);
+            EraseTxSession(txSessionIt);
             std::cout << "LtpEngine::CancelSegmentReceivedCallback deleted session sender session number " << sessionId.sessionNumber << std::endl;
             //Send CAx after outer if-else statement
         }
@@ -556,6 +640,7 @@ void LtpEngine::CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionI
     Ltp::GenerateCancelAcknowledgementSegmentLtpPacket(m_queueClosedSessionDataToSend.back().second,
         sessionId, isFromSender, NULL, NULL);
     m_queueClosedSessionDataToSend.back().first = sessionId.sessionOriginatorEngineId;
+    ChargeMemory(m_queueClosedSessionDataToSend.back().second.size());
     TrySendPacketIfAvailable();
 }
 
@@ -693,6 +778,11 @@ void LtpEngine::ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionI
     map_session_number_to_session_sender_t::iterator txSessionIt = m_mapSessionNumberToSessionSender.find(sessionId.sessionNumber);
     if (txSessionIt != m_mapSessionNumberToSessionSender.end()) { //found
         txSessionIt->second->ReportSegmentReceivedCallback(reportSegment, headerExtensions, trailerExtensions);
+        if (m_adaptiveControllerPtr && m_maxSendRateBitsPerSecOrZeroToDisable
+            && (m_adaptiveControllerPtr->GetSendRateBitsPerSec() != m_maxSendRateBitsPerSecOrZeroToDisable))
+        {
+            ApplyAdaptiveSendRate();
+        }
     }
     else { //not found
         //Note that while at the CLOSED state, the LTP sender might receive an
@@ -704,6 +794,7 @@ void LtpEngine::ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionI
         Ltp::GenerateReportAcknowledgementSegmentLtpPacket(m_queueClosedSessionDataToSend.back().second,
             sessionId, reportSegment.reportSerialNumber, NULL, NULL);
         m_queueClosedSessionDataToSend.back().first = sessionId.sessionOriginatorEngineId;
+        ChargeMemory(m_queueClosedSessionDataToSend.back().second.size());
     }
     TrySendPacketIfAvailable();
 }
@@ -714,7 +805,7 @@ void LtpEngine::ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionI
 //data segment carrying a new session ID.
 
 void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
-    std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
     Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
 {
     if (sessionId.sessionOriginatorEngineId == M_THIS_ENGINE_ID) {
@@ -724,6 +815,13 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
 
     map_session_id_to_session_receiver_t::iterator rxSessionIt = m_mapSessionIdToSessionReceiver.find(sessionId);
     if (rxSessionIt == m_mapSessionIdToSessionReceiver.end()) { //not found.. new session started
+        const uint64_t memoryBudget = m_memoryBudgetBytesOrZeroToDisable.load(std::memory_order_relaxed);
+        if (memoryBudget && ((m_memoryInUseBytes.load(std::memory_order_relaxed) + M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION) > memoryBudget)) {
+            //drop the segment before the recreation preventer remembers the session, so the sender's retransmission can start it later
+            ++m_numReceiveSessionsRefusedByMemoryBudget;
+            g_metricReceiveSessionsRefusedByMemoryBudget.Increment();
+            return;
+        }
         //first check if the session has been closed prevously before recreating
         if (M_MAX_RX_DATA_SEGMENT_HISTORY_OR_ZERO_DISABLE) {
             std::map<uint64_t, std::unique_ptr<LtpSessionRecreationPreventer> >::iterator it = m_mapSessionOriginatorEngineIdToLtpSessionRecreationPreventer.find(sessionId.sessionOriginatorEngineId);
@@ -738,7 +836,8 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
         }
         const uint64_t randomNextReportSegmentReportSerialNumber = (M_FORCE_32_BIT_RANDOM_NUMBERS) ? m_rng.GetRandomSerialNumber32(m_randomDevice) : m_rng.GetRandomSerialNumber64(m_randomDevice); //incremented by 1 for new
         std::unique_ptr<LtpSessionReceiver> session = boost::make_unique<LtpSessionReceiver>(randomNextReportSegmentReportSerialNumber, m_maxReceptionClaims,
-            M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, M_MAX_RED_RX_BYTES_PER_SESSION,
+            M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, M_MAX_RED_RX_BYTES_PER_SESSION, m_redPartBufferRecyclePool,
+            m_rxSpillToDiskThresholdBytesOrZeroToDisable, m_rxSpillDirectory,
             sessionId, dataSegmentMetadata.clientServiceId, M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_ioServiceLtpEngine,
             boost::bind(&LtpEngine::NotifyEngineThatThisReceiverNeedsDeletedCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3),
             boost::bind(&LtpEngine::NotifyEngineThatThisReceiversTimersHasProducibleData, this, boost::placeholders::_1), m_maxRetriesPerSerialNumber);
@@ -749,25 +848,151 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
             return;
         }
         rxSessionIt = res.first;
+        ChargeMemory(rxSessionIt->second->GetMemoryFootprintBytes());
 
         if (m_sessionStartCallback) {
             //At the receiver, this notice indicates the beginning of a new reception session, and is delivered upon arrival of the first data segment carrying a new session ID.
             m_sessionStartCallback(sessionId);
         }
     }
-    rxSessionIt->second->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceDataVec, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_greenPartSegmentArrivalCallback);
+    const uint64_t memoryFootprintBefore = rxSessionIt->second->GetMemoryFootprintBytes();
+    rxSessionIt->second->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceData, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_redPartFileReceptionCallback,
+        m_greenPartSegmentArrivalCallback, m_greenPartSegmentArrivalZeroCopyCallback);
+    const uint64_t memoryFootprintAfter = rxSessionIt->second->GetMemoryFootprintBytes();
+    if (memoryFootprintAfter > memoryFootprintBefore) {
+        ChargeMemory(memoryFootprintAfter - memoryFootprintBefore);
+        EvictSessionsUntilWithinMemoryBudget(); //may erase this session
+    }
+    else {
+        ReleaseMemory(memoryFootprintBefore - memoryFootprintAfter);
+    }
     TrySendPacketIfAvailable();
 }
 
+void LtpEngine::EraseTxSession(map_session_number_to_session_sender_t::iterator & txSessionIt) {
+    m_numCheckpointTimerExpiredCallbacks += txSessionIt->second->m_numCheckpointTimerExpiredCallbacks;
+    m_numDiscretionaryCheckpointsNotResent += txSessionIt->second->m_numDiscretionaryCheckpointsNotResent;
+    ReleaseMemory(txSessionIt->second->GetMemoryFootprintBytes());
+    m_mapSessionNumberToSessionSender.erase(txSessionIt);
+}
+
+void LtpEngine::EraseRxSession(map_session_id_to_session_receiver_t::iterator & rxSessionIt) {
+    m_numReportSegmentTimerExpiredCallbacks += rxSessionIt->second->m_numReportSegmentTimerExpiredCallbacks;
+    m_numReportSegmentsUnableToBeIssued += rxSessionIt->second->m_numReportSegmentsUnableToBeIssued;
+    m_numReportSegmentsTooLargeAndNeedingSplit += rxSessionIt->second->m_numReportSegmentsTooLargeAndNeedingSplit;
+    m_numReportSegmentsCreatedViaSplit += rxSessionIt->second->m_numReportSegmentsCreatedViaSplit;
+    ReleaseMemory(rxSessionIt->second->GetMemoryFootprintBytes());
+    m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
+}
+
+void LtpEngine::ChargeMemory(const uint64_t bytes) {
+    m_memoryInUseBytes.fetch_add(bytes, std::memory_order_relaxed);
+    g_metricMemoryInUseBytes.Add(static_cast<int64_t>(bytes));
+}
+
+void LtpEngine::ReleaseMemory(const uint64_t bytes) {
+    m_memoryInUseBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    g_metricMemoryInUseBytes.Add(-static_cast<int64_t>(bytes));
+}
+
+void LtpEngine::SetMemoryBudget(const uint64_t memoryBudgetBytesOrZeroToDisable) {
+    m_memoryBudgetBytesOrZeroToDisable.store(memoryBudgetBytesOrZeroToDisable, std::memory_order_relaxed);
+    EvictSessionsUntilWithinMemoryBudget();
+}
+
+void LtpEngine::SetMemoryBudget_ThreadSafe(const uint64_t memoryBudgetBytesOrZeroToDisable) {
+    boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::SetMemoryBudget, this, memoryBudgetBytesOrZeroToDisable));
+}
+
+uint64_t LtpEngine::GetMemoryInUseBytes() const {
+    return m_memoryInUseBytes.load(std::memory_order_relaxed);
+}
+
+bool LtpEngine::TransmissionRequestFitsWithinMemoryBudget(const uint64_t clientServiceDataBytes) const {
+    const uint64_t memoryBudget = m_memoryBudgetBytesOrZeroToDisable.load(std::memory_order_relaxed);
+    if (memoryBudget == 0) {
+        return true;
+    }
+    const uint64_t senderBudget = memoryBudget - (memoryBudget >> 2); //a quarter is reserved for receivers
+    return (m_memoryInUseBytes.load(std::memory_order_relaxed) + clientServiceDataBytes) <= senderBudget;
+}
+
+void LtpEngine::EvictSessionsUntilWithinMemoryBudget() {
+    const uint64_t memoryBudget = m_memoryBudgetBytesOrZeroToDisable.load(std::memory_order_relaxed);
+    while (memoryBudget && (m_memoryInUseBytes.load(std::memory_order_relaxed) > memoryBudget)) {
+        //senders first (the client service still has their data and can retry), largest first
+        map_session_number_to_session_sender_t::iterator largestTxSessionIt = m_mapSessionNumberToSessionSender.end();
+        uint64_t largestFootprint = 0;
+        for (map_session_number_to_session_sender_t::iterator it = m_mapSessionNumberToSessionSender.begin(); it != m_mapSessionNumberToSessionSender.end(); ++it) {
+            const uint64_t footprint = it->second->GetMemoryFootprintBytes();
+            if (footprint > largestFootprint) {
+                largestFootprint = footprint;
+                largestTxSessionIt = it;
+            }
+        }
+        if (largestTxSessionIt != m_mapSessionNumberToSessionSender.end()) {
+            const Ltp::session_id_t sessionId(M_THIS_ENGINE_ID, largestTxSessionIt->first);
+            if (m_transmissionSessionCancelledCallback) {
+                m_transmissionSessionCancelledCallback(sessionId, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED, largestTxSessionIt->second->m_userDataPtr);
+            }
+            EraseTxSession(largestTxSessionIt);
+            std::cout << "LtpEngine memory budget of " << memoryBudget << " bytes exceeded, cancelled session sender session number " << sessionId.sessionNumber << std::endl;
+
+            //send Cancel Segment to receiver (GetNextPacketToSend() will create the packet and start the timer)
+            m_queueCancelSegmentTimerInfo.emplace();
+            cancel_segment_timer_info_t & info = m_queueCancelSegmentTimerInfo.back();
+            info.sessionId = sessionId;
+            info.retryCount = 1;
+            info.isFromSender = true;
+            info.reasonCode = CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED;
+        }
+        else {
+            map_session_id_to_session_receiver_t::iterator largestRxSessionIt = m_mapSessionIdToSessionReceiver.end();
+            for (map_session_id_to_session_receiver_t::iterator it = m_mapSessionIdToSessionReceiver.begin(); it != m_mapSessionIdToSessionReceiver.end(); ++it) {
+                const uint64_t footprint = it->second->GetMemoryFootprintBytes();
+                if (footprint > largestFootprint) {
+                    largestFootprint = footprint;
+                    largestRxSessionIt = it;
+                }
+            }
+            if (largestRxSessionIt == m_mapSessionIdToSessionReceiver.end()) {
+                break; //only queued segments of closed sessions remain, which drain on their own
+            }
+            const Ltp::session_id_t sessionId = largestRxSessionIt->first;
+            if (m_receptionSessionCancelledCallback) {
+                m_receptionSessionCancelledCallback(sessionId, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
+            }
+            EraseRxSession(largestRxSessionIt);
+            std::cout << "LtpEngine memory budget of " << memoryBudget << " bytes exceeded, cancelled session receiver session number " << sessionId.sessionNumber << std::endl;
+
+            //send Cancel Segment to sender (GetNextPacketToSend() will create the packet and start the timer)
+            m_queueCancelSegmentTimerInfo.emplace();
+            cancel_segment_timer_info_t & info = m_queueCancelSegmentTimerInfo.back();
+            info.sessionId = sessionId;
+            info.retryCount = 1;
+            info.isFromSender = false;
+            info.reasonCode = CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED;
+        }
+        ++m_numSessionsEvictedByMemoryBudget;
+        g_metricSessionsEvictedByMemoryBudget.Increment();
+    }
+}
+
 void LtpEngine::SetSessionStartCallback(const SessionStartCallback_t & callback) {
     m_sessionStartCallback = callback;
 }
 void LtpEngine::SetRedPartReceptionCallback(const RedPartReceptionCallback_t & callback) {
     m_redPartReceptionCallback = callback;
 }
+void LtpEngine::SetRedPartFileReceptionCallback(const RedPartFileReceptionCallback_t & callback) {
+    m_redPartFileReceptionCallback = callback;
+}
 void LtpEngine::SetGreenPartSegmentArrivalCallback(const GreenPartSegmentArrivalCallback_t & callback) {
     m_greenPartSegmentArrivalCallback = callback;
 }
+void LtpEngine::SetGreenPartSegmentArrivalZeroCopyCallback(const GreenPartSegmentArrivalZeroCopyCallback_t & callback) {
+    m_greenPartSegmentArrivalZeroCopyCallback = callback;
+}
 void LtpEngine::SetReceptionSessionCancelledCallback(const ReceptionSessionCancelledCallback_t & callback) {
     m_receptionSessionCancelledCallback = callback;
 }
@@ -789,6 +1014,11 @@ std::size_t LtpEngine::NumActiveSenders() const {
 }
 
 void LtpEngine::UpdateRate(const uint64_t maxSendRateBitsPerSecOrZeroToDisable) {
+    if (m_adaptiveControllerPtr && maxSendRateBitsPerSecOrZeroToDisable) { //the new rate is the ceiling of the adaptive rate
+        m_adaptiveControllerPtr->SetMaxSendRate(maxSendRateBitsPerSecOrZeroToDisable);
+        ApplyAdaptiveSendRate();
+        return;
+    }
     m_maxSendRateBitsPerSecOrZeroToDisable = maxSendRateBitsPerSecOrZeroToDisable;
     if (maxSendRateBitsPerSecOrZeroToDisable) {
         const uint64_t rateBytesPerSecond = m_maxSendRateBitsPerSecOrZeroToDisable >> 3;
@@ -800,6 +1030,17 @@ void LtpEngine::UpdateRate(const uint64_t maxSendRateBitsPerSecOrZeroToDisable)
     }
 }
 
+//unlike UpdateRate, keeps the tokens in the bucket so that frequent adjustments don't each allow a full burst
+void LtpEngine::ApplyAdaptiveSendRate() {
+    m_maxSendRateBitsPerSecOrZeroToDisable = m_adaptiveControllerPtr->GetSendRateBitsPerSec();
+    const uint64_t rateBytesPerSecond = m_maxSendRateBitsPerSecOrZeroToDisable >> 3;
+    m_tokenRateLimiter.SetRateKeepingRemainingTokens(
+        rateBytesPerSecond,
+        boost::posix_time::seconds(1),
+        static_tokenMaxLimitDurationWindow
+    );
+}
+
 void LtpEngine::UpdateRate_ThreadSafe(const uint64_t maxSendRateBitsPerSecOrZeroToDisable) {
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::UpdateRate, this, maxSendRateBitsPerSecOrZeroToDisable));
 }
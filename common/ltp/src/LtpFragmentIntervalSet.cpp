@@ -0,0 +1,234 @@
+/**
+ * @file LtpFragmentIntervalSet.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpFragmentIntervalSet.h"
+#include <iostream>
+#include <algorithm>
+
+static bool ChunkBackIsBefore(const std::vector<FragmentSet::data_fragment_t> & chunk, const FragmentSet::data_fragment_t & key) {
+    return chunk.back() < key;
+}
+
+LtpFragmentIntervalSet::LtpFragmentIntervalSet() : m_size(0), m_numBytes(0) {}
+LtpFragmentIntervalSet::~LtpFragmentIntervalSet() {}
+
+void LtpFragmentIntervalSet::clear() {
+    m_chunks.clear();
+    m_size = 0;
+    m_numBytes = 0;
+}
+
+//the first chunk containing a fragment that overlaps, abuts, or is after the key
+std::vector<LtpFragmentIntervalSet::chunk_t>::const_iterator LtpFragmentIntervalSet::FindChunk(const data_fragment_t & key) const {
+    return std::lower_bound(m_chunks.cbegin(), m_chunks.cend(), key, ChunkBackIsBefore);
+}
+
+void LtpFragmentIntervalSet::SplitChunkIfFull(const std::size_t chunkIndex) {
+    if (m_chunks[chunkIndex].size() <= MAX_FRAGMENTS_PER_CHUNK) {
+        return;
+    }
+    m_chunks.emplace(m_chunks.begin() + (chunkIndex + 1));
+    chunk_t & fullChunk = m_chunks[chunkIndex];
+    chunk_t & newChunk = m_chunks[chunkIndex + 1];
+    const std::size_t half = fullChunk.size() / 2;
+    newChunk.reserve(MAX_FRAGMENTS_PER_CHUNK + 1);
+    newChunk.assign(fullChunk.cbegin() + half, fullChunk.cend());
+    fullChunk.resize(half);
+}
+
+void LtpFragmentIntervalSet::InsertFragment(const data_fragment_t & key) {
+    //fast paths: segments usually arrive in order, so the key is either beyond or overlapping/abutting the last fragment
+    if (m_chunks.empty() || (back() < key)) {
+        if (m_chunks.empty() || (m_chunks.back().size() >= MAX_FRAGMENTS_PER_CHUNK)) {
+            m_chunks.emplace_back();
+            m_chunks.back().reserve(MAX_FRAGMENTS_PER_CHUNK + 1);
+        }
+        m_chunks.back().push_back(key);
+        ++m_size;
+        m_numBytes += (key.endIndex - key.beginIndex) + 1;
+        return;
+    }
+    data_fragment_t & lastFragment = m_chunks.back().back();
+    if (key.beginIndex >= lastFragment.beginIndex) {
+        if (key.endIndex > lastFragment.endIndex) {
+            m_numBytes += key.endIndex - lastFragment.endIndex;
+            lastFragment.endIndex = key.endIndex;
+        }
+        return;
+    }
+
+    //data_fragment_t::operator< is "entirely before without abutting", so [first, last) is every fragment in the chunk that overlaps or abuts the key
+    const std::size_t chunkIndex = FindChunk(key) - m_chunks.cbegin(); //exists since the key is not after the last fragment
+    chunk_t & chunk = m_chunks[chunkIndex];
+    const chunk_t::iterator first = std::lower_bound(chunk.begin(), chunk.end(), key); //exists since the chunk's back is not before the key
+    const chunk_t::iterator last = std::upper_bound(first, chunk.end(), key);
+    if (first == last) { //no overlap nor abut
+        chunk.insert(first, key);
+        ++m_size;
+        m_numBytes += (key.endIndex - key.beginIndex) + 1;
+        SplitChunkIfFull(chunkIndex);
+        return;
+    }
+    data_fragment_t merged(std::min(first->beginIndex, key.beginIndex), std::max((last - 1)->endIndex, key.endIndex));
+    const bool mayOverlapNextChunks = (last == chunk.end());
+    uint64_t numBytesMerged = 0;
+    for (chunk_t::const_iterator it = first; it != last; ++it) {
+        numBytesMerged += (it->endIndex - it->beginIndex) + 1;
+    }
+    m_size -= (last - first) - 1;
+    chunk.erase(first + 1, last); //first remains valid
+    if (mayOverlapNextChunks) { //only a large key (i.e. a reception claim) can span chunks
+        while ((chunkIndex + 1) < m_chunks.size()) {
+            chunk_t & nextChunk = m_chunks[chunkIndex + 1];
+            const chunk_t::iterator nextLast = std::upper_bound(nextChunk.begin(), nextChunk.end(), merged);
+            if (nextLast == nextChunk.begin()) {
+                break;
+            }
+            merged.endIndex = std::max(merged.endIndex, (nextLast - 1)->endIndex);
+            for (chunk_t::const_iterator it = nextChunk.cbegin(); it != nextLast; ++it) {
+                numBytesMerged += (it->endIndex - it->beginIndex) + 1;
+            }
+            m_size -= nextLast - nextChunk.begin();
+            if (nextLast != nextChunk.end()) {
+                nextChunk.erase(nextChunk.begin(), nextLast);
+                break;
+            }
+            m_chunks.erase(m_chunks.begin() + (chunkIndex + 1));
+        }
+    }
+    m_chunks[chunkIndex][first - m_chunks[chunkIndex].begin()] = merged;
+    m_numBytes += ((merged.endIndex - merged.beginIndex) + 1) - numBytesMerged;
+}
+
+bool LtpFragmentIntervalSet::ContainsFragmentEntirely(const data_fragment_t & key) const {
+    std::vector<chunk_t>::const_iterator chunkIt = FindChunk(key);
+    if (chunkIt == m_chunks.cend()) {
+        return false;
+    }
+    chunk_t::const_iterator it = std::lower_bound(chunkIt->cbegin(), chunkIt->cend(), key);
+    return (key.beginIndex >= it->beginIndex) && (key.endIndex <= it->endIndex);
+}
+
+bool LtpFragmentIntervalSet::ContainsPrefix(const uint64_t length) const {
+    return (m_size == 1) && (front().beginIndex == 0) && (front().endIndex >= (length - 1));
+}
+
+bool LtpFragmentIntervalSet::PopulateReportSegment(Ltp::report_segment_t & reportSegment, uint64_t lowerBound, uint64_t upperBound) const {
+    //same rules as LtpFragmentSet::PopulateReportSegment
+    if (m_size == 0) {
+        return false;
+    }
+    std::vector<chunk_t>::const_iterator chunkIt = m_chunks.cbegin();
+    std::size_t firstElementIndexInChunk = 0;
+    if (lowerBound == UINT64_MAX) { //AUTO DETECT
+        lowerBound = front().beginIndex;
+    }
+    else {
+        const data_fragment_t key(lowerBound, lowerBound);
+        chunkIt = FindChunk(key);
+        if (chunkIt != m_chunks.cend()) {
+            firstElementIndexInChunk = std::lower_bound(chunkIt->cbegin(), chunkIt->cend(), key) - chunkIt->cbegin(); //first element may overlap or abut key
+        }
+    }
+    reportSegment.lowerBound = lowerBound;
+    if (upperBound == UINT64_MAX) { //AUTO DETECT
+        upperBound = back().endIndex + 1;
+    }
+    reportSegment.upperBound = upperBound;
+    if (lowerBound >= upperBound) {
+        return false;
+    }
+    const uint64_t differenceBetweenUpperAndLowerBounds = upperBound - lowerBound;
+
+    reportSegment.receptionClaims.clear();
+    reportSegment.receptionClaims.reserve(m_size);
+    for (; chunkIt != m_chunks.cend(); ++chunkIt, firstElementIndexInChunk = 0) {
+        for (chunk_t::const_iterator it = chunkIt->cbegin() + firstElementIndexInChunk; it != chunkIt->cend(); ++it) {
+            const uint64_t beginIndex = std::max(it->beginIndex, lowerBound);
+            if (beginIndex >= upperBound) {
+                return true;
+            }
+            uint64_t length = (it->endIndex + 1) - beginIndex;
+            length = std::min(length, differenceBetweenUpperAndLowerBounds);
+            length = std::min(length, upperBound - beginIndex);
+            if (length) { //A reception claim's length shall never be less than 1
+                reportSegment.receptionClaims.emplace_back(beginIndex - lowerBound, length);
+            }
+        }
+    }
+    return true;
+}
+
+void LtpFragmentIntervalSet::AddReportSegment(const Ltp::report_segment_t & reportSegment) {
+    const uint64_t lowerBound = reportSegment.lowerBound;
+    for (std::vector<Ltp::reception_claim_t>::const_iterator it = reportSegment.receptionClaims.cbegin(); it != reportSegment.receptionClaims.cend(); ++it) {
+        const uint64_t beginIndex = lowerBound + it->offset;
+        InsertFragment(data_fragment_t(beginIndex, (beginIndex + it->length) - 1));
+    }
+}
+
+void LtpFragmentIntervalSet::GetFragmentsNeedingResent(const Ltp::report_segment_t & reportSegment, std::vector<data_fragment_t> & fragmentsNeedingResent) {
+    //same rules as LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent
+    fragmentsNeedingResent.clear();
+    const std::vector<Ltp::reception_claim_t> & receptionClaims = reportSegment.receptionClaims;
+    if (receptionClaims.empty()) {
+        return;
+    }
+    fragmentsNeedingResent.reserve(receptionClaims.size() + 1);
+    const uint64_t lowerBound = reportSegment.lowerBound;
+    uint64_t nextBeginIndex = lowerBound;
+    bool inOrder = true;
+    for (std::vector<Ltp::reception_claim_t>::const_iterator it = receptionClaims.cbegin(); it != receptionClaims.cend(); ++it) {
+        const uint64_t claimBeginIndex = lowerBound + it->offset;
+        if (nextBeginIndex < claimBeginIndex) {
+            inOrder = inOrder && (fragmentsNeedingResent.empty() || (fragmentsNeedingResent.back() < data_fragment_t(nextBeginIndex, claimBeginIndex - 1)));
+            fragmentsNeedingResent.emplace_back(nextBeginIndex, claimBeginIndex - 1);
+        }
+        nextBeginIndex = claimBeginIndex + it->length;
+    }
+    if (nextBeginIndex < reportSegment.upperBound) {
+        inOrder = inOrder && (fragmentsNeedingResent.empty() || (fragmentsNeedingResent.back() < data_fragment_t(nextBeginIndex, reportSegment.upperBound - 1)));
+        fragmentsNeedingResent.emplace_back(nextBeginIndex, reportSegment.upperBound - 1);
+    }
+    if (!inOrder) { //claims of an invalid report segment were out of order or overlapping, so sort and merge like the std::set would
+        std::set<data_fragment_t> fragmentSet;
+        for (std::size_t i = 0; i < fragmentsNeedingResent.size(); ++i) {
+            FragmentSet::InsertFragment(fragmentSet, fragmentsNeedingResent[i]);
+        }
+        fragmentsNeedingResent.assign(fragmentSet.cbegin(), fragmentSet.cend());
+    }
+}
+
+bool LtpFragmentIntervalSet::operator==(const std::set<data_fragment_t> & fragmentSet) const {
+    if (m_size != fragmentSet.size()) {
+        return false;
+    }
+    std::set<data_fragment_t>::const_iterator setIt = fragmentSet.cbegin();
+    for (std::vector<chunk_t>::const_iterator chunkIt = m_chunks.cbegin(); chunkIt != m_chunks.cend(); ++chunkIt) {
+        for (chunk_t::const_iterator it = chunkIt->cbegin(); it != chunkIt->cend(); ++it, ++setIt) {
+            if (*it != *setIt) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void LtpFragmentIntervalSet::Print() const {
+    for (std::vector<chunk_t>::const_iterator chunkIt = m_chunks.cbegin(); chunkIt != m_chunks.cend(); ++chunkIt) {
+        for (chunk_t::const_iterator it = chunkIt->cbegin(); it != chunkIt->cend(); ++it) {
+            std::cout << "(" << it->beginIndex << "," << it->endIndex << ") ";
+        }
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file LtpGreenSegmentRing.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpGreenSegmentRing.h"
+#include <boost/bind/bind.hpp>
+
+LtpGreenSegmentRing::LtpGreenSegmentRing(const unsigned int numSegments, const uint64_t maxSegmentSizeBytes) :
+    M_MAX_SEGMENT_SIZE_BYTES(maxSegmentSizeBytes),
+    m_circularIndexBuffer(numSegments, true),
+    m_segments(numSegments),
+    m_readIndex(CIRCULAR_INDEX_BUFFER_EMPTY),
+    m_numSegmentsDropped(0)
+{
+    for (std::size_t i = 0; i < m_segments.size(); ++i) {
+        m_segments[i].data.reserve(maxSegmentSizeBytes);
+    }
+}
+
+LtpGreenSegmentRing::~LtpGreenSegmentRing() {}
+
+bool LtpGreenSegmentRing::PushSegment(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+    uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock)
+{
+    const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
+    if ((writeIndex == CIRCULAR_INDEX_BUFFER_FULL) || (length > M_MAX_SEGMENT_SIZE_BYTES)) {
+        m_numSegmentsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    green_segment_t & segment = m_segments[writeIndex];
+    segment.sessionId = sessionId;
+    segment.offsetStartOfBlock = offsetStartOfBlock;
+    segment.clientServiceId = clientServiceId;
+    segment.isEndOfBlock = isEndOfBlock;
+    segment.data.assign(clientServiceData, clientServiceData + length); //within the reserved capacity
+    m_circularIndexBuffer.CommitWrite(); //write complete at this point
+    return true;
+}
+
+void LtpGreenSegmentRing::PushSegmentFromCallback(const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData, uint64_t length,
+    uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock)
+{
+    PushSegment(sessionId, clientServiceData, length, offsetStartOfBlock, clientServiceId, isEndOfBlock);
+}
+
+GreenPartSegmentArrivalZeroCopyCallback_t LtpGreenSegmentRing::GetProducerCallback() {
+    return boost::bind(&LtpGreenSegmentRing::PushSegmentFromCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+        boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6);
+}
+
+const LtpGreenSegmentRing::green_segment_t * LtpGreenSegmentRing::TryGetNextSegment() {
+    m_readIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
+    return (m_readIndex == CIRCULAR_INDEX_BUFFER_EMPTY) ? NULL : &m_segments[m_readIndex];
+}
+
+const LtpGreenSegmentRing::green_segment_t * LtpGreenSegmentRing::WaitForNextSegment() {
+    while (true) {
+        const green_segment_t * const segment = TryGetNextSegment();
+        if (segment) {
+            return segment;
+        }
+        if (!m_circularIndexBuffer.WaitUntilNotEmpty()) {
+            return TryGetNextSegment(); //stopped, but drain anything pushed before the stop
+        }
+    }
+}
+
+void LtpGreenSegmentRing::ReleaseSegment() {
+    if (m_readIndex != CIRCULAR_INDEX_BUFFER_EMPTY) {
+        m_readIndex = CIRCULAR_INDEX_BUFFER_EMPTY;
+        m_circularIndexBuffer.CommitRead();
+    }
+}
+
+void LtpGreenSegmentRing::StopWaiting() {
+    m_circularIndexBuffer.StopWaiting();
+}
+
+uint64_t LtpGreenSegmentRing::GetNumSegmentsDropped() const {
+    return m_numSegmentsDropped.load(std::memory_order_relaxed);
+}
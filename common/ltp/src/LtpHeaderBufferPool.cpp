@@ -0,0 +1,70 @@
+/**
+ * @file LtpHeaderBufferPool.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpHeaderBufferPool.h"
+
+LtpHeaderBufferPool::LtpHeaderBufferPool(const unsigned int numSlots) :
+    M_NUM_SLOTS(numSlots),
+    m_slotsBuffer(static_cast<std::size_t>(numSlots) * SLOT_SIZE_BYTES),
+    m_slotInUseFlags(new std::atomic<bool>[numSlots]),
+    m_nextSlotIndexToTry(0),
+    m_numAcquires(0),
+    m_numAcquireFailures(0)
+{
+    for (unsigned int i = 0; i < M_NUM_SLOTS; ++i) {
+        m_slotInUseFlags[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+LtpHeaderBufferPool::~LtpHeaderBufferPool() {}
+
+uint8_t * LtpHeaderBufferPool::Acquire() {
+    //sends usually complete in order, so the next slot after the last one acquired is almost always free
+    for (unsigned int i = 0; i < M_NUM_SLOTS; ++i) {
+        unsigned int slotIndex = m_nextSlotIndexToTry + i;
+        if (slotIndex >= M_NUM_SLOTS) {
+            slotIndex -= M_NUM_SLOTS;
+        }
+        //acquire pairs with the release in Release() so the previous send is done reading the slot before it is overwritten
+        if (!m_slotInUseFlags[slotIndex].load(std::memory_order_acquire)) {
+            m_slotInUseFlags[slotIndex].store(true, std::memory_order_relaxed); //only this thread sets flags, so no compare exchange needed
+            m_nextSlotIndexToTry = ((slotIndex + 1) == M_NUM_SLOTS) ? 0 : (slotIndex + 1);
+            ++m_numAcquires;
+            return &m_slotsBuffer[static_cast<std::size_t>(slotIndex) * SLOT_SIZE_BYTES];
+        }
+    }
+    ++m_numAcquireFailures;
+    return NULL;
+}
+
+bool LtpHeaderBufferPool::IsFromPool(const void * ptr) const {
+    const uint8_t * const p = static_cast<const uint8_t *>(ptr);
+    return (M_NUM_SLOTS != 0) && (p >= m_slotsBuffer.data()) && (p < (m_slotsBuffer.data() + m_slotsBuffer.size()));
+}
+
+bool LtpHeaderBufferPool::Release(const void * slotPtr) {
+    if (!IsFromPool(slotPtr)) {
+        return false;
+    }
+    const std::size_t slotIndex = static_cast<std::size_t>(static_cast<const uint8_t *>(slotPtr) - m_slotsBuffer.data()) / SLOT_SIZE_BYTES;
+    m_slotInUseFlags[slotIndex].store(false, std::memory_order_release);
+    return true;
+}
+
+unsigned int LtpHeaderBufferPool::NumSlotsInUse() const {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < M_NUM_SLOTS; ++i) {
+        count += m_slotInUseFlags[i].load(std::memory_order_relaxed);
+    }
+    return count;
+}
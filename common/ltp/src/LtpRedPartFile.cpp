@@ -0,0 +1,92 @@
+/**
+ * @file LtpRedPartFile.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "LtpRedPartFile.h"
+#include <iostream>
+#include <boost/filesystem/fstream.hpp>
+
+LtpRedPartFile::LtpRedPartFile() : m_paddedData(NULL), m_redPartCapacityBytes(0) {}
+
+LtpRedPartFile::~LtpRedPartFile() {
+    m_mappedFile.close();
+    if (!m_filePath.empty()) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(m_filePath, ec);
+        if (ec) {
+            std::cerr << "error in ~LtpRedPartFile: unable to delete " << m_filePath << ": " << ec.message() << std::endl;
+        }
+    }
+}
+
+bool LtpRedPartFile::Create(const boost::filesystem::path & directory, const uint64_t redPartCapacityBytes) {
+    if (!m_filePath.empty()) {
+        std::cerr << "error in LtpRedPartFile::Create: file " << m_filePath << " already created" << std::endl;
+        return false;
+    }
+    boost::system::error_code ec;
+    const boost::filesystem::path dir = (directory.empty()) ? boost::filesystem::temp_directory_path(ec) : directory;
+    if (ec) {
+        std::cerr << "error in LtpRedPartFile::Create: unable to get the temp directory: " << ec.message() << std::endl;
+        return false;
+    }
+    const boost::filesystem::path filePath = dir / boost::filesystem::unique_path("ltp_red_part_%%%%-%%%%-%%%%-%%%%.bin", ec);
+    if (ec) {
+        std::cerr << "error in LtpRedPartFile::Create: unable to generate a unique file name: " << ec.message() << std::endl;
+        return false;
+    }
+    {
+        boost::filesystem::ofstream ofs(filePath, std::ofstream::out | std::ofstream::binary);
+        if (!ofs.good()) {
+            std::cerr << "error in LtpRedPartFile::Create: unable to create " << filePath << std::endl;
+            return false;
+        }
+    }
+    m_filePath = filePath; //from here on, the destructor deletes the file
+    return Grow(redPartCapacityBytes);
+}
+
+bool LtpRedPartFile::Grow(const uint64_t newRedPartCapacityBytes) {
+    if (m_filePath.empty()) {
+        std::cerr << "error in LtpRedPartFile::Grow: file not created" << std::endl;
+        return false;
+    }
+    if ((newRedPartCapacityBytes <= m_redPartCapacityBytes) && m_mappedFile.is_open()) {
+        return true;
+    }
+    //the data already written stays in the file (page cache), so growing never copies it
+    m_mappedFile.close();
+    m_paddedData = NULL;
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(m_filePath, newRedPartCapacityBytes + TOTAL_PADDING_BYTES, ec);
+    if (ec) {
+        std::cerr << "error in LtpRedPartFile::Grow: unable to resize " << m_filePath << " to "
+            << (newRedPartCapacityBytes + TOTAL_PADDING_BYTES) << " bytes: " << ec.message() << std::endl;
+        return false;
+    }
+    m_redPartCapacityBytes = newRedPartCapacityBytes;
+    return Map();
+}
+
+bool LtpRedPartFile::Map() {
+    try {
+        boost::iostreams::mapped_file_params params(m_filePath.string());
+        params.flags = boost::iostreams::mapped_file::mapmode::readwrite;
+        m_mappedFile.open(params);
+    }
+    catch (const std::exception & e) {
+        std::cerr << "error in LtpRedPartFile::Map: unable to map " << m_filePath << ": " << e.what() << std::endl;
+        return false;
+    }
+    m_paddedData = reinterpret_cast<uint8_t *>(m_mappedFile.data());
+    return (m_paddedData != NULL);
+}
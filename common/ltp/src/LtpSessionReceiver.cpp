@@ -17,9 +17,15 @@
 #include <inttypes.h>
 #include <boost/bind/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/make_unique.hpp>
+#include "MetricsRegistry.h"
+
+static LatencyHistogram & g_metricReceiveSessionDuration = MetricsRegistry::GetInstance().GetOrCreateHistogram("ltp.receiveSessionDuration");
 
 LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
+    std::vector<padded_vector_uint8_t> & redPartBufferRecyclePoolRef,
+    const uint64_t rxSpillToDiskThresholdBytesOrZeroToDisable, const boost::filesystem::path & rxSpillDirectoryRef,
     const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
     const NotifyEngineThatThisReceiverNeedsDeletedCallback_t & notifyEngineThatThisReceiverNeedsDeletedCallback,
@@ -27,6 +33,9 @@ LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSer
     const uint32_t maxRetriesPerSerialNumber) :
     m_timeManagerOfReportSerialNumbers(ioServiceRef, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpSessionReceiver::LtpReportSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
     m_nextReportSegmentReportSerialNumber(randomNextReportSegmentReportSerialNumber),
+    m_redPartBufferRecyclePoolRef(redPartBufferRecyclePoolRef),
+    M_RX_SPILL_TO_DISK_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE(rxSpillToDiskThresholdBytesOrZeroToDisable),
+    M_RX_SPILL_DIRECTORY_REF(rxSpillDirectoryRef),
     M_MAX_RECEPTION_CLAIMS(MAX_RECEPTION_CLAIMS),
     M_ESTIMATED_BYTES_TO_RECEIVE(ESTIMATED_BYTES_TO_RECEIVE),
     M_MAX_RED_RX_BYTES(maxRedRxBytes),
@@ -45,12 +54,49 @@ LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSer
     m_numReportSegmentTimerExpiredCallbacks(0),
     m_numReportSegmentsUnableToBeIssued(0),
     m_numReportSegmentsTooLargeAndNeedingSplit(0),
-    m_numReportSegmentsCreatedViaSplit(0)
+    m_numReportSegmentsCreatedViaSplit(0),
+    m_creationTimestampNanoseconds(LatencyHistogram::NowNanoseconds())
 {
+    if (!m_redPartBufferRecyclePoolRef.empty()) {
+        m_dataReceivedRed = std::move(m_redPartBufferRecyclePoolRef.back());
+        m_redPartBufferRecyclePoolRef.pop_back();
+    }
     m_dataReceivedRed.reserve(ESTIMATED_BYTES_TO_RECEIVE);
 }
 
-LtpSessionReceiver::~LtpSessionReceiver() {}
+LtpSessionReceiver::~LtpSessionReceiver() {
+    g_metricReceiveSessionDuration.RecordSince(m_creationTimestampNanoseconds);
+    ReturnRedPartBufferToRecyclePool();
+}
+
+uint64_t LtpSessionReceiver::GetMemoryFootprintBytes() const {
+    return m_dataReceivedRed.capacity();
+}
+
+void LtpSessionReceiver::ReturnRedPartBufferToRecyclePool() {
+    //don't hold on to unusually large buffers
+    if (m_dataReceivedRed.capacity() && (m_dataReceivedRed.capacity() <= (M_ESTIMATED_BYTES_TO_RECEIVE << 2))
+        && (m_redPartBufferRecyclePoolRef.size() < MAX_RED_PART_BUFFERS_IN_RECYCLE_POOL))
+    {
+        m_dataReceivedRed.clear();
+        m_redPartBufferRecyclePoolRef.push_back(std::move(m_dataReceivedRed));
+    }
+    padded_vector_uint8_t().swap(m_dataReceivedRed);
+}
+
+//moves the red data received so far (at most the spill threshold) into a new file, after which the in-memory buffer is released
+bool LtpSessionReceiver::SpillRedPartToDisk(const uint64_t redPartCapacityBytes) {
+    std::unique_ptr<LtpRedPartFile> redPartFilePtr = boost::make_unique<LtpRedPartFile>();
+    if (!redPartFilePtr->Create(M_RX_SPILL_DIRECTORY_REF, redPartCapacityBytes)) {
+        return false;
+    }
+    if (!m_dataReceivedRed.empty()) {
+        memcpy(redPartFilePtr->RedPartData(), m_dataReceivedRed.data(), m_dataReceivedRed.size());
+    }
+    m_redPartFilePtr = std::move(redPartFilePtr);
+    ReturnRedPartBufferToRecyclePool();
+    return true;
+}
 
 void LtpSessionReceiver::LtpReportSegmentTimerExpiredCallback(uint64_t reportSerialNumber, std::vector<uint8_t> & userData) {
     //std::cout << "LtpReportSegmentTimerExpiredCallback reportSerialNumber " << reportSerialNumber << std::endl;
@@ -159,18 +205,14 @@ void LtpSessionReceiver::ReportAcknowledgementSegmentReceivedCallback(uint64_t r
 
 
 void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
-    std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
     Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
-    const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
+    const RedPartFileReceptionCallback_t & redPartFileReceptionCallback,
+    const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback,
+    const GreenPartSegmentArrivalZeroCopyCallback_t & greenPartSegmentArrivalZeroCopyCallback)
 {
     const uint64_t offsetPlusLength = dataSegmentMetadata.offset + dataSegmentMetadata.length;
-    
-    if (dataSegmentMetadata.length != clientServiceDataVec.size()) {
-        std::cerr << "error dataSegmentMetadata.length != clientServiceDataVec.size()\n";
-    }
-    
 
-    
 
     bool isRedData = (segmentTypeFlags <= 3);
     bool isEndOfBlock = ((segmentTypeFlags & 3) == 3);
@@ -216,17 +258,53 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
             }
             return;
         }
-        if (m_dataReceivedRed.size() < offsetPlusLength) {
-            m_dataReceivedRed.resize(offsetPlusLength);
-            //std::cout << m_dataReceived.size() << " " << m_dataReceived.capacity() << std::endl;
-        }
-        memcpy(m_dataReceivedRed.data() + dataSegmentMetadata.offset, clientServiceDataVec.data(), dataSegmentMetadata.length);
-
         bool isRedCheckpoint = (segmentTypeFlags != 0);
         bool isEndOfRedPart = (segmentTypeFlags & 2);
-        LtpFragmentSet::InsertFragment(m_receivedDataFragmentsSet, 
-            LtpFragmentSet::data_fragment_t(dataSegmentMetadata.offset, offsetPlusLength - 1));
-        //LtpFragmentSet::PrintFragmentSet(m_receivedDataFragmentsSet);
+        if ((!m_redPartFilePtr) && M_RX_SPILL_TO_DISK_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE
+            && (offsetPlusLength > M_RX_SPILL_TO_DISK_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) && redPartFileReceptionCallback)
+        {
+            const uint64_t redPartCapacity = (isEndOfRedPart) ? offsetPlusLength :
+                std::min(std::max<uint64_t>(M_RX_SPILL_TO_DISK_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE << 1, offsetPlusLength), M_MAX_RED_RX_BYTES);
+            if (!SpillRedPartToDisk(redPartCapacity)) {
+                std::cerr << "error in LtpSessionReceiver::DataSegmentReceivedCallback: unable to spill red part of session " << M_SESSION_ID << " to disk\n";
+                if (!m_didNotifyForDeletion) {
+                    m_didNotifyForDeletion = true;
+                    m_notifyEngineThatThisReceiverNeedsDeletedCallback(M_SESSION_ID, true, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED); //close session (cancelled)
+                }
+                return;
+            }
+        }
+        if (m_redPartFilePtr) {
+            if (m_redPartFilePtr->GetRedPartCapacity() < offsetPlusLength) {
+                //growing a file never copies the data already received, but still grow geometrically to limit remapping
+                const uint64_t newCapacity = (isEndOfRedPart) ? offsetPlusLength :
+                    std::min(std::max<uint64_t>(m_redPartFilePtr->GetRedPartCapacity() << 1, offsetPlusLength), M_MAX_RED_RX_BYTES);
+                if (!m_redPartFilePtr->Grow(newCapacity)) {
+                    if (!m_didNotifyForDeletion) {
+                        m_didNotifyForDeletion = true;
+                        m_notifyEngineThatThisReceiverNeedsDeletedCallback(M_SESSION_ID, true, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED); //close session (cancelled)
+                    }
+                    return;
+                }
+            }
+            memcpy(m_redPartFilePtr->RedPartData() + dataSegmentMetadata.offset, clientServiceData, dataSegmentMetadata.length);
+        }
+        else {
+            if (m_dataReceivedRed.size() < offsetPlusLength) {
+                if (m_dataReceivedRed.capacity() < offsetPlusLength) {
+                    //the end of red part gives the exact block size; otherwise grow geometrically (bounded by the max red size)
+                    // so that the payload already received is reallocated (copied) as few times as possible
+                    const uint64_t newCapacity = (isEndOfRedPart) ? offsetPlusLength :
+                        std::min(std::max<uint64_t>(m_dataReceivedRed.capacity() << 1, offsetPlusLength), M_MAX_RED_RX_BYTES);
+                    m_dataReceivedRed.reserve(newCapacity);
+                }
+                m_dataReceivedRed.resize(offsetPlusLength);
+            }
+            memcpy(m_dataReceivedRed.data() + dataSegmentMetadata.offset, clientServiceData, dataSegmentMetadata.length);
+        }
+
+        m_receivedDataFragmentsSet.InsertFragment(LtpFragmentSet::data_fragment_t(dataSegmentMetadata.offset, offsetPlusLength - 1));
+        //m_receivedDataFragmentsSet.Print();
         //std::cout << "offset: " << dataSegmentMetadata.offset << " l: " << dataSegmentMetadata.length << " d: " << (int)clientServiceDataVec[0] << std::endl;
         if (isEndOfRedPart) {
             m_lengthOfRedPart = offsetPlusLength;
@@ -311,7 +389,7 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
             }
             else {
                 std::vector<Ltp::report_segment_t> reportSegmentsVec(1);
-                if (!LtpFragmentSet::PopulateReportSegment(m_receivedDataFragmentsSet, reportSegmentsVec[0], lowerBound, upperBound)) {
+                if (!m_receivedDataFragmentsSet.PopulateReportSegment(reportSegmentsVec[0], lowerBound, upperBound)) {
                     std::cerr << "error in LtpSessionReceiver::DataSegmentReceivedCallback: cannot populate report segment\n";
                 }
 
@@ -363,7 +441,7 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
                     const uint64_t rsn = m_nextReportSegmentReportSerialNumber++;
                     reportSegment.reportSerialNumber = rsn;
                     //std::cout << "reportSegment for lb: " << lowerBound << " and ub: " << upperBound << std::endl << reportSegment << std::endl;
-                    //LtpFragmentSet::PrintFragmentSet(m_receivedDataFragmentsSet);
+                    //m_receivedDataFragmentsSet.Print();
 
                     if (!checkpointIsResponseToReportSegment) {
                         m_mapPrimaryReportSegmentsSent[rsn] = reportSegment;
@@ -377,10 +455,15 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
         }
         //std::cout << "m_lengthOfRedPart " << m_lengthOfRedPart << " m_receivedDataFragmentsSet.size() " << m_receivedDataFragmentsSet.size() << std::endl;
         if ((!m_didRedPartReceptionCallback) && (m_lengthOfRedPart != UINT64_MAX) && (m_receivedDataFragmentsSet.size() == 1)) {
-            std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = m_receivedDataFragmentsSet.cbegin();
-            //std::cout << "it->beginIndex " << it->beginIndex << " it->endIndex " << it->endIndex << std::endl;
-            if ((it->beginIndex == 0) && (it->endIndex == (m_lengthOfRedPart - 1))) {
-                if (redPartReceptionCallback) {
+            const LtpFragmentSet::data_fragment_t & receivedFragment = m_receivedDataFragmentsSet.front();
+            //std::cout << "receivedFragment.beginIndex " << receivedFragment.beginIndex << " receivedFragment.endIndex " << receivedFragment.endIndex << std::endl;
+            if ((receivedFragment.beginIndex == 0) && (receivedFragment.endIndex == (m_lengthOfRedPart - 1))) {
+                if (m_redPartFilePtr) { //redPartFileReceptionCallback is set (a prerequisite for spilling)
+                    m_didRedPartReceptionCallback = true;
+                    redPartFileReceptionCallback(M_SESSION_ID,
+                        m_redPartFilePtr, m_lengthOfRedPart, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+                }
+                else if (redPartReceptionCallback) {
                     m_didRedPartReceptionCallback = true;
                     redPartReceptionCallback(M_SESSION_ID,
                         m_dataReceivedRed, m_lengthOfRedPart, dataSegmentMetadata.clientServiceId, isEndOfBlock);
@@ -414,7 +497,12 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
             return;
         }
 
+        if (greenPartSegmentArrivalZeroCopyCallback) {
+            greenPartSegmentArrivalZeroCopyCallback(M_SESSION_ID, clientServiceData, dataSegmentMetadata.length, dataSegmentMetadata.offset,
+                dataSegmentMetadata.clientServiceId, isEndOfBlock);
+        }
         if (greenPartSegmentArrivalCallback) {
+            std::vector<uint8_t> clientServiceDataVec(clientServiceData, clientServiceData + dataSegmentMetadata.length);
             greenPartSegmentArrivalCallback(M_SESSION_ID, clientServiceDataVec, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
         }
         
@@ -15,38 +15,126 @@
 #include "LtpSessionRecreationPreventer.h"
 #include <iostream>
 
-LtpSessionRecreationPreventer::LtpSessionRecreationPreventer(const uint64_t numReceivedSessionsToRemember) :
-    M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER(numReceivedSessionsToRemember),
-    m_previouslyReceivedSessionNumbersUnorderedSet(numReceivedSessionsToRemember + 10), //intial num buckets to prevent rehash
-    m_previouslyReceivedSessionNumbersQueueVector(numReceivedSessionsToRemember),
-    m_queueIsFull(false),
-    m_nextQueueIndex(0)
-{
+static uint64_t MixSessionNumber(uint64_t x) { //splitmix64 finalizer
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
 
+LtpSessionRecreationPreventer::LtpSessionRecreationPreventer(const uint64_t numReceivedSessionsToRemember, const unsigned int fingerprintBits) :
+    M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER((numReceivedSessionsToRemember) ? numReceivedSessionsToRemember : 1),
+    M_FINGERPRINT_MASK((fingerprintBits >= 32) ? UINT32_MAX : (fingerprintBits < 8) ? 0xffu : ((static_cast<uint32_t>(1) << fingerprintBits) - 1)),
+    m_fifoRingBucketIndexAndFingerprint(M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER),
+    m_ringIsFull(false),
+    m_nextRingIndex(0),
+    m_kickCounter(0),
+    m_numInsertionFailures(0)
+{
+    //power of 2 number of buckets for a load factor between 40% and 80% when the history is full
+    const uint64_t minBuckets = (M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER * 5 + (SLOTS_PER_BUCKET * 4) - 1) / (SLOTS_PER_BUCKET * 4);
+    uint64_t numBuckets = 1;
+    while ((numBuckets < minBuckets) && (numBuckets < (static_cast<uint64_t>(1) << 31))) {
+        numBuckets <<= 1;
+    }
+    m_bucketIndexMask = static_cast<uint32_t>(numBuckets - 1);
+    m_fingerprintSlots.assign(numBuckets * SLOTS_PER_BUCKET, 0);
 }
 
 LtpSessionRecreationPreventer::~LtpSessionRecreationPreventer() {}
 
-bool LtpSessionRecreationPreventer::AddSession(const uint64_t newSessionNumber) {
-    if (m_previouslyReceivedSessionNumbersUnorderedSet.insert(newSessionNumber).second) { //successful insertion
-        if (m_queueIsFull) { //remove oldest session number from history
-            if (m_previouslyReceivedSessionNumbersUnorderedSet.erase(m_previouslyReceivedSessionNumbersQueueVector[m_nextQueueIndex]) == 0) {
-                std::cerr << "error in LtpSessionRecreationPreventer::AddSession: unable to erase an old value\n";
-                return false;
-            }
+void LtpSessionRecreationPreventer::Hash(const uint64_t sessionNumber, uint32_t & bucketIndex, uint32_t & fingerprint) const {
+    const uint64_t h = MixSessionNumber(sessionNumber);
+    bucketIndex = static_cast<uint32_t>(h) & m_bucketIndexMask;
+    fingerprint = static_cast<uint32_t>(h >> 32) & M_FINGERPRINT_MASK;
+    fingerprint += (fingerprint == 0); //0 is reserved for an empty slot
+}
+
+uint32_t LtpSessionRecreationPreventer::AltBucketIndex(const uint32_t bucketIndex, const uint32_t fingerprint) const {
+    //partial-key cuckoo hashing: each bucket of a fingerprint can be computed from the other
+    return (bucketIndex ^ (fingerprint * UINT32_C(0x5bd1e995))) & m_bucketIndexMask;
+}
+
+bool LtpSessionRecreationPreventer::BucketContains(const uint32_t bucketIndex, const uint32_t fingerprint) const {
+    const uint32_t * const b = &m_fingerprintSlots[static_cast<std::size_t>(bucketIndex) * SLOTS_PER_BUCKET];
+    return ((b[0] == fingerprint) | (b[1] == fingerprint) | (b[2] == fingerprint) | (b[3] == fingerprint));
+}
+
+bool LtpSessionRecreationPreventer::TryInsertIntoBucket(const uint32_t bucketIndex, const uint32_t fingerprint) {
+    uint32_t * const b = &m_fingerprintSlots[static_cast<std::size_t>(bucketIndex) * SLOTS_PER_BUCKET];
+    for (unsigned int i = 0; i < SLOTS_PER_BUCKET; ++i) {
+        if (b[i] == 0) {
+            b[i] = fingerprint;
+            return true;
         }
-        m_previouslyReceivedSessionNumbersQueueVector[m_nextQueueIndex++] = newSessionNumber;
+    }
+    return false;
+}
 
-        if (m_nextQueueIndex >= M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER) {
-            m_nextQueueIndex = 0;
-            m_queueIsFull = true;
+bool LtpSessionRecreationPreventer::RemoveFromBucket(const uint32_t bucketIndex, const uint32_t fingerprint) {
+    uint32_t * const b = &m_fingerprintSlots[static_cast<std::size_t>(bucketIndex) * SLOTS_PER_BUCKET];
+    for (unsigned int i = 0; i < SLOTS_PER_BUCKET; ++i) {
+        if (b[i] == fingerprint) {
+            b[i] = 0;
+            return true;
         }
-        return true;
     }
     return false;
 }
-bool LtpSessionRecreationPreventer::ContainsSession(const uint64_t newSessionNumber) const {
-    return (m_previouslyReceivedSessionNumbersUnorderedSet.count(newSessionNumber) != 0);
+
+void LtpSessionRecreationPreventer::Insert(uint32_t bucketIndex, uint32_t fingerprint) {
+    if (TryInsertIntoBucket(bucketIndex, fingerprint)) {
+        return;
+    }
+    bucketIndex = AltBucketIndex(bucketIndex, fingerprint);
+    for (unsigned int kick = 0; kick < MAX_KICKS; ++kick) {
+        if (TryInsertIntoBucket(bucketIndex, fingerprint)) {
+            return;
+        }
+        //swap with a resident and move the resident to its other bucket
+        uint32_t & victim = m_fingerprintSlots[static_cast<std::size_t>(bucketIndex) * SLOTS_PER_BUCKET + ((m_kickCounter++) & (SLOTS_PER_BUCKET - 1))];
+        const uint32_t victimFingerprint = victim;
+        victim = fingerprint;
+        fingerprint = victimFingerprint;
+        bucketIndex = AltBucketIndex(bucketIndex, fingerprint);
+    }
+    //the homeless fingerprint is forgotten (its ring entry will find nothing to remove)
+    ++m_numInsertionFailures;
 }
 
+bool LtpSessionRecreationPreventer::AddSession(const uint64_t newSessionNumber) {
+    uint32_t bucketIndex;
+    uint32_t fingerprint;
+    Hash(newSessionNumber, bucketIndex, fingerprint);
+    if (BucketContains(bucketIndex, fingerprint) || BucketContains(AltBucketIndex(bucketIndex, fingerprint), fingerprint)) {
+        return false;
+    }
+    uint64_t & ringEntry = m_fifoRingBucketIndexAndFingerprint[m_nextRingIndex];
+    if (m_ringIsFull) { //remove oldest session number from history
+        const uint32_t oldBucketIndex = static_cast<uint32_t>(ringEntry >> 32);
+        const uint32_t oldFingerprint = static_cast<uint32_t>(ringEntry);
+        if (!RemoveFromBucket(oldBucketIndex, oldFingerprint)) {
+            RemoveFromBucket(AltBucketIndex(oldBucketIndex, oldFingerprint), oldFingerprint);
+        }
+    }
+    Insert(bucketIndex, fingerprint);
+    ringEntry = (static_cast<uint64_t>(bucketIndex) << 32) | fingerprint;
+
+    if (++m_nextRingIndex >= M_NUM_RECEIVED_SESSION_NUMBERS_TO_REMEMBER) {
+        m_nextRingIndex = 0;
+        m_ringIsFull = true;
+    }
+    return true;
+}
+bool LtpSessionRecreationPreventer::ContainsSession(const uint64_t newSessionNumber) const {
+    uint32_t bucketIndex;
+    uint32_t fingerprint;
+    Hash(newSessionNumber, bucketIndex, fingerprint);
+    return BucketContains(bucketIndex, fingerprint) | BucketContains(AltBucketIndex(bucketIndex, fingerprint), fingerprint);
+}
 
+uint64_t LtpSessionRecreationPreventer::GetNumInsertionFailures() const {
+    return m_numInsertionFailures;
+}
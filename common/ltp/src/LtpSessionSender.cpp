@@ -18,17 +18,21 @@
 #include <boost/bind/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/next_prior.hpp>
+#include "MetricsRegistry.h"
 
+static LatencyHistogram & g_metricSendSessionDuration = MetricsRegistry::GetInstance().GetOrCreateHistogram("ltp.sendSessionDuration");
+static LatencyHistogram & g_metricCheckpointRoundTripTime = MetricsRegistry::GetInstance().GetOrCreateHistogram("ltp.checkpointRoundTripTime");
 
 
 LtpSessionSender::LtpSessionSender(uint64_t randomInitialSenderCheckpointSerialNumber,
     LtpClientServiceDataToSend && dataToSend, std::shared_ptr<LtpTransmissionRequestUserData> && userDataPtrToTake,
     uint64_t lengthOfRedPart, const uint64_t MTU, const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef, 
+    LtpHeaderBufferPool & headerBufferPoolRef,
     const NotifyEngineThatThisSenderNeedsDeletedCallback_t & notifyEngineThatThisSenderNeedsDeletedCallback,
     const NotifyEngineThatThisSenderHasProducibleDataFunction_t & notifyEngineThatThisSenderHasProducibleDataFunction,
     const InitialTransmissionCompletedCallback_t & initialTransmissionCompletedCallback, 
-    const uint64_t checkpointEveryNthDataPacket, const uint32_t maxRetriesPerSerialNumber) :
+    const uint64_t checkpointEveryNthDataPacket, const uint32_t maxRetriesPerSerialNumber, LtpAdaptiveController * adaptiveControllerPtr) :
     m_timeManagerOfCheckpointSerialNumbers(ioServiceRef, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpSessionSender::LtpCheckpointTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
     m_receptionClaimIndex(0),
     m_nextCheckpointSerialNumber(randomInitialSenderCheckpointSerialNumber),
@@ -42,19 +46,27 @@ LtpSessionSender::LtpSessionSender(uint64_t randomInitialSenderCheckpointSerialN
     M_CLIENT_SERVICE_ID(clientServiceId),
     M_CHECKPOINT_EVERY_NTH_DATA_PACKET(checkpointEveryNthDataPacket),
     m_checkpointEveryNthDataPacketCounter(checkpointEveryNthDataPacket),
+    m_adaptiveControllerPtr(adaptiveControllerPtr),
     M_MAX_RETRIES_PER_SERIAL_NUMBER(maxRetriesPerSerialNumber),
     m_ioServiceRef(ioServiceRef),
+    m_headerBufferPoolRef(headerBufferPoolRef),
     m_notifyEngineThatThisSenderNeedsDeletedCallback(notifyEngineThatThisSenderNeedsDeletedCallback),
     m_notifyEngineThatThisSenderHasProducibleDataFunction(notifyEngineThatThisSenderHasProducibleDataFunction),
     m_initialTransmissionCompletedCallback(initialTransmissionCompletedCallback),
     m_numCheckpointTimerExpiredCallbacks(0),
-    m_numDiscretionaryCheckpointsNotResent(0)
+    m_numDiscretionaryCheckpointsNotResent(0),
+    m_creationTimestampNanoseconds(LatencyHistogram::NowNanoseconds())
 {
     m_notifyEngineThatThisSenderHasProducibleDataFunction(M_SESSION_ID.sessionNumber); //to trigger first pass of red data
 }
 
 LtpSessionSender::~LtpSessionSender() {
     //std::cout << "~LtpSessionSender" << std::endl;
+    g_metricSendSessionDuration.RecordSince(m_creationTimestampNanoseconds);
+}
+
+uint64_t LtpSessionSender::GetMemoryFootprintBytes() const {
+    return m_dataToSend.size();
 }
 
 void LtpSessionSender::LtpCheckpointTimerExpiredCallback(uint64_t checkpointSerialNumber, std::vector<uint8_t> & userData) {
@@ -75,6 +87,9 @@ void LtpSessionSender::LtpCheckpointTimerExpiredCallback(uint64_t checkpointSeri
     //(conceptual) application data queue for the destination LTP engine.
     //std::cout << "LtpCheckpointTimerExpiredCallback timer expired!!! checkpointSerialNumber = " << checkpointSerialNumber << std::endl;
     ++m_numCheckpointTimerExpiredCallbacks;
+    if (m_adaptiveControllerPtr) {
+        m_adaptiveControllerPtr->OnCheckpointTimerExpired();
+    }
     if (userData.size() != sizeof(resend_fragment_t)) {
         std::cerr << "error in LtpSessionSender::LtpCheckpointTimerExpiredCallback: userData.size() != sizeof(resend_fragment_t)\n";
         return;
@@ -84,7 +99,7 @@ void LtpSessionSender::LtpCheckpointTimerExpiredCallback(uint64_t checkpointSeri
 
     if (resendFragment.retryCount <= M_MAX_RETRIES_PER_SERIAL_NUMBER) {
         const bool isDiscretionaryCheckpoint = (resendFragment.flags == LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT);
-        if (isDiscretionaryCheckpoint && LtpFragmentSet::ContainsFragmentEntirely(m_dataFragmentsAckedByReceiver, LtpFragmentSet::data_fragment_t(resendFragment.offset, (resendFragment.offset + resendFragment.length) - 1))) {
+        if (isDiscretionaryCheckpoint && m_dataFragmentsAckedByReceiver.ContainsFragmentEntirely(LtpFragmentSet::data_fragment_t(resendFragment.offset, (resendFragment.offset + resendFragment.length) - 1))) {
             //std::cout << "  Discretionary checkpoint not being resent because its data was already received successfully by the receiver." << std::endl;
             ++m_numDiscretionaryCheckpointsNotResent;
         }
@@ -103,6 +118,33 @@ void LtpSessionSender::LtpCheckpointTimerExpiredCallback(uint64_t checkpointSeri
     }
 }
 
+void LtpSessionSender::StartCheckpointTimer(resend_fragment_t & resendFragment) {
+    ++m_sessionStats.numCheckpointsSent;
+    resendFragment.checkpointSentTimestampNanoseconds = LatencyHistogram::NowNanoseconds();
+    if (m_adaptiveControllerPtr) {
+        m_timeManagerOfCheckpointSerialNumbers.SetTransmissionToAckReceivedTime(
+            boost::posix_time::microseconds(static_cast<int64_t>(m_adaptiveControllerPtr->GetCheckpointTimeoutNanoseconds() / 1000)));
+    }
+    const uint8_t * const resendFragmentPtr = (uint8_t*)&resendFragment;
+    m_timeManagerOfCheckpointSerialNumbers.StartTimer(resendFragment.checkpointSerialNumber, std::vector<uint8_t>(resendFragmentPtr, resendFragmentPtr + sizeof(resendFragment)));
+}
+
+void LtpSessionSender::GenerateDataSegmentHeader(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback,
+    LTP_DATA_SEGMENT_TYPE_FLAGS flags, const Ltp::data_segment_metadata_t & meta)
+{
+    constBufferVec.resize(3); //3 in case of trailer
+    if (uint8_t * const pooledHeader = m_headerBufferPoolRef.Acquire()) { //no header extensions, so always fits in a slot
+        const uint64_t headerSize = Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(pooledHeader, flags, M_SESSION_ID, meta, NULL, 0);
+        constBufferVec[0] = boost::asio::buffer(pooledHeader, headerSize);
+        underlyingDataToDeleteOnSentCallback.reset();
+    }
+    else { //every slot is awaiting its send completion
+        underlyingDataToDeleteOnSentCallback = boost::make_shared<std::vector<std::vector<uint8_t> > >(2); //2 in case of trailer extensions
+        Ltp::GenerateLtpHeaderPlusDataSegmentMetadata((*underlyingDataToDeleteOnSentCallback)[0], flags, M_SESSION_ID, meta, NULL, 0);
+        constBufferVec[0] = boost::asio::buffer((*underlyingDataToDeleteOnSentCallback)[0]);
+    }
+}
+
 bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback) {
     if (!m_nonDataToSend.empty()) { //includes report ack segments
         //std::cout << "sender dequeue\n";
@@ -137,22 +179,20 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
             //the remote LTP engine has ceased transmission(Section 6.5), then
             //this timer is immediately suspended, because the computed expected
             //arrival time may require an adjustment that cannot yet be computed.
-            const uint8_t * const resendFragmentPtr = (uint8_t*)&resendFragment;
             //std::cout << "resend csn " << resendFragment.checkpointSerialNumber << std::endl;
-            m_timeManagerOfCheckpointSerialNumbers.StartTimer(resendFragment.checkpointSerialNumber, std::vector<uint8_t>(resendFragmentPtr, resendFragmentPtr + sizeof(resendFragment)));
+            StartCheckpointTimer(resendFragment);
         }
         else {
             meta.checkpointSerialNumber = NULL;
             meta.reportSerialNumber = NULL;
         }
-        underlyingDataToDeleteOnSentCallback = boost::make_shared<std::vector<std::vector<uint8_t> > >(2); //2 in case of trailer extensions
-        Ltp::GenerateLtpHeaderPlusDataSegmentMetadata((*underlyingDataToDeleteOnSentCallback)[0], resendFragment.flags,
-            M_SESSION_ID, meta, NULL, 0);
-        constBufferVec.resize(3); //3 in case of trailer
-        constBufferVec[0] = boost::asio::buffer((*underlyingDataToDeleteOnSentCallback)[0]);
+        GenerateDataSegmentHeader(constBufferVec, underlyingDataToDeleteOnSentCallback, resendFragment.flags, meta);
         //std::cout << "rf o: " << resendFragment.offset << " l: " << resendFragment.length << " flags: " << (int)resendFragment.flags << std::endl;
         //std::cout << (int)(*(m_dataToSend.data() + resendFragment.offset)) << std::endl;
         constBufferVec[1] = boost::asio::buffer(m_dataToSend.data() + resendFragment.offset, resendFragment.length);
+        ++m_sessionStats.numDataSegmentsSent;
+        ++m_sessionStats.numDataSegmentsResent;
+        m_sessionStats.numRedBytesResent += resendFragment.length;
         m_resendFragmentsQueue.pop();
         return true;
     }
@@ -163,7 +203,7 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
             const bool isEndOfRedPart = ((bytesToSendRed + m_dataIndexFirstPass) == M_LENGTH_OF_RED_PART);
             bool isPeriodicCheckpoint = false;
             if (M_CHECKPOINT_EVERY_NTH_DATA_PACKET && (--m_checkpointEveryNthDataPacketCounter == 0)) {
-                m_checkpointEveryNthDataPacketCounter = M_CHECKPOINT_EVERY_NTH_DATA_PACKET;
+                m_checkpointEveryNthDataPacketCounter = (m_adaptiveControllerPtr) ? m_adaptiveControllerPtr->GetCheckpointEveryNthDataPacket() : M_CHECKPOINT_EVERY_NTH_DATA_PACKET;
                 isPeriodicCheckpoint = true;
             }
             const bool isCheckpoint = isPeriodicCheckpoint || isEndOfRedPart;
@@ -187,8 +227,7 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
                 }
                 //std::cout << "send sync csn " << cp << std::endl;
                 LtpSessionSender::resend_fragment_t resendFragment(m_dataIndexFirstPass, bytesToSendRed, cp, rsn, flags);
-                const uint8_t * const resendFragmentPtr = (uint8_t*)&resendFragment;
-                m_timeManagerOfCheckpointSerialNumbers.StartTimer(cp, std::vector<uint8_t>(resendFragmentPtr, resendFragmentPtr + sizeof(resendFragment)));
+                StartCheckpointTimer(resendFragment);
             }
 
             Ltp::data_segment_metadata_t meta;
@@ -197,11 +236,7 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
             meta.length = bytesToSendRed;
             meta.checkpointSerialNumber = checkpointSerialNumber;
             meta.reportSerialNumber = reportSerialNumber;
-            underlyingDataToDeleteOnSentCallback = boost::make_shared<std::vector<std::vector<uint8_t> > >(2); //2 in case of trailer extensions
-            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata((*underlyingDataToDeleteOnSentCallback)[0], flags,
-                M_SESSION_ID, meta, NULL, 0);
-            constBufferVec.resize(3); //3 in case of trailer
-            constBufferVec[0] = boost::asio::buffer((*underlyingDataToDeleteOnSentCallback)[0]);
+            GenerateDataSegmentHeader(constBufferVec, underlyingDataToDeleteOnSentCallback, flags, meta);
             constBufferVec[1] = boost::asio::buffer(m_dataToSend.data() + m_dataIndexFirstPass, bytesToSendRed);
             m_dataIndexFirstPass += bytesToSendRed;
         }
@@ -218,14 +253,11 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
             meta.length = bytesToSendGreen;
             meta.checkpointSerialNumber = NULL;
             meta.reportSerialNumber = NULL;
-            underlyingDataToDeleteOnSentCallback = boost::make_shared<std::vector<std::vector<uint8_t> > >(2); //2 in case of trailer extensions
-            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata((*underlyingDataToDeleteOnSentCallback)[0], flags,
-                M_SESSION_ID, meta, NULL, 0);
-            constBufferVec.resize(3); //3 in case of trailer
-            constBufferVec[0] = boost::asio::buffer((*underlyingDataToDeleteOnSentCallback)[0]);
+            GenerateDataSegmentHeader(constBufferVec, underlyingDataToDeleteOnSentCallback, flags, meta);
             constBufferVec[1] = boost::asio::buffer(m_dataToSend.data() + m_dataIndexFirstPass, bytesToSendGreen);
             m_dataIndexFirstPass += bytesToSendGreen;
         }
+        ++m_sessionStats.numDataSegmentsSent;
         if (m_dataIndexFirstPass == m_dataToSend.size()) { //only ever enters here once
             m_initialTransmissionCompletedCallback(M_SESSION_ID, m_userDataPtr);
             if (M_LENGTH_OF_RED_PART == 0) { //fully green case complete (notify engine for deletion)
@@ -234,14 +266,10 @@ bool LtpSessionSender::NextDataToSend(std::vector<boost::asio::const_buffer> & c
                     m_notifyEngineThatThisSenderNeedsDeletedCallback(M_SESSION_ID, false, CANCEL_SEGMENT_REASON_CODES::RESERVED, m_userDataPtr);
                 }
             }
-            else if (m_dataFragmentsAckedByReceiver.size() == 1) { //in case red data already acked before green data send completes
-                std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = m_dataFragmentsAckedByReceiver.cbegin();
-                //std::cout << "it->beginIndex " << it->beginIndex << " it->endIndex " << it->endIndex << std::endl;
-                if ((it->beginIndex == 0) && (it->endIndex >= (M_LENGTH_OF_RED_PART - 1))) { //>= in case some green data was acked
-                    if (!m_didNotifyForDeletion) {
-                        m_didNotifyForDeletion = true;
-                        m_notifyEngineThatThisSenderNeedsDeletedCallback(M_SESSION_ID, false, CANCEL_SEGMENT_REASON_CODES::RESERVED, m_userDataPtr);
-                    }
+            else if (m_dataFragmentsAckedByReceiver.ContainsPrefix(M_LENGTH_OF_RED_PART)) { //in case red data already acked before green data send completes (some green data may also be acked)
+                if (!m_didNotifyForDeletion) {
+                    m_didNotifyForDeletion = true;
+                    m_notifyEngineThatThisSenderNeedsDeletedCallback(M_SESSION_ID, false, CANCEL_SEGMENT_REASON_CODES::RESERVED, m_userDataPtr);
                 }
             }
         }
@@ -278,15 +306,46 @@ void LtpSessionSender::ReportSegmentReceivedCallback(const Ltp::report_segment_t
 
     //If the report's checkpoint serial number is not zero, then the
     //countdown timer associated with the indicated checkpoint segment is deleted.
-    if (reportSegment.checkpointSerialNumber) {
+    ++m_sessionStats.numReportSegmentsReceived;
+    std::vector<uint8_t> & checkpointUserData = m_checkpointUserDataTemp;
+    if (reportSegment.checkpointSerialNumber && m_timeManagerOfCheckpointSerialNumbers.DeleteTimer(reportSegment.checkpointSerialNumber, checkpointUserData)
+        && (checkpointUserData.size() == sizeof(resend_fragment_t)))
+    {
         //std::cout << "delete rs's csn " << reportSegment.checkpointSerialNumber << std::endl;
-        m_timeManagerOfCheckpointSerialNumbers.DeleteTimer(reportSegment.checkpointSerialNumber);
+        resend_fragment_t checkpointFragment;
+        memcpy(&checkpointFragment, checkpointUserData.data(), sizeof(checkpointFragment));
+        if (checkpointFragment.retryCount == 1) { //sent only once, so the report unambiguously answers this send (Karn's algorithm)
+            const uint64_t roundTripTimeNanoseconds = LatencyHistogram::NowNanoseconds() - checkpointFragment.checkpointSentTimestampNanoseconds;
+            g_metricCheckpointRoundTripTime.RecordNanoseconds(roundTripTimeNanoseconds);
+            m_sessionStats.lastRoundTripTimeNanoseconds = roundTripTimeNanoseconds;
+            if ((m_sessionStats.numRoundTripTimeSamples == 0) || (roundTripTimeNanoseconds < m_sessionStats.minRoundTripTimeNanoseconds)) {
+                m_sessionStats.minRoundTripTimeNanoseconds = roundTripTimeNanoseconds;
+            }
+            if (roundTripTimeNanoseconds > m_sessionStats.maxRoundTripTimeNanoseconds) {
+                m_sessionStats.maxRoundTripTimeNanoseconds = roundTripTimeNanoseconds;
+            }
+            ++m_sessionStats.numRoundTripTimeSamples;
+            if (m_adaptiveControllerPtr) {
+                m_adaptiveControllerPtr->OnRoundTripTimeSample(roundTripTimeNanoseconds);
+            }
+        }
+        if (m_adaptiveControllerPtr && (checkpointFragment.reportSerialNumber == 0)) { //a first pass checkpoint (not a retransmission), so the claims measure loss
+            uint64_t claimedBytes = 0;
+            for (std::vector<Ltp::reception_claim_t>::const_iterator it = reportSegment.receptionClaims.cbegin(); it != reportSegment.receptionClaims.cend(); ++it) {
+                claimedBytes += it->length;
+            }
+            m_adaptiveControllerPtr->OnFirstPassReportClaims(reportSegment.upperBound - reportSegment.lowerBound, claimedBytes);
+        }
     }
 
-
-    LtpFragmentSet::AddReportSegmentToFragmentSet(m_dataFragmentsAckedByReceiver, reportSegment);
+    const uint64_t numRedBytesAckedBeforeReport = m_dataFragmentsAckedByReceiver.GetNumBytes();
+    m_dataFragmentsAckedByReceiver.AddReportSegment(reportSegment);
+    m_sessionStats.numRedBytesAcked = m_dataFragmentsAckedByReceiver.GetNumBytes();
+    if (m_adaptiveControllerPtr) {
+        m_adaptiveControllerPtr->OnBytesDelivered(LatencyHistogram::NowNanoseconds(), m_sessionStats.numRedBytesAcked - numRedBytesAckedBeforeReport);
+    }
     //std::cout << "rs: " << reportSegment << std::endl;
-    //std::cout << "acked segments: "; LtpFragmentSet::PrintFragmentSet(m_dataFragmentsAckedByReceiver); std::cout << std::endl;
+    //std::cout << "acked segments: "; m_dataFragmentsAckedByReceiver.Print(); std::cout << std::endl;
     //6.12.  Signify Transmission Completion
     //
     //This procedure is triggered at the earliest time at which(a) all
@@ -306,14 +365,10 @@ void LtpSessionSender::ReportSegmentReceivedCallback(const Ltp::report_segment_t
     //invoked.
     //std::cout << "M_LENGTH_OF_RED_PART " << M_LENGTH_OF_RED_PART << " m_dataFragmentsAckedByReceiver.size() " << m_dataFragmentsAckedByReceiver.size() << std::endl;
     //std::cout << "m_dataIndexFirstPass " << m_dataIndexFirstPass << " m_dataToSend.size() " << m_dataToSend.size() << std::endl;
-    if ((m_dataIndexFirstPass == m_dataToSend.size()) && (m_dataFragmentsAckedByReceiver.size() == 1)) {
-        std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = m_dataFragmentsAckedByReceiver.cbegin();
-        //std::cout << "it->beginIndex " << it->beginIndex << " it->endIndex " << it->endIndex << std::endl;
-        if ((it->beginIndex == 0) && (it->endIndex >= (M_LENGTH_OF_RED_PART - 1))) { //>= in case some green data was acked
-            if (!m_didNotifyForDeletion) {
-                m_didNotifyForDeletion = true;
-                m_notifyEngineThatThisSenderNeedsDeletedCallback(M_SESSION_ID, false, CANCEL_SEGMENT_REASON_CODES::RESERVED, m_userDataPtr);
-            }
+    if ((m_dataIndexFirstPass == m_dataToSend.size()) && m_dataFragmentsAckedByReceiver.ContainsPrefix(M_LENGTH_OF_RED_PART)) { //some green data may also be acked
+        if (!m_didNotifyForDeletion) {
+            m_didNotifyForDeletion = true;
+            m_notifyEngineThatThisSenderNeedsDeletedCallback(M_SESSION_ID, false, CANCEL_SEGMENT_REASON_CODES::RESERVED, m_userDataPtr);
         }
     }
     
@@ -328,11 +383,11 @@ void LtpSessionSender::ReportSegmentReceivedCallback(const Ltp::report_segment_t
     //segment carrying a new CP serial number(obtained by
     //incrementing the last CP serial number used) and the report
     //serial number of the received RS segment.
-    std::set<LtpFragmentSet::data_fragment_t> fragmentsNeedingResent;
-    LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(fragmentsNeedingResent, reportSegment);
+    std::vector<LtpFragmentSet::data_fragment_t> & fragmentsNeedingResent = m_fragmentsNeedingResent;
+    LtpFragmentIntervalSet::GetFragmentsNeedingResent(reportSegment, fragmentsNeedingResent);
     //std::cout << "need resent: "; LtpFragmentSet::PrintFragmentSet(fragmentsNeedingResent); std::cout << std::endl;
     //std::cout << "resend\n";
-    for (std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = fragmentsNeedingResent.cbegin(); it != fragmentsNeedingResent.cend(); ++it) {
+    for (std::vector<LtpFragmentSet::data_fragment_t>::const_iterator it = fragmentsNeedingResent.cbegin(); it != fragmentsNeedingResent.cend(); ++it) {
         //std::cout << "h1\n";
         const bool isLastFragmentNeedingResent = (boost::next(it) == fragmentsNeedingResent.cend());
         for (uint64_t dataIndex = it->beginIndex; dataIndex <= it->endIndex; ) {
@@ -15,6 +15,7 @@
 #include "LtpTimerManager.h"
 #include <iostream>
 #include <boost/bind/bind.hpp>
+#include <boost/next_prior.hpp>
 #include "Ltp.h"
 
 template <class idType>
@@ -23,7 +24,7 @@ LtpTimerManager<idType>::LtpTimerManager(boost::asio::io_service & ioService, co
     m_deadlineTimer(ioService),
     M_ONE_WAY_LIGHT_TIME(oneWayLightTime),
     M_ONE_WAY_MARGIN_TIME(oneWayMarginTime),
-    M_TRANSMISSION_TO_ACK_RECEIVED_TIME((oneWayLightTime * 2) + (oneWayMarginTime * 2)),
+    m_transmissionToAckReceivedTime((oneWayLightTime * 2) + (oneWayMarginTime * 2)),
     m_ltpTimerExpiredCallbackFunction(callback),
     m_timerIsDeletedPtr(new bool(false))
 {
@@ -55,19 +56,34 @@ void LtpTimerManager<idType>::Reset() {
 }
 
 
+template <class idType>
+void LtpTimerManager<idType>::SetTransmissionToAckReceivedTime(const boost::posix_time::time_duration & transmissionToAckReceivedTime) {
+    m_transmissionToAckReceivedTime = transmissionToAckReceivedTime;
+}
+
 template <class idType>
 bool LtpTimerManager<idType>::StartTimer(const idType serialNumber, std::vector<uint8_t> userData) {
-    //expiry will always be appended to list (always greater than previous) (duplicate expiries ok)
-    const boost::posix_time::ptime expiry = boost::posix_time::microsec_clock::universal_time() + M_TRANSMISSION_TO_ACK_RECEIVED_TIME;
+    //expiry will almost always be appended to list (greater than or equal to previous) (duplicate expiries ok)
+    //unless the transmission to ack received time was shortened
+    const boost::posix_time::ptime expiry = boost::posix_time::microsec_clock::universal_time() + m_transmissionToAckReceivedTime;
     
     std::pair<typename id_to_listiteratorplususerdata_map_t::iterator, bool> retVal =
         m_mapCheckpointSerialNumberToExpiryListIteratorPlusUserData.emplace(serialNumber, listiterator_userdata_pair_t());
     if (retVal.second) {
         //value was inserted
-        retVal.first->second.first = m_listCheckpointSerialNumberPlusExpiry.insert(m_listCheckpointSerialNumberPlusExpiry.end(), id_ptime_pair_t(serialNumber,expiry));
+        typename id_ptime_list_t::iterator insertBeforeIt = m_listCheckpointSerialNumberPlusExpiry.end();
+        while ((insertBeforeIt != m_listCheckpointSerialNumberPlusExpiry.begin()) && (boost::prior(insertBeforeIt)->second > expiry)) {
+            --insertBeforeIt;
+        }
+        const bool isNewEarliestExpiry = (insertBeforeIt == m_listCheckpointSerialNumberPlusExpiry.begin());
+        retVal.first->second.first = m_listCheckpointSerialNumberPlusExpiry.insert(insertBeforeIt, id_ptime_pair_t(serialNumber,expiry));
         retVal.first->second.second = std::move(userData);
         //std::cout << "StartTimer inserted " << serialNumber << std::endl;
-        if (!m_isTimerActive) { //timer is not running
+        if (m_isTimerActive && isNewEarliestExpiry) { //expires before the running one, so cancel it (which will automatically start this one)
+            m_activeSerialNumberBeingTimed = 0;
+            m_deadlineTimer.cancel();
+        }
+        else if (!m_isTimerActive) { //timer is not running
             //std::cout << "StartTimer started timer for " << serialNumber << std::endl;
             m_activeSerialNumberBeingTimed = serialNumber;
             m_deadlineTimer.expires_at(expiry);
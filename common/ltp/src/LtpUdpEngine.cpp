@@ -23,7 +23,8 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     const boost::asio::ip::udp::endpoint & remoteEndpoint, const unsigned int numUdpRxCircularBufferVectors,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
     uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
-    const uint64_t maxSimultaneousSessions, const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable) :
+    const uint64_t maxSimultaneousSessions, const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable,
+    const unsigned int numUdpRxSockets) :
     LtpEngine(thisEngineId, engineIndexForEncodingIntoRandomSessionNumber, mtuClientServiceData, mtuReportSegment, oneWayLightTime, oneWayMarginTime,
         ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, true, checkpointEveryNthDataPacketSender, maxRetriesPerSerialNumber,
         force32BitRandomNumbers, maxSendRateBitsPerSecOrZeroToDisable, maxSimultaneousSessions, rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable),
@@ -32,14 +33,22 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     m_remoteEndpoint(remoteEndpoint),
     M_NUM_CIRCULAR_BUFFER_VECTORS(numUdpRxCircularBufferVectors),
     M_MAX_UDP_RX_PACKET_SIZE_BYTES(maxUdpRxPacketSizeBytes),
-    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_printedCbTooSmallNotice(false),
+    m_udpRxQueues((numUdpRxSockets) ? numUdpRxSockets : 1),
+    m_rxSocketIndexOfPacketBeingProcessed(0),
     m_countAsyncSendCalls(0),
     m_countAsyncSendCallbackCalls(0),
     m_countCircularBufferOverruns(0)
 {
-    for (unsigned int i = 0; i < M_NUM_CIRCULAR_BUFFER_VECTORS; ++i) {
+    //the queues of any additional receive sockets are allocated by their receive threads on their first packet
+    m_udpRxQueues[0] = boost::make_unique<udp_rx_queue_t>(M_NUM_CIRCULAR_BUFFER_VECTORS, M_MAX_UDP_RX_PACKET_SIZE_BYTES);
+}
+
+LtpUdpEngine::udp_rx_queue_t::udp_rx_queue_t(const unsigned int numCircularBufferVectors, const uint64_t maxUdpRxPacketSizeBytes) :
+    m_circularIndexBuffer(numCircularBufferVectors),
+    m_udpReceiveBuffersCbVec(numCircularBufferVectors),
+    m_printedCbTooSmallNotice(false)
+{
+    for (unsigned int i = 0; i < numCircularBufferVectors; ++i) {
         m_udpReceiveBuffersCbVec[i].resize(maxUdpRxPacketSizeBytes);
     }
 }
@@ -58,46 +67,69 @@ void LtpUdpEngine::Reset() {
 }
 
 
-void LtpUdpEngine::PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size) {
-    const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
+void LtpUdpEngine::PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size, const unsigned int rxSocketIndex) {
+    std::unique_ptr<udp_rx_queue_t> & rxQueuePtr = m_udpRxQueues[rxSocketIndex];
+    if (!rxQueuePtr) { //only this receive thread touches this queue before posting its first packet (the post publishes it to the LtpEngine thread)
+        rxQueuePtr = boost::make_unique<udp_rx_queue_t>(M_NUM_CIRCULAR_BUFFER_VECTORS, M_MAX_UDP_RX_PACKET_SIZE_BYTES);
+    }
+    udp_rx_queue_t & rxQueue = *rxQueuePtr;
+    const unsigned int writeIndex = rxQueue.m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
     if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
-        ++m_countCircularBufferOverruns;
-        if (!m_printedCbTooSmallNotice) {
-            m_printedCbTooSmallNotice = true;
+        m_countCircularBufferOverruns.fetch_add(1, std::memory_order_relaxed);
+        if (!rxQueue.m_printedCbTooSmallNotice) {
+            rxQueue.m_printedCbTooSmallNotice = true;
             std::cout << "notice in LtpUdpEngine::StartUdpReceive(): buffers full.. you might want to increase the circular buffer size! Next UDP packet will be dropped!" << std::endl;
         }
     }
     else {
-        packetIn_thenSwappedForAnotherSameSizeVector.swap(m_udpReceiveBuffersCbVec[writeIndex]);
-        m_circularIndexBuffer.CommitWrite(); //write complete at this point
-        PacketIn_ThreadSafe(m_udpReceiveBuffersCbVec[writeIndex].data(), size); //Post to the LtpEngine IoService so its thread will process
+        packetIn_thenSwappedForAnotherSameSizeVector.swap(rxQueue.m_udpReceiveBuffersCbVec[writeIndex]);
+        rxQueue.m_circularIndexBuffer.CommitWrite(); //write complete at this point
+        //Post to the LtpEngine IoService so its thread will process
+        boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpUdpEngine::PacketInFromRxQueue, this, rxSocketIndex, rxQueue.m_udpReceiveBuffersCbVec[writeIndex].data(), size));
     }
 }
 
 void LtpUdpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId) {
     //called by LtpEngine Thread
     ++m_countAsyncSendCalls;
+    const void * const headerPtr = constBufferVec[0].data(); //may be a slot from m_headerBufferPool, released in HandleUdpSend
     if (m_udpDropSimulatorFunction && m_udpDropSimulatorFunction(*((uint8_t*)constBufferVec[0].data()))) {
-        boost::asio::post(m_ioServiceUdpRef, boost::bind(&LtpUdpEngine::HandleUdpSend, this, underlyingDataToDeleteOnSentCallback, boost::system::error_code(), 0));
+        boost::asio::post(m_ioServiceUdpRef, boost::bind(&LtpUdpEngine::HandleUdpSend, this, underlyingDataToDeleteOnSentCallback, headerPtr, boost::system::error_code(), 0));
+    }
+    else if (constBufferVec.size() <= 3) {
+        //copy into a fixed size buffer sequence so that the async operation doesn't have to allocate a copy of the vector
+        std::array<boost::asio::const_buffer, 3> constBufferArray;
+        std::copy(constBufferVec.begin(), constBufferVec.end(), constBufferArray.begin());
+        m_udpSocketRef.async_send_to(constBufferArray, m_remoteEndpoint,
+            boost::bind(&LtpUdpEngine::HandleUdpSend, this, std::move(underlyingDataToDeleteOnSentCallback), headerPtr,
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
     }
     else {
         m_udpSocketRef.async_send_to(constBufferVec, m_remoteEndpoint,
-            boost::bind(&LtpUdpEngine::HandleUdpSend, this, std::move(underlyingDataToDeleteOnSentCallback),
+            boost::bind(&LtpUdpEngine::HandleUdpSend, this, std::move(underlyingDataToDeleteOnSentCallback), headerPtr,
                 boost::asio::placeholders::error,
                 boost::asio::placeholders::bytes_transferred));
     }
 }
 
 
+void LtpUdpEngine::PacketInFromRxQueue(const unsigned int rxSocketIndex, const uint8_t * data, const std::size_t size) {
+    //Called by LTP Engine thread
+    m_rxSocketIndexOfPacketBeingProcessed = rxSocketIndex;
+    PacketIn(data, size);
+}
+
 void LtpUdpEngine::PacketInFullyProcessedCallback(bool success) {
     //Called by LTP Engine thread
     //std::cout << "PacketInFullyProcessedCallback " << std::endl;
-    m_circularIndexBuffer.CommitRead(); //LtpEngine IoService thread will CommitRead
+    m_udpRxQueues[m_rxSocketIndexOfPacketBeingProcessed]->m_circularIndexBuffer.CommitRead(); //LtpEngine IoService thread will CommitRead
 }
 
 
 
-void LtpUdpEngine::HandleUdpSend(boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const boost::system::error_code& error, std::size_t bytes_transferred) {
+void LtpUdpEngine::HandleUdpSend(boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const void * headerPtr, const boost::system::error_code& error, std::size_t bytes_transferred) {
+    m_headerBufferPool.Release(headerPtr); //does nothing if the header was heap allocated (underlyingDataToDeleteOnSentCallback)
     ++m_countAsyncSendCallbackCalls;
     if (error) {
         std::cerr << "error in LtpUdpEngine::HandleUdpSend: " << error.message() << std::endl;
@@ -15,8 +15,17 @@
 #include "LtpUdpEngineManager.h"
 #include <boost/make_unique.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/future.hpp>
 #include "Sdnv.h"
 
+#ifdef SO_REUSEPORT
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port_option_t;
+#endif
+
+static unsigned int HashRemoteEngineId(const uint64_t remoteEngineId, const unsigned int numBits) { //fibonacci hashing
+    return static_cast<unsigned int>((remoteEngineId * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - numBits));
+}
+
 //c++ shared singleton using weak pointer
 //https://codereview.stackexchange.com/questions/14343/c-shared-singleton
 std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> > LtpUdpEngineManager::m_staticMapBoundPortToLtpUdpEngineManagerPtr;
@@ -43,7 +52,7 @@ void LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t max
 }
 
 //static function
-std::shared_ptr<LtpUdpEngineManager> LtpUdpEngineManager::GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart) {
+std::shared_ptr<LtpUdpEngineManager> LtpUdpEngineManager::GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart, const unsigned int numUdpRxSockets) {
     boost::mutex::scoped_lock theLock(m_staticMutex);
     std::shared_ptr<LtpUdpEngineManager> sp;
     if (M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES == 0) {
@@ -52,26 +61,49 @@ std::shared_ptr<LtpUdpEngineManager> LtpUdpEngineManager::GetOrCreateInstance(co
     else {
         std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> >::iterator it = m_staticMapBoundPortToLtpUdpEngineManagerPtr.find(myBoundUdpPort);
         if ((it == m_staticMapBoundPortToLtpUdpEngineManagerPtr.end()) || (it->second.expired())) { //create new instance
-            sp.reset(new LtpUdpEngineManager(myBoundUdpPort, autoStart));
+            sp.reset(new LtpUdpEngineManager(myBoundUdpPort, autoStart, numUdpRxSockets));
             m_staticMapBoundPortToLtpUdpEngineManagerPtr[myBoundUdpPort] = sp;
         }
         else {
             sp = it->second.lock();
+            if (sp->GetNumUdpRxSockets() != ((numUdpRxSockets) ? numUdpRxSockets : 1)) {
+                std::cout << "notice in LtpUdpEngineManager::GetOrCreateInstance: UDP port " << myBoundUdpPort << " already has "
+                    << sp->GetNumUdpRxSockets() << " receive socket(s).. ignoring request for " << numUdpRxSockets << "\n";
+            }
         }
     }
     return sp;
 }
 
 //private constructor
-LtpUdpEngineManager::LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bool autoStart) :
+LtpUdpEngineManager::LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bool autoStart, const unsigned int numUdpRxSockets) :
     M_MY_BOUND_UDP_PORT(myBoundUdpPort),
+#ifdef SO_REUSEPORT
+    M_NUM_UDP_RX_SOCKETS((numUdpRxSockets) ? numUdpRxSockets : 1),
+#else
+    M_NUM_UDP_RX_SOCKETS(1),
+#endif
     m_resolver(m_ioServiceUdp),
     m_udpSocket(m_ioServiceUdp),
     m_udpReceiveBuffer(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES),
-    m_vecEngineIndexToLtpUdpEngineTransmitterPtr(256, NULL),
+    m_receiverHashTable(new receiver_hash_table_slot_t[RECEIVER_HASH_TABLE_SIZE]),
+    m_engineIndexToLtpUdpEngineTransmitterPtr(new std::atomic<LtpUdpEngine*>[256]),
     m_nextEngineIndex(1),
     m_readyToForward(false)
 {
+    for (unsigned int i = 0; i < RECEIVER_HASH_TABLE_SIZE; ++i) {
+        m_receiverHashTable[i].remoteEngineId = 0;
+        m_receiverHashTable[i].ltpUdpEnginePtr.store(NULL, std::memory_order_relaxed);
+        m_receiverHashTable[i].inUse.store(false, std::memory_order_relaxed);
+    }
+    for (unsigned int i = 0; i < 256; ++i) {
+        m_engineIndexToLtpUdpEngineTransmitterPtr[i].store(NULL, std::memory_order_relaxed);
+    }
+#ifndef SO_REUSEPORT
+    if (numUdpRxSockets > 1) {
+        std::cout << "notice in LtpUdpEngineManager: SO_REUSEPORT is not supported on this platform.. using 1 receive socket on UDP port " << myBoundUdpPort << "\n";
+    }
+#endif
     if (autoStart) {
         StartIfNotAlreadyRunning(); //TODO EVALUATE IF AUTO START SAFE
     }
@@ -83,24 +115,113 @@ bool LtpUdpEngineManager::StartIfNotAlreadyRunning() {
         //Receiver UDP
         try {
             m_udpSocket.open(boost::asio::ip::udp::v4());
+#ifdef SO_REUSEPORT
+            if (M_NUM_UDP_RX_SOCKETS > 1) {
+                m_udpSocket.set_option(reuse_port_option_t(true));
+            }
+#endif
             m_udpSocket.bind(boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), M_MY_BOUND_UDP_PORT)); // //if udpPort is 0 then bind to random ephemeral port
+#ifdef SO_REUSEPORT
+            const uint16_t boundPort = m_udpSocket.local_endpoint().port();
+            for (unsigned int i = 1; i < M_NUM_UDP_RX_SOCKETS; ++i) {
+                m_additionalUdpRxSockets.emplace_back(boost::make_unique<additional_udp_rx_socket_t>(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES));
+                boost::asio::ip::udp::socket & rxSocket = m_additionalUdpRxSockets.back()->m_udpSocket;
+                rxSocket.open(boost::asio::ip::udp::v4());
+                rxSocket.set_option(reuse_port_option_t(true));
+                rxSocket.bind(boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), boundPort));
+            }
+#endif
         }
         catch (const boost::system::system_error & e) {
             std::cerr << "Could not bind on UDP port " << M_MY_BOUND_UDP_PORT << std::endl;
             std::cerr << "  Error: " << e.what() << std::endl;
-
+            m_additionalUdpRxSockets.clear();
+            boost::system::error_code ec;
+            m_udpSocket.close(ec);
             return false;
         }
-        printf("LtpUdpEngineManager bound successfully on UDP port %d\n", m_udpSocket.local_endpoint().port());
+        printf("LtpUdpEngineManager bound successfully on UDP port %d with %u receive socket(s)\n", m_udpSocket.local_endpoint().port(), M_NUM_UDP_RX_SOCKETS);
 
-        StartUdpReceive(); //call before creating io_service thread so that it has "work"
+        for (unsigned int i = 0; i < M_NUM_UDP_RX_SOCKETS; ++i) {
+            StartUdpReceive(i); //call before creating io_service threads so that they have "work"
+        }
 
         m_ioServiceUdpThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioServiceUdp));
+        for (std::size_t i = 0; i < m_additionalUdpRxSockets.size(); ++i) {
+            boost::asio::io_service & ioService = m_additionalUdpRxSockets[i]->m_ioService;
+            m_additionalUdpRxSockets[i]->m_ioServiceThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &ioService));
+        }
         m_readyToForward = true;
     }
     return true;
 }
 
+LtpUdpEngineManager::additional_udp_rx_socket_t::additional_udp_rx_socket_t(const uint64_t maxUdpRxPacketSizeBytes) :
+    m_udpSocket(m_ioService),
+    m_udpReceiveBuffer(maxUdpRxPacketSizeBytes) {}
+
+unsigned int LtpUdpEngineManager::GetNumUdpRxSockets() const {
+    return M_NUM_UDP_RX_SOCKETS;
+}
+
+bool LtpUdpEngineManager::InsertReceiverEngine(const uint64_t remoteEngineId, LtpUdpEngine * ltpUdpEnginePtr) {
+    unsigned int index = HashRemoteEngineId(remoteEngineId, RECEIVER_HASH_TABLE_SIZE_BITS);
+    for (unsigned int probe = 0; probe < RECEIVER_HASH_TABLE_SIZE; ++probe, index = (index + 1) & (RECEIVER_HASH_TABLE_SIZE - 1)) {
+        receiver_hash_table_slot_t & slot = m_receiverHashTable[index];
+        if (!slot.inUse.load(std::memory_order_relaxed)) {
+            slot.remoteEngineId = remoteEngineId;
+            slot.ltpUdpEnginePtr.store(ltpUdpEnginePtr, std::memory_order_relaxed);
+            slot.inUse.store(true, std::memory_order_release); //publishes the id and engine
+            return true;
+        }
+        if (slot.remoteEngineId == remoteEngineId) { //reuse the slot of a removed engine
+            slot.ltpUdpEnginePtr.store(ltpUdpEnginePtr, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+LtpUdpEngine * LtpUdpEngineManager::FindReceiverEngine(const uint64_t remoteEngineId) const {
+    unsigned int index = HashRemoteEngineId(remoteEngineId, RECEIVER_HASH_TABLE_SIZE_BITS);
+    for (unsigned int probe = 0; probe < RECEIVER_HASH_TABLE_SIZE; ++probe, index = (index + 1) & (RECEIVER_HASH_TABLE_SIZE - 1)) {
+        const receiver_hash_table_slot_t & slot = m_receiverHashTable[index];
+        if (!slot.inUse.load(std::memory_order_acquire)) {
+            return NULL;
+        }
+        if (slot.remoteEngineId == remoteEngineId) {
+            return slot.ltpUdpEnginePtr.load(std::memory_order_acquire);
+        }
+    }
+    return NULL;
+}
+
+//blocks until every additional receive thread has finished the handler it was running (if any),
+//after which none of them can still be using an engine that was removed from the routing tables before this call
+void LtpUdpEngineManager::WaitForAdditionalUdpRxThreadsToBeIdle() {
+    std::vector<boost::unique_future<void> > futures(m_additionalUdpRxSockets.size());
+    std::vector<boost::promise<void> > promises(m_additionalUdpRxSockets.size());
+    for (std::size_t i = 0; i < m_additionalUdpRxSockets.size(); ++i) {
+        additional_udp_rx_socket_t & rxSocket = *m_additionalUdpRxSockets[i];
+        if (rxSocket.m_ioServiceThreadPtr && (!rxSocket.m_ioService.stopped())) {
+            futures[i] = promises[i].get_future();
+            boost::asio::post(rxSocket.m_ioService, boost::bind(&boost::promise<void>::set_value, &promises[i]));
+        }
+    }
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+        if (!futures[i].valid()) {
+            continue;
+        }
+        //a thread that returned from run() (i.e. after a receive error) will never run the handler,
+        //and is no longer using any engine
+        while (!futures[i].timed_wait(boost::posix_time::milliseconds(100))) {
+            if (m_additionalUdpRxSockets[i]->m_ioService.stopped()) {
+                break;
+            }
+        }
+    }
+}
+
 LtpUdpEngine * LtpUdpEngineManager::GetLtpUdpEnginePtrByRemoteEngineId(const uint64_t remoteEngineId, const bool isInduct) {
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > * const whichMap = (isInduct) ? &m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr : &m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr;
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = whichMap->find(remoteEngineId);
@@ -118,6 +239,18 @@ void LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_NotThreadSafe(const
             << " for type " << ((isInduct) ? "induct" : "outduct") << " does not exist" << std::endl;
     }
     else {
+        //unpublish the engine from the routing tables, then wait for the other receive threads to let go of it before deleting it
+        if (isInduct) {
+            InsertReceiverEngine(remoteEngineId, NULL);
+        }
+        else {
+            for (unsigned int i = 0; i < 256; ++i) {
+                if (m_engineIndexToLtpUdpEngineTransmitterPtr[i].load(std::memory_order_relaxed) == it->second.get()) {
+                    m_engineIndexToLtpUdpEngineTransmitterPtr[i].store(NULL, std::memory_order_release);
+                }
+            }
+        }
+        WaitForAdditionalUdpRxThreadsToBeIdle();
         whichMap->erase(it);
         std::cout << "remoteEngineId " << remoteEngineId << " for type " << ((isInduct) ? "induct" : "outduct") << " successfully removed" << std::endl;
     }
@@ -162,10 +295,17 @@ bool LtpUdpEngineManager::AddLtpUdpEngine(const uint64_t thisEngineId, const uin
         m_udpSocket, thisEngineId, engineIndex, mtuClientServiceData, mtuReportSegment, oneWayLightTime, oneWayMarginTime,
         remoteEndpoint, numUdpRxCircularBufferVectors, ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, checkpointEveryNthDataPacketSender,
         maxRetriesPerSerialNumber, force32BitRandomNumbers, M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES, maxSendRateBitsPerSecOrZeroToDisable, maxSimultaneousSessions,
-        rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable);
-    if (!isInduct) {
+        rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable, M_NUM_UDP_RX_SOCKETS);
+    if (isInduct) {
+        if (!InsertReceiverEngine(remoteEngineId, newLtpUdpEnginePtr.get())) {
+            std::cerr << "error in LtpUdpEngineManager::AddLtpUdpEngine: a max of " << RECEIVER_HASH_TABLE_SIZE
+                << " remote engine Ids can be added for inducts with the same udp port\n";
+            return false;
+        }
+    }
+    else {
         ++m_nextEngineIndex;
-        m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex] = newLtpUdpEnginePtr.get();
+        m_engineIndexToLtpUdpEngineTransmitterPtr[engineIndex].store(newLtpUdpEnginePtr.get(), std::memory_order_release);
     }
     (*whichMap)[remoteEngineId] = std::move(newLtpUdpEnginePtr);
     
@@ -189,57 +329,69 @@ void LtpUdpEngineManager::Stop() {
 }
 
 
-void LtpUdpEngineManager::StartUdpReceive() {
-    m_udpSocket.async_receive_from(
-        boost::asio::buffer(m_udpReceiveBuffer),
-        m_remoteEndpointReceived,
-        boost::bind(&LtpUdpEngineManager::HandleUdpReceive, this,
-            boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
+void LtpUdpEngineManager::StartUdpReceive(const unsigned int rxSocketIndex) {
+    if (rxSocketIndex == 0) {
+        m_udpSocket.async_receive_from(
+            boost::asio::buffer(m_udpReceiveBuffer),
+            m_remoteEndpointReceived,
+            boost::bind(&LtpUdpEngineManager::HandleUdpReceive, this, 0u,
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+    }
+    else {
+        additional_udp_rx_socket_t & rxSocket = *m_additionalUdpRxSockets[rxSocketIndex - 1];
+        rxSocket.m_udpSocket.async_receive_from(
+            boost::asio::buffer(rxSocket.m_udpReceiveBuffer),
+            rxSocket.m_remoteEndpointReceived,
+            boost::bind(&LtpUdpEngineManager::HandleUdpReceive, this, rxSocketIndex,
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+    }
 }
 
-
-void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
+//runs on the thread of the receive socket rxSocketIndex (socket 0's thread is also the thread of all the engines' sends and of the add/remove operations)
+void LtpUdpEngineManager::HandleUdpReceive(const unsigned int rxSocketIndex, const boost::system::error_code & error, std::size_t bytesTransferred) {
+    std::vector<uint8_t> & udpReceiveBuffer = (rxSocketIndex == 0) ? m_udpReceiveBuffer : m_additionalUdpRxSockets[rxSocketIndex - 1]->m_udpReceiveBuffer;
     if (!error) {
         if (bytesTransferred <= 2) {
             std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): bytesTransferred <= 2 .. ignoring packet" << std::endl;
-            StartUdpReceive();
+            StartUdpReceive(rxSocketIndex);
             return;
         }
         
-        const uint8_t segmentTypeFlags = m_udpReceiveBuffer[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
+        const uint8_t segmentTypeFlags = udpReceiveBuffer[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
         bool isSenderToReceiver;
         if (!Ltp::GetMessageDirectionFromSegmentFlags(segmentTypeFlags, isSenderToReceiver)) {
             std::cerr << "critical error in LtpUdpEngine::HandleUdpReceive(): received invalid ltp packet with segment type flag " << (int)segmentTypeFlags << std::endl;
-            DoUdpShutdown();
+            DoUdpShutdownFromRxThread(rxSocketIndex);
             return;
         }
 #if defined(USE_SDNV_FAST) && defined(SDNV_SUPPORT_AVX2_FUNCTIONS)
         uint64_t decodedValues[2];
         const unsigned int numSdnvsToDecode = 2u - isSenderToReceiver;
         uint8_t totalBytesDecoded;
-        unsigned int numValsDecodedThisIteration = SdnvDecodeMultiple256BitU64Fast(&m_udpReceiveBuffer[1], &totalBytesDecoded, decodedValues, numSdnvsToDecode);
+        unsigned int numValsDecodedThisIteration = SdnvDecodeMultiple256BitU64Fast(&udpReceiveBuffer[1], &totalBytesDecoded, decodedValues, numSdnvsToDecode);
         if (numValsDecodedThisIteration != numSdnvsToDecode) { //all required sdnvs were not decoded, possibly due to a decode error
             std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read 1 or more of sessionOriginatorEngineId or sessionNumber.. ignoring packet" << std::endl;
-            StartUdpReceive();
+            StartUdpReceive(rxSocketIndex);
             return;
         }
         const uint64_t & sessionOriginatorEngineId = decodedValues[0];
         const uint64_t & sessionNumber = decodedValues[1];
 #else
         uint8_t sdnvSize;
-        const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&m_udpReceiveBuffer[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+        const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&udpReceiveBuffer[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
         if (sdnvSize == 0) {
             std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionOriginatorEngineId.. ignoring packet" << std::endl;
-            StartUdpReceive();
+            StartUdpReceive(rxSocketIndex);
             return;
         }
         uint64_t sessionNumber;
         if (!isSenderToReceiver) {
-            sessionNumber = SdnvDecodeU64(&m_udpReceiveBuffer[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+            sessionNumber = SdnvDecodeU64(&udpReceiveBuffer[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
             if (sdnvSize == 0) {
                 std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet" << std::endl;
-                StartUdpReceive();
+                StartUdpReceive(rxSocketIndex);
                 return;
             }
         }
@@ -248,47 +400,73 @@ void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & err
         LtpUdpEngine * ltpUdpEnginePtr;
         if (isSenderToReceiver) { //received an isSenderToReceiver message type => isInduct (this ltp engine received a message type that only travels from an outduct (sender) to an induct (receiver))
             //sessionOriginatorEngineId is the remote engine id in the case of an induct
-            std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.find(sessionOriginatorEngineId);
-            if (it == m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.end()) {
+            ltpUdpEnginePtr = FindReceiverEngine(sessionOriginatorEngineId);
+            if (ltpUdpEnginePtr == NULL) {
                 std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an induct received packet with unknown remote engine Id "
                     << sessionOriginatorEngineId << ".. ignoring packet" << std::endl;
-                StartUdpReceive();
+                StartUdpReceive(rxSocketIndex);
                 return;
             }
-            ltpUdpEnginePtr = it->second.get();
         }
         else { //received an isReceiverToSender message type => isOutduct (this ltp engine received a message type that only travels from an induct (receiver) to an outduct (sender))
             //sessionOriginatorEngineId is my engine id in the case of an outduct.. need to get the session number to find the proper LtpUdpEngine
             const uint8_t engineIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionNumber);
-            ltpUdpEnginePtr = m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex];
+            ltpUdpEnginePtr = m_engineIndexToLtpUdpEngineTransmitterPtr[engineIndex].load(std::memory_order_acquire);
             if (ltpUdpEnginePtr == NULL) {
                 std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an outduct received packet of type " << (int)segmentTypeFlags << " with unknown session number "
                     << sessionNumber << ".. ignoring packet" << std::endl;
-                StartUdpReceive();
+                StartUdpReceive(rxSocketIndex);
                 return;
             }
         }
         
-        ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(m_udpReceiveBuffer, bytesTransferred);
-        if (m_udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
+        ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(udpReceiveBuffer, bytesTransferred, rxSocketIndex);
+        if (udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
             std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: swapped packet not size " 
                 << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing" << std::endl;
-            m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+            udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
         }
-        StartUdpReceive(); //restart operation only if there was no error
+        StartUdpReceive(rxSocketIndex); //restart operation only if there was no error
     }
     else if (error != boost::asio::error::operation_aborted) {
         std::cerr << "critical error in LtpUdpEngine::HandleUdpReceive(): " << error.message() << std::endl;
-        DoUdpShutdown();
+        DoUdpShutdownFromRxThread(rxSocketIndex);
     }
 }
 
+void LtpUdpEngineManager::DoUdpShutdownFromRxThread(const unsigned int rxSocketIndex) {
+    if (rxSocketIndex == 0) {
+        DoUdpShutdown();
+    }
+    else { //the shutdown must run on socket 0's thread (which owns the engines)
+        CloseAdditionalUdpRxSocket(rxSocketIndex); //this thread's io_service runs out of work and stops
+        boost::asio::post(m_ioServiceUdp, boost::bind(&LtpUdpEngineManager::DoUdpShutdown, this));
+    }
+}
 
+void LtpUdpEngineManager::CloseAdditionalUdpRxSocket(const unsigned int rxSocketIndex) {
+    boost::asio::ip::udp::socket & udpSocket = m_additionalUdpRxSockets[rxSocketIndex - 1]->m_udpSocket;
+    if (udpSocket.is_open()) {
+        boost::system::error_code ec;
+        udpSocket.close(ec); //cancels the pending receive so that the thread's io_service runs out of work
+        if (ec) {
+            std::cout << "notice in LtpUdpEngineManager::CloseAdditionalUdpRxSocket: " << ec.message() << std::endl;
+        }
+    }
+}
 
 
 void LtpUdpEngineManager::DoUdpShutdown() {
     //final code to shut down tcp sockets
     m_readyToForward = false;
+    for (std::size_t i = 0; i < m_additionalUdpRxSockets.size(); ++i) {
+        additional_udp_rx_socket_t & rxSocket = *m_additionalUdpRxSockets[i];
+        if (rxSocket.m_ioServiceThreadPtr) {
+            boost::asio::post(rxSocket.m_ioService, boost::bind(&LtpUdpEngineManager::CloseAdditionalUdpRxSocket, this, static_cast<unsigned int>(i + 1)));
+            rxSocket.m_ioServiceThreadPtr->join();
+            rxSocket.m_ioServiceThreadPtr.reset(); //delete it
+        }
+    }
     if (m_udpSocket.is_open()) {
         try {
             std::cout << "closing LtpUdpEngine UDP socket.." << std::endl;
@@ -298,6 +476,12 @@ void LtpUdpEngineManager::DoUdpShutdown() {
             std::cout << "notice in LtpUdpEngine::DoUdpShutdown calling udpSocket.close: " << e.what() << std::endl;
         }
     }
+    for (unsigned int i = 0; i < RECEIVER_HASH_TABLE_SIZE; ++i) {
+        m_receiverHashTable[i].ltpUdpEnginePtr.store(NULL, std::memory_order_relaxed);
+    }
+    for (unsigned int i = 0; i < 256; ++i) {
+        m_engineIndexToLtpUdpEngineTransmitterPtr[i].store(NULL, std::memory_order_relaxed);
+    }
     m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.clear();
     m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.clear();
 }
@@ -1350,4 +1350,78 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
     t.DoCancelSegment();
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(LtpDataSegmentInPlaceTestCase)
+{
+    struct InPlaceReceiver {
+        std::vector<std::vector<uint8_t> > receivedData;
+        std::vector<const uint8_t *> receivedPointers;
+        void DataSegmentCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            BOOST_REQUIRE_EQUAL(sessionId, Ltp::session_id_t(5555, 6666));
+            receivedData.emplace_back(clientServiceData, clientServiceData + dataSegmentMetadata.length);
+            receivedPointers.push_back(clientServiceData);
+        }
+    };
+    InPlaceReceiver r;
+    Ltp ltp;
+    ltp.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&InPlaceReceiver::DataSegmentCallback, &r,
+        boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+        boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+
+    //two whole data segments back to back in one "packet"
+    const std::vector<uint8_t> data1 = { 'a', 'b', 'c', 'd' };
+    const std::vector<uint8_t> data2 = { 'e', 'f', 'g', 'h', 'i', 'j' };
+    std::vector<uint8_t> packet;
+    Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(packet, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA,
+        Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(1, 0, data1.size()), NULL, 0);
+    const std::size_t data1Offset = packet.size();
+    packet.insert(packet.end(), data1.begin(), data1.end());
+    std::vector<uint8_t> header2;
+    Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(header2, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA,
+        Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(1, data1.size(), data2.size()), NULL, 0);
+    packet.insert(packet.end(), header2.begin(), header2.end());
+    const std::size_t data2Offset = packet.size();
+    packet.insert(packet.end(), data2.begin(), data2.end());
+
+    std::string errorMessage;
+    BOOST_REQUIRE(ltp.HandleReceivedChars(packet.data(), packet.size(), errorMessage));
+    BOOST_REQUIRE(ltp.IsAtBeginningState());
+    BOOST_REQUIRE_EQUAL(r.receivedData.size(), 2);
+    BOOST_REQUIRE(r.receivedData[0] == data1);
+    BOOST_REQUIRE(r.receivedData[1] == data2);
+    //passed in place (not copied)
+    BOOST_REQUIRE(r.receivedPointers[0] == packet.data() + data1Offset);
+    BOOST_REQUIRE(r.receivedPointers[1] == packet.data() + data2Offset);
+
+    //the same packet fed one byte at a time falls back to copying
+    r.receivedData.clear();
+    r.receivedPointers.clear();
+    for (std::size_t i = 0; i < packet.size(); ++i) {
+        BOOST_REQUIRE(ltp.HandleReceivedChars(&packet[i], 1, errorMessage));
+    }
+    BOOST_REQUIRE(ltp.IsAtBeginningState());
+    BOOST_REQUIRE_EQUAL(r.receivedData.size(), 2);
+    BOOST_REQUIRE(r.receivedData[0] == data1);
+    BOOST_REQUIRE(r.receivedData[1] == data2);
+    BOOST_REQUIRE(r.receivedPointers[0] != packet.data() + data1Offset);
+
+    //trailer extensions fall back to copying
+    r.receivedData.clear();
+    Ltp::ltp_extensions_t trailerExtensions;
+    trailerExtensions.extensionsVec.resize(1);
+    trailerExtensions.extensionsVec[0].tag = 0x44;
+    trailerExtensions.extensionsVec[0].valueVec.assign(3, 'z');
+    packet.clear();
+    Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(packet, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA,
+        Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(1, 0, data1.size()), NULL, 1);
+    packet.insert(packet.end(), data1.begin(), data1.end());
+    trailerExtensions.AppendSerialize(packet);
+    BOOST_REQUIRE(ltp.HandleReceivedChars(packet.data(), packet.size(), errorMessage));
+    BOOST_REQUIRE(ltp.IsAtBeginningState());
+    BOOST_REQUIRE_EQUAL(r.receivedData.size(), 1);
+    BOOST_REQUIRE(r.receivedData[0] == data1);
+}
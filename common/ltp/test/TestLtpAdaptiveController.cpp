@@ -0,0 +1,142 @@
+/**
+ * @file TestLtpAdaptiveController.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "LtpAdaptiveController.h"
+
+static constexpr uint64_t MS = 1000000; //nanoseconds
+
+BOOST_AUTO_TEST_CASE(LtpAdaptiveControllerCheckpointTimeoutTestCase)
+{
+    LtpAdaptiveController c(1000000, 100000000, 1, 100, 10 * MS, 2000 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 2000 * MS); //no samples yet
+    BOOST_REQUIRE_EQUAL(c.GetSmoothedRoundTripTimeNanoseconds(), 0);
+
+    c.OnRoundTripTimeSample(100 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetSmoothedRoundTripTimeNanoseconds(), 100 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 300 * MS); //srtt + 4 * (rtt/2)
+
+    c.OnCheckpointTimerExpired(); //backoff doubles
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 600 * MS);
+    for (unsigned int i = 0; i < 10; ++i) {
+        c.OnCheckpointTimerExpired();
+    }
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 2000 * MS); //clamped to the configured 2*(owlt+margin)
+
+    c.OnRoundTripTimeSample(100 * MS); //a new sample clears the backoff
+    BOOST_REQUIRE_EQUAL(c.GetSmoothedRoundTripTimeNanoseconds(), 100 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 250 * MS); //rttvar = (3 * 50ms + 0) / 4
+
+    for (unsigned int i = 0; i < 100; ++i) {
+        c.OnRoundTripTimeSample(MS);
+    }
+    BOOST_REQUIRE_LT(c.GetSmoothedRoundTripTimeNanoseconds(), 2 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 10 * MS); //clamped to the min
+
+    c.Reset();
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointTimeoutNanoseconds(), 2000 * MS);
+}
+
+BOOST_AUTO_TEST_CASE(LtpAdaptiveControllerCheckpointIntervalTestCase)
+{
+    LtpAdaptiveController c(1000000, 100000000, 2, 100, 10 * MS, 2000 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 100);
+
+    for (unsigned int i = 0; i < 10; ++i) {
+        c.OnFirstPassReportClaims(1000, 1000); //no loss
+    }
+    BOOST_REQUIRE_EQUAL(c.GetLossRate(), 0);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 100);
+
+    for (unsigned int i = 0; i < 50; ++i) {
+        c.OnFirstPassReportClaims(1000, 900); //10% loss
+    }
+    BOOST_REQUIRE_CLOSE(c.GetLossRate(), 0.1, 1);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 10); //one expected loss per interval
+
+    c.OnFirstPassReportClaims(1000, 2000); //invalid claims ignored
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 10);
+
+    for (unsigned int i = 0; i < 50; ++i) {
+        c.OnFirstPassReportClaims(1000, 0); //total loss
+    }
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 2); //clamped to the min
+
+    c.Reset();
+    BOOST_REQUIRE_EQUAL(c.GetLossRate(), 0);
+    BOOST_REQUIRE_EQUAL(c.GetCheckpointEveryNthDataPacket(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(LtpAdaptiveControllerSendRateTestCase)
+{
+    static constexpr uint64_t BYTES_PER_100MS = 1250000; //100 Mbit/s
+    LtpAdaptiveController c(1000000, 1000000000, 1, 100, 10 * MS, 2000 * MS);
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 1000000000); //no samples yet
+    BOOST_REQUIRE(c.IsInStartup());
+
+    uint64_t now = 1000 * MS;
+    BOOST_REQUIRE(!c.OnBytesDelivered(now, 0)); //first report starts the first interval
+    BOOST_REQUIRE(!c.OnBytesDelivered(now + MS, BYTES_PER_100MS)); //interval too short for a sample
+    c.OnSendLimitedByRate();
+    now += 100 * MS;
+    BOOST_REQUIRE(c.OnBytesDelivered(now, 0));
+    BOOST_REQUIRE_EQUAL(c.GetBottleneckBandwidthBitsPerSec(), 100000000);
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 300000000); //startup gain
+    BOOST_REQUIRE(c.IsInStartup());
+
+    //bandwidth stops growing, so startup ends after 3 more samples and the queue is drained
+    for (unsigned int i = 0; i < 3; ++i) {
+        BOOST_REQUIRE(c.IsInStartup());
+        c.OnSendLimitedByRate();
+        now += 100 * MS;
+        c.OnBytesDelivered(now, BYTES_PER_100MS);
+    }
+    BOOST_REQUIRE(!c.IsInStartup());
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 75000000);
+
+    //probe bandwidth gain cycle
+    static const uint64_t EXPECTED_RATES[8] = { 100000000, 100000000, 100000000, 100000000, 100000000, 100000000, 125000000, 75000000 };
+    for (unsigned int i = 0; i < 8; ++i) {
+        c.OnSendLimitedByRate();
+        now += 100 * MS;
+        c.OnBytesDelivered(now, BYTES_PER_100MS);
+        BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), EXPECTED_RATES[i]);
+    }
+
+    //application limited (never held back by the rate limiter) samples don't lower the estimate
+    now += 100 * MS;
+    c.OnBytesDelivered(now, BYTES_PER_100MS / 2);
+    BOOST_REQUIRE_EQUAL(c.GetBottleneckBandwidthBitsPerSec(), 100000000);
+
+    //the max rate bounds the send rate
+    c.SetMaxSendRate(50000000);
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 50000000);
+
+    c.Reset();
+    BOOST_REQUIRE(c.IsInStartup());
+    BOOST_REQUIRE_EQUAL(c.GetBottleneckBandwidthBitsPerSec(), 0);
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 50000000);
+}
+
+BOOST_AUTO_TEST_CASE(LtpAdaptiveControllerStartupLossTestCase)
+{
+    LtpAdaptiveController c(1000000, 1000000000, 1, 100, 10 * MS, 2000 * MS);
+    uint64_t now = 1000 * MS;
+    c.OnBytesDelivered(now, 0);
+    c.OnFirstPassReportClaims(100000, 90000); //10% loss within the sample exits startup immediately
+    c.OnSendLimitedByRate();
+    now += 100 * MS;
+    BOOST_REQUIRE(c.OnBytesDelivered(now, 1250000));
+    BOOST_REQUIRE(!c.IsInStartup());
+    BOOST_REQUIRE_EQUAL(c.GetSendRateBitsPerSec(), 75000000);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file TestLtpBlockAggregator.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "LtpBlockAggregator.h"
+
+BOOST_AUTO_TEST_CASE(LtpBlockAggregatorTestCase)
+{
+    static const uint64_t SIZE_THRESHOLD = 1000;
+    LtpBlockAggregator aggregator(SIZE_THRESHOLD);
+    BOOST_REQUIRE(aggregator.IsEmpty());
+
+    //bundles of sizes 1, 100, 200, ... (sdnv lengths of 1 and 2 bytes)
+    std::vector<std::vector<uint8_t> > bundles;
+    bundles.push_back(std::vector<uint8_t>(1, 0));
+    for (unsigned int i = 1; i <= 3; ++i) {
+        bundles.push_back(std::vector<uint8_t>(i * 100, static_cast<uint8_t>(i)));
+    }
+    for (std::size_t i = 0; i < bundles.size(); ++i) {
+        BOOST_REQUIRE(!aggregator.AddBundle(bundles[i].data(), bundles[i].size()));
+    }
+    BOOST_REQUIRE(!aggregator.IsEmpty());
+    BOOST_REQUIRE_EQUAL(aggregator.GetNumBundles(), bundles.size());
+    BOOST_REQUIRE_EQUAL(aggregator.GetBlockSize(), (1 + 1) + (1 + 100) + (2 + 200) + (2 + 300)); //(sdnv length + bundle) under the threshold
+    bundles.push_back(std::vector<uint8_t>(400, 4));
+    BOOST_REQUIRE(aggregator.AddBundle(bundles.back().data(), bundles.back().size())); //threshold reached
+
+    std::vector<uint8_t> block;
+    BOOST_REQUIRE_EQUAL(aggregator.TakeBlock(block), bundles.size());
+    BOOST_REQUIRE(aggregator.IsEmpty());
+    BOOST_REQUIRE_EQUAL(aggregator.GetBlockSize(), 0);
+
+    std::vector<std::pair<const uint8_t *, std::size_t> > splitBundles;
+    BOOST_REQUIRE(LtpBlockAggregator::SplitBlock(block.data(), block.size(), splitBundles));
+    BOOST_REQUIRE_EQUAL(splitBundles.size(), bundles.size());
+    for (std::size_t i = 0; i < bundles.size(); ++i) {
+        BOOST_REQUIRE(std::vector<uint8_t>(splitBundles[i].first, splitBundles[i].first + splitBundles[i].second) == bundles[i]);
+    }
+
+    //the aggregator is reusable after TakeBlock
+    BOOST_REQUIRE(!aggregator.AddBundle(bundles[1].data(), bundles[1].size()));
+    BOOST_REQUIRE_EQUAL(aggregator.TakeBlock(block), 1);
+    splitBundles.clear();
+    BOOST_REQUIRE(LtpBlockAggregator::SplitBlock(block.data(), block.size(), splitBundles));
+    BOOST_REQUIRE_EQUAL(splitBundles.size(), 1);
+    BOOST_REQUIRE_EQUAL(splitBundles[0].second, bundles[1].size());
+
+    //malformed (truncated) block yields only the complete bundles
+    aggregator.AddBundle(bundles[1].data(), bundles[1].size());
+    aggregator.AddBundle(bundles[2].data(), bundles[2].size());
+    aggregator.TakeBlock(block);
+    splitBundles.clear();
+    BOOST_REQUIRE(!LtpBlockAggregator::SplitBlock(block.data(), block.size() - 1, splitBundles));
+    BOOST_REQUIRE_EQUAL(splitBundles.size(), 1);
+    //zero length bundles are invalid
+    const uint8_t zeroLengthBlock[2] = { 0, 0 };
+    splitBundles.clear();
+    BOOST_REQUIRE(!LtpBlockAggregator::SplitBlock(zeroLengthBlock, sizeof(zeroLengthBlock), splitBundles));
+    BOOST_REQUIRE(splitBundles.empty());
+}
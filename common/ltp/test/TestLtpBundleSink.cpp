@@ -0,0 +1,150 @@
+/**
+ * @file TestLtpBundleSink.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "LtpBundleSink.h"
+#include "LtpUdpEngineManager.h"
+#include "Ltp.h"
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+
+//drives an LtpBundleSink with forwardGreenOnlyBundles set using hand made data segments sent from a plain udp socket
+BOOST_AUTO_TEST_CASE(LtpBundleSinkForwardGreenOnlyBundlesTestCase)
+{
+    static const uint64_t ENGINE_ID_SRC = 100;
+    static const uint64_t ENGINE_ID_DEST = 200;
+    static const uint16_t SINK_UDP_PORT = 4581;
+    static const uint16_t UNUSED_REPORT_UDP_PORT = 4582;
+    static const uint64_t MAX_SIMULTANEOUS_SESSIONS = 4;
+
+    struct Test {
+        boost::mutex m_mutex;
+        std::vector<padded_vector_uint8_t> m_receivedBundles;
+        boost::asio::io_service m_ioService;
+        boost::asio::ip::udp::socket m_udpSocket;
+        boost::asio::ip::udp::endpoint m_sinkEndpoint;
+
+        Test() : m_udpSocket(m_ioService), m_sinkEndpoint(boost::asio::ip::address_v4::loopback(), SINK_UDP_PORT) {
+            m_udpSocket.open(boost::asio::ip::udp::v4());
+        }
+        void WholeBundleReady(padded_vector_uint8_t & wholeBundleVec) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_receivedBundles.push_back(std::move(wholeBundleVec));
+        }
+        std::size_t NumReceived() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_receivedBundles.size();
+        }
+        bool WaitForNumReceived(const std::size_t num) {
+            for (unsigned int i = 0; i < 200; ++i) {
+                if (NumReceived() >= num) {
+                    return true;
+                }
+                boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            }
+            return false;
+        }
+        void SendSegment(const LTP_DATA_SEGMENT_TYPE_FLAGS flags, const uint64_t sessionNumber, const std::vector<uint8_t> & block,
+            const uint64_t offset, const uint64_t length)
+        {
+            std::vector<uint8_t> packet;
+            uint64_t checkpointSerialNumber = 1;
+            uint64_t reportSerialNumber = 0;
+            const bool isCheckpoint = (flags == LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART);
+            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(packet, flags, Ltp::session_id_t(ENGINE_ID_SRC, sessionNumber),
+                Ltp::data_segment_metadata_t(1, offset, length, (isCheckpoint) ? &checkpointSerialNumber : NULL, (isCheckpoint) ? &reportSerialNumber : NULL), NULL, 0);
+            packet.insert(packet.end(), block.begin() + offset, block.begin() + offset + length);
+            m_udpSocket.send_to(boost::asio::buffer(packet), m_sinkEndpoint);
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+        //sends block in 3 green segments, leaving out the last one if !finish
+        void SendGreenBlock(const uint64_t sessionNumber, const std::vector<uint8_t> & block, const bool start, const bool finish) {
+            const uint64_t third = block.size() / 3;
+            if (start) {
+                SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA, sessionNumber, block, 0, third);
+                SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA, sessionNumber, block, third, third);
+            }
+            if (finish) {
+                SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA_ENDOFBLOCK, sessionNumber, block, 2 * third, block.size() - (2 * third));
+            }
+        }
+        static std::vector<uint8_t> MakeBlock(const uint8_t seed, const std::size_t size) {
+            std::vector<uint8_t> block(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                block[i] = static_cast<uint8_t>(seed + (i * 7));
+            }
+            return block;
+        }
+        bool ReceivedEquals(const std::size_t index, const std::vector<uint8_t> & block) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return (m_receivedBundles.size() > index) && (m_receivedBundles[index].size() == block.size())
+                && std::equal(block.begin(), block.end(), m_receivedBundles[index].begin());
+        }
+    };
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX);
+    Test t;
+    {
+        LtpBundleSink sink(boost::bind(&Test::WholeBundleReady, &t, boost::placeholders::_1),
+            ENGINE_ID_DEST, ENGINE_ID_SRC, UINT64_MAX, boost::posix_time::milliseconds(10), boost::posix_time::milliseconds(10),
+            SINK_UDP_PORT, 100, 10000, 5, false, "localhost", UNUSED_REPORT_UDP_PORT, 10000000, MAX_SIMULTANEOUS_SESSIONS, 0,
+            0, "", 1, true);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+        //multi segment green block is reassembled
+        const std::vector<uint8_t> block1 = Test::MakeBlock(1, 3000);
+        t.SendGreenBlock(1, block1, true, true);
+        BOOST_REQUIRE(t.WaitForNumReceived(1));
+        BOOST_REQUIRE(t.ReceivedEquals(0, block1));
+
+        //single segment green block
+        const std::vector<uint8_t> block2 = Test::MakeBlock(2, 500);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA_ENDOFBLOCK, 2, block2, 0, block2.size());
+        BOOST_REQUIRE(t.WaitForNumReceived(2));
+        BOOST_REQUIRE(t.ReceivedEquals(1, block2));
+
+        //a live block is not evicted by many more blocks that complete while it is being reassembled
+        const std::vector<uint8_t> longLivedBlock = Test::MakeBlock(3, 3000);
+        t.SendGreenBlock(3, longLivedBlock, true, false);
+        std::vector<std::vector<uint8_t> > shortLivedBlocks;
+        for (uint64_t i = 0; i < (MAX_SIMULTANEOUS_SESSIONS * 3); ++i) {
+            shortLivedBlocks.push_back(Test::MakeBlock(static_cast<uint8_t>(10 + i), 1500));
+            t.SendGreenBlock(10 + i, shortLivedBlocks.back(), true, true);
+        }
+        t.SendGreenBlock(3, longLivedBlock, false, true);
+        BOOST_REQUIRE(t.WaitForNumReceived(2 + shortLivedBlocks.size() + 1));
+        for (std::size_t i = 0; i < shortLivedBlocks.size(); ++i) {
+            BOOST_REQUIRE(t.ReceivedEquals(2 + i, shortLivedBlocks[i]));
+        }
+        BOOST_REQUIRE(t.ReceivedEquals(2 + shortLivedBlocks.size(), longLivedBlock));
+
+        //the green part of a block with a red part is never delivered as a bundle of its own (only the red part is)
+        const std::size_t numReceivedBeforeMixed = t.NumReceived();
+        const std::vector<uint8_t> mixedBlock = Test::MakeBlock(4, 2000);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART, 4, mixedBlock, 0, 1000);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA, 4, mixedBlock, 1000, 500);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA_ENDOFBLOCK, 4, mixedBlock, 1500, 500);
+        BOOST_REQUIRE(t.WaitForNumReceived(numReceivedBeforeMixed + 1));
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        BOOST_REQUIRE_EQUAL(t.NumReceived(), numReceivedBeforeMixed + 1);
+        BOOST_REQUIRE(t.ReceivedEquals(numReceivedBeforeMixed, std::vector<uint8_t>(mixedBlock.begin(), mixedBlock.begin() + 1000)));
+
+        //an incomplete green block (middle segment lost) is discarded
+        const std::vector<uint8_t> lossyBlock = Test::MakeBlock(5, 3000);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA, 5, lossyBlock, 0, 1000);
+        t.SendSegment(LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA_ENDOFBLOCK, 5, lossyBlock, 2000, 1000);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        BOOST_REQUIRE_EQUAL(t.NumReceived(), numReceivedBeforeMixed + 1);
+    }
+}
@@ -15,6 +15,7 @@
 #include <boost/test/unit_test.hpp>
 #include "LtpEngine.h"
 #include <boost/bind/bind.hpp>
+#include "MetricsRegistry.h"
 
 BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
 {
@@ -32,6 +33,7 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
         const std::string DESIRED_FULLY_GREEN_DATA_TO_SEND;
 
         uint64_t numRedPartReceptionCallbacks;
+        uint64_t numRedPartFileReceptionCallbacks;
         uint64_t numSessionStartSenderCallbacks;
         uint64_t numSessionStartReceiverCallbacks;
         uint64_t numGreenPartReceptionCallbacks;
@@ -61,6 +63,8 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             engineDest.SetSessionStartCallback(boost::bind(&Test::SessionStartReceiverCallback, this, boost::placeholders::_1));
             engineDest.SetRedPartReceptionCallback(boost::bind(&Test::RedPartReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
                 boost::placeholders::_4, boost::placeholders::_5));
+            engineDest.SetRedPartFileReceptionCallback(boost::bind(&Test::RedPartFileReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5));
             engineDest.SetGreenPartSegmentArrivalCallback(boost::bind(&Test::GreenPartSegmentArrivalCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
                 boost::placeholders::_4, boost::placeholders::_5));
 
@@ -87,6 +91,16 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             //std::cout << "receivedMessage: " << receivedMessage << std::endl;
             //std::cout << "here\n";
         }
+        void RedPartFileReceptionCallback(const Ltp::session_id_t & sessionId, std::unique_ptr<LtpRedPartFile> & movableRedPartFilePtr, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock) {
+            std::string receivedMessage(movableRedPartFilePtr->RedPartData(), movableRedPartFilePtr->RedPartData() + lengthOfRedPart);
+            ++numRedPartFileReceptionCallbacks;
+            BOOST_REQUIRE_EQUAL(receivedMessage, DESIRED_RED_DATA_TO_SEND);
+            BOOST_REQUIRE(sessionId == sessionIdFromSessionStartSender);
+            const boost::filesystem::path filePath = movableRedPartFilePtr->GetFilePath();
+            BOOST_REQUIRE(boost::filesystem::exists(filePath));
+            movableRedPartFilePtr.reset(); //take ownership and delete
+            BOOST_REQUIRE(!boost::filesystem::exists(filePath));
+        }
         void GreenPartSegmentArrivalCallback(const Ltp::session_id_t & sessionId, std::vector<uint8_t> & movableClientServiceDataVec, uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock) {
             ++numGreenPartReceptionCallbacks;
             BOOST_REQUIRE_EQUAL(movableClientServiceDataVec.size(), 1);
@@ -142,6 +156,7 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             numSrcToDestDataExchanged = 0;
             numDestToSrcDataExchanged = 0;
             numRedPartReceptionCallbacks = 0;
+            numRedPartFileReceptionCallbacks = 0;
             numSessionStartSenderCallbacks = 0;
             numSessionStartReceiverCallbacks = 0;
             numGreenPartReceptionCallbacks = 0;
@@ -195,6 +210,28 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 0);
         }
 
+        void DoTestRedPartSpilledToDisk() {
+            Reset();
+            engineDest.SetRxSpillToDisk(10, ""); //spill once more than 10 bytes of red data have been received
+            AssertNoActiveSendersAndReceivers();
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            AssertOneActiveSenderOnly();
+            unsigned int numDroppedSrcToDest = 0;
+            while (ExchangeData((numSrcToDestDataExchanged == 20) && (numDroppedSrcToDest++ == 0))) { //drop one segment after the spill to test retransmission into the file
+
+            }
+            AssertNoActiveSendersAndReceivers();
+            engineDest.SetRxSpillToDisk(0, "");
+
+            BOOST_REQUIRE_EQUAL(numRedPartReceptionCallbacks, 0);
+            BOOST_REQUIRE_EQUAL(numRedPartFileReceptionCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numSessionStartSenderCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numSessionStartReceiverCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numReceptionSessionCancelledCallbacks, 0);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCompletedCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 0);
+        }
+
         void DoTestOneDropSrcToDest() {
             Reset();
             AssertNoActiveSendersAndReceivers();
@@ -431,6 +468,61 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 1);
             BOOST_REQUIRE(lastTxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
         }
+
+        void DoTestMemoryBudget() {
+            MetricGauge & memoryInUseGauge = MetricsRegistry::GetInstance().GetOrCreateGauge("ltp.memoryInUseBytes");
+            const int64_t memoryInUseGaugeStart = memoryInUseGauge.Get();
+
+            //transmission request refused (44 bytes exceeds the 30 byte sender share of a 40 byte budget)
+            Reset();
+            engineSrc.SetMemoryBudget(40);
+            BOOST_REQUIRE(!engineSrc.TransmissionRequestFitsWithinMemoryBudget(DESIRED_RED_DATA_TO_SEND.size()));
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            AssertNoActiveSendersAndReceivers();
+            BOOST_REQUIRE_EQUAL(engineSrc.GetMemoryInUseBytes(), 0);
+            BOOST_REQUIRE_EQUAL(numSessionStartSenderCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 1);
+            BOOST_REQUIRE(lastTxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
+            BOOST_REQUIRE(!ExchangeData()); //nothing sent
+            BOOST_REQUIRE_EQUAL(engineSrc.m_numTransmissionRequestsRefusedByMemoryBudget, 1);
+
+            //admitted within a larger budget, and everything is released once the session completes
+            Reset();
+            engineSrc.SetMemoryBudget(100);
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            AssertOneActiveSenderOnly();
+            BOOST_REQUIRE_EQUAL(engineSrc.GetMemoryInUseBytes(), DESIRED_RED_DATA_TO_SEND.size());
+            BOOST_REQUIRE_EQUAL(memoryInUseGauge.Get() - memoryInUseGaugeStart, static_cast<int64_t>(DESIRED_RED_DATA_TO_SEND.size()));
+            while (ExchangeData()) {
+
+            }
+            AssertNoActiveSendersAndReceivers();
+            BOOST_REQUIRE_EQUAL(engineSrc.GetMemoryInUseBytes(), 0);
+            BOOST_REQUIRE_EQUAL(engineDest.GetMemoryInUseBytes(), 0);
+            BOOST_REQUIRE_EQUAL(numRedPartReceptionCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCompletedCallbacks, 1);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 0);
+            engineSrc.SetMemoryBudget(0);
+
+            //the receiver's red part buffer outgrows a 20 byte budget, so the receiving session is evicted (and the sender cancelled)
+            Reset();
+            engineDest.SetMemoryBudget(20);
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            while (ExchangeData()) {
+
+            }
+            AssertNoActiveSendersAndReceivers();
+            BOOST_REQUIRE_EQUAL(engineSrc.GetMemoryInUseBytes(), 0);
+            BOOST_REQUIRE_EQUAL(engineDest.GetMemoryInUseBytes(), 0);
+            BOOST_REQUIRE_EQUAL(engineDest.m_numSessionsEvictedByMemoryBudget, 1);
+            BOOST_REQUIRE_EQUAL(numRedPartReceptionCallbacks, 0);
+            BOOST_REQUIRE_EQUAL(numReceptionSessionCancelledCallbacks, 1);
+            BOOST_REQUIRE(lastRxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 1);
+            BOOST_REQUIRE(lastTxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
+            engineDest.SetMemoryBudget(0);
+            BOOST_REQUIRE_EQUAL(memoryInUseGauge.Get(), memoryInUseGaugeStart);
+        }
     };
 
     Test t;
@@ -445,4 +537,6 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
     t.DoTestMiscoloredRed();
     t.DoTestMiscoloredGreen();
     t.DoTestTooMuchRedData();
+    t.DoTestRedPartSpilledToDisk();
+    t.DoTestMemoryBudget();
 }
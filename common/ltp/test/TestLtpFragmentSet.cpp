@@ -14,7 +14,12 @@
 
 #include <boost/test/unit_test.hpp>
 #include "LtpFragmentSet.h"
+#include "LtpFragmentIntervalSet.h"
 #include <boost/bind/bind.hpp>
+#include <boost/timer/timer.hpp>
+#include <random>
+#include <algorithm>
+#include <iostream>
 
 BOOST_AUTO_TEST_CASE(LtpFragmentSetTestCase)
 {
@@ -604,3 +609,144 @@ BOOST_AUTO_TEST_CASE(LtpFragmentSetTestCase)
         }
     }
 }
+
+static uint64_t GetNumBytes(const std::set<LtpFragmentSet::data_fragment_t> & fragmentSet) {
+    uint64_t numBytes = 0;
+    for (std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = fragmentSet.cbegin(); it != fragmentSet.cend(); ++it) {
+        numBytes += (it->endIndex - it->beginIndex) + 1;
+    }
+    return numBytes;
+}
+
+BOOST_AUTO_TEST_CASE(LtpFragmentIntervalSetTestCase)
+{
+    //the interval set must behave exactly like the std::set based FragmentSet/LtpFragmentSet functions it replaces
+    typedef LtpFragmentSet::data_fragment_t df;
+    typedef Ltp::report_segment_t rs;
+    typedef Ltp::reception_claim_t rc;
+    std::mt19937_64 rng(12345);
+
+    for (unsigned int trial = 0; trial < 200; ++trial) {
+        std::set<df> fragmentSet;
+        LtpFragmentIntervalSet intervalSet;
+        //enough fragments to span several chunks, with occasional large fragments that merge across chunks
+        const uint64_t blockSize = 1 + (rng() % 20000);
+        const unsigned int numInserts = 1 + (rng() % 1000);
+        for (unsigned int i = 0; i < numInserts; ++i) {
+            const uint64_t beginIndex = rng() % blockSize;
+            const uint64_t endIndex = std::min(beginIndex + (rng() % (((rng() % 20) == 0) ? 3000 : 20)), blockSize - 1);
+            LtpFragmentSet::InsertFragment(fragmentSet, df(beginIndex, endIndex));
+            intervalSet.InsertFragment(df(beginIndex, endIndex));
+            BOOST_REQUIRE(intervalSet == fragmentSet);
+            BOOST_REQUIRE_EQUAL(intervalSet.GetNumBytes(), GetNumBytes(fragmentSet));
+        }
+        for (unsigned int i = 0; i < 50; ++i) {
+            const uint64_t beginIndex = rng() % blockSize;
+            const df key(beginIndex, std::min(beginIndex + (rng() % 20), blockSize - 1));
+            BOOST_REQUIRE_EQUAL(intervalSet.ContainsFragmentEntirely(key), LtpFragmentSet::ContainsFragmentEntirely(fragmentSet, key));
+        }
+
+        //report segments (auto bounds and random bounds)
+        for (unsigned int i = 0; i < 20; ++i) {
+            uint64_t lowerBound = UINT64_MAX;
+            uint64_t upperBound = UINT64_MAX;
+            if (i) {
+                lowerBound = rng() % blockSize;
+                upperBound = lowerBound + 1 + (rng() % blockSize);
+            }
+            rs reportSegmentFromSet;
+            rs reportSegmentFromIntervalSet;
+            const bool retSet = LtpFragmentSet::PopulateReportSegment(fragmentSet, reportSegmentFromSet, lowerBound, upperBound);
+            BOOST_REQUIRE_EQUAL(intervalSet.PopulateReportSegment(reportSegmentFromIntervalSet, lowerBound, upperBound), retSet);
+            if (!retSet) {
+                continue;
+            }
+            BOOST_REQUIRE(reportSegmentFromSet == reportSegmentFromIntervalSet);
+
+            //sender side of the same report segment
+            std::set<df> needingResentSet;
+            LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentSet, reportSegmentFromSet);
+            std::vector<df> needingResentVec;
+            LtpFragmentIntervalSet::GetFragmentsNeedingResent(reportSegmentFromSet, needingResentVec);
+            BOOST_REQUIRE(needingResentVec == std::vector<df>(needingResentSet.cbegin(), needingResentSet.cend()));
+
+            std::set<df> ackedSet;
+            LtpFragmentIntervalSet ackedIntervalSet;
+            const uint64_t preAckedBegin = rng() % blockSize;
+            LtpFragmentSet::InsertFragment(ackedSet, df(preAckedBegin, preAckedBegin + 5));
+            ackedIntervalSet.InsertFragment(df(preAckedBegin, preAckedBegin + 5));
+            LtpFragmentSet::AddReportSegmentToFragmentSet(ackedSet, reportSegmentFromSet);
+            ackedIntervalSet.AddReportSegment(reportSegmentFromSet);
+            BOOST_REQUIRE(ackedIntervalSet == ackedSet);
+            BOOST_REQUIRE_EQUAL(ackedIntervalSet.GetNumBytes(), GetNumBytes(ackedSet));
+        }
+    }
+
+    //merge path of AddReportSegment (many claims into a small set)
+    {
+        LtpFragmentIntervalSet acked;
+        acked.InsertFragment(df(0, 9));
+        acked.InsertFragment(df(100, 109));
+        acked.AddReportSegment(rs(0, 0, 200, 0, std::vector<rc>({ rc(5, 10), rc(20, 10), rc(40, 10), rc(60, 10), rc(95, 5), rc(120, 10) })));
+        std::set<df> expected = { df(0, 14), df(20, 29), df(40, 49), df(60, 69), df(95, 109), df(120, 129) };
+        BOOST_REQUIRE(acked == expected);
+        BOOST_REQUIRE_EQUAL(acked.GetNumBytes(), GetNumBytes(expected));
+        BOOST_REQUIRE(!acked.ContainsPrefix(130));
+        acked.AddReportSegment(rs(0, 0, 200, 0, std::vector<rc>({ rc(0, 200) })));
+        BOOST_REQUIRE_EQUAL(acked.size(), 1);
+        BOOST_REQUIRE_EQUAL(acked.GetNumBytes(), 200);
+        BOOST_REQUIRE(acked.ContainsPrefix(200));
+        BOOST_REQUIRE(!acked.ContainsPrefix(201));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LtpFragmentIntervalSetSpeedTestCase, *boost::unit_test::disabled())
+{
+    //a 500MB red part in 1360 byte segments with 20% loss, received in order then retransmitted,
+    //with a report segment generated every 100 segments
+    typedef LtpFragmentSet::data_fragment_t df;
+    static const uint64_t SEGMENT_SIZE = 1360;
+    static const uint64_t NUM_SEGMENTS = (500000000 / SEGMENT_SIZE);
+    std::vector<uint64_t> segmentOrder;
+    segmentOrder.reserve(NUM_SEGMENTS);
+    std::vector<uint64_t> lostSegments;
+    std::mt19937_64 rng(1);
+    for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+        ((rng() % 100) < 20) ? lostSegments.push_back(i) : segmentOrder.push_back(i);
+    }
+    segmentOrder.insert(segmentOrder.end(), lostSegments.begin(), lostSegments.end());
+
+    std::size_t numClaimsSet = 0;
+    std::size_t numClaimsIntervalSet = 0;
+    {
+        boost::timer::cpu_timer timer;
+        std::set<df> fragmentSet;
+        Ltp::report_segment_t reportSegment;
+        for (std::size_t i = 0; i < segmentOrder.size(); ++i) {
+            const uint64_t offset = segmentOrder[i] * SEGMENT_SIZE;
+            LtpFragmentSet::InsertFragment(fragmentSet, df(offset, (offset + SEGMENT_SIZE) - 1));
+            if ((i % 100) == 99) {
+                LtpFragmentSet::PopulateReportSegment(fragmentSet, reportSegment, 0, offset + SEGMENT_SIZE);
+                numClaimsSet += reportSegment.receptionClaims.size();
+            }
+        }
+        BOOST_REQUIRE_EQUAL(fragmentSet.size(), 1);
+        std::cout << "std::set<data_fragment_t>: " << timer.format() << std::endl;
+    }
+    {
+        boost::timer::cpu_timer timer;
+        LtpFragmentIntervalSet intervalSet;
+        Ltp::report_segment_t reportSegment;
+        for (std::size_t i = 0; i < segmentOrder.size(); ++i) {
+            const uint64_t offset = segmentOrder[i] * SEGMENT_SIZE;
+            intervalSet.InsertFragment(df(offset, (offset + SEGMENT_SIZE) - 1));
+            if ((i % 100) == 99) {
+                intervalSet.PopulateReportSegment(reportSegment, 0, offset + SEGMENT_SIZE);
+                numClaimsIntervalSet += reportSegment.receptionClaims.size();
+            }
+        }
+        BOOST_REQUIRE(intervalSet.ContainsPrefix(NUM_SEGMENTS * SEGMENT_SIZE));
+        std::cout << "LtpFragmentIntervalSet: " << timer.format() << std::endl;
+    }
+    BOOST_REQUIRE_EQUAL(numClaimsSet, numClaimsIntervalSet);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file TestLtpGreenSegmentRing.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include "LtpGreenSegmentRing.h"
+#include "LtpUdpEngineManager.h"
+#include <string>
+#include <algorithm>
+
+BOOST_AUTO_TEST_CASE(LtpGreenSegmentRingTestCase)
+{
+    LtpGreenSegmentRing ring(4, 10);
+    const Ltp::session_id_t sessionId(1, 2);
+    const std::string data("0123456789abc");
+    BOOST_REQUIRE(ring.TryGetNextSegment() == NULL);
+    for (unsigned int i = 0; i < 3; ++i) { //ring of 4 holds 3
+        BOOST_REQUIRE(ring.PushSegment(sessionId, (const uint8_t *)data.data() + i, 5, i * 5, 1, (i == 2)));
+    }
+    BOOST_REQUIRE(!ring.PushSegment(sessionId, (const uint8_t *)data.data(), 5, 15, 1, false)); //full
+    BOOST_REQUIRE_EQUAL(ring.GetNumSegmentsDropped(), 1);
+    for (unsigned int i = 0; i < 3; ++i) {
+        const LtpGreenSegmentRing::green_segment_t * segment = ring.TryGetNextSegment();
+        BOOST_REQUIRE(segment != NULL);
+        BOOST_REQUIRE(segment->sessionId == sessionId);
+        BOOST_REQUIRE_EQUAL(segment->offsetStartOfBlock, i * 5);
+        BOOST_REQUIRE_EQUAL(segment->clientServiceId, 1);
+        BOOST_REQUIRE_EQUAL(segment->isEndOfBlock, (i == 2));
+        BOOST_REQUIRE_EQUAL(std::string(segment->data.begin(), segment->data.end()), data.substr(i, 5));
+        ring.ReleaseSegment();
+    }
+    BOOST_REQUIRE(ring.TryGetNextSegment() == NULL);
+    BOOST_REQUIRE(!ring.PushSegment(sessionId, (const uint8_t *)data.data(), 11, 0, 1, true)); //larger than a slot
+    BOOST_REQUIRE_EQUAL(ring.GetNumSegmentsDropped(), 2);
+    ring.StopWaiting();
+    BOOST_REQUIRE(ring.WaitForNextSegment() == NULL);
+}
+
+static void ConsumeGreenSegmentsThreadFunc(LtpGreenSegmentRing * ring, std::string * receivedData, unsigned int * numEndOfBlocks) {
+    while (const LtpGreenSegmentRing::green_segment_t * segment = ring->WaitForNextSegment()) {
+        if (receivedData->size() < (segment->offsetStartOfBlock + segment->data.size())) {
+            receivedData->resize(segment->offsetStartOfBlock + segment->data.size());
+        }
+        std::copy(segment->data.begin(), segment->data.end(), receivedData->begin() + segment->offsetStartOfBlock);
+        *numEndOfBlocks += segment->isEndOfBlock;
+        ring->ReleaseSegment();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LtpGreenSegmentRingStreamingTestCase)
+{
+    //a fully green block sent 1 byte per segment is streamed to a consumer thread as the segments arrive
+    static const uint64_t ENGINE_ID_SRC = 120;
+    static const uint64_t ENGINE_ID_DEST = 220;
+    static const uint16_t BOUND_UDP_PORT_SRC = 12360;
+    static const uint16_t BOUND_UDP_PORT_DEST = 1115;
+    const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME(boost::posix_time::milliseconds(250));
+    const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(250));
+    const std::string DESIRED_GREEN_DATA_TO_SEND("The quick brown fox jumps over the lazy dog!");
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX);
+    std::shared_ptr<LtpUdpEngineManager> ltpUdpEngineManagerSrcPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_SRC, true);
+    std::shared_ptr<LtpUdpEngineManager> ltpUdpEngineManagerDestPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_DEST, true);
+    BOOST_REQUIRE(ltpUdpEngineManagerDestPtr->AddLtpUdpEngine(ENGINE_ID_DEST, ENGINE_ID_SRC, true, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+        "localhost", BOUND_UDP_PORT_SRC, 100, 0, 10000000, 0, 5, false, 0, 5, 1000));
+    BOOST_REQUIRE(ltpUdpEngineManagerSrcPtr->AddLtpUdpEngine(ENGINE_ID_SRC, ENGINE_ID_DEST, false, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, //1 => 1 byte per segment
+        "localhost", BOUND_UDP_PORT_DEST, 100, 0, 0, 0, 5, false, 0, 5, 0));
+    LtpUdpEngine * ltpUdpEngineSrcPtr = ltpUdpEngineManagerSrcPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false);
+    LtpUdpEngine * ltpUdpEngineDestPtr = ltpUdpEngineManagerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_SRC, true);
+
+    LtpGreenSegmentRing ring(100, 1500);
+    ltpUdpEngineDestPtr->SetGreenPartSegmentArrivalZeroCopyCallback(ring.GetProducerCallback());
+    std::string receivedData;
+    unsigned int numEndOfBlocks = 0;
+    boost::thread consumerThread(boost::bind(&ConsumeGreenSegmentsThreadFunc, &ring, &receivedData, &numEndOfBlocks));
+
+    boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+    tReq->destinationClientServiceId = 300;
+    tReq->destinationLtpEngineId = ENGINE_ID_DEST;
+    tReq->clientServiceDataToSend = std::vector<uint8_t>(DESIRED_GREEN_DATA_TO_SEND.data(), DESIRED_GREEN_DATA_TO_SEND.data() + DESIRED_GREEN_DATA_TO_SEND.size()); //copy
+    tReq->lengthOfRedPart = 0;
+    ltpUdpEngineSrcPtr->TransmissionRequest_ThreadSafe(std::move(tReq));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    for (unsigned int attempt = 0; attempt < 20; ++attempt) {
+        if ((ltpUdpEngineDestPtr->NumActiveReceivers() == 0) && (ltpUdpEngineSrcPtr->NumActiveSenders() == 0)) {
+            break;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    ring.StopWaiting();
+    consumerThread.join();
+    BOOST_REQUIRE_EQUAL(ring.GetNumSegmentsDropped(), 0);
+    BOOST_REQUIRE_EQUAL(numEndOfBlocks, 1);
+    BOOST_REQUIRE_EQUAL(receivedData, DESIRED_GREEN_DATA_TO_SEND);
+
+    ltpUdpEngineDestPtr->SetGreenPartSegmentArrivalZeroCopyCallback(GreenPartSegmentArrivalZeroCopyCallback_t());
+    ltpUdpEngineManagerDestPtr->RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(ENGINE_ID_SRC, true, boost::function<void()>());
+    ltpUdpEngineManagerSrcPtr->RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(ENGINE_ID_DEST, false, boost::function<void()>());
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+}
@@ -0,0 +1,75 @@
+/**
+ * @file TestLtpHeaderBufferPool.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "LtpHeaderBufferPool.h"
+#include "Ltp.h"
+#include <set>
+
+BOOST_AUTO_TEST_CASE(LtpHeaderBufferPoolTestCase)
+{
+    static const unsigned int NUM_SLOTS = 4;
+    LtpHeaderBufferPool pool(NUM_SLOTS);
+    BOOST_REQUIRE_EQUAL(pool.NumSlotsInUse(), 0);
+
+    std::vector<uint8_t*> slots;
+    std::set<uint8_t*> uniqueSlots;
+    for (unsigned int i = 0; i < NUM_SLOTS; ++i) {
+        uint8_t * slot = pool.Acquire();
+        BOOST_REQUIRE(slot != NULL);
+        BOOST_REQUIRE(pool.IsFromPool(slot));
+        BOOST_REQUIRE(pool.IsFromPool(slot + (LtpHeaderBufferPool::SLOT_SIZE_BYTES - 1)));
+        slots.push_back(slot);
+        uniqueSlots.insert(slot);
+    }
+    BOOST_REQUIRE_EQUAL(uniqueSlots.size(), NUM_SLOTS);
+    BOOST_REQUIRE_EQUAL(pool.NumSlotsInUse(), NUM_SLOTS);
+
+    //exhausted
+    BOOST_REQUIRE(pool.Acquire() == NULL);
+    BOOST_REQUIRE_EQUAL(pool.m_numAcquires, NUM_SLOTS);
+    BOOST_REQUIRE_EQUAL(pool.m_numAcquireFailures, 1);
+
+    //pointers not from the pool are ignored
+    uint8_t notFromPool[LtpHeaderBufferPool::SLOT_SIZE_BYTES];
+    BOOST_REQUIRE(!pool.IsFromPool(notFromPool));
+    BOOST_REQUIRE(!pool.Release(notFromPool));
+    BOOST_REQUIRE(!pool.Release(NULL));
+    BOOST_REQUIRE_EQUAL(pool.NumSlotsInUse(), NUM_SLOTS);
+
+    //out of order release, the freed slot is the only one that can be reacquired
+    BOOST_REQUIRE(pool.Release(slots[2]));
+    BOOST_REQUIRE_EQUAL(pool.NumSlotsInUse(), NUM_SLOTS - 1);
+    BOOST_REQUIRE(pool.Acquire() == slots[2]);
+    BOOST_REQUIRE(pool.Acquire() == NULL);
+
+    for (unsigned int i = 0; i < NUM_SLOTS; ++i) {
+        BOOST_REQUIRE(pool.Release(slots[i]));
+    }
+    BOOST_REQUIRE_EQUAL(pool.NumSlotsInUse(), 0);
+
+    //a max sized data segment header (all 10-byte sdnvs) fits in a slot and serializes identically to the vector version
+    Ltp::session_id_t sessionId(UINT64_MAX, UINT64_MAX);
+    uint64_t checkpointSerialNumber = UINT64_MAX;
+    uint64_t reportSerialNumber = UINT64_MAX;
+    Ltp::data_segment_metadata_t meta(UINT64_MAX, UINT64_MAX, UINT64_MAX, &checkpointSerialNumber, &reportSerialNumber);
+    std::vector<uint8_t> headerVec;
+    Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(headerVec, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART_ENDOFBLOCK, sessionId, meta, NULL, 0);
+    uint8_t * slot = pool.Acquire();
+    BOOST_REQUIRE(slot != NULL);
+    const uint64_t headerSize = Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(slot, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART_ENDOFBLOCK, sessionId, meta, NULL, 0);
+    BOOST_REQUIRE_LE(headerSize, static_cast<uint64_t>(LtpHeaderBufferPool::SLOT_SIZE_BYTES));
+    BOOST_REQUIRE_EQUAL(headerSize, headerVec.size());
+    BOOST_REQUIRE(std::vector<uint8_t>(slot, slot + headerSize) == headerVec);
+    BOOST_REQUIRE(pool.Release(slot));
+}
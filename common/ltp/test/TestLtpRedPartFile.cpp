@@ -0,0 +1,51 @@
+/**
+ * @file TestLtpRedPartFile.cpp
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "LtpRedPartFile.h"
+#include <cstring>
+
+BOOST_AUTO_TEST_CASE(LtpRedPartFileTestCase)
+{
+    boost::filesystem::path filePath;
+    {
+        LtpRedPartFile redPartFile;
+        BOOST_REQUIRE(redPartFile.Create("", 1000));
+        filePath = redPartFile.GetFilePath();
+        BOOST_REQUIRE(boost::filesystem::exists(filePath));
+        BOOST_REQUIRE_EQUAL(redPartFile.GetRedPartCapacity(), 1000);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 1000 + LtpRedPartFile::TOTAL_PADDING_BYTES);
+        BOOST_REQUIRE(redPartFile.RedPartData() == (redPartFile.PaddedData() + LtpRedPartFile::PADDING_BYTES_BEFORE));
+        for (unsigned int i = 0; i < 1000; ++i) {
+            redPartFile.RedPartData()[i] = static_cast<uint8_t>(i);
+        }
+
+        //growing keeps the data already written
+        BOOST_REQUIRE(redPartFile.Grow(100000));
+        BOOST_REQUIRE_EQUAL(redPartFile.GetRedPartCapacity(), 100000);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 100000 + LtpRedPartFile::TOTAL_PADDING_BYTES);
+        for (unsigned int i = 0; i < 1000; ++i) {
+            BOOST_REQUIRE_EQUAL(redPartFile.RedPartData()[i], static_cast<uint8_t>(i));
+        }
+        std::memset(redPartFile.RedPartData() + 1000, 0xff, 99000);
+        BOOST_REQUIRE_EQUAL(redPartFile.RedPartData()[99999], 0xff);
+    }
+    //deleted on destruction
+    BOOST_REQUIRE(!boost::filesystem::exists(filePath));
+
+    //a directory that doesn't exist fails
+    {
+        LtpRedPartFile redPartFile;
+        BOOST_REQUIRE(!redPartFile.Create(boost::filesystem::temp_directory_path() / "ltp_red_part_file_nonexistent_directory", 1000));
+    }
+}
@@ -14,6 +14,8 @@
 
 #include <boost/test/unit_test.hpp>
 #include "LtpSessionRecreationPreventer.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <vector>
 
 BOOST_AUTO_TEST_CASE(LtpSessionRecreationPreventerTestCase)
 {
@@ -46,8 +48,27 @@ BOOST_AUTO_TEST_CASE(LtpSessionRecreationPreventerTestCase)
             BOOST_REQUIRE(srp.ContainsSession(i));
             BOOST_REQUIRE(!srp.AddSession(i));
         }
-        
+        BOOST_REQUIRE_EQUAL(srp.GetNumInsertionFailures(), 0);
+    }
+    //large history with random session numbers, then measure the false positive rate of a short fingerprint
+    {
+        const uint64_t maxSessions = 1000000;
+        LtpSessionRecreationPreventer srp(maxSessions, 16);
+        boost::random::mt19937_64 gen(12345);
+        std::vector<uint64_t> sessions(maxSessions);
+        for (uint64_t i = 0; i < maxSessions; ++i) {
+            sessions[i] = gen();
+            BOOST_REQUIRE(srp.AddSession(sessions[i]) || srp.ContainsSession(sessions[i])); //false positive allowed
+        }
+        for (uint64_t i = 0; i < maxSessions; ++i) {
+            BOOST_REQUIRE(srp.ContainsSession(sessions[i])); //no false negatives
+        }
+        BOOST_REQUIRE_EQUAL(srp.GetNumInsertionFailures(), 0);
+        uint64_t numFalsePositives = 0;
+        static const uint64_t NUM_LOOKUPS = 1000000;
+        for (uint64_t i = 0; i < NUM_LOOKUPS; ++i) {
+            numFalsePositives += srp.ContainsSession(gen());
+        }
+        BOOST_REQUIRE_LE(numFalsePositives, (NUM_LOOKUPS * 8) >> 16); //bounded by 8 / 2^fingerprintBits
     }
-
-   
 }
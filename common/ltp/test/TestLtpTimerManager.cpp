@@ -136,6 +136,23 @@ BOOST_AUTO_TEST_CASE(LtpTimerManagerTestCase)
             BOOST_REQUIRE_EQUAL(m_numCallbacks, 2);
             BOOST_REQUIRE(m_serialNumbersInCallback == std::vector<uint64_t>({ 5,15 }));
         }
+        void DoTest5() { //a shorter timeout started later expires first
+            m_testNumber = 1;// 1 is valid
+            m_timerManager.Reset();
+            m_ioService.stop();
+            m_ioService.reset();
+            m_numCallbacks = 0;
+            m_serialNumbersInCallback.clear();
+            BOOST_REQUIRE(m_timerManager.StartTimer(5));
+            BOOST_REQUIRE(m_timerManager.StartTimer(10));
+            m_timerManager.SetTransmissionToAckReceivedTime(boost::posix_time::milliseconds(50));
+            BOOST_REQUIRE(m_timerManager.StartTimer(15));
+            m_timerManager.SetTransmissionToAckReceivedTime((ONE_WAY_LIGHT_TIME * 2) + (ONE_WAY_MARGIN_TIME * 2));
+            m_ioService.run();
+
+            BOOST_REQUIRE_EQUAL(m_numCallbacks, 3);
+            BOOST_REQUIRE(m_serialNumbersInCallback == std::vector<uint64_t>({ 15,5,10 }));
+        }
     };
     
     Test t;
@@ -143,6 +160,7 @@ BOOST_AUTO_TEST_CASE(LtpTimerManagerTestCase)
     t.DoTest2();
     t.DoTest3();
     t.DoTest4();
+    t.DoTest5();
 
     
 
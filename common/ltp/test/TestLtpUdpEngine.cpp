@@ -15,6 +15,7 @@
 #include <boost/test/unit_test.hpp>
 #include "LtpUdpEngineManager.h"
 #include <boost/bind/bind.hpp>
+#include <atomic>
 
 BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
 {
@@ -1056,3 +1057,105 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
     t.DoTestSenderCancelSession();
     t.DoTestDropOddDataSegmentWithRsMtu();
 }
+
+BOOST_AUTO_TEST_CASE(LtpUdpEngineMultipleRxSocketsTestCase)
+{
+    //several remote engines send to one induct port that has multiple SO_REUSEPORT receive sockets
+    static const unsigned int NUM_SRC_ENGINES = 4;
+    static const unsigned int NUM_RX_SOCKETS = 4;
+    static const unsigned int NUM_BLOCKS_PER_SRC_ENGINE = 10;
+    static const uint64_t ENGINE_ID_DEST = 210;
+    static const uint64_t CLIENT_SERVICE_ID_DEST = 300;
+    static const uint16_t BOUND_UDP_PORT_DEST = 1114;
+    const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME(boost::posix_time::milliseconds(250));
+    const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(250));
+    const std::string DESIRED_RED_DATA_TO_SEND("The quick brown fox jumps over the lazy dog!");
+
+    struct Counters {
+        Counters() : numRedPartsReceived(0), numRedPartsReceivedWithErrors(0), numTransmissionSessionsCompleted(0), numRemoveCallbacks(0) {}
+        void RedPartReceptionCallback(const std::string * expected, const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec,
+            uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)
+        {
+            const std::string receivedMessage(movableClientServiceDataVec.data(), movableClientServiceDataVec.data() + movableClientServiceDataVec.size());
+            if (receivedMessage == *expected) {
+                ++numRedPartsReceived;
+            }
+            else {
+                ++numRedPartsReceivedWithErrors;
+            }
+        }
+        void TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr) {
+            ++numTransmissionSessionsCompleted;
+        }
+        void RemoveCallback() {
+            ++numRemoveCallbacks;
+        }
+        std::atomic<unsigned int> numRedPartsReceived;
+        std::atomic<unsigned int> numRedPartsReceivedWithErrors;
+        std::atomic<unsigned int> numTransmissionSessionsCompleted;
+        std::atomic<unsigned int> numRemoveCallbacks;
+    };
+    Counters counters;
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX);
+    std::shared_ptr<LtpUdpEngineManager> ltpUdpEngineManagerDestPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_DEST, true, NUM_RX_SOCKETS);
+#ifdef SO_REUSEPORT
+    BOOST_REQUIRE_EQUAL(ltpUdpEngineManagerDestPtr->GetNumUdpRxSockets(), NUM_RX_SOCKETS);
+#endif
+    std::vector<std::shared_ptr<LtpUdpEngineManager> > ltpUdpEngineManagerSrcPtrs;
+    std::vector<LtpUdpEngine*> ltpUdpEngineSrcPtrs;
+    for (unsigned int i = 0; i < NUM_SRC_ENGINES; ++i) {
+        const uint64_t engineIdSrc = 110 + i;
+        const uint16_t boundUdpPortSrc = static_cast<uint16_t>(12350 + i);
+        BOOST_REQUIRE(ltpUdpEngineManagerDestPtr->AddLtpUdpEngine(ENGINE_ID_DEST, engineIdSrc, true, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+            "localhost", boundUdpPortSrc, 100, 0, 10000000, 0, 5, false, 0, 5, 1000));
+        LtpUdpEngine * ltpUdpEngineDestPtr = ltpUdpEngineManagerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(engineIdSrc, true);
+        BOOST_REQUIRE(ltpUdpEngineDestPtr != NULL);
+        ltpUdpEngineDestPtr->SetRedPartReceptionCallback(boost::bind(&Counters::RedPartReceptionCallback, &counters, &DESIRED_RED_DATA_TO_SEND, boost::placeholders::_1,
+            boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5));
+
+        ltpUdpEngineManagerSrcPtrs.push_back(LtpUdpEngineManager::GetOrCreateInstance(boundUdpPortSrc, true));
+        BOOST_REQUIRE(ltpUdpEngineManagerSrcPtrs.back()->AddLtpUdpEngine(engineIdSrc, ENGINE_ID_DEST, false, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+            "localhost", BOUND_UDP_PORT_DEST, 100, 0, 0, 0, 5, false, 0, 5, 0));
+        ltpUdpEngineSrcPtrs.push_back(ltpUdpEngineManagerSrcPtrs.back()->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false));
+        ltpUdpEngineSrcPtrs.back()->SetTransmissionSessionCompletedCallback(boost::bind(&Counters::TransmissionSessionCompletedCallback, &counters,
+            boost::placeholders::_1, boost::placeholders::_2));
+    }
+
+    for (unsigned int block = 0; block < NUM_BLOCKS_PER_SRC_ENGINE; ++block) {
+        for (unsigned int i = 0; i < NUM_SRC_ENGINES; ++i) {
+            boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+            tReq->destinationClientServiceId = CLIENT_SERVICE_ID_DEST;
+            tReq->destinationLtpEngineId = ENGINE_ID_DEST;
+            tReq->clientServiceDataToSend = std::vector<uint8_t>(DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.data() + DESIRED_RED_DATA_TO_SEND.size()); //copy
+            tReq->lengthOfRedPart = DESIRED_RED_DATA_TO_SEND.size();
+            ltpUdpEngineSrcPtrs[i]->TransmissionRequest_ThreadSafe(std::move(tReq));
+        }
+    }
+    static const unsigned int NUM_BLOCKS_TOTAL = NUM_SRC_ENGINES * NUM_BLOCKS_PER_SRC_ENGINE;
+    for (unsigned int attempt = 0; attempt < 50; ++attempt) {
+        if ((counters.numRedPartsReceived == NUM_BLOCKS_TOTAL) && (counters.numTransmissionSessionsCompleted == NUM_BLOCKS_TOTAL)) {
+            break;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+    BOOST_REQUIRE_EQUAL(counters.numRedPartsReceived, NUM_BLOCKS_TOTAL);
+    BOOST_REQUIRE_EQUAL(counters.numRedPartsReceivedWithErrors, 0);
+    BOOST_REQUIRE_EQUAL(counters.numTransmissionSessionsCompleted, NUM_BLOCKS_TOTAL);
+
+    //remove the inducts while the other receive sockets are still running
+    for (unsigned int i = 0; i < NUM_SRC_ENGINES; ++i) {
+        ltpUdpEngineManagerDestPtr->RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(110 + i, true, boost::bind(&Counters::RemoveCallback, &counters));
+        ltpUdpEngineManagerSrcPtrs[i]->RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(ENGINE_ID_DEST, false, boost::bind(&Counters::RemoveCallback, &counters));
+    }
+    for (unsigned int attempt = 0; attempt < 20; ++attempt) {
+        if (counters.numRemoveCallbacks == (2 * NUM_SRC_ENGINES)) {
+            break;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+    BOOST_REQUIRE_EQUAL(counters.numRemoveCallbacks, 2 * NUM_SRC_ENGINES);
+    for (unsigned int i = 0; i < NUM_SRC_ENGINES; ++i) {
+        BOOST_REQUIRE(ltpUdpEngineManagerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(110 + i, true) == NULL);
+    }
+}
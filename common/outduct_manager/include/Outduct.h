@@ -47,6 +47,7 @@ public:
     OUTDUCT_MANAGER_LIB_EXPORT uint64_t GetOutductUuid() const;
     OUTDUCT_MANAGER_LIB_EXPORT uint64_t GetOutductMaxBundlesInPipeline() const;
     OUTDUCT_MANAGER_LIB_EXPORT std::string GetConvergenceLayerName() const;
+    OUTDUCT_MANAGER_LIB_EXPORT uint64_t GetBpv7FragmentationMaxBundleSizeBytes() const; //0 if disabled
 
 protected:
     const outduct_element_config_t m_outductConfig;
@@ -10,7 +10,11 @@ LtpOverUdpOutduct::LtpOverUdpOutduct(const outduct_element_config_t & outductCon
         boost::posix_time::milliseconds(outductConfig.oneWayLightTimeMs), boost::posix_time::milliseconds(outductConfig.oneWayMarginTimeMs),
         outductConfig.ltpSenderBoundPort, outductConfig.numRxCircularBufferElements,
         outductConfig.ltpCheckpointEveryNthDataSegment, outductConfig.ltpMaxRetriesPerSerialNumber, (outductConfig.ltpRandomNumberSizeBits == 32),
-        m_outductConfig.remoteHostname, m_outductConfig.remotePort, m_outductConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable, m_outductConfig.bundlePipelineLimit)
+        m_outductConfig.remoteHostname, m_outductConfig.remotePort, m_outductConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable, m_outductConfig.bundlePipelineLimit,
+        m_outductConfig.ltpAggregationSizeThresholdBytesOrZeroToDisable, m_outductConfig.ltpAggregationTimeThresholdMilliseconds,
+        m_outductConfig.ltpAdaptiveMinSendRateBitsPerSecOrZeroToDisable, m_outductConfig.ltpAdaptiveMinCheckpointEveryNthDataSegment,
+        m_outductConfig.ltpAdaptiveMaxCheckpointEveryNthDataSegment, m_outductConfig.ltpAdaptiveMinCheckpointTimeoutMs,
+        m_outductConfig.ltpMemoryBudgetBytesOrZeroToDisable)
 {}
 LtpOverUdpOutduct::~LtpOverUdpOutduct() {}
 
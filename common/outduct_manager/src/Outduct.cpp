@@ -19,3 +19,6 @@ uint64_t Outduct::GetOutductMaxBundlesInPipeline() const {
 std::string Outduct::GetConvergenceLayerName() const {
     return m_outductConfig.convergenceLayer;
 }
+uint64_t Outduct::GetBpv7FragmentationMaxBundleSizeBytes() const {
+    return m_outductConfig.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable;
+}
@@ -27,6 +27,7 @@ TcpclV4Outduct::TcpclV4Outduct(const outduct_element_config_t & outductConfig, c
         outductConfig.keepAliveIntervalSeconds, myNodeId, outductConfig.nextHopEndpointId,
         outductConfig.bundlePipelineLimit + 5, outductConfig.tcpclV4MyMaxRxSegmentSizeBytes, maxOpportunisticRxBundleSizeBytes, outductOpportunisticProcessReceivedBundleCallback)
 {
+    m_tcpclV4BundleSource.SetReactiveFragmentationEnabled(outductConfig.tcpclV4ReactiveFragmentation);
 #ifdef OPENSSL_SUPPORT_ENABLED
     if (outductConfig.tryUseTls) {
 #if (BOOST_VERSION < 106900)
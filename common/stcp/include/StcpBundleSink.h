@@ -17,6 +17,11 @@
  * to receive bundles (or any other user defined data) over an STCP link
  * and calls the user defined function WholeBundleReadyCallback_t when a new bundle
  * is received.
+ * The TCP stream is read with read_some into one large buffer and parsed in place, so that many
+ * length-prefixed bundles are extracted per system call.  Bundles are copied out of that buffer into
+ * circular buffer slots (a bundle spanning reads is copied piecewise into its preallocated slot),
+ * except that the remainder of a large bundle is read directly into its slot.  Completed bundles
+ * are committed to the consumer thread once per read.
  * This class is implemented based on the ION.pdf V4.0.1 sections STCPCLI and STCPCLO.
  */
 
@@ -28,6 +33,7 @@
 #include <boost/thread.hpp>
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <atomic>
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "PaddedVectorUint8.h"
 #include "stcp_lib_export.h"
@@ -50,8 +56,13 @@ public:
 private:
 
     STCP_LIB_NO_EXPORT void TryStartTcpReceive();
-    STCP_LIB_NO_EXPORT void HandleTcpReceiveIncomingBundleSize(const boost::system::error_code & error, std::size_t bytesTransferred, const unsigned int writeIndex);
-    STCP_LIB_NO_EXPORT void HandleTcpReceiveBundleData(const boost::system::error_code & error, std::size_t bytesTransferred, unsigned int writeIndex);
+    STCP_LIB_NO_EXPORT bool ParseReadSomeBuffer();
+    STCP_LIB_NO_EXPORT bool TryGetWriteIndexForIncomingBundle();
+    STCP_LIB_NO_EXPORT void CommitCompletedBundles();
+    STCP_LIB_NO_EXPORT void OnIncomingBundleComplete();
+    STCP_LIB_NO_EXPORT void HandleTcpReceiveSome(const boost::system::error_code & error, std::size_t bytesTransferred);
+    STCP_LIB_NO_EXPORT void HandleTcpReceiveBundleData(const boost::system::error_code & error, std::size_t bytesTransferred);
+    STCP_LIB_NO_EXPORT void HandleTcpReceiveError(const boost::system::error_code & error);
     STCP_LIB_NO_EXPORT void PopCbThreadFunc();
     STCP_LIB_NO_EXPORT void DoStcpShutdown();
     STCP_LIB_NO_EXPORT void HandleSocketShutdown();
@@ -66,14 +77,29 @@ private:
     const uint64_t M_MAX_BUNDLE_SIZE_BYTES;
     CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
     std::vector<padded_vector_uint8_t > m_tcpReceiveBuffersCbVec;
-    std::vector<std::size_t> m_tcpReceiveBytesTransferredCbVec;
-    boost::condition_variable m_conditionVariableCb;
     std::unique_ptr<boost::thread> m_threadCbReaderPtr;
     bool m_stateTcpReadActive;
     bool m_printedCbTooSmallNotice;
     volatile bool m_running;
     volatile bool m_safeToDelete;
+    std::atomic<bool> m_waitingForCbSpace; //set by the io service thread when paused, cleared by whichever thread resumes
+
+    //read_some buffer, fully parsed before the next read is started
+    std::vector<uint8_t> m_tcpReadSomeBufferVec;
+    std::size_t m_readSomeBufferParseIndex;
+    std::size_t m_readSomeBufferEndIndex;
+
+    //incoming bundle state (the 4 byte length field may also span reads)
     uint32_t m_incomingBundleSize;
+    unsigned int m_incomingBundleSizeNumBytesReceived;
+    uint32_t m_incomingBundleNumBytesReceived;
+    bool m_incomingBundleHasWriteIndex;
+
+    //circular buffer slots owned by the io service thread: a contiguous run starting at m_writeIndex,
+    //of which the first m_numWritesToCommit hold completed bundles not yet visible to the consumer
+    unsigned int m_writeIndex;
+    unsigned int m_numContiguousWritesAvailable;
+    unsigned int m_numWritesToCommit;
 };
 
 
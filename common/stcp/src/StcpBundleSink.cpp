@@ -19,6 +19,10 @@
 #include <boost/endian/conversion.hpp>
 #include <boost/make_unique.hpp>
 
+//the remainder of a bundle at least this large is read directly into its circular buffer slot rather than through the read_some buffer
+static const std::size_t READ_SOME_BUFFER_SIZE_BYTES = 1000000;
+static const std::size_t MIN_BYTES_TO_READ_DIRECTLY_INTO_SLOT = 65536;
+
 StcpBundleSink::StcpBundleSink(boost::shared_ptr<boost::asio::ip::tcp::socket> tcpSocketPtr,
     boost::asio::io_service & tcpSocketIoServiceRef,
     const WholeBundleReadyCallback_t & wholeBundleReadyCallback,
@@ -32,13 +36,23 @@ StcpBundleSink::StcpBundleSink(boost::shared_ptr<boost::asio::ip::tcp::socket> t
     m_tcpSocketIoServiceRef(tcpSocketIoServiceRef),
     M_NUM_CIRCULAR_BUFFER_VECTORS(numCircularBufferVectors),
     M_MAX_BUNDLE_SIZE_BYTES(maxBundleSizeBytes),
-    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS, true), //blocking wait for PopCbThreadFunc
     m_tcpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_tcpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_stateTcpReadActive(false),
     m_printedCbTooSmallNotice(false),
     m_running(false),
-    m_safeToDelete(false)
+    m_safeToDelete(false),
+    m_waitingForCbSpace(false),
+    m_tcpReadSomeBufferVec(READ_SOME_BUFFER_SIZE_BYTES),
+    m_readSomeBufferParseIndex(0),
+    m_readSomeBufferEndIndex(0),
+    m_incomingBundleSize(0),
+    m_incomingBundleSizeNumBytesReceived(0),
+    m_incomingBundleNumBytesReceived(0),
+    m_incomingBundleHasWriteIndex(false),
+    m_writeIndex(0),
+    m_numContiguousWritesAvailable(0),
+    m_numWritesToCommit(0)
 {
     std::cout << "stcp sink using CB size: " << M_NUM_CIRCULAR_BUFFER_VECTORS << std::endl;
     m_running = true;
@@ -59,6 +73,7 @@ StcpBundleSink::~StcpBundleSink() {
     
     
     m_running = false; //thread stopping criteria
+    m_circularIndexBuffer.StopWaiting(); //wake PopCbThreadFunc
 
     if (m_threadCbReaderPtr) {
         m_threadCbReaderPtr->join();
@@ -66,91 +81,158 @@ StcpBundleSink::~StcpBundleSink() {
     }
 }
 
-//Note: the tcp layer will control flow in the event that the source is faster than the sink
+//called by the io service thread (or posted by PopCbThreadFunc once it frees a slot after a pause)
 void StcpBundleSink::TryStartTcpReceive() {
     if ((!m_stateTcpReadActive) && (m_tcpSocketPtr)) {
-
-        const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
-        if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
-            if (!m_printedCbTooSmallNotice) {
-                m_printedCbTooSmallNotice = true;
-                std::cout << "notice in StcpBundleSink::TryStartTcpReceive(): buffers full.. you might want to increase the circular buffer size!" << std::endl; 
-            }
+        if (!ParseReadSomeBuffer()) { //paused until PopCbThreadFunc frees a slot, or shut down
+            return;
         }
-        else {
-            //StartTcpReceiveIncomingBundleSize
-            m_stateTcpReadActive = true;
+        //the read_some buffer is now fully parsed
+        m_stateTcpReadActive = true;
+        const uint32_t incomingBundleBytesRemaining = m_incomingBundleSize - m_incomingBundleNumBytesReceived;
+        if (m_incomingBundleHasWriteIndex && (incomingBundleBytesRemaining >= MIN_BYTES_TO_READ_DIRECTLY_INTO_SLOT)) {
+            padded_vector_uint8_t & incomingBundle = m_tcpReceiveBuffersCbVec[m_writeIndex + m_numWritesToCommit];
             boost::asio::async_read(*m_tcpSocketPtr,
-                boost::asio::buffer(&m_incomingBundleSize, sizeof(m_incomingBundleSize)),
-                boost::bind(&StcpBundleSink::HandleTcpReceiveIncomingBundleSize, this,
+                boost::asio::buffer(incomingBundle.data() + m_incomingBundleNumBytesReceived, incomingBundleBytesRemaining),
+                boost::bind(&StcpBundleSink::HandleTcpReceiveBundleData, this,
                     boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred,
-                    writeIndex));
-            
+                    boost::asio::placeholders::bytes_transferred));
+        }
+        else {
+            m_tcpSocketPtr->async_read_some(
+                boost::asio::buffer(m_tcpReadSomeBufferVec),
+                boost::bind(&StcpBundleSink::HandleTcpReceiveSome, this,
+                    boost::asio::placeholders::error,
+                    boost::asio::placeholders::bytes_transferred));
         }
     }
 }
 
-
-void StcpBundleSink::HandleTcpReceiveIncomingBundleSize(const boost::system::error_code & error, std::size_t bytesTransferred, const unsigned int writeIndex) {
-    if (!error) {
-        if (m_incomingBundleSize == 0) { //keepalive (0 is endian agnostic)
-            std::cout << "notice: keepalive packet received" << std::endl;
-            //StartTcpReceiveIncomingBundleSize
-            boost::asio::async_read(*m_tcpSocketPtr,
-                boost::asio::buffer(&m_incomingBundleSize, sizeof(m_incomingBundleSize)),
-                boost::bind(&StcpBundleSink::HandleTcpReceiveIncomingBundleSize, this,
-                    boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred,
-                    writeIndex));
+bool StcpBundleSink::TryGetWriteIndexForIncomingBundle() {
+    if (m_numWritesToCommit == m_numContiguousWritesAvailable) { //contiguous run used up
+        CommitCompletedBundles();
+        m_writeIndex = m_circularIndexBuffer.GetContiguousIndicesForWrite(m_numContiguousWritesAvailable);
+        if (m_writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+            m_waitingForCbSpace = true;
+            //try again in case PopCbThreadFunc freed a slot before it could see m_waitingForCbSpace
+            //(if it did see it, the resulting TryStartTcpReceive is harmless)
+            m_writeIndex = m_circularIndexBuffer.GetContiguousIndicesForWrite(m_numContiguousWritesAvailable);
+            if (m_writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+                m_numContiguousWritesAvailable = 0;
+                if (!m_printedCbTooSmallNotice) {
+                    m_printedCbTooSmallNotice = true;
+                    std::cout << "notice in StcpBundleSink::TryStartTcpReceive(): buffers full.. you might want to increase the circular buffer size!" << std::endl;
+                }
+                return false;
+            }
+            m_waitingForCbSpace = false;
         }
-        else {
+    }
+    m_incomingBundleHasWriteIndex = true;
+    m_tcpReceiveBuffersCbVec[m_writeIndex + m_numWritesToCommit].resize(m_incomingBundleSize);
+    return true;
+}
+
+void StcpBundleSink::CommitCompletedBundles() {
+    if (m_numWritesToCommit) {
+        m_circularIndexBuffer.CommitWrites(m_numWritesToCommit); //one consumer wakeup for all bundles completed by this read
+        m_writeIndex += m_numWritesToCommit;
+        m_numContiguousWritesAvailable -= m_numWritesToCommit;
+        m_numWritesToCommit = 0;
+    }
+}
+
+void StcpBundleSink::OnIncomingBundleComplete() {
+    ++m_numWritesToCommit;
+    m_incomingBundleHasWriteIndex = false;
+    m_incomingBundleSizeNumBytesReceived = 0;
+    m_incomingBundleNumBytesReceived = 0;
+}
+
+//returns false if parsing must pause because the circular buffer is full or the connection is being shut down
+bool StcpBundleSink::ParseReadSomeBuffer() {
+    while (true) {
+        if (m_incomingBundleSizeNumBytesReceived < sizeof(m_incomingBundleSize)) {
+            if (m_readSomeBufferParseIndex == m_readSomeBufferEndIndex) {
+                break;
+            }
+            const std::size_t numBytesToCopy = std::min(sizeof(m_incomingBundleSize) - m_incomingBundleSizeNumBytesReceived, m_readSomeBufferEndIndex - m_readSomeBufferParseIndex);
+            memcpy(((uint8_t*)&m_incomingBundleSize) + m_incomingBundleSizeNumBytesReceived, &m_tcpReadSomeBufferVec[m_readSomeBufferParseIndex], numBytesToCopy);
+            m_incomingBundleSizeNumBytesReceived += static_cast<unsigned int>(numBytesToCopy);
+            m_readSomeBufferParseIndex += numBytesToCopy;
+            if (m_incomingBundleSizeNumBytesReceived < sizeof(m_incomingBundleSize)) {
+                break;
+            }
+            if (m_incomingBundleSize == 0) { //keepalive (0 is endian agnostic)
+                std::cout << "notice: keepalive packet received" << std::endl;
+                m_incomingBundleSizeNumBytesReceived = 0;
+                continue;
+            }
             boost::endian::big_to_native_inplace(m_incomingBundleSize);
-            //continue operation StartTcpReceiveBundleData only if there was no error
             if (m_incomingBundleSize > M_MAX_BUNDLE_SIZE_BYTES) { //SAFETY CHECKS ON SIZE BEFORE ALLOCATE
-                std::cerr << "critical error in StcpBundleSink::HandleTcpReceiveIncomingBundleSize(): size " << m_incomingBundleSize << " exceeds 100MB.. TCP receiving on StcpBundleSink will now stop!" << std::endl;
-                DoStcpShutdown(); //leave in m_stateTcpReadActive = true
+                std::cerr << "critical error in StcpBundleSink::ParseReadSomeBuffer(): size " << m_incomingBundleSize << " exceeds " << M_MAX_BUNDLE_SIZE_BYTES
+                    << " bytes.. TCP receiving on StcpBundleSink will now stop!" << std::endl;
+                CommitCompletedBundles();
+                DoStcpShutdown(); //leave in m_stateTcpReadActive = false with nothing read
+                return false;
             }
-            else {
-                m_tcpReceiveBuffersCbVec[writeIndex].resize(m_incomingBundleSize);
-                boost::asio::async_read(*m_tcpSocketPtr,
-                    boost::asio::buffer(m_tcpReceiveBuffersCbVec[writeIndex]),
-                    boost::bind(&StcpBundleSink::HandleTcpReceiveBundleData, this,
-                        boost::asio::placeholders::error,
-                        boost::asio::placeholders::bytes_transferred,
-                        writeIndex));
+        }
+        if (!m_incomingBundleHasWriteIndex) {
+            if (!TryGetWriteIndexForIncomingBundle()) {
+                CommitCompletedBundles();
+                return false;
             }
         }
+        if (m_readSomeBufferParseIndex == m_readSomeBufferEndIndex) {
+            break;
+        }
+        //a bundle spanning reads is copied piecewise into its preallocated slot
+        const std::size_t numBytesToCopy = std::min(static_cast<std::size_t>(m_incomingBundleSize - m_incomingBundleNumBytesReceived), m_readSomeBufferEndIndex - m_readSomeBufferParseIndex);
+        memcpy(m_tcpReceiveBuffersCbVec[m_writeIndex + m_numWritesToCommit].data() + m_incomingBundleNumBytesReceived, &m_tcpReadSomeBufferVec[m_readSomeBufferParseIndex], numBytesToCopy);
+        m_incomingBundleNumBytesReceived += static_cast<uint32_t>(numBytesToCopy);
+        m_readSomeBufferParseIndex += numBytesToCopy;
+        if (m_incomingBundleNumBytesReceived == m_incomingBundleSize) {
+            OnIncomingBundleComplete();
+        }
     }
-    else if (error == boost::asio::error::eof) {
-        std::cout << "Tcp connection closed cleanly by peer" << std::endl;
-        DoStcpShutdown();
+    CommitCompletedBundles();
+    m_readSomeBufferParseIndex = 0;
+    m_readSomeBufferEndIndex = 0;
+    return true;
+}
+
+void StcpBundleSink::HandleTcpReceiveSome(const boost::system::error_code & error, std::size_t bytesTransferred) {
+    if (!error) {
+        m_readSomeBufferParseIndex = 0;
+        m_readSomeBufferEndIndex = bytesTransferred;
+        m_stateTcpReadActive = false; //must be false before calling TryStartTcpReceive
+        TryStartTcpReceive(); //parse and restart operation only if there was no error
     }
-    else if (error != boost::asio::error::operation_aborted) {
-        std::cerr << "Error in StcpBundleSink::HandleTcpReceiveIncomingBundleSize: " << error.message() << std::endl;
+    else {
+        HandleTcpReceiveError(error);
     }
 }
 
-void StcpBundleSink::HandleTcpReceiveBundleData(const boost::system::error_code & error, std::size_t bytesTransferred, unsigned int writeIndex) {
+void StcpBundleSink::HandleTcpReceiveBundleData(const boost::system::error_code & error, std::size_t bytesTransferred) {
+    m_incomingBundleNumBytesReceived += static_cast<uint32_t>(bytesTransferred);
     if (!error) {
-        if (bytesTransferred == m_incomingBundleSize) {
-            m_tcpReceiveBytesTransferredCbVec[writeIndex] = bytesTransferred;
-            m_circularIndexBuffer.CommitWrite(); //write complete at this point
-            m_stateTcpReadActive = false; //must be false before calling TryStartTcpReceive
-            m_conditionVariableCb.notify_one();
-            TryStartTcpReceive(); //restart operation only if there was no error
-        }
-        else {
-            std::cerr << "Critical error in StcpBundleSink::HandleTcpReceiveBundleData: bytesTransferred ("
-                << bytesTransferred << ") != m_incomingBundleSize (" << m_incomingBundleSize << ")" << std::endl;
-        }
+        OnIncomingBundleComplete();
+        CommitCompletedBundles();
+        m_stateTcpReadActive = false; //must be false before calling TryStartTcpReceive
+        TryStartTcpReceive(); //restart operation only if there was no error
     }
-    else if (error == boost::asio::error::eof) {
+    else {
+        HandleTcpReceiveError(error);
+    }
+}
+
+void StcpBundleSink::HandleTcpReceiveError(const boost::system::error_code & error) {
+    if (error == boost::asio::error::eof) {
         std::cout << "Tcp connection closed cleanly by peer" << std::endl;
         DoStcpShutdown();
     }
     else if (error != boost::asio::error::operation_aborted) {
-        std::cerr << "Error in StcpBundleSink::HandleTcpReceiveBundleData: " << error.message() << std::endl;
+        std::cerr << "Error in StcpBundleSink receive: " << error.message() << std::endl;
     }
 }
 
@@ -158,22 +240,22 @@ void StcpBundleSink::HandleTcpReceiveBundleData(const boost::system::error_code
 
 void StcpBundleSink::PopCbThreadFunc() {
 
-    boost::mutex localMutex;
-    boost::mutex::scoped_lock lock(localMutex);
-
     while (m_running || (m_circularIndexBuffer.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY)) { //keep thread alive if running or cb not empty
 
-
-        const unsigned int consumeIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
-        boost::asio::post(m_tcpSocketIoServiceRef, boost::bind(&StcpBundleSink::TryStartTcpReceive, this)); //keep this a thread safe operation by letting ioService thread run it
+        unsigned int numContiguousAvailable;
+        const unsigned int consumeIndex = m_circularIndexBuffer.GetContiguousIndicesForRead(numContiguousAvailable); //store the volatile
         if (consumeIndex == CIRCULAR_INDEX_BUFFER_EMPTY) { //if empty
-            m_conditionVariableCb.timed_wait(lock, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            m_circularIndexBuffer.WaitUntilNotEmpty(); //blocks until CommitWrite() or StopWaiting()
             continue;
         }
-        m_wholeBundleReadyCallback(m_tcpReceiveBuffersCbVec[consumeIndex]);
-        
-        m_circularIndexBuffer.CommitRead();
+        for (unsigned int i = 0; i < numContiguousAvailable; ++i) {
+            m_wholeBundleReadyCallback(m_tcpReceiveBuffersCbVec[consumeIndex + i]);
+            m_circularIndexBuffer.CommitRead();
+            //only wake the io service thread if it paused on a full circular buffer
+            if (m_waitingForCbSpace.load(std::memory_order_relaxed) && m_waitingForCbSpace.exchange(false)) {
+                boost::asio::post(m_tcpSocketIoServiceRef, boost::bind(&StcpBundleSink::TryStartTcpReceive, this)); //keep this a thread safe operation by letting ioService thread run it
+            }
+        }
     }
 
     std::cout << "StcpBundleSink Circular buffer reader thread exiting\n";
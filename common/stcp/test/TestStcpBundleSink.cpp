@@ -0,0 +1,149 @@
+/**
+ * @file TestStcpBundleSink.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "StcpBundleSink.h"
+#include <boost/bind/bind.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/make_unique.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <algorithm>
+#include <set>
+
+//streams many small bundles and a few large ones (either side of the 64 KiB direct read threshold) into an StcpBundleSink
+//over a loopback tcp connection in arbitrarily sized writes, some of which end inside a length field,
+//with a consumer that stalls at first so that the sink must pause on a full circular buffer and resume
+BOOST_AUTO_TEST_CASE(StcpBundleSinkChunkedLoopbackTestCase)
+{
+    static const uint16_t STCP_PORT = 4594;
+    static const unsigned int NUM_CIRCULAR_BUFFER_VECTORS = 5;
+    static const unsigned int NUM_BUNDLES = 400;
+
+    struct Test {
+        boost::mutex m_mutex;
+        std::vector<padded_vector_uint8_t> m_receivedBundles;
+        boost::posix_time::ptime m_consumerStallUntil;
+
+        void WholeBundleReady(padded_vector_uint8_t & wholeBundleVec) {
+            const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+            if (now < m_consumerStallUntil) {
+                boost::this_thread::sleep(m_consumerStallUntil - now);
+            }
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_receivedBundles.push_back(std::move(wholeBundleVec));
+        }
+        std::size_t NumReceived() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_receivedBundles.size();
+        }
+        static std::vector<uint8_t> MakeBundle(const uint32_t index, const uint32_t size) {
+            std::vector<uint8_t> bundle(size);
+            for (uint32_t i = 0; i < size; ++i) {
+                bundle[i] = static_cast<uint8_t>(index + (i * 31) + (i >> 8));
+            }
+            return bundle;
+        }
+    };
+
+    //bundle sizes: mostly small, with large ones at, just below, and well above the direct read threshold
+    boost::random::mt19937 gen(12345);
+    const boost::random::uniform_int_distribution<uint32_t> distSmallSize(1, 3000);
+    const boost::random::uniform_int_distribution<uint32_t> distChunkSize(1, 5000);
+    std::vector<uint32_t> bundleSizes(NUM_BUNDLES);
+    for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+        bundleSizes[i] = distSmallSize(gen);
+    }
+    bundleSizes[17] = 65535;
+    bundleSizes[18] = 65536;
+    bundleSizes[19] = 65537;
+    bundleSizes[100] = 500000;
+    bundleSizes[101] = 200000;
+    bundleSizes[250] = 1000000;
+    bundleSizes[NUM_BUNDLES - 1] = 300000;
+
+    //the stcp stream: 4 byte big endian length then the bundle, with a few keepalives (length 0) mixed in
+    std::vector<uint8_t> stream;
+    std::vector<std::size_t> lengthFieldOffsets;
+    for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+        if ((i % 50) == 25) {
+            stream.insert(stream.end(), 4, 0);
+        }
+        lengthFieldOffsets.push_back(stream.size());
+        const uint32_t sizeBe = boost::endian::native_to_big(bundleSizes[i]);
+        stream.insert(stream.end(), (const uint8_t*)&sizeBe, ((const uint8_t*)&sizeBe) + sizeof(sizeBe));
+        const std::vector<uint8_t> bundle = Test::MakeBundle(i, bundleSizes[i]);
+        stream.insert(stream.end(), bundle.begin(), bundle.end());
+    }
+    //write boundaries: random chunks, plus every 10th length field split in the middle
+    std::set<std::size_t> writeBoundaries;
+    for (std::size_t offset = distChunkSize(gen); offset < stream.size(); offset += distChunkSize(gen)) {
+        writeBoundaries.insert(offset);
+    }
+    for (std::size_t i = 0; i < lengthFieldOffsets.size(); i += 10) {
+        writeBoundaries.insert(lengthFieldOffsets[i] + 2);
+    }
+    writeBoundaries.insert(stream.size());
+
+    Test t;
+    t.m_consumerStallUntil = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(300);
+    boost::asio::io_service ioService;
+    std::unique_ptr<boost::asio::io_service::work> workPtr = boost::make_unique<boost::asio::io_service::work>(ioService); //keep run() alive while the sink is paused with no read pending
+    boost::asio::ip::tcp::acceptor acceptor(ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), STCP_PORT));
+    boost::asio::ip::tcp::socket senderSocket(ioService);
+    senderSocket.connect(acceptor.local_endpoint());
+    senderSocket.set_option(boost::asio::ip::tcp::no_delay(true));
+    boost::shared_ptr<boost::asio::ip::tcp::socket> sinkSocketPtr = boost::make_shared<boost::asio::ip::tcp::socket>(ioService);
+    acceptor.accept(*sinkSocketPtr);
+    std::unique_ptr<StcpBundleSink> sinkPtr = boost::make_unique<StcpBundleSink>(sinkSocketPtr, ioService,
+        boost::bind(&Test::WholeBundleReady, &t, boost::placeholders::_1), NUM_CIRCULAR_BUFFER_VECTORS, 2000000);
+    sinkSocketPtr.reset(); //the sink owns the socket
+    boost::thread ioServiceThread(boost::bind(&boost::asio::io_service::run, &ioService));
+
+    std::size_t writeOffset = 0;
+    for (std::set<std::size_t>::const_iterator it = writeBoundaries.cbegin(); it != writeBoundaries.cend(); ++it) {
+        boost::asio::write(senderSocket, boost::asio::buffer(&stream[writeOffset], *it - writeOffset));
+        if ((*it != stream.size()) && (*it >= 2) && (std::binary_search(lengthFieldOffsets.begin(), lengthFieldOffsets.end(), *it - 2))) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(2)); //let the sink read up to the middle of this length field
+        }
+        writeOffset = *it;
+    }
+
+    for (unsigned int i = 0; (i < 1000) && (t.NumReceived() < NUM_BUNDLES); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE_EQUAL(t.NumReceived(), NUM_BUNDLES);
+    {
+        boost::mutex::scoped_lock lock(t.m_mutex);
+        for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+            const std::vector<uint8_t> expectedBundle = Test::MakeBundle(i, bundleSizes[i]);
+            BOOST_REQUIRE_EQUAL(t.m_receivedBundles[i].size(), expectedBundle.size());
+            BOOST_REQUIRE(std::equal(expectedBundle.begin(), expectedBundle.end(), t.m_receivedBundles[i].begin()));
+        }
+    }
+
+    //a clean close from the sender shuts the sink down without delivering anything more
+    senderSocket.shutdown(boost::asio::socket_base::shutdown_send);
+    for (unsigned int i = 0; (i < 200) && (!sinkPtr->ReadyToBeDeleted()); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE(sinkPtr->ReadyToBeDeleted());
+    sinkPtr.reset();
+    BOOST_REQUIRE_EQUAL(t.NumReceived(), NUM_BUNDLES);
+    senderSocket.close();
+    workPtr.reset();
+    ioService.stop();
+    ioServiceThread.join();
+}
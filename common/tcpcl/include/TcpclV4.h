@@ -177,6 +177,9 @@ public:
         //helpers
         TCPCL_LIB_EXPORT static uint64_t SerializeTransferLengthExtension(uint8_t * serialization, const uint64_t totalLength);
         static constexpr uint64_t SIZE_OF_SERIALIZED_TRANSFER_LENGTH_EXTENSION = 5 + sizeof(uint64_t); //5 bytes of flags, type, length
+        //non-critical session extension (item type from the 0x8000-0xffff private/experimental range) with no value,
+        //sent by an entity that resends the unacknowledged remainder of an interrupted transfer as a bundle fragment
+        static constexpr uint16_t SESSION_EXTENSION_TYPE_REACTIVE_FRAGMENTATION = 0x8000;
     };
     struct tcpclv4_extensions_t {
         std::vector<tcpclv4_extension_t> extensionsVec;
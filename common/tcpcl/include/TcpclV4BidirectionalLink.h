@@ -136,6 +136,10 @@ private:
     TCPCL_LIB_NO_EXPORT void BaseClass_HandleTcpSendShutdown(const boost::system::error_code& error, std::size_t bytes_transferred);
     
     TCPCL_LIB_NO_EXPORT void BaseClass_CloseAndDeleteSockets();
+    TCPCL_LIB_NO_EXPORT bool BaseClass_SendTransfer(const uint64_t transferId, const uint8_t * dataToSendPtr, const std::size_t dataSize,
+        std::unique_ptr<zmq::message_t> & zmqMessageUniquePtr, std::vector<uint8_t> & vecMessage, const bool usingZmqData);
+    TCPCL_LIB_NO_EXPORT void BaseClass_ResendRetainedBundles();
+    TCPCL_LIB_NO_EXPORT void BaseClass_DeliverReceivedPrefixOfInterruptedTransfer();
 
 protected:
     const std::string M_BASE_IMPLEMENTATION_STRING_FOR_COUT;
@@ -183,6 +187,23 @@ protected:
     TcpAsyncSenderElement::OnSuccessfulSendCallbackByIoServiceThread_t m_base_handleTcpSendContactHeaderCallback;
     TcpAsyncSenderElement::OnSuccessfulSendCallbackByIoServiceThread_t m_base_handleTcpSendShutdownCallback;
     padded_vector_uint8_t m_base_fragmentedBundleRxConcat;
+    uint64_t m_base_fragmentedBundleRxConcatTotalLength; //from the transfer length extension, 0 if no segmented transfer is in progress
+
+    //reactive fragmentation (bundle source only): each bundle is retained until its whole transfer is acked
+    //so that after a session loss only the unacknowledged remainder of its payload is resent (as a fragment) on the next session
+    struct retained_bundle_t {
+        std::vector<uint8_t> bundleVec;
+        std::unique_ptr<zmq::message_t> bundleZmq;
+        uint8_t * bundleDataPtr;
+        uint64_t bundleSizeBytes;
+        uint64_t originalBundleSizeBytes;
+        uint64_t transferId;
+        uint64_t numBytesAcked;
+    };
+    bool m_base_reactiveFragmentationEnabled;
+    bool m_base_remoteResendsUnackedRemainder; //the remote's session init advertised reactive fragmentation
+    std::unique_ptr<CircularIndexBufferSingleProducerSingleConsumerConfigurable> m_base_retainedBundlesCbPtr;
+    std::vector<retained_bundle_t> m_base_retainedBundlesCbVec;
 
     const unsigned int M_BASE_MY_MAX_TX_UNACKED_BUNDLES;
     std::unique_ptr<CircularIndexBufferSingleProducerSingleConsumerConfigurable> m_base_segmentsToAckCbPtr; //CircularIndexBufferSingleProducerSingleConsumerConfigurable m_base_bytesToAckCb;
@@ -46,6 +46,9 @@ public:
     TCPCL_LIB_EXPORT void Connect(const std::string & hostname, const std::string & port);
     TCPCL_LIB_EXPORT bool ReadyToForward() const;
     TCPCL_LIB_EXPORT void SetOnSuccessfulAckCallback(const OnSuccessfulAckCallback_t & callback);
+    //must be called before Connect.  Only enable if the remote delivers the received part of an interrupted transfer as a fragment
+    //(enabling it advertises reactive fragmentation in the session init, which an hdtn remote requires before delivering that fragment).
+    TCPCL_LIB_EXPORT void SetReactiveFragmentationEnabled(const bool enabled);
 private:
     TCPCL_LIB_NO_EXPORT void OnResolve(const boost::system::error_code & ec, boost::asio::ip::tcp::resolver::results_type results);
     TCPCL_LIB_NO_EXPORT void OnConnect(const boost::system::error_code & ec);
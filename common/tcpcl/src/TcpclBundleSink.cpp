@@ -56,7 +56,7 @@ TcpclBundleSink::TcpclBundleSink(
     m_tcpSocketIoServiceRef(tcpSocketIoServiceRef),
     M_NUM_CIRCULAR_BUFFER_VECTORS(numCircularBufferVectors),
     M_CIRCULAR_BUFFER_BYTES_PER_VECTOR(circularBufferBytesPerVector),
-    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS, true), //blocking wait for PopCbThreadFunc
     m_tcpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_tcpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_stateTcpReadActive(false),
@@ -90,6 +90,7 @@ TcpclBundleSink::~TcpclBundleSink() {
     }
 
     m_running = false; //thread stopping criteria
+    m_circularIndexBuffer.StopWaiting(); //wake PopCbThreadFunc
 
     if (m_threadCbReaderPtr) {
         m_threadCbReaderPtr->join();
@@ -134,7 +135,6 @@ void TcpclBundleSink::HandleTcpReceiveSome(const boost::system::error_code & err
         m_tcpReceiveBytesTransferredCbVec[writeIndex] = bytesTransferred;
         m_circularIndexBuffer.CommitWrite(); //write complete at this point
         m_stateTcpReadActive = false; //must be false before calling TryStartTcpReceive
-        m_conditionVariableCb.notify_one();
         TryStartTcpReceive(); //restart operation only if there was no error
     }
     else if (error == boost::asio::error::eof) {
@@ -148,8 +148,6 @@ void TcpclBundleSink::HandleTcpReceiveSome(const boost::system::error_code & err
 
 void TcpclBundleSink::PopCbThreadFunc() {
 
-    boost::mutex localMutex;
-    boost::mutex::scoped_lock lock(localMutex);
 
     while (m_running || (m_circularIndexBuffer.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY)) { //keep thread alive if running or cb not empty
 
@@ -157,8 +155,7 @@ void TcpclBundleSink::PopCbThreadFunc() {
         const unsigned int consumeIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
         boost::asio::post(m_tcpSocketIoServiceRef, boost::bind(&TcpclBundleSink::TryStartTcpReceive, this)); //keep this a thread safe operation by letting ioService thread run it
         if (consumeIndex == CIRCULAR_INDEX_BUFFER_EMPTY) { //if empty
-            m_conditionVariableCb.timed_wait(lock, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            m_circularIndexBuffer.WaitUntilNotEmpty(); //blocks until CommitWrite() or StopWaiting()
             continue;
         }
         m_base_dataReceivedServedAsKeepaliveReceived = true;
@@ -20,6 +20,7 @@
 #include <boost/make_unique.hpp>
 #include "Uri.h"
 #include <boost/endian/conversion.hpp>
+#include "codec/Bpv7Fragmentation.h"
 
 TcpclV4BidirectionalLink::TcpclV4BidirectionalLink(
     const std::string & implementationStringForCout,
@@ -68,6 +69,11 @@ TcpclV4BidirectionalLink::TcpclV4BidirectionalLink(
     m_base_reconnectionDelaySecondsIfNotZero(3), //bundle source only, start at 3, increases with exponential back-off mechanism
 
     m_base_myNextTransferId(0),
+    m_base_fragmentedBundleRxConcatTotalLength(0),
+    m_base_reactiveFragmentationEnabled(false),
+    m_base_remoteResendsUnackedRemainder(false),
+    m_base_retainedBundlesCbPtr(boost::make_unique<CircularIndexBufferSingleProducerSingleConsumerConfigurable>(myMaxTxUnackedBundles + 1)),
+    m_base_retainedBundlesCbVec(myMaxTxUnackedBundles + 1),
 
     M_BASE_MY_MAX_TX_UNACKED_BUNDLES(myMaxTxUnackedBundles), //bundle sink has MAX_UNACKED(maxUnacked + 5),
     M_BASE_MY_MAX_RX_SEGMENT_SIZE_BYTES(myMaxRxSegmentSizeBytes),
@@ -266,6 +272,7 @@ void TcpclV4BidirectionalLink::BaseClass_DataSegmentCallback(padded_vector_uint8
     else {
         if (isStartFlag) {
             m_base_fragmentedBundleRxConcat.resize(0);
+            m_base_fragmentedBundleRxConcatTotalLength = (detectedLengthExtension) ? bundleLength : 0;
             //(!isEndFlag) is assumed from if else
             if (detectedLengthExtension) {
                 m_base_fragmentedBundleRxConcat.reserve(bundleLength);
@@ -277,6 +284,7 @@ void TcpclV4BidirectionalLink::BaseClass_DataSegmentCallback(padded_vector_uint8
         m_base_fragmentedBundleRxConcat.insert(m_base_fragmentedBundleRxConcat.end(), dataSegmentDataVec.begin(), dataSegmentDataVec.end()); //concatenate
         bytesToAck = m_base_fragmentedBundleRxConcat.size();
         if (isEndFlag) { //fragmentation complete
+            m_base_fragmentedBundleRxConcatTotalLength = 0;
             Virtual_WholeBundleReady(m_base_fragmentedBundleRxConcat);
         }
     }
@@ -329,9 +337,21 @@ void TcpclV4BidirectionalLink::BaseClass_AckCallback(const TcpclV4::tcpclv4_ack_
         m_base_segmentsToAckCbPtr->CommitRead();
         const bool isFragment = !(ack.isStartSegment && ack.isEndSegment);
         m_base_totalFragmentedAcked += isFragment;
+        uint64_t totalBytesAcknowledged = ack.totalBytesAcknowledged;
+        const unsigned int retainedReadIndex = m_base_retainedBundlesCbPtr->GetIndexForRead();
+        if ((retainedReadIndex != CIRCULAR_INDEX_BUFFER_EMPTY) && (m_base_retainedBundlesCbVec[retainedReadIndex].transferId == ack.transferId)) {
+            retained_bundle_t & retainedBundle = m_base_retainedBundlesCbVec[retainedReadIndex];
+            retainedBundle.numBytesAcked = ack.totalBytesAcknowledged;
+            if (ack.isEndSegment) {
+                totalBytesAcknowledged = retainedBundle.originalBundleSizeBytes; //a resent remainder completes the original bundle
+                std::vector<uint8_t>().swap(retainedBundle.bundleVec);
+                retainedBundle.bundleZmq.reset();
+                m_base_retainedBundlesCbPtr->CommitRead();
+            }
+        }
         if (ack.isEndSegment) { //entire bundle
             ++m_base_totalBundlesAcked;
-            m_base_totalBytesAcked += ack.totalBytesAcknowledged;
+            m_base_totalBytesAcked += totalBytesAcknowledged;
             Virtual_OnSuccessfulWholeBundleAcknowledged();
             if (m_base_useLocalConditionVariableAckReceived) {
                 m_base_localConditionVariableAckReceived.notify_one();
@@ -625,6 +645,10 @@ void TcpclV4BidirectionalLink::BaseClass_CloseAndDeleteSockets() {
     }
     m_base_needToSendKeepAliveMessageTimer.cancel();
     m_base_noKeepAlivePacketReceivedTimer.cancel();
+    if (m_base_fragmentedBundleRxConcatTotalLength) {
+        BaseClass_DeliverReceivedPrefixOfInterruptedTransfer();
+    }
+    m_base_remoteResendsUnackedRemainder = false;
     m_base_tcpclV4RxStateMachine.InitRx(); //reset states
     m_base_tcpclShutdownComplete = true; //bundlesource
     m_base_sinkIsSafeToDelete = true; //bundlesink
@@ -669,14 +693,17 @@ bool TcpclV4BidirectionalLink::BaseClass_Forward(std::unique_ptr<zmq::message_t>
         dataToSendPtr = vecMessage.data();
     }
 
-        
+    //the remote was told that every interrupted transfer is resent, so a bundle that cannot be retained must not be sent
+    const unsigned int retainedWriteIndex = (m_base_reactiveFragmentationEnabled) ? m_base_retainedBundlesCbPtr->GetIndexForWrite() : 0;
+    if (retainedWriteIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+        std::cerr << M_BASE_IMPLEMENTATION_STRING_FOR_COUT << ": error in Base_Forward: too many retained bundles awaiting an ack" << std::endl;
+        return false;
+    }
+
 
     ++m_base_totalBundlesSent;
     m_base_totalBundleBytesSent += dataSize;
 
-        
-    std::vector<TcpAsyncSenderElement*> elements;
-
     /*
     Each of the bundle transfer messages contains a Transfer ID which is
     used to correlate messages (from both sides of a transfer) for each
@@ -714,7 +741,29 @@ bool TcpclV4BidirectionalLink::BaseClass_Forward(std::unique_ptr<zmq::message_t>
     unpredictable Transfer IDs within a session.*/
     const uint64_t transferId = m_base_myNextTransferId++;
 
+    if (m_base_reactiveFragmentationEnabled) {
+        //keep ownership of the bundle (instead of handing it over to the tcp async sender) until its whole transfer is acked
+        retained_bundle_t & retainedBundle = m_base_retainedBundlesCbVec[retainedWriteIndex];
+        if (usingZmqData) {
+            retainedBundle.bundleZmq = std::move(zmqMessageUniquePtr);
+        }
+        else {
+            retainedBundle.bundleVec = std::move(vecMessage);
+        }
+        retainedBundle.bundleDataPtr = const_cast<uint8_t*>(dataToSendPtr); //moving the owner does not move the data
+        retainedBundle.bundleSizeBytes = dataSize;
+        retainedBundle.originalBundleSizeBytes = dataSize;
+        retainedBundle.transferId = transferId;
+        retainedBundle.numBytesAcked = 0;
+        m_base_retainedBundlesCbPtr->CommitWrite();
+    }
+    return BaseClass_SendTransfer(transferId, dataToSendPtr, dataSize, zmqMessageUniquePtr, vecMessage, usingZmqData);
+}
 
+bool TcpclV4BidirectionalLink::BaseClass_SendTransfer(const uint64_t transferId, const uint8_t * dataToSendPtr, const std::size_t dataSize,
+    std::unique_ptr<zmq::message_t> & zmqMessageUniquePtr, std::vector<uint8_t> & vecMessage, const bool usingZmqData)
+{
+    std::vector<TcpAsyncSenderElement*> elements;
     if (m_base_remoteMaxRxSegmentSizeBytes && (dataSize > m_base_remoteMaxRxSegmentSizeBytes)) {
         //fragmenting a bundle into multiple tcpcl segments
         elements.reserve((dataSize / m_base_remoteMaxRxSegmentSizeBytes) + 2);
@@ -916,10 +965,14 @@ void TcpclV4BidirectionalLink::BaseClass_SendSessionInit() {
 #else
     if (m_base_tcpSocketPtr) {
 #endif
+        TcpclV4::tcpclv4_extensions_t sessionExtensions;
+        if (m_base_reactiveFragmentationEnabled) { //tell the remote that it may deliver the received part of an interrupted transfer
+            sessionExtensions.extensionsVec.push_back(TcpclV4::tcpclv4_extension_t(false, TcpclV4::tcpclv4_extension_t::SESSION_EXTENSION_TYPE_REACTIVE_FRAGMENTATION, std::vector<uint8_t>()));
+        }
         TcpAsyncSenderElement * el = new TcpAsyncSenderElement();
         el->m_underlyingData.resize(1);
         TcpclV4::GenerateSessionInitMessage(el->m_underlyingData[0], M_BASE_DESIRED_KEEPALIVE_INTERVAL_SECONDS, M_BASE_MY_MAX_RX_SEGMENT_SIZE_BYTES,
-            M_BASE_MY_MAX_RX_BUNDLE_SIZE_BYTES, M_BASE_THIS_TCPCL_EID_STRING, TcpclV4::tcpclv4_extensions_t());
+            M_BASE_MY_MAX_RX_BUNDLE_SIZE_BYTES, M_BASE_THIS_TCPCL_EID_STRING, sessionExtensions);
         el->m_constBufferVec.emplace_back(boost::asio::buffer(el->m_underlyingData[0])); //only one element so resize not needed
         el->m_onSuccessfulSendCallbackByIoServiceThreadPtr = &m_base_handleTcpSendCallback;
 
@@ -1015,10 +1068,16 @@ void TcpclV4BidirectionalLink::BaseClass_SessionInitCallback(uint16_t keepAliveI
     m_base_segmentsToAckCbPtr = boost::make_unique<CircularIndexBufferSingleProducerSingleConsumerConfigurable>(m_base_ackCbSize);
     m_base_segmentsToAckCbVec.resize(m_base_ackCbSize);
 
+    m_base_remoteResendsUnackedRemainder = false;
     if (sessionExtensions.extensionsVec.size()) {
         std::cout << M_BASE_IMPLEMENTATION_STRING_FOR_COUT << ": received " << sessionExtensions.extensionsVec.size() << " session extensions\n";
         for (std::size_t i = 0; i < sessionExtensions.extensionsVec.size(); ++i) {
             const TcpclV4::tcpclv4_extension_t & ext = sessionExtensions.extensionsVec[i];
+            if (ext.type == TcpclV4::tcpclv4_extension_t::SESSION_EXTENSION_TYPE_REACTIVE_FRAGMENTATION) {
+                std::cout << M_BASE_IMPLEMENTATION_STRING_FOR_COUT << ": remote resends the unacknowledged remainder of an interrupted transfer as a fragment\n";
+                m_base_remoteResendsUnackedRemainder = true;
+                continue;
+            }
             //If a TCPCL entity receives a
             //Session Extension Item with an unknown Item Type and the CRITICAL
             //flag of 1, the entity SHALL terminate the TCPCL session with
@@ -1079,8 +1138,61 @@ void TcpclV4BidirectionalLink::BaseClass_SessionInitCallback(uint16_t keepAliveI
         BaseClass_RestartNeedToSendKeepAliveMessageTimer();
     }
 
+    BaseClass_ResendRetainedBundles();
     m_base_readyToForward = true;
     Virtual_OnSessionInitReceivedAndProcessedSuccessfully();
 }
 
 void TcpclV4BidirectionalLink::Virtual_OnSessionInitReceivedAndProcessedSuccessfully() {}
+
+void TcpclV4BidirectionalLink::BaseClass_ResendRetainedBundles() {
+    //called from the io service thread before m_base_readyToForward is set, so Base_Forward is not adding retained bundles
+    const unsigned int numRetained = m_base_retainedBundlesCbPtr->NumInBuffer();
+    if (numRetained == 0) {
+        return;
+    }
+    const unsigned int readIndex = m_base_retainedBundlesCbPtr->GetIndexForRead();
+    std::size_t numReactiveFragments = 0;
+    for (unsigned int i = 0; i < numRetained; ++i) {
+        retained_bundle_t & retainedBundle = m_base_retainedBundlesCbVec[(readIndex + i) % m_base_retainedBundlesCbVec.size()];
+        std::vector<uint8_t> fragment;
+        if (Bpv7Fragmenter::FragmentUnsentRemainder(retainedBundle.bundleDataPtr, retainedBundle.bundleSizeBytes, retainedBundle.numBytesAcked, fragment)) {
+            retainedBundle.bundleVec = std::move(fragment);
+            retainedBundle.bundleZmq.reset();
+            retainedBundle.bundleDataPtr = retainedBundle.bundleVec.data();
+            retainedBundle.bundleSizeBytes = retainedBundle.bundleVec.size();
+            ++numReactiveFragments;
+        }
+        //otherwise (not fragmentable, or its whole payload was acked) the whole bundle (or the whole previous remainder) is sent again
+        retainedBundle.transferId = m_base_myNextTransferId++;
+        retainedBundle.numBytesAcked = 0;
+        std::unique_ptr<zmq::message_t> unusedZmqMessagePtr;
+        std::vector<uint8_t> unusedVecMessage;
+        if (!BaseClass_SendTransfer(retainedBundle.transferId, retainedBundle.bundleDataPtr, retainedBundle.bundleSizeBytes, unusedZmqMessagePtr, unusedVecMessage, false)) {
+            return;
+        }
+    }
+    std::cout << M_BASE_IMPLEMENTATION_STRING_FOR_COUT << ": resent " << numRetained << " bundles unacknowledged by the previous session ("
+        << numReactiveFragments << " as reactive fragments of their unacknowledged remainder)" << std::endl;
+}
+
+void TcpclV4BidirectionalLink::BaseClass_DeliverReceivedPrefixOfInterruptedTransfer() {
+    //reactive fragmentation: the session ended mid transfer, so deliver the received part of the payload as a fragment,
+    //but only if the remote will resend the rest as a fragment (otherwise it resends the whole bundle and the fragment would never be completed)
+    const uint64_t numBytesReceived = m_base_fragmentedBundleRxConcat.size();
+    const uint64_t bundleLength = m_base_fragmentedBundleRxConcatTotalLength;
+    m_base_fragmentedBundleRxConcatTotalLength = 0;
+    if ((!m_base_remoteResendsUnackedRemainder) || (numBytesReceived == 0) || (numBytesReceived >= bundleLength)) {
+        m_base_fragmentedBundleRxConcat.resize(0);
+        return;
+    }
+    m_base_fragmentedBundleRxConcat.resize(bundleLength);
+    std::vector<uint8_t> fragment;
+    if (Bpv7Fragmenter::FragmentReceivedPrefix(m_base_fragmentedBundleRxConcat.data(), numBytesReceived, bundleLength, fragment)) {
+        std::cout << M_BASE_IMPLEMENTATION_STRING_FOR_COUT << ": session ended after receiving " << numBytesReceived << " of " << bundleLength
+            << " bundle bytes.. delivering the received payload as a fragment" << std::endl;
+        padded_vector_uint8_t fragmentVec(fragment.begin(), fragment.end());
+        Virtual_WholeBundleReady(fragmentVec);
+    }
+    m_base_fragmentedBundleRxConcat.resize(0);
+}
@@ -327,3 +327,7 @@ bool TcpclV4BundleSource::ReadyToForward() const {
 void TcpclV4BundleSource::SetOnSuccessfulAckCallback(const OnSuccessfulAckCallback_t & callback) {
     m_onSuccessfulAckCallback = callback;
 }
+
+void TcpclV4BundleSource::SetReactiveFragmentationEnabled(const bool enabled) {
+    m_base_reactiveFragmentationEnabled = enabled;
+}
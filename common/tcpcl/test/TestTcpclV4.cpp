@@ -14,8 +14,14 @@
 
 #include <boost/test/unit_test.hpp>
 #include "TcpclV4.h"
+#include "TcpclV4BundleSource.h"
+#include "TcpclV4BundleSink.h"
+#include "codec/Bpv7Fragmentation.h"
 #include <boost/bind/bind.hpp>
 #include <boost/endian/conversion.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/make_unique.hpp>
 
 
 BOOST_AUTO_TEST_CASE(TcpclV4FullTestCase)
@@ -728,3 +734,224 @@ BOOST_AUTO_TEST_CASE(TcpclV4MagicHeaderStatesTestCase)
         BOOST_REQUIRE(m_tcpcl.m_contactHeaderRxState == TCPCLV4_CONTACT_HEADER_RX_STATE::READ_VERSION);
     }
 }
+
+//copies from one proxy socket to the other until the other end closes or maxBytes have been copied
+static void ProxyPump(boost::asio::ip::tcp::socket & fromSocket, boost::asio::ip::tcp::socket & toSocket, std::size_t maxBytes) {
+    std::vector<uint8_t> buffer(4096);
+    boost::system::error_code ec;
+    while (maxBytes) {
+        const std::size_t bytesRead = fromSocket.read_some(boost::asio::buffer(buffer.data(), std::min(buffer.size(), maxBytes)), ec);
+        if (ec) {
+            toSocket.shutdown(boost::asio::socket_base::shutdown_send, ec); //pass the close on
+            return;
+        }
+        boost::asio::write(toSocket, boost::asio::buffer(buffer.data(), bytesRead), ec);
+        if (ec) {
+            return;
+        }
+        maxBytes -= bytesRead;
+    }
+}
+
+//a TcpclV4BundleSource with reactive fragmentation sends one large bpv7 bundle to a TcpclV4BundleSink through a loopback proxy
+//that cuts the first session after part of the bundle (and the XFER_ACKs of its first segments) got through.
+//The sink delivers the received prefix as a fragment, the source reconnects and resends only the unacknowledged remainder
+//as a fragment, and the upper layer sees exactly one ack for the bundle.
+BOOST_AUTO_TEST_CASE(TcpclV4ReactiveFragmentationLoopbackTestCase)
+{
+    static const uint16_t PROXY_PORT = 4595;
+    static const uint16_t SINK_PORT = 4596;
+    static const uint64_t SINK_SEGMENT_MRU = 10000;
+    static const std::size_t PAYLOAD_SIZE = 100000;
+    static const std::size_t FIRST_SESSION_BYTES_TO_SINK = 45000; //contact header, session init, and about 4.5 of the 11 segments
+
+    struct ProxiedSession {
+        boost::asio::ip::tcp::socket m_sourceSideSocket;
+        boost::asio::ip::tcp::socket m_sinkSideSocket;
+        std::unique_ptr<TcpclV4BundleSink> m_sinkPtr;
+        std::unique_ptr<boost::thread> m_toSinkThreadPtr;
+        std::unique_ptr<boost::thread> m_toSourceThreadPtr;
+
+        ProxiedSession(boost::asio::io_service & ioService) : m_sourceSideSocket(ioService), m_sinkSideSocket(ioService) {}
+        void Cut() {
+            boost::system::error_code ec;
+            m_sourceSideSocket.shutdown(boost::asio::socket_base::shutdown_both, ec);
+            m_sinkSideSocket.shutdown(boost::asio::socket_base::shutdown_both, ec);
+            m_toSinkThreadPtr->join();
+            m_toSourceThreadPtr->join();
+            m_sourceSideSocket.close(ec);
+            m_sinkSideSocket.close(ec);
+        }
+    };
+    struct Test {
+        boost::mutex m_mutex;
+        std::vector<padded_vector_uint8_t> m_receivedBundles;
+        unsigned int m_numAcks;
+
+        Test() : m_numAcks(0) {}
+        void WholeBundleReady(padded_vector_uint8_t & wholeBundleVec) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_receivedBundles.push_back(std::move(wholeBundleVec));
+        }
+        void OnSuccessfulAck() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            ++m_numAcks;
+        }
+        std::size_t NumReceived() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_receivedBundles.size();
+        }
+        unsigned int NumAcks() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_numAcks;
+        }
+        //the proxy accepts the (re)connecting source and connects it to a new bundle sink,
+        //forwarding at most maxBytesToSink bytes from the source to the sink
+        std::unique_ptr<ProxiedSession> AcceptProxiedSession(boost::asio::ip::tcp::acceptor & proxyAcceptor, boost::asio::ip::tcp::acceptor & sinkAcceptor,
+#ifdef OPENSSL_SUPPORT_ENABLED
+            boost::asio::ssl::context & sinkSslContext,
+#endif
+            boost::asio::io_service & ioService, const std::size_t maxBytesToSink)
+        {
+            std::unique_ptr<ProxiedSession> sessionPtr = boost::make_unique<ProxiedSession>(ioService);
+            proxyAcceptor.accept(sessionPtr->m_sourceSideSocket);
+            sessionPtr->m_sinkSideSocket.connect(sinkAcceptor.local_endpoint());
+#ifdef OPENSSL_SUPPORT_ENABLED
+            boost::shared_ptr<boost::asio::ssl::stream<boost::asio::ip::tcp::socket> > sinkSocketPtr =
+                boost::make_shared<boost::asio::ssl::stream<boost::asio::ip::tcp::socket> >(ioService, sinkSslContext);
+            sinkAcceptor.accept(sinkSocketPtr->next_layer());
+#else
+            boost::shared_ptr<boost::asio::ip::tcp::socket> sinkSocketPtr = boost::make_shared<boost::asio::ip::tcp::socket>(ioService);
+            sinkAcceptor.accept(*sinkSocketPtr);
+#endif
+            sessionPtr->m_sinkPtr = boost::make_unique<TcpclV4BundleSink>(sinkSocketPtr, false, false, 15, ioService,
+                boost::bind(&Test::WholeBundleReady, this, boost::placeholders::_1), 10, 200000, 2, 10000000,
+                TcpclV4BundleSink::NotifyReadyToDeleteCallback_t(), TcpclV4BundleSink::OnContactHeaderCallback_t(), 10, SINK_SEGMENT_MRU);
+            sessionPtr->m_toSinkThreadPtr = boost::make_unique<boost::thread>(boost::bind(&ProxyPump,
+                boost::ref(sessionPtr->m_sourceSideSocket), boost::ref(sessionPtr->m_sinkSideSocket), maxBytesToSink));
+            sessionPtr->m_toSourceThreadPtr = boost::make_unique<boost::thread>(boost::bind(&ProxyPump,
+                boost::ref(sessionPtr->m_sinkSideSocket), boost::ref(sessionPtr->m_sourceSideSocket), SIZE_MAX));
+            return sessionPtr;
+        }
+    };
+
+    //a bpv7 bundle from ipn:1.1 to ipn:2.1 with a large payload
+    std::string payload(PAYLOAD_SIZE, 0);
+    for (std::size_t i = 0; i < PAYLOAD_SIZE; ++i) {
+        payload[i] = static_cast<char>('a' + (i % 26));
+    }
+    BundleViewV7 bv;
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.SetZero();
+    primary.m_sourceNodeId.Set(1, 1);
+    primary.m_destinationEid.Set(2, 1);
+    primary.m_reportToEid.Set(0, 0);
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = 1000;
+    primary.m_lifetimeMilliseconds = 1000000;
+    primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    bv.m_primaryBlockView.SetManuallyModified();
+    std::unique_ptr<Bpv7CanonicalBlock> payloadBlockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+    payloadBlockPtr->m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+    payloadBlockPtr->m_blockNumber = 1;
+    payloadBlockPtr->m_crcType = BPV7_CRC_TYPE::CRC32C;
+    payloadBlockPtr->m_dataLength = payload.size();
+    payloadBlockPtr->m_dataPtr = (uint8_t*)payload.data();
+    bv.AppendMoveCanonicalBlock(payloadBlockPtr);
+    BOOST_REQUIRE(bv.Render(PAYLOAD_SIZE + 500));
+    const std::vector<uint8_t> originalBundle(bv.m_frontBuffer);
+
+    Test t;
+    boost::asio::io_service sinkIoService;
+    std::unique_ptr<boost::asio::io_service::work> workPtr = boost::make_unique<boost::asio::io_service::work>(sinkIoService);
+    boost::asio::ip::tcp::acceptor proxyAcceptor(sinkIoService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), PROXY_PORT));
+    boost::asio::ip::tcp::acceptor sinkAcceptor(sinkIoService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), SINK_PORT));
+    boost::thread ioServiceThread(boost::bind(&boost::asio::io_service::run, &sinkIoService));
+#ifdef OPENSSL_SUPPORT_ENABLED
+    boost::asio::ssl::context sinkSslContext(boost::asio::ssl::context::sslv23_server);
+    boost::asio::ssl::context sourceSslContext(boost::asio::ssl::context::sslv23_client);
+#endif
+    std::unique_ptr<TcpclV4BundleSource> sourcePtr = boost::make_unique<TcpclV4BundleSource>(
+#ifdef OPENSSL_SUPPORT_ENABLED
+        sourceSslContext,
+#endif
+        false, false, 15, 1, "ipn:2.0", 10, 100000, 10000000);
+    sourcePtr->SetReactiveFragmentationEnabled(true);
+    sourcePtr->SetOnSuccessfulAckCallback(boost::bind(&Test::OnSuccessfulAck, &t));
+    sourcePtr->Connect("localhost", boost::lexical_cast<std::string>(PROXY_PORT));
+
+    //first session: cut once the first part of the bundle got through and its segments were acked
+    std::unique_ptr<ProxiedSession> session1Ptr = t.AcceptProxiedSession(proxyAcceptor, sinkAcceptor,
+#ifdef OPENSSL_SUPPORT_ENABLED
+        sinkSslContext,
+#endif
+        sinkIoService, FIRST_SESSION_BYTES_TO_SINK);
+    for (unsigned int i = 0; (i < 100) && (!sourcePtr->ReadyToForward()); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    }
+    BOOST_REQUIRE(sourcePtr->ReadyToForward());
+    std::vector<uint8_t> bundleToSend(originalBundle);
+    BOOST_REQUIRE(sourcePtr->BaseClass_Forward(bundleToSend));
+    BOOST_REQUIRE(session1Ptr->m_toSinkThreadPtr->timed_join(boost::posix_time::seconds(5)));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500)); //let the XFER_ACKs of the forwarded segments reach the source
+    session1Ptr->Cut();
+    for (unsigned int i = 0; (i < 100) && (!session1Ptr->m_sinkPtr->ReadyToBeDeleted()); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    }
+    BOOST_REQUIRE(session1Ptr->m_sinkPtr->ReadyToBeDeleted());
+    BOOST_REQUIRE_EQUAL(t.NumReceived(), 1); //the received prefix
+    BOOST_REQUIRE_EQUAL(t.NumAcks(), 0);
+
+    //second session (the source reconnects after its reconnection delay): only the remainder is resent
+    std::unique_ptr<ProxiedSession> session2Ptr = t.AcceptProxiedSession(proxyAcceptor, sinkAcceptor,
+#ifdef OPENSSL_SUPPORT_ENABLED
+        sinkSslContext,
+#endif
+        sinkIoService, SIZE_MAX);
+    for (unsigned int i = 0; (i < 200) && ((t.NumAcks() == 0) || (t.NumReceived() < 2)); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200)); //a duplicate ack or bundle would arrive in this time
+    BOOST_REQUIRE_EQUAL(t.NumAcks(), 1);
+    BOOST_REQUIRE_EQUAL(t.NumReceived(), 2);
+    BOOST_REQUIRE_EQUAL(sourcePtr->Virtual_GetTotalBundlesSent(), 1);
+    BOOST_REQUIRE_EQUAL(sourcePtr->Virtual_GetTotalBundlesAcked(), 1);
+    BOOST_REQUIRE_EQUAL(sourcePtr->Virtual_GetTotalBundlesUnacked(), 0);
+    BOOST_REQUIRE_EQUAL(sourcePtr->Virtual_GetTotalBundleBytesSent(), originalBundle.size());
+    BOOST_REQUIRE_EQUAL(sourcePtr->Virtual_GetTotalBundleBytesAcked(), originalBundle.size());
+
+    //the prefix starts the payload, the resent remainder ends it (starting no later than where the prefix ended), and together they reassemble
+    BundleViewV7 prefixBv;
+    BundleViewV7 remainderBv;
+    BOOST_REQUIRE(prefixBv.CopyAndLoadBundle(t.m_receivedBundles[0].data(), t.m_receivedBundles[0].size()));
+    BOOST_REQUIRE(remainderBv.CopyAndLoadBundle(t.m_receivedBundles[1].data(), t.m_receivedBundles[1].size()));
+    BOOST_REQUIRE(prefixBv.m_primaryBlockView.header.HasFragmentationFlagSet());
+    BOOST_REQUIRE(remainderBv.m_primaryBlockView.header.HasFragmentationFlagSet());
+    const uint64_t prefixLength = prefixBv.m_listCanonicalBlockView.back().headerPtr->m_dataLength;
+    const uint64_t remainderOffset = remainderBv.m_primaryBlockView.header.m_fragmentOffset;
+    BOOST_REQUIRE_EQUAL(prefixBv.m_primaryBlockView.header.m_fragmentOffset, 0);
+    BOOST_REQUIRE_LT(prefixLength, PAYLOAD_SIZE);
+    BOOST_REQUIRE_GT(remainderOffset, 0); //some of the payload was acked in the first session
+    BOOST_REQUIRE_LE(remainderOffset, prefixLength);
+    BOOST_REQUIRE_EQUAL(remainderOffset + remainderBv.m_listCanonicalBlockView.back().headerPtr->m_dataLength, PAYLOAD_SIZE);
+    Bpv7FragmentReassembler reassembler;
+    std::vector<uint8_t> reassembledBundle;
+    bool isComplete;
+    BOOST_REQUIRE(reassembler.AddFragment(prefixBv, isComplete, reassembledBundle));
+    BOOST_REQUIRE(!isComplete);
+    BOOST_REQUIRE(reassembler.AddFragment(remainderBv, isComplete, reassembledBundle));
+    BOOST_REQUIRE(isComplete);
+    BOOST_REQUIRE(reassembledBundle == originalBundle);
+
+    sourcePtr.reset(); //cleanly terminates the second session
+    for (unsigned int i = 0; (i < 100) && (!session2Ptr->m_sinkPtr->ReadyToBeDeleted()); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    }
+    BOOST_REQUIRE(session2Ptr->m_sinkPtr->ReadyToBeDeleted());
+    session2Ptr->Cut();
+    session1Ptr.reset();
+    session2Ptr.reset();
+    BOOST_REQUIRE_EQUAL(t.NumReceived(), 2);
+    workPtr.reset();
+    sinkIoService.stop();
+    ioServiceThread.join();
+}
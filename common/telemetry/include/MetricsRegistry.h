@@ -0,0 +1,161 @@
+/**
+ * @file MetricsRegistry.h
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The MetricsRegistry is a process wide set of named counters, gauges, and latency histograms
+ * that all HDTN modules record into.  Metrics are created (under a mutex) once at initialization,
+ * and the returned references remain valid for the life of the process, so recording on the hot path
+ * never takes a lock or allocates:
+ * 1.) MetricCounter::Increment is a relaxed atomic add to a per-thread shard (no cache line contention between threads).
+ * 2.) MetricGauge::Set/Add is a relaxed atomic store/add.
+ * 3.) LatencyHistogram::RecordNanoseconds is a few relaxed atomic adds into HDR style log-linear buckets
+ *     (16 linear sub-buckets per power of two, i.e. a worst case relative error of 6.25%).
+ * A snapshot of all metrics whose names begin with a given prefix can be serialized to JSON,
+ * which the modules return to the GUI over their existing ZMQ REQ/REP telemetry sockets.
+ */
+
+#ifndef HDTN_METRICS_REGISTRY_H
+#define HDTN_METRICS_REGISTRY_H 1
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <boost/thread/mutex.hpp>
+#include <boost/core/noncopyable.hpp>
+#include "telemetry_definitions_export.h"
+
+class MetricCounter : private boost::noncopyable {
+public:
+    static constexpr unsigned int NUM_SHARDS = 16;
+
+    TELEMETRY_DEFINITIONS_EXPORT MetricCounter();
+    void Increment(const uint64_t value = 1) {
+        m_shards[GetThreadShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+    TELEMETRY_DEFINITIONS_EXPORT uint64_t Get() const;
+    TELEMETRY_DEFINITIONS_EXPORT void Reset();
+    //each thread is assigned its own shard (round robin) on its first increment of any counter
+    TELEMETRY_DEFINITIONS_EXPORT static unsigned int GetThreadShardIndex();
+private:
+    struct Shard {
+        std::atomic<uint64_t> value;
+        uint8_t padding[64 - sizeof(std::atomic<uint64_t>)]; //one shard per cache line
+    };
+    Shard m_shards[NUM_SHARDS];
+};
+
+class MetricGauge : private boost::noncopyable {
+public:
+    TELEMETRY_DEFINITIONS_EXPORT MetricGauge();
+    void Set(const int64_t value) {
+        m_value.store(value, std::memory_order_relaxed);
+    }
+    void Add(const int64_t value) {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+    int64_t Get() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+private:
+    std::atomic<int64_t> m_value;
+};
+
+struct LatencyHistogramSummary {
+    uint64_t count;
+    uint64_t sumNanoseconds;
+    uint64_t minNanoseconds;
+    uint64_t maxNanoseconds;
+    uint64_t p50Nanoseconds;
+    uint64_t p90Nanoseconds;
+    uint64_t p99Nanoseconds;
+    uint64_t p999Nanoseconds;
+};
+
+class LatencyHistogram : private boost::noncopyable {
+public:
+    static constexpr unsigned int SUB_BUCKET_BITS = 4;
+    static constexpr unsigned int NUM_SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * NUM_SUB_BUCKETS;
+
+    TELEMETRY_DEFINITIONS_EXPORT LatencyHistogram();
+    void RecordNanoseconds(const uint64_t nanoseconds) {
+        m_buckets[GetBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        m_sumNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        uint64_t currentMax = m_maxNanoseconds.load(std::memory_order_relaxed);
+        while ((nanoseconds > currentMax) && (!m_maxNanoseconds.compare_exchange_weak(currentMax, nanoseconds, std::memory_order_relaxed))) {}
+    }
+    void RecordSince(const uint64_t startTimestampNanoseconds) {
+        RecordNanoseconds(NowNanoseconds() - startTimestampNanoseconds);
+    }
+    TELEMETRY_DEFINITIONS_EXPORT LatencyHistogramSummary GetSummary() const;
+    TELEMETRY_DEFINITIONS_EXPORT void Reset();
+
+    //monotonic clock used for all latency measurements
+    static uint64_t NowNanoseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    TELEMETRY_DEFINITIONS_EXPORT static unsigned int GetBucketIndex(const uint64_t value);
+    TELEMETRY_DEFINITIONS_EXPORT static uint64_t GetBucketLowestValue(const unsigned int bucketIndex);
+    TELEMETRY_DEFINITIONS_EXPORT static uint64_t GetBucketHighestValue(const unsigned int bucketIndex);
+
+    //records the lifetime of the scope
+    class ScopedTimer : private boost::noncopyable {
+    public:
+        ScopedTimer(LatencyHistogram & histogram) : m_histogram(histogram), m_startTimestampNanoseconds(NowNanoseconds()) {}
+        ~ScopedTimer() {
+            m_histogram.RecordSince(m_startTimestampNanoseconds);
+        }
+    private:
+        LatencyHistogram & m_histogram;
+        const uint64_t m_startTimestampNanoseconds;
+    };
+private:
+    std::atomic<uint64_t> m_buckets[NUM_BUCKETS];
+    std::atomic<uint64_t> m_sumNanoseconds;
+    std::atomic<uint64_t> m_maxNanoseconds;
+};
+
+struct MetricsSnapshot {
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, int64_t> gauges;
+    std::map<std::string, LatencyHistogramSummary> histograms;
+
+    TELEMETRY_DEFINITIONS_EXPORT std::string ToJson() const;
+};
+
+class MetricsRegistry : private boost::noncopyable {
+public:
+    TELEMETRY_DEFINITIONS_EXPORT static MetricsRegistry & GetInstance();
+
+    //thread safe, returns the existing metric if the name is already registered
+    TELEMETRY_DEFINITIONS_EXPORT MetricCounter & GetOrCreateCounter(const std::string & name);
+    TELEMETRY_DEFINITIONS_EXPORT MetricGauge & GetOrCreateGauge(const std::string & name);
+    TELEMETRY_DEFINITIONS_EXPORT LatencyHistogram & GetOrCreateHistogram(const std::string & name);
+
+    //snapshot of every metric whose name begins with any of the prefixes (all metrics if namePrefixes is empty)
+    TELEMETRY_DEFINITIONS_EXPORT MetricsSnapshot GetSnapshot(const std::vector<std::string> & namePrefixes = std::vector<std::string>()) const;
+    TELEMETRY_DEFINITIONS_EXPORT void ResetAll();
+private:
+    MetricsRegistry();
+
+    mutable boost::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<MetricCounter> > m_counters;
+    std::map<std::string, std::unique_ptr<MetricGauge> > m_gauges;
+    std::map<std::string, std::unique_ptr<LatencyHistogram> > m_histograms;
+};
+
+#endif // HDTN_METRICS_REGISTRY_H
@@ -22,6 +22,10 @@
 #include <cstdint>
 #include "telemetry_definitions_export.h"
 
+//single byte requests sent by the gui over the REQ/REP telemetry sockets
+#define TELEMETRY_GUI_REQUEST_TELEMETRY 1 //reply is the module's fixed size *Telemetry_t struct
+#define TELEMETRY_GUI_REQUEST_METRICS_SNAPSHOT 2 //reply is the module's MetricsRegistry snapshot as a JSON string
+
 struct IngressTelemetry_t{
     uint64_t type = 1;
     double bundleDataRate;
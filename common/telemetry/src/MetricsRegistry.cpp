@@ -0,0 +1,251 @@
+/**
+ * @file MetricsRegistry.cpp
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "MetricsRegistry.h"
+#include <sstream>
+#include <boost/make_unique.hpp>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static std::atomic<unsigned int> g_nextThreadShardIndex(0);
+static thread_local unsigned int t_threadShardIndexPlusOne = 0; //0 => not yet assigned
+
+MetricCounter::MetricCounter() {
+    Reset();
+}
+
+unsigned int MetricCounter::GetThreadShardIndex() {
+    if (t_threadShardIndexPlusOne == 0) {
+        t_threadShardIndexPlusOne = (g_nextThreadShardIndex.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS) + 1;
+    }
+    return t_threadShardIndexPlusOne - 1;
+}
+
+uint64_t MetricCounter::Get() const {
+    uint64_t sum = 0;
+    for (unsigned int i = 0; i < NUM_SHARDS; ++i) {
+        sum += m_shards[i].value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void MetricCounter::Reset() {
+    for (unsigned int i = 0; i < NUM_SHARDS; ++i) {
+        m_shards[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricGauge::MetricGauge() : m_value(0) {}
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+void LatencyHistogram::Reset() {
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_sumNanoseconds.store(0, std::memory_order_relaxed);
+    m_maxNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+static unsigned int GetMostSignificantBitPosition(const uint64_t value) { //value must be nonzero
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned int>(index);
+#else
+    return 63u - static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+}
+
+//values [0, NUM_SUB_BUCKETS) get their own bucket,
+//then each power of two is split into NUM_SUB_BUCKETS linear sub-buckets
+unsigned int LatencyHistogram::GetBucketIndex(const uint64_t value) {
+    if (value < NUM_SUB_BUCKETS) {
+        return static_cast<unsigned int>(value);
+    }
+    const unsigned int msb = GetMostSignificantBitPosition(value);
+    const unsigned int shift = msb - SUB_BUCKET_BITS;
+    const unsigned int subBucket = static_cast<unsigned int>(value >> shift) & (NUM_SUB_BUCKETS - 1);
+    return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+}
+
+uint64_t LatencyHistogram::GetBucketLowestValue(const unsigned int bucketIndex) {
+    if (bucketIndex < NUM_SUB_BUCKETS) {
+        return bucketIndex;
+    }
+    const unsigned int shift = (bucketIndex >> SUB_BUCKET_BITS) - 1;
+    const uint64_t subBucket = bucketIndex & (NUM_SUB_BUCKETS - 1);
+    return (NUM_SUB_BUCKETS + subBucket) << shift;
+}
+
+uint64_t LatencyHistogram::GetBucketHighestValue(const unsigned int bucketIndex) {
+    if (bucketIndex < NUM_SUB_BUCKETS) {
+        return bucketIndex;
+    }
+    const unsigned int shift = (bucketIndex >> SUB_BUCKET_BITS) - 1;
+    return GetBucketLowestValue(bucketIndex) + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+LatencyHistogramSummary LatencyHistogram::GetSummary() const {
+    LatencyHistogramSummary summary;
+    uint64_t counts[NUM_BUCKETS];
+    summary.count = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    summary.sumNanoseconds = m_sumNanoseconds.load(std::memory_order_relaxed);
+    summary.maxNanoseconds = m_maxNanoseconds.load(std::memory_order_relaxed);
+    summary.minNanoseconds = 0;
+    summary.p50Nanoseconds = 0;
+    summary.p90Nanoseconds = 0;
+    summary.p99Nanoseconds = 0;
+    summary.p999Nanoseconds = 0;
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    //a percentile is reported as the highest value of the bucket it falls in (never more than the max recorded)
+    static const double PERCENTILES[4] = { 0.50, 0.90, 0.99, 0.999 };
+    uint64_t * const results[4] = { &summary.p50Nanoseconds, &summary.p90Nanoseconds, &summary.p99Nanoseconds, &summary.p999Nanoseconds };
+    unsigned int percentileIndex = 0;
+    uint64_t cumulativeCount = 0;
+    bool foundMin = false;
+    for (unsigned int i = 0; (i < NUM_BUCKETS) && (percentileIndex < 4); ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        if (!foundMin) {
+            foundMin = true;
+            summary.minNanoseconds = GetBucketLowestValue(i);
+        }
+        cumulativeCount += counts[i];
+        while ((percentileIndex < 4) && (cumulativeCount >= static_cast<uint64_t>(PERCENTILES[percentileIndex] * summary.count + 0.5))) {
+            const uint64_t highest = GetBucketHighestValue(i);
+            *results[percentileIndex] = (highest < summary.maxNanoseconds) ? highest : summary.maxNanoseconds;
+            ++percentileIndex;
+        }
+    }
+    return summary;
+}
+
+std::string MetricsSnapshot::ToJson() const {
+    std::ostringstream oss;
+    oss << "{\"counters\":{";
+    for (std::map<std::string, uint64_t>::const_iterator it = counters.cbegin(); it != counters.cend(); ++it) {
+        oss << ((it == counters.cbegin()) ? "" : ",") << "\"" << it->first << "\":" << it->second;
+    }
+    oss << "},\"gauges\":{";
+    for (std::map<std::string, int64_t>::const_iterator it = gauges.cbegin(); it != gauges.cend(); ++it) {
+        oss << ((it == gauges.cbegin()) ? "" : ",") << "\"" << it->first << "\":" << it->second;
+    }
+    oss << "},\"histograms\":{";
+    for (std::map<std::string, LatencyHistogramSummary>::const_iterator it = histograms.cbegin(); it != histograms.cend(); ++it) {
+        const LatencyHistogramSummary & s = it->second;
+        oss << ((it == histograms.cbegin()) ? "" : ",") << "\"" << it->first << "\":{"
+            << "\"count\":" << s.count
+            << ",\"sumNs\":" << s.sumNanoseconds
+            << ",\"minNs\":" << s.minNanoseconds
+            << ",\"maxNs\":" << s.maxNanoseconds
+            << ",\"p50Ns\":" << s.p50Nanoseconds
+            << ",\"p90Ns\":" << s.p90Nanoseconds
+            << ",\"p99Ns\":" << s.p99Nanoseconds
+            << ",\"p999Ns\":" << s.p999Nanoseconds
+            << "}";
+    }
+    oss << "}}";
+    return oss.str();
+}
+
+MetricsRegistry & MetricsRegistry::GetInstance() {
+    static MetricsRegistry instance; //thread safe initialization (c++11)
+    return instance;
+}
+
+MetricsRegistry::MetricsRegistry() {}
+
+MetricCounter & MetricsRegistry::GetOrCreateCounter(const std::string & name) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::unique_ptr<MetricCounter> & ptr = m_counters[name];
+    if (!ptr) {
+        ptr = boost::make_unique<MetricCounter>();
+    }
+    return *ptr;
+}
+
+MetricGauge & MetricsRegistry::GetOrCreateGauge(const std::string & name) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::unique_ptr<MetricGauge> & ptr = m_gauges[name];
+    if (!ptr) {
+        ptr = boost::make_unique<MetricGauge>();
+    }
+    return *ptr;
+}
+
+LatencyHistogram & MetricsRegistry::GetOrCreateHistogram(const std::string & name) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::unique_ptr<LatencyHistogram> & ptr = m_histograms[name];
+    if (!ptr) {
+        ptr = boost::make_unique<LatencyHistogram>();
+    }
+    return *ptr;
+}
+
+static bool NameMatchesAnyPrefix(const std::string & name, const std::vector<std::string> & namePrefixes) {
+    if (namePrefixes.empty()) {
+        return true;
+    }
+    for (std::size_t i = 0; i < namePrefixes.size(); ++i) {
+        if (name.compare(0, namePrefixes[i].size(), namePrefixes[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MetricsSnapshot MetricsRegistry::GetSnapshot(const std::vector<std::string> & namePrefixes) const {
+    MetricsSnapshot snapshot;
+    boost::mutex::scoped_lock lock(m_mutex);
+    for (std::map<std::string, std::unique_ptr<MetricCounter> >::const_iterator it = m_counters.cbegin(); it != m_counters.cend(); ++it) {
+        if (NameMatchesAnyPrefix(it->first, namePrefixes)) {
+            snapshot.counters[it->first] = it->second->Get();
+        }
+    }
+    for (std::map<std::string, std::unique_ptr<MetricGauge> >::const_iterator it = m_gauges.cbegin(); it != m_gauges.cend(); ++it) {
+        if (NameMatchesAnyPrefix(it->first, namePrefixes)) {
+            snapshot.gauges[it->first] = it->second->Get();
+        }
+    }
+    for (std::map<std::string, std::unique_ptr<LatencyHistogram> >::const_iterator it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+        if (NameMatchesAnyPrefix(it->first, namePrefixes)) {
+            snapshot.histograms[it->first] = it->second->GetSummary();
+        }
+    }
+    return snapshot;
+}
+
+void MetricsRegistry::ResetAll() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    for (std::map<std::string, std::unique_ptr<MetricCounter> >::iterator it = m_counters.begin(); it != m_counters.end(); ++it) {
+        it->second->Reset();
+    }
+    for (std::map<std::string, std::unique_ptr<MetricGauge> >::iterator it = m_gauges.begin(); it != m_gauges.end(); ++it) {
+        it->second->Set(0);
+    }
+    for (std::map<std::string, std::unique_ptr<LatencyHistogram> >::iterator it = m_histograms.begin(); it != m_histograms.end(); ++it) {
+        it->second->Reset();
+    }
+}
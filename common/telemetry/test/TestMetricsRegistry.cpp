@@ -0,0 +1,144 @@
+/**
+ * @file TestMetricsRegistry.cpp
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/timer/timer.hpp>
+#include "MetricsRegistry.h"
+#include <iostream>
+
+BOOST_AUTO_TEST_CASE(LatencyHistogramBucketsTestCase)
+{
+    //every value falls in the bucket whose range contains it, and bucket ranges are contiguous
+    for (uint64_t value = 0; value < 100000; ++value) {
+        const unsigned int index = LatencyHistogram::GetBucketIndex(value);
+        BOOST_REQUIRE_LE(LatencyHistogram::GetBucketLowestValue(index), value);
+        BOOST_REQUIRE_GE(LatencyHistogram::GetBucketHighestValue(index), value);
+    }
+    for (unsigned int i = 1; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+        BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketHighestValue(i - 1) + 1, LatencyHistogram::GetBucketLowestValue(i));
+    }
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketIndex(UINT64_MAX), LatencyHistogram::NUM_BUCKETS - 1);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketHighestValue(LatencyHistogram::NUM_BUCKETS - 1), UINT64_MAX);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketIndex(15), 15);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketIndex(16), 16);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketIndex(32), 32);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::GetBucketIndex(33), 32); //buckets of width 2 start at 32
+}
+
+BOOST_AUTO_TEST_CASE(LatencyHistogramSummaryTestCase)
+{
+    LatencyHistogram h;
+    LatencyHistogramSummary s = h.GetSummary();
+    BOOST_REQUIRE_EQUAL(s.count, 0);
+    BOOST_REQUIRE_EQUAL(s.p99Nanoseconds, 0);
+
+    //1..1000 microseconds
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        h.RecordNanoseconds(i * 1000);
+    }
+    s = h.GetSummary();
+    BOOST_REQUIRE_EQUAL(s.count, 1000);
+    BOOST_REQUIRE_EQUAL(s.sumNanoseconds, 500500000);
+    BOOST_REQUIRE_EQUAL(s.maxNanoseconds, 1000000);
+    BOOST_REQUIRE_LE(s.minNanoseconds, 1000);
+    BOOST_REQUIRE_GE(s.minNanoseconds, 1000 - (1000 / 16));
+    //within the 6.25% bucket error
+    BOOST_REQUIRE_GE(s.p50Nanoseconds, 500000);
+    BOOST_REQUIRE_LE(s.p50Nanoseconds, 500000 + (500000 / 16));
+    BOOST_REQUIRE_GE(s.p90Nanoseconds, 900000);
+    BOOST_REQUIRE_LE(s.p90Nanoseconds, 900000 + (900000 / 16));
+    BOOST_REQUIRE_GE(s.p99Nanoseconds, 990000);
+    BOOST_REQUIRE_LE(s.p99Nanoseconds, 1000000); //clamped to the max
+    BOOST_REQUIRE_EQUAL(s.p999Nanoseconds, 1000000);
+
+    h.Reset();
+    BOOST_REQUIRE_EQUAL(h.GetSummary().count, 0);
+}
+
+static void IncrementCounterThreadFunc(MetricCounter * counter, LatencyHistogram * histogram, const unsigned int numIncrements) {
+    for (unsigned int i = 0; i < numIncrements; ++i) {
+        counter->Increment();
+        histogram->RecordNanoseconds(i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MetricsRegistryTestCase)
+{
+    MetricsRegistry & registry = MetricsRegistry::GetInstance();
+    MetricCounter & counter = registry.GetOrCreateCounter("test.counter");
+    BOOST_REQUIRE_EQUAL(&counter, &registry.GetOrCreateCounter("test.counter")); //same metric returned by name
+    MetricGauge & gauge = registry.GetOrCreateGauge("test.gauge");
+    LatencyHistogram & histogram = registry.GetOrCreateHistogram("test.latency");
+    registry.GetOrCreateCounter("othertest.counter").Increment(5);
+    counter.Reset();
+    histogram.Reset();
+
+    static const unsigned int NUM_THREADS = 4;
+    static const unsigned int NUM_INCREMENTS_PER_THREAD = 100000;
+    {
+        boost::thread_group threads;
+        for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+            threads.create_thread(boost::bind(&IncrementCounterThreadFunc, &counter, &histogram, NUM_INCREMENTS_PER_THREAD));
+        }
+        threads.join_all();
+    }
+    BOOST_REQUIRE_EQUAL(counter.Get(), NUM_THREADS * NUM_INCREMENTS_PER_THREAD);
+    BOOST_REQUIRE_EQUAL(histogram.GetSummary().count, NUM_THREADS * NUM_INCREMENTS_PER_THREAD);
+
+    gauge.Set(10);
+    gauge.Add(-3);
+    BOOST_REQUIRE_EQUAL(gauge.Get(), 7);
+
+    const MetricsSnapshot snapshot = registry.GetSnapshot(std::vector<std::string>(1, "test."));
+    BOOST_REQUIRE_EQUAL(snapshot.counters.size(), 1);
+    BOOST_REQUIRE_EQUAL(snapshot.counters.at("test.counter"), NUM_THREADS * NUM_INCREMENTS_PER_THREAD);
+    BOOST_REQUIRE_EQUAL(snapshot.gauges.at("test.gauge"), 7);
+    BOOST_REQUIRE_EQUAL(snapshot.histograms.at("test.latency").count, NUM_THREADS * NUM_INCREMENTS_PER_THREAD);
+    BOOST_REQUIRE_GE(registry.GetSnapshot().counters.size(), 2);
+
+    const std::string json = snapshot.ToJson();
+    BOOST_REQUIRE(json.find("\"counters\":{\"test.counter\":400000}") != std::string::npos);
+    BOOST_REQUIRE(json.find("\"gauges\":{\"test.gauge\":7}") != std::string::npos);
+    BOOST_REQUIRE(json.find("\"test.latency\":{\"count\":400000,") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(MetricsRegistrySpeedTestCase, *boost::unit_test::disabled())
+{
+    MetricCounter & counter = MetricsRegistry::GetInstance().GetOrCreateCounter("test.speedCounter");
+    LatencyHistogram & histogram = MetricsRegistry::GetInstance().GetOrCreateHistogram("test.speedLatency");
+    static const unsigned int NUM_CALLS = 10000000;
+    {
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_CALLS; ++i) {
+            counter.Increment();
+        }
+        std::cout << "MetricCounter::Increment: " << (static_cast<double>(timer.elapsed().wall) / NUM_CALLS) << " ns per call\n";
+    }
+    {
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_CALLS; ++i) {
+            histogram.RecordNanoseconds(i);
+        }
+        std::cout << "LatencyHistogram::RecordNanoseconds: " << (static_cast<double>(timer.elapsed().wall) / NUM_CALLS) << " ns per call\n";
+    }
+    {
+        boost::timer::cpu_timer timer;
+        for (unsigned int i = 0; i < NUM_CALLS; ++i) {
+            histogram.RecordSince(LatencyHistogram::NowNanoseconds());
+        }
+        std::cout << "LatencyHistogram::RecordSince(NowNanoseconds()): " << (static_cast<double>(timer.elapsed().wall) / NUM_CALLS) << " ns per call\n";
+    }
+    BOOST_REQUIRE_EQUAL(counter.Get(), NUM_CALLS);
+}
@@ -72,7 +72,6 @@ private:
     std::vector<padded_vector_uint8_t > m_udpReceiveBuffersCbVec;
     std::vector<boost::asio::ip::udp::endpoint> m_remoteEndpointsCbVec;
     std::vector<std::size_t> m_udpReceiveBytesTransferredCbVec;
-    boost::condition_variable m_conditionVariableCb;
     std::unique_ptr<boost::thread> m_threadCbReaderPtr;
     volatile bool m_running;
     volatile bool m_safeToDelete;
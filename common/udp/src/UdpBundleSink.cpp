@@ -32,7 +32,7 @@ UdpBundleSink::UdpBundleSink(boost::asio::io_service & ioService,
     M_NUM_CIRCULAR_BUFFER_VECTORS(numCircularBufferVectors),
     M_MAX_UDP_PACKET_SIZE_BYTES(maxUdpPacketSizeBytes),
     m_udpReceiveBuffer(M_MAX_UDP_PACKET_SIZE_BYTES),
-    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS, true), //blocking wait for PopCbThreadFunc
     m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_remoteEndpointsCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_udpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
@@ -76,6 +76,7 @@ UdpBundleSink::~UdpBundleSink() {
     
     
     m_running = false; //thread stopping criteria
+    m_circularIndexBuffer.StopWaiting(); //wake PopCbThreadFunc
 
     if (m_threadCbReaderPtr) {
         m_threadCbReaderPtr->join();
@@ -108,8 +109,7 @@ void UdpBundleSink::HandleUdpReceive(const boost::system::error_code & error, st
             m_udpReceiveBuffer.swap(m_udpReceiveBuffersCbVec[writeIndex]);
             m_udpReceiveBytesTransferredCbVec[writeIndex] = bytesTransferred;
             m_remoteEndpointsCbVec[writeIndex] = std::move(m_remoteEndpoint);
-            m_circularIndexBuffer.CommitWrite(); //write complete at this point
-            m_conditionVariableCb.notify_one();
+            m_circularIndexBuffer.CommitWrite(); //write complete at this point (wakes PopCbThreadFunc)
         }
         StartUdpReceive(); //restart operation only if there was no error
     }
@@ -124,17 +124,13 @@ void UdpBundleSink::HandleUdpReceive(const boost::system::error_code & error, st
 
 void UdpBundleSink::PopCbThreadFunc() {
 
-    boost::mutex localMutex;
-    boost::mutex::scoped_lock lock(localMutex);
-
     while (m_running || (m_circularIndexBuffer.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY)) { //keep thread alive if running or cb not empty
 
 
         const unsigned int consumeIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
 
         if (consumeIndex == CIRCULAR_INDEX_BUFFER_EMPTY) { //if empty
-            m_conditionVariableCb.timed_wait(lock, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            m_circularIndexBuffer.WaitUntilNotEmpty(); //blocks until CommitWrite() or StopWaiting()
             continue;
         }
         //m_wholeBundleReadyCallback(m_udpReceiveBuffersCbVec[consumeIndex], m_udpReceiveBytesTransferredCbVec[consumeIndex]);
@@ -20,7 +20,14 @@
  *     and commit the read (modifying only the begin index).
  * This class is only concerned with sharing the two array indices between the two threads.
  * Therefore this class requires the user to provide the array(s) of user defined data.
- * This class assumes that "unsigned int" read and write operations for an index are atomic.
+ * The indices are std::atomic with release (commit) and acquire (get index) ordering, so all
+ * writes to the user data made before CommitWrite() are visible to the consumer after GetIndexForRead().
+ * The producer and consumer indices live on separate cache lines, and each side keeps a cached copy
+ * of the other side's index so that the shared cache line is only touched when the buffer looks full/empty.
+ *
+ * Optionally (enableBlockingWait), the consumer may block in WaitUntilNotEmpty() and the producer may block
+ * in WaitUntilNotFull() with no polling timeout.  On Linux the wait is a futex; elsewhere it falls back
+ * to a mutex and condition variable.  When blocking wait is disabled, commits never make a system call.
  */
 
 #ifndef _CIRCULAR_INDEX_BUFFER_SINGLE_PRODUCER_SINGLE_CONSUMER_CONFIGURABLE_H
@@ -28,6 +35,11 @@
 
 #include <boost/integer.hpp>
 #include <stdint.h>
+#include <atomic>
+#ifndef __linux__
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#endif
 #include "hdtn_util_export.h"
 
 #define CIRCULAR_INDEX_BUFFER_FULL UINT32_MAX
@@ -36,8 +48,11 @@
 class HDTN_UTIL_EXPORT CircularIndexBufferSingleProducerSingleConsumerConfigurable {
 private:
     CircularIndexBufferSingleProducerSingleConsumerConfigurable();
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & operator=(const CircularIndexBufferSingleProducerSingleConsumerConfigurable &);
 public:
-    CircularIndexBufferSingleProducerSingleConsumerConfigurable(unsigned int size);
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable(unsigned int size, bool enableBlockingWait = false);
+    //copies the configuration and index values; only for use before the producer and consumer threads start (i.e. std::vector construction)
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable(const CircularIndexBufferSingleProducerSingleConsumerConfigurable & o);
     ~CircularIndexBufferSingleProducerSingleConsumerConfigurable();
 	
     void Init();
@@ -49,11 +64,48 @@ public:
     void CommitRead();
     unsigned int NumInBuffer();
 
+    //batch operations: return the first index (or CIRCULAR_INDEX_BUFFER_FULL/EMPTY) and the number of
+    //contiguous (non-wrapping) elements starting at that index, then commit any number up to that count
+    unsigned int GetContiguousIndicesForWrite(unsigned int & numContiguousAvailable);
+    void CommitWrites(const unsigned int numWritten);
+    unsigned int GetContiguousIndicesForRead(unsigned int & numContiguousAvailable);
+    void CommitReads(const unsigned int numRead);
+
+    //blocking wait (requires enableBlockingWait)
+    //consumer: returns true when not empty, or false if StopWaiting() was called while empty
+    bool WaitUntilNotEmpty();
+    //producer: returns true when not full, or false if StopWaiting() was called while full
+    bool WaitUntilNotFull();
+    //wakes all blocked threads and makes subsequent waits return immediately (until Init() is called)
+    void StopWaiting();
+
 private:
-    volatile unsigned int m_cbStartIndex;
-    volatile unsigned int m_cbEndIndex;
+    void WaitOnFlag(std::atomic<unsigned int> & waitingFlag);
+    void WakeFlag(std::atomic<unsigned int> & waitingFlag);
+
+    static constexpr unsigned int CACHE_LINE_SIZE = 64;
+
     const unsigned int M_CIRCULAR_INDEX_BUFFER_SIZE;
-	
+    const bool M_ENABLE_BLOCKING_WAIT;
+    std::atomic<unsigned int> m_stopWaiting;
+    char m_paddingBeforeConsumer[CACHE_LINE_SIZE];
+
+    //written by the consumer
+    std::atomic<unsigned int> m_cbStartIndex;
+    unsigned int m_consumerCachedEndIndex;
+    std::atomic<unsigned int> m_consumerWaiting;
+    char m_paddingBeforeProducer[CACHE_LINE_SIZE];
+
+    //written by the producer
+    std::atomic<unsigned int> m_cbEndIndex;
+    unsigned int m_producerCachedStartIndex;
+    std::atomic<unsigned int> m_producerWaiting;
+    char m_paddingAfterProducer[CACHE_LINE_SIZE];
+
+#ifndef __linux__
+    boost::mutex m_waitMutex;
+    boost::condition_variable m_waitCv;
+#endif
 };
 
 
@@ -54,6 +54,19 @@ public:
     HDTN_UTIL_EXPORT void SetRate(const int64_t tokens, const boost::posix_time::time_duration & interval,
         const boost::posix_time::time_duration & window);
 
+    /** Set the token fill rate without refilling the bucket.
+     *
+     * Same as SetRate() except that the tokens currently remaining (or borrowed) are kept,
+     * clamped to the new burst limit, so that frequent small rate adjustments
+     * don't each grant a full window of burst.
+     *
+     * @param tokens The number of tokens to add per interval.
+     * @param interval The interval of time to add @c tokens over.
+     * @param window The window of time for averaging the rate over.
+     */
+    HDTN_UTIL_EXPORT void SetRateKeepingRemainingTokens(const int64_t tokens, const boost::posix_time::time_duration & interval,
+        const boost::posix_time::time_duration & window);
+
     /** Tick the rate limiter.
      *
      * @param interval The interval of time to add tokens for based on
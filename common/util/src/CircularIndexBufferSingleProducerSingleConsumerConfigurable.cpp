@@ -14,71 +14,221 @@
 
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include <stdint.h>
+#include <climits>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
-
-CircularIndexBufferSingleProducerSingleConsumerConfigurable::CircularIndexBufferSingleProducerSingleConsumerConfigurable(unsigned int size) :
-    m_cbStartIndex(0), m_cbEndIndex(0), M_CIRCULAR_INDEX_BUFFER_SIZE(size)
+CircularIndexBufferSingleProducerSingleConsumerConfigurable::CircularIndexBufferSingleProducerSingleConsumerConfigurable(unsigned int size, bool enableBlockingWait) :
+    M_CIRCULAR_INDEX_BUFFER_SIZE(size),
+    M_ENABLE_BLOCKING_WAIT(enableBlockingWait),
+    m_stopWaiting(0),
+    m_cbStartIndex(0),
+    m_consumerCachedEndIndex(0),
+    m_consumerWaiting(0),
+    m_cbEndIndex(0),
+    m_producerCachedStartIndex(0),
+    m_producerWaiting(0)
 {
 	
 }
 
+CircularIndexBufferSingleProducerSingleConsumerConfigurable::CircularIndexBufferSingleProducerSingleConsumerConfigurable(const CircularIndexBufferSingleProducerSingleConsumerConfigurable & o) :
+    M_CIRCULAR_INDEX_BUFFER_SIZE(o.M_CIRCULAR_INDEX_BUFFER_SIZE),
+    M_ENABLE_BLOCKING_WAIT(o.M_ENABLE_BLOCKING_WAIT),
+    m_stopWaiting(o.m_stopWaiting.load(std::memory_order_relaxed)),
+    m_cbStartIndex(o.m_cbStartIndex.load(std::memory_order_relaxed)),
+    m_consumerCachedEndIndex(o.m_consumerCachedEndIndex),
+    m_consumerWaiting(0),
+    m_cbEndIndex(o.m_cbEndIndex.load(std::memory_order_relaxed)),
+    m_producerCachedStartIndex(o.m_producerCachedStartIndex),
+    m_producerWaiting(0)
+{
+
+}
+
 CircularIndexBufferSingleProducerSingleConsumerConfigurable::~CircularIndexBufferSingleProducerSingleConsumerConfigurable() {
 	
 }
 
 void CircularIndexBufferSingleProducerSingleConsumerConfigurable::Init() {
-    m_cbStartIndex = 0;
-    m_cbEndIndex = 0;
+    m_cbStartIndex.store(0, std::memory_order_relaxed);
+    m_consumerCachedEndIndex = 0;
+    m_cbEndIndex.store(0, std::memory_order_relaxed);
+    m_producerCachedStartIndex = 0;
+    m_stopWaiting.store(0, std::memory_order_release);
 }
 
 
 bool CircularIndexBufferSingleProducerSingleConsumerConfigurable::IsFull() {
     //return ((m_end + 1) % m_bufferSize) == m_start;
-    unsigned int endPlus1 = m_cbEndIndex + 1;
-        if (endPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) endPlus1 = 0;
-    return (m_cbStartIndex == endPlus1);
+    unsigned int endPlus1 = m_cbEndIndex.load(std::memory_order_acquire) + 1;
+    if (endPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) endPlus1 = 0;
+    return (m_cbStartIndex.load(std::memory_order_acquire) == endPlus1);
 }
 
 bool CircularIndexBufferSingleProducerSingleConsumerConfigurable::IsEmpty() {
-	return (m_cbEndIndex == m_cbStartIndex);
+    return (m_cbEndIndex.load(std::memory_order_acquire) == m_cbStartIndex.load(std::memory_order_acquire));
 }
 
 unsigned int CircularIndexBufferSingleProducerSingleConsumerConfigurable::GetIndexForWrite() {
-	if (IsFull())
-		return CIRCULAR_INDEX_BUFFER_FULL;
-	return m_cbEndIndex;
+    const unsigned int endIndex = m_cbEndIndex.load(std::memory_order_relaxed); //only the producer writes the end index
+    unsigned int endPlus1 = endIndex + 1;
+    if (endPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) endPlus1 = 0;
+    if (endPlus1 == m_producerCachedStartIndex) { //looks full, so refresh from the consumer's cache line
+        m_producerCachedStartIndex = m_cbStartIndex.load(std::memory_order_acquire);
+        if (endPlus1 == m_producerCachedStartIndex) {
+            return CIRCULAR_INDEX_BUFFER_FULL;
+        }
+    }
+    return endIndex;
 }
 
 void CircularIndexBufferSingleProducerSingleConsumerConfigurable::CommitWrite() {
-	////if(CircularBufferIsFull())
-	////	return;
-	//m_end = (m_end + 1) % m_bufferSize;
-	unsigned int endPlus1 = m_cbEndIndex + 1;
-        if (endPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) endPlus1 = 0;
-	m_cbEndIndex = endPlus1;
+    unsigned int endPlus1 = m_cbEndIndex.load(std::memory_order_relaxed) + 1;
+    if (endPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) endPlus1 = 0;
+    m_cbEndIndex.store(endPlus1, std::memory_order_release);
+    if (M_ENABLE_BLOCKING_WAIT) {
+        WakeFlag(m_consumerWaiting);
+    }
 }
 
 unsigned int CircularIndexBufferSingleProducerSingleConsumerConfigurable::GetIndexForRead() {
-	if (IsEmpty())
-		return CIRCULAR_INDEX_BUFFER_EMPTY;
-	return m_cbStartIndex;
+    const unsigned int startIndex = m_cbStartIndex.load(std::memory_order_relaxed); //only the consumer writes the start index
+    if (startIndex == m_consumerCachedEndIndex) { //looks empty, so refresh from the producer's cache line
+        m_consumerCachedEndIndex = m_cbEndIndex.load(std::memory_order_acquire);
+        if (startIndex == m_consumerCachedEndIndex) {
+            return CIRCULAR_INDEX_BUFFER_EMPTY;
+        }
+    }
+    return startIndex;
 }
 
 void CircularIndexBufferSingleProducerSingleConsumerConfigurable::CommitRead() {
-	////if(CircularBufferIsEmpty())
-	////	return;
-	//m_start = (m_start + 1) % m_bufferSize;
-	unsigned int startPlus1 = m_cbStartIndex + 1;
-        if (startPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) startPlus1 = 0;
-	m_cbStartIndex = startPlus1;
-	
+    unsigned int startPlus1 = m_cbStartIndex.load(std::memory_order_relaxed) + 1;
+    if (startPlus1 >= M_CIRCULAR_INDEX_BUFFER_SIZE) startPlus1 = 0;
+    m_cbStartIndex.store(startPlus1, std::memory_order_release);
+    if (M_ENABLE_BLOCKING_WAIT) {
+        WakeFlag(m_producerWaiting);
+    }
 }
 
 unsigned int CircularIndexBufferSingleProducerSingleConsumerConfigurable::NumInBuffer() {
-    unsigned int endIndex = m_cbEndIndex;
-    const unsigned int startIndex = m_cbStartIndex;
+    unsigned int endIndex = m_cbEndIndex.load(std::memory_order_acquire);
+    const unsigned int startIndex = m_cbStartIndex.load(std::memory_order_acquire);
     if (endIndex < startIndex) {
         endIndex += M_CIRCULAR_INDEX_BUFFER_SIZE;
     }
     return endIndex - startIndex;
 }
+
+unsigned int CircularIndexBufferSingleProducerSingleConsumerConfigurable::GetContiguousIndicesForWrite(unsigned int & numContiguousAvailable) {
+    const unsigned int endIndex = m_cbEndIndex.load(std::memory_order_relaxed);
+    m_producerCachedStartIndex = m_cbStartIndex.load(std::memory_order_acquire);
+    const unsigned int startIndex = m_producerCachedStartIndex;
+    //one slot is always left unused to distinguish full from empty
+    if (startIndex > endIndex) {
+        numContiguousAvailable = (startIndex - endIndex) - 1;
+    }
+    else {
+        numContiguousAvailable = M_CIRCULAR_INDEX_BUFFER_SIZE - endIndex;
+        if (startIndex == 0) {
+            --numContiguousAvailable;
+        }
+    }
+    return (numContiguousAvailable) ? endIndex : CIRCULAR_INDEX_BUFFER_FULL;
+}
+
+void CircularIndexBufferSingleProducerSingleConsumerConfigurable::CommitWrites(const unsigned int numWritten) {
+    unsigned int newEnd = m_cbEndIndex.load(std::memory_order_relaxed) + numWritten;
+    if (newEnd >= M_CIRCULAR_INDEX_BUFFER_SIZE) newEnd -= M_CIRCULAR_INDEX_BUFFER_SIZE;
+    m_cbEndIndex.store(newEnd, std::memory_order_release);
+    if (M_ENABLE_BLOCKING_WAIT) {
+        WakeFlag(m_consumerWaiting);
+    }
+}
+
+unsigned int CircularIndexBufferSingleProducerSingleConsumerConfigurable::GetContiguousIndicesForRead(unsigned int & numContiguousAvailable) {
+    const unsigned int startIndex = m_cbStartIndex.load(std::memory_order_relaxed);
+    m_consumerCachedEndIndex = m_cbEndIndex.load(std::memory_order_acquire);
+    const unsigned int endIndex = m_consumerCachedEndIndex;
+    numContiguousAvailable = (endIndex >= startIndex) ? (endIndex - startIndex) : (M_CIRCULAR_INDEX_BUFFER_SIZE - startIndex);
+    return (numContiguousAvailable) ? startIndex : CIRCULAR_INDEX_BUFFER_EMPTY;
+}
+
+void CircularIndexBufferSingleProducerSingleConsumerConfigurable::CommitReads(const unsigned int numRead) {
+    unsigned int newStart = m_cbStartIndex.load(std::memory_order_relaxed) + numRead;
+    if (newStart >= M_CIRCULAR_INDEX_BUFFER_SIZE) newStart -= M_CIRCULAR_INDEX_BUFFER_SIZE;
+    m_cbStartIndex.store(newStart, std::memory_order_release);
+    if (M_ENABLE_BLOCKING_WAIT) {
+        WakeFlag(m_producerWaiting);
+    }
+}
+
+bool CircularIndexBufferSingleProducerSingleConsumerConfigurable::WaitUntilNotEmpty() {
+    while (true) {
+        if (!IsEmpty()) {
+            return true;
+        }
+        if (m_stopWaiting.load(std::memory_order_acquire)) {
+            return false;
+        }
+        //Announce the wait, then re-check.  Paired with the seq_cst fence in WakeFlag,
+        //either the producer sees the flag set or this thread sees the producer's new end index.
+        m_consumerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (IsEmpty() && (!m_stopWaiting.load(std::memory_order_relaxed))) {
+            WaitOnFlag(m_consumerWaiting);
+        }
+        m_consumerWaiting.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool CircularIndexBufferSingleProducerSingleConsumerConfigurable::WaitUntilNotFull() {
+    while (true) {
+        if (!IsFull()) {
+            return true;
+        }
+        if (m_stopWaiting.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_producerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (IsFull() && (!m_stopWaiting.load(std::memory_order_relaxed))) {
+            WaitOnFlag(m_producerWaiting);
+        }
+        m_producerWaiting.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CircularIndexBufferSingleProducerSingleConsumerConfigurable::StopWaiting() {
+    m_stopWaiting.store(1, std::memory_order_release);
+    WakeFlag(m_consumerWaiting);
+    WakeFlag(m_producerWaiting);
+}
+
+//sleeps while waitingFlag is still 1 (a waker clears it to 0 before waking)
+void CircularIndexBufferSingleProducerSingleConsumerConfigurable::WaitOnFlag(std::atomic<unsigned int> & waitingFlag) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<unsigned int*>(&waitingFlag), FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+#else
+    boost::mutex::scoped_lock lock(m_waitMutex);
+    if (waitingFlag.load(std::memory_order_relaxed)) {
+        m_waitCv.wait(lock);
+    }
+#endif
+}
+
+void CircularIndexBufferSingleProducerSingleConsumerConfigurable::WakeFlag(std::atomic<unsigned int> & waitingFlag) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waitingFlag.load(std::memory_order_relaxed) && waitingFlag.exchange(0, std::memory_order_relaxed)) {
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<unsigned int*>(&waitingFlag), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+        boost::mutex::scoped_lock lock(m_waitMutex);
+        m_waitCv.notify_all();
+#endif
+    }
+}
@@ -33,6 +33,22 @@ void TokenRateLimiter::SetRate(const int64_t tokens, const boost::posix_time::ti
     m_remain = m_limit;
 }
 
+void TokenRateLimiter::SetRateKeepingRemainingTokens(const int64_t tokens, const boost::posix_time::time_duration & interval, const boost::posix_time::time_duration & window) {
+    if (interval.is_special()) {
+        return;
+    }
+    const int64_t oldIntervalTicks = m_rateInterval.ticks();
+    int64_t remain = (oldIntervalTicks) ? ((m_remain / oldIntervalTicks) * interval.ticks()) : 0;
+    m_rateTokens = tokens;
+    m_rateInterval = interval;
+
+    m_limit = m_rateTokens * window.ticks();
+    if (remain > m_limit) {
+        remain = m_limit;
+    }
+    m_remain = remain;
+}
+
 void TokenRateLimiter::AddTime(const boost::posix_time::time_duration & interval) {
     if (interval.is_special()) {
         return;
@@ -18,6 +18,10 @@
 #include <string>
 #include <inttypes.h>
 #include <vector>
+#include <algorithm>
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/timer/timer.hpp>
 
 
 BOOST_AUTO_TEST_CASE(CircularIndexBuffer_TestCase)
@@ -222,4 +226,183 @@ BOOST_AUTO_TEST_CASE(CircularIndexBuffer_TestCase)
 
 
 
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(CircularIndexBufferBatch_TestCase)
+{
+    static const unsigned int SIZE_CB = 10;
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable cib(SIZE_CB);
+    std::vector<uint32_t> cbData(SIZE_CB);
+    uint32_t nextValueToWrite = 0;
+    uint32_t nextValueToRead = 0;
+    for (unsigned int iteration = 0; iteration < (SIZE_CB * 3); ++iteration) {
+        //write as many as possible in at most two contiguous chunks
+        unsigned int totalWritten = 0;
+        for (unsigned int chunk = 0; chunk < 2; ++chunk) {
+            unsigned int numContiguous = 0;
+            const unsigned int writeIndex = cib.GetContiguousIndicesForWrite(numContiguous);
+            if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+                BOOST_REQUIRE_EQUAL(numContiguous, 0);
+                break;
+            }
+            BOOST_REQUIRE_GT(numContiguous, 0);
+            BOOST_REQUIRE_LE(writeIndex + numContiguous, SIZE_CB); //never wraps
+            for (unsigned int i = 0; i < numContiguous; ++i) {
+                cbData[writeIndex + i] = nextValueToWrite++;
+            }
+            cib.CommitWrites(numContiguous);
+            totalWritten += numContiguous;
+        }
+        BOOST_REQUIRE(cib.IsFull());
+        BOOST_REQUIRE_EQUAL(cib.NumInBuffer(), SIZE_CB - 1);
+        BOOST_REQUIRE_EQUAL(totalWritten, (iteration == 0) ? (SIZE_CB - 1) : ((iteration % 3) + 1));
+
+        //read back only some of them so that the start index moves around the ring
+        const unsigned int numToLeave = SIZE_CB - 1 - ((iteration + 1) % 3) - 1;
+        while (cib.NumInBuffer() > numToLeave) {
+            unsigned int numContiguous = 0;
+            const unsigned int readIndex = cib.GetContiguousIndicesForRead(numContiguous);
+            BOOST_REQUIRE(readIndex != CIRCULAR_INDEX_BUFFER_EMPTY);
+            BOOST_REQUIRE_LE(readIndex + numContiguous, SIZE_CB); //never wraps
+            const unsigned int numToRead = std::min(numContiguous, cib.NumInBuffer() - numToLeave);
+            for (unsigned int i = 0; i < numToRead; ++i) {
+                BOOST_REQUIRE_EQUAL(cbData[readIndex + i], nextValueToRead++);
+            }
+            cib.CommitReads(numToRead);
+        }
+        BOOST_REQUIRE_EQUAL(cib.NumInBuffer(), numToLeave);
+    }
+
+    //drain
+    while (true) {
+        unsigned int numContiguous = 0;
+        const unsigned int readIndex = cib.GetContiguousIndicesForRead(numContiguous);
+        if (readIndex == CIRCULAR_INDEX_BUFFER_EMPTY) {
+            BOOST_REQUIRE_EQUAL(numContiguous, 0);
+            break;
+        }
+        for (unsigned int i = 0; i < numContiguous; ++i) {
+            BOOST_REQUIRE_EQUAL(cbData[readIndex + i], nextValueToRead++);
+        }
+        cib.CommitReads(numContiguous);
+    }
+    BOOST_REQUIRE(cib.IsEmpty());
+    BOOST_REQUIRE_EQUAL(nextValueToRead, nextValueToWrite);
+}
+
+static void BlockingProducerThreadFunc(CircularIndexBufferSingleProducerSingleConsumerConfigurable * cib,
+    std::vector<uint64_t> * cbData, const uint64_t numValues)
+{
+    for (uint64_t value = 0; value < numValues; ++value) {
+        unsigned int writeIndex;
+        while ((writeIndex = cib->GetIndexForWrite()) == CIRCULAR_INDEX_BUFFER_FULL) {
+            if (!cib->WaitUntilNotFull()) {
+                return;
+            }
+        }
+        (*cbData)[writeIndex] = value;
+        cib->CommitWrite();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CircularIndexBufferBlockingWait_TestCase)
+{
+    static const unsigned int SIZE_CB = 16;
+    static const uint64_t NUM_VALUES = 200000;
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable cib(SIZE_CB, true);
+    std::vector<uint64_t> cbData(SIZE_CB);
+    {
+        boost::thread producerThread(boost::bind(&BlockingProducerThreadFunc, &cib, &cbData, NUM_VALUES));
+        uint64_t sum = 0;
+        for (uint64_t expectedValue = 0; expectedValue < NUM_VALUES; ++expectedValue) {
+            unsigned int readIndex;
+            while ((readIndex = cib.GetIndexForRead()) == CIRCULAR_INDEX_BUFFER_EMPTY) {
+                BOOST_REQUIRE(cib.WaitUntilNotEmpty());
+            }
+            BOOST_REQUIRE_EQUAL(cbData[readIndex], expectedValue);
+            sum += cbData[readIndex];
+            cib.CommitRead();
+        }
+        producerThread.join();
+        BOOST_REQUIRE_EQUAL(sum, (NUM_VALUES * (NUM_VALUES - 1)) / 2);
+        BOOST_REQUIRE(cib.IsEmpty());
+    }
+
+    //StopWaiting() releases a blocked consumer
+    {
+        boost::thread stopThread([&cib]() {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+            cib.StopWaiting();
+        });
+        BOOST_REQUIRE(!cib.WaitUntilNotEmpty());
+        stopThread.join();
+        BOOST_REQUIRE(!cib.WaitUntilNotEmpty()); //stays stopped until Init()
+    }
+
+    //StopWaiting() releases a blocked producer
+    {
+        cib.Init();
+        while (cib.GetIndexForWrite() != CIRCULAR_INDEX_BUFFER_FULL) {
+            cib.CommitWrite();
+        }
+        boost::thread producerThread(boost::bind(&BlockingProducerThreadFunc, &cib, &cbData, 1));
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        cib.StopWaiting();
+        producerThread.join();
+        BOOST_REQUIRE(cib.IsFull());
+    }
+}
+
+struct PingPongLatencyHelper {
+    PingPongLatencyHelper(const bool blocking) :
+        m_requests(4, blocking), m_responses(4, blocking), m_blocking(blocking) {}
+    void WaitRead(CircularIndexBufferSingleProducerSingleConsumerConfigurable & cib, unsigned int & readIndex) {
+        while ((readIndex = cib.GetIndexForRead()) == CIRCULAR_INDEX_BUFFER_EMPTY) {
+            if (m_blocking) {
+                cib.WaitUntilNotEmpty();
+            }
+            else {
+                boost::this_thread::yield(); //don't starve the other thread on a single core machine
+            }
+        }
+    }
+    void EchoThreadFunc(const uint64_t numRoundTrips) {
+        for (uint64_t i = 0; i < numRoundTrips; ++i) {
+            unsigned int readIndex;
+            WaitRead(m_requests, readIndex);
+            const uint64_t value = m_requestData[readIndex];
+            m_requests.CommitRead();
+            const unsigned int writeIndex = m_responses.GetIndexForWrite(); //never full in ping pong
+            m_responseData[writeIndex] = value;
+            m_responses.CommitWrite();
+        }
+    }
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_requests;
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_responses;
+    uint64_t m_requestData[4];
+    uint64_t m_responseData[4];
+    const bool m_blocking;
+};
+
+BOOST_AUTO_TEST_CASE(CircularIndexBufferLatencySpeed_TestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_ROUND_TRIPS = 200000;
+    for (unsigned int blocking = 0; blocking < 2; ++blocking) {
+        PingPongLatencyHelper helper(blocking != 0);
+        boost::thread echoThread(boost::bind(&PingPongLatencyHelper::EchoThreadFunc, &helper, NUM_ROUND_TRIPS));
+        boost::timer::cpu_timer timer;
+        for (uint64_t i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            const unsigned int writeIndex = helper.m_requests.GetIndexForWrite();
+            helper.m_requestData[writeIndex] = i;
+            helper.m_requests.CommitWrite();
+            unsigned int readIndex;
+            helper.WaitRead(helper.m_responses, readIndex);
+            BOOST_REQUIRE_EQUAL(helper.m_responseData[readIndex], i);
+            helper.m_responses.CommitRead();
+        }
+        const boost::timer::nanosecond_type elapsedNs = timer.elapsed().wall;
+        echoThread.join();
+        std::cout << ((blocking) ? "blocking wait" : "spin/yield wait") << ": " << NUM_ROUND_TRIPS << " round trips, "
+            << (elapsedNs / NUM_ROUND_TRIPS) << " ns per round trip\n";
+    }
+}
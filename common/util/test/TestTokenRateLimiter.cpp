@@ -95,3 +95,33 @@ BOOST_AUTO_TEST_CASE(TokenRateLimiterHighRate)
     BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), i64_1e8);
     BOOST_REQUIRE(limiter.HasFullBucketOfTokens());
 }
+
+BOOST_AUTO_TEST_CASE(TokenRateLimiterChangeRateKeepingRemainingTokens)
+{
+    TokenRateLimiter limiter;
+    limiter.SetRate(
+        50,
+        boost::posix_time::seconds(1),
+        boost::posix_time::milliseconds(100)
+    );
+    BOOST_REQUIRE(limiter.TakeTokens(3));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), 2);
+
+    // a higher rate doesn't refill the bucket
+    limiter.SetRateKeepingRemainingTokens(100, boost::posix_time::seconds(1), boost::posix_time::milliseconds(100));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), 2);
+    limiter.AddTime(boost::posix_time::milliseconds(10));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), 3);
+
+    // a lower rate clamps to the smaller burst limit
+    limiter.SetRateKeepingRemainingTokens(20, boost::posix_time::seconds(1), boost::posix_time::milliseconds(100));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), 2);
+    BOOST_REQUIRE(limiter.HasFullBucketOfTokens());
+
+    // borrowed tokens stay borrowed
+    BOOST_REQUIRE(limiter.TakeTokens(5));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), -3);
+    limiter.SetRateKeepingRemainingTokens(1000, boost::posix_time::seconds(1), boost::posix_time::milliseconds(100));
+    BOOST_REQUIRE_EQUAL(limiter.GetRemainingTokens(), -3);
+    BOOST_REQUIRE(!limiter.CanTakeTokens());
+}
@@ -16,6 +16,7 @@
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "Logger.h"
 #include "Telemetry.h"
+#include "MetricsRegistry.h"
 #include "egress_async_lib_export.h"
 
 #define HEGR_NAME_SZ (32)
@@ -8,10 +8,15 @@
 #include <string.h>
 
 #include "EgressAsync.h"
+#include "AsyncLogger.h"
 #include <boost/lexical_cast.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/make_unique.hpp>
 #include "Uri.h"
+#include "codec/BundleViewV7.h"
+#include "codec/Bpv7Fragmentation.h"
+#include <boost/next_prior.hpp>
+#include <list>
 
 #include "SignalHandler.h"
 #include <fstream>
@@ -192,7 +197,7 @@ void hdtn::HegrManagerAsync::OnSuccessfulBundleAck(uint64_t outductUuidIndex) {
             m_needToSendSignal = false;
             ++m_totalEgressInprocSignalsSent;
             if (!m_zmqPushSignalInprocSockPtr->send(signalByteConstBuf, zmq::send_flags::dontwait)) {
-                std::cout << "error in hdtn::HegrManagerAsync::OnSuccessfulBundleAck: unable to send signal\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in hdtn::HegrManagerAsync::OnSuccessfulBundleAck: unable to send signal");
             }
         }
         m_mutexPushSignal.unlock();
@@ -205,6 +210,45 @@ static void CustomCleanupEgressAckHdrNoHint(void *data, void *hint) {
     delete static_cast<hdtn::EgressAckHdr *>(data);
 }
 
+typedef std::queue<std::unique_ptr<hdtn::EgressAckHdr> > egress_need_acks_queue_t;
+
+//a bundle fragment (or a whole bundle queued behind fragments) waiting for room in its outduct's bundle pipeline
+struct held_bundle_t {
+    std::vector<uint8_t> bundle;
+    std::unique_ptr<hdtn::EgressAckHdr> egressAckPtr; //NULL for all but the last fragment of a bundle
+    bool isFragment;
+};
+
+//Forwards held bundles, oldest first, while the outduct's pipeline has room.
+//A bundle's ack queue entry is pushed only once it has actually been forwarded,
+//so a bundle is never acked while any of its fragments are still held.
+static void ForwardHeldBundles(Outduct * outduct, std::list<held_bundle_t> & heldBundles, egress_need_acks_queue_t & needAcksQueue, MetricCounter & metricFragmentsForwarded) {
+    while ((!heldBundles.empty()) && (outduct->GetTotalDataSegmentsUnacked() < outduct->GetOutductMaxBundlesInPipeline())) {
+        held_bundle_t & held = heldBundles.front();
+        if (!outduct->Forward(held.bundle)) {
+            if (!held.bundle.empty()) { //not consumed, try again once the outduct acks something
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress ReadZmqThreadFunc: outduct could not forward a held bundle, will retry");
+                return;
+            }
+            //consumed by the failed forward: drop the rest of this bundle (including its ack) so that it is never acked
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress ReadZmqThreadFunc: outduct could not forward a bundle fragment, the bundle will not be acked");
+            while (!heldBundles.empty()) {
+                const bool wasLastOfBundle = static_cast<bool>(heldBundles.front().egressAckPtr);
+                heldBundles.pop_front();
+                if (wasLastOfBundle) {
+                    break;
+                }
+            }
+            continue;
+        }
+        needAcksQueue.push(std::move(held.egressAckPtr));
+        if (held.isFragment) {
+            metricFragmentsForwarded.Increment();
+        }
+        heldBundles.pop_front();
+    }
+}
+
 void hdtn::HegrManagerAsync::RouterEventHandler() {
     zmq::message_t message;
     if (!m_zmqSubSock_boundRouterToConnectingEgressPtr->recv(message, zmq::recv_flags::none)) {
@@ -255,12 +299,21 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
     char junkChar;
     const zmq::mutable_buffer signalRxBufferJunk(&junkChar, sizeof(junkChar));
 
-    typedef std::queue<std::unique_ptr<hdtn::EgressAckHdr> > queue_t;
+    typedef egress_need_acks_queue_t queue_t;
     typedef std::map<uint64_t, queue_t> outductuuid_needacksqueue_map_t;
+    typedef std::map<uint64_t, std::list<held_bundle_t> > outductuuid_heldbundles_map_t;
 
     outductuuid_needacksqueue_map_t outductUuidToNeedAcksQueueMap;
+    outductuuid_heldbundles_map_t outductUuidToHeldBundlesMap; //bundles (mostly fragments) waiting for room in the outduct pipeline
     std::set<uint64_t> availableDestOpportunisticNodeIdsSet;
 
+    MetricsRegistry & metricsRegistry = MetricsRegistry::GetInstance();
+    MetricCounter & metricBundlesForwarded = metricsRegistry.GetOrCreateCounter("egress.bundlesForwarded");
+    MetricCounter & metricBundlesFragmented = metricsRegistry.GetOrCreateCounter("egress.bundlesFragmented");
+    MetricCounter & metricFragmentsForwarded = metricsRegistry.GetOrCreateCounter("egress.fragmentsForwarded");
+    std::list<std::vector<uint8_t> > fragments;
+    std::vector<MetricGauge*> metricOutductUnackedGauges; //indexed by outduct uuid, created on first use
+
     // Use a form of receive that times out so we can terminate cleanly.
     static const int timeout = 250;  // milliseconds
     static constexpr unsigned int NUM_SOCKETS = 5;
@@ -300,38 +353,34 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                 hdtn::ToEgressHdr toEgressHeader;
                 const zmq::recv_buffer_result_t res = firstTwoSockets[itemIndex]->recv(zmq::mutable_buffer(&toEgressHeader, sizeof(hdtn::ToEgressHdr)), zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr" << std::endl;
-                    hdtn::Logger::getInstance()->logError("egress", "Error in HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr");
                     continue;
                 }
                 else if ((res->truncated()) || (res->size != sizeof(hdtn::ToEgressHdr))) {
-                    std::cerr << "egress blockhdr message mismatch: untruncated = " << res->untruncated_size 
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::ToEgressHdr) << std::endl;
-                    hdtn::Logger::getInstance()->logError("egress", "Egress blockhdr message mismatch: untruncated = " + 
-                        std::to_string(res->untruncated_size) +  " truncated = " + std::to_string(res->size) + " expected = " + 
-                        std::to_string(sizeof(hdtn::ToEgressHdr)));
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "egress blockhdr message mismatch: untruncated = {} truncated = {} expected = {}",
+                        res->untruncated_size, res->size, sizeof(hdtn::ToEgressHdr));
                     continue;
                 }
                 else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK)) {
-                    std::cout << "egress adding opportunistic link " << toEgressHeader.finalDestEid.nodeId << std::endl;
+                    HDTN_LOG_INFO("egress", "egress adding opportunistic link {}", toEgressHeader.finalDestEid.nodeId);
                     availableDestOpportunisticNodeIdsSet.insert(toEgressHeader.finalDestEid.nodeId);
                     continue;
                 }
                 else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK)) {
-                    std::cout << "egress removing opportunistic link " << toEgressHeader.finalDestEid.nodeId << std::endl;
+                    HDTN_LOG_INFO("egress", "egress removing opportunistic link {}", toEgressHeader.finalDestEid.nodeId);
                     availableDestOpportunisticNodeIdsSet.erase(toEgressHeader.finalDestEid.nodeId);
                     continue;
                 }
                 else if (toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS) {
-                    std::cerr << "error: toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS");
                     continue;
                 }
                 else if ((itemIndex == 1) && (toEgressHeader.isCutThroughFromIngress)) {
-                    std::cerr << "error: received on storage socket but cut through flag set\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: received on storage socket but cut through flag set");
                     continue;
                 }
                 else if ((itemIndex == 0) && (!toEgressHeader.isCutThroughFromIngress)) {
-                    std::cerr << "error: received on ingress socket but cut through flag not set\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: received on ingress socket but cut through flag not set");
                     continue;
                 }
                 ++m_messageCount;
@@ -340,7 +389,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                 zmq::message_t zmqMessageBundle;
                 //message guaranteed to be there due to the zmq::send_flags::sndmore
                 if (!firstTwoSockets[itemIndex]->recv(zmqMessageBundle, zmq::recv_flags::none)) {
-                    std::cerr << "error on sockets[itemIndex]->recv\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error on sockets[itemIndex]->recv");
                     continue;
                 }
                        
@@ -361,8 +410,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
 
                     zmq::message_t messageWithDataStolen(egressAckPtr, sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //storage can be acked right away since bundle transferred
                     if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                        std::cout << "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send" << std::endl;
-                        hdtn::Logger::getInstance()->logError("egress", "Error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
                         break;
                     }
                     ++totalCustodyTransfersSentToStorage;
@@ -371,10 +419,10 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     static const char messageFlags = 0; //0 => from storage and needs no processing
                     static const zmq::const_buffer messageFlagsConstBuf(&messageFlags, sizeof(messageFlags));
                     if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(messageFlagsConstBuf, zmq::send_flags::sndmore)) { //blocks if above 5 high water mark
-                        std::cout << "error in egress WholeBundleReadyCallback: zmq could not send messageFlagsConstBuf to ingress" << std::endl;
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress ReadZmqThreadFunc: zmq could not send messageFlagsConstBuf to ingress");
                     }
                     if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(std::move(zmqMessageBundle), zmq::send_flags::none)) { //blocks if above 5 high water mark
-                        std::cout << "error in egress WholeBundleReadyCallback: zmq could not forward bundle to ingress" << std::endl;
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress ReadZmqThreadFunc: zmq could not forward bundle to ingress");
                     }
                 }
                 else if (Outduct * outduct = m_outductManager.GetOutductByFinalDestinationEid_ThreadSafe(finalDestEid)) {
@@ -389,16 +437,56 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     egressAckPtr->isToStorage = !toEgressHeader.isCutThroughFromIngress;
                     egressAckPtr->custodyId = toEgressHeader.custodyId;
                     //std::cout << "*****Egress Outduct: " << static_cast<int>(outduct->GetOutductUuid()) << std::endl;
-                    outductUuidToNeedAcksQueueMap[outduct->GetOutductUuid()].push(std::move(egressAckPtr));
-                    outduct->Forward(zmqMessageBundle);
-                    if (zmqMessageBundle.size() != 0) {
-                        std::cout << "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved" << std::endl;
-                        hdtn::Logger::getInstance()->logError("egress", "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved");
+                    queue_t & needAcksQueue = outductUuidToNeedAcksQueueMap[outduct->GetOutductUuid()];
+                    std::list<held_bundle_t> & heldBundles = outductUuidToHeldBundlesMap[outduct->GetOutductUuid()];
+                    fragments.clear();
+                    const uint64_t maxBundleSizeBytes = outduct->GetBpv7FragmentationMaxBundleSizeBytes();
+                    if (maxBundleSizeBytes && (zmqMessageBundle.size() > maxBundleSizeBytes)
+                        && ((*static_cast<const uint8_t*>(zmqMessageBundle.data())) == ((4U << 5) | 31U))) //bpv7 (cbor indefinite array), bpv6 bundles are forwarded whole
+                    {
+                        BundleViewV7 bv;
+                        if (bv.LoadBundle(static_cast<uint8_t*>(zmqMessageBundle.data()), zmqMessageBundle.size(), true) && Bpv7Fragmenter::IsFragmentable(bv)) {
+                            if (!Bpv7Fragmenter::Fragment(bv, maxBundleSizeBytes, fragments)) {
+                                HDTN_LOG_WARNING_RATE_LIMITED(10, "egress", "egress unable to fragment a bundle of size {} to outduct max bundle size {}, forwarding it whole",
+                                    zmqMessageBundle.size(), maxBundleSizeBytes);
+                            }
+                        }
                     }
+                    if (fragments.empty() && heldBundles.empty()) {
+                        needAcksQueue.push(std::move(egressAckPtr));
+                        outduct->Forward(zmqMessageBundle);
+                        if (zmqMessageBundle.size() != 0) {
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved");
+                        }
+                    }
+                    else if (fragments.empty()) { //keep the outduct's forwarding (and ack) order behind the held fragments
+                        heldBundles.emplace_back();
+                        const uint8_t * const bundleData = static_cast<const uint8_t*>(zmqMessageBundle.data());
+                        heldBundles.back().bundle.assign(bundleData, bundleData + zmqMessageBundle.size());
+                        heldBundles.back().egressAckPtr = std::move(egressAckPtr);
+                        heldBundles.back().isFragment = false;
+                        ForwardHeldBundles(outduct, heldBundles, needAcksQueue, metricFragmentsForwarded);
+                    }
+                    else {
+                        //A bundle may fragment into more pieces than the outduct's bundle pipeline holds, so the fragments
+                        //are held and forwarded as room becomes available.  The outduct acks each fragment in order,
+                        //so only the last fragment carries the bundle's ack and the others hold a NULL place in the queue.
+                        metricBundlesFragmented.Increment();
+                        for (std::list<std::vector<uint8_t> >::iterator fragmentIt = fragments.begin(); fragmentIt != fragments.end(); ++fragmentIt) {
+                            heldBundles.emplace_back();
+                            heldBundles.back().bundle.swap(*fragmentIt);
+                            if (boost::next(fragmentIt) == fragments.end()) {
+                                heldBundles.back().egressAckPtr = std::move(egressAckPtr);
+                            }
+                            heldBundles.back().isFragment = true;
+                        }
+                        ForwardHeldBundles(outduct, heldBundles, needAcksQueue, metricFragmentsForwarded);
+                    }
+                    metricBundlesForwarded.Increment();
                 }
                 else {
-                    std::cerr << "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: no outduct for " 
-                        << Uri::GetIpnUriString(finalDestEid.nodeId, finalDestEid.serviceId) << std::endl;
+                    HDTN_LOG_CRITICAL("egress", "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: no outduct for ipn:{}.{}",
+                        finalDestEid.nodeId, finalDestEid.serviceId);
                 }
 
             }
@@ -410,11 +498,11 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
             if ((items[3].revents & ZMQ_POLLIN)) { //m_zmqPullSignalInprocSockPtr                
                 const zmq::recv_buffer_result_t res = m_zmqPullSignalInprocSockPtr->recv(signalRxBufferJunk, zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal not received" << std::endl;
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in HegrManagerAsync::ReadZmqThreadFunc: signal not received");
                 }
                 else if ((res->truncated()) || (res->size != sizeof(junkChar))) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(junkChar) << std::endl;
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in HegrManagerAsync::ReadZmqThreadFunc: signal message mismatch: untruncated = {} truncated = {} expected = {}",
+                        res->untruncated_size, res->size, sizeof(junkChar));
                 }
                 else {
                     ++totalEgressInprocSignalsReceived;
@@ -433,7 +521,14 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     std::cerr << "guiMsgByte message mismatch: untruncated = " << res->untruncated_size
                         << " truncated = " << res->size << " expected = " << sizeof(guiMsgByte) << std::endl;
                 }
-                else if (guiMsgByte != 1) {
+                else if (guiMsgByte == TELEMETRY_GUI_REQUEST_METRICS_SNAPSHOT) {
+                    static const std::vector<std::string> metricsNamePrefixes = { "egress.", "ltp.send" }; //ltp outducts live in egress
+                    const std::string metricsJson = MetricsRegistry::GetInstance().GetSnapshot(metricsNamePrefixes).ToJson();
+                    if (!m_zmqRepSock_connectingGuiToFromBoundEgressPtr->send(zmq::const_buffer(metricsJson.data(), metricsJson.size()), zmq::send_flags::dontwait)) {
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "egress", "egress can't send metrics snapshot to gui");
+                    }
+                }
+                else if (guiMsgByte != TELEMETRY_GUI_REQUEST_TELEMETRY) {
                     std::cerr << "error guiMsgByte not 1\n";
                 }
                 else {
@@ -444,7 +539,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     telem.egressBundleData = static_cast<double>(m_bundleData/1000);
                     telem.egressMessageCount = m_messageCount;
                     if (!m_zmqRepSock_connectingGuiToFromBoundEgressPtr->send(zmq::const_buffer(&telem, sizeof(telem)), zmq::send_flags::dontwait)) {
-                        std::cerr << "egress can't send telemetry to gui" << std::endl;
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "egress", "egress can't send telemetry to gui");
                     }
                 }
             }
@@ -459,9 +554,24 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
             //const unsigned int fec = 1; //TODO
             queue_t & q = it->second;
             if (Outduct * outduct = m_outductManager.GetOutductByOutductUuid(outductUuid)) {
+                outductuuid_heldbundles_map_t::iterator heldIt = outductUuidToHeldBundlesMap.find(outductUuid);
+                if (heldIt != outductUuidToHeldBundlesMap.end()) {
+                    ForwardHeldBundles(outduct, heldIt->second, q, metricFragmentsForwarded);
+                }
                 const std::size_t numAckedRemaining = outduct->GetTotalDataSegmentsUnacked();
+                if (outductUuid >= metricOutductUnackedGauges.size()) {
+                    metricOutductUnackedGauges.resize(outductUuid + 1, NULL);
+                }
+                if (metricOutductUnackedGauges[outductUuid] == NULL) {
+                    metricOutductUnackedGauges[outductUuid] = &metricsRegistry.GetOrCreateGauge("egress.outduct" + boost::lexical_cast<std::string>(outductUuid) + ".unacked");
+                }
+                metricOutductUnackedGauges[outductUuid]->Set(static_cast<int64_t>(numAckedRemaining));
                 while (q.size() > numAckedRemaining) {
                     std::unique_ptr<hdtn::EgressAckHdr> & qItem = q.front();
+                    if (!qItem) { //fragment whose ack is carried by the bundle's last fragment
+                        q.pop();
+                        continue;
+                    }
                     const bool isToStorage = qItem->isToStorage;
                     //this is an optimization because we only have one chunk to send
                     //The zmq_msg_init_data() function shall initialise the message object referenced by msg
@@ -472,8 +582,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     zmq::message_t messageWithDataStolen(qItem.release(), sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //unique_ptr goes "null" with release()
                     if (isToStorage) {
                         if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                            std::cout << "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send" << std::endl;
-                            hdtn::Logger::getInstance()->logError("egress", "Error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
                             break;
                         }
                         ++totalCustodyTransfersSentToStorage;
@@ -481,8 +590,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     else {
                         //send ack message by echoing back the block
                         if (!m_zmqPushSock_connectingEgressToBoundIngressPtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                            std::cout << "error: zmq could not send ingress an ack from egress" << std::endl;
-                            hdtn::Logger::getInstance()->logError("egress", "Error: zmq could not send ingress an ack from egress");
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error: zmq could not send ingress an ack from egress");
                             break;
                         }
                         ++totalCustodyTransfersSentToIngress;
@@ -491,7 +599,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                 }
             }
             else {
-                std::cerr << "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: cannot find outductUuid " << outductUuid << std::endl;
+                HDTN_LOG_CRITICAL("egress", "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: cannot find outductUuid {}", outductUuid);
             }
         }
     }
@@ -534,9 +642,9 @@ void hdtn::HegrManagerAsync::WholeBundleReadyCallback(padded_vector_uint8_t & wh
         rxBufRawPointer->size() + rxBufRawPointer->get_allocator().TOTAL_PADDING_ELEMENTS, CustomCleanupPaddedVecUint8, rxBufRawPointer);
     boost::mutex::scoped_lock lock(m_mutexPushBundleToIngress);
     if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(messageFlagsConstBuf, zmq::send_flags::sndmore)) { //blocks if above 5 high water mark
-        std::cout << "error in egress WholeBundleReadyCallback: zmq could not send messageFlagsConstBuf to ingress" << std::endl;
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress WholeBundleReadyCallback: zmq could not send messageFlagsConstBuf to ingress");
     }
     if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(std::move(paddedMessageWithDataStolen), zmq::send_flags::none)) { //blocks if above 5 high water mark
-        std::cout << "error in egress WholeBundleReadyCallback: zmq could not forward bundle to ingress" << std::endl;
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "egress", "error in egress WholeBundleReadyCallback: zmq could not forward bundle to ingress");
     }
 }
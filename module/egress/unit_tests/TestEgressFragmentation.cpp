@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+#include "EgressAsync.h"
+#include "codec/BundleViewV7.h"
+#include "codec/Bpv7Fragmentation.h"
+#include <boost/make_unique.hpp>
+
+//a bpv7 bundle from storage that egress fragments into many more pieces than the outduct's bundle pipeline limit
+//must arrive whole (every fragment forwarded) and be acked to storage exactly once, after its last fragment
+BOOST_AUTO_TEST_CASE(EgressFragmentationExceedsPipelineLimitTestCase)
+{
+    static const uint16_t UDP_SINK_PORT = 4593;
+    static const uint64_t MAX_FRAGMENT_SIZE = 1200;
+    static const uint64_t CUSTODY_ID = 77;
+    static const std::size_t PAYLOAD_SIZE = 30000;
+
+    HdtnConfig hdtnConfig;
+    hdtnConfig.m_myNodeId = 100;
+    hdtnConfig.m_maxBundleSizeBytes = 10000000;
+    outduct_element_config_t outductConfig;
+    outductConfig.name = "fragmenting udp";
+    outductConfig.convergenceLayer = "udp";
+    outductConfig.nextHopEndpointId = "ipn:200.0";
+    outductConfig.remoteHostname = "localhost";
+    outductConfig.remotePort = UDP_SINK_PORT;
+    outductConfig.bundlePipelineLimit = 2;
+    outductConfig.bpv7FragmentationMaxBundleSizeBytesOrZeroToDisable = MAX_FRAGMENT_SIZE;
+    outductConfig.finalDestinationEidUris.insert("ipn:200.2");
+    outductConfig.udpRateBps = 2000000; //a slow link keeps the pipeline full
+    hdtnConfig.m_outductsConfig.m_outductElementConfigVector.push_back(outductConfig);
+
+    boost::asio::io_service ioService;
+    boost::asio::ip::udp::socket udpSinkSocket(ioService, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), UDP_SINK_PORT));
+
+    std::string payload(PAYLOAD_SIZE, 0);
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + (i % 26));
+    }
+    BundleViewV7 bv;
+    {
+        Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+        primary.SetZero();
+        primary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::NO_FLAGS_SET;
+        primary.m_sourceNodeId.Set(100, 1);
+        primary.m_destinationEid.Set(200, 2);
+        primary.m_reportToEid.Set(0, 0);
+        primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = 10000;
+        primary.m_lifetimeMilliseconds = 1000000;
+        primary.m_creationTimestamp.sequenceNumber = 1;
+        primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+        bv.m_primaryBlockView.SetManuallyModified();
+        std::unique_ptr<Bpv7CanonicalBlock> payloadBlockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+        payloadBlockPtr->m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+        payloadBlockPtr->m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+        payloadBlockPtr->m_blockNumber = 1;
+        payloadBlockPtr->m_crcType = BPV7_CRC_TYPE::CRC32C;
+        payloadBlockPtr->m_dataLength = payload.size();
+        payloadBlockPtr->m_dataPtr = (uint8_t*)payload.data();
+        bv.AppendMoveCanonicalBlock(payloadBlockPtr);
+        BOOST_REQUIRE(bv.Render(payload.size() + 500));
+    }
+    const std::vector<uint8_t> originalBundle(bv.m_frontBuffer);
+
+    zmq::context_t zmqInprocContext(0);
+    hdtn::HegrManagerAsync egress;
+    egress.Init(hdtnConfig, &zmqInprocContext);
+    zmq::socket_t storageToEgressSock(zmqInprocContext, zmq::socket_type::pair);
+    storageToEgressSock.connect(std::string("inproc://connecting_storage_to_bound_egress"));
+    zmq::socket_t egressToStorageSock(zmqInprocContext, zmq::socket_type::pair);
+    egressToStorageSock.connect(std::string("inproc://bound_egress_to_connecting_storage"));
+
+    hdtn::ToEgressHdr toEgressHeader;
+    memset(&toEgressHeader, 0, sizeof(toEgressHeader));
+    toEgressHeader.base.type = HDTN_MSGTYPE_EGRESS;
+    toEgressHeader.hasCustody = 1;
+    toEgressHeader.isCutThroughFromIngress = 0;
+    toEgressHeader.finalDestEid.Set(200, 2);
+    toEgressHeader.custodyId = CUSTODY_ID;
+    BOOST_REQUIRE(storageToEgressSock.send(zmq::const_buffer(&toEgressHeader, sizeof(toEgressHeader)), zmq::send_flags::sndmore));
+    BOOST_REQUIRE(storageToEgressSock.send(zmq::const_buffer(originalBundle.data(), originalBundle.size()), zmq::send_flags::none));
+
+    //The bundle must not be acked until every fragment has been sent.  The udp outduct acks a fragment once its send completes,
+    //so by the time the bundle's ack arrives every fragment must already be waiting on the loopback sink socket.
+    Bpv7FragmentReassembler reassembler;
+    std::vector<uint8_t> reassembledBundle;
+    bool isComplete = false;
+    bool ackReceived = false;
+    std::size_t numFragmentsReceived = 0;
+    std::vector<uint8_t> udpRxBuffer(65536);
+    const boost::posix_time::ptime timeoutTime = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(10);
+    zmq::pollitem_t ackPollItem = { egressToStorageSock.handle(), 0, ZMQ_POLLIN, 0 };
+    while ((!isComplete) && (boost::posix_time::microsec_clock::universal_time() < timeoutTime)) {
+        if (udpSinkSocket.available() == 0) {
+            BOOST_REQUIRE(!ackReceived); //acked with fragments never sent
+            ackReceived = (zmq::poll(&ackPollItem, 1, 0) == 1);
+            if (!ackReceived) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+            }
+            continue;
+        }
+        const std::size_t size = udpSinkSocket.receive(boost::asio::buffer(udpRxBuffer));
+        BOOST_REQUIRE_LE(size, MAX_FRAGMENT_SIZE);
+        BundleViewV7 fragmentBv;
+        BOOST_REQUIRE(fragmentBv.CopyAndLoadBundle(udpRxBuffer.data(), size));
+        BOOST_REQUIRE(reassembler.AddFragment(fragmentBv, isComplete, reassembledBundle));
+        ++numFragmentsReceived;
+    }
+    BOOST_REQUIRE(isComplete);
+    BOOST_REQUIRE_GT(numFragmentsReceived, 2 * (outductConfig.bundlePipelineLimit + 5)); //well beyond what the udp bundle source can hold
+    BOOST_REQUIRE(reassembledBundle == originalBundle);
+
+    hdtn::EgressAckHdr egressAck;
+    ackPollItem.revents = 0;
+    BOOST_REQUIRE_EQUAL(zmq::poll(&ackPollItem, 1, 2000), 1);
+    const zmq::recv_buffer_result_t res = egressToStorageSock.recv(zmq::mutable_buffer(&egressAck, sizeof(egressAck)), zmq::recv_flags::none);
+    BOOST_REQUIRE(res);
+    BOOST_REQUIRE_EQUAL(res->size, sizeof(egressAck));
+    BOOST_REQUIRE_EQUAL(egressAck.base.type, HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE);
+    BOOST_REQUIRE_EQUAL(egressAck.custodyId, CUSTODY_ID);
+    ackPollItem.revents = 0;
+    BOOST_REQUIRE_EQUAL(zmq::poll(&ackPollItem, 1, 500), 0); //acked exactly once
+
+    storageToEgressSock.set(zmq::sockopt::linger, 0);
+    egressToStorageSock.set(zmq::sockopt::linger, 0);
+    egress.Stop();
+}
@@ -35,6 +35,7 @@ public:
 
 private:
     GUI_LIB_NO_EXPORT void ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInprocContextPtr);
+    GUI_LIB_NO_EXPORT bool ForwardMetricsSnapshotToActiveWebsockets(zmq::socket_t & moduleSocket, const char * moduleName);
     GUI_LIB_NO_EXPORT virtual bool handleConnection(CivetServer *server, const struct mg_connection *conn);
     GUI_LIB_NO_EXPORT virtual void handleReadyState(CivetServer *server, struct mg_connection *conn);
     GUI_LIB_NO_EXPORT virtual bool handleData(CivetServer *server, struct mg_connection *conn, int bits, char *data, size_t data_len);
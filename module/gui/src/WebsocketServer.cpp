@@ -123,6 +123,18 @@ void WebSocketHandler::handleClose(CivetServer *server, const struct mg_connecti
     printf("WS closed\n");
 }
 
+//receives a module's (variable length) JSON metrics snapshot and forwards it to the websockets as text
+bool WebSocketHandler::ForwardMetricsSnapshotToActiveWebsockets(zmq::socket_t & moduleSocket, const char * moduleName) {
+    zmq::message_t metricsJsonMessage;
+    if (!moduleSocket.recv(metricsJsonMessage, zmq::recv_flags::dontwait)) {
+        std::cerr << "error in WebSocketHandler::ReadZmqThreadFunc: cannot read " << moduleName << " metrics snapshot" << std::endl;
+        return false;
+    }
+    const std::string text = std::string("{\"metricsSnapshot\":\"") + moduleName + "\",\"metrics\":" + metricsJsonMessage.to_string() + "}";
+    SendTextDataToActiveWebsockets(text.data(), text.size());
+    return true;
+}
+
 void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
 
     std::unique_ptr<zmq::context_t> zmqCtxPtr;
@@ -133,8 +145,12 @@ void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInpro
     //storage
     std::unique_ptr<zmq::socket_t> zmqReqSock_connectingGuiToFromBoundStoragePtr;
 
-    const uint8_t guiByteSignal = 1;
-    const zmq::const_buffer guiByteSignalBuf(&guiByteSignal, sizeof(guiByteSignal));
+    const uint8_t guiByteSignal = TELEMETRY_GUI_REQUEST_TELEMETRY;
+    const zmq::const_buffer guiByteSignalTelemetryBuf(&guiByteSignal, sizeof(guiByteSignal));
+    const uint8_t guiByteSignalMetrics = TELEMETRY_GUI_REQUEST_METRICS_SNAPSHOT;
+    const zmq::const_buffer guiByteSignalMetricsBuf(&guiByteSignalMetrics, sizeof(guiByteSignalMetrics));
+    static const unsigned int METRICS_SNAPSHOT_EVERY_N_SECONDS = 5; //request a metrics snapshot instead of the telemetry every 5th second
+    unsigned int secondsCount = 0;
     
     try {
         if (hdtnOneProcessZmqInprocContextPtr) {
@@ -211,6 +227,8 @@ void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInpro
             return;
         }
         deadlineTimer.expires_at(deadlineTimer.expires_at() + sleepValTimeDuration);
+        const bool requestMetricsSnapshot = ((++secondsCount % METRICS_SNAPSHOT_EVERY_N_SECONDS) == 0);
+        const zmq::const_buffer & guiByteSignalBuf = (requestMetricsSnapshot) ? guiByteSignalMetricsBuf : guiByteSignalTelemetryBuf;
 
         //std::cout << "loop\n";
         //send signals to all hdtn modules
@@ -256,7 +274,12 @@ void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInpro
                 continue;
             }
             if (rc > 0) {
-                if (items[0].revents & ZMQ_POLLIN) { //ingress telemetry received
+                if ((items[0].revents & ZMQ_POLLIN) && requestMetricsSnapshot) { //ingress metrics snapshot received
+                    if (ForwardMetricsSnapshotToActiveWebsockets(*zmqReqSock_connectingGuiToFromBoundIngressPtr, "ingress")) {
+                        moduleMask |= 0x1;
+                    }
+                }
+                else if (items[0].revents & ZMQ_POLLIN) { //ingress telemetry received
                     IngressTelemetry_t telem;
                     const zmq::recv_buffer_result_t res = zmqReqSock_connectingGuiToFromBoundIngressPtr->recv(zmq::mutable_buffer(&telem, sizeof(telem)), zmq::recv_flags::dontwait);
                     if (!res) {
@@ -284,7 +307,12 @@ void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInpro
                         SendBinaryDataToActiveWebsockets((const char *) &telem, sizeof(telem));
                     }
                 }
-                if (items[1].revents & ZMQ_POLLIN) { //egress telemetry received
+                if ((items[1].revents & ZMQ_POLLIN) && requestMetricsSnapshot) { //egress metrics snapshot received
+                    if (ForwardMetricsSnapshotToActiveWebsockets(*zmqReqSock_connectingGuiToFromBoundEgressPtr, "egress")) {
+                        moduleMask |= 0x2;
+                    }
+                }
+                else if (items[1].revents & ZMQ_POLLIN) { //egress telemetry received
                     EgressTelemetry_t telem;
                     const zmq::recv_buffer_result_t res = zmqReqSock_connectingGuiToFromBoundEgressPtr->recv(zmq::mutable_buffer(&telem, sizeof(telem)), zmq::recv_flags::dontwait);
                     if (!res) {
@@ -300,7 +328,12 @@ void WebSocketHandler::ReadZmqThreadFunc(zmq::context_t * hdtnOneProcessZmqInpro
                         SendBinaryDataToActiveWebsockets((const char *) &telem, sizeof(telem));
                     }
                 }
-                if (items[2].revents & ZMQ_POLLIN) { //storage telemetry received
+                if ((items[2].revents & ZMQ_POLLIN) && requestMetricsSnapshot) { //storage metrics snapshot received
+                    if (ForwardMetricsSnapshotToActiveWebsockets(*zmqReqSock_connectingGuiToFromBoundStoragePtr, "storage")) {
+                        moduleMask |= 0x4;
+                    }
+                }
+                else if (items[2].revents & ZMQ_POLLIN) { //storage telemetry received
                     StorageTelemetry_t telem;
                     const zmq::recv_buffer_result_t res = zmqReqSock_connectingGuiToFromBoundStoragePtr->recv(zmq::mutable_buffer(&telem, sizeof(telem)), zmq::recv_flags::dontwait);
                     if (!res) {
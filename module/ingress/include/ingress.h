@@ -18,6 +18,7 @@
 #include "TcpclInduct.h"
 #include "TcpclV4Induct.h"
 #include "Telemetry.h"
+#include "MetricsRegistry.h"
 #include "ingress_async_lib_export.h"
 
 namespace hdtn {
@@ -48,6 +49,7 @@ private:
     INGRESS_ASYNC_LIB_NO_EXPORT void ReadZmqAcksThreadFunc();
     INGRESS_ASYNC_LIB_NO_EXPORT void ReadTcpclOpportunisticBundlesFromEgressThreadFunc();
     INGRESS_ASYNC_LIB_NO_EXPORT void WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec);
+    INGRESS_ASYNC_LIB_NO_EXPORT void WholePaddedZmqBundleReadyCallback(std::unique_ptr<zmq::message_t> & movablePaddedBundleZmq);
     INGRESS_ASYNC_LIB_NO_EXPORT void OnNewOpportunisticLinkCallback(const uint64_t remoteNodeId, Induct * thisInductPtr);
     INGRESS_ASYNC_LIB_NO_EXPORT void OnDeletedOpportunisticLinkCallback(const uint64_t remoteNodeId);
     INGRESS_ASYNC_LIB_NO_EXPORT void SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable);
@@ -66,16 +68,17 @@ private:
         std::size_t GetQueueSize() {
             return m_ingressToEgressCustodyIdQueue.size();
         }
-        void PushMove_ThreadSafe(const uint64_t ingressToEgressCustody) {
+        void PushMove_ThreadSafe(const uint64_t ingressToEgressCustody, const uint64_t sentTimestampNanoseconds) {
             boost::mutex::scoped_lock lock(m_mutex);
-            m_ingressToEgressCustodyIdQueue.push(ingressToEgressCustody);
+            m_ingressToEgressCustodyIdQueue.emplace(ingressToEgressCustody, sentTimestampNanoseconds);
         }
-        bool CompareAndPop_ThreadSafe(const uint64_t ingressToEgressCustody) {
+        bool CompareAndPop_ThreadSafe(const uint64_t ingressToEgressCustody, uint64_t & sentTimestampNanoseconds) {
             boost::mutex::scoped_lock lock(m_mutex);
             if (m_ingressToEgressCustodyIdQueue.empty()) {
                 return false;
             }
-            else if (m_ingressToEgressCustodyIdQueue.front() == ingressToEgressCustody) {
+            else if (m_ingressToEgressCustodyIdQueue.front().first == ingressToEgressCustody) {
+                sentTimestampNanoseconds = m_ingressToEgressCustodyIdQueue.front().second;
                 m_ingressToEgressCustodyIdQueue.pop();
                 return true;
             }
@@ -90,7 +93,7 @@ private:
         }
         boost::mutex m_mutex;
         boost::condition_variable m_conditionVariable;
-        std::queue<uint64_t> m_ingressToEgressCustodyIdQueue;
+        std::queue<std::pair<uint64_t, uint64_t> > m_ingressToEgressCustodyIdQueue; //custody id, sent timestamp
     };
 
     std::unique_ptr<zmq::context_t> m_zmqCtxPtr;
@@ -114,7 +117,7 @@ private:
     
     std::unique_ptr<boost::thread> m_threadZmqAckReaderPtr;
     std::unique_ptr<boost::thread> m_threadTcpclOpportunisticBundlesFromEgressReaderPtr;
-    std::queue<uint64_t> m_storageAckQueue;
+    std::queue<std::pair<uint64_t, uint64_t> > m_storageAckQueue; //ingress unique id, sent timestamp
     boost::mutex m_storageAckQueueMutex;
     boost::condition_variable m_conditionVariableStorageAckReceived;
     std::map<cbhe_eid_t, EgressToIngressAckingQueue> m_egressAckMapQueue; //final dest id to queue
@@ -132,6 +135,14 @@ private:
 
     std::map<uint64_t, Induct*> m_availableDestOpportunisticNodeIdToTcpclInductMap;
     boost::mutex m_availableDestOpportunisticNodeIdToTcpclInductMapMutex;
+
+    //metrics (see MetricsRegistry.h)
+    MetricCounter & m_metricBundlesReceived;
+    MetricCounter & m_metricBytesReceived;
+    MetricGauge & m_metricStorageAckQueueDepth;
+    MetricGauge & m_metricEgressAckQueueDepth; //sum over all final destinations
+    LatencyHistogram & m_metricIngressToEgressAckLatency;
+    LatencyHistogram & m_metricIngressToStorageAckLatency;
 };
 
 
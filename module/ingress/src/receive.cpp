@@ -10,6 +10,7 @@
 #include "codec/bpv6.h"
 #include "ingress.h"
 #include "Logger.h"
+#include "AsyncLogger.h"
 #include "message.hpp"
 #include <boost/bind/bind.hpp>
 #include <boost/make_unique.hpp>
@@ -30,7 +31,13 @@ Ingress::Ingress() :
     m_eventsTooManyInEgressQueue(0),
     m_running(false),
     m_ingressToEgressNextUniqueIdAtomic(0),
-    m_ingressToStorageNextUniqueId(0)
+    m_ingressToStorageNextUniqueId(0),
+    m_metricBundlesReceived(MetricsRegistry::GetInstance().GetOrCreateCounter("ingress.bundlesReceived")),
+    m_metricBytesReceived(MetricsRegistry::GetInstance().GetOrCreateCounter("ingress.bytesReceived")),
+    m_metricStorageAckQueueDepth(MetricsRegistry::GetInstance().GetOrCreateGauge("ingress.storageAckQueueDepth")),
+    m_metricEgressAckQueueDepth(MetricsRegistry::GetInstance().GetOrCreateGauge("ingress.egressAckQueueDepth")),
+    m_metricIngressToEgressAckLatency(MetricsRegistry::GetInstance().GetOrCreateHistogram("ingress.ingressToEgressAckLatency")),
+    m_metricIngressToStorageAckLatency(MetricsRegistry::GetInstance().GetOrCreateHistogram("ingress.ingressToStorageAckLatency"))
 {
 }
 
@@ -177,7 +184,8 @@ int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest
         m_inductManager.LoadInductsFromConfig(boost::bind(&Ingress::WholeBundleReadyCallback, this, boost::placeholders::_1), m_hdtnConfig.m_inductsConfig,
             m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
             boost::bind(&Ingress::OnNewOpportunisticLinkCallback, this, boost::placeholders::_1, boost::placeholders::_2),
-            boost::bind(&Ingress::OnDeletedOpportunisticLinkCallback, this, boost::placeholders::_1));
+            boost::bind(&Ingress::OnDeletedOpportunisticLinkCallback, this, boost::placeholders::_1),
+            boost::bind(&Ingress::WholePaddedZmqBundleReadyCallback, this, boost::placeholders::_1));
 
         std::cout << "Ingress running, allowing up to " << m_hdtnConfig.m_zmqMaxMessagesPerPath << " max zmq messages per path." << std::endl;
     }
@@ -214,32 +222,28 @@ void Ingress::ReadZmqAcksThreadFunc() {
                 EgressAckHdr receivedEgressAckHdr;
                 const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingEgressToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedEgressAckHdr, sizeof(hdtn::EgressAckHdr)), zmq::recv_flags::dontwait);
                 if (!res) {
-                    std::cerr << "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack");
                 }
                 else if ((res->truncated()) || (res->size != sizeof(hdtn::EgressAckHdr))) {
-                    std::cerr << "egress EgressAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::EgressAckHdr) << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Egress EgressAckHdr message mismatch: untruncated = " + std::to_string(res->untruncated_size)
-                        + " truncated = " + std::to_string(res->size) + " expected = " +
-                        std::to_string(sizeof(hdtn::EgressAckHdr)));
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "egress EgressAckHdr message mismatch: untruncated = {} truncated = {} expected = {}",
+                        res->untruncated_size, res->size, sizeof(hdtn::EgressAckHdr));
                 }
                 else if (receivedEgressAckHdr.base.type != HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS) {
-                    std::cerr << "error message ack not HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error message ack not HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS");
                 }
                 else {
                     m_egressAckMapQueueMutex.lock();
                     EgressToIngressAckingQueue & egressToIngressAckingObj = m_egressAckMapQueue[receivedEgressAckHdr.finalDestEid];
                     m_egressAckMapQueueMutex.unlock();
-                    if (egressToIngressAckingObj.CompareAndPop_ThreadSafe(receivedEgressAckHdr.custodyId)) {
+                    uint64_t sentTimestampNanoseconds;
+                    if (egressToIngressAckingObj.CompareAndPop_ThreadSafe(receivedEgressAckHdr.custodyId, sentTimestampNanoseconds)) {
                         egressToIngressAckingObj.NotifyAll();
+                        m_metricIngressToEgressAckLatency.RecordSince(sentTimestampNanoseconds);
+                        m_metricEgressAckQueueDepth.Add(-1);
                         ++totalAcksFromEgress;
                     }
                     else {
-                        std::cerr << "error didn't receive expected egress ack" << std::endl;
-                        hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected egress ack");
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error didn't receive expected egress ack");
                     }
 
                 }
@@ -248,38 +252,31 @@ void Ingress::ReadZmqAcksThreadFunc() {
                 StorageAckHdr receivedStorageAck;
                 const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingStorageToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedStorageAck, sizeof(hdtn::StorageAckHdr)), zmq::recv_flags::dontwait);
                 if (!res) {
-                    std::cerr << "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack");
-
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack");
                 }
                 else if ((res->truncated()) || (res->size != sizeof(hdtn::StorageAckHdr))) {
-                    std::cerr << "egress StorageAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::StorageAckHdr) << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Egress blockhdr message mismatch: untruncated = " + std::to_string(res->untruncated_size)
-                        + " truncated = " + std::to_string(res->size) + " expected = " +
-                        std::to_string(sizeof(hdtn::StorageAckHdr)));
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "storage StorageAckHdr message mismatch: untruncated = {} truncated = {} expected = {}",
+                        res->untruncated_size, res->size, sizeof(hdtn::StorageAckHdr));
                 }
                 else if (receivedStorageAck.base.type != HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS) {
-                    std::cerr << "error message ack not HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error message ack not HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS");
                 }
                 else {
                     bool needsNotify = false;
                     {
                         boost::mutex::scoped_lock lock(m_storageAckQueueMutex);
                         if (m_storageAckQueue.empty()) {
-                            std::cerr << "error m_storageAckQueue is empty" << std::endl;
-                            hdtn::Logger::getInstance()->logError("ingress", "Error m_storageAckQueue is empty");
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error m_storageAckQueue is empty");
                         }
-                        else if (m_storageAckQueue.front() == receivedStorageAck.ingressUniqueId) {
+                        else if (m_storageAckQueue.front().first == receivedStorageAck.ingressUniqueId) {
+                            m_metricIngressToStorageAckLatency.RecordSince(m_storageAckQueue.front().second);
                             m_storageAckQueue.pop();
+                            m_metricStorageAckQueueDepth.Set(static_cast<int64_t>(m_storageAckQueue.size()));
                             needsNotify = true;
                             ++totalAcksFromStorage;
                         }
                         else {
-                            std::cerr << "error didn't receive expected storage ack" << std::endl;
-                            hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected storage ack");
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error didn't receive expected storage ack");
                         }
                     }
                     if (needsNotify) {
@@ -300,7 +297,14 @@ void Ingress::ReadZmqAcksThreadFunc() {
                     std::cerr << "guiMsgByte message mismatch: untruncated = " << res->untruncated_size
                         << " truncated = " << res->size << " expected = " << sizeof(guiMsgByte) << std::endl;
                 }
-                else if (guiMsgByte != 1) {
+                else if (guiMsgByte == TELEMETRY_GUI_REQUEST_METRICS_SNAPSHOT) {
+                    static const std::vector<std::string> metricsNamePrefixes = { "ingress.", "ltp.receive" }; //ltp inducts live in ingress
+                    const std::string metricsJson = MetricsRegistry::GetInstance().GetSnapshot(metricsNamePrefixes).ToJson();
+                    if (!m_zmqRepSock_connectingGuiToFromBoundIngressPtr->send(zmq::const_buffer(metricsJson.data(), metricsJson.size()), zmq::send_flags::dontwait)) {
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "ingress", "ingress can't send metrics snapshot to gui");
+                    }
+                }
+                else if (guiMsgByte != TELEMETRY_GUI_REQUEST_TELEMETRY) {
                     std::cerr << "error guiMsgByte not 1\n";
                 }
                 else {
@@ -311,7 +315,7 @@ void Ingress::ReadZmqAcksThreadFunc() {
                     telem.bundleCountEgress = m_bundleCountEgress;
                     telem.bundleCountStorage = m_bundleCountStorage;
                     if (!m_zmqRepSock_connectingGuiToFromBoundIngressPtr->send(zmq::const_buffer(&telem, sizeof(telem)), zmq::send_flags::dontwait)) {
-                        std::cerr << "ingress can't send telemetry to gui" << std::endl;
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "ingress", "ingress can't send telemetry to gui");
                     }
                 }
             }
@@ -461,9 +465,8 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
 {
     std::unique_ptr<zmq::message_t> zmqMessageToSendUniquePtr; //create on heap as zmq default constructor costly
     if (bundleCurrentSize > m_hdtnConfig.m_maxBundleSizeBytes) { //should never reach here as this is handled by induct
-        std::cerr << "error in Ingress::Process: received bundle size ("
-            << bundleCurrentSize << " bytes) exceeds max bundle size limit of "
-            << m_hdtnConfig.m_maxBundleSizeBytes << " bytes\n";
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: received bundle size ({} bytes) exceeds max bundle size limit of {} bytes",
+            bundleCurrentSize, m_hdtnConfig.m_maxBundleSizeBytes);
         return false;
     }
     cbhe_eid_t finalDestEid;
@@ -475,7 +478,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
     if (isBpVersion6) {
         BundleViewV6 bv;
         if (!bv.LoadBundle(bundleDataBegin, bundleCurrentSize)) {
-            std::cerr << "malformed bundle\n";
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: malformed version 6 bundle received");
             return false;
         }
         Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
@@ -492,7 +495,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
             if (isEcho) {
                 primary.m_destinationEid = primary.m_sourceNodeId;
                 finalDestEid = primary.m_destinationEid;
-                std::cerr << "Sending Ping for destination " << primary.m_destinationEid << "\n";
+                HDTN_LOG_INFO_RATE_LIMITED(10, "ingress", "Sending Ping for destination ipn:{}.{}", primary.m_destinationEid.nodeId, primary.m_destinationEid.serviceId);
                 primary.m_sourceNodeId = M_HDTN_EID_ECHO;
                 bv.m_primaryBlockView.SetManuallyModified();
                 bv.Render(bundleCurrentSize + 10);
@@ -516,7 +519,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
         BundleViewV7 bv;
         const bool skipCrcVerifyInCanonicalBlocks = !needsProcessing;
         if (!bv.LoadBundle(bundleDataBegin, bundleCurrentSize, skipCrcVerifyInCanonicalBlocks)) { //todo true => skip canonical block crc checks to increase speed
-            std::cout << "error in Ingress::Process: malformed version 7 bundle received\n";
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: malformed version 7 bundle received");
             return false;
         }
         Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
@@ -533,7 +536,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                 std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
                 bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE, blocks);
                 if (blocks.size() > 1) {
-                    std::cout << "error in Ingress::Process: version 7 bundle received has multiple previous node blocks\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: version 7 bundle received has multiple previous node blocks");
                     return false;
                 }
                 else if (blocks.size() == 1) { //update existing
@@ -542,7 +545,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                         blocks[0]->SetManuallyModified();
                     }
                     else {
-                        std::cout << "error in Ingress::Process: dynamic_cast to Bpv7PreviousNodeCanonicalBlock failed\n";
+                        HDTN_LOG_ERROR("ingress", "error in Ingress::Process: dynamic_cast to Bpv7PreviousNodeCanonicalBlock failed");
                         return false;
                     }
                 }
@@ -560,7 +563,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                 //get hop count if exists and update it
                 bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::HOP_COUNT, blocks);
                 if (blocks.size() > 1) {
-                    std::cout << "error in Ingress::Process: version 7 bundle received has multiple hop count blocks\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: version 7 bundle received has multiple hop count blocks");
                     return false;
                 }
                 else if (blocks.size() == 1) { //update existing
@@ -573,27 +576,27 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                         //Section 5.10.
                         //Hop limit MUST be in the range 1 through 255.
                         if ((newHopCount > hopCountBlockPtr->m_hopLimit) || (newHopCount > 255)) {
-                            std::cout << "notice: Ingress::Process dropping version 7 bundle with hop count " << newHopCount << "\n";
+                            HDTN_LOG_NOTIFICATION("ingress", "notice: Ingress::Process dropping version 7 bundle with hop count {}", newHopCount);
                             return false;
                         }
                         hopCountBlockPtr->m_hopCount = newHopCount;
                         blocks[0]->SetManuallyModified();
                     }
                     else {
-                        std::cout << "error in Ingress::Process: dynamic_cast to Bpv7HopCountCanonicalBlock failed\n";
+                        HDTN_LOG_ERROR("ingress", "error in Ingress::Process: dynamic_cast to Bpv7HopCountCanonicalBlock failed");
                         return false;
                     }
                 }
                 if (isEcho) {
                     primary.m_destinationEid = primary.m_sourceNodeId;
                     finalDestEid = primary.m_sourceNodeId;
-                    std::cerr << "Sending Ping for destination " << finalDestEid << std::endl;
+                    HDTN_LOG_INFO_RATE_LIMITED(10, "ingress", "Sending Ping for destination ipn:{}.{}", finalDestEid.nodeId, finalDestEid.serviceId);
                     primary.m_sourceNodeId = M_HDTN_EID_ECHO;
                     bv.m_primaryBlockView.SetManuallyModified();
                 }
 
                 if (!bv.RenderInPlace(PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE)) {
-                    std::cout << "error in Ingress::Process: bpv7 RenderInPlace failed\n";
+                    HDTN_LOG_ERROR("ingress", "error in Ingress::Process: bpv7 RenderInPlace failed");
                     return false;
                 }
                 bundleCurrentSize = bv.m_renderedBundle.size();
@@ -609,7 +612,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
         }
     }
     else {
-        std::cout << "error in Ingress::Process: unsupported bundle version received\n";
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error in Ingress::Process: unsupported bundle version received");
         return false;
     }
 
@@ -632,16 +635,9 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
             useStorage = false;
         }
         else {
-            std::string msg = "notice in Ingress::Process: tcpcl opportunistic forward timed out after 3 seconds for "
-                + Uri::GetIpnUriString(finalDestEid.nodeId, finalDestEid.serviceId);
-            if (shouldTryToUseCustThrough) {
-                msg += " ..trying the cut-through path instead";
-            }
-            else {
-                msg += " ..sending to storage instead";
-            }
-            std::cerr << msg << std::endl;
-            hdtn::Logger::getInstance()->logError("ingress", msg);
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "notice in Ingress::Process: tcpcl opportunistic forward timed out after 3 seconds for ipn:{}.{} ..{}",
+                finalDestEid.nodeId, finalDestEid.serviceId,
+                (shouldTryToUseCustThrough) ? "trying the cut-through path instead" : "sending to storage instead");
         }
     }
     while (shouldTryToUseCustThrough) { //type egress cut through ("while loop" instead of "if statement" to support breaking to storage)
@@ -657,20 +653,13 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                 timeoutExpiry = boost::posix_time::microsec_clock::universal_time() + M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION;
             }
             else if (timeoutExpiry < boost::posix_time::microsec_clock::universal_time()) {
-                std::string msg = "notice in Ingress::Process: cut-through path timed out after " +
-                    boost::lexical_cast<std::string>(m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds) +
-                    " milliseconds because it has too many pending egress acks in the queue for finalDestEid (" +
-                    boost::lexical_cast<std::string>(finalDestEid.nodeId) + "," + boost::lexical_cast<std::string>(finalDestEid.serviceId) + ")";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "notice in Ingress::Process: cut-through path timed out after {} milliseconds because it has too many pending egress acks in the queue for finalDestEid ({},{}) ..{}",
+                    m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds, finalDestEid.nodeId, finalDestEid.serviceId,
+                    (m_isCutThroughOnlyTest) ? "dropping bundle because \"cut through only test\" was specified (not sending to storage)" : "sending to storage instead");
                 if (m_isCutThroughOnlyTest) {
-                    msg += " ..dropping bundle because \"cut through only test\" was specified (not sending to storage)";
-                    std::cerr << msg << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress", msg);
                     return false;
                 }
                 else {
-                    msg += " ..sending to storage instead";
-                    std::cerr << msg << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress", msg);
                     useStorage = true;
                     break;
                 }
@@ -698,17 +687,15 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
             //zmq::message_t messageWithDataStolen(hdrPtr.get(), sizeof(hdtn::BlockHdr), CustomIgnoreCleanupBlockHdr); //cleanup will occur in the queue below
             boost::mutex::scoped_lock lock(m_ingressToEgressZmqSocketMutex);
             if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-                std::cerr << "ingress can't send BlockHdr to egress" << std::endl;
-                hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send BlockHdr to egress");
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "ingress can't send BlockHdr to egress");
             }
             else {
-                egressToIngressAckingObj.PushMove_ThreadSafe(ingressToEgressUniqueId);
+                egressToIngressAckingObj.PushMove_ThreadSafe(ingressToEgressUniqueId, LatencyHistogram::NowNanoseconds());
+                m_metricEgressAckQueueDepth.Add(1);
 
 
                 if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
-                    std::cerr << "ingress can't send bundle to egress" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send bundle to egress");
-
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "ingress can't send bundle to egress");
                 }
                 else {
                     //success                            
@@ -729,8 +716,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                 timeoutExpiry = boost::posix_time::microsec_clock::universal_time() + twoSeconds;
             }
             if (timeoutExpiry < boost::posix_time::microsec_clock::universal_time()) {
-                std::cerr << "error: too many pending storage acks in the queue" << std::endl;
-                hdtn::Logger::getInstance()->logError("ingress", "Error: too many pending storage acks in the queue");
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "error: too many pending storage acks in the queue");
                 return false;
             }
             m_conditionVariableStorageAckReceived.timed_wait(lock, boost::posix_time::milliseconds(250)); // call lock.unlock() and blocks the current thread
@@ -751,15 +737,14 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
 
         //zmq threads not thread safe but protected by mutex above
         if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(zmqMessageToStorageHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-            std::cerr << "ingress can't send BlockHdr to storage" << std::endl;
-            hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send BlockHdr to storage");
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "ingress can't send BlockHdr to storage");
         }
         else {
-            m_storageAckQueue.push(ingressToStorageUniqueId);
+            m_storageAckQueue.emplace(ingressToStorageUniqueId, LatencyHistogram::NowNanoseconds());
+            m_metricStorageAckQueueDepth.Set(static_cast<int64_t>(m_storageAckQueue.size()));
 
             if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
-                std::cerr << "ingress can't send bundle to storage" << std::endl;
-                hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send bundle to storage");
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "ingress", "ingress can't send bundle to storage");
             }
             else {
                 //success                            
@@ -771,6 +756,8 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
 
 
     m_bundleData.fetch_add(bundleCurrentSize, boost::memory_order_relaxed);
+    m_metricBundlesReceived.Increment();
+    m_metricBytesReceived.Increment(bundleCurrentSize);
 
     return true;
 }
@@ -783,6 +770,15 @@ void Ingress::WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec) {
     ProcessPaddedData(wholeBundleVec.data(), wholeBundleVec.size(), unusedZmqPtr, wholeBundleVec, false, true);
 }
 
+void Ingress::WholePaddedZmqBundleReadyCallback(std::unique_ptr<zmq::message_t> & movablePaddedBundleZmq) {
+    //bundles received into files by the convergence layer (i.e. ltp red parts spilled to disk) are passed to storage
+    //within the zmq message rather than copied into memory
+    static padded_vector_uint8_t unusedPaddedVec;
+    uint8_t * bundleDataBegin = ((uint8_t *)movablePaddedBundleZmq->data()) + PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE;
+    const std::size_t bundleCurrentSize = movablePaddedBundleZmq->size() - PaddedMallocator<uint8_t>::TOTAL_PADDING_ELEMENTS;
+    ProcessPaddedData(bundleDataBegin, bundleCurrentSize, movablePaddedBundleZmq, unusedPaddedVec, true, true);
+}
+
 void Ingress::SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable) {
     //force natural/64-bit alignment
     hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
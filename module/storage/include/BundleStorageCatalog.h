@@ -22,7 +22,8 @@
 
 #include <cstdint>
 #include <map>
-#include <forward_list>
+#include <queue>
+#include <functional>
 #include <array>
 #include <vector>
 #include <utility>
@@ -36,10 +37,8 @@
 #include "storage_lib_export.h"
 
 //Awaiting Send data structures
-typedef std::forward_list<uint64_t> custids_flist_t;
-typedef std::pair<custids_flist_t, custids_flist_t::iterator> custids_flist_plus_lastiterator_t;
-typedef std::map<uint64_t, custids_flist_plus_lastiterator_t> expirations_to_custids_map_t;
-typedef std::array<expirations_to_custids_map_t, NUMBER_OF_PRIORITIES> priorities_to_expirations_array_t;
+typedef std::map<uint64_t, catalog_entry_dlist_t> expirations_to_catalog_entries_map_t;
+typedef std::array<expirations_to_catalog_entries_map_t, NUMBER_OF_PRIORITIES> priorities_to_expirations_array_t;
 typedef std::map<cbhe_eid_t, priorities_to_expirations_array_t> dest_eid_to_priorities_map_t;
 
 typedef HashMap16BitFixedSize<cbhe_bundle_uuid_t, uint64_t> uuid_to_custid_hashmap_t; //get the cteb custody id from fragmented bundle uuid
@@ -47,6 +46,11 @@ typedef HashMap16BitFixedSize<cbhe_bundle_uuid_nofragment_t, uint64_t> uuidnofra
 typedef HashMap16BitFixedSize<uint64_t, catalog_entry_t> custid_to_catalog_entry_hashmap_t; //get the catalog entry from cteb custody id
 typedef boost::bimap<uint64_t, boost::posix_time::ptime> custid_to_custody_xfer_expiry_bimap_t;
 
+//Expiration index across all destinations: a min-heap of (absolute expiration, custody id).
+//Removal from the catalog does not touch the heap; stale pairs are discarded when they reach the top.
+typedef std::pair<uint64_t, uint64_t> expiration_custid_pair_t;
+typedef std::priority_queue<expiration_custid_pair_t, std::vector<expiration_custid_pair_t>, std::greater<expiration_custid_pair_t> > expiration_custid_min_heap_t;
+
 class BundleStorageCatalog {
 public:
     enum class DUPLICATE_EXPIRY_ORDER {
@@ -63,21 +67,33 @@ public:
     STORAGE_LIB_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<uint64_t> & availableDestNodeIds);
     STORAGE_LIB_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests);
     
-    STORAGE_LIB_EXPORT bool AddEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order);
-    STORAGE_LIB_EXPORT bool ReturnEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId);
-    STORAGE_LIB_EXPORT bool RemoveEntryFromAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId);
+    //catalogEntry must be the entry stored in this catalog (i.e. from PopEntryFromAwaitingSend or GetEntryFromCustodyId)
+    STORAGE_LIB_EXPORT bool AddEntryToAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order);
+    STORAGE_LIB_EXPORT bool ReturnEntryToAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId);
+    STORAGE_LIB_EXPORT bool RemoveEntryFromAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId);
     STORAGE_LIB_EXPORT std::pair<bool, uint16_t> Remove(const uint64_t custodyId, bool alsoNeedsRemovedFromAwaitingSend);
+    //Remove every entry with a custody id in [firstCustodyId, lastCustodyId] (i.e. an aggregate custody signal fill),
+    //appending each removed entry to removedEntries.  Returns the number of entries removed.
+    STORAGE_LIB_EXPORT std::size_t RemoveCustodyIdRange(const uint64_t firstCustodyId, const uint64_t lastCustodyId,
+        bool alsoNeedsRemovedFromAwaitingSend, std::vector<catalog_entry_t> & removedEntries);
     STORAGE_LIB_EXPORT catalog_entry_t * GetEntryFromCustodyId(const uint64_t custodyId);
+    //Append (oldest first) up to maxCustodyIds custody ids of cataloged bundles whose expiration is at or before nowSecondsSinceStartOfYear2000,
+    //removing them from the expiration index.  Returns the number appended.
+    STORAGE_LIB_EXPORT std::size_t PopExpiredCustodyIds(const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxCustodyIds, std::vector<uint64_t> & expiredCustodyIds);
+    STORAGE_LIB_EXPORT uint64_t GetNumEntries() const;
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
 
 private:
     STORAGE_LIB_NO_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId,
         const std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > & destEidPlusPriorityArrayPtrs);
-    STORAGE_LIB_NO_EXPORT bool Insert_OrderBySequence(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert, const uint64_t mySequence);
-    STORAGE_LIB_NO_EXPORT void Insert_OrderByFifo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert);
-    STORAGE_LIB_NO_EXPORT void Insert_OrderByFilo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert);
-    STORAGE_LIB_NO_EXPORT bool Remove(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToRemove);
+    STORAGE_LIB_NO_EXPORT static bool Insert_OrderBySequence(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert);
+    STORAGE_LIB_NO_EXPORT static void Insert_OrderByFifo(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert);
+    STORAGE_LIB_NO_EXPORT static void Insert_OrderByFilo(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert);
+    STORAGE_LIB_NO_EXPORT static void Unlink(catalog_entry_t & entryToRemove);
+    STORAGE_LIB_NO_EXPORT std::pair<bool, uint16_t> Remove(const uint64_t custodyId, bool alsoNeedsRemovedFromAwaitingSend, catalog_entry_t & removedEntry);
+    STORAGE_LIB_NO_EXPORT bool IsExpirationPairStale(const expiration_custid_pair_t & expirationCustodyIdPair);
+    STORAGE_LIB_NO_EXPORT void CompactExpirationHeap();
 
 protected:
     dest_eid_to_priorities_map_t m_destEidToPrioritiesMap;
@@ -85,6 +101,8 @@ protected:
     uuidnofrag_to_custid_hashmap_t m_uuidNoFragToCustodyIdHashMap;
     custid_to_catalog_entry_hashmap_t m_custodyIdToCatalogEntryHashmap;
     custid_to_custody_xfer_expiry_bimap_t m_custodyIdToCustodyTransferExpiryBimap;
+    expiration_custid_min_heap_t m_expirationCustodyIdMinHeap;
+    uint64_t m_numEntries;
 };
 
 
@@ -98,11 +98,17 @@ public:
     STORAGE_LIB_EXPORT bool ReturnTop(BundleStorageManagerSession_ReadFromDisk & session);
     STORAGE_LIB_EXPORT bool ReturnCustodyIdToAwaitingSend(const uint64_t custodyId); //for expired custody timers
     STORAGE_LIB_EXPORT catalog_entry_t * GetCatalogEntryPtrFromCustodyId(const uint64_t custodyId); //for deletion of custody timer
+    STORAGE_LIB_EXPORT std::size_t PopExpiredCustodyIds(const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxCustodyIds, std::vector<uint64_t> & expiredCustodyIds);
+    //read a bundle that is not popped from awaiting send (i.e. an expired bundle about to be deleted) using TopSegment/ReadAllSegments
+    STORAGE_LIB_EXPORT uint64_t StartReadByCustodyId(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t custodyId); //0 if not found, size if entry
     STORAGE_LIB_EXPORT std::size_t TopSegment(BundleStorageManagerSession_ReadFromDisk & session, void * buf);
     STORAGE_LIB_EXPORT bool ReadAllSegments(BundleStorageManagerSession_ReadFromDisk & session, std::vector<uint8_t> & buf);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(const uint64_t custodyId);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(BundleStorageManagerSession_ReadFromDisk & sessionRead);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(const catalog_entry_t * catalogEntryPtr, const uint64_t custodyId);
+    //remove every stored bundle with a custody id in [firstCustodyId, lastCustodyId] (i.e. an aggregate custody signal fill)
+    //using a single bulk free of their segments; the removed catalog entries are appended to removedEntries
+    STORAGE_LIB_EXPORT uint64_t RemoveReadBundlesFromDisk(const uint64_t firstCustodyId, const uint64_t lastCustodyId, std::vector<catalog_entry_t> & removedEntries);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
 
@@ -117,6 +123,7 @@ protected:
 
     
     virtual void NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) = 0;
+    STORAGE_LIB_NO_EXPORT void InvalidateBundleHeadOnDisk(const segment_id_t headSegmentId);
 
 protected:
     StorageConfig_ptr m_storageConfigPtr;
@@ -124,7 +131,19 @@ public:
     const unsigned int M_NUM_STORAGE_DISKS;
     const uint64_t M_TOTAL_STORAGE_CAPACITY_BYTES; //old FILE_SIZE
     const uint64_t M_MAX_SEGMENTS;
+    const uint64_t M_DISK_EXTENT_SIZE_SEGMENTS; //1 => each segment id is striped round robin across the disks
 protected:
+    //Segment ids are grouped into extents of M_DISK_EXTENT_SIZE_SEGMENTS consecutive ids.
+    //The extents are striped round robin across the disks, and the segments of an extent are contiguous on its disk,
+    //so a contiguous run of segment ids (from the MemoryManagerTreeArray) becomes one large sequential disk transfer.
+    unsigned int SegmentIdToDiskIndex(const segment_id_t segmentId) const {
+        return static_cast<unsigned int>((segmentId / M_DISK_EXTENT_SIZE_SEGMENTS) % M_NUM_STORAGE_DISKS);
+    }
+    uint64_t SegmentIdToDiskOffsetBytes(const segment_id_t segmentId) const {
+        const uint64_t extentIndexOnDisk = (segmentId / M_DISK_EXTENT_SIZE_SEGMENTS) / M_NUM_STORAGE_DISKS;
+        return ((extentIndexOnDisk * M_DISK_EXTENT_SIZE_SEGMENTS) + (segmentId % M_DISK_EXTENT_SIZE_SEGMENTS)) * SEGMENT_SIZE;
+    }
+
     MemoryManagerTreeArray m_memoryManager;
     BundleStorageCatalog m_bundleStorageCatalog;
     boost::mutex m_mutexMainThread;
@@ -15,7 +15,8 @@
  *
  * This BundleStorageManagerMT class inherits from the BundleStorageManagerBase class and implements
  * writing and reading bundles to and from solid state disk drive(s) using 1 thread per disk drive (i.e. 1 thread per storeFilePath)
- * and uses cross-platform blocking synchronous I/O operations from stdio.h such as fwrite.
+ * and uses blocking synchronous I/O operations (preadv/pwritev on Linux, or stdio.h such as fwrite elsewhere).
+ * Each disk thread transfers a run of queued segments at consecutive disk offsets with a single I/O operation.
  */
 
 #ifndef _BUNDLE_STORAGE_MANAGER_MT_H
@@ -41,7 +42,6 @@ private:
     //boost::condition_variable m_conditionVariables[NUM_STORAGE_THREADS];
     //boost::shared_ptr<boost::thread> m_threadPtrs[NUM_STORAGE_THREADS];
     //CircularIndexBufferSingleProducerSingleConsumer m_circularIndexBuffers[NUM_STORAGE_THREADS];
-    std::vector<boost::condition_variable> m_conditionVariablesVec;
     std::vector<std::unique_ptr<boost::thread> > m_threadPtrsVec;
 
     volatile bool m_running;
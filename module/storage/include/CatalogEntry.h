@@ -25,6 +25,17 @@
 #include "codec/PrimaryBlock.h"
 #include "storage_lib_export.h"
 
+struct catalog_entry_t;
+
+//head and tail of an intrusive doubly linked list of catalog entries
+//(the bundles awaiting send with the same destination, priority, and expiration)
+struct catalog_entry_dlist_t {
+    catalog_entry_t * head;
+    catalog_entry_t * tail;
+
+    catalog_entry_dlist_t() : head(NULL), tail(NULL) {}
+};
+
 struct catalog_entry_t {
     uint64_t bundleSizeBytes;
     segment_id_chain_vec_t segmentIdChainVec;
@@ -32,6 +43,13 @@ struct catalog_entry_t {
     uint64_t encodedAbsExpirationAndCustodyAndPriority;
     uint64_t sequence;
     const void * ptrUuidKeyInMap;
+    uint64_t custodyId;
+
+    //Intrusive links (a handle stored alongside the custody id) so that an entry is unlinked from awaiting send in O(1).
+    //These are never copied or moved (a copy is not in any list), and are not part of equality.
+    catalog_entry_dlist_t * awaitingSendListPtr; //NULL if not awaiting send
+    catalog_entry_t * prevAwaitingSend;
+    catalog_entry_t * nextAwaitingSend;
 
     STORAGE_LIB_EXPORT catalog_entry_t(); //a default constructor: X()
     STORAGE_LIB_EXPORT ~catalog_entry_t(); //a destructor: ~X()
@@ -48,6 +66,8 @@ struct catalog_entry_t {
     STORAGE_LIB_EXPORT bool HasCustodyAndFragmentation() const;
     STORAGE_LIB_EXPORT bool HasCustodyAndNonFragmentation() const;
     STORAGE_LIB_EXPORT bool HasCustody() const;
+    STORAGE_LIB_EXPORT bool IsDeletionStatusReportRequired() const;
+    STORAGE_LIB_EXPORT bool IsAwaitingSend() const;
     STORAGE_LIB_EXPORT void Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, const uint64_t paramNumSegmentsRequired, void * paramPtrUuidKeyInMap);
 };
 
@@ -48,6 +48,8 @@ public:
 
     /** Thread safe method to allocate a vector of the first available free segment numbers in numerical order.
      * The desired number of segments must be set prior to the call by calling segmentVec.resize() (i.e. number of desired segments should be the vector size).
+     * The segments are claimed in bulk (up to 64 per tree descent) so that a large bundle holds the mutex for only a few descents,
+     * and consecutive free segments are returned as contiguous runs of segment Ids.
      *
      * @param segmentVec The preallocated vector of segments to be filled.  Will be resized to zero on failure.
      * @return True if the segmentVec was fully populated (the MemoryManagerTreeArray was not full prior to the last segment being allocated), or False otherwise.
@@ -57,6 +59,7 @@ public:
     STORAGE_LIB_EXPORT bool AllocateSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec);
 
     /** Thread safe method to free a vector of segment numbers.
+     * Segment Ids that share a leaf uint64_t (i.e. contiguous runs) are freed together with one update of the parent rows.
      *
      * @param segmentVec The vector of segments to mark as free in the internal data structure.
      * @return True if all the segment numbers in the segmentVec were freed, or False otherwise.
@@ -71,6 +74,12 @@ public:
      */
     STORAGE_LIB_EXPORT bool IsSegmentFree(const segment_id_t segmentId) const;
 
+    /** Get the number of segments that are currently free.
+     *
+     * @return The number of segments available for allocation.
+     */
+    STORAGE_LIB_EXPORT uint64_t GetNumFreeSegments() const;
+
     /** Backup the internal data structure to the given reference parameter, useful for equality comparision in unit testing.
      *
      * @param backup The data to copy the internal data structure to.
@@ -117,11 +126,15 @@ private:
 
 
     STORAGE_LIB_NO_EXPORT bool GetAndSetFirstFreeSegmentId(const segment_id_t depthIndex, segment_id_t & segmentId);
+    STORAGE_LIB_NO_EXPORT std::size_t GetAndSetFirstFreeSegmentIdsInLeaf(segment_id_t * segmentIds, const std::size_t maxSegmentIds);
+    STORAGE_LIB_NO_EXPORT void SetParentBitsOfLeaf(segment_id_t leafLongIndex);
+    STORAGE_LIB_NO_EXPORT void ClearParentBitsOfFullLeaf(segment_id_t leafLongIndex);
     STORAGE_LIB_NO_EXPORT void AllocateRows(const segment_id_t largestSegmentId);
     STORAGE_LIB_NO_EXPORT void AllocateRowsMaxMemory();
 private:
     const uint64_t M_MAX_SEGMENTS;
     std::vector<std::vector<uint64_t> > m_bitMasks;
+    uint64_t m_numFreeSegments;
     boost::mutex m_mutex;
 };
 
@@ -21,6 +21,7 @@
 #define _ZMQ_STORAGE_INTERFACE_H 1
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <boost/shared_ptr.hpp>
@@ -30,12 +31,19 @@
 #include "zmq.hpp"
 #include "codec/bpv6.h"
 #include "Telemetry.h"
+#include "MetricsRegistry.h"
 #include "storage_lib_export.h"
 
 //addresses for ZMQ IPC transport
 #define HDTN_STORAGE_TELEM_PATH "tcp://127.0.0.1:10460"
 #define HDTN_RELEASE_TELEM_PATH "tcp://127.0.0.1:10461"
 
+class BundleStorageManagerBase;
+struct BundleStorageManagerSession_ReadFromDisk;
+class CustodyIdAllocator;
+class CustodyTransferManager;
+class CustodyTimers;
+
 
 class ZmqStorageInterface {
 public:
@@ -47,8 +55,19 @@ public:
 
     hdtn::WorkerStats stats() { return m_workerStats; }
 
+    typedef std::set<uint64_t> custodyid_set_t;
+    typedef std::map<cbhe_eid_t, custodyid_set_t> finaldesteid_opencustids_map_t;
+    //Delete (at most maxBundlesToSweep) bundles whose lifetime has expired, generating any deletion status reports.
+    //Returns true if the limit was reached (i.e. more expired bundles may remain).
+    STORAGE_LIB_EXPORT bool SweepExpiredBundles(BundleStorageManagerBase & bsm, BundleStorageManagerSession_ReadFromDisk & sessionRead,
+        CustodyIdAllocator & custodyIdAllocator, CustodyTransferManager & ctm, CustodyTimers & custodyTimers,
+        finaldesteid_opencustids_map_t & finalDestEidToOpenCustIdsMap, std::vector<uint64_t> & expiredCustodyIdsVec,
+        const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxBundlesToSweep,
+        MetricCounter & metricBundlesExpired, MetricCounter & metricBytesReclaimed, MetricCounter & metricStatusReportsGenerated);
+
     std::size_t m_totalBundlesErasedFromStorageNoCustodyTransfer;
     std::size_t m_totalBundlesErasedFromStorageWithCustodyTransfer;
+    std::size_t m_totalBundlesErasedFromStorageDueToExpiration;
     std::size_t m_totalBundlesSentToEgressFromStorage;
     uint64_t m_numRfc5050CustodyTransfers;
     uint64_t m_numAcsCustodyTransfers;
@@ -18,105 +18,93 @@
 #include <boost/make_unique.hpp>
 
 
-BundleStorageCatalog::BundleStorageCatalog() {}
+BundleStorageCatalog::BundleStorageCatalog() : m_numEntries(0) {}
 
 
 
 BundleStorageCatalog::~BundleStorageCatalog() {}
 
-bool BundleStorageCatalog::Insert_OrderBySequence(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert, const uint64_t mySequence) {
-    custids_flist_t & custodyIdFlist = custodyIdFlistPlusLastIt.first;
-    custids_flist_t::iterator & custodyIdFlistLastIterator = custodyIdFlistPlusLastIt.second;
-    if (custodyIdFlist.empty()) {
-        custodyIdFlist.emplace_front(custodyIdToInsert);
-        custodyIdFlistLastIterator = custodyIdFlist.begin();
+bool BundleStorageCatalog::Insert_OrderBySequence(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert) {
+    const uint64_t mySequence = entryToInsert.sequence;
+    //Chances are that bundle sequences will arrive in numerical order.
+    //To optimize ordered insertion into an ordered list, check if greater than the
+    //tail first before iterating (backwards) through the list.
+    catalog_entry_t * entryInList = entryList.tail;
+    if ((entryInList == NULL) || (entryInList->sequence < mySequence)) {
+        Insert_OrderByFifo(entryList, entryToInsert);
         return true;
     }
-    else {
-        
-        //Chances are that bundle sequences will arrive in numerical order.
-        //To optimize ordered insertion into an ordered singly-linked list, check if greater than the
-        //last iterator first before iterating through the list.
-        const uint64_t lastCustodyIdInList = *custodyIdFlistLastIterator;
-        catalog_entry_t * lastEntryInList = m_custodyIdToCatalogEntryHashmap.GetValuePtr(lastCustodyIdInList);
-        if (lastEntryInList == NULL) {
-            return false; //unexpected error
-        }
-        const uint64_t lastSequenceInList = lastEntryInList->sequence;
-        if (lastSequenceInList < mySequence) {
-            //sequence is greater than every element in the bucket, insert at the end
-            custodyIdFlistLastIterator = custodyIdFlist.emplace_after(custodyIdFlistLastIterator, custodyIdToInsert);
-            return true;
-        }
-        
 
-        //An out of order sequence arrived.  Revert to classic insertion
-        custids_flist_t::const_iterator itPrev = custodyIdFlist.cbefore_begin();
-        for (custids_flist_t::const_iterator it = custodyIdFlist.cbegin(); it != custodyIdFlist.cend(); ++it, ++itPrev) {
-            const uint64_t custodyIdInList = *it;
-            catalog_entry_t * entryInList = m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyIdInList);
-            if (entryInList == NULL) {
-                return false; //unexpected error
-            }
-            const uint64_t sequenceInList = entryInList->sequence;
-            if (mySequence < sequenceInList) { //not in list, insert now
-                break; //will call bucket.emplace_after(itPrev, custodyIdToInsert); and return true;
-            }
-            else if (sequenceInList < mySequence) { //greater than element
-                continue;
-            }
-            else { //equal, already exists
-                return false;
-            }
+    //An out of order sequence arrived.  Revert to classic insertion
+    for (; entryInList != NULL; entryInList = entryInList->prevAwaitingSend) {
+        const uint64_t sequenceInList = entryInList->sequence;
+        if (sequenceInList < mySequence) { //not in list, insert after entryInList
+            break;
         }
-        //sequence is greater than every element iterated thus far in the bucket (but less than the last element), insert here
-        custodyIdFlist.emplace_after(itPrev, custodyIdToInsert);
-        return true;
+        else if (sequenceInList == mySequence) { //equal, already exists
+            return false;
+        }
+    }
+    //entryInList is NULL if sequence is less than every element in the list
+    catalog_entry_t * const nextEntry = (entryInList) ? entryInList->nextAwaitingSend : entryList.head;
+    entryToInsert.prevAwaitingSend = entryInList;
+    entryToInsert.nextAwaitingSend = nextEntry;
+    entryToInsert.awaitingSendListPtr = &entryList;
+    nextEntry->prevAwaitingSend = &entryToInsert; //nextEntry is never NULL since mySequence < tail sequence
+    if (entryInList) {
+        entryInList->nextAwaitingSend = &entryToInsert;
+    }
+    else {
+        entryList.head = &entryToInsert;
     }
+    return true;
 }
 //won't detect duplicates
-void BundleStorageCatalog::Insert_OrderByFifo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert) {
-    custids_flist_t & custodyIdFlist = custodyIdFlistPlusLastIt.first;
-    custids_flist_t::iterator & custodyIdFlistLastIterator = custodyIdFlistPlusLastIt.second;
-    if (custodyIdFlist.empty()) {
-        custodyIdFlist.emplace_front(custodyIdToInsert);
-        custodyIdFlistLastIterator = custodyIdFlist.begin();
+void BundleStorageCatalog::Insert_OrderByFifo(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert) {
+    entryToInsert.prevAwaitingSend = entryList.tail;
+    entryToInsert.nextAwaitingSend = NULL;
+    entryToInsert.awaitingSendListPtr = &entryList;
+    if (entryList.tail) {
+        entryList.tail->nextAwaitingSend = &entryToInsert;
     }
     else {
-        custodyIdFlistLastIterator = custodyIdFlist.emplace_after(custodyIdFlistLastIterator, custodyIdToInsert);
+        entryList.head = &entryToInsert;
     }
+    entryList.tail = &entryToInsert;
 }
 //won't detect duplicates
-void BundleStorageCatalog::Insert_OrderByFilo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert) {
-    custids_flist_t & custodyIdFlist = custodyIdFlistPlusLastIt.first;
-    custids_flist_t::iterator & custodyIdFlistLastIterator = custodyIdFlistPlusLastIt.second;
-    const bool startedAsEmpty = custodyIdFlist.empty();
-    custodyIdFlist.emplace_front(custodyIdToInsert);
-    if (startedAsEmpty) {
-        custodyIdFlistLastIterator = custodyIdFlist.begin();
+void BundleStorageCatalog::Insert_OrderByFilo(catalog_entry_dlist_t & entryList, catalog_entry_t & entryToInsert) {
+    entryToInsert.prevAwaitingSend = NULL;
+    entryToInsert.nextAwaitingSend = entryList.head;
+    entryToInsert.awaitingSendListPtr = &entryList;
+    if (entryList.head) {
+        entryList.head->prevAwaitingSend = &entryToInsert;
+    }
+    else {
+        entryList.tail = &entryToInsert;
     }
+    entryList.head = &entryToInsert;
 }
 
-bool BundleStorageCatalog::Remove(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToRemove) {
-    custids_flist_t & custodyIdFlist = custodyIdFlistPlusLastIt.first;
-    custids_flist_t::iterator & custodyIdFlistLastIterator = custodyIdFlistPlusLastIt.second;
-    if (custodyIdFlist.empty()) {
-        return false;
+//O(1), entryToRemove must be awaiting send.
+//Does not erase the (possibly now empty) list from its expiration map.
+void BundleStorageCatalog::Unlink(catalog_entry_t & entryToRemove) {
+    catalog_entry_dlist_t & entryList = *entryToRemove.awaitingSendListPtr;
+    if (entryToRemove.prevAwaitingSend) {
+        entryToRemove.prevAwaitingSend->nextAwaitingSend = entryToRemove.nextAwaitingSend;
     }
     else {
-        for (custids_flist_t::iterator itPrev = custodyIdFlist.before_begin(), it = custodyIdFlist.begin(); it != custodyIdFlist.end(); ++it, ++itPrev) {
-            const uint64_t custodyIdInList = *it;
-            if (custodyIdToRemove == custodyIdInList) { //equal, remove it
-                if (it == custodyIdFlistLastIterator) {
-                    custodyIdFlistLastIterator = itPrev;
-                }
-                custodyIdFlist.erase_after(itPrev);
-                return true;
-            }
-        }
-        //not found
-        return false;
+        entryList.head = entryToRemove.nextAwaitingSend;
+    }
+    if (entryToRemove.nextAwaitingSend) {
+        entryToRemove.nextAwaitingSend->prevAwaitingSend = entryToRemove.prevAwaitingSend;
+    }
+    else {
+        entryList.tail = entryToRemove.prevAwaitingSend;
     }
+    entryToRemove.prevAwaitingSend = NULL;
+    entryToRemove.nextAwaitingSend = NULL;
+    entryToRemove.awaitingSendListPtr = NULL;
 }
 
 bool BundleStorageCatalog::CatalogIncomingBundleForStore(catalog_entry_t & catalogEntryToTake, const PrimaryBlock & primary, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
@@ -136,50 +124,67 @@ bool BundleStorageCatalog::CatalogIncomingBundleForStore(catalog_entry_t & catal
             catalogEntryToTake.ptrUuidKeyInMap = &p->first;
         }
     }
-    if (!AddEntryToAwaitingSend(catalogEntryToTake, custodyId, order)) {
+    catalogEntryToTake.custodyId = custodyId;
+    const custid_to_catalog_entry_hashmap_t::key_value_pair_t * p = m_custodyIdToCatalogEntryHashmap.Insert(custodyId, std::move(catalogEntryToTake));
+    if (p == NULL) {
         return false;
     }
-    if (!m_custodyIdToCatalogEntryHashmap.Insert(custodyId, std::move(catalogEntryToTake))) {
+    //the entry now lives (at a stable address) in the hashmap, and is linked directly into its awaiting send list
+    catalog_entry_t & entryInMap = const_cast<catalog_entry_t &>(p->second);
+    if (!AddEntryToAwaitingSend(entryInMap, custodyId, order)) {
+        m_custodyIdToCatalogEntryHashmap.GetValueAndRemove(custodyId, catalogEntryToTake); //give the entry back to the caller
         return false;
     }
-    
+    ++m_numEntries;
+    //keep stale pairs (from removed entries) from growing the heap without bound
+    if (m_expirationCustodyIdMinHeap.size() >= ((2 * m_numEntries) + 1024)) {
+        CompactExpirationHeap();
+    }
+    if (!primary.HasUnknownCreationTime()) { //without a creation time the bundle never expires here (as in Bpv7FragmentReassembler)
+        m_expirationCustodyIdMinHeap.emplace(entryInMap.GetAbsExpiration(), custodyId);
+    }
     return true;
 }
-bool BundleStorageCatalog::AddEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
+bool BundleStorageCatalog::AddEntryToAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
+    if (catalogEntry.IsAwaitingSend() || (catalogEntry.custodyId != custodyId)) {
+        return false;
+    }
     priorities_to_expirations_array_t & priorityArray = m_destEidToPrioritiesMap[catalogEntry.destEid]; //created if not exist
-    expirations_to_custids_map_t & expirationMap = priorityArray[catalogEntry.GetPriorityIndex()];
-    custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt = expirationMap[catalogEntry.GetAbsExpiration()];
+    expirations_to_catalog_entries_map_t & expirationMap = priorityArray[catalogEntry.GetPriorityIndex()];
+    catalog_entry_dlist_t & entryList = expirationMap[catalogEntry.GetAbsExpiration()]; //created if not exist
     if (order == DUPLICATE_EXPIRY_ORDER::SEQUENCE_NUMBER) {
-        return Insert_OrderBySequence(custodyIdFlistPlusLastIt, custodyId, catalogEntry.sequence);
+        return Insert_OrderBySequence(entryList, catalogEntry);
     }
     else if (order == DUPLICATE_EXPIRY_ORDER::FIFO) {
-        Insert_OrderByFifo(custodyIdFlistPlusLastIt, custodyId);
+        Insert_OrderByFifo(entryList, catalogEntry);
         return true;
     }
     else if (order == DUPLICATE_EXPIRY_ORDER::FILO) {
-        Insert_OrderByFilo(custodyIdFlistPlusLastIt, custodyId);
+        Insert_OrderByFilo(entryList, catalogEntry);
         return true;
     }
     else {
         return false;
     }
 }
-bool BundleStorageCatalog::ReturnEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId) {
+bool BundleStorageCatalog::ReturnEntryToAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId) {
     //return what was popped off the front back to the front
     return AddEntryToAwaitingSend(catalogEntry, custodyId, DUPLICATE_EXPIRY_ORDER::FILO); 
 }
-bool BundleStorageCatalog::RemoveEntryFromAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId) {
-    dest_eid_to_priorities_map_t::iterator destEidIt = m_destEidToPrioritiesMap.find(catalogEntry.destEid);
-    if (destEidIt != m_destEidToPrioritiesMap.end()) {
-        priorities_to_expirations_array_t & priorityArray = destEidIt->second; //created if not exist
-        expirations_to_custids_map_t & expirationMap = priorityArray[catalogEntry.GetPriorityIndex()];
-        expirations_to_custids_map_t::iterator expirationsIt = expirationMap.find(catalogEntry.GetAbsExpiration());
-        if (expirationsIt != expirationMap.end()) {
-            custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt = expirationsIt->second;
-            return Remove(custodyIdFlistPlusLastIt, custodyId);
+bool BundleStorageCatalog::RemoveEntryFromAwaitingSend(catalog_entry_t & catalogEntry, const uint64_t custodyId) {
+    if ((!catalogEntry.IsAwaitingSend()) || (catalogEntry.custodyId != custodyId)) {
+        return false;
+    }
+    const bool listWillBeEmpty = (catalogEntry.awaitingSendListPtr->head == catalogEntry.awaitingSendListPtr->tail);
+    Unlink(catalogEntry);
+    if (listWillBeEmpty) { //only now is a map lookup needed, to erase the empty list
+        dest_eid_to_priorities_map_t::iterator destEidIt = m_destEidToPrioritiesMap.find(catalogEntry.destEid);
+        if (destEidIt != m_destEidToPrioritiesMap.end()) {
+            expirations_to_catalog_entries_map_t & expirationMap = destEidIt->second[catalogEntry.GetPriorityIndex()];
+            expirationMap.erase(catalogEntry.GetAbsExpiration());
         }
     }
-    return false;
+    return true;
 }
 
 //this function requires fully qualified endpoint ids
@@ -252,36 +257,36 @@ catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & cust
     //memset((uint8_t*)session.readCacheIsSegmentReady, 0, READ_CACHE_NUM_SEGMENTS_PER_SESSION);
     for (int i = NUMBER_OF_PRIORITIES - 1; i >= 0; --i) { //00 = bulk, 01 = normal, 10 = expedited
         uint64_t lowestExpiration = UINT64_MAX;
-        expirations_to_custids_map_t * expirationMapPtr = NULL;
-        custids_flist_plus_lastiterator_t * custIdFlistPlusLastItPtr = NULL;
-        expirations_to_custids_map_t::iterator expirationMapIterator;
+        expirations_to_catalog_entries_map_t * expirationMapPtr = NULL;
+        catalog_entry_dlist_t * entryListPtr = NULL;
+        expirations_to_catalog_entries_map_t::iterator expirationMapIterator;
 
         for (std::size_t j = 0; j < destEidPlusPriorityArrayPtrs.size(); ++j) {
             priorities_to_expirations_array_t * priorityArray = destEidPlusPriorityArrayPtrs[j].second;
             //std::cout << "size " << (*priorityVec).size() << "\n";
-            expirations_to_custids_map_t & expirationMap = (*priorityArray)[i];
-            expirations_to_custids_map_t::iterator it = expirationMap.begin();
+            expirations_to_catalog_entries_map_t & expirationMap = (*priorityArray)[i];
+            expirations_to_catalog_entries_map_t::iterator it = expirationMap.begin();
             if (it != expirationMap.end()) {
                 const uint64_t thisExpiration = it->first;
                 //std::cout << "thisexp " << thisExpiration << "\n";
                 if (lowestExpiration > thisExpiration) {
                     lowestExpiration = thisExpiration;
                     expirationMapPtr = &expirationMap;
-                    custIdFlistPlusLastItPtr = &it->second;
+                    entryListPtr = &it->second;
                     expirationMapIterator = it;
                 }
             }
         }
-        if (custIdFlistPlusLastItPtr) {
-            custids_flist_t & cidFlist = custIdFlistPlusLastItPtr->first;
-            custodyId = cidFlist.front();
-            cidFlist.pop_front();
+        if (entryListPtr) {
+            catalog_entry_t * const entryPtr = entryListPtr->head;
+            Unlink(*entryPtr);
 
-            if (cidFlist.empty()) {
+            if (entryListPtr->head == NULL) {
                 expirationMapPtr->erase(expirationMapIterator);
             }
 
-            return m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId);
+            custodyId = entryPtr->custodyId;
+            return entryPtr;
         }
     }
     return NULL;
@@ -292,51 +297,80 @@ catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & cust
 //return pair<success, numSuccessfulRemovals>
 std::pair<bool, uint16_t> BundleStorageCatalog::Remove(const uint64_t custodyId, bool alsoNeedsRemovedFromAwaitingSend) {
     catalog_entry_t entry;
+    return Remove(custodyId, alsoNeedsRemovedFromAwaitingSend, entry);
+}
+std::pair<bool, uint16_t> BundleStorageCatalog::Remove(const uint64_t custodyId, bool alsoNeedsRemovedFromAwaitingSend, catalog_entry_t & removedEntry) {
     bool error = false;
     uint16_t numRemovals = 0;
-    if (!m_custodyIdToCatalogEntryHashmap.GetValueAndRemove(custodyId, entry)) {
-        error = true;
-    }
-    else {
-        ++numRemovals;
+    //unlink from the awaiting send list while the entry is still at its address in the hashmap (O(1), no list search)
+    catalog_entry_t * const entryInMapPtr = m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId);
+    if (entryInMapPtr == NULL) {
+        return std::pair<bool, uint16_t>(false, 0);
     }
-    if ((!error) && alsoNeedsRemovedFromAwaitingSend) {
-        if (!RemoveEntryFromAwaitingSend(entry, custodyId)) {
+    if (alsoNeedsRemovedFromAwaitingSend) {
+        if (!RemoveEntryFromAwaitingSend(*entryInMapPtr, custodyId)) {
             error = true;
         }
         else {
             ++numRemovals;
         }
     }
-    if (entry.HasCustodyAndFragmentation()) {
+    else if (entryInMapPtr->IsAwaitingSend()) {
+        //never leave a dangling entry in an awaiting send list
+        RemoveEntryFromAwaitingSend(*entryInMapPtr, custodyId);
+    }
+    if (!m_custodyIdToCatalogEntryHashmap.GetValueAndRemove(custodyId, removedEntry)) {
+        return std::pair<bool, uint16_t>(false, numRemovals);
+    }
+    ++numRemovals;
+    --m_numEntries;
+    if (removedEntry.HasCustodyAndFragmentation()) {
         uint64_t cidInMap;
-        const cbhe_bundle_uuid_t* uuidPtr = (const cbhe_bundle_uuid_t*)entry.ptrUuidKeyInMap;
+        const cbhe_bundle_uuid_t* uuidPtr = (const cbhe_bundle_uuid_t*)removedEntry.ptrUuidKeyInMap;
         if ((uuidPtr == NULL) || (!m_uuidToCustodyIdHashMap.GetValueAndRemove(*uuidPtr, cidInMap))) {
             error = true;
         }
         else {
             ++numRemovals;
-        }
-        if (cidInMap != custodyId) {
-            error = true;
+            if (cidInMap != custodyId) {
+                error = true;
+            }
         }
     }
-    if (entry.HasCustodyAndNonFragmentation()) {
+    if (removedEntry.HasCustodyAndNonFragmentation()) {
         uint64_t cidInMap;
-        const cbhe_bundle_uuid_nofragment_t* uuidPtr = (const cbhe_bundle_uuid_nofragment_t*)entry.ptrUuidKeyInMap;
+        const cbhe_bundle_uuid_nofragment_t* uuidPtr = (const cbhe_bundle_uuid_nofragment_t*)removedEntry.ptrUuidKeyInMap;
         if ((uuidPtr == NULL) || (!m_uuidNoFragToCustodyIdHashMap.GetValueAndRemove(*uuidPtr, cidInMap))) {
             error = true;
         }
         else {
             ++numRemovals;
-        }
-        if (cidInMap != custodyId) {
-            error = true;
+            if (cidInMap != custodyId) {
+                error = true;
+            }
         }
     }
     
     return std::pair<bool, uint16_t>(!error, numRemovals);
 }
+std::size_t BundleStorageCatalog::RemoveCustodyIdRange(const uint64_t firstCustodyId, const uint64_t lastCustodyId,
+    bool alsoNeedsRemovedFromAwaitingSend, std::vector<catalog_entry_t> & removedEntries)
+{
+    std::size_t numRemoved = 0;
+    for (uint64_t custodyId = firstCustodyId; custodyId <= lastCustodyId; ++custodyId) {
+        if (m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId) != NULL) { //gaps in the range are expected (i.e. already deleted)
+            removedEntries.emplace_back();
+            if (!Remove(custodyId, alsoNeedsRemovedFromAwaitingSend, removedEntries.back()).first) {
+                std::cout << "error in BundleStorageCatalog::RemoveCustodyIdRange: custody id " << custodyId << " was not cleanly removed\n";
+            }
+            ++numRemoved;
+        }
+        if (custodyId == UINT64_MAX) {
+            break;
+        }
+    }
+    return numRemoved;
+}
 catalog_entry_t * BundleStorageCatalog::GetEntryFromCustodyId(const uint64_t custodyId) {
     return m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId);
 }
@@ -346,3 +380,44 @@ uint64_t * BundleStorageCatalog::GetCustodyIdFromUuid(const cbhe_bundle_uuid_t &
 uint64_t * BundleStorageCatalog::GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid) {
     return m_uuidNoFragToCustodyIdHashMap.GetValuePtr(bundleUuid);
 }
+uint64_t BundleStorageCatalog::GetNumEntries() const {
+    return m_numEntries;
+}
+
+//a pair is stale if its custody id was removed from the catalog (or was reused by a bundle with a different expiration)
+bool BundleStorageCatalog::IsExpirationPairStale(const expiration_custid_pair_t & expirationCustodyIdPair) {
+    const catalog_entry_t * entryPtr = m_custodyIdToCatalogEntryHashmap.GetValuePtr(expirationCustodyIdPair.second);
+    return ((entryPtr == NULL) || (entryPtr->GetAbsExpiration() != expirationCustodyIdPair.first));
+}
+
+void BundleStorageCatalog::CompactExpirationHeap() {
+    std::vector<expiration_custid_pair_t> livePairs;
+    livePairs.reserve(m_numEntries);
+    while (!m_expirationCustodyIdMinHeap.empty()) {
+        const expiration_custid_pair_t & top = m_expirationCustodyIdMinHeap.top();
+        if (!IsExpirationPairStale(top)) {
+            livePairs.push_back(top);
+        }
+        m_expirationCustodyIdMinHeap.pop();
+    }
+    //already sorted ascending, which satisfies the heap property of a min-heap
+    m_expirationCustodyIdMinHeap = expiration_custid_min_heap_t(std::greater<expiration_custid_pair_t>(), std::move(livePairs));
+}
+
+std::size_t BundleStorageCatalog::PopExpiredCustodyIds(const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxCustodyIds, std::vector<uint64_t> & expiredCustodyIds) {
+    std::size_t numAppended = 0;
+    while ((numAppended < maxCustodyIds) && (!m_expirationCustodyIdMinHeap.empty())) {
+        const expiration_custid_pair_t top = m_expirationCustodyIdMinHeap.top();
+        if (IsExpirationPairStale(top)) {
+            m_expirationCustodyIdMinHeap.pop();
+            continue;
+        }
+        if (top.first > nowSecondsSinceStartOfYear2000) {
+            break; //nothing else has expired
+        }
+        m_expirationCustodyIdMinHeap.pop();
+        expiredCustodyIds.push_back(top.second);
+        ++numAppended;
+    }
+    return numAppended;
+}
@@ -130,7 +130,7 @@ void BundleStorageManagerAsio::TryDiskOperation_Consume_NotThreadSafe(const unsi
                 //continue;
             }
 
-            const boost::uint64_t offsetBytes = static_cast<boost::uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            const boost::uint64_t offsetBytes = SegmentIdToDiskOffsetBytes(segmentId);
 
 #ifdef _WIN32
 
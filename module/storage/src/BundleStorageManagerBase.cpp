@@ -15,6 +15,7 @@
 #include "BundleStorageManagerBase.h"
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/make_unique.hpp>
@@ -69,11 +70,12 @@ BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & sto
     M_NUM_STORAGE_DISKS((m_storageConfigPtr) ? static_cast<unsigned int>(m_storageConfigPtr->m_storageDiskConfigVector.size()) : 1),
     M_TOTAL_STORAGE_CAPACITY_BYTES((m_storageConfigPtr) ? m_storageConfigPtr->m_totalStorageCapacityBytes : 1),
     M_MAX_SEGMENTS(M_TOTAL_STORAGE_CAPACITY_BYTES / SEGMENT_SIZE),
+    M_DISK_EXTENT_SIZE_SEGMENTS(((m_storageConfigPtr) && (m_storageConfigPtr->m_diskExtentSizeSegmentsOrZeroToDisable)) ? m_storageConfigPtr->m_diskExtentSizeSegmentsOrZeroToDisable : 1),
     m_memoryManager(M_MAX_SEGMENTS),
     m_lockMainThread(m_mutexMainThread),
     m_filePathsVec(M_NUM_STORAGE_DISKS),
     m_filePathsAsStringVec(M_NUM_STORAGE_DISKS),
-    m_circularIndexBuffersVec(M_NUM_STORAGE_DISKS, CircularIndexBufferSingleProducerSingleConsumerConfigurable(CIRCULAR_INDEX_BUFFER_SIZE)),
+    m_circularIndexBuffersVec(M_NUM_STORAGE_DISKS, CircularIndexBufferSingleProducerSingleConsumerConfigurable(CIRCULAR_INDEX_BUFFER_SIZE, true)), //blocking wait when full/empty
     m_autoDeleteFilesOnExit((m_storageConfigPtr) ? m_storageConfigPtr->m_autoDeleteFilesOnExit : false),
     m_successfullyRestoredFromDisk(false),
     m_totalBundlesRestored(0),
@@ -160,12 +162,11 @@ int BundleStorageManagerBase::PushSegment(BundleStorageManagerSession_WriteToDis
     StorageSegmentHeader storageSegmentHeader;
     storageSegmentHeader.bundleSizeBytes = (session.nextLogicalSegment == 0) ? catalogEntry.bundleSizeBytes : UINT64_MAX;
     const segment_id_t segmentId = segmentIdChainVec[session.nextLogicalSegment++];
-    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+    const unsigned int diskIndex = SegmentIdToDiskIndex(segmentId);
     CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
     unsigned int produceIndex = cb.GetIndexForWrite();
-    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //store the volatile, wait until not full				
-        m_conditionVariableMainThread.timed_wait(m_lockMainThread, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-        //thread is now unblocked, and the lock is reacquired by invoking lock.lock()	
+    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //wait until not full
+        cb.WaitUntilNotFull(); //blocks until the disk thread's CommitRead()
         produceIndex = cb.GetIndexForWrite();
     }
 
@@ -273,6 +274,22 @@ bool BundleStorageManagerBase::ReturnCustodyIdToAwaitingSend(const uint64_t cust
 catalog_entry_t * BundleStorageManagerBase::GetCatalogEntryPtrFromCustodyId(const uint64_t custodyId) { //NULL if unavailable
     return m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
 }
+std::size_t BundleStorageManagerBase::PopExpiredCustodyIds(const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxCustodyIds, std::vector<uint64_t> & expiredCustodyIds) {
+    return m_bundleStorageCatalog.PopExpiredCustodyIds(nowSecondsSinceStartOfYear2000, maxCustodyIds, expiredCustodyIds);
+}
+uint64_t BundleStorageManagerBase::StartReadByCustodyId(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t custodyId) { //0 if not found, size if entry
+    session.catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
+    if (session.catalogEntryPtr == NULL) {
+        return 0;
+    }
+    session.custodyId = custodyId;
+    session.nextLogicalSegment = 0;
+    session.nextLogicalSegmentToCache = 0;
+    session.cacheReadIndex = 0;
+    session.cacheWriteIndex = 0;
+
+    return session.catalogEntryPtr->bundleSizeBytes;
+}
 
 std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_ReadFromDisk & session, void * buf) {
     const segment_id_chain_vec_t & segments = session.catalogEntryPtr->segmentIdChainVec;
@@ -281,12 +298,11 @@ std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_Rea
         && (session.nextLogicalSegmentToCache < segments.size()))
     {
         const segment_id_t segmentId = segments[session.nextLogicalSegmentToCache++];
-        const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+        const unsigned int diskIndex = SegmentIdToDiskIndex(segmentId);
         CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
         unsigned int produceIndex = cb.GetIndexForWrite();
-        while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //store the volatile, wait until not full				
-            m_conditionVariableMainThread.timed_wait(m_lockMainThread, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()	
+        while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //wait until not full
+            cb.WaitUntilNotFull(); //blocks until the disk thread's CommitRead()
             produceIndex = cb.GetIndexForWrite();
         }
 
@@ -371,18 +387,40 @@ bool BundleStorageManagerBase::RemoveReadBundleFromDisk(BundleStorageManagerSess
 }
 bool BundleStorageManagerBase::RemoveReadBundleFromDisk(const catalog_entry_t * catalogEntryPtr, const uint64_t custodyId) {
     const segment_id_chain_vec_t & segmentIdChainVec = catalogEntryPtr->segmentIdChainVec;
-
-    //destroy the head on the disk by writing UINT64_MAX to bundleSizeBytes of first logical segment
-
-
+    InvalidateBundleHeadOnDisk(segmentIdChainVec[0]);
+    const bool successFreedSegments = m_memoryManager.FreeSegments_ThreadSafe(segmentIdChainVec);
+    return (m_bundleStorageCatalog.Remove(custodyId, false).first && successFreedSegments);
+}
+uint64_t BundleStorageManagerBase::RemoveReadBundlesFromDisk(const uint64_t firstCustodyId, const uint64_t lastCustodyId, std::vector<catalog_entry_t> & removedEntries) {
+    const std::size_t startIndex = removedEntries.size();
+    const std::size_t numRemoved = m_bundleStorageCatalog.RemoveCustodyIdRange(firstCustodyId, lastCustodyId, false, removedEntries);
+    std::size_t totalSegments = 0;
+    for (std::size_t i = startIndex; i < removedEntries.size(); ++i) {
+        totalSegments += removedEntries[i].segmentIdChainVec.size();
+    }
+    segment_id_chain_vec_t segmentIdsToFree;
+    segmentIdsToFree.reserve(totalSegments);
+    for (std::size_t i = startIndex; i < removedEntries.size(); ++i) {
+        const segment_id_chain_vec_t & segmentIdChainVec = removedEntries[i].segmentIdChainVec;
+        InvalidateBundleHeadOnDisk(segmentIdChainVec[0]);
+        segmentIdsToFree.insert(segmentIdsToFree.end(), segmentIdChainVec.cbegin(), segmentIdChainVec.cend());
+    }
+    if ((!segmentIdsToFree.empty()) && (!m_memoryManager.FreeSegments_ThreadSafe(segmentIdsToFree))) {
+        const std::string msg = "error in RemoveReadBundlesFromDisk: unable to free segments of custody ids "
+            + boost::lexical_cast<std::string>(firstCustodyId) + " to " + boost::lexical_cast<std::string>(lastCustodyId);
+        std::cerr << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+    }
+    return numRemoved;
+}
+//destroy the head on the disk by writing UINT64_MAX to bundleSizeBytes of first logical segment
+void BundleStorageManagerBase::InvalidateBundleHeadOnDisk(const segment_id_t segmentId) {
     static const uint64_t bundleSizeBytesLittleEndian = UINT64_MAX;
-    const segment_id_t segmentId = segmentIdChainVec[0];
-    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+    const unsigned int diskIndex = SegmentIdToDiskIndex(segmentId);
     CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
     unsigned int produceIndex = cb.GetIndexForWrite();
-    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //store the volatile, wait until not full				
-        m_conditionVariableMainThread.timed_wait(m_lockMainThread, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-        //thread is now unblocked, and the lock is reacquired by invoking lock.lock()	
+    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //wait until not full
+        cb.WaitUntilNotFull(); //blocks until the disk thread's CommitRead()
         produceIndex = cb.GetIndexForWrite();
     }
 
@@ -399,9 +437,6 @@ bool BundleStorageManagerBase::RemoveReadBundleFromDisk(const catalog_entry_t *
 
     cb.CommitWrite();
     NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
-
-    const bool successFreedSegments = m_memoryManager.FreeSegments_ThreadSafe(segmentIdChainVec);
-    return (m_bundleStorageCatalog.Remove(custodyId, false).first && successFreedSegments);
 }
 uint64_t * BundleStorageManagerBase::GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid) {
     return m_bundleStorageCatalog.GetCustodyIdFromUuid(bundleUuid);
@@ -444,10 +479,24 @@ bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored,
         }
     }
 
-    bool restoreInProgress = true;
+    uint64_t largestFileSize = 0;
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        largestFileSize = std::max(largestFileSize, fileSizesVec[diskId]);
+    }
+    const uint64_t numSegmentIdsPerStripeRow = M_DISK_EXTENT_SIZE_SEGMENTS * M_NUM_STORAGE_DISKS;
+
     BundleViewV6 bv6;
     BundleViewV7 bv7;
-    for (segment_id_t potentialHeadSegmentId = 0; restoreInProgress; ++potentialHeadSegmentId) {
+    for (segment_id_t potentialHeadSegmentId = 0; ; ++potentialHeadSegmentId) {
+        //every disk offset of the stripe row containing potentialHeadSegmentId (and all later rows) is beyond the end of every file
+        if ((potentialHeadSegmentId >= M_MAX_SEGMENTS) ||
+            (((potentialHeadSegmentId / numSegmentIdsPerStripeRow) * M_DISK_EXTENT_SIZE_SEGMENTS * SEGMENT_SIZE) >= largestFileSize))
+        {
+            static const std::string msg = "end of restore";
+            std::cout << msg << "\n";
+            hdtn::Logger::getInstance()->logNotification("storage", msg);
+            break;
+        }
         if (!m_memoryManager.IsSegmentFree(potentialHeadSegmentId)) continue;
         segment_id_t segmentId = potentialHeadSegmentId;
         BundleStorageManagerSession_WriteToDisk session;
@@ -457,16 +506,12 @@ bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored,
         uint64_t custodyIdHeadSegment;
         PrimaryBlock * primaryBasePtr = NULL;
         for (session.nextLogicalSegment = 0; ; ++session.nextLogicalSegment) {
-            const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+            const unsigned int diskIndex = SegmentIdToDiskIndex(segmentId);
             FILE * const fileHandle = fileHandlesVec[diskIndex];
-            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            const uint64_t offsetBytes = SegmentIdToDiskOffsetBytes(segmentId);
             const uint64_t fileSize = fileSizesVec[diskIndex];
             if ((session.nextLogicalSegment == 0) && ((offsetBytes + SEGMENT_SIZE) > fileSize)) {
-                static const std::string msg = "end of restore";
-                std::cout << msg << "\n";
-                hdtn::Logger::getInstance()->logNotification("storage", msg);
-                restoreInProgress = false;
-                break;
+                break; //never written (but a later segment id on another disk may have been)
             }
 #ifdef _MSC_VER 
             _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
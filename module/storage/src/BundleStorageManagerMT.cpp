@@ -18,6 +18,13 @@
 #include <boost/filesystem.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/make_unique.hpp>
+#if !defined(_MSC_VER) && !defined(__APPLE__)
+# define USE_PREADV_PWRITEV 1
+# include <sys/types.h>
+# include <sys/uio.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 
 BundleStorageManagerMT::BundleStorageManagerMT() : BundleStorageManagerMT("storageConfig.json") {}
@@ -33,7 +40,6 @@ BundleStorageManagerMT::BundleStorageManagerMT(const std::string & jsonConfigFil
 BundleStorageManagerMT::BundleStorageManagerMT(const StorageConfig_ptr & storageConfigPtr) :
     BundleStorageManagerBase(storageConfigPtr),
 
-    m_conditionVariablesVec(M_NUM_STORAGE_DISKS),
     m_threadPtrsVec(M_NUM_STORAGE_DISKS),
     m_running(false)
 {
@@ -42,6 +48,9 @@ BundleStorageManagerMT::BundleStorageManagerMT(const StorageConfig_ptr & storage
 
 BundleStorageManagerMT::~BundleStorageManagerMT() {
     m_running = false; //thread stopping criteria
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        m_circularIndexBuffersVec[diskId].StopWaiting(); //wake the disk thread
+    }
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
         if (m_threadPtrsVec[diskId]) {
             m_threadPtrsVec[diskId]->join();
@@ -63,9 +72,6 @@ void BundleStorageManagerMT::Start() {
 
 void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
 
-    boost::mutex localMutex;
-    boost::mutex::scoped_lock lock(localMutex);
-    boost::condition_variable & cv = m_conditionVariablesVec[threadIndex];
     CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[threadIndex];
     const char * const filePath = m_storageConfigPtr->m_storageDiskConfigVector[threadIndex].storeFilePath.c_str();
     std::cout << ((m_successfullyRestoredFromDisk) ? "reopening " : "creating ") << filePath << "\n";
@@ -77,68 +83,123 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
     {
         hdtn::Logger::getInstance()->logNotification("storage", "Creating " + std::string(filePath));
     }
+#ifdef USE_PREADV_PWRITEV
+    const int fileDescriptor = (m_successfullyRestoredFromDisk) ? open(filePath, O_RDWR) : open(filePath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        std::cout << "error opening " << filePath << "\n";
+        hdtn::Logger::getInstance()->logError("storage", "Error opening " + std::string(filePath));
+    }
+    struct iovec iovecs[CIRCULAR_INDEX_BUFFER_SIZE];
+#else
     FILE * fileHandle = (m_successfullyRestoredFromDisk) ? fopen(filePath, "r+bR") : fopen(filePath, "w+bR");
+#endif
     boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
     segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+    volatile boost::uint8_t * volatile * const readFromStorageDestPointers = &m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+    volatile bool * volatile * const isReadCompletedPointers = &m_circularBufferIsReadCompletedPointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE];
 
     while (m_running || (cb.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY)) { //keep thread alive if running or cb not empty
 
-
-        const unsigned int consumeIndex = cb.GetIndexForRead(); //store the volatile
+        unsigned int numContiguousAvailable;
+        const unsigned int consumeIndex = cb.GetContiguousIndicesForRead(numContiguousAvailable); //store the volatile
 
         if (consumeIndex == CIRCULAR_INDEX_BUFFER_EMPTY) { //if empty
-            cv.timed_wait(lock, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            cb.WaitUntilNotEmpty(); //blocks until CommitWrite() or StopWaiting()
             continue;
         }
 
-        boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
-        const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
-        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
-        volatile bool * const isReadCompletedPointer = m_circularBufferIsReadCompletedPointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
-        const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
-        if (segmentId == SEGMENT_ID_LAST) {
+        const segment_id_t firstSegmentId = circularBufferSegmentIdsPtr[consumeIndex];
+        const bool isWriteToDisk = (readFromStorageDestPointers[consumeIndex] == NULL);
+        if (firstSegmentId == SEGMENT_ID_LAST) {
             std::cout << "error segmentId is last\n";
             hdtn::Logger::getInstance()->logError("storage", "Error segmentId is last");
             m_running = false;
             continue;
         }
 
-        const boost::uint64_t offsetBytes = static_cast<boost::uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
-#ifdef _MSC_VER 
-        _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
-#elif defined __APPLE__ 
-        fseeko(fileHandle, offsetBytes, SEEK_SET);
-#else
-        fseeko64(fileHandle, offsetBytes, SEEK_SET);
-#endif
+        //Gather the queued operations that are all reads or all writes of consecutive disk offsets
+        //(i.e. a contiguous run of segment ids within a disk extent) into a single disk transfer.
+        const boost::uint64_t offsetBytes = SegmentIdToDiskOffsetBytes(firstSegmentId);
+        unsigned int numSegmentsInRun = 1;
+        while (numSegmentsInRun < numContiguousAvailable) {
+            const unsigned int index = consumeIndex + numSegmentsInRun;
+            const segment_id_t segmentId = circularBufferSegmentIdsPtr[index];
+            if ((segmentId == SEGMENT_ID_LAST)
+                || ((readFromStorageDestPointers[index] == NULL) != isWriteToDisk)
+                || (SegmentIdToDiskOffsetBytes(segmentId) != (offsetBytes + (static_cast<boost::uint64_t>(numSegmentsInRun) * SEGMENT_SIZE))))
+            {
+                break;
+            }
+            ++numSegmentsInRun;
+        }
+        const std::size_t runSizeBytes = static_cast<std::size_t>(numSegmentsInRun) * SEGMENT_SIZE;
 
+#ifdef USE_PREADV_PWRITEV
+        for (unsigned int i = 0; i < numSegmentsInRun; ++i) {
+            const unsigned int index = consumeIndex + i;
+            iovecs[i].iov_base = (isWriteToDisk) ? (void*)&circularBufferBlockDataPtr[index * SEGMENT_SIZE] : (void*)readFromStorageDestPointers[index];
+            iovecs[i].iov_len = SEGMENT_SIZE;
+        }
         if (isWriteToDisk) {
-            if (fwrite(data, 1, SEGMENT_SIZE, fileHandle) != SEGMENT_SIZE) {
+            if (pwritev(fileDescriptor, iovecs, static_cast<int>(numSegmentsInRun), static_cast<off_t>(offsetBytes)) != static_cast<ssize_t>(runSizeBytes)) {
                 std::cout << "error writing\n";
                 hdtn::Logger::getInstance()->logError("storage", "Error writing");
             }
         }
         else { //read from disk
-            if (fread((void*)readFromStorageDestPointer, 1, SEGMENT_SIZE, fileHandle) != SEGMENT_SIZE) {
+            if (preadv(fileDescriptor, iovecs, static_cast<int>(numSegmentsInRun), static_cast<off_t>(offsetBytes)) != static_cast<ssize_t>(runSizeBytes)) {
                 std::cout << "error reading\n";
                 hdtn::Logger::getInstance()->logError("storage", "Error reading");
             }
-            *isReadCompletedPointer = true;
+        }
+#else
+# ifdef _MSC_VER 
+        _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
+# elif defined __APPLE__ 
+        fseeko(fileHandle, offsetBytes, SEEK_SET);
+# else
+        fseeko64(fileHandle, offsetBytes, SEEK_SET);
+# endif
+
+        if (isWriteToDisk) { //the circular buffer slots of the run are contiguous in memory
+            if (fwrite(&circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE], 1, runSizeBytes, fileHandle) != runSizeBytes) {
+                std::cout << "error writing\n";
+                hdtn::Logger::getInstance()->logError("storage", "Error writing");
+            }
+        }
+        else { //read from disk (sequentially, without seeking)
+            for (unsigned int i = 0; i < numSegmentsInRun; ++i) {
+                if (fread((void*)readFromStorageDestPointers[consumeIndex + i], 1, SEGMENT_SIZE, fileHandle) != SEGMENT_SIZE) {
+                    std::cout << "error reading\n";
+                    hdtn::Logger::getInstance()->logError("storage", "Error reading");
+                }
+            }
+        }
+#endif
+        if (!isWriteToDisk) {
+            for (unsigned int i = 0; i < numSegmentsInRun; ++i) {
+                *isReadCompletedPointers[consumeIndex + i] = true;
+            }
         }
 
 
-        cb.CommitRead();
+        cb.CommitReads(numSegmentsInRun);
         m_conditionVariableMainThread.notify_one();
     }
 
+#ifdef USE_PREADV_PWRITEV
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+#else
     if (fileHandle) {
         fclose(fileHandle);
         fileHandle = NULL;
     }
+#endif
 }
 
 //virtual function to be called immediately after a disk's circular buffer CommitWrite();
-void BundleStorageManagerMT::NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) {
-    m_conditionVariablesVec[diskId].notify_one();
+void BundleStorageManagerMT::NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int /*diskId*/) {
+    //nothing to do, the circular buffer's CommitWrite() already woke the disk thread blocked in WaitUntilNotEmpty()
 }
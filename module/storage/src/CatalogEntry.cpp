@@ -20,7 +20,11 @@ catalog_entry_t::catalog_entry_t() :
     bundleSizeBytes(0),
     encodedAbsExpirationAndCustodyAndPriority(0),
     sequence(0),
-    ptrUuidKeyInMap(NULL) { } //a default constructor: X()
+    ptrUuidKeyInMap(NULL),
+    custodyId(0),
+    awaitingSendListPtr(NULL),
+    prevAwaitingSend(NULL),
+    nextAwaitingSend(NULL) { } //a default constructor: X()
 catalog_entry_t::~catalog_entry_t() { } //a destructor: ~X()
 catalog_entry_t::catalog_entry_t(const catalog_entry_t& o) :
     bundleSizeBytes(o.bundleSizeBytes),
@@ -28,14 +32,22 @@ catalog_entry_t::catalog_entry_t(const catalog_entry_t& o) :
     destEid(o.destEid),
     encodedAbsExpirationAndCustodyAndPriority(o.encodedAbsExpirationAndCustodyAndPriority),
     sequence(o.sequence),
-    ptrUuidKeyInMap(o.ptrUuidKeyInMap) { } //a copy constructor: X(const X&)
+    ptrUuidKeyInMap(o.ptrUuidKeyInMap),
+    custodyId(o.custodyId),
+    awaitingSendListPtr(NULL),
+    prevAwaitingSend(NULL),
+    nextAwaitingSend(NULL) { } //a copy constructor: X(const X&)
 catalog_entry_t::catalog_entry_t(catalog_entry_t&& o) :
     bundleSizeBytes(o.bundleSizeBytes),
     segmentIdChainVec(std::move(o.segmentIdChainVec)),
     destEid(o.destEid),
     encodedAbsExpirationAndCustodyAndPriority(o.encodedAbsExpirationAndCustodyAndPriority),
     sequence(o.sequence),
-    ptrUuidKeyInMap(o.ptrUuidKeyInMap) { } //a move constructor: X(X&&)
+    ptrUuidKeyInMap(o.ptrUuidKeyInMap),
+    custodyId(o.custodyId),
+    awaitingSendListPtr(NULL),
+    prevAwaitingSend(NULL),
+    nextAwaitingSend(NULL) { } //a move constructor: X(X&&)
 catalog_entry_t& catalog_entry_t::operator=(const catalog_entry_t& o) { //a copy assignment: operator=(const X&)
     bundleSizeBytes = o.bundleSizeBytes;
     segmentIdChainVec = o.segmentIdChainVec;
@@ -43,6 +55,7 @@ catalog_entry_t& catalog_entry_t::operator=(const catalog_entry_t& o) { //a copy
     encodedAbsExpirationAndCustodyAndPriority = o.encodedAbsExpirationAndCustodyAndPriority;
     sequence = o.sequence;
     ptrUuidKeyInMap = o.ptrUuidKeyInMap;
+    custodyId = o.custodyId;
     return *this;
 }
 catalog_entry_t& catalog_entry_t::operator=(catalog_entry_t && o) { //a move assignment: operator=(X&&)
@@ -52,6 +65,7 @@ catalog_entry_t& catalog_entry_t::operator=(catalog_entry_t && o) { //a move ass
     encodedAbsExpirationAndCustodyAndPriority = o.encodedAbsExpirationAndCustodyAndPriority;
     sequence = o.sequence;
     ptrUuidKeyInMap = o.ptrUuidKeyInMap;
+    custodyId = o.custodyId;
     return *this;
 }
 bool catalog_entry_t::operator==(const catalog_entry_t & o) const {
@@ -61,7 +75,8 @@ bool catalog_entry_t::operator==(const catalog_entry_t & o) const {
         (destEid == o.destEid) &&
         (encodedAbsExpirationAndCustodyAndPriority == o.encodedAbsExpirationAndCustodyAndPriority) &&
         (sequence == o.sequence) &&
-        (ptrUuidKeyInMap == o.ptrUuidKeyInMap);
+        (ptrUuidKeyInMap == o.ptrUuidKeyInMap) &&
+        (custodyId == o.custodyId);
 }
 bool catalog_entry_t::operator!=(const catalog_entry_t & o) const {
     return
@@ -70,7 +85,8 @@ bool catalog_entry_t::operator!=(const catalog_entry_t & o) const {
         (destEid != o.destEid) ||
         (encodedAbsExpirationAndCustodyAndPriority != o.encodedAbsExpirationAndCustodyAndPriority) ||
         (sequence != o.sequence) ||
-        (ptrUuidKeyInMap != o.ptrUuidKeyInMap);
+        (ptrUuidKeyInMap != o.ptrUuidKeyInMap) ||
+        (custodyId != o.custodyId);
 }
 bool catalog_entry_t::operator<(const catalog_entry_t & o) const {
     return (segmentIdChainVec[0] < o.segmentIdChainVec[0]);
@@ -79,7 +95,7 @@ uint8_t catalog_entry_t::GetPriorityIndex() const {
     return static_cast<uint8_t>(encodedAbsExpirationAndCustodyAndPriority & 3);
 }
 uint64_t catalog_entry_t::GetAbsExpiration() const {
-    return encodedAbsExpirationAndCustodyAndPriority >> 4;
+    return encodedAbsExpirationAndCustodyAndPriority >> 5;
 }
 bool catalog_entry_t::HasCustodyAndFragmentation() const {
     return ((encodedAbsExpirationAndCustodyAndPriority & (1U << 2)) != 0);
@@ -90,10 +106,16 @@ bool catalog_entry_t::HasCustodyAndNonFragmentation() const {
 bool catalog_entry_t::HasCustody() const {
     return ((encodedAbsExpirationAndCustodyAndPriority & ((1U << 2) | (1U << 3)) ) != 0);
 }
+bool catalog_entry_t::IsDeletionStatusReportRequired() const {
+    return ((encodedAbsExpirationAndCustodyAndPriority & (1U << 4)) != 0);
+}
+bool catalog_entry_t::IsAwaitingSend() const {
+    return (awaitingSendListPtr != NULL);
+}
 void catalog_entry_t::Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, const uint64_t paramNumSegmentsRequired, void * paramPtrUuidKeyInMap) {
     bundleSizeBytes = paramBundleSizeBytes;
     destEid = primary.GetFinalDestinationEid();
-    encodedAbsExpirationAndCustodyAndPriority = primary.GetPriority() | (primary.GetExpirationSeconds() << 4);
+    encodedAbsExpirationAndCustodyAndPriority = primary.GetPriority() | (primary.GetExpirationSeconds() << 5);
     if (primary.HasCustodyFlagSet()) {
         if (primary.HasFragmentationFlagSet()) {
             encodedAbsExpirationAndCustodyAndPriority |= (1U << 2); //HasCustodyAndFragmentation
@@ -102,6 +124,10 @@ void catalog_entry_t::Init(const PrimaryBlock & primary, const uint64_t paramBun
             encodedAbsExpirationAndCustodyAndPriority |= (1U << 3); //HasCustodyAndNonFragmentation
         }
     }
+    //a custodian must report the deletion of a bundle (rfc5050 5.13), otherwise only if the source requested it
+    if (primary.HasCustodyFlagSet() || primary.HasDeletionStatusReportsRequested()) {
+        encodedAbsExpirationAndCustodyAndPriority |= (1U << 4); //IsDeletionStatusReportRequired
+    }
     ptrUuidKeyInMap = paramPtrUuidKeyInMap;
     sequence = primary.GetSequenceForSecondsScale();
     segmentIdChainVec.resize(paramNumSegmentsRequired);
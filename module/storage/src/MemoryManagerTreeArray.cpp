@@ -17,6 +17,9 @@
 #include <iostream>
 #include <string>
 #include <inttypes.h>
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
 #ifdef USE_BITTEST
 # include <immintrin.h>
 # ifdef HAVE_INTRIN_H
@@ -35,7 +38,19 @@
 # endif
 #endif //USE_BITTEST or USE_ANDN
 
-MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) : M_MAX_SEGMENTS(maxSegments), m_bitMasks(MAX_TREE_ARRAY_DEPTH) {
+static unsigned int PopCount64(const uint64_t value) {
+#ifdef _MSC_VER
+    return static_cast<unsigned int>(__popcnt64(value));
+#else
+    return static_cast<unsigned int>(__builtin_popcountll(value));
+#endif
+}
+
+MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) :
+    M_MAX_SEGMENTS(maxSegments),
+    m_bitMasks(MAX_TREE_ARRAY_DEPTH),
+    m_numFreeSegments(maxSegments)
+{
 #if 0
     AllocateRowsMaxMemory();
 #else
@@ -57,6 +72,10 @@ bool MemoryManagerTreeArray::IsBackupEqual(const memmanager_t & backup) const {
     return (backup == m_bitMasks);
 }
 
+uint64_t MemoryManagerTreeArray::GetNumFreeSegments() const {
+    return m_numFreeSegments;
+}
+
 /** Private function to allocate and get the first available free segment number in numerical order.  Requires 6 recursive calls (depth first).
 * This function is used by the public function GetAndSetFirstFreeSegmentId_NotThreadSafe()
 *
@@ -97,9 +116,92 @@ segment_id_t MemoryManagerTreeArray::GetAndSetFirstFreeSegmentId_NotThreadSafe()
     segment_id_t segmentId = 0;
     GetAndSetFirstFreeSegmentId(0, segmentId);
     if (segmentId >= M_MAX_SEGMENTS) return SEGMENT_ID_FULL;
+    --m_numFreeSegments;
     return segmentId;
 }
 
+/** Private function to allocate, in numerical order, up to maxSegmentIds free segments from the first leaf uint64_t that has a free segment.
+* Only one descent of the tree is required per 64 segments (versus one descent per segment for GetAndSetFirstFreeSegmentId).
+* This function is used by the public function AllocateSegments_ThreadSafe()
+*
+* @param segmentIds The array to write the allocated segment Ids to.
+* @param maxSegmentIds The max number of segment Ids to allocate (must be nonzero).
+* @return The number of segment Ids allocated (between 1 and 64), or 0 if the MemoryManagerTreeArray is full.
+* @post The internal data structures (except m_numFreeSegments) are updated for the allocated segment Ids.
+*/
+std::size_t MemoryManagerTreeArray::GetAndSetFirstFreeSegmentIdsInLeaf(segment_id_t * segmentIds, const std::size_t maxSegmentIds) {
+    if (m_bitMasks[0][0] == 0) return 0; //full (prevent undefined behavior in boost::multiprecision::detail::find_lsb)
+    segment_id_t longIndex = 0;
+    for (segment_id_t depthIndex = 0; depthIndex < (MAX_TREE_ARRAY_DEPTH - 1); ++depthIndex) {
+        longIndex = (longIndex << 6) | boost::multiprecision::detail::find_lsb<uint64_t>(m_bitMasks[depthIndex][longIndex]);
+    }
+    uint64_t & leafRef = m_bitMasks[MAX_TREE_ARRAY_DEPTH - 1][longIndex];
+    const uint64_t firstSegmentIdOfLeaf = static_cast<uint64_t>(longIndex) << 6;
+    uint64_t available = leafRef;
+    if ((firstSegmentIdOfLeaf + 64) > M_MAX_SEGMENTS) { //last leaf: the bits at or beyond M_MAX_SEGMENTS are never allocated
+        available = (firstSegmentIdOfLeaf >= M_MAX_SEGMENTS) ? 0 : (available & ((((uint64_t)1) << (M_MAX_SEGMENTS - firstSegmentIdOfLeaf)) - 1));
+    }
+    std::size_t numAllocated = 0;
+    if ((available == UINT64_MAX) && (maxSegmentIds >= 64)) { //entire leaf is one contiguous run
+        for (unsigned int bitIndex = 0; bitIndex < 64; ++bitIndex) {
+            segmentIds[bitIndex] = static_cast<segment_id_t>(firstSegmentIdOfLeaf + bitIndex);
+        }
+        numAllocated = 64;
+        leafRef = 0;
+    }
+    else {
+        uint64_t allocatedMask = 0;
+        while (available && (numAllocated < maxSegmentIds)) {
+            const unsigned int bitIndex = boost::multiprecision::detail::find_lsb<uint64_t>(available);
+            segmentIds[numAllocated++] = static_cast<segment_id_t>(firstSegmentIdOfLeaf + bitIndex);
+            allocatedMask |= (((uint64_t)1) << bitIndex);
+            available &= (available - 1); //clear lowest set bit
+        }
+#if defined(USE_ANDN) && !defined(USE_BITTEST)
+        leafRef = _andn_u64(allocatedMask, leafRef);
+#else
+        leafRef &= (~allocatedMask);
+#endif
+    }
+    if (leafRef == 0) {
+        ClearParentBitsOfFullLeaf(longIndex);
+    }
+    return numAllocated;
+}
+
+/** Private function to mark a leaf uint64_t (that just became full) as full in its parent rows.
+*
+* @param leafLongIndex The index of the leaf uint64_t within the leaf row.
+*/
+void MemoryManagerTreeArray::ClearParentBitsOfFullLeaf(segment_id_t leafLongIndex) {
+    for (segment_id_t depth = MAX_TREE_ARRAY_DEPTH - 1; depth != 0; --depth) {
+        const segment_id_t bitIndex = leafLongIndex & 63;
+        leafLongIndex >>= 6; //divide by 64 bits per ui64
+        uint64_t & longRef = m_bitMasks[depth - 1][leafLongIndex];
+        longRef &= (~(((uint64_t)1) << bitIndex));
+        if (longRef != 0) { //parent still has free children
+            break;
+        }
+    }
+}
+
+/** Private function to mark a leaf uint64_t (that was full and now has a free segment) as not full in its parent rows.
+*
+* @param leafLongIndex The index of the leaf uint64_t within the leaf row.
+*/
+void MemoryManagerTreeArray::SetParentBitsOfLeaf(segment_id_t leafLongIndex) {
+    for (segment_id_t depth = MAX_TREE_ARRAY_DEPTH - 1; depth != 0; --depth) {
+        const segment_id_t bitIndex = leafLongIndex & 63;
+        leafLongIndex >>= 6; //divide by 64 bits per ui64
+        uint64_t & longRef = m_bitMasks[depth - 1][leafLongIndex];
+        const uint64_t mask64 = (((uint64_t)1) << bitIndex);
+        if (longRef & mask64) { //already marked not full (so are all of its parents)
+            break;
+        }
+        longRef |= mask64;
+    }
+}
+
 bool MemoryManagerTreeArray::IsSegmentFree(const segment_id_t segmentId) const {
     if (segmentId >= M_MAX_SEGMENTS) return false;
     //just look at the leaf node
@@ -134,6 +236,7 @@ bool MemoryManagerTreeArray::FreeSegmentId_NotThreadSafe(const segment_id_t segm
             return false;
         }
     }
+    ++m_numFreeSegments;
     for (segment_id_t depth = MAX_TREE_ARRAY_DEPTH - 1; depth != 0; --depth) {
         const segment_id_t bitIndex = longIndex & 63;
         longIndex >>= 6; //divide by 64 bits per ui64
@@ -201,6 +304,7 @@ bool MemoryManagerTreeArray::AllocateSegmentId_NotThreadSafe(const segment_id_t
         }
         childIsFull = (longRef == 0);
     }
+    --m_numFreeSegments;
     for (segment_id_t depth = MAX_TREE_ARRAY_DEPTH - 1; ((depth != 0) && (childIsFull)); --depth) {
         const segment_id_t bitIndex = longIndex & 63;
         longIndex >>= 6; //divide by 64 bits per ui64
@@ -224,18 +328,22 @@ bool MemoryManagerTreeArray::AllocateSegmentId_NotThreadSafe(const segment_id_t
 bool MemoryManagerTreeArray::AllocateSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec) { //number of segments should be the vector size
     boost::mutex::scoped_lock lock(m_mutex);
     const std::size_t size = segmentVec.size();
-    for (std::size_t i = 0; i < size; ++i) {
-        const segment_id_t segmentId = GetAndSetFirstFreeSegmentId_NotThreadSafe();
-        if (segmentId != SEGMENT_ID_FULL) { //success
-            segmentVec[i] = segmentId;
-        }
-        else { //fail
-            for (std::size_t j = 0; j < i; ++j) {
+    if (size > m_numFreeSegments) { //fail fast without a partial allocation to undo
+        segmentVec.resize(0);
+        return false;
+    }
+    std::size_t numAllocated = 0;
+    while (numAllocated < size) {
+        const std::size_t numAllocatedFromLeaf = GetAndSetFirstFreeSegmentIdsInLeaf(&segmentVec[numAllocated], size - numAllocated);
+        if (numAllocatedFromLeaf == 0) { //fail (should never happen given m_numFreeSegments)
+            for (std::size_t j = 0; j < numAllocated; ++j) {
                 FreeSegmentId_NotThreadSafe(segmentVec[j]);
             }
             segmentVec.resize(0);
             return false;
         }
+        m_numFreeSegments -= numAllocatedFromLeaf;
+        numAllocated += numAllocatedFromLeaf;
     }
     return true;
 }
@@ -244,9 +352,44 @@ bool MemoryManagerTreeArray::FreeSegments_ThreadSafe(const segment_id_chain_vec_
     boost::mutex::scoped_lock lock(m_mutex);
     const std::size_t size = segmentVec.size();
     bool success = true;
-    for (std::size_t i = 0; i < size; ++i) {
-        if (!FreeSegmentId_NotThreadSafe(segmentVec[i])) {
+    std::size_t i = 0;
+    while (i < size) {
+        const segment_id_t firstSegmentId = segmentVec[i];
+        if (firstSegmentId >= M_MAX_SEGMENTS) {
             success = false;
+            ++i;
+            continue;
+        }
+        //gather the run of segment Ids that share this leaf uint64_t
+        const segment_id_t longIndex = firstSegmentId >> 6; //divide by 64 bits per ui64
+        uint64_t freeMask = 0;
+        for ( ; i < size; ++i) {
+            const segment_id_t segmentId = segmentVec[i];
+            if ((segmentId >= M_MAX_SEGMENTS) || ((segmentId >> 6) != longIndex)) {
+                break;
+            }
+            const uint64_t mask64 = (((uint64_t)1) << (segmentId & 63));
+            if (freeMask & mask64) { //duplicate segment Id in segmentVec (second free fails)
+                success = false;
+            }
+            freeMask |= mask64;
+        }
+        uint64_t & leafRef = m_bitMasks[MAX_TREE_ARRAY_DEPTH - 1][longIndex];
+        if (leafRef & freeMask) { //error if leaf bit is already 1 (empty)
+            success = false;
+#if defined(USE_ANDN) && !defined(USE_BITTEST)
+            freeMask = _andn_u64(leafRef, freeMask);
+#else
+            freeMask &= (~leafRef);
+#endif
+        }
+        if (freeMask) {
+            const bool leafWasFull = (leafRef == 0);
+            leafRef |= freeMask;
+            m_numFreeSegments += PopCount64(freeMask);
+            if (leafWasFull) {
+                SetParentBitsOfLeaf(longIndex);
+            }
         }
     }
     return success;
@@ -18,6 +18,7 @@
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
 #include "Logger.h"
+#include "AsyncLogger.h"
 #include <set>
 #include <boost/lexical_cast.hpp>
 #include <boost/make_unique.hpp>
@@ -28,6 +29,8 @@
 #include "codec/BundleViewV7.h"
 
 typedef std::pair<cbhe_eid_t, bool> eid_plus_isanyserviceid_pair_t;
+typedef ZmqStorageInterface::custodyid_set_t custodyid_set_t;
+typedef ZmqStorageInterface::finaldesteid_opencustids_map_t finaldesteid_opencustids_map_t;
 
 ZmqStorageInterface::ZmqStorageInterface() : m_running(false) {}
 
@@ -181,34 +184,193 @@ bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * h
     return true;
 }
 
-static bool WriteAcsBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
-    const Bpv6CbhePrimaryBlock & primary, const std::vector<uint8_t> & acsBundleSerialized)
+//write an admin record generated by hdtn (acs custody signal or status report) to disk
+static bool WriteAdminRecordBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+    const PrimaryBlock & primary, const cbhe_eid_t & hdtnSrcEid, const std::vector<uint8_t> & adminRecordBundleSerialized)
 {
-    const cbhe_eid_t & hdtnSrcEid = primary.m_sourceNodeId;
-    const uint64_t newCustodyIdForAcsCustodySignal = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
+    const uint64_t newCustodyIdForAdminRecord = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
 
-    //write custody signal to disk
     BundleStorageManagerSession_WriteToDisk sessionWrite;
-    const uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, acsBundleSerialized.size());
+    const uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, adminRecordBundleSerialized.size());
     //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
     if (totalSegmentsRequired == 0) {
-        const std::string msg = "out of space for acs custody signal";
-        std::cerr << msg << "\n";
-        hdtn::Logger::getInstance()->logError("storage", msg);
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "out of space for admin record");
         return false;
     }
 
     const uint64_t totalBytesPushed = bsm.PushAllSegments(sessionWrite, primary,
-        newCustodyIdForAcsCustodySignal, acsBundleSerialized.data(), acsBundleSerialized.size());
-    if (totalBytesPushed != acsBundleSerialized.size()) {
-        const std::string msg = "totalBytesPushed != acsBundleSerialized.size";
-        std::cerr << msg << "\n";
-        hdtn::Logger::getInstance()->logError("storage", msg);
+        newCustodyIdForAdminRecord, adminRecordBundleSerialized.data(), adminRecordBundleSerialized.size());
+    if (totalBytesPushed != adminRecordBundleSerialized.size()) {
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "totalBytesPushed != adminRecordBundleSerialized.size");
         return false;
     }
     return true;
 }
 
+//generate a "bundle deleted, lifetime expired" status report about the bundle (read back from disk) destined for its report-to eid
+static bool GenerateAndWriteLifetimeExpiredStatusReport(std::vector<uint8_t> & bundleSerialized, BundleStorageManagerBase & bsm,
+    CustodyIdAllocator & custodyIdAllocator, CustodyTransferManager & ctm, const cbhe_eid_t & hdtnSrcEid)
+{
+    uint64_t creationSeconds;
+    uint64_t creationSequence;
+    const uint8_t firstByte = bundleSerialized[0];
+    if (firstByte == 6) {
+        BundleViewV6 bv;
+        if (!bv.LoadBundle(bundleSerialized.data(), bundleSerialized.size())) {
+            return false;
+        }
+        const Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+        if ((primary.m_reportToEid.nodeId == 0) || ((primary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::ADMINRECORD) != BPV6_BUNDLEFLAG::NO_FLAGS_SET)) {
+            return true; //no report-to endpoint (dtn:none), and never report on an admin record
+        }
+        BundleViewV6 reportBv;
+        Bpv6CbhePrimaryBlock & reportPrimary = reportBv.m_primaryBlockView.header;
+        reportPrimary.SetZero();
+        reportPrimary.m_bundleProcessingControlFlags = (primary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::PRIORITY_BIT_MASK) |
+            (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT | BPV6_BUNDLEFLAG::ADMINRECORD);
+        reportPrimary.m_sourceNodeId = hdtnSrcEid;
+        reportPrimary.m_destinationEid = primary.m_reportToEid;
+        ctm.SetCreationAndSequence(creationSeconds, creationSequence);
+        reportPrimary.m_creationTimestamp.secondsSinceStartOfYear2000 = creationSeconds;
+        reportPrimary.m_creationTimestamp.sequenceNumber = creationSequence;
+        reportPrimary.m_lifetimeSeconds = 1000; //todo
+        reportBv.m_primaryBlockView.SetManuallyModified();
+        {
+            std::unique_ptr<Bpv6CanonicalBlock> blockPtr = boost::make_unique<Bpv6AdministrativeRecord>();
+            Bpv6AdministrativeRecord & block = *(reinterpret_cast<Bpv6AdministrativeRecord*>(blockPtr.get()));
+            block.m_blockProcessingControlFlags = BPV6_BLOCKFLAG::NO_FLAGS_SET;
+            block.m_adminRecordTypeCode = BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT;
+            block.m_adminRecordContentPtr = boost::make_unique<Bpv6AdministrativeRecordContentBundleStatusReport>();
+            Bpv6AdministrativeRecordContentBundleStatusReport & bsr = *(reinterpret_cast<Bpv6AdministrativeRecordContentBundleStatusReport*>(block.m_adminRecordContentPtr.get()));
+            bsr.SetTimeOfDeletionOfBundleAndStatusFlag(TimestampUtil::GenerateDtnTimeNow());
+            bsr.m_reasonCode = BPV6_BUNDLE_STATUS_REPORT_REASON_CODES::LIFETIME_EXPIRED;
+            bsr.m_bundleSourceEid = Uri::GetIpnUriString(primary.m_sourceNodeId.nodeId, primary.m_sourceNodeId.serviceId);
+            bsr.m_copyOfBundleCreationTimestamp = primary.m_creationTimestamp;
+            if (primary.HasFragmentationFlagSet()) {
+                std::vector<BundleViewV6::Bpv6CanonicalBlockView*> blocks;
+                bv.GetCanonicalBlocksByType(BPV6_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+                //must set both m_isFragment
+                block.m_isFragment = true;
+                bsr.m_isFragment = true;
+                bsr.m_fragmentOffsetIfPresent = primary.m_fragmentOffset;
+                bsr.m_fragmentLengthIfPresent = (blocks.size() == 1) ? blocks[0]->headerPtr->m_blockTypeSpecificDataLength : 0;
+            }
+            reportBv.AppendMoveCanonicalBlock(blockPtr);
+        }
+        if (!reportBv.Render(CBHE_BPV6_MINIMUM_SAFE_PRIMARY_HEADER_ENCODE_SIZE + Bpv6AdministrativeRecordContentBundleStatusReport::CBHE_MAX_SERIALIZATION_SIZE)) {
+            return false;
+        }
+        return WriteAdminRecordBundle(bsm, custodyIdAllocator, reportPrimary, hdtnSrcEid, reportBv.m_frontBuffer);
+    }
+    else if (firstByte == ((4U << 5) | 31U)) { //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+        BundleViewV7 bv;
+        if (!bv.LoadBundle(bundleSerialized.data(), bundleSerialized.size(), true)) { //already crc verified at ingress
+            return false;
+        }
+        const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+        if ((primary.m_reportToEid.nodeId == 0) || ((primary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ADMINRECORD) != BPV7_BUNDLEFLAG::NO_FLAGS_SET)) {
+            return true; //no report-to endpoint (dtn:none), and never report on an admin record
+        }
+        BundleViewV7 reportBv;
+        Bpv7CbhePrimaryBlock & reportPrimary = reportBv.m_primaryBlockView.header;
+        reportPrimary.SetZero();
+        reportPrimary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::NOFRAGMENT | BPV7_BUNDLEFLAG::ADMINRECORD;
+        reportPrimary.m_sourceNodeId = hdtnSrcEid;
+        reportPrimary.m_destinationEid = primary.m_reportToEid;
+        reportPrimary.m_reportToEid.Set(0, 0);
+        ctm.SetCreationAndSequence(creationSeconds, creationSequence);
+        reportPrimary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = creationSeconds * 1000;
+        reportPrimary.m_creationTimestamp.sequenceNumber = creationSequence;
+        reportPrimary.m_lifetimeMilliseconds = 1000 * 1000; //todo
+        reportPrimary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+        reportBv.m_primaryBlockView.SetManuallyModified();
+        {
+            std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7AdministrativeRecord>();
+            Bpv7AdministrativeRecord & block = *(reinterpret_cast<Bpv7AdministrativeRecord*>(blockPtr.get()));
+            block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+            block.m_crcType = BPV7_CRC_TYPE::CRC32C;
+            block.m_adminRecordTypeCode = BPV7_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT;
+            block.m_adminRecordContentPtr = boost::make_unique<Bpv7AdministrativeRecordContentBundleStatusReport>();
+            Bpv7AdministrativeRecordContentBundleStatusReport & bsr = *(reinterpret_cast<Bpv7AdministrativeRecordContentBundleStatusReport*>(block.m_adminRecordContentPtr.get()));
+            bsr.m_reportStatusTimeFlagWasSet = ((primary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::STATUSTIME_REQUESTED) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+            for (std::size_t i = 0; i < bsr.m_bundleStatusInfo.size(); ++i) {
+                bsr.m_bundleStatusInfo[i].first = false;
+                bsr.m_bundleStatusInfo[i].second = 0;
+            }
+            //reporting-node-deleted-bundle
+            bsr.m_bundleStatusInfo[3].first = true;
+            bsr.m_bundleStatusInfo[3].second = (bsr.m_reportStatusTimeFlagWasSet) ? TimestampUtil::GetMillisecondsSinceEpochRfc5050() : 0;
+            bsr.m_statusReportReasonCode = BPV7_STATUS_REPORT_REASON_CODE::LIFETIME_EXPIRED;
+            bsr.m_sourceNodeEid = primary.m_sourceNodeId;
+            bsr.m_creationTimestamp = primary.m_creationTimestamp;
+            bsr.m_subjectBundleIsFragment = primary.HasFragmentationFlagSet();
+            bsr.m_optionalSubjectPayloadFragmentOffset = 0;
+            bsr.m_optionalSubjectPayloadFragmentLength = 0;
+            if (bsr.m_subjectBundleIsFragment) {
+                std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+                bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+                bsr.m_optionalSubjectPayloadFragmentOffset = primary.m_fragmentOffset;
+                bsr.m_optionalSubjectPayloadFragmentLength = (blocks.size() == 1) ? blocks[0]->headerPtr->m_dataLength : 0;
+            }
+            reportBv.AppendMoveCanonicalBlock(blockPtr);
+        }
+        if (!reportBv.Render(5000)) {
+            return false;
+        }
+        return WriteAdminRecordBundle(bsm, custodyIdAllocator, reportPrimary, hdtnSrcEid, reportBv.m_frontBuffer);
+    }
+    return false;
+}
+
+bool ZmqStorageInterface::SweepExpiredBundles(BundleStorageManagerBase & bsm, BundleStorageManagerSession_ReadFromDisk & sessionRead,
+    CustodyIdAllocator & custodyIdAllocator, CustodyTransferManager & ctm, CustodyTimers & custodyTimers,
+    finaldesteid_opencustids_map_t & finalDestEidToOpenCustIdsMap, std::vector<uint64_t> & expiredCustodyIdsVec,
+    const uint64_t nowSecondsSinceStartOfYear2000, const std::size_t maxBundlesToSweep,
+    MetricCounter & metricBundlesExpired, MetricCounter & metricBytesReclaimed, MetricCounter & metricStatusReportsGenerated)
+{
+    expiredCustodyIdsVec.clear();
+    const std::size_t numExpired = bsm.PopExpiredCustodyIds(nowSecondsSinceStartOfYear2000, maxBundlesToSweep, expiredCustodyIdsVec);
+    std::vector<uint8_t> bundleReadBack;
+    for (std::size_t i = 0; i < numExpired; ++i) {
+        const uint64_t custodyId = expiredCustodyIdsVec[i];
+        catalog_entry_t * catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(custodyId);
+        if (catalogEntryPtr == NULL) {
+            continue; //listed twice
+        }
+        const cbhe_eid_t destEid = catalogEntryPtr->destEid;
+        const uint64_t bundleSizeBytes = catalogEntryPtr->bundleSizeBytes;
+        if (catalogEntryPtr->HasCustody()) {
+            custodyTimers.CancelCustodyTransferTimer(destEid, custodyId); //if sent and awaiting a custody signal
+        }
+        //if currently sent to egress, a late egress ack is ignored
+        finaldesteid_opencustids_map_t::iterator openIt = finalDestEidToOpenCustIdsMap.find(destEid);
+        if (openIt != finalDestEidToOpenCustIdsMap.end()) {
+            openIt->second.erase(custodyId);
+        }
+        if (catalogEntryPtr->IsDeletionStatusReportRequired()) {
+            if ((bsm.StartReadByCustodyId(sessionRead, custodyId) == 0) || (!bsm.ReadAllSegments(sessionRead, bundleReadBack))) {
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error reading expired bundle from disk for its deletion status report");
+            }
+            else if (!GenerateAndWriteLifetimeExpiredStatusReport(bundleReadBack, bsm, custodyIdAllocator, ctm, M_HDTN_EID_CUSTODY)) {
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error generating deletion status report for expired bundle");
+            }
+            else {
+                metricStatusReportsGenerated.Increment();
+            }
+            catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(custodyId); //the report was cataloged in the meantime
+        }
+        if ((catalogEntryPtr == NULL) || (!bsm.RemoveReadBundleFromDisk(catalogEntryPtr, custodyId))) {
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error freeing expired bundle from disk");
+            continue;
+        }
+        custodyIdAllocator.FreeCustodyId(custodyId);
+        ++m_totalBundlesErasedFromStorageDueToExpiration;
+        metricBundlesExpired.Increment();
+        metricBytesReclaimed.Increment(bundleSizeBytes);
+    }
+    return (numExpired == maxBundlesToSweep);
+}
+
 static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
     CustodyIdAllocator & custodyIdAllocator, CustodyTransferManager & ctm,
     CustodyTimers & custodyTimers,
@@ -223,7 +385,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
     if (isBpVersion6) {
         BundleViewV6 bv;
         if (!bv.LoadBundle((uint8_t *)message->data(), message->size())) { //invalid bundle
-            std::cerr << "malformed bundle\n";
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "malformed bundle");
             return false;
         }
         const Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
@@ -236,12 +398,12 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
             std::vector<BundleViewV6::Bpv6CanonicalBlockView*> blocks;
             bv.GetCanonicalBlocksByType(BPV6_BLOCK_TYPE_CODE::PAYLOAD, blocks);
             if (blocks.size() != 1) {
-                std::cerr << "error admin record does not have a payload block\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error admin record does not have a payload block");
                 return false;
             }
             Bpv6AdministrativeRecord* adminRecordBlockPtr = dynamic_cast<Bpv6AdministrativeRecord*>(blocks[0]->headerPtr.get());
             if (adminRecordBlockPtr == NULL) {
-                std::cerr << "error null Bpv6AdministrativeRecord\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error null Bpv6AdministrativeRecord");
                 return false;
             }
             const BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE adminRecordType = adminRecordBlockPtr->m_adminRecordTypeCode;
@@ -251,53 +413,51 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                 //check acs
                 Bpv6AdministrativeRecordContentAggregateCustodySignal * acsPtr = dynamic_cast<Bpv6AdministrativeRecordContentAggregateCustodySignal*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
                 if (acsPtr == NULL) {
-                    std::cerr << "error null AggregateCustodySignal\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error null AggregateCustodySignal");
                     return false;
                 }
                 Bpv6AdministrativeRecordContentAggregateCustodySignal & acs = *(reinterpret_cast<Bpv6AdministrativeRecordContentAggregateCustodySignal*>(acsPtr));
                 if (!acs.DidCustodyTransferSucceed()) {
-                    std::cerr << "custody transfer failed with reason code " << static_cast<unsigned int>(acs.GetReasonCode()) << "\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "custody transfer failed with reason code {}", static_cast<unsigned int>(acs.GetReasonCode()));
                     return false;
                 }
 
                 //todo figure out what to do with failed custody from next hop
+                std::vector<catalog_entry_t> removedEntries;
                 for (std::set<FragmentSet::data_fragment_t>::const_iterator it = acs.m_custodyIdFills.cbegin(); it != acs.m_custodyIdFills.cend(); ++it) {
-                    forStats->m_numAcsCustodyTransfers += (it->endIndex + 1) - it->beginIndex;
+                    const uint64_t numInFill = (it->endIndex + 1) - it->beginIndex;
+                    forStats->m_numAcsCustodyTransfers += numInFill;
                     custodyIdAllocator.FreeCustodyIdRange(it->beginIndex, it->endIndex);
-                    for (uint64_t currentCustodyId = it->beginIndex; currentCustodyId <= it->endIndex; ++currentCustodyId) {
-                        catalog_entry_t * catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(currentCustodyId);
-                        if (catalogEntryPtr == NULL) {
-                            std::cout << "error finding catalog entry for bundle identified by acs custody signal\n";
-                            continue;
-                        }
-                        if (!custodyTimers.CancelCustodyTransferTimer(catalogEntryPtr->destEid, currentCustodyId)) {
-                            std::cout << "notice: can't find custody timer associated with bundle identified by acs custody signal\n";
-                        }
-                        if (!bsm.RemoveReadBundleFromDisk(catalogEntryPtr, currentCustodyId)) {
-                            std::cout << "error freeing bundle identified by acs custody signal from disk\n";
-                            continue;
+                    removedEntries.clear();
+                    const uint64_t numRemoved = bsm.RemoveReadBundlesFromDisk(it->beginIndex, it->endIndex, removedEntries);
+                    if (numRemoved != numInFill) {
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error finding catalog entries for {} bundles identified by acs custody signal", numInFill - numRemoved);
+                    }
+                    for (std::size_t i = 0; i < removedEntries.size(); ++i) {
+                        if (!custodyTimers.CancelCustodyTransferTimer(removedEntries[i].destEid, removedEntries[i].custodyId)) {
+                            HDTN_LOG_NOTIFICATION_RATE_LIMITED(10, "storage", "notice: can't find custody timer associated with bundle identified by acs custody signal");
                         }
-                        ++forStats->m_totalBundlesErasedFromStorageWithCustodyTransfer;
                     }
+                    forStats->m_totalBundlesErasedFromStorageWithCustodyTransfer += numRemoved;
                 }
             }
             else if (adminRecordType == BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::CUSTODY_SIGNAL) { //rfc5050 style custody transfer
                 //check acs
                 Bpv6AdministrativeRecordContentCustodySignal * csPtr = dynamic_cast<Bpv6AdministrativeRecordContentCustodySignal*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
                 if (csPtr == NULL) {
-                    std::cerr << "error null CustodySignal\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error null CustodySignal");
                     return false;
                 }
                 Bpv6AdministrativeRecordContentCustodySignal & cs = *(reinterpret_cast<Bpv6AdministrativeRecordContentCustodySignal*>(csPtr));
                 if (!cs.DidCustodyTransferSucceed()) {
-                    std::cerr << "custody transfer failed with reason code " << cs.GetReasonCode() << "\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "custody transfer failed with reason code {}", static_cast<unsigned int>(cs.GetReasonCode()));
                     return false;
                 }
                 uint64_t * custodyIdPtr;
                 if (cs.m_isFragment) {
                     cbhe_bundle_uuid_t uuid;
                     if (!Uri::ParseIpnUriString(cs.m_bundleSourceEid, uuid.srcEid.nodeId, uuid.srcEid.serviceId)) {
-                        std::cerr << "error custody signal with bad ipn string\n";
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error custody signal with bad ipn string");
                         return false;
                     }
                     uuid.creationSeconds = cs.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000;
@@ -309,7 +469,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                 else {
                     cbhe_bundle_uuid_nofragment_t uuid;
                     if (!Uri::ParseIpnUriString(cs.m_bundleSourceEid, uuid.srcEid.nodeId, uuid.srcEid.serviceId)) {
-                        std::cerr << "error custody signal with bad ipn string\n";
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error custody signal with bad ipn string");
                         return false;
                     }
                     uuid.creationSeconds = cs.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000;
@@ -318,28 +478,28 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                     custodyIdPtr = bsm.GetCustodyIdFromUuid(uuid);
                 }
                 if (custodyIdPtr == NULL) {
-                    std::cerr << "error custody signal does not match a bundle in the storage database\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error custody signal does not match a bundle in the storage database");
                     return false;
                 }
                 const uint64_t custodyIdFromRfc5050 = *custodyIdPtr;
                 custodyIdAllocator.FreeCustodyId(custodyIdFromRfc5050);
                 catalog_entry_t * catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(custodyIdFromRfc5050);
                 if (catalogEntryPtr == NULL) {
-                    std::cout << "error finding catalog entry for bundle identified by rfc5050 custody signal\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error finding catalog entry for bundle identified by rfc5050 custody signal");
                     return false;
                 }
                 if (!custodyTimers.CancelCustodyTransferTimer(catalogEntryPtr->destEid, custodyIdFromRfc5050)) {
-                    std::cout << "notice: can't find custody timer associated with bundle identified by rfc5050 custody signal\n";
+                    HDTN_LOG_NOTIFICATION_RATE_LIMITED(10, "storage", "notice: can't find custody timer associated with bundle identified by rfc5050 custody signal");
                 }
                 if (!bsm.RemoveReadBundleFromDisk(catalogEntryPtr, custodyIdFromRfc5050)) {
-                    std::cout << "error freeing bundle identified by rfc5050 custody signal from disk\n";
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error freeing bundle identified by rfc5050 custody signal from disk");
                     return false;
                 }
                 ++forStats->m_totalBundlesErasedFromStorageWithCustodyTransfer;
                 ++forStats->m_numRfc5050CustodyTransfers;
             }
             else {
-                std::cerr << "error unknown admin record type\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error unknown admin record type");
                 return false;
             }
             return true; //do not proceed past this point so that the signal is not written to disk
@@ -351,10 +511,10 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
         if ((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForCustody) == requiredPrimaryFlagsForCustody) {
             if (!ctm.ProcessCustodyOfBundle(bv, true, newCustodyId, BPV6_ACS_STATUS_REASON_INDICES::SUCCESS__NO_ADDITIONAL_INFORMATION,
                 custodySignalRfc5050RenderedBundleView)) {
-                std::cerr << "error unable to process custody\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error unable to process custody");
             }
             else if (!bv.Render(message->size() + 200)) { //hdtn modifies bundle for next hop
-                std::cerr << "error unable to render new bundle\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error unable to render new bundle");
             }
             else {
                 if (custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()) {
@@ -368,9 +528,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                         custodySignalRfc5050RenderedBundleView.m_renderedBundle.size());
                     //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
                     if (totalSegmentsRequired == 0) {
-                        const std::string msg = "out of space for custody signal";
-                        std::cerr << msg << "\n";
-                        hdtn::Logger::getInstance()->logError("storage", msg);
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "out of space for custody signal");
                         return false;
                     }
 
@@ -378,9 +536,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                         newCustodyIdFor5050CustodySignal, (const uint8_t*)custodySignalRfc5050RenderedBundleView.m_renderedBundle.data(),
                         custodySignalRfc5050RenderedBundleView.m_renderedBundle.size());
                     if (totalBytesPushed != custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()) {
-                        const std::string msg = "totalBytesPushed != custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()";
-                        std::cerr << msg << "\n";
-                        hdtn::Logger::getInstance()->logError("storage", msg);
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "totalBytesPushed != custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()");
                         return false;
                     }
                 }
@@ -392,8 +548,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
         uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, bv.m_renderedBundle.size());
         //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
         if (totalSegmentsRequired == 0) {
-            std::cerr << "out of space\n";
-            hdtn::Logger::getInstance()->logError("storage", "Out of space");
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "out of space");
             return false;
         }
         //totalSegmentsStoredOnDisk += totalSegmentsRequired;
@@ -401,9 +556,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
 
         const uint64_t totalBytesPushed = bsm.PushAllSegments(sessionWrite, primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size());
         if (totalBytesPushed != bv.m_renderedBundle.size()) {
-            const std::string msg = "totalBytesPushed != size";
-            std::cerr << msg << "\n";
-            hdtn::Logger::getInstance()->logError("storage", msg);
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "totalBytesPushed != size");
             return false;
         }
         return true;
@@ -412,7 +565,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
     else if (isBpVersion7) {
         BundleViewV7 bv;
         if (!bv.LoadBundle((uint8_t *)message->data(), message->size(), true, true)) { //invalid bundle
-            std::cerr << "malformed bundle\n";
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "malformed bundle");
             return false;
         }
         const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
@@ -423,8 +576,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
         uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, bv.m_renderedBundle.size());
         //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
         if (totalSegmentsRequired == 0) {
-            std::cerr << "out of space\n";
-            hdtn::Logger::getInstance()->logError("storage", "Out of space");
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "out of space");
             return false;
         }
         //totalSegmentsStoredOnDisk += totalSegmentsRequired;
@@ -432,15 +584,13 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
         const uint64_t newCustodyId = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
         const uint64_t totalBytesPushed = bsm.PushAllSegments(sessionWrite, primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size());
         if (totalBytesPushed != bv.m_renderedBundle.size()) {
-            const std::string msg = "totalBytesPushed != size";
-            std::cerr << msg << "\n";
-            hdtn::Logger::getInstance()->logError("storage", msg);
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "totalBytesPushed != size");
             return false;
         }
         return true;
     }
     else {
-        std::cout << "error in ZmqStorageInterface Write: unsupported bundle version detected\n";
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in ZmqStorageInterface Write: unsupported bundle version detected");
         return false;
     }
     
@@ -472,7 +622,8 @@ static void CustomCleanupStdVecUint8(void *data, void *hint) {
 
 static bool ReleaseOne_NoBlock(BundleStorageManagerSession_ReadFromDisk & sessionRead,
     const std::vector<eid_plus_isanyserviceid_pair_t> & availableDestLinks,
-    zmq::socket_t *egressSock, BundleStorageManagerBase & bsm, const uint64_t maxBundleSizeToRead)
+    zmq::socket_t *egressSock, BundleStorageManagerBase & bsm, const uint64_t maxBundleSizeToRead,
+    LatencyHistogram & readLatencyHistogram)
 {
     //std::cout << "reading\n";
     const uint64_t bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks);
@@ -486,21 +637,21 @@ static bool ReleaseOne_NoBlock(BundleStorageManagerSession_ReadFromDisk & sessio
 
     //IF YOU DECIDE YOU DON'T WANT TO READ THE BUNDLE AFTER PEEKING AT IT (MAYBE IT'S TOO BIG RIGHT NOW)
     if (bytesToReadFromDisk > maxBundleSizeToRead) {
-        std::cerr << "error: bundle to read from disk is too large right now" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: bundle to read from disk is too large right now");
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error: bundle to read from disk is too large right now");
         bsm.ReturnTop(sessionRead);
         return false;
         //bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks); //get it back
     }
         
     std::vector<uint8_t> * vecUint8BundleDataRawPointer = new std::vector<uint8_t>();
+    const uint64_t readStartTimestampNanoseconds = LatencyHistogram::NowNanoseconds();
     const bool successReadAllSegments = bsm.ReadAllSegments(sessionRead, *vecUint8BundleDataRawPointer);
+    readLatencyHistogram.RecordSince(readStartTimestampNanoseconds);
     zmq::message_t zmqBundleDataMessageWithDataStolen(vecUint8BundleDataRawPointer->data(), vecUint8BundleDataRawPointer->size(), CustomCleanupStdVecUint8, vecUint8BundleDataRawPointer);
         
     //std::cout << "totalBytesRead " << totalBytesRead << "\n";
     if (!successReadAllSegments) {
-        std::cout << "error: unable to read all segments from disk\n";
-        hdtn::Logger::getInstance()->logError("storage", "error: unable to read all segments from disk");
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error: unable to read all segments from disk");
         return false;
     }
 
@@ -518,14 +669,12 @@ static bool ReleaseOne_NoBlock(BundleStorageManagerSession_ReadFromDisk & sessio
     toEgressHdr->custodyId = sessionRead.custodyId;
     
     if (!egressSock->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-        std::cout << "error: zmq could not send" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send");
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error: zmq could not send");
         bsm.ReturnTop(sessionRead);
         return false;
     }
     if (!egressSock->send(std::move(zmqBundleDataMessageWithDataStolen), zmq::send_flags::dontwait)) {
-        std::cout << "error: zmq could not send bundle" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send bundle");
+        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error: zmq could not send bundle");
         bsm.ReturnTop(sessionRead);
         return false;
     }
@@ -534,7 +683,7 @@ static bool ReleaseOne_NoBlock(BundleStorageManagerSession_ReadFromDisk & sessio
     if (deleteFromDiskNow) {
         bool successRemoveBundle = bsm.RemoveReadBundleFromDisk(sessionRead);
         if (!successRemoveBundle) {
-            std::cout << "error freeing bundle from disk\n";
+            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error freeing bundle from disk");
             return false;
         }
     }
@@ -571,9 +720,18 @@ void ZmqStorageInterface::ThreadFunc() {
     const uint64_t ACS_MAX_FILLS_PER_ACS_PACKET = m_hdtnConfig.m_acsMaxFillsPerAcsPacket;
     
     static const boost::posix_time::time_duration ACS_SEND_PERIOD = boost::posix_time::milliseconds(m_hdtnConfig.m_acsSendPeriodMilliseconds);
+    static constexpr uint64_t ACS_MAX_CONTENT_BYTES_PER_ACS_PACKET = 1000;
     CustodyTransferManager ctm(IS_HDTN_ACS_AWARE, M_HDTN_EID_CUSTODY.nodeId, M_HDTN_EID_CUSTODY.serviceId);
-    std::cout << "[storage-worker] Worker thread starting up." << std::endl;
-    hdtn::Logger::getInstance()->logNotification("storage", "Worker thread starting up");
+    ctm.SetAcsFlushThresholds(ACS_MAX_FILLS_PER_ACS_PACKET, ACS_MAX_CONTENT_BYTES_PER_ACS_PACKET, ACS_SEND_PERIOD);
+    MetricsRegistry & metricsRegistry = MetricsRegistry::GetInstance();
+    LatencyHistogram & metricWriteLatency = metricsRegistry.GetOrCreateHistogram("storage.writeLatency");
+    LatencyHistogram & metricReadLatency = metricsRegistry.GetOrCreateHistogram("storage.readLatency");
+    MetricCounter & metricBundlesWritten = metricsRegistry.GetOrCreateCounter("storage.bundlesWritten");
+    MetricCounter & metricBundlesSentToEgress = metricsRegistry.GetOrCreateCounter("storage.bundlesSentToEgress");
+    MetricCounter & metricBundlesExpired = metricsRegistry.GetOrCreateCounter("storage.bundlesExpired");
+    MetricCounter & metricBytesReclaimedFromExpiredBundles = metricsRegistry.GetOrCreateCounter("storage.bytesReclaimedFromExpiredBundles");
+    MetricCounter & metricExpirationStatusReportsGenerated = metricsRegistry.GetOrCreateCounter("storage.expirationStatusReportsGenerated");
+    HDTN_LOG_NOTIFICATION("storage", "[storage-worker] Worker thread starting up.");
 
    
 
@@ -581,13 +739,11 @@ void ZmqStorageInterface::ThreadFunc() {
     
     std::unique_ptr<BundleStorageManagerBase> bsmPtr;
     if (m_hdtnConfig.m_storageConfig.m_storageImplementation == "stdio_multi_threaded") {
-        std::cout << "[ZmqStorageInterface] Initializing BundleStorageManagerMT ... " << std::endl;
-        hdtn::Logger::getInstance()->logNotification("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerMT ... ");
+        HDTN_LOG_NOTIFICATION("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerMT ... ");
         bsmPtr = boost::make_unique<BundleStorageManagerMT>(boost::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
     }
     else if (m_hdtnConfig.m_storageConfig.m_storageImplementation == "asio_single_threaded") {
-        std::cout << "[ZmqStorageInterface] Initializing BundleStorageManagerAsio ... " << std::endl;
-        hdtn::Logger::getInstance()->logNotification("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerAsio ... ");
+        HDTN_LOG_NOTIFICATION("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerAsio ... ");
         bsmPtr = boost::make_unique<BundleStorageManagerAsio>(boost::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
     }
     else {
@@ -598,9 +754,6 @@ void ZmqStorageInterface::ThreadFunc() {
     bsm.Start();
     
 
-    typedef std::set<uint64_t> custodyid_set_t;
-    typedef std::map<cbhe_eid_t, custodyid_set_t> finaldesteid_opencustids_map_t;
-
     std::vector<eid_plus_isanyserviceid_pair_t> availableDestLinksNotCloggedVec;
     availableDestLinksNotCloggedVec.reserve(100); //todo
     std::vector<eid_plus_isanyserviceid_pair_t> availableDestLinksCloggedVec;
@@ -608,6 +761,7 @@ void ZmqStorageInterface::ThreadFunc() {
 
     m_totalBundlesErasedFromStorageNoCustodyTransfer = 0;
     m_totalBundlesErasedFromStorageWithCustodyTransfer = 0;
+    m_totalBundlesErasedFromStorageDueToExpiration = 0;
     m_totalBundlesSentToEgressFromStorage = 0;
     m_numRfc5050CustodyTransfers = 0;
     m_numAcsCustodyTransfers = 0;
@@ -632,7 +786,12 @@ void ZmqStorageInterface::ThreadFunc() {
     };
     static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
     long timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL; //0 => no blocking
-    boost::posix_time::ptime acsSendNowExpiry = boost::posix_time::microsec_clock::universal_time() + ACS_SEND_PERIOD;
+    //expired bundles are deleted incrementally, at most MAX_EXPIRED_BUNDLES_PER_SWEEP per loop iteration
+    static const boost::posix_time::time_duration EXPIRATION_SWEEP_PERIOD = boost::posix_time::seconds(1);
+    static constexpr std::size_t MAX_EXPIRED_BUNDLES_PER_SWEEP = 256;
+    std::vector<uint64_t> expiredCustodyIdsVec;
+    expiredCustodyIdsVec.reserve(MAX_EXPIRED_BUNDLES_PER_SWEEP);
+    boost::posix_time::ptime expirationSweepExpiry = boost::posix_time::microsec_clock::universal_time() + EXPIRATION_SWEEP_PERIOD;
     m_threadStartupComplete = true;
     while (m_running) {
         int rc = 0;
@@ -648,18 +807,15 @@ void ZmqStorageInterface::ThreadFunc() {
                 hdtn::EgressAckHdr egressAckHdr;
                 const zmq::recv_buffer_result_t res = m_zmqPullSock_boundEgressToConnectingStoragePtr->recv(zmq::mutable_buffer(&egressAckHdr, sizeof(egressAckHdr)), zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "[storage-worker] EgressAckHdr not received" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr not received");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[storage-worker] EgressAckHdr not received");
                     continue;
                 }
                 else if ((res->truncated()) || (res->size != sizeof(hdtn::EgressAckHdr))) {
-                    std::cerr << "[storage-worker] EgressAckHdr wrong size received" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr wrong size received");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[storage-worker] EgressAckHdr wrong size received");
                     continue;
                 }
                 else if (egressAckHdr.base.type != HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE) {
-                    std::cerr << "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE, got " << egressAckHdr.base.type << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE, got {}", egressAckHdr.base.type);
                     continue;
                 }
                 custodyid_set_t & custodyIdSet = finalDestEidToOpenCustIdsMap[egressAckHdr.finalDestEid];
@@ -668,8 +824,7 @@ void ZmqStorageInterface::ThreadFunc() {
                     if (egressAckHdr.deleteNow) { //custody not requested, so don't wait on a custody signal to delete the bundle
                         bool successRemoveBundle = bsm.RemoveReadBundleFromDisk(egressAckHdr.custodyId);
                         if (!successRemoveBundle) {
-                            std::cout << "error freeing bundle from disk\n";
-                            hdtn::Logger::getInstance()->logError("storage", "Error freeing bundle from disk");
+                            HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error freeing bundle from disk");
                         }
                         else {
                             ++m_totalBundlesErasedFromStorageNoCustodyTransfer;
@@ -682,13 +837,11 @@ void ZmqStorageInterface::ThreadFunc() {
                 hdtn::ToStorageHdr toStorageHeader;
                 const zmq::recv_buffer_result_t res = m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmq::mutable_buffer(&toStorageHeader, sizeof(hdtn::ToStorageHdr)), zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message hdr not received" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message hdr not received");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message hdr not received");
                     continue;
                 }
                 else if ((res->truncated()) || (res->size != sizeof(hdtn::ToStorageHdr))) {
-                    std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) rhdr.size() != sizeof(hdtn::ToStorageHdr)" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) rhdr.size() != sizeof(hdtn::ToStorageHdr)");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) rhdr.size() != sizeof(hdtn::ToStorageHdr)");
                     continue;
                 }
                 else if (toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK) {
@@ -714,8 +867,7 @@ void ZmqStorageInterface::ThreadFunc() {
                     continue;
                 }
                 else if (toStorageHeader.base.type != HDTN_MSGTYPE_STORE) {
-                    std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message type not HDTN_MSGTYPE_STORE" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message type not HDTN_MSGTYPE_STORE");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message type not HDTN_MSGTYPE_STORE");
                     continue;
                 }
 
@@ -724,14 +876,17 @@ void ZmqStorageInterface::ThreadFunc() {
 
                 zmq::message_t zmqBundleDataReceived;
                 if (!m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmqBundleDataReceived, zmq::recv_flags::none)) {
-                    std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message not received" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message not received");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message not received");
                     continue;
                 }
                 storageStats.inBytes += zmqBundleDataReceived.size();
                 
                 cbhe_eid_t finalDestEidReturnedFromWrite;
-                Write(&zmqBundleDataReceived, bsm, custodyIdAllocator, ctm, custodyTimers, custodySignalRfc5050RenderedBundleView, finalDestEidReturnedFromWrite, this);
+                {
+                    LatencyHistogram::ScopedTimer writeTimer(metricWriteLatency);
+                    Write(&zmqBundleDataReceived, bsm, custodyIdAllocator, ctm, custodyTimers, custodySignalRfc5050RenderedBundleView, finalDestEidReturnedFromWrite, this);
+                }
+                metricBundlesWritten.Increment();
 
                 //send ack message to ingress
                 //force natural/64-bit alignment
@@ -746,8 +901,7 @@ void ZmqStorageInterface::ThreadFunc() {
                 storageAckHdr->ingressUniqueId = toStorageHeader.ingressUniqueId;
 
                 if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(zmqMessageStorageAckHdrWithDataStolen), zmq::send_flags::dontwait)) {
-                    std::cout << "error: zmq could not send ingress an ack from storage" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send ingress an ack from storage");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error: zmq could not send ingress an ack from storage");
                 }
             }
             if (pollItems[2].revents & ZMQ_POLLIN) { //release messages
@@ -755,23 +909,19 @@ void ZmqStorageInterface::ThreadFunc() {
                 const zmq::recv_buffer_result_t res = m_zmqSubSock_boundReleaseToConnectingStoragePtr->recv(
                     zmq::mutable_buffer(rxBufReleaseMessagesAlign64, minBufSizeBytesReleaseMessages), zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "[schedule release] message not received" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[schedule release] message not received");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[schedule release] message not received");
                     continue;
                 }
                 else if (res->size < sizeof(hdtn::CommonHdr)) {
-                    std::cerr << "[schedule release] res->size < sizeof(hdtn::CommonHdr)" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[schedule release] res->size < sizeof(hdtn::CommonHdr)");
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[schedule release] res->size < sizeof(hdtn::CommonHdr)");
                     continue;
                 }
 
-                std::cout << "release message received\n";
-                hdtn::Logger::getInstance()->logNotification("storage", "Release message received");
+                HDTN_LOG_NOTIFICATION_RATE_LIMITED(10, "storage", "release message received");
                 hdtn::CommonHdr *commonHdr = (hdtn::CommonHdr *)rxBufReleaseMessagesAlign64;
                 if (commonHdr->type == HDTN_MSGTYPE_ILINKUP) {
                     if (res->size != sizeof(hdtn::IreleaseStartHdr)) {
-                        std::cerr << "[schedule release] res->size != sizeof(hdtn::IreleaseStartHdr)" << std::endl;
-                        hdtn::Logger::getInstance()->logError("storage", "[schedule release] res->size != sizeof(hdtn::IreleaseStartHdr)");
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[schedule release] res->size != sizeof(hdtn::IreleaseStartHdr)");
                         continue;
                     }
 
@@ -786,8 +936,7 @@ void ZmqStorageInterface::ThreadFunc() {
 		}
                 else if (commonHdr->type == HDTN_MSGTYPE_ILINKDOWN) {
                     if (res->size != sizeof(hdtn::IreleaseStopHdr)) {
-                        std::cerr << "[schedule release] res->size != sizeof(hdtn::IreleaseStopHdr)" << std::endl;
-                        hdtn::Logger::getInstance()->logError("storage", "[schedule release] res->size != sizeof(hdtn::IreleaseStopHdr)");
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "[schedule release] res->size != sizeof(hdtn::IreleaseStopHdr)");
                         continue;
                     }
 
@@ -806,14 +955,21 @@ void ZmqStorageInterface::ThreadFunc() {
                 uint8_t guiMsgByte;
                 const zmq::recv_buffer_result_t res = m_zmqRepSock_connectingGuiToFromBoundStoragePtr->recv(zmq::mutable_buffer(&guiMsgByte, sizeof(guiMsgByte)), zmq::recv_flags::dontwait);
                 if (!res) {
-                    std::cerr << "error in ZmqStorageInterface::ThreadFunc: cannot read guiMsgByte" << std::endl;
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error in ZmqStorageInterface::ThreadFunc: cannot read guiMsgByte");
                 }
                 else if ((res->truncated()) || (res->size != sizeof(guiMsgByte))) {
-                    std::cerr << "guiMsgByte message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(guiMsgByte) << std::endl;
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "guiMsgByte message mismatch: untruncated = {} truncated = {} expected = {}",
+                        res->untruncated_size, res->size, sizeof(guiMsgByte));
+                }
+                else if (guiMsgByte == TELEMETRY_GUI_REQUEST_METRICS_SNAPSHOT) {
+                    static const std::vector<std::string> metricsNamePrefixes = { "storage." };
+                    const std::string metricsJson = MetricsRegistry::GetInstance().GetSnapshot(metricsNamePrefixes).ToJson();
+                    if (!m_zmqRepSock_connectingGuiToFromBoundStoragePtr->send(zmq::const_buffer(metricsJson.data(), metricsJson.size()), zmq::send_flags::dontwait)) {
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "storage", "storage can't send metrics snapshot to gui");
+                    }
                 }
-                else if (guiMsgByte != 1) {
-                    std::cerr << "error guiMsgByte not 1\n";
+                else if (guiMsgByte != TELEMETRY_GUI_REQUEST_TELEMETRY) {
+                    HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error guiMsgByte not 1");
                 }
                 else {
                     //send telemetry
@@ -822,23 +978,19 @@ void ZmqStorageInterface::ThreadFunc() {
                     telem.totalBundlesErasedFromStorage = GetCurrentNumberOfBundlesDeletedFromStorage();
                     telem.totalBundlesSentToEgressFromStorage = m_totalBundlesSentToEgressFromStorage;
                     if (!m_zmqRepSock_connectingGuiToFromBoundStoragePtr->send(zmq::const_buffer(&telem, sizeof(telem)), zmq::send_flags::dontwait)) {
-                        std::cerr << "storage can't send telemetry to gui" << std::endl;
+                        HDTN_LOG_WARNING_RATE_LIMITED(1, "storage", "storage can't send telemetry to gui");
                     }
                 }
             }
         }
 
         const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
-        if ((acsSendNowExpiry <= nowPtime) || (ctm.GetLargestNumberOfFills() > ACS_MAX_FILLS_PER_ACS_PACKET)) {
-            //std::cout << "send acs, fills = " << ctm.GetLargestNumberOfFills() << "\n";
-            //test with generate all
-            std::list<BundleViewV6> newAcsRenderedBundleViewList;
-            if (ctm.GenerateAllAcsBundlesAndClear(newAcsRenderedBundleViewList)) {
-                for(std::list<BundleViewV6>::iterator it = newAcsRenderedBundleViewList.begin(); it != newAcsRenderedBundleViewList.end(); ++it) {
-                    WriteAcsBundle(bsm, custodyIdAllocator, it->m_primaryBlockView.header, it->m_frontBuffer);
-                }
+        if (ctm.IsAcsReadyToSend(nowPtime)) { //an acs reached its max fills/bytes or its first fill is ACS_SEND_PERIOD old
+            std::list<serialized_acs_bundle_t> newAcsBundleList;
+            ctm.GenerateReadyAcsBundles(newAcsBundleList, nowPtime);
+            for (std::list<serialized_acs_bundle_t>::iterator it = newAcsBundleList.begin(); it != newAcsBundleList.end(); ++it) {
+                WriteAdminRecordBundle(bsm, custodyIdAllocator, it->m_primary, it->m_primary.m_sourceNodeId, it->m_bundleSerialized);
             }
-            acsSendNowExpiry = nowPtime + ACS_SEND_PERIOD;
         }
 
         uint64_t custodyIdExpiredAndNeedingResent;
@@ -847,9 +999,16 @@ void ZmqStorageInterface::ThreadFunc() {
                 ++numCustodyTransferTimeouts;
             }
             else {
-                std::cerr << "error unable to return expired custody id " << custodyIdExpiredAndNeedingResent << " to the awaiting send\n";
+                HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "error unable to return expired custody id {} to the awaiting send", custodyIdExpiredAndNeedingResent);
             }
         }
+
+        if (expirationSweepExpiry <= nowPtime) {
+            const bool moreExpiredBundlesMayRemain = SweepExpiredBundles(bsm, sessionRead, custodyIdAllocator, ctm, custodyTimers,
+                finalDestEidToOpenCustIdsMap, expiredCustodyIdsVec, TimestampUtil::GetSecondsSinceEpochRfc5050(nowPtime), MAX_EXPIRED_BUNDLES_PER_SWEEP,
+                metricBundlesExpired, metricBytesReclaimedFromExpiredBundles, metricExpirationStatusReportsGenerated);
+            expirationSweepExpiry = (moreExpiredBundlesMayRemain) ? nowPtime : (nowPtime + EXPIRATION_SWEEP_PERIOD);
+        }
         
         
         //Send and maintain a maximum of 5 unacked bundles (per flow id) to Egress.
@@ -872,16 +1031,17 @@ void ZmqStorageInterface::ThreadFunc() {
                 }
             }
             if (availableDestLinksNotCloggedVec.size() > 0) {
-                if (ReleaseOne_NoBlock(sessionRead, availableDestLinksNotCloggedVec, m_zmqPushSock_connectingStorageToBoundEgressPtr.get(), bsm, maxBundleSizeToRead)) { //true => (successfully sent to egress)
+                if (ReleaseOne_NoBlock(sessionRead, availableDestLinksNotCloggedVec, m_zmqPushSock_connectingStorageToBoundEgressPtr.get(), bsm, maxBundleSizeToRead, metricReadLatency)) { //true => (successfully sent to egress)
                     if (finalDestEidToOpenCustIdsMap[sessionRead.catalogEntryPtr->destEid].insert(sessionRead.custodyId).second) {
                         if (sessionRead.catalogEntryPtr->HasCustody()) {
                             custodyTimers.StartCustodyTransferTimer(sessionRead.catalogEntryPtr->destEid, sessionRead.custodyId);
                         }
                         timeoutPoll = 0; //no timeout as we need to keep feeding to egress
                         ++m_totalBundlesSentToEgressFromStorage;
+                        metricBundlesSentToEgress.Increment();
                     }
                     else {
-                        std::cerr << "could not insert custody id into finalDestEidToOpenCustIdsMap\n";
+                        HDTN_LOG_ERROR_RATE_LIMITED(10, "storage", "could not insert custody id into finalDestEidToOpenCustIdsMap");
                     }
                 }
                 else if (PeekOne(availableDestLinksCloggedVec, bsm) > 0) { //data available in storage for clogged links
@@ -917,6 +1077,7 @@ void ZmqStorageInterface::ThreadFunc() {
     std::cout << "m_numAcsPacketsReceived: " << m_numAcsPacketsReceived << std::endl;
     std::cout << "m_totalBundlesErasedFromStorageNoCustodyTransfer: " << m_totalBundlesErasedFromStorageNoCustodyTransfer << std::endl;
     std::cout << "m_totalBundlesErasedFromStorageWithCustodyTransfer: " << m_totalBundlesErasedFromStorageWithCustodyTransfer << std::endl;
+    std::cout << "m_totalBundlesErasedFromStorageDueToExpiration: " << m_totalBundlesErasedFromStorageDueToExpiration << std::endl;
     std::cout << "numCustodyTransferTimeouts: " << numCustodyTransferTimeouts << std::endl;
     hdtn::Logger::getInstance()->logInfo("storage", "totalEventsAllLinksClogged: " + 
         std::to_string(totalEventsAllLinksClogged));
@@ -927,5 +1088,5 @@ void ZmqStorageInterface::ThreadFunc() {
 }
 
 std::size_t ZmqStorageInterface::GetCurrentNumberOfBundlesDeletedFromStorage() {
-    return m_totalBundlesErasedFromStorageNoCustodyTransfer + m_totalBundlesErasedFromStorageWithCustodyTransfer;
+    return m_totalBundlesErasedFromStorageNoCustodyTransfer + m_totalBundlesErasedFromStorageWithCustodyTransfer + m_totalBundlesErasedFromStorageDueToExpiration;
 }
@@ -99,7 +99,7 @@ static bool GenerateBundleV7(std::vector<uint8_t> & bundle, const Bpv7CbhePrimar
 
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 {
-    for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+    for (unsigned int whichBsm = 0; whichBsm < 4; ++whichBsm) { //odd => asio, 2 and 3 => extent disk layout
         boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
         const boost::random::uniform_int_distribution<> distRandomData(0, 255);
         const boost::random::uniform_int_distribution<> distLinkId(0, 9);
@@ -137,7 +137,8 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
         StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
         ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
         ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
-        if (whichBsm == 0) {
+        ptrStorageConfig->m_diskExtentSizeSegmentsOrZeroToDisable = (whichBsm >= 2) ? 64 : 0; //manually set this json entry
+        if ((whichBsm & 1) == 0) {
             std::cout << "create BundleStorageManagerMT" << std::endl;
             bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
         }
@@ -250,7 +251,7 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
 {
     for (unsigned int whichBundleVersion = 6; whichBundleVersion <= 7; ++whichBundleVersion) {
-        for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+        for (unsigned int whichBsm = 0; whichBsm < 4; ++whichBsm) { //odd => asio, 2 and 3 => extent disk layout
             boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
             const boost::random::uniform_int_distribution<> distRandomData(0, 255);
             const boost::random::uniform_int_distribution<> distPriorityIndex(0, 2);
@@ -314,7 +315,8 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                 StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
                 ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
                 ptrStorageConfig->m_autoDeleteFilesOnExit = false; //manually set this json entry
-                if (whichBsm == 0) {
+                ptrStorageConfig->m_diskExtentSizeSegmentsOrZeroToDisable = (whichBsm >= 2) ? 64 : 0; //manually set this json entry
+                if ((whichBsm & 1) == 0) {
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
@@ -409,7 +411,8 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                 StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
                 ptrStorageConfig->m_tryToRestoreFromDisk = true; //manually set this json entry
                 ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
-                if (whichBsm == 0) {
+                ptrStorageConfig->m_diskExtentSizeSegmentsOrZeroToDisable = (whichBsm >= 2) ? 64 : 0; //manually set this json entry
+                if ((whichBsm & 1) == 0) {
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
@@ -16,6 +16,7 @@
 #include "MemoryManagerTreeArray.h"
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/multiprecision/detail/bitscan.hpp>
+#include <boost/timer/timer.hpp>
 #include <iostream>
 #include <string>
 #include <inttypes.h>
@@ -244,3 +245,147 @@ BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayFullTestCase)
         BOOST_REQUIRE(t.AllocateSegmentId_NotThreadSafe(i));
     }
 }
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayBulkTestCase)
+{
+    //bulk allocation must give the same segment Ids (first free in numerical order) and tree as allocating one segment at a time
+    const uint64_t MAX_SEGMENTS = (64 * 64 * 3) + 17;
+    MemoryManagerTreeArray tBulk(MAX_SEGMENTS);
+    MemoryManagerTreeArray tSingle(MAX_SEGMENTS);
+    memmanager_t backup;
+    BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), MAX_SEGMENTS);
+
+    //fragment the trees: every 5th segment of the first 1000 stays allocated
+    for (segment_id_t i = 0; i < 1000; ++i) {
+        BOOST_REQUIRE_EQUAL(tSingle.GetAndSetFirstFreeSegmentId_NotThreadSafe(), i);
+    }
+    {
+        segment_id_chain_vec_t segmentVec(1000);
+        BOOST_REQUIRE(tBulk.AllocateSegments_ThreadSafe(segmentVec));
+        for (segment_id_t i = 0; i < 1000; ++i) {
+            BOOST_REQUIRE_EQUAL(segmentVec[i], i);
+        }
+        segment_id_chain_vec_t toFree;
+        for (segment_id_t i = 0; i < 1000; ++i) {
+            if (i % 5) {
+                toFree.push_back(i);
+                BOOST_REQUIRE(tSingle.FreeSegmentId_NotThreadSafe(i));
+            }
+        }
+        BOOST_REQUIRE(tBulk.FreeSegments_ThreadSafe(toFree));
+        tSingle.BackupDataToVector(backup);
+        BOOST_REQUIRE(tBulk.IsBackupEqual(backup));
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), tSingle.GetNumFreeSegments());
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), MAX_SEGMENTS - 200);
+    }
+
+    const std::size_t sizes[6] = { 1, 63, 64, 300, 1000, 4096 };
+    std::vector<segment_id_chain_vec_t> chains;
+    for (unsigned int s = 0; s < 6; ++s) {
+        segment_id_chain_vec_t segmentVec(sizes[s]);
+        BOOST_REQUIRE(tBulk.AllocateSegments_ThreadSafe(segmentVec));
+        BOOST_REQUIRE_EQUAL(segmentVec.size(), sizes[s]);
+        for (std::size_t i = 0; i < sizes[s]; ++i) {
+            BOOST_REQUIRE_EQUAL(segmentVec[i], tSingle.GetAndSetFirstFreeSegmentId_NotThreadSafe());
+        }
+        tSingle.BackupDataToVector(backup);
+        BOOST_REQUIRE(tBulk.IsBackupEqual(backup));
+        chains.push_back(std::move(segmentVec));
+    }
+    BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), tSingle.GetNumFreeSegments());
+
+    //not enough free segments: nothing allocated
+    {
+        tBulk.BackupDataToVector(backup);
+        segment_id_chain_vec_t segmentVec(static_cast<std::size_t>(tBulk.GetNumFreeSegments() + 1));
+        BOOST_REQUIRE(!tBulk.AllocateSegments_ThreadSafe(segmentVec));
+        BOOST_REQUIRE(segmentVec.empty());
+        BOOST_REQUIRE(tBulk.IsBackupEqual(backup));
+    }
+
+    //fill to exactly full
+    {
+        segment_id_chain_vec_t segmentVec(static_cast<std::size_t>(tBulk.GetNumFreeSegments()));
+        BOOST_REQUIRE(tBulk.AllocateSegments_ThreadSafe(segmentVec));
+        for (std::size_t i = 0; i < segmentVec.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(segmentVec[i], tSingle.GetAndSetFirstFreeSegmentId_NotThreadSafe());
+        }
+        BOOST_REQUIRE_EQUAL(tSingle.GetAndSetFirstFreeSegmentId_NotThreadSafe(), SEGMENT_ID_FULL);
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), 0);
+        tSingle.BackupDataToVector(backup);
+        BOOST_REQUIRE(tBulk.IsBackupEqual(backup));
+        segment_id_chain_vec_t oneMore(1);
+        BOOST_REQUIRE(!tBulk.AllocateSegments_ThreadSafe(oneMore));
+    }
+
+    //bulk free of chains must give the same tree as freeing one segment at a time
+    for (std::size_t c = 0; c < chains.size(); ++c) {
+        BOOST_REQUIRE(tBulk.FreeSegments_ThreadSafe(chains[c]));
+        for (std::size_t i = 0; i < chains[c].size(); ++i) {
+            BOOST_REQUIRE(tSingle.FreeSegmentId_NotThreadSafe(chains[c][i]));
+        }
+        tSingle.BackupDataToVector(backup);
+        BOOST_REQUIRE(tBulk.IsBackupEqual(backup));
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), tSingle.GetNumFreeSegments());
+    }
+
+    //already free, duplicate, and out of range segment Ids fail but the allocated ones are still freed
+    {
+        segment_id_chain_vec_t segmentVec;
+        segmentVec.push_back(chains[0][0]); //already free
+        segmentVec.push_back(6000); //allocated
+        segmentVec.push_back(6001); //allocated
+        segmentVec.push_back(6001); //duplicate
+        segmentVec.push_back(static_cast<segment_id_t>(MAX_SEGMENTS)); //out of range
+        segmentVec.push_back(static_cast<segment_id_t>(MAX_SEGMENTS - 1)); //allocated
+        const uint64_t numFreeBefore = tBulk.GetNumFreeSegments();
+        BOOST_REQUIRE(!tBulk.FreeSegments_ThreadSafe(segmentVec));
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), numFreeBefore + 3);
+        BOOST_REQUIRE(tBulk.IsSegmentFree(6000));
+        BOOST_REQUIRE(tBulk.IsSegmentFree(6001));
+        BOOST_REQUIRE(tBulk.IsSegmentFree(static_cast<segment_id_t>(MAX_SEGMENTS - 1)));
+        BOOST_REQUIRE(!tBulk.FreeSegments_ThreadSafe(segmentVec)); //all already free now
+        BOOST_REQUIRE_EQUAL(tBulk.GetNumFreeSegments(), numFreeBefore + 3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayAllocationSpeedTestCase, *boost::unit_test::disabled())
+{
+    //allocation throughput of 1 MByte bundles: one tree descent per segment versus the bulk allocator
+    const uint64_t MAX_SEGMENTS = (1024000000ULL * 8) / SEGMENT_SIZE + 1;
+    const std::size_t SEGMENTS_PER_BUNDLE = (1024 * 1024) / BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1;
+    const std::size_t NUM_BUNDLES = static_cast<std::size_t>(MAX_SEGMENTS / SEGMENTS_PER_BUNDLE);
+    std::vector<segment_id_chain_vec_t> chains(NUM_BUNDLES, segment_id_chain_vec_t(SEGMENTS_PER_BUNDLE));
+    memmanager_t backup;
+    {
+        MemoryManagerTreeArray t(MAX_SEGMENTS);
+        boost::timer::cpu_timer timer;
+        for (std::size_t b = 0; b < NUM_BUNDLES; ++b) {
+            segment_id_chain_vec_t & segmentVec = chains[b];
+            for (std::size_t i = 0; i < SEGMENTS_PER_BUNDLE; ++i) {
+                segmentVec[i] = t.GetAndSetFirstFreeSegmentId_NotThreadSafe();
+            }
+        }
+        std::cout << "GetAndSetFirstFreeSegmentId_NotThreadSafe: "
+            << (static_cast<double>(timer.elapsed().wall) / (NUM_BUNDLES * SEGMENTS_PER_BUNDLE)) << " ns per segment\n";
+        t.BackupDataToVector(backup);
+    }
+    {
+        MemoryManagerTreeArray t(MAX_SEGMENTS);
+        boost::timer::cpu_timer timer;
+        for (std::size_t b = 0; b < NUM_BUNDLES; ++b) {
+            BOOST_REQUIRE(t.AllocateSegments_ThreadSafe(chains[b]));
+        }
+        std::cout << "AllocateSegments_ThreadSafe: "
+            << (static_cast<double>(timer.elapsed().wall) / (NUM_BUNDLES * SEGMENTS_PER_BUNDLE)) << " ns per segment\n";
+        BOOST_REQUIRE(t.IsBackupEqual(backup));
+
+        timer.start();
+        for (std::size_t b = 0; b < NUM_BUNDLES; ++b) {
+            BOOST_REQUIRE(t.FreeSegments_ThreadSafe(chains[b]));
+        }
+        std::cout << "FreeSegments_ThreadSafe: "
+            << (static_cast<double>(timer.elapsed().wall) / (NUM_BUNDLES * SEGMENTS_PER_BUNDLE)) << " ns per segment\n";
+        BOOST_REQUIRE_EQUAL(t.GetNumFreeSegments(), MAX_SEGMENTS);
+    }
+}
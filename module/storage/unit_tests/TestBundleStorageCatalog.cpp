@@ -18,6 +18,7 @@
 #include <string>
 #include <inttypes.h>
 #include <set>
+#include <boost/timer/timer.hpp>
 #include "codec/bpv6.h"
 #include "codec/bpv7.h"
 
@@ -89,6 +90,7 @@ BOOST_AUTO_TEST_CASE(BundleStorageCatalogTestCase)
             BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdChainVec.size(), 1); //verify before move
             BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, *primaries[i], custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
             catalogEntryCopiesForVerification.back().ptrUuidKeyInMap = catalogEntryToTake.ptrUuidKeyInMap; //was potentially modified at CatalogIncomingBundleForStore
+            catalogEntryCopiesForVerification.back().custodyId = custodyId; //set at CatalogIncomingBundleForStore
             BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdChainVec.size(), 0); //verify was moved
         }
         const std::vector<cbhe_eid_t> availableDestinationEids({ cbhe_eid_t(501, 501) });
@@ -150,3 +152,171 @@ BOOST_AUTO_TEST_CASE(BundleStorageCatalogTestCase)
 
     
 }
+
+static void CatalogBundlesV6(BundleStorageCatalog & bsc, const uint64_t numBundles, const BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER order) {
+    for (uint64_t i = 0; i < numBundles; ++i) {
+        Bpv6CbhePrimaryBlock primary;
+        CreatePrimaryV6(primary, cbhe_eid_t(500, 500), cbhe_eid_t(501, 501), true, 1000, i); //same dest, priority, and expiry
+        catalog_entry_t catalogEntryToTake;
+        catalogEntryToTake.Init(primary, 1000, 1, NULL);
+        catalogEntryToTake.segmentIdChainVec = { static_cast<segment_id_t>(i) };
+        BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primary, i, order));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogRemoveAwaitingSendTestCase)
+{
+    const std::vector<cbhe_eid_t> availableDestinationEids({ cbhe_eid_t(501, 501) });
+    for (unsigned int whichOrder = 0; whichOrder < 2; ++whichOrder) {
+        const BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER order = (whichOrder == 0) ?
+            BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO : BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::SEQUENCE_NUMBER;
+        BundleStorageCatalog bsc;
+        CatalogBundlesV6(bsc, 10, order);
+        //remove from the middle, head, and tail of the awaiting send list
+        const std::set<uint64_t> removedCustodyIds({ 0, 4, 5, 9 });
+        const std::pair<bool, uint16_t> expectedRet(true, 3); //3 removals, awaiting send list, m_custodyIdToCatalogEntryHashmap, and m_uuidNoFragToCustodyIdHashMap
+        const std::pair<bool, uint16_t> expectedRetFail(false, 0);
+        for (std::set<uint64_t>::const_iterator it = removedCustodyIds.cbegin(); it != removedCustodyIds.cend(); ++it) {
+            BOOST_REQUIRE(bsc.GetEntryFromCustodyId(*it)->IsAwaitingSend());
+            BOOST_REQUIRE(expectedRet == bsc.Remove(*it, true)); //awaiting send list, custody id, and uuid
+            BOOST_REQUIRE(bsc.GetEntryFromCustodyId(*it) == NULL);
+            BOOST_REQUIRE(expectedRetFail == bsc.Remove(*it, true));
+        }
+        //a popped entry is not awaiting send, and can't be removed from awaiting send twice
+        uint64_t custodyId;
+        catalog_entry_t * entryPtr = bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids);
+        BOOST_REQUIRE(entryPtr != NULL);
+        BOOST_REQUIRE_EQUAL(custodyId, 1);
+        BOOST_REQUIRE(!entryPtr->IsAwaitingSend());
+        BOOST_REQUIRE(!bsc.RemoveEntryFromAwaitingSend(*entryPtr, custodyId));
+        BOOST_REQUIRE(bsc.ReturnEntryToAwaitingSend(*entryPtr, custodyId));
+        BOOST_REQUIRE(!bsc.ReturnEntryToAwaitingSend(*entryPtr, custodyId)); //already awaiting send
+        //remaining pop order is preserved
+        for (uint64_t expectedCustodyId = 1; expectedCustodyId < 10; ++expectedCustodyId) {
+            if (removedCustodyIds.count(expectedCustodyId)) {
+                continue;
+            }
+            entryPtr = bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids);
+            BOOST_REQUIRE(entryPtr != NULL);
+            BOOST_REQUIRE_EQUAL(custodyId, expectedCustodyId);
+            BOOST_REQUIRE_EQUAL(entryPtr->custodyId, expectedCustodyId);
+            BOOST_REQUIRE_EQUAL(entryPtr->sequence, expectedCustodyId);
+        }
+        BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids) == NULL);
+    }
+
+    //out of order sequence insertion
+    {
+        BundleStorageCatalog bsc;
+        const uint64_t sequences[6] = { 5, 1, 3, 0, 4, 2 };
+        for (unsigned int i = 0; i < 6; ++i) {
+            Bpv6CbhePrimaryBlock primary;
+            CreatePrimaryV6(primary, cbhe_eid_t(500, 500), cbhe_eid_t(501, 501), true, 1000, sequences[i]);
+            catalog_entry_t catalogEntryToTake;
+            catalogEntryToTake.Init(primary, 1000, 1, NULL);
+            catalogEntryToTake.segmentIdChainVec = { static_cast<segment_id_t>(i) };
+            BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primary, 100 + sequences[i], BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::SEQUENCE_NUMBER));
+        }
+        BOOST_REQUIRE(bsc.Remove(103, true).first);
+        for (uint64_t expectedSequence = 0; expectedSequence < 6; ++expectedSequence) {
+            if (expectedSequence == 3) {
+                continue;
+            }
+            uint64_t custodyId;
+            catalog_entry_t * entryPtr = bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids);
+            BOOST_REQUIRE(entryPtr != NULL);
+            BOOST_REQUIRE_EQUAL(entryPtr->sequence, expectedSequence);
+            BOOST_REQUIRE_EQUAL(custodyId, 100 + expectedSequence);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogRemoveCustodyIdRangeTestCase)
+{
+    BundleStorageCatalog bsc;
+    CatalogBundlesV6(bsc, 20, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
+    BOOST_REQUIRE(bsc.Remove(7, true).first); //leave a gap in the range
+    std::vector<catalog_entry_t> removedEntries;
+    BOOST_REQUIRE_EQUAL(bsc.RemoveCustodyIdRange(5, 14, true, removedEntries), 9);
+    BOOST_REQUIRE_EQUAL(removedEntries.size(), 9);
+    for (std::size_t i = 0; i < removedEntries.size(); ++i) {
+        const uint64_t expectedCustodyId = (i < 2) ? (5 + i) : (6 + i);
+        BOOST_REQUIRE_EQUAL(removedEntries[i].custodyId, expectedCustodyId);
+        BOOST_REQUIRE_EQUAL(removedEntries[i].segmentIdChainVec.size(), 1);
+        BOOST_REQUIRE_EQUAL(removedEntries[i].segmentIdChainVec[0], expectedCustodyId);
+        BOOST_REQUIRE(!removedEntries[i].IsAwaitingSend());
+        BOOST_REQUIRE(bsc.GetEntryFromCustodyId(expectedCustodyId) == NULL);
+    }
+    BOOST_REQUIRE_EQUAL(bsc.RemoveCustodyIdRange(5, 14, true, removedEntries), 0);
+    const std::vector<cbhe_eid_t> availableDestinationEids({ cbhe_eid_t(501, 501) });
+    for (uint64_t expectedCustodyId = 0; expectedCustodyId < 20; ++expectedCustodyId) {
+        if ((expectedCustodyId >= 5) && (expectedCustodyId <= 14)) {
+            continue;
+        }
+        uint64_t custodyId;
+        BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids) != NULL);
+        BOOST_REQUIRE_EQUAL(custodyId, expectedCustodyId);
+    }
+    uint64_t custodyId;
+    BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids) == NULL);
+}
+
+//removing a bundle still awaiting send shall not depend on the number of bundles sharing its dest/priority/expiry
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogRemoveSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_BUNDLES[3] = { 1000, 10000, 100000 };
+    for (unsigned int n = 0; n < 3; ++n) {
+        BundleStorageCatalog bsc;
+        CatalogBundlesV6(bsc, NUM_BUNDLES[n], BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
+        //remove from the tail first, the worst case for a list search from the head
+        boost::timer::cpu_timer timer;
+        for (uint64_t i = NUM_BUNDLES[n]; i > 0; --i) {
+            BOOST_REQUIRE(bsc.Remove(i - 1, true).first);
+        }
+        std::cout << "BundleStorageCatalog::Remove with " << NUM_BUNDLES[n] << " bundles awaiting send: "
+            << (static_cast<double>(timer.elapsed().wall) / NUM_BUNDLES[n]) << " ns per bundle\n";
+        uint64_t custodyId;
+        BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, std::vector<cbhe_eid_t>({ cbhe_eid_t(501, 501) })) == NULL);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogPopExpiredCustodyIdsTestCase)
+{
+    BundleStorageCatalog bsc;
+    //catalog in reverse expiration order, bundle i expires at 2000 + i
+    for (uint64_t i = 10; i > 0; --i) {
+        const uint64_t custodyId = i - 1;
+        Bpv6CbhePrimaryBlock primary;
+        CreatePrimaryV6(primary, cbhe_eid_t(500, 500), cbhe_eid_t(501, 501), false, 1000 + custodyId, 0);
+        catalog_entry_t catalogEntryToTake;
+        catalogEntryToTake.Init(primary, 1000, 1, NULL);
+        catalogEntryToTake.segmentIdChainVec = { static_cast<segment_id_t>(custodyId) };
+        BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primary, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+        BOOST_REQUIRE_EQUAL(bsc.GetEntryFromCustodyId(custodyId)->GetAbsExpiration(), 2000 + custodyId);
+    }
+    BOOST_REQUIRE_EQUAL(bsc.GetNumEntries(), 10);
+    std::vector<uint64_t> expiredCustodyIds;
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredCustodyIds(1999, 100, expiredCustodyIds), 0); //nothing expired yet
+
+    //removed bundles are skipped
+    BOOST_REQUIRE(bsc.Remove(1, true).first);
+    BOOST_REQUIRE(bsc.Remove(3, true).first);
+    BOOST_REQUIRE_EQUAL(bsc.GetNumEntries(), 8);
+
+    //bounded by maxCustodyIds, soonest expiration first
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredCustodyIds(2005, 2, expiredCustodyIds), 2);
+    BOOST_REQUIRE(expiredCustodyIds == std::vector<uint64_t>({ 0, 2 }));
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredCustodyIds(2005, 100, expiredCustodyIds), 2); //appended
+    BOOST_REQUIRE(expiredCustodyIds == std::vector<uint64_t>({ 0, 2, 4, 5 }));
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredCustodyIds(2005, 100, expiredCustodyIds), 0); //already popped
+
+    //popping does not remove the entries, the caller deletes the bundles
+    for (std::size_t i = 0; i < expiredCustodyIds.size(); ++i) {
+        BOOST_REQUIRE(bsc.GetEntryFromCustodyId(expiredCustodyIds[i]) != NULL);
+        BOOST_REQUIRE(bsc.Remove(expiredCustodyIds[i], true).first);
+    }
+    BOOST_REQUIRE_EQUAL(bsc.GetNumEntries(), 4);
+    expiredCustodyIds.clear();
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredCustodyIds(UINT64_MAX, 100, expiredCustodyIds), 4);
+    BOOST_REQUIRE(expiredCustodyIds == std::vector<uint64_t>({ 6, 7, 8, 9 }));
+}
@@ -0,0 +1,149 @@
+/**
+ * @file TestStorageExpirationSweep.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "ZmqStorageInterface.h"
+#include "BundleStorageManagerMT.h"
+#include "CustodyTimers.h"
+#include "Environment.h"
+#include "codec/BundleViewV7.h"
+#include "codec/CustodyIdAllocator.h"
+#include "codec/CustodyTransferManager.h"
+#include <boost/make_unique.hpp>
+
+static void GenerateExpirationTestBundleV7(std::vector<uint8_t> & bundle, const uint64_t creationSeconds, const uint64_t lifetimeSeconds,
+    const uint64_t sequence, const bool deletionReportRequested)
+{
+    BundleViewV7 bv;
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = (deletionReportRequested) ? BPV7_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED : BPV7_BUNDLEFLAG::NO_FLAGS_SET;
+    primary.m_sourceNodeId.Set(100, 1);
+    primary.m_destinationEid.Set(200, 2);
+    primary.m_reportToEid.Set(300, 1);
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = creationSeconds * 1000;
+    primary.m_creationTimestamp.sequenceNumber = sequence;
+    primary.m_lifetimeMilliseconds = lifetimeSeconds * 1000;
+    primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    bv.m_primaryBlockView.SetManuallyModified();
+    std::vector<uint8_t> payloadData(1000, static_cast<uint8_t>(sequence));
+    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+    blockPtr->m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+    blockPtr->m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+    blockPtr->m_blockNumber = 1;
+    blockPtr->m_crcType = BPV7_CRC_TYPE::CRC32C;
+    blockPtr->m_dataLength = payloadData.size();
+    blockPtr->m_dataPtr = payloadData.data();
+    bv.AppendMoveCanonicalBlock(blockPtr);
+    BOOST_REQUIRE(bv.Render(payloadData.size() + 500));
+    bundle = std::move(bv.m_frontBuffer);
+}
+
+static uint64_t WriteExpirationTestBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator, const std::vector<uint8_t> & bundle) {
+    BundleViewV7 bv;
+    BOOST_REQUIRE(bv.CopyAndLoadBundle(bundle.data(), bundle.size()));
+    const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    const uint64_t custodyId = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+    BundleStorageManagerSession_WriteToDisk sessionWrite;
+    BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, bundle.size()), 0);
+    BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, bundle.data(), bundle.size()), bundle.size());
+    return custodyId;
+}
+
+//drives the storage expiration sweep directly: an expired bundle is deleted (with its deletion status report written
+//to storage and its custody id freed), a bundle with an unknown (zero) creation time is never aged out, and an unexpired bundle stays
+BOOST_AUTO_TEST_CASE(StorageExpirationSweepTestCase)
+{
+    StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+    BOOST_REQUIRE(ptrStorageConfig);
+    ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+    ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+    BundleStorageManagerMT bsm(ptrStorageConfig);
+    bsm.Start();
+
+    ZmqStorageInterface storage;
+    storage.m_totalBundlesErasedFromStorageDueToExpiration = 0;
+    storage.M_HDTN_EID_CUSTODY.Set(150, 0);
+    BundleStorageManagerSession_ReadFromDisk sessionRead;
+    CustodyIdAllocator custodyIdAllocator;
+    CustodyTransferManager ctm(false, storage.M_HDTN_EID_CUSTODY.nodeId, storage.M_HDTN_EID_CUSTODY.serviceId);
+    CustodyTimers custodyTimers(boost::posix_time::seconds(10));
+    ZmqStorageInterface::finaldesteid_opencustids_map_t finalDestEidToOpenCustIdsMap;
+    std::vector<uint64_t> expiredCustodyIdsVec;
+    MetricsRegistry & metricsRegistry = MetricsRegistry::GetInstance();
+    MetricCounter & metricBundlesExpired = metricsRegistry.GetOrCreateCounter("storage.bundlesExpired");
+    MetricCounter & metricBytesReclaimed = metricsRegistry.GetOrCreateCounter("storage.bytesReclaimedFromExpiredBundles");
+    MetricCounter & metricStatusReportsGenerated = metricsRegistry.GetOrCreateCounter("storage.expirationStatusReportsGenerated");
+    const uint64_t bundlesExpiredBefore = metricBundlesExpired.Get();
+    const uint64_t bytesReclaimedBefore = metricBytesReclaimed.Get();
+    const uint64_t statusReportsBefore = metricStatusReportsGenerated.Get();
+
+    std::vector<uint8_t> expiredBundle, unknownCreationTimeBundle, unexpiredBundle;
+    GenerateExpirationTestBundleV7(expiredBundle, 1000, 100, 1, true); //expires at 1100 seconds
+    GenerateExpirationTestBundleV7(unknownCreationTimeBundle, 0, 100, 2, true);
+    GenerateExpirationTestBundleV7(unexpiredBundle, 1000, 10000000, 3, false); //expires at 10001000 seconds
+    const uint64_t expiredCustodyId = WriteExpirationTestBundle(bsm, custodyIdAllocator, expiredBundle);
+    const uint64_t unknownCreationTimeCustodyId = WriteExpirationTestBundle(bsm, custodyIdAllocator, unknownCreationTimeBundle);
+    const uint64_t unexpiredCustodyId = WriteExpirationTestBundle(bsm, custodyIdAllocator, unexpiredBundle);
+    finalDestEidToOpenCustIdsMap[cbhe_eid_t(200, 2)].insert(expiredCustodyId); //as if sent to egress and awaiting its ack
+
+    BOOST_REQUIRE(!storage.SweepExpiredBundles(bsm, sessionRead, custodyIdAllocator, ctm, custodyTimers,
+        finalDestEidToOpenCustIdsMap, expiredCustodyIdsVec, 5000, 10,
+        metricBundlesExpired, metricBytesReclaimed, metricStatusReportsGenerated));
+    BOOST_REQUIRE_EQUAL(storage.m_totalBundlesErasedFromStorageDueToExpiration, 1);
+    BOOST_REQUIRE_EQUAL(metricBundlesExpired.Get() - bundlesExpiredBefore, 1);
+    BOOST_REQUIRE_EQUAL(metricBytesReclaimed.Get() - bytesReclaimedBefore, expiredBundle.size());
+    BOOST_REQUIRE_EQUAL(metricStatusReportsGenerated.Get() - statusReportsBefore, 1);
+    BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(expiredCustodyId) == NULL);
+    BOOST_REQUIRE(!custodyIdAllocator.IsCustodyIdUsed(expiredCustodyId));
+    BOOST_REQUIRE(finalDestEidToOpenCustIdsMap[cbhe_eid_t(200, 2)].empty());
+    BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(unknownCreationTimeCustodyId) != NULL);
+    BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(unexpiredCustodyId) != NULL);
+
+    //the lifetime expired status report was written to storage destined for the expired bundle's report-to eid
+    {
+        std::vector<uint8_t> reportReadBack;
+        BOOST_REQUIRE_NE(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(300, 1))), 0);
+        BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, reportReadBack));
+        BundleViewV7 reportBv;
+        BOOST_REQUIRE(reportBv.LoadBundle(reportReadBack.data(), reportReadBack.size()));
+        BOOST_REQUIRE(reportBv.m_primaryBlockView.header.m_sourceNodeId == storage.M_HDTN_EID_CUSTODY);
+        BOOST_REQUIRE(reportBv.m_primaryBlockView.header.m_destinationEid == cbhe_eid_t(300, 1));
+        std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+        reportBv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+        Bpv7AdministrativeRecord* adminRecordBlockPtr = dynamic_cast<Bpv7AdministrativeRecord*>(blocks[0]->headerPtr.get());
+        BOOST_REQUIRE(adminRecordBlockPtr);
+        BOOST_REQUIRE_EQUAL(adminRecordBlockPtr->m_adminRecordTypeCode, BPV7_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT);
+        Bpv7AdministrativeRecordContentBundleStatusReport * bsrPtr = dynamic_cast<Bpv7AdministrativeRecordContentBundleStatusReport*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
+        BOOST_REQUIRE(bsrPtr);
+        BOOST_REQUIRE(bsrPtr->m_bundleStatusInfo[3].first); //reporting-node-deleted-bundle
+        BOOST_REQUIRE_EQUAL(bsrPtr->m_statusReportReasonCode, BPV7_STATUS_REPORT_REASON_CODE::LIFETIME_EXPIRED);
+        BOOST_REQUIRE(bsrPtr->m_sourceNodeEid == cbhe_eid_t(100, 1));
+        BOOST_REQUIRE_EQUAL(bsrPtr->m_creationTimestamp.millisecondsSinceStartOfYear2000, 1000 * 1000);
+        BOOST_REQUIRE_EQUAL(bsrPtr->m_creationTimestamp.sequenceNumber, 1);
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+    }
+
+    //long after everything else has expired, the bundle with no creation time is still kept
+    BOOST_REQUIRE(!storage.SweepExpiredBundles(bsm, sessionRead, custodyIdAllocator, ctm, custodyTimers,
+        finalDestEidToOpenCustIdsMap, expiredCustodyIdsVec, 20000000, 10,
+        metricBundlesExpired, metricBytesReclaimed, metricStatusReportsGenerated));
+    BOOST_REQUIRE_EQUAL(storage.m_totalBundlesErasedFromStorageDueToExpiration, 2);
+    BOOST_REQUIRE_EQUAL(metricStatusReportsGenerated.Get() - statusReportsBefore, 1); //no deletion report requested
+    BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(unexpiredCustodyId) == NULL);
+    BOOST_REQUIRE(!custodyIdAllocator.IsCustodyIdUsed(unexpiredCustodyId));
+    BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(unknownCreationTimeCustodyId) != NULL);
+    BOOST_REQUIRE(custodyIdAllocator.IsCustodyIdUsed(unknownCreationTimeCustodyId));
+}
@@ -18,17 +18,22 @@
  * the specified remote destination.
  * The direction is one way, so create two separate instances/processes of UdpDelaySim
  * in order to achieve bidirectional communication such as LTP.
+ * Beyond the constant delay, a UdpDelaySimLinkModel can emulate burst loss, bandwidth,
+ * jitter, reordering, duplication, and a contact plan driven link schedule.
+ * Packets wait in a fixed pool of buffers, ordered by send time, and on Linux
+ * are received and sent in batches with recvmmsg/sendmmsg.
  */
 
 #ifndef _UDP_DELAY_SIM_H
 #define _UDP_DELAY_SIM_H 1
 
 #include <stdint.h>
-#include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <boost/date_time.hpp>
 #include <list>
+#include <queue>
+#include "UdpDelaySimLinkModel.h"
 #include "udp_delay_sim_lib_export.h"
 
 
@@ -44,6 +49,14 @@ public:
         const unsigned int maxUdpPacketSizeBytes,
         const boost::posix_time::time_duration & sendDelay,
         const bool autoStart);
+    UDP_DELAY_SIM_LIB_EXPORT UdpDelaySim(uint16_t myBoundUdpPort,
+        const std::string & remoteHostnameToForwardPacketsTo,
+        const std::string & remotePortToForwardPacketsTo,
+        const unsigned int numCircularBufferVectors,
+        const unsigned int maxUdpPacketSizeBytes,
+        const UdpDelaySimLinkModelConfig & linkModelConfig,
+        const std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule,
+        const bool autoStart);
     UDP_DELAY_SIM_LIB_EXPORT ~UdpDelaySim();
     UDP_DELAY_SIM_LIB_EXPORT void Stop();
     UDP_DELAY_SIM_LIB_EXPORT bool StartIfNotAlreadyRunning();
@@ -52,10 +65,15 @@ private:
     UDP_DELAY_SIM_LIB_NO_EXPORT void OnResolve(const boost::system::error_code & ec, boost::asio::ip::udp::resolver::results_type results);
     UDP_DELAY_SIM_LIB_NO_EXPORT void StartUdpReceive();
     UDP_DELAY_SIM_LIB_NO_EXPORT void HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void HandleUdpReadable(const boost::system::error_code & error);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void OnPacketReceived(const unsigned int bufferIndex, const std::size_t bytesTransferred, const boost::posix_time::ptime & nowTime);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void SendDuePackets();
     UDP_DELAY_SIM_LIB_NO_EXPORT void HandleUdpSend(const boost::system::error_code& error, std::size_t bytes_transferred);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void HandleUdpWritable(const boost::system::error_code & error);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void OnPacketSent(const unsigned int bufferIndex, const std::size_t bytesTransferred);
 
     UDP_DELAY_SIM_LIB_NO_EXPORT void TryRestartSendDelayTimer();
-    UDP_DELAY_SIM_LIB_NO_EXPORT void OnSendDelay_TimerExpired(const boost::system::error_code& e, const unsigned int consumeIndex);
+    UDP_DELAY_SIM_LIB_NO_EXPORT void OnSendDelay_TimerExpired(const boost::system::error_code& e);
 
     UDP_DELAY_SIM_LIB_NO_EXPORT void TransferRate_TimerExpired(const boost::system::error_code& e);
 public:
@@ -76,17 +94,33 @@ private:
     const std::string M_REMOTE_PORT_TO_FORWARD_PACKETS_TO;
     const unsigned int M_NUM_CIRCULAR_BUFFER_VECTORS;
     const unsigned int M_MAX_UDP_PACKET_SIZE_BYTES;
-    const boost::posix_time::time_duration M_SEND_DELAY;
-    std::vector<uint8_t> m_udpReceiveBuffer;
+    std::vector<uint8_t> m_udpReceiveBuffer; //receives into here when every packet buffer is in use (the packet gets dropped)
     boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
     boost::asio::ip::udp::endpoint m_udpDestinationEndpoint;
-    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
-    std::vector<std::vector<uint8_t> > m_udpReceiveBuffersCbVec;
-    std::vector<uint64_t> m_udpReceiveBytesTransferredCbVec;
-    std::vector<boost::posix_time::ptime> m_expiriesCbVec;
+    UdpDelaySimLinkModel m_linkModel;
+
+    //packets waiting to be sent, ordered by send time then arrival (the link model may reorder)
+    struct pending_send_t {
+        boost::posix_time::ptime sendTime;
+        uint64_t sequence;
+        unsigned int bufferIndex;
+        bool operator>(const pending_send_t & o) const {
+            return (sendTime > o.sendTime) || ((sendTime == o.sendTime) && (sequence > o.sequence));
+        }
+    };
+    std::vector<std::vector<uint8_t> > m_packetBuffersVec;
+    std::vector<std::size_t> m_packetSizesVec;
+    std::vector<unsigned int> m_freePacketBufferIndicesVec;
+    std::priority_queue<pending_send_t, std::vector<pending_send_t>, std::greater<pending_send_t> > m_pendingSendsPq;
+    uint64_t m_nextPendingSendSequence;
+    std::vector<pending_send_t> m_sendBatchVec; //due packets popped from m_pendingSendsPq, of which the first m_sendBatchNumSent have been sent
+    std::size_t m_sendBatchNumSent;
+
     std::unique_ptr<boost::thread> m_ioServiceThreadPtr;
     bool m_printedCbTooSmallNotice;
     bool m_sendDelayTimerIsRunning;
+    boost::posix_time::ptime m_sendDelayTimerExpiry;
+    bool m_sendInProgress; //waiting on an async send, socket writability, or a posted continuation
 
     //stats
     uint64_t m_lastTotalUdpPacketsReceived;
@@ -0,0 +1,114 @@
+/**
+ * @file UdpDelaySimLinkModel.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This UdpDelaySimLinkModel class decides the fate of each packet entering the UdpDelaySim proxy:
+ * whether it is dropped (link down per the link schedule, bandwidth shaping queue full,
+ * or lost per a Gilbert-Elliott two state burst loss channel), when each copy of it
+ * leaves the proxy (serialization at the link rate, then propagation delay plus jitter),
+ * and whether it is reordered or duplicated.
+ * It performs no I/O and all randomness comes from a seeded mt19937_64,
+ * so a given seed and packet arrival sequence always produces the same channel.
+ */
+
+#ifndef _UDP_DELAY_SIM_LINK_MODEL_H
+#define _UDP_DELAY_SIM_LINK_MODEL_H 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/date_time.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include "udp_delay_sim_lib_export.h"
+
+struct UdpDelaySimLinkModelConfig {
+    enum class JITTER_DISTRIBUTION { UNIFORM, NORMAL };
+
+    UDP_DELAY_SIM_LIB_EXPORT UdpDelaySimLinkModelConfig();
+
+    uint64_t rngSeed;
+
+    //Gilbert-Elliott burst loss (the state transitions once per packet, before the loss decision).
+    //Uniform (Bernoulli) loss is lossProbabilityGoodState with probabilityGoodToBad of 0.
+    double lossProbabilityGoodState;
+    double lossProbabilityBadState;
+    double probabilityGoodToBad;
+    double probabilityBadToGood;
+
+    uint64_t rateBitsPerSecond; //0 for unlimited
+    uint64_t maxQueuedBytes; //packets arriving while this many bytes await serialization are dropped (0 for unlimited)
+
+    boost::posix_time::time_duration delay;
+    boost::posix_time::time_duration jitter; //uniform: +/- jitter, normal: standard deviation
+    JITTER_DISTRIBUTION jitterDistribution;
+
+    //a reordered packet is held an extra reorderExtraDelay and may be overtaken,
+    //whereas all other packets leave in arrival order even when jitter is enabled
+    double reorderProbability;
+    boost::posix_time::time_duration reorderExtraDelay;
+    double duplicateProbability;
+};
+
+//while a link schedule is in use, the link is down outside of every entry
+struct UdpDelaySimLinkScheduleEntry {
+    boost::posix_time::time_duration startOffset; //relative to UdpDelaySimLinkModel::Reset
+    boost::posix_time::time_duration endOffset;
+    uint64_t rateBitsPerSecond; //0 to use UdpDelaySimLinkModelConfig::rateBitsPerSecond
+    boost::posix_time::time_duration delay; //negative to use UdpDelaySimLinkModelConfig::delay
+};
+
+class UdpDelaySimLinkModel {
+private:
+    UdpDelaySimLinkModel();
+public:
+    static constexpr unsigned int MAX_COPIES_PER_PACKET = 2;
+
+    UDP_DELAY_SIM_LIB_EXPORT UdpDelaySimLinkModel(const UdpDelaySimLinkModelConfig & config, const std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule);
+    UDP_DELAY_SIM_LIB_EXPORT ~UdpDelaySimLinkModel();
+    UDP_DELAY_SIM_LIB_EXPORT void Reset(const boost::posix_time::ptime & startTime);
+
+    //packets must be processed in nondecreasing arrival time order.
+    //returns the number of copies to forward (0 if dropped), each to be sent at its sendTimes entry
+    UDP_DELAY_SIM_LIB_EXPORT unsigned int ProcessPacket(const boost::posix_time::ptime & arrivalTime, const std::size_t packetSizeBytes,
+        boost::posix_time::ptime sendTimes[MAX_COPIES_PER_PACKET]);
+
+    //contacts (source, dest, startTime, endTime, rate in bits per second, optional owlt; times in seconds) from an HDTN contact plan json file
+    //become schedule entries for the link from sourceNode to destNode, sorted by start time
+    UDP_DELAY_SIM_LIB_EXPORT static bool LoadLinkScheduleFromContactPlanFile(const std::string & contactPlanFilePath,
+        const uint64_t sourceNode, const uint64_t destNode, std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule);
+
+private:
+    UDP_DELAY_SIM_LIB_NO_EXPORT double GetUniform01();
+    UDP_DELAY_SIM_LIB_NO_EXPORT bool IsLost();
+    UDP_DELAY_SIM_LIB_NO_EXPORT boost::posix_time::time_duration GetRandomDelay(const boost::posix_time::time_duration & meanDelay);
+
+    const UdpDelaySimLinkModelConfig M_CONFIG;
+    const std::vector<UdpDelaySimLinkScheduleEntry> M_LINK_SCHEDULE;
+    boost::random::mt19937_64 m_rng;
+    boost::posix_time::ptime m_startTime;
+    boost::posix_time::ptime m_linkBusyUntil; //end of serialization of the last accepted packet
+    uint64_t m_linkBusyRemainder; //sub-microsecond part of m_linkBusyUntil (in units of 1/rate microseconds)
+    boost::posix_time::ptime m_lastInOrderSendTime;
+    std::size_t m_linkScheduleIndex;
+    bool m_gilbertElliottBadState;
+
+public:
+    uint64_t m_countDroppedLinkDown;
+    uint64_t m_countDroppedQueueFull;
+    uint64_t m_countLost;
+    uint64_t m_countReordered;
+    uint64_t m_countDuplicated;
+};
+
+#endif  //_UDP_DELAY_SIM_LINK_MODEL_H
@@ -17,7 +17,23 @@
 
 #include "UdpDelaySim.h"
 #include <boost/make_unique.hpp>
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <string.h>
+//receive and send up to MMSG_BATCH_SIZE packets per system call
+#define UDP_DELAY_SIM_USE_MMSG 1
+#endif
 
+static const unsigned int MMSG_BATCH_SIZE = 64;
+static const unsigned int MAX_SEND_BATCHES_PER_HANDLER = 16; //then let pending receives run
+
+static UdpDelaySimLinkModelConfig GetConstantDelayLinkModelConfig(const boost::posix_time::time_duration & sendDelay) {
+    UdpDelaySimLinkModelConfig config;
+    config.delay = sendDelay;
+    return config;
+}
 
 UdpDelaySim::UdpDelaySim(uint16_t myBoundUdpPort,
     const std::string & remoteHostnameToForwardPacketsTo,
@@ -26,6 +42,17 @@ UdpDelaySim::UdpDelaySim(uint16_t myBoundUdpPort,
     const unsigned int maxUdpPacketSizeBytes,
     const boost::posix_time::time_duration & sendDelay,
     const bool autoStart) :
+    UdpDelaySim(myBoundUdpPort, remoteHostnameToForwardPacketsTo, remotePortToForwardPacketsTo, numCircularBufferVectors, maxUdpPacketSizeBytes,
+        GetConstantDelayLinkModelConfig(sendDelay), std::vector<UdpDelaySimLinkScheduleEntry>(), autoStart) {}
+
+UdpDelaySim::UdpDelaySim(uint16_t myBoundUdpPort,
+    const std::string & remoteHostnameToForwardPacketsTo,
+    const std::string & remotePortToForwardPacketsTo,
+    const unsigned int numCircularBufferVectors,
+    const unsigned int maxUdpPacketSizeBytes,
+    const UdpDelaySimLinkModelConfig & linkModelConfig,
+    const std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule,
+    const bool autoStart) :
     m_resolver(m_ioService),
     m_udpPacketSendDelayTimer(m_ioService),
     m_timerTransferRateStats(m_ioService),
@@ -35,14 +62,15 @@ UdpDelaySim::UdpDelaySim(uint16_t myBoundUdpPort,
     M_REMOTE_PORT_TO_FORWARD_PACKETS_TO(remotePortToForwardPacketsTo),
     M_NUM_CIRCULAR_BUFFER_VECTORS(numCircularBufferVectors),
     M_MAX_UDP_PACKET_SIZE_BYTES(maxUdpPacketSizeBytes),
-    M_SEND_DELAY(sendDelay),
     m_udpReceiveBuffer(M_MAX_UDP_PACKET_SIZE_BYTES),
-    m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_udpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
-    m_expiriesCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_linkModel(linkModelConfig, linkSchedule),
+    m_packetBuffersVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_packetSizesVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_nextPendingSendSequence(0),
+    m_sendBatchNumSent(0),
     m_printedCbTooSmallNotice(false),
     m_sendDelayTimerIsRunning(false),
+    m_sendInProgress(false),
     //stats
     m_lastTotalUdpPacketsReceived(0),
     m_lastTotalUdpBytesReceived(0),
@@ -55,9 +83,12 @@ UdpDelaySim::UdpDelaySim(uint16_t myBoundUdpPort,
     m_countTotalUdpPacketsSent(0),
     m_countTotalUdpBytesSent(0)
 {
+    m_freePacketBufferIndicesVec.reserve(M_NUM_CIRCULAR_BUFFER_VECTORS);
     for (unsigned int i = 0; i < M_NUM_CIRCULAR_BUFFER_VECTORS; ++i) {
-        m_udpReceiveBuffersCbVec[i].resize(M_MAX_UDP_PACKET_SIZE_BYTES);
+        m_packetBuffersVec[i].resize(M_MAX_UDP_PACKET_SIZE_BYTES);
+        m_freePacketBufferIndicesVec.push_back((M_NUM_CIRCULAR_BUFFER_VECTORS - 1) - i); //index 0 used first
     }
+    m_sendBatchVec.reserve(MMSG_BATCH_SIZE);
 
     if (autoStart) {
         StartIfNotAlreadyRunning(); //TODO EVALUATE IF AUTO START SAFE
@@ -82,6 +113,7 @@ bool UdpDelaySim::StartIfNotAlreadyRunning() {
         {
             //start timer
             m_lastPtime = boost::posix_time::microsec_clock::universal_time();
+            m_linkModel.Reset(m_lastPtime); //link schedule starts now
             m_timerTransferRateStats.expires_from_now(boost::posix_time::seconds(5));
             m_timerTransferRateStats.async_wait(boost::bind(&UdpDelaySim::TransferRate_TimerExpired, this, boost::asio::placeholders::error));
         }
@@ -107,6 +139,11 @@ UdpDelaySim::~UdpDelaySim() {
     std::cout << "m_countMaxCircularBufferSize " << m_countMaxCircularBufferSize << "\n";
     std::cout << "m_countTotalUdpPacketsReceived " << m_countTotalUdpPacketsReceived << "\n";
     std::cout << "m_countTotalUdpPacketsSent " << m_countTotalUdpPacketsSent << "\n";
+    std::cout << "linkModel m_countDroppedLinkDown " << m_linkModel.m_countDroppedLinkDown << "\n";
+    std::cout << "linkModel m_countDroppedQueueFull " << m_linkModel.m_countDroppedQueueFull << "\n";
+    std::cout << "linkModel m_countLost " << m_linkModel.m_countLost << "\n";
+    std::cout << "linkModel m_countReordered " << m_linkModel.m_countReordered << "\n";
+    std::cout << "linkModel m_countDuplicated " << m_linkModel.m_countDuplicated << "\n";
 }
 
 void UdpDelaySim::Stop() {
@@ -135,34 +172,35 @@ void UdpDelaySim::OnResolve(const boost::system::error_code & ec, boost::asio::i
 }
 
 void UdpDelaySim::StartUdpReceive() {
+#ifdef UDP_DELAY_SIM_USE_MMSG
+    m_udpSocket.async_wait(boost::asio::socket_base::wait_read,
+        boost::bind(&UdpDelaySim::HandleUdpReadable, this,
+            boost::asio::placeholders::error));
+#else
     m_udpSocket.async_receive_from(
         boost::asio::buffer(m_udpReceiveBuffer),
         m_remoteEndpointReceived,
         boost::bind(&UdpDelaySim::HandleUdpReceive, this,
             boost::asio::placeholders::error,
             boost::asio::placeholders::bytes_transferred));
+#endif
 }
 
 
 void UdpDelaySim::HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
     if (!error) {
-        const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
-        if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+        if (m_freePacketBufferIndicesVec.empty()) {
             ++m_countCircularBufferOverruns;
             if (!m_printedCbTooSmallNotice) {
                 m_printedCbTooSmallNotice = true;
                 std::cout << "notice in UdpDelaySim::HandleUdpReceive(): buffers full.. you might want to increase the circular buffer size! This UDP packet will be dropped!" << std::endl;
             }
         }
-        else { //not full.. swap packet in to circular buffer
-            m_udpReceiveBuffer.swap(m_udpReceiveBuffersCbVec[writeIndex]);
-            m_udpReceiveBytesTransferredCbVec[writeIndex] = bytesTransferred;
-            m_expiriesCbVec[writeIndex] = boost::posix_time::microsec_clock::universal_time() + M_SEND_DELAY;
-            m_circularIndexBuffer.CommitWrite(); //write complete at this point
-            ++m_countTotalUdpPacketsReceived;
-            m_countTotalUdpBytesReceived += bytesTransferred;
-            const uint64_t cbSize = m_circularIndexBuffer.NumInBuffer();
-            m_countMaxCircularBufferSize = std::max(m_countMaxCircularBufferSize, cbSize);
+        else { //not full.. swap packet in to a free packet buffer
+            const unsigned int bufferIndex = m_freePacketBufferIndicesVec.back();
+            m_freePacketBufferIndicesVec.pop_back();
+            m_udpReceiveBuffer.swap(m_packetBuffersVec[bufferIndex]);
+            OnPacketReceived(bufferIndex, bytesTransferred, boost::posix_time::microsec_clock::universal_time());
             TryRestartSendDelayTimer();
         }
         StartUdpReceive(); //restart operation only if there was no error
@@ -173,6 +211,96 @@ void UdpDelaySim::HandleUdpReceive(const boost::system::error_code & error, std:
     }
 }
 
+void UdpDelaySim::HandleUdpReadable(const boost::system::error_code & error) {
+#ifdef UDP_DELAY_SIM_USE_MMSG
+    if (error) {
+        if (error != boost::asio::error::operation_aborted) {
+            std::cerr << "critical error in UdpDelaySim::HandleUdpReadable(): " << error.message() << std::endl;
+            DoUdpShutdown();
+        }
+        return;
+    }
+    struct mmsghdr msgs[MMSG_BATCH_SIZE];
+    struct iovec iovecs[MMSG_BATCH_SIZE];
+    unsigned int bufferIndices[MMSG_BATCH_SIZE];
+    const std::size_t numFree = m_freePacketBufferIndicesVec.size();
+    const bool buffersFull = (numFree == 0);
+    unsigned int numToReceive;
+    if (buffersFull) { //still drain the socket, into the drop buffer
+        numToReceive = 1;
+        iovecs[0].iov_base = m_udpReceiveBuffer.data();
+        iovecs[0].iov_len = m_udpReceiveBuffer.size();
+    }
+    else {
+        numToReceive = static_cast<unsigned int>(std::min<std::size_t>(numFree, MMSG_BATCH_SIZE));
+        for (unsigned int i = 0; i < numToReceive; ++i) {
+            bufferIndices[i] = m_freePacketBufferIndicesVec[(numFree - 1) - i];
+            std::vector<uint8_t> & packetBuffer = m_packetBuffersVec[bufferIndices[i]];
+            iovecs[i].iov_base = packetBuffer.data();
+            iovecs[i].iov_len = packetBuffer.size();
+        }
+    }
+    memset(msgs, 0, numToReceive * sizeof(struct mmsghdr));
+    for (unsigned int i = 0; i < numToReceive; ++i) {
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    const int numReceived = recvmmsg(m_udpSocket.native_handle(), msgs, numToReceive, MSG_DONTWAIT, NULL);
+    if (numReceived < 0) {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            std::cerr << "critical error in UdpDelaySim::HandleUdpReadable(): recvmmsg: " << strerror(errno) << std::endl;
+            DoUdpShutdown();
+            return;
+        }
+    }
+    else if (buffersFull) {
+        m_countCircularBufferOverruns += numReceived;
+        if (!m_printedCbTooSmallNotice) {
+            m_printedCbTooSmallNotice = true;
+            std::cout << "notice in UdpDelaySim::HandleUdpReadable(): buffers full.. you might want to increase the circular buffer size! This UDP packet will be dropped!" << std::endl;
+        }
+    }
+    else {
+        const boost::posix_time::ptime nowTime = boost::posix_time::microsec_clock::universal_time(); //one arrival time per batch
+        //take every filled buffer off the free list before OnPacketReceived, which pushes (drops) and pops (duplicates) free indices
+        m_freePacketBufferIndicesVec.resize(numFree - static_cast<std::size_t>(numReceived));
+        for (int i = 0; i < numReceived; ++i) {
+            OnPacketReceived(bufferIndices[i], msgs[i].msg_len, nowTime);
+        }
+        TryRestartSendDelayTimer();
+    }
+    StartUdpReceive();
+#else
+    (void)error;
+#endif
+}
+
+void UdpDelaySim::OnPacketReceived(const unsigned int bufferIndex, const std::size_t bytesTransferred, const boost::posix_time::ptime & nowTime) {
+    ++m_countTotalUdpPacketsReceived;
+    m_countTotalUdpBytesReceived += bytesTransferred;
+    boost::posix_time::ptime sendTimes[UdpDelaySimLinkModel::MAX_COPIES_PER_PACKET];
+    const unsigned int numCopies = m_linkModel.ProcessPacket(nowTime, bytesTransferred, sendTimes);
+    if (numCopies == 0) { //dropped by the link model
+        m_freePacketBufferIndicesVec.push_back(bufferIndex);
+        return;
+    }
+    m_packetSizesVec[bufferIndex] = bytesTransferred;
+    m_pendingSendsPq.push(pending_send_t{ sendTimes[0], m_nextPendingSendSequence++, bufferIndex });
+    for (unsigned int i = 1; i < numCopies; ++i) { //duplicates
+        if (m_freePacketBufferIndicesVec.empty()) {
+            ++m_countCircularBufferOverruns;
+            break;
+        }
+        const unsigned int duplicateBufferIndex = m_freePacketBufferIndicesVec.back();
+        m_freePacketBufferIndicesVec.pop_back();
+        memcpy(m_packetBuffersVec[duplicateBufferIndex].data(), m_packetBuffersVec[bufferIndex].data(), bytesTransferred);
+        m_packetSizesVec[duplicateBufferIndex] = bytesTransferred;
+        m_pendingSendsPq.push(pending_send_t{ sendTimes[i], m_nextPendingSendSequence++, duplicateBufferIndex });
+    }
+    const uint64_t numBuffered = M_NUM_CIRCULAR_BUFFER_VECTORS - m_freePacketBufferIndicesVec.size();
+    m_countMaxCircularBufferSize = std::max(m_countMaxCircularBufferSize, numBuffered);
+}
+
 void UdpDelaySim::DoUdpShutdown() {
     //final code to shut down udp sockets
     m_udpPacketSendDelayTimer.cancel();
@@ -190,49 +318,136 @@ void UdpDelaySim::DoUdpShutdown() {
 }
 
 
-//restarts the send delay timer if it is not running and there are packets available
+//restarts the send delay timer if it is not running (or expires after the earliest packet) and there are packets available
 void UdpDelaySim::TryRestartSendDelayTimer() {
-    if (!m_sendDelayTimerIsRunning) {
-        const unsigned int consumeIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
-        if (consumeIndex != CIRCULAR_INDEX_BUFFER_EMPTY) { //if not empty
-            m_udpPacketSendDelayTimer.expires_at(m_expiriesCbVec[consumeIndex]);
-            m_udpPacketSendDelayTimer.async_wait(boost::bind(&UdpDelaySim::OnSendDelay_TimerExpired, this, boost::asio::placeholders::error, consumeIndex));
-            m_sendDelayTimerIsRunning = true;
-        }
+    if (m_sendInProgress || m_pendingSendsPq.empty()) {
+        return; //SendDuePackets will call this when done
+    }
+    const boost::posix_time::ptime & earliestSendTime = m_pendingSendsPq.top().sendTime;
+    if ((!m_sendDelayTimerIsRunning) || (earliestSendTime < m_sendDelayTimerExpiry)) {
+        m_sendDelayTimerExpiry = earliestSendTime;
+        m_udpPacketSendDelayTimer.expires_at(earliestSendTime); //cancels any earlier wait (its handler sees operation_aborted)
+        m_udpPacketSendDelayTimer.async_wait(boost::bind(&UdpDelaySim::OnSendDelay_TimerExpired, this, boost::asio::placeholders::error));
+        m_sendDelayTimerIsRunning = true;
     }
 }
 
-void UdpDelaySim::OnSendDelay_TimerExpired(const boost::system::error_code& e, const unsigned int consumeIndex) {
-    //m_sendDelayTimerIsRunning = false; (HandleUdpSend shall set this false)
+void UdpDelaySim::OnSendDelay_TimerExpired(const boost::system::error_code& e) {
     if (e != boost::asio::error::operation_aborted) {
         // Timer was not cancelled, take necessary action.
-        
-        const std::vector<uint8_t> & vecDataToSend = m_udpReceiveBuffersCbVec[consumeIndex];
-        const uint64_t bytesTransferred = m_udpReceiveBytesTransferredCbVec[consumeIndex];
-        m_udpSocket.async_send_to(boost::asio::buffer(vecDataToSend.data(), bytesTransferred), m_udpDestinationEndpoint,
-            boost::bind(&UdpDelaySim::HandleUdpSend, this,
-                boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred));
+        if (boost::posix_time::microsec_clock::universal_time() < m_sendDelayTimerExpiry) {
+            return; //stale completion already queued when expires_at rearmed the timer (the rearmed wait is still pending)
+        }
+        m_sendDelayTimerIsRunning = false;
+        if (m_sendInProgress) {
+            return; //SendDuePackets is already sending and will restart the timer when done
+        }
+        SendDuePackets();
     }
     else {
         //std::cout << "timer cancelled\n";
     }
 }
 
+//sends every packet whose send time has passed, in batches, then rearms the send delay timer
+void UdpDelaySim::SendDuePackets() {
+    m_sendInProgress = false;
+    for (unsigned int batchCount = 0; ; ++batchCount) {
+        if (m_sendBatchNumSent == m_sendBatchVec.size()) {
+            m_sendBatchVec.clear();
+            m_sendBatchNumSent = 0;
+            if (batchCount == MAX_SEND_BATCHES_PER_HANDLER) {
+                m_sendInProgress = true;
+                boost::asio::post(m_ioService, boost::bind(&UdpDelaySim::SendDuePackets, this));
+                return;
+            }
+            const boost::posix_time::ptime nowTime = boost::posix_time::microsec_clock::universal_time();
+            while ((!m_pendingSendsPq.empty()) && (m_pendingSendsPq.top().sendTime <= nowTime) && (m_sendBatchVec.size() < MMSG_BATCH_SIZE)) {
+                m_sendBatchVec.push_back(m_pendingSendsPq.top());
+                m_pendingSendsPq.pop();
+            }
+            if (m_sendBatchVec.empty()) {
+                TryRestartSendDelayTimer();
+                return;
+            }
+        }
+#ifdef UDP_DELAY_SIM_USE_MMSG
+        struct mmsghdr msgs[MMSG_BATCH_SIZE];
+        struct iovec iovecs[MMSG_BATCH_SIZE];
+        const unsigned int numToSend = static_cast<unsigned int>(m_sendBatchVec.size() - m_sendBatchNumSent);
+        memset(msgs, 0, numToSend * sizeof(struct mmsghdr));
+        for (unsigned int i = 0; i < numToSend; ++i) {
+            const unsigned int bufferIndex = m_sendBatchVec[m_sendBatchNumSent + i].bufferIndex;
+            iovecs[i].iov_base = m_packetBuffersVec[bufferIndex].data();
+            iovecs[i].iov_len = m_packetSizesVec[bufferIndex];
+            msgs[i].msg_hdr.msg_name = m_udpDestinationEndpoint.data();
+            msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_udpDestinationEndpoint.size());
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int numSent = sendmmsg(m_udpSocket.native_handle(), msgs, numToSend, MSG_DONTWAIT);
+        if (numSent < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                m_sendInProgress = true;
+                m_udpSocket.async_wait(boost::asio::socket_base::wait_write,
+                    boost::bind(&UdpDelaySim::HandleUdpWritable, this,
+                        boost::asio::placeholders::error));
+                return;
+            }
+            else if (errno != EINTR) {
+                std::cerr << "error in UdpDelaySim::SendDuePackets: sendmmsg: " << strerror(errno) << std::endl;
+                DoUdpShutdown();
+                return;
+            }
+        }
+        else {
+            for (int i = 0; i < numSent; ++i) {
+                OnPacketSent(m_sendBatchVec[m_sendBatchNumSent + i].bufferIndex, msgs[i].msg_len);
+            }
+            m_sendBatchNumSent += numSent;
+        }
+#else
+        const unsigned int bufferIndex = m_sendBatchVec[m_sendBatchNumSent].bufferIndex;
+        m_sendInProgress = true;
+        m_udpSocket.async_send_to(boost::asio::buffer(m_packetBuffersVec[bufferIndex].data(), m_packetSizesVec[bufferIndex]), m_udpDestinationEndpoint,
+            boost::bind(&UdpDelaySim::HandleUdpSend, this,
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+        return;
+#endif
+    }
+}
+
 void UdpDelaySim::HandleUdpSend(const boost::system::error_code& error, std::size_t bytes_transferred) {
     if (error) {
         std::cerr << "error in UdpDelaySim::HandleUdpSend: " << error.message() << std::endl;
         DoUdpShutdown();
     }
     else {
-        ++m_countTotalUdpPacketsSent;
-        m_countTotalUdpBytesSent += bytes_transferred;
-        m_sendDelayTimerIsRunning = false;
-        m_circularIndexBuffer.CommitRead();
-        TryRestartSendDelayTimer();
+        OnPacketSent(m_sendBatchVec[m_sendBatchNumSent].bufferIndex, bytes_transferred);
+        ++m_sendBatchNumSent;
+        SendDuePackets();
     }
 }
 
+void UdpDelaySim::HandleUdpWritable(const boost::system::error_code & error) {
+    if (error) {
+        if (error != boost::asio::error::operation_aborted) {
+            std::cerr << "error in UdpDelaySim::HandleUdpWritable: " << error.message() << std::endl;
+            DoUdpShutdown();
+        }
+    }
+    else {
+        SendDuePackets();
+    }
+}
+
+void UdpDelaySim::OnPacketSent(const unsigned int bufferIndex, const std::size_t bytesTransferred) {
+    ++m_countTotalUdpPacketsSent;
+    m_countTotalUdpBytesSent += bytesTransferred;
+    m_freePacketBufferIndicesVec.push_back(bufferIndex);
+}
+
 void UdpDelaySim::TransferRate_TimerExpired(const boost::system::error_code& e) {
     if (e != boost::asio::error::operation_aborted) {
         // Timer was not cancelled, take necessary action.
@@ -248,7 +463,7 @@ void UdpDelaySim::TransferRate_TimerExpired(const boost::system::error_code& e)
             double rateBytesRxMbps = (diffTotalUdpBytesReceived * 8.0) / diffTotalMicroseconds;
             double ratePacketsTxPerSecond = (diffTotalUdpPacketsSent * 1e6) / diffTotalMicroseconds;
             double rateBytesTxMbps = (diffTotalUdpBytesSent * 8.0) / diffTotalMicroseconds;
-            const unsigned int cbSize = m_circularIndexBuffer.NumInBuffer();
+            const unsigned int cbSize = static_cast<unsigned int>(M_NUM_CIRCULAR_BUFFER_VECTORS - m_freePacketBufferIndicesVec.size());
 
             printf("RX: %0.4f Mbits/sec, %0.1f Packets/sec   TX: %0.4f Mbits/sec, %0.1f Packets/sec  Buffered: %d\n",
                 rateBytesRxMbps, ratePacketsRxPerSecond, rateBytesTxMbps, ratePacketsTxPerSecond, cbSize);
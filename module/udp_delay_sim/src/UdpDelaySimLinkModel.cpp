@@ -0,0 +1,197 @@
+/**
+ * @file UdpDelaySimLinkModel.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "UdpDelaySimLinkModel.h"
+#include "JsonSerializable.h"
+#include <iostream>
+#include <algorithm>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+UdpDelaySimLinkModelConfig::UdpDelaySimLinkModelConfig() :
+    rngSeed(1),
+    lossProbabilityGoodState(0),
+    lossProbabilityBadState(0),
+    probabilityGoodToBad(0),
+    probabilityBadToGood(1),
+    rateBitsPerSecond(0),
+    maxQueuedBytes(0),
+    delay(boost::posix_time::milliseconds(0)),
+    jitter(boost::posix_time::milliseconds(0)),
+    jitterDistribution(JITTER_DISTRIBUTION::UNIFORM),
+    reorderProbability(0),
+    reorderExtraDelay(boost::posix_time::milliseconds(0)),
+    duplicateProbability(0) {}
+
+UdpDelaySimLinkModel::UdpDelaySimLinkModel(const UdpDelaySimLinkModelConfig & config, const std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule) :
+    M_CONFIG(config),
+    M_LINK_SCHEDULE(linkSchedule)
+{
+    Reset(boost::posix_time::microsec_clock::universal_time());
+}
+
+UdpDelaySimLinkModel::~UdpDelaySimLinkModel() {}
+
+void UdpDelaySimLinkModel::Reset(const boost::posix_time::ptime & startTime) {
+    m_rng.seed(M_CONFIG.rngSeed);
+    m_startTime = startTime;
+    m_linkBusyUntil = startTime;
+    m_linkBusyRemainder = 0;
+    m_lastInOrderSendTime = startTime;
+    m_linkScheduleIndex = 0;
+    m_gilbertElliottBadState = false;
+    m_countDroppedLinkDown = 0;
+    m_countDroppedQueueFull = 0;
+    m_countLost = 0;
+    m_countReordered = 0;
+    m_countDuplicated = 0;
+}
+
+double UdpDelaySimLinkModel::GetUniform01() {
+    return boost::random::uniform_01<double>()(m_rng);
+}
+
+bool UdpDelaySimLinkModel::IsLost() {
+    if (m_gilbertElliottBadState) {
+        if (GetUniform01() < M_CONFIG.probabilityBadToGood) {
+            m_gilbertElliottBadState = false;
+        }
+    }
+    else if (GetUniform01() < M_CONFIG.probabilityGoodToBad) {
+        m_gilbertElliottBadState = true;
+    }
+    const double lossProbability = (m_gilbertElliottBadState) ? M_CONFIG.lossProbabilityBadState : M_CONFIG.lossProbabilityGoodState;
+    return (lossProbability > 0) && (GetUniform01() < lossProbability);
+}
+
+boost::posix_time::time_duration UdpDelaySimLinkModel::GetRandomDelay(const boost::posix_time::time_duration & meanDelay) {
+    const int64_t jitterMicroseconds = M_CONFIG.jitter.total_microseconds();
+    if (jitterMicroseconds <= 0) {
+        return meanDelay;
+    }
+    double offsetMicroseconds;
+    if (M_CONFIG.jitterDistribution == UdpDelaySimLinkModelConfig::JITTER_DISTRIBUTION::NORMAL) {
+        offsetMicroseconds = boost::random::normal_distribution<double>(0, static_cast<double>(jitterMicroseconds))(m_rng);
+    }
+    else {
+        offsetMicroseconds = ((2.0 * GetUniform01()) - 1.0) * jitterMicroseconds;
+    }
+    const int64_t delayMicroseconds = meanDelay.total_microseconds() + static_cast<int64_t>(offsetMicroseconds);
+    return boost::posix_time::microseconds(std::max<int64_t>(delayMicroseconds, 0));
+}
+
+unsigned int UdpDelaySimLinkModel::ProcessPacket(const boost::posix_time::ptime & arrivalTime, const std::size_t packetSizeBytes,
+    boost::posix_time::ptime sendTimes[MAX_COPIES_PER_PACKET])
+{
+    uint64_t rateBitsPerSecond = M_CONFIG.rateBitsPerSecond;
+    boost::posix_time::time_duration meanDelay = M_CONFIG.delay;
+    if (!M_LINK_SCHEDULE.empty()) {
+        const boost::posix_time::time_duration offset = arrivalTime - m_startTime;
+        while ((m_linkScheduleIndex < M_LINK_SCHEDULE.size()) && (offset >= M_LINK_SCHEDULE[m_linkScheduleIndex].endOffset)) {
+            ++m_linkScheduleIndex;
+        }
+        if ((m_linkScheduleIndex == M_LINK_SCHEDULE.size()) || (offset < M_LINK_SCHEDULE[m_linkScheduleIndex].startOffset)) {
+            ++m_countDroppedLinkDown;
+            return 0;
+        }
+        const UdpDelaySimLinkScheduleEntry & entry = M_LINK_SCHEDULE[m_linkScheduleIndex];
+        if (entry.rateBitsPerSecond) {
+            rateBitsPerSecond = entry.rateBitsPerSecond;
+        }
+        if (!entry.delay.is_negative()) {
+            meanDelay = entry.delay;
+        }
+    }
+
+    //bandwidth shaping: the packet leaves the transmitter once every packet before it has been serialized
+    boost::posix_time::ptime transmitFinishedTime = arrivalTime;
+    if (rateBitsPerSecond) {
+        if (m_linkBusyUntil < arrivalTime) { //idle link
+            m_linkBusyUntil = arrivalTime;
+            m_linkBusyRemainder = 0;
+        }
+        else if (M_CONFIG.maxQueuedBytes) {
+            const uint64_t queuedBytes = (static_cast<uint64_t>((m_linkBusyUntil - arrivalTime).total_microseconds()) * rateBitsPerSecond) / 8000000;
+            if (queuedBytes >= M_CONFIG.maxQueuedBytes) {
+                ++m_countDroppedQueueFull;
+                return 0;
+            }
+        }
+        //carry the sub-microsecond remainder so that serialization times at multi-Gbps rates don't truncate to zero
+        const uint64_t numerator = (static_cast<uint64_t>(packetSizeBytes) * 8000000) + m_linkBusyRemainder;
+        m_linkBusyUntil += boost::posix_time::microseconds(static_cast<int64_t>(numerator / rateBitsPerSecond));
+        m_linkBusyRemainder = numerator % rateBitsPerSecond;
+        transmitFinishedTime = m_linkBusyUntil;
+    }
+
+    if (IsLost()) { //lost in the channel (after consuming its share of the bandwidth)
+        ++m_countLost;
+        return 0;
+    }
+
+    boost::posix_time::ptime sendTime = transmitFinishedTime + GetRandomDelay(meanDelay);
+    if ((M_CONFIG.reorderProbability > 0) && (GetUniform01() < M_CONFIG.reorderProbability)) {
+        ++m_countReordered;
+        sendTime += M_CONFIG.reorderExtraDelay;
+    }
+    else {
+        //jitter alone never reorders
+        if (sendTime < m_lastInOrderSendTime) {
+            sendTime = m_lastInOrderSendTime;
+        }
+        m_lastInOrderSendTime = sendTime;
+    }
+    sendTimes[0] = sendTime;
+    if ((M_CONFIG.duplicateProbability > 0) && (GetUniform01() < M_CONFIG.duplicateProbability)) {
+        ++m_countDuplicated;
+        sendTimes[1] = sendTime;
+        return 2;
+    }
+    return 1;
+}
+
+bool UdpDelaySimLinkModel::LoadLinkScheduleFromContactPlanFile(const std::string & contactPlanFilePath,
+    const uint64_t sourceNode, const uint64_t destNode, std::vector<UdpDelaySimLinkScheduleEntry> & linkSchedule)
+{
+    linkSchedule.clear();
+    try {
+        const boost::property_tree::ptree pt = JsonSerializable::GetPropertyTreeFromJsonFile(contactPlanFilePath);
+        const boost::property_tree::ptree & contactsPt = pt.get_child("contacts", boost::property_tree::ptree());
+        for (boost::property_tree::ptree::const_iterator it = contactsPt.begin(); it != contactsPt.end(); ++it) {
+            const boost::property_tree::ptree & contactPt = it->second;
+            if ((contactPt.get<uint64_t>("source") != sourceNode) || (contactPt.get<uint64_t>("dest") != destNode)) {
+                continue;
+            }
+            UdpDelaySimLinkScheduleEntry entry;
+            entry.startOffset = boost::posix_time::seconds(contactPt.get<long>("startTime"));
+            entry.endOffset = boost::posix_time::seconds(contactPt.get<long>("endTime"));
+            entry.rateBitsPerSecond = contactPt.get<uint64_t>("rate", 0);
+            entry.delay = boost::posix_time::seconds(contactPt.get<long>("owlt", -1));
+            if (entry.endOffset <= entry.startOffset) {
+                std::cerr << "error in UdpDelaySimLinkModel::LoadLinkScheduleFromContactPlanFile: contact endTime must be greater than startTime" << std::endl;
+                return false;
+            }
+            linkSchedule.push_back(entry);
+        }
+    }
+    catch (const std::exception & e) {
+        std::cerr << "error loading contact plan " << contactPlanFilePath << ": " << e.what() << std::endl;
+        return false;
+    }
+    std::sort(linkSchedule.begin(), linkSchedule.end(), [](const UdpDelaySimLinkScheduleEntry & a, const UdpDelaySimLinkScheduleEntry & b) {
+        return a.startOffset < b.startOffset;
+    });
+    std::cout << "loaded " << linkSchedule.size() << " contacts from node " << sourceNode << " to node " << destNode << std::endl;
+    return true;
+}
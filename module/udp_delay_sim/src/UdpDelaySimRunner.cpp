@@ -47,6 +47,8 @@ bool UdpDelaySimRunner::Run(int argc, const char* const argv[], volatile bool &
         uint64_t sendDelayMs;
         unsigned int numUdpRxPacketsCircularBufferSize;
         unsigned int maxRxUdpPacketSizeBytes;
+        UdpDelaySimLinkModelConfig linkModelConfig;
+        std::vector<UdpDelaySimLinkScheduleEntry> linkSchedule;
 
         boost::program_options::options_description desc("Allowed options");
         try {
@@ -58,6 +60,21 @@ bool UdpDelaySimRunner::Run(int argc, const char* const argv[], volatile bool &
                 ("num-rx-udp-packets-buffer-size", boost::program_options::value<unsigned int>()->default_value(100), "UDP max packets to receive (circular buffer size).")
                 ("max-rx-udp-packet-size-bytes", boost::program_options::value<unsigned int>()->default_value(1500), "Maximum size (bytes) of a UDP packet to receive (1500 byte for small ethernet frames).")
                 ("send-delay-ms", boost::program_options::value<uint64_t>()->default_value(1), "Delay in milliseconds before forwarding received udp packets.")
+                ("jitter-us", boost::program_options::value<uint64_t>()->default_value(0), "Jitter in microseconds added to the send delay (see jitter-distribution).")
+                ("jitter-distribution", boost::program_options::value<std::string>()->default_value("uniform"), "uniform (send delay +/- jitter) or normal (jitter is the standard deviation).")
+                ("rate-bits-per-second", boost::program_options::value<uint64_t>()->default_value(0), "Link rate for bandwidth shaping (0 for unlimited).")
+                ("max-queued-bytes", boost::program_options::value<uint64_t>()->default_value(0), "Drop packets arriving while this many bytes await serialization at the link rate (0 for unlimited).")
+                ("loss-probability-good-state", boost::program_options::value<double>()->default_value(0), "Gilbert-Elliott probability of losing a packet in the good state (uniform loss if probability-good-to-bad is 0).")
+                ("loss-probability-bad-state", boost::program_options::value<double>()->default_value(0), "Gilbert-Elliott probability of losing a packet in the bad state.")
+                ("probability-good-to-bad", boost::program_options::value<double>()->default_value(0), "Gilbert-Elliott per packet probability of moving from the good to the bad state.")
+                ("probability-bad-to-good", boost::program_options::value<double>()->default_value(1), "Gilbert-Elliott per packet probability of moving from the bad to the good state.")
+                ("reorder-probability", boost::program_options::value<double>()->default_value(0), "Probability of holding a packet an extra reorder-extra-delay-ms so that later packets overtake it.")
+                ("reorder-extra-delay-ms", boost::program_options::value<uint64_t>()->default_value(10), "Extra delay in milliseconds of a reordered packet.")
+                ("duplicate-probability", boost::program_options::value<double>()->default_value(0), "Probability of forwarding a packet twice.")
+                ("rng-seed", boost::program_options::value<uint64_t>()->default_value(1), "Seed of the random number generator (same seed and traffic give the same channel).")
+                ("contact-plan-file", boost::program_options::value<std::string>()->default_value(""), "Optional contact plan json file whose contacts from contact-plan-source-node to contact-plan-dest-node are the only times the link is up (rate in bits per second, optional owlt in seconds overrides send-delay-ms).")
+                ("contact-plan-source-node", boost::program_options::value<uint64_t>()->default_value(0), "Contact plan source node of this link.")
+                ("contact-plan-dest-node", boost::program_options::value<uint64_t>()->default_value(0), "Contact plan dest node of this link.")
                 ;
 
             boost::program_options::variables_map vm;
@@ -76,6 +93,39 @@ bool UdpDelaySimRunner::Run(int argc, const char* const argv[], volatile bool &
             sendDelayMs = vm["send-delay-ms"].as<uint64_t>();
             numUdpRxPacketsCircularBufferSize = vm["num-rx-udp-packets-buffer-size"].as<unsigned int>();
             maxRxUdpPacketSizeBytes = vm["max-rx-udp-packet-size-bytes"].as<unsigned int>();
+
+            linkModelConfig.delay = boost::posix_time::milliseconds(sendDelayMs);
+            linkModelConfig.jitter = boost::posix_time::microseconds(vm["jitter-us"].as<uint64_t>());
+            const std::string jitterDistribution = vm["jitter-distribution"].as<std::string>();
+            if (jitterDistribution == "uniform") {
+                linkModelConfig.jitterDistribution = UdpDelaySimLinkModelConfig::JITTER_DISTRIBUTION::UNIFORM;
+            }
+            else if (jitterDistribution == "normal") {
+                linkModelConfig.jitterDistribution = UdpDelaySimLinkModelConfig::JITTER_DISTRIBUTION::NORMAL;
+            }
+            else {
+                std::cerr << "error: jitter-distribution must be uniform or normal\n";
+                return false;
+            }
+            linkModelConfig.rateBitsPerSecond = vm["rate-bits-per-second"].as<uint64_t>();
+            linkModelConfig.maxQueuedBytes = vm["max-queued-bytes"].as<uint64_t>();
+            linkModelConfig.lossProbabilityGoodState = vm["loss-probability-good-state"].as<double>();
+            linkModelConfig.lossProbabilityBadState = vm["loss-probability-bad-state"].as<double>();
+            linkModelConfig.probabilityGoodToBad = vm["probability-good-to-bad"].as<double>();
+            linkModelConfig.probabilityBadToGood = vm["probability-bad-to-good"].as<double>();
+            linkModelConfig.reorderProbability = vm["reorder-probability"].as<double>();
+            linkModelConfig.reorderExtraDelay = boost::posix_time::milliseconds(vm["reorder-extra-delay-ms"].as<uint64_t>());
+            linkModelConfig.duplicateProbability = vm["duplicate-probability"].as<double>();
+            linkModelConfig.rngSeed = vm["rng-seed"].as<uint64_t>();
+
+            const std::string contactPlanFile = vm["contact-plan-file"].as<std::string>();
+            if (contactPlanFile.length()) {
+                if (!UdpDelaySimLinkModel::LoadLinkScheduleFromContactPlanFile(contactPlanFile,
+                    vm["contact-plan-source-node"].as<uint64_t>(), vm["contact-plan-dest-node"].as<uint64_t>(), linkSchedule))
+                {
+                    return false;
+                }
+            }
         }
         catch (boost::bad_any_cast & e) {
             std::cout << "invalid data error: " << e.what() << "\n\n";
@@ -92,7 +142,7 @@ bool UdpDelaySimRunner::Run(int argc, const char* const argv[], volatile bool &
         }
 
         std::cout << "starting UdpDelaySim (Proxy).." << std::endl;
-        UdpDelaySim udpDelaySim(myBoundUdpPort, remoteUdpHostname, remoteUdpPortAsString, numUdpRxPacketsCircularBufferSize, maxRxUdpPacketSizeBytes, boost::posix_time::milliseconds(sendDelayMs), true);
+        UdpDelaySim udpDelaySim(myBoundUdpPort, remoteUdpHostname, remoteUdpPortAsString, numUdpRxPacketsCircularBufferSize, maxRxUdpPacketSizeBytes, linkModelConfig, linkSchedule, true);
         
         if (useSignalHandler) {
             sigHandler.Start(false);
@@ -0,0 +1,138 @@
+/**
+ * @file TestUdpDelaySim.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "UdpDelaySim.h"
+#include <boost/bind/bind.hpp>
+#include <boost/make_unique.hpp>
+#include <set>
+
+//sends numbered packets of varying length through a UdpDelaySim with loss and duplication enabled,
+//in bursts so that the proxy receives several packets per batch, and checks every forwarded packet is intact
+BOOST_AUTO_TEST_CASE(UdpDelaySimLossDuplicateLoopbackTestCase)
+{
+    static const uint16_t PROXY_UDP_PORT = 4591;
+    static const uint16_t RECEIVER_UDP_PORT = 4592;
+    static const unsigned int NUM_PACKETS = 2000;
+    static const unsigned int BURST_SIZE = 20;
+
+    struct Receiver {
+        boost::asio::io_service m_ioService;
+        boost::asio::ip::udp::socket m_udpSocket;
+        boost::asio::ip::udp::endpoint m_remoteEndpoint;
+        std::vector<uint8_t> m_receiveBuffer;
+        boost::mutex m_mutex;
+        std::vector<std::vector<uint8_t> > m_receivedPackets;
+        std::unique_ptr<boost::thread> m_ioServiceThreadPtr;
+
+        Receiver() :
+            m_udpSocket(m_ioService, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), RECEIVER_UDP_PORT)),
+            m_receiveBuffer(2000)
+        {
+            m_udpSocket.set_option(boost::asio::socket_base::receive_buffer_size(4000000));
+            StartReceive();
+            m_ioServiceThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioService));
+        }
+        ~Receiver() {
+            boost::asio::post(m_ioService, boost::bind(&boost::asio::ip::udp::socket::close, &m_udpSocket));
+            m_ioServiceThreadPtr->join();
+        }
+        void StartReceive() {
+            m_udpSocket.async_receive_from(boost::asio::buffer(m_receiveBuffer), m_remoteEndpoint,
+                boost::bind(&Receiver::HandleReceive, this, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+        }
+        void HandleReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
+            if (!error) {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_receivedPackets.emplace_back(m_receiveBuffer.begin(), m_receiveBuffer.begin() + bytesTransferred);
+                StartReceive();
+            }
+        }
+        std::size_t NumReceived() {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_receivedPackets.size();
+        }
+    };
+
+    //packet n is (n % 1000) + 8 bytes long: a 4 byte sequence number, a 4 byte length, then a pattern seeded by the sequence number
+    struct Packet {
+        static std::vector<uint8_t> Make(const uint32_t sequence) {
+            const uint32_t length = (sequence % 1000) + 8;
+            std::vector<uint8_t> packet(length);
+            memcpy(&packet[0], &sequence, sizeof(sequence));
+            memcpy(&packet[4], &length, sizeof(length));
+            for (uint32_t i = 8; i < length; ++i) {
+                packet[i] = static_cast<uint8_t>(sequence + (i * 13));
+            }
+            return packet;
+        }
+        static bool IsIntact(const std::vector<uint8_t> & packet, uint32_t & sequence) {
+            if (packet.size() < 8) {
+                return false;
+            }
+            memcpy(&sequence, &packet[0], sizeof(sequence));
+            return (sequence < NUM_PACKETS) && (packet == Make(sequence));
+        }
+    };
+
+    UdpDelaySimLinkModelConfig config;
+    config.delay = boost::posix_time::milliseconds(1);
+    config.lossProbabilityGoodState = 0.2;
+    config.duplicateProbability = 0.2;
+
+    Receiver receiver;
+    UdpDelaySim udpDelaySim(PROXY_UDP_PORT, "localhost", boost::lexical_cast<std::string>(RECEIVER_UDP_PORT), 1000, 2000,
+        config, std::vector<UdpDelaySimLinkScheduleEntry>(), true);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200)); //wait for resolve
+
+    boost::asio::io_service ioService;
+    boost::asio::ip::udp::socket senderSocket(ioService);
+    senderSocket.open(boost::asio::ip::udp::v4());
+    const boost::asio::ip::udp::endpoint proxyEndpoint(boost::asio::ip::address_v4::loopback(), PROXY_UDP_PORT);
+    for (uint32_t sequence = 0; sequence < NUM_PACKETS; ++sequence) {
+        senderSocket.send_to(boost::asio::buffer(Packet::Make(sequence)), proxyEndpoint);
+        if ((sequence % BURST_SIZE) == (BURST_SIZE - 1)) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+
+    //wait until the receiver has been quiet for a while
+    std::size_t lastNumReceived = 0;
+    for (unsigned int quietCount = 0; quietCount < 5; ) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        const std::size_t numReceived = receiver.NumReceived();
+        quietCount = (numReceived == lastNumReceived) ? quietCount + 1 : 0;
+        lastNumReceived = numReceived;
+    }
+    udpDelaySim.Stop();
+
+    std::set<uint32_t> sequencesReceived;
+    unsigned int numDuplicates = 0;
+    {
+        boost::mutex::scoped_lock lock(receiver.m_mutex);
+        for (std::size_t i = 0; i < receiver.m_receivedPackets.size(); ++i) {
+            uint32_t sequence;
+            BOOST_REQUIRE(Packet::IsIntact(receiver.m_receivedPackets[i], sequence));
+            if (!sequencesReceived.insert(sequence).second) {
+                ++numDuplicates;
+            }
+        }
+        BOOST_REQUIRE_EQUAL(receiver.m_receivedPackets.size(), udpDelaySim.m_countTotalUdpPacketsSent);
+    }
+    BOOST_REQUIRE_EQUAL(udpDelaySim.m_countTotalUdpPacketsReceived, NUM_PACKETS);
+    BOOST_REQUIRE_EQUAL(udpDelaySim.m_countCircularBufferOverruns, 0);
+    BOOST_REQUIRE_GT(numDuplicates, 0);
+    BOOST_REQUIRE_LT(sequencesReceived.size(), NUM_PACKETS); //some were lost
+    BOOST_REQUIRE_GT(sequencesReceived.size(), NUM_PACKETS / 2);
+}
@@ -0,0 +1,185 @@
+/**
+ * @file TestUdpDelaySimLinkModel.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "UdpDelaySimLinkModel.h"
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+static const boost::posix_time::ptime START_TIME(boost::gregorian::date(2022, 1, 1));
+
+//feeds one packet per packetSpacing and returns (arrival packet number, send time) of every forwarded copy in send order
+static std::vector<std::pair<unsigned int, boost::posix_time::ptime> > RunPackets(UdpDelaySimLinkModel & model, const unsigned int numPackets,
+    const std::size_t packetSizeBytes, const boost::posix_time::time_duration & packetSpacing)
+{
+    std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent;
+    boost::posix_time::ptime sendTimes[UdpDelaySimLinkModel::MAX_COPIES_PER_PACKET];
+    model.Reset(START_TIME);
+    for (unsigned int i = 0; i < numPackets; ++i) {
+        const unsigned int numCopies = model.ProcessPacket(START_TIME + (packetSpacing * static_cast<int>(i)), packetSizeBytes, sendTimes);
+        for (unsigned int c = 0; c < numCopies; ++c) {
+            sent.emplace_back(i, sendTimes[c]);
+        }
+    }
+    std::stable_sort(sent.begin(), sent.end(), [](const std::pair<unsigned int, boost::posix_time::ptime> & a, const std::pair<unsigned int, boost::posix_time::ptime> & b) {
+        return a.second < b.second;
+    });
+    return sent;
+}
+
+BOOST_AUTO_TEST_CASE(UdpDelaySimLinkModelConstantDelayTestCase)
+{
+    UdpDelaySimLinkModelConfig config;
+    config.delay = boost::posix_time::milliseconds(5);
+    UdpDelaySimLinkModel model(config, std::vector<UdpDelaySimLinkScheduleEntry>());
+    const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent = RunPackets(model, 100, 1000, boost::posix_time::microseconds(10));
+    BOOST_REQUIRE_EQUAL(sent.size(), 100);
+    for (unsigned int i = 0; i < sent.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(sent[i].first, i);
+        BOOST_REQUIRE(sent[i].second == START_TIME + boost::posix_time::microseconds(10 * i) + boost::posix_time::milliseconds(5));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UdpDelaySimLinkModelBandwidthTestCase)
+{
+    UdpDelaySimLinkModelConfig config;
+    config.rateBitsPerSecond = 3000000000; //3Gbps, 1500 byte packet takes 4 microseconds
+    config.maxQueuedBytes = 15000;
+    UdpDelaySimLinkModel model(config, std::vector<UdpDelaySimLinkScheduleEntry>());
+    //all arrive at once: the first 10 are queued at line rate, the rest overflow the queue
+    const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent = RunPackets(model, 20, 1500, boost::posix_time::microseconds(0));
+    BOOST_REQUIRE_EQUAL(sent.size(), 10);
+    BOOST_REQUIRE_EQUAL(model.m_countDroppedQueueFull, 10);
+    for (unsigned int i = 0; i < sent.size(); ++i) {
+        BOOST_REQUIRE(sent[i].second == START_TIME + boost::posix_time::microseconds(4 * (i + 1)));
+    }
+
+    //sub-microsecond serialization times accumulate rather than truncate (10Gbps, 1000 bytes is 0.8 microseconds)
+    UdpDelaySimLinkModelConfig fastConfig;
+    fastConfig.rateBitsPerSecond = 10000000000;
+    UdpDelaySimLinkModel fastModel(fastConfig, std::vector<UdpDelaySimLinkScheduleEntry>());
+    const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > fastSent = RunPackets(fastModel, 1000, 1000, boost::posix_time::microseconds(0));
+    BOOST_REQUIRE_EQUAL(fastSent.size(), 1000);
+    BOOST_REQUIRE(fastSent.back().second == START_TIME + boost::posix_time::microseconds(800));
+}
+
+BOOST_AUTO_TEST_CASE(UdpDelaySimLinkModelGilbertElliottTestCase)
+{
+    UdpDelaySimLinkModelConfig config;
+    config.rngSeed = 12345;
+    config.lossProbabilityGoodState = 0;
+    config.lossProbabilityBadState = 1;
+    config.probabilityGoodToBad = 0.01;
+    config.probabilityBadToGood = 0.1;
+    UdpDelaySimLinkModel model(config, std::vector<UdpDelaySimLinkScheduleEntry>());
+    static const unsigned int NUM_PACKETS = 200000;
+    const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent = RunPackets(model, NUM_PACKETS, 100, boost::posix_time::microseconds(1));
+    BOOST_REQUIRE_EQUAL(sent.size() + model.m_countLost, NUM_PACKETS);
+    //stationary bad state probability is 0.01 / (0.01 + 0.1), about 9.1%
+    const double lossRate = static_cast<double>(model.m_countLost) / NUM_PACKETS;
+    BOOST_REQUIRE_GT(lossRate, 0.08);
+    BOOST_REQUIRE_LT(lossRate, 0.10);
+    //losses come in bursts averaging 1 / 0.1 packets
+    uint64_t numBursts = 0;
+    unsigned int expectedNext = 0;
+    for (std::size_t i = 0; i < sent.size(); ++i) {
+        numBursts += (sent[i].first != expectedNext);
+        expectedNext = sent[i].first + 1;
+    }
+    const double meanBurstLength = static_cast<double>(model.m_countLost) / numBursts;
+    BOOST_REQUIRE_GT(meanBurstLength, 8.0);
+    BOOST_REQUIRE_LT(meanBurstLength, 12.0);
+
+    //deterministic for a given seed
+    const uint64_t countLost = model.m_countLost;
+    BOOST_REQUIRE(RunPackets(model, NUM_PACKETS, 100, boost::posix_time::microseconds(1)) == sent);
+    BOOST_REQUIRE_EQUAL(model.m_countLost, countLost);
+}
+
+BOOST_AUTO_TEST_CASE(UdpDelaySimLinkModelJitterReorderDuplicateTestCase)
+{
+    UdpDelaySimLinkModelConfig config;
+    config.delay = boost::posix_time::milliseconds(10);
+    config.jitter = boost::posix_time::milliseconds(5);
+    config.jitterDistribution = UdpDelaySimLinkModelConfig::JITTER_DISTRIBUTION::NORMAL;
+    {
+        //jitter alone keeps arrival order
+        UdpDelaySimLinkModel model(config, std::vector<UdpDelaySimLinkScheduleEntry>());
+        const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent = RunPackets(model, 10000, 100, boost::posix_time::microseconds(100));
+        BOOST_REQUIRE_EQUAL(sent.size(), 10000);
+        for (unsigned int i = 0; i < sent.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(sent[i].first, i);
+        }
+    }
+    config.reorderProbability = 0.05;
+    config.reorderExtraDelay = boost::posix_time::milliseconds(20);
+    config.duplicateProbability = 0.02;
+    {
+        UdpDelaySimLinkModel model(config, std::vector<UdpDelaySimLinkScheduleEntry>());
+        const std::vector<std::pair<unsigned int, boost::posix_time::ptime> > sent = RunPackets(model, 10000, 100, boost::posix_time::microseconds(100));
+        BOOST_REQUIRE_EQUAL(sent.size(), 10000 + model.m_countDuplicated);
+        BOOST_REQUIRE_GT(model.m_countDuplicated, 100);
+        BOOST_REQUIRE_LT(model.m_countDuplicated, 300);
+        BOOST_REQUIRE_GT(model.m_countReordered, 350);
+        BOOST_REQUIRE_LT(model.m_countReordered, 650);
+        unsigned int numOutOfOrder = 0;
+        for (std::size_t i = 1; i < sent.size(); ++i) {
+            numOutOfOrder += (sent[i].first < sent[i - 1].first);
+        }
+        BOOST_REQUIRE_GT(numOutOfOrder, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UdpDelaySimLinkModelContactPlanScheduleTestCase)
+{
+    const boost::filesystem::path contactPlanPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("udp_delay_sim_contact_plan_%%%%%%.json");
+    {
+        std::ofstream ofs(contactPlanPath.string());
+        ofs << "{\"contacts\": ["
+            << "{\"contact\": 0, \"source\": 1, \"dest\": 2, \"startTime\": 10, \"endTime\": 20, \"rate\": 8000000, \"owlt\": 2},"
+            << "{\"contact\": 1, \"source\": 2, \"dest\": 1, \"startTime\": 0, \"endTime\": 100, \"rate\": 1000},"
+            << "{\"contact\": 2, \"source\": 1, \"dest\": 2, \"startTime\": 1, \"endTime\": 5, \"rate\": 0}"
+            << "]}";
+    }
+    std::vector<UdpDelaySimLinkScheduleEntry> linkSchedule;
+    BOOST_REQUIRE(UdpDelaySimLinkModel::LoadLinkScheduleFromContactPlanFile(contactPlanPath.string(), 1, 2, linkSchedule));
+    boost::filesystem::remove(contactPlanPath);
+    BOOST_REQUIRE_EQUAL(linkSchedule.size(), 2);
+    BOOST_REQUIRE(linkSchedule[0].startOffset == boost::posix_time::seconds(1)); //sorted
+    BOOST_REQUIRE(linkSchedule[1].endOffset == boost::posix_time::seconds(20));
+    BOOST_REQUIRE(!UdpDelaySimLinkModel::LoadLinkScheduleFromContactPlanFile("this_contact_plan_does_not_exist.json", 1, 2, linkSchedule));
+
+    std::vector<UdpDelaySimLinkScheduleEntry> schedule(2);
+    schedule[0].startOffset = boost::posix_time::seconds(1);
+    schedule[0].endOffset = boost::posix_time::seconds(5);
+    schedule[0].rateBitsPerSecond = 0;
+    schedule[0].delay = boost::posix_time::seconds(-1);
+    schedule[1].startOffset = boost::posix_time::seconds(10);
+    schedule[1].endOffset = boost::posix_time::seconds(20);
+    schedule[1].rateBitsPerSecond = 8000000; //1000 bytes per millisecond
+    schedule[1].delay = boost::posix_time::seconds(2);
+    UdpDelaySimLinkModelConfig config;
+    config.delay = boost::posix_time::milliseconds(3);
+    UdpDelaySimLinkModel model(config, schedule);
+    model.Reset(START_TIME);
+    boost::posix_time::ptime sendTimes[UdpDelaySimLinkModel::MAX_COPIES_PER_PACKET];
+    BOOST_REQUIRE_EQUAL(model.ProcessPacket(START_TIME + boost::posix_time::milliseconds(500), 1000, sendTimes), 0); //before first contact
+    BOOST_REQUIRE_EQUAL(model.ProcessPacket(START_TIME + boost::posix_time::seconds(2), 1000, sendTimes), 1);
+    BOOST_REQUIRE(sendTimes[0] == START_TIME + boost::posix_time::seconds(2) + boost::posix_time::milliseconds(3)); //config delay, unlimited rate
+    BOOST_REQUIRE_EQUAL(model.ProcessPacket(START_TIME + boost::posix_time::seconds(7), 1000, sendTimes), 0); //between contacts
+    BOOST_REQUIRE_EQUAL(model.ProcessPacket(START_TIME + boost::posix_time::seconds(10), 1000, sendTimes), 1);
+    BOOST_REQUIRE(sendTimes[0] == START_TIME + boost::posix_time::seconds(12) + boost::posix_time::milliseconds(1)); //contact owlt and rate
+    BOOST_REQUIRE_EQUAL(model.ProcessPacket(START_TIME + boost::posix_time::seconds(20), 1000, sendTimes), 0); //after last contact
+    BOOST_REQUIRE_EQUAL(model.m_countDroppedLinkDown, 3);
+}
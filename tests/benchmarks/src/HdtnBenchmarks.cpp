@@ -0,0 +1,447 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ ****************************************************************************
+ */
+
+/*
+End to end throughput benchmarks of the HDTN pipeline.
+
+For each convergence layer, bundle size, and number of concurrent sources, this program runs (all in one process, over loopback):
+    N x BpGenAsync (ipn:(100+i).1, as fast as possible) -> HdtnOneProcessRunner (cut through) -> BpSinkAsync (ipn:2.1)
+using the same config files as the integrated tests (with the web interface turned off and the udp rate limits raised).
+The throughput is measured at the sink from its first to its last received bundle,
+the one way latency comes from the timestamp bpgen puts in each payload (bpsink.bundleLatency in the MetricsRegistry),
+and the cpu usage is the process cpu time (all threads) over the same interval.
+The results are written as JSON so runs can be compared across commits.
+The "ltp_aggregated" convergence layer is ltp with block aggregation enabled on every ltp outduct (bpgen's and hdtn's),
+so small-bundle throughput can be compared against plain "ltp" (one session per bundle).
+
+Example:
+    ./build/tests/benchmarks/hdtn-benchmarks --convergence-layers=tcpcl_v4,ltp --bundle-sizes=1000,100000 --concurrency=1,4 --duration=10 --output-file=results.json
+    ./build/tests/benchmarks/hdtn-benchmarks --convergence-layers=ltp,ltp_aggregated --bundle-sizes=100,1000 --concurrency=1
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/timer/timer.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include "Environment.h"
+#include "HdtnConfig.h"
+#include "OutductsConfig.h"
+#include "InductsConfig.h"
+#include "MetricsRegistry.h"
+#include "BpGenAsyncRunner.h"
+#include "BpSinkAsyncRunner.h"
+#include "HdtnOneProcessRunner.h"
+
+#define DELAY_AFTER_SINK_STARTED_MS 2000
+#define DELAY_AFTER_HDTN_STARTED_MS 3000
+#define POLL_INTERVAL_MS 10
+#define MIN_BUNDLE_SIZE 32 //bpgen's header (sequence number and timestamps)
+#define MAX_UDP_BUNDLE_SIZE 65000
+#define LTP_AGGREGATION_TIME_THRESHOLD_MS 10
+#define LTP_AGGREGATION_BUNDLE_PIPELINE_LIMIT_MULTIPLIER 8 //the pipeline limit counts bundles (not blocks), so allow several blocks worth in flight without overrunning the receiver's udp circular buffer
+
+struct BenchmarkConvergenceLayer {
+    const char * name;
+    const char * hdtnConfigFile;
+    const char * bpgenOutductsConfigFile;
+    const char * bpsinkInductsConfigFile;
+    bool supportsConcurrentSources; //ltp sources would all share bpgen's engine id
+    bool isUdp;
+    uint64_t ltpAggregationSizeThresholdBytes; //0 => not aggregated
+};
+
+static const BenchmarkConvergenceLayer BENCHMARK_CONVERGENCE_LAYERS[] = {
+    { "tcpcl_v3", "hdtn_ingress1tcpcl_port4556_egress1tcpcl_port4558flowid2.json", "bpgen_one_tcpcl_port4556.json", "bpsink_one_tcpcl_port4558.json", true, false, 0 },
+    { "tcpcl_v4", "hdtn_ingress1tcpclv4_port4556_egress1tcpclv4_port4558flowid2.json", "bpgen_one_tcpclv4_port4556.json", "bpsink_one_tcpclv4_port4558.json", true, false, 0 },
+    { "stcp", "hdtn_ingress1stcp_port4556_egress1stcp_port4558flowid2.json", "bpgen_one_stcp_port4556.json", "bpsink_one_stcp_port4558.json", true, false, 0 },
+    { "udp", "hdtn_ingress1udp_port4556_egress1udp_port4558flowid2_0.8Mbps.json", "bpgen_one_udp_port4556_0.5Mbps.json", "bpsink_one_udp_port4558.json", true, true, 0 },
+    { "ltp", "hdtn_ingress1ltp_port4556_egress1ltp_port4558flowid2.json", "bpgen_one_ltp_port4556_thisengineid200.json", "bpsink_one_ltp_port4558.json", false, false, 0 },
+    { "ltp_aggregated", "hdtn_ingress1ltp_port4556_egress1ltp_port4558flowid2.json", "bpgen_one_ltp_port4556_thisengineid200.json", "bpsink_one_ltp_port4558.json", false, false, 8000 }
+};
+
+struct BenchmarkResult {
+    std::string convergenceLayer;
+    uint64_t bundleSizeBytes;
+    unsigned int numSources;
+    uint64_t bundlesSent;
+    uint64_t bundlesReceived;
+    uint64_t bytesReceived;
+    double elapsedSeconds;
+    double bundlesPerSecond;
+    double gigabitsPerSecond;
+    uint64_t p50LatencyNanoseconds;
+    uint64_t p99LatencyNanoseconds;
+    uint64_t maxLatencyNanoseconds;
+    double cpuCores;
+    double cpuCoresPerGigabitPerSecond;
+};
+
+//runner threads take argv, so keep the strings alive for the life of the thread
+class RunnerArgs {
+public:
+    RunnerArgs(const std::vector<std::string> & args) : m_args(args) {
+        for (std::size_t i = 0; i < m_args.size(); ++i) {
+            m_argv.push_back(m_args[i].c_str());
+        }
+        m_argv.push_back(NULL);
+    }
+    int Argc() const { return static_cast<int>(m_args.size()); }
+    const char * const * Argv() const { return m_argv.data(); }
+private:
+    std::vector<std::string> m_args;
+    std::vector<const char *> m_argv;
+};
+
+static bool ParseCommaSeparatedList(const std::string & str, std::vector<uint64_t> & values) {
+    std::vector<std::string> strs;
+    boost::split(strs, str, boost::is_any_of(","), boost::token_compress_on);
+    values.clear();
+    for (std::size_t i = 0; i < strs.size(); ++i) {
+        if (strs[i].empty()) {
+            continue;
+        }
+        try {
+            values.push_back(boost::lexical_cast<uint64_t>(strs[i]));
+        }
+        catch (boost::bad_lexical_cast &) {
+            std::cerr << "error: " << strs[i] << " is not a number\n";
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+static void EnableLtpAggregation(outduct_element_config_vector_t & outductElementConfigVector, const uint64_t sizeThresholdBytes) {
+    for (std::size_t i = 0; i < outductElementConfigVector.size(); ++i) {
+        outduct_element_config_t & outductConfig = outductElementConfigVector[i];
+        if (outductConfig.convergenceLayer == "ltp_over_udp") {
+            outductConfig.ltpAggregationSizeThresholdBytesOrZeroToDisable = sizeThresholdBytes;
+            outductConfig.ltpAggregationTimeThresholdMilliseconds = LTP_AGGREGATION_TIME_THRESHOLD_MS;
+            outductConfig.bundlePipelineLimit *= LTP_AGGREGATION_BUNDLE_PIPELINE_LIMIT_MULTIPLIER;
+        }
+    }
+}
+
+//writes copies of the test config files with the web interface turned off and the udp rate limits raised
+static bool WriteBenchmarkConfigFiles(const BenchmarkConvergenceLayer & cl, const uint64_t udpRateBps, const boost::filesystem::path & tempDir,
+    std::string & hdtnConfigFile, std::string & bpgenOutductsConfigFile, std::string & bpsinkInductsConfigFile)
+{
+    const boost::filesystem::path configFilesDir = Environment::GetPathHdtnSourceRoot() / "tests" / "config_files";
+
+    HdtnConfig_ptr hdtnConfig = HdtnConfig::CreateFromJsonFile((configFilesDir / "hdtn" / cl.hdtnConfigFile).string());
+    OutductsConfig_ptr outductsConfig = OutductsConfig::CreateFromJsonFile((configFilesDir / "outducts" / cl.bpgenOutductsConfigFile).string());
+    InductsConfig_ptr inductsConfig = InductsConfig::CreateFromJsonFile((configFilesDir / "inducts" / cl.bpsinkInductsConfigFile).string());
+    if ((!hdtnConfig) || (!outductsConfig) || (!inductsConfig)) {
+        std::cerr << "error loading config files for " << cl.name << std::endl;
+        return false;
+    }
+    hdtnConfig->m_userInterfaceOn = false;
+    if (cl.isUdp) {
+        for (std::size_t i = 0; i < hdtnConfig->m_outductsConfig.m_outductElementConfigVector.size(); ++i) {
+            hdtnConfig->m_outductsConfig.m_outductElementConfigVector[i].udpRateBps = udpRateBps;
+        }
+        for (std::size_t i = 0; i < outductsConfig->m_outductElementConfigVector.size(); ++i) {
+            outductsConfig->m_outductElementConfigVector[i].udpRateBps = udpRateBps;
+        }
+    }
+    if (cl.ltpAggregationSizeThresholdBytes) {
+        EnableLtpAggregation(hdtnConfig->m_outductsConfig.m_outductElementConfigVector, cl.ltpAggregationSizeThresholdBytes);
+        EnableLtpAggregation(outductsConfig->m_outductElementConfigVector, cl.ltpAggregationSizeThresholdBytes);
+    }
+
+    hdtnConfigFile = (tempDir / (std::string("benchmark_hdtn_") + cl.name + ".json")).string();
+    bpgenOutductsConfigFile = (tempDir / (std::string("benchmark_bpgen_") + cl.name + ".json")).string();
+    bpsinkInductsConfigFile = (tempDir / (std::string("benchmark_bpsink_") + cl.name + ".json")).string();
+    if ((!hdtnConfig->ToJsonFile(hdtnConfigFile)) || (!outductsConfig->ToJsonFile(bpgenOutductsConfigFile)) || (!inductsConfig->ToJsonFile(bpsinkInductsConfigFile))) {
+        std::cerr << "error writing benchmark config files to " << tempDir.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool RunBenchmark(const BenchmarkConvergenceLayer & cl, const std::string & hdtnConfigFile, const std::string & bpgenOutductsConfigFile,
+    const std::string & bpsinkInductsConfigFile, const uint64_t bundleSizeBytes, const unsigned int numSources, const unsigned int durationSeconds,
+    const unsigned int drainTimeoutSeconds, BenchmarkResult & result)
+{
+    MetricsRegistry & registry = MetricsRegistry::GetInstance();
+    MetricCounter & sinkBundlesReceivedCounter = registry.GetOrCreateCounter("bpsink.bundlesReceived");
+    MetricCounter & sinkBytesReceivedCounter = registry.GetOrCreateCounter("bpsink.bytesReceived");
+    LatencyHistogram & sinkLatencyHistogram = registry.GetOrCreateHistogram("bpsink.bundleLatency");
+    registry.ResetAll();
+
+    std::cout << ">>>>>> Benchmark: " << cl.name << " bundleSize=" << bundleSizeBytes << " sources=" << numSources << std::endl << std::flush;
+
+    const RunnerArgs sinkArgs({ "bpsink", "--my-uri-eid=ipn:2.1", "--inducts-config-file=" + bpsinkInductsConfigFile });
+    BpSinkAsyncRunner sinkRunner;
+    volatile bool runningSink = true;
+    std::thread threadSink(&BpSinkAsyncRunner::Run, &sinkRunner, sinkArgs.Argc(), sinkArgs.Argv(), std::ref(runningSink), false);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(DELAY_AFTER_SINK_STARTED_MS));
+
+    const RunnerArgs hdtnArgs({ "hdtn-one-process", "--cut-through-only-test", "--hdtn-config-file=" + hdtnConfigFile });
+    HdtnOneProcessRunner hdtnRunner;
+    volatile bool runningHdtn = true;
+    std::thread threadHdtn(&HdtnOneProcessRunner::Run, &hdtnRunner, hdtnArgs.Argc(), hdtnArgs.Argv(), std::ref(runningHdtn), false);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(DELAY_AFTER_HDTN_STARTED_MS));
+
+    std::vector<std::unique_ptr<RunnerArgs> > bpgenArgs;
+    std::vector<std::unique_ptr<BpGenAsyncRunner> > bpgenRunners;
+    std::unique_ptr<volatile bool[]> runningBpgens(new volatile bool[numSources]);
+    std::vector<std::thread> threadsBpgen;
+    boost::timer::cpu_timer cpuTimer;
+    for (unsigned int i = 0; i < numSources; ++i) {
+        bpgenArgs.emplace_back(new RunnerArgs({ "bpgen",
+            "--bundle-rate=0",
+            "--force-disable-custody",
+            "--bundle-size=" + boost::lexical_cast<std::string>(bundleSizeBytes),
+            "--duration=" + boost::lexical_cast<std::string>(durationSeconds),
+            "--my-uri-eid=ipn:" + boost::lexical_cast<std::string>(100 + i) + ".1",
+            "--dest-uri-eid=ipn:2.1",
+            "--outducts-config-file=" + bpgenOutductsConfigFile }));
+        bpgenRunners.emplace_back(new BpGenAsyncRunner());
+        runningBpgens[i] = true;
+        threadsBpgen.emplace_back(&BpGenAsyncRunner::Run, bpgenRunners.back().get(), bpgenArgs.back()->Argc(), bpgenArgs.back()->Argv(), std::ref(runningBpgens[i]), false);
+    }
+
+    //sample the sink until every bpgen has stopped and the sink has drained (or stalled for drainTimeoutSeconds)
+    uint64_t lastCount = 0;
+    uint64_t firstRxNanoseconds = 0;
+    uint64_t lastRxNanoseconds = 0;
+    boost::timer::cpu_times firstRxCpuTimes = cpuTimer.elapsed();
+    boost::timer::cpu_times lastRxCpuTimes = firstRxCpuTimes;
+    uint64_t lastChangeNanoseconds = LatencyHistogram::NowNanoseconds();
+    uint64_t bundlesSent = 0;
+    bool allBpgensStopped = false;
+    while (true) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(POLL_INTERVAL_MS));
+        const uint64_t nowNanoseconds = LatencyHistogram::NowNanoseconds();
+        const uint64_t count = sinkBundlesReceivedCounter.Get();
+        if (count != lastCount) {
+            const boost::timer::cpu_times cpuTimes = cpuTimer.elapsed();
+            if (lastCount == 0) {
+                firstRxNanoseconds = nowNanoseconds;
+                firstRxCpuTimes = cpuTimes;
+            }
+            lastRxNanoseconds = nowNanoseconds;
+            lastRxCpuTimes = cpuTimes;
+            lastChangeNanoseconds = nowNanoseconds;
+            lastCount = count;
+        }
+        if (!allBpgensStopped) {
+            allBpgensStopped = true;
+            for (unsigned int i = 0; i < numSources; ++i) {
+                allBpgensStopped = allBpgensStopped && (!runningBpgens[i]);
+            }
+            if (allBpgensStopped) {
+                for (unsigned int i = 0; i < numSources; ++i) {
+                    threadsBpgen[i].join();
+                    bundlesSent += bpgenRunners[i]->m_bundleCount;
+                }
+            }
+        }
+        else if ((count >= bundlesSent) || ((nowNanoseconds - lastChangeNanoseconds) > (drainTimeoutSeconds * 1000000000ULL))) {
+            break;
+        }
+    }
+
+    runningHdtn = false;
+    threadHdtn.join();
+    runningSink = false;
+    threadSink.join();
+
+    const LatencyHistogramSummary latencySummary = sinkLatencyHistogram.GetSummary();
+    result.convergenceLayer = cl.name;
+    result.bundleSizeBytes = bundleSizeBytes;
+    result.numSources = numSources;
+    result.bundlesSent = bundlesSent;
+    result.bundlesReceived = sinkBundlesReceivedCounter.Get();
+    result.bytesReceived = sinkBytesReceivedCounter.Get();
+    result.elapsedSeconds = (lastRxNanoseconds - firstRxNanoseconds) * 1e-9;
+    const double cpuSeconds = ((lastRxCpuTimes.user + lastRxCpuTimes.system) - (firstRxCpuTimes.user + firstRxCpuTimes.system)) * 1e-9;
+    if (result.elapsedSeconds > 0) {
+        result.bundlesPerSecond = result.bundlesReceived / result.elapsedSeconds;
+        result.gigabitsPerSecond = (result.bytesReceived * 8.0) / result.elapsedSeconds * 1e-9;
+        result.cpuCores = cpuSeconds / result.elapsedSeconds;
+    }
+    else {
+        result.bundlesPerSecond = 0;
+        result.gigabitsPerSecond = 0;
+        result.cpuCores = 0;
+    }
+    result.cpuCoresPerGigabitPerSecond = (result.gigabitsPerSecond > 0) ? (result.cpuCores / result.gigabitsPerSecond) : 0;
+    result.p50LatencyNanoseconds = latencySummary.p50Nanoseconds;
+    result.p99LatencyNanoseconds = latencySummary.p99Nanoseconds;
+    result.maxLatencyNanoseconds = latencySummary.maxNanoseconds;
+
+    std::cout << ">>>>>> Result: " << cl.name << " bundleSize=" << bundleSizeBytes << " sources=" << numSources
+        << " sent=" << result.bundlesSent << " received=" << result.bundlesReceived
+        << " bundles/sec=" << result.bundlesPerSecond << " Gbps=" << result.gigabitsPerSecond
+        << " p50=" << (result.p50LatencyNanoseconds * 1e-3) << "us p99=" << (result.p99LatencyNanoseconds * 1e-3) << "us"
+        << " cpuCores/Gbps=" << result.cpuCoresPerGigabitPerSecond << std::endl << std::flush;
+    return (result.bundlesReceived != 0);
+}
+
+static std::string ResultsToJson(const std::vector<BenchmarkResult> & results, const unsigned int durationSeconds) {
+    std::ostringstream oss;
+    oss << "{\n    \"durationSeconds\": " << durationSeconds << ",\n    \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult & r = results[i];
+        oss << ((i == 0) ? "\n" : ",\n")
+            << "        {"
+            << "\"convergenceLayer\": \"" << r.convergenceLayer << "\""
+            << ", \"bundleSizeBytes\": " << r.bundleSizeBytes
+            << ", \"numSources\": " << r.numSources
+            << ", \"bundlesSent\": " << r.bundlesSent
+            << ", \"bundlesReceived\": " << r.bundlesReceived
+            << ", \"bytesReceived\": " << r.bytesReceived
+            << ", \"elapsedSeconds\": " << r.elapsedSeconds
+            << ", \"bundlesPerSecond\": " << r.bundlesPerSecond
+            << ", \"gigabitsPerSecond\": " << r.gigabitsPerSecond
+            << ", \"p50LatencyMicroseconds\": " << (r.p50LatencyNanoseconds * 1e-3)
+            << ", \"p99LatencyMicroseconds\": " << (r.p99LatencyNanoseconds * 1e-3)
+            << ", \"maxLatencyMicroseconds\": " << (r.maxLatencyNanoseconds * 1e-3)
+            << ", \"cpuCores\": " << r.cpuCores
+            << ", \"cpuCoresPerGigabitPerSecond\": " << r.cpuCoresPerGigabitPerSecond
+            << "}";
+    }
+    oss << "\n    ]\n}\n";
+    return oss.str();
+}
+
+int main(int argc, const char* argv[]) {
+    std::vector<std::string> convergenceLayerNames;
+    std::vector<uint64_t> bundleSizes;
+    std::vector<uint64_t> concurrencies;
+    unsigned int durationSeconds;
+    unsigned int drainTimeoutSeconds;
+    uint64_t udpRateBps;
+    std::string outputFileName;
+
+    boost::program_options::options_description desc("Allowed options");
+    try {
+        desc.add_options()
+            ("help", "Produce help message.")
+            ("convergence-layers", boost::program_options::value<std::string>()->default_value("tcpcl_v3,tcpcl_v4,stcp,udp,ltp,ltp_aggregated"), "Comma separated convergence layers to benchmark.")
+            ("bundle-sizes", boost::program_options::value<std::string>()->default_value("100,1000,10000,100000"), "Comma separated bundle sizes (bytes).")
+            ("concurrency", boost::program_options::value<std::string>()->default_value("1,4"), "Comma separated numbers of concurrent bpgen sources.")
+            ("duration", boost::program_options::value<unsigned int>()->default_value(5), "Seconds each bpgen sends bundles for.")
+            ("drain-timeout-seconds", boost::program_options::value<unsigned int>()->default_value(5), "Stop waiting for the sink after this many seconds without a bundle.")
+            ("udp-rate-mbps", boost::program_options::value<uint64_t>()->default_value(1000), "Rate limit of the udp outducts (Mbps).")
+            ("output-file", boost::program_options::value<std::string>()->default_value(""), "Write the JSON results to this file (default stdout).")
+            ;
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc, boost::program_options::command_line_style::unix_style | boost::program_options::command_line_style::case_insensitive), vm);
+        boost::program_options::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << desc << "\n";
+            return 1;
+        }
+        boost::split(convergenceLayerNames, vm["convergence-layers"].as<std::string>(), boost::is_any_of(","), boost::token_compress_on);
+        if (!ParseCommaSeparatedList(vm["bundle-sizes"].as<std::string>(), bundleSizes)) {
+            std::cerr << "error: invalid bundle-sizes\n";
+            return 1;
+        }
+        if (!ParseCommaSeparatedList(vm["concurrency"].as<std::string>(), concurrencies)) {
+            std::cerr << "error: invalid concurrency\n";
+            return 1;
+        }
+        durationSeconds = vm["duration"].as<unsigned int>();
+        if (durationSeconds == 0) {
+            std::cerr << "error: duration must be nonzero\n";
+            return 1;
+        }
+        drainTimeoutSeconds = vm["drain-timeout-seconds"].as<unsigned int>();
+        udpRateBps = vm["udp-rate-mbps"].as<uint64_t>() * 1000000;
+        outputFileName = vm["output-file"].as<std::string>();
+    }
+    catch (boost::bad_any_cast & e) {
+        std::cout << "invalid data error: " << e.what() << "\n\n";
+        std::cout << desc << "\n";
+        return 1;
+    }
+    catch (std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    catch (...) {
+        std::cerr << "Exception of unknown type!\n";
+        return 1;
+    }
+
+    const boost::filesystem::path tempDir = boost::filesystem::temp_directory_path();
+    std::vector<BenchmarkResult> results;
+    bool success = true;
+    for (std::size_t clNameIndex = 0; clNameIndex < convergenceLayerNames.size(); ++clNameIndex) {
+        const BenchmarkConvergenceLayer * cl = NULL;
+        for (std::size_t i = 0; i < (sizeof(BENCHMARK_CONVERGENCE_LAYERS) / sizeof(BENCHMARK_CONVERGENCE_LAYERS[0])); ++i) {
+            if (convergenceLayerNames[clNameIndex] == BENCHMARK_CONVERGENCE_LAYERS[i].name) {
+                cl = &BENCHMARK_CONVERGENCE_LAYERS[i];
+            }
+        }
+        if (cl == NULL) {
+            std::cerr << "error: unknown convergence layer " << convergenceLayerNames[clNameIndex] << std::endl;
+            return 1;
+        }
+        std::string hdtnConfigFile, bpgenOutductsConfigFile, bpsinkInductsConfigFile;
+        if (!WriteBenchmarkConfigFiles(*cl, udpRateBps, tempDir, hdtnConfigFile, bpgenOutductsConfigFile, bpsinkInductsConfigFile)) {
+            return 1;
+        }
+        for (std::size_t sizeIndex = 0; sizeIndex < bundleSizes.size(); ++sizeIndex) {
+            const uint64_t bundleSizeBytes = bundleSizes[sizeIndex];
+            if (bundleSizeBytes < MIN_BUNDLE_SIZE) {
+                std::cout << "skipping " << cl->name << " bundle size " << bundleSizeBytes << ": too small for bpgen's header\n";
+                continue;
+            }
+            if (cl->isUdp && (bundleSizeBytes > MAX_UDP_BUNDLE_SIZE)) {
+                std::cout << "skipping " << cl->name << " bundle size " << bundleSizeBytes << ": bundle won't fit in a udp datagram\n";
+                continue;
+            }
+            for (std::size_t concurrencyIndex = 0; concurrencyIndex < concurrencies.size(); ++concurrencyIndex) {
+                const unsigned int numSources = static_cast<unsigned int>(concurrencies[concurrencyIndex]);
+                if ((numSources == 0) || ((numSources > 1) && (!cl->supportsConcurrentSources))) {
+                    std::cout << "skipping " << cl->name << " with " << numSources << " sources\n";
+                    continue;
+                }
+                BenchmarkResult result;
+                if (!RunBenchmark(*cl, hdtnConfigFile, bpgenOutductsConfigFile, bpsinkInductsConfigFile,
+                    bundleSizeBytes, numSources, durationSeconds, drainTimeoutSeconds, result))
+                {
+                    std::cerr << "error: " << cl->name << " bundle size " << bundleSizeBytes << " with " << numSources << " sources received no bundles\n";
+                    success = false;
+                }
+                results.push_back(result);
+            }
+        }
+        boost::filesystem::remove(hdtnConfigFile);
+        boost::filesystem::remove(bpgenOutductsConfigFile);
+        boost::filesystem::remove(bpsinkInductsConfigFile);
+    }
+
+    const std::string json = ResultsToJson(results, durationSeconds);
+    if (outputFileName.empty()) {
+        std::cout << json;
+    }
+    else {
+        std::ofstream ofs(outputFileName);
+        if (!ofs.good()) {
+            std::cerr << "error: cannot open " << outputFileName << std::endl;
+            return 1;
+        }
+        ofs << json;
+        std::cout << "wrote benchmark results to " << outputFileName << std::endl;
+    }
+    return (success) ? 0 : 1;
+}